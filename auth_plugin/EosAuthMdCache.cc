@@ -0,0 +1,486 @@
+//------------------------------------------------------------------------------
+// File: EosAuthMdCache.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "EosAuthMdCache.hh"
+#include "XrdSec/XrdSecEntity.hh"
+#include "XrdSfs/XrdSfsInterface.hh"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+EOSAUTHNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+EosAuthMdCache::EosAuthMdCache():
+  mTtl(0), mMaxEntries(100000), mNumEntries(0), mGeneration(0),
+  mInvalidations(0)
+{
+  for (int i = 0; i < kNumOps; ++i) {
+    mHits[i] = 0;
+    mMisses[i] = 0;
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Configure the cache
+//------------------------------------------------------------------------------
+void
+EosAuthMdCache::Configure(unsigned long long ttl_ms, size_t max_entries)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mTtl = std::chrono::milliseconds(ttl_ms);
+  mMaxEntries = (max_entries ? max_entries : 1);
+  mEntries.clear();
+  mNumEntries = 0;
+  ++mGeneration;
+}
+
+
+//------------------------------------------------------------------------------
+// Look up a response
+//------------------------------------------------------------------------------
+bool
+EosAuthMdCache::Get(Op op, const char* path, const char* opaque,
+                    const XrdSecEntity* client, ResponseProto& response,
+                    unsigned long long& generation)
+{
+  std::string npath = Normalize(path);
+  std::string key = GetKey(op, opaque, client);
+  std::lock_guard<std::mutex> lock(mMutex);
+  Entry* entry = Find(op, npath, key);
+
+  if (!entry) {
+    generation = mGeneration;
+    return false;
+  }
+
+  response.CopyFrom(entry->mResponse);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Store a response obtained from the MGM
+//------------------------------------------------------------------------------
+bool
+EosAuthMdCache::Put(Op op, const char* path, const char* opaque,
+                    const XrdSecEntity* client, const ResponseProto& response,
+                    unsigned long long generation)
+{
+  // Keep only final answers, the rest depends on the state of the MGM
+  bool cacheable = ((response.response() == SFS_OK) ||
+                    ((response.response() == SFS_ERROR) &&
+                     response.has_error() &&
+                     (response.error().code() == ENOENT)));
+
+  if (!IsEnabled() || !cacheable) {
+    return false;
+  }
+
+  std::string npath = Normalize(path);
+  std::string key = GetKey(op, opaque, client);
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (generation != mGeneration) {
+    return false;
+  }
+
+  Insert(npath, key)->mResponse.CopyFrom(response);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Look up a directory listing
+//------------------------------------------------------------------------------
+bool
+EosAuthMdCache::GetListing(const char* path, const char* opaque,
+                           const XrdSecEntity* client,
+                           std::vector<std::string>& entries,
+                           unsigned long long& generation)
+{
+  std::string npath = Normalize(path);
+  std::string key = GetKey(kDirList, opaque, client);
+  std::lock_guard<std::mutex> lock(mMutex);
+  Entry* entry = Find(kDirList, npath, key);
+
+  if (!entry) {
+    generation = mGeneration;
+    return false;
+  }
+
+  entries = entry->mEntries;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Store a complete directory listing obtained from the MGM
+//------------------------------------------------------------------------------
+bool
+EosAuthMdCache::PutListing(const char* path, const char* opaque,
+                           const XrdSecEntity* client,
+                           const std::vector<std::string>& entries,
+                           unsigned long long generation)
+{
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  std::string npath = Normalize(path);
+  std::string key = GetKey(kDirList, opaque, client);
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (generation != mGeneration) {
+    return false;
+  }
+
+  Entry* entry = Insert(npath, key);
+  entry->mResponse.set_response(SFS_OK);
+  entry->mEntries = entries;
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Drop the entries of a path, of everything below it and of its parent
+//------------------------------------------------------------------------------
+void
+EosAuthMdCache::Invalidate(const char* path)
+{
+  if (!IsEnabled()) {
+    return;
+  }
+
+  std::string npath = Normalize(path);
+
+  if (npath == "/") {
+    Clear();
+    return;
+  }
+
+  std::string parent = npath.substr(0, npath.rfind('/'));
+  std::lock_guard<std::mutex> lock(mMutex);
+  ++mGeneration;
+  ++mInvalidations;
+  auto it = mEntries.find(npath);
+
+  if (it != mEntries.end()) {
+    Erase(it);
+  }
+
+  // Everything below the path, '0' follows '/' in ASCII
+  it = mEntries.lower_bound(npath + "/");
+
+  while ((it != mEntries.end()) && (it->first < npath + "0")) {
+    Erase(it++);
+  }
+
+  it = mEntries.find(parent.empty() ? std::string("/") : parent);
+
+  if (it != mEntries.end()) {
+    Erase(it);
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Drop all entries
+//------------------------------------------------------------------------------
+void
+EosAuthMdCache::Clear()
+{
+  if (!IsEnabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  ++mGeneration;
+  ++mInvalidations;
+  mEntries.clear();
+  mNumEntries = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Get number of cached entries
+//------------------------------------------------------------------------------
+size_t
+EosAuthMdCache::Size()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumEntries;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the hit and miss counters of an operation
+//------------------------------------------------------------------------------
+void
+EosAuthMdCache::GetCounters(Op op, unsigned long long& hits,
+                            unsigned long long& misses) const
+{
+  hits = mHits[op];
+  misses = mMisses[op];
+}
+
+
+//------------------------------------------------------------------------------
+// Get the hit rate of an operation in percent
+//------------------------------------------------------------------------------
+double
+EosAuthMdCache::GetHitRate(Op op) const
+{
+  unsigned long long hits, misses;
+  GetCounters(op, hits, misses);
+  return ((hits + misses) ? 100.0 * hits / (hits + misses) : 0.0);
+}
+
+
+//------------------------------------------------------------------------------
+// Print the counters of all operations in the XRootD summary format
+//------------------------------------------------------------------------------
+int
+EosAuthMdCache::PrintStats(char* buff, int blen)
+{
+  static const int max_len = 1024;
+
+  if (!buff || (blen <= 0)) {
+    return max_len;
+  }
+
+  std::string out = "<stats id=\"mdcache\"><ttl>" +
+                    std::to_string(mTtl.count()) + "</ttl><entries>" +
+                    std::to_string(Size()) + "</entries><invalidations>" +
+                    std::to_string(mInvalidations) + "</invalidations>";
+  char rate[32];
+
+  for (int i = 0; i < kNumOps; ++i) {
+    unsigned long long hits, misses;
+    GetCounters((Op) i, hits, misses);
+    snprintf(rate, sizeof(rate), "%.02f", GetHitRate((Op) i));
+    out += std::string("<") + GetOpName((Op) i) + "><hits>" +
+           std::to_string(hits) + "</hits><misses>" + std::to_string(misses) +
+           "</misses><rate>" + rate + "</rate></" + GetOpName((Op) i) + ">";
+  }
+
+  out += "</stats>";
+
+  if ((int) out.length() >= blen) {
+    return 0;
+  }
+
+  memcpy(buff, out.c_str(), out.length() + 1);
+  return out.length();
+}
+
+
+//------------------------------------------------------------------------------
+// Build the identity of a client
+//------------------------------------------------------------------------------
+std::string
+EosAuthMdCache::GetIdentity(const XrdSecEntity* client)
+{
+  if (!client) {
+    return std::string();
+  }
+
+  // Every field forwarded to the MGM is part of the identity, prefixed with
+  // its length since credentials can contain any character
+  std::string id;
+  auto append = [&id](const char* field, size_t len) {
+    id += std::to_string(len);
+    id += ':';
+
+    if (field) {
+      id.append(field, len);
+    }
+  };
+  append(client->prot, strnlen(client->prot, sizeof(client->prot)));
+  const char* fields[] = {client->name, client->host, client->vorg,
+                          client->role, client->grps, client->endorsements,
+                          client->creds, client->moninfo, client->tident
+                         };
+
+  for (auto field : fields) {
+    append(field, (field ? strlen(field) : 0));
+  }
+
+  id += std::to_string(client->credslen);
+  return id;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the name of an operation
+//------------------------------------------------------------------------------
+const char*
+EosAuthMdCache::GetOpName(Op op)
+{
+  switch (op) {
+  case kStat:
+    return "stat";
+
+  case kStatMode:
+    return "statm";
+
+  case kExists:
+    return "exists";
+
+  case kDirList:
+    return "readdir";
+
+  default:
+    return "unknown";
+  }
+}
+
+
+//------------------------------------------------------------------------------
+// Normalize a path by dropping trailing slashes
+//------------------------------------------------------------------------------
+std::string
+EosAuthMdCache::Normalize(const char* path)
+{
+  std::string npath = (path ? path : "");
+
+  while ((npath.length() > 1) && (npath.back() == '/')) {
+    npath.pop_back();
+  }
+
+  return npath;
+}
+
+
+//------------------------------------------------------------------------------
+// Build the key of an entry within the entries of its path
+//------------------------------------------------------------------------------
+std::string
+EosAuthMdCache::GetKey(Op op, const char* opaque, const XrdSecEntity* client)
+{
+  std::string key = std::to_string(op);
+  key += '\0';
+  key += GetIdentity(client);
+  key += '\0';
+
+  if (opaque) {
+    key += opaque;
+  }
+
+  return key;
+}
+
+
+//------------------------------------------------------------------------------
+// Find a valid entry, expired entries are dropped
+//------------------------------------------------------------------------------
+EosAuthMdCache::Entry*
+EosAuthMdCache::Find(Op op, const std::string& path, const std::string& key)
+{
+  if (IsEnabled()) {
+    auto it = mEntries.find(path);
+
+    if (it != mEntries.end()) {
+      auto entry = it->second.find(key);
+
+      if (entry != it->second.end()) {
+        if (entry->second.mExpires > Clock::now()) {
+          ++mHits[op];
+          return &entry->second;
+        }
+
+        it->second.erase(entry);
+        --mNumEntries;
+
+        if (it->second.empty()) {
+          mEntries.erase(it);
+        }
+      }
+    }
+  }
+
+  ++mMisses[op];
+  return nullptr;
+}
+
+
+//------------------------------------------------------------------------------
+// Add an entry
+//------------------------------------------------------------------------------
+EosAuthMdCache::Entry*
+EosAuthMdCache::Insert(const std::string& path, const std::string& key)
+{
+  Clock::time_point now = Clock::now();
+
+  if (mNumEntries >= mMaxEntries) {
+    // Drop the expired entries and if this is not enough everything
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+      for (auto entry = it->second.begin(); entry != it->second.end();) {
+        if (entry->second.mExpires <= now) {
+          entry = it->second.erase(entry);
+          --mNumEntries;
+        } else {
+          ++entry;
+        }
+      }
+
+      if (it->second.empty()) {
+        it = mEntries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (mNumEntries >= mMaxEntries) {
+      mEntries.clear();
+      mNumEntries = 0;
+    }
+  }
+
+  PathEntries& entries = mEntries[path];
+  auto it = entries.find(key);
+
+  if (it == entries.end()) {
+    it = entries.emplace(key, Entry()).first;
+    ++mNumEntries;
+  }
+
+  it->second.mExpires = now + mTtl;
+  it->second.mEntries.clear();
+  return &it->second;
+}
+
+
+//------------------------------------------------------------------------------
+// Drop the entries of a path
+//------------------------------------------------------------------------------
+void
+EosAuthMdCache::Erase(std::map<std::string, PathEntries>::iterator it)
+{
+  mNumEntries -= it->second.size();
+  mEntries.erase(it);
+}
+
+EOSAUTHNAMESPACE_END
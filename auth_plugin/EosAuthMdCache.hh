@@ -0,0 +1,243 @@
+//------------------------------------------------------------------------------
+// File: EosAuthMdCache.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSAUTH_MDCACHE_HH__
+#define __EOSAUTH_MDCACHE_HH__
+
+#include "Namespace.hh"
+#include "auth_plugin/Response.pb.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class XrdSecEntity;
+
+EOSAUTHNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class EosAuthMdCache
+//!
+//! @brief Cache of the MGM responses to stat, stat mode, exists and directory
+//! listing requests. Entries are keyed by the path, the opaque information
+//! and the identity of the client i.e. everything the MGM uses to map the
+//! client, and expire after a configurable time to live. Only successful
+//! responses and "no such file" errors are kept - redirections, stalls and
+//! other errors always go to the MGM.
+//!
+//! Every modifying request seen by the proxy drops the entries of the
+//! affected path, of everything below it and of its parent directory. A
+//! response is only stored if no invalidation happened since its request
+//! was sent, so a reply racing with a modification can not hide the latter.
+//! Modifications done by other clients of the MGM are only seen once the
+//! entries expired.
+//------------------------------------------------------------------------------
+class EosAuthMdCache
+{
+public:
+  //! Cached operations
+  enum Op { kStat = 0, kStatMode = 1, kExists = 2, kDirList = 3, kNumOps = 4 };
+
+  //----------------------------------------------------------------------------
+  //! Constructor - the cache is disabled until configured with a TTL
+  //----------------------------------------------------------------------------
+  EosAuthMdCache();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~EosAuthMdCache() = default;
+
+  //----------------------------------------------------------------------------
+  //! Configure the cache
+  //!
+  //! @param ttl_ms time to live of the entries in milliseconds, 0 disables
+  //!        the cache
+  //! @param max_entries maximum number of cached entries
+  //----------------------------------------------------------------------------
+  void Configure(unsigned long long ttl_ms, size_t max_entries);
+
+  //----------------------------------------------------------------------------
+  //! Check if the cache is enabled
+  //----------------------------------------------------------------------------
+  inline bool IsEnabled() const
+  {
+    return (mTtl.count() != 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Look up a response
+  //!
+  //! @param op operation type
+  //! @param path path of the request
+  //! @param opaque opaque information of the request
+  //! @param client client identity
+  //! @param response filled with the cached response
+  //! @param generation on a miss filled with the value to be passed to the
+  //!        Put call storing the response obtained from the MGM
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Get(Op op, const char* path, const char* opaque,
+           const XrdSecEntity* client, ResponseProto& response,
+           unsigned long long& generation);
+
+  //----------------------------------------------------------------------------
+  //! Store a response obtained from the MGM
+  //!
+  //! @param op operation type
+  //! @param path path of the request
+  //! @param opaque opaque information of the request
+  //! @param client client identity
+  //! @param response response from the MGM
+  //! @param generation value returned by the Get call done before sending
+  //!        the request
+  //!
+  //! @return true if stored, otherwise false
+  //----------------------------------------------------------------------------
+  bool Put(Op op, const char* path, const char* opaque,
+           const XrdSecEntity* client, const ResponseProto& response,
+           unsigned long long generation);
+
+  //----------------------------------------------------------------------------
+  //! Look up a directory listing
+  //!
+  //! @param entries filled with the entries of the directory
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetListing(const char* path, const char* opaque,
+                  const XrdSecEntity* client, std::vector<std::string>& entries,
+                  unsigned long long& generation);
+
+  //----------------------------------------------------------------------------
+  //! Store a complete directory listing obtained from the MGM
+  //----------------------------------------------------------------------------
+  bool PutListing(const char* path, const char* opaque,
+                  const XrdSecEntity* client,
+                  const std::vector<std::string>& entries,
+                  unsigned long long generation);
+
+  //----------------------------------------------------------------------------
+  //! Drop the entries of a path, of everything below it and of its parent
+  //----------------------------------------------------------------------------
+  void Invalidate(const char* path);
+
+  //----------------------------------------------------------------------------
+  //! Drop all entries
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get number of cached entries
+  //----------------------------------------------------------------------------
+  size_t Size();
+
+  //----------------------------------------------------------------------------
+  //! Get the hit and miss counters of an operation
+  //----------------------------------------------------------------------------
+  void GetCounters(Op op, unsigned long long& hits,
+                   unsigned long long& misses) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the hit rate of an operation in percent
+  //----------------------------------------------------------------------------
+  double GetHitRate(Op op) const;
+
+  //----------------------------------------------------------------------------
+  //! Print the counters of all operations in the XRootD summary format
+  //!
+  //! @param buff output buffer
+  //! @param blen size of the output buffer
+  //!
+  //! @return number of bytes written, or the maximum length if blen is 0
+  //----------------------------------------------------------------------------
+  int PrintStats(char* buff, int blen);
+
+  //----------------------------------------------------------------------------
+  //! Build the identity of a client from all the fields forwarded to the MGM
+  //! i.e. everything it can use to map the client to a virtual identity,
+  //! including the trace identifier, endorsements and credentials
+  //----------------------------------------------------------------------------
+  static std::string GetIdentity(const XrdSecEntity* client);
+
+  //----------------------------------------------------------------------------
+  //! Get the name of an operation
+  //----------------------------------------------------------------------------
+  static const char* GetOpName(Op op);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  //! Cached response
+  struct Entry {
+    Clock::time_point mExpires; ///< expiration time
+    ResponseProto mResponse; ///< MGM response
+    std::vector<std::string> mEntries; ///< directory entries for kDirList
+  };
+
+  //! Entries of a path by operation, identity and opaque information
+  typedef std::unordered_map<std::string, Entry> PathEntries;
+
+  //----------------------------------------------------------------------------
+  //! Normalize a path by dropping trailing slashes
+  //----------------------------------------------------------------------------
+  static std::string Normalize(const char* path);
+
+  //----------------------------------------------------------------------------
+  //! Build the key of an entry within the entries of its path
+  //----------------------------------------------------------------------------
+  static std::string GetKey(Op op, const char* opaque,
+                            const XrdSecEntity* client);
+
+  //----------------------------------------------------------------------------
+  //! Find a valid entry, expired entries are dropped - mMutex must be locked
+  //----------------------------------------------------------------------------
+  Entry* Find(Op op, const std::string& path, const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Add an entry - mMutex must be locked
+  //----------------------------------------------------------------------------
+  Entry* Insert(const std::string& path, const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Drop the entries of a path - mMutex must be locked
+  //----------------------------------------------------------------------------
+  void Erase(std::map<std::string, PathEntries>::iterator it);
+
+  std::chrono::milliseconds mTtl; ///< time to live of the entries
+  size_t mMaxEntries; ///< maximum number of entries
+  std::mutex mMutex; ///< mutex protecting the entries
+  std::map<std::string, PathEntries> mEntries; ///< entries ordered by path
+  size_t mNumEntries; ///< number of entries
+  unsigned long long mGeneration; ///< incremented by every invalidation
+  std::atomic<unsigned long long> mHits[kNumOps]; ///< hits per operation
+  std::atomic<unsigned long long> mMisses[kNumOps]; ///< misses per operation
+  std::atomic<unsigned long long> mInvalidations; ///< number of invalidations
+};
+
+EOSAUTHNAMESPACE_END
+
+#endif // __EOSAUTH_MDCACHE_HH__
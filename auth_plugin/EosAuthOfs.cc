@@ -176,6 +176,8 @@ EosAuthOfs::Configure(XrdSysError& error, XrdOucEnv* envP)
 
     Config.Attach(cfgFD);
     std::string auth_tag = "eosauth.";
+    unsigned long long mdcache_ttl = 0;
+    unsigned long long mdcache_size = 100000;
 
     while ((var = Config.GetMyFirstWord())) {
       if (!strncmp(var, auth_tag.c_str(), auth_tag.length())) {
@@ -249,9 +251,40 @@ EosAuthOfs::Configure(XrdSysError& error, XrdOucEnv* envP)
           // Set the new log level
           g_logging.SetLogPriority(mLogLevel);
         }
+
+        // Get metadata cache TTL in milliseconds by default 0 i.e. disabled
+        option_tag = "mdcachettl";
+
+        if (!strncmp(var, option_tag.c_str(), option_tag.length())) {
+          if (!(val = Config.GetWord())) {
+            error.Emsg("Configure ", "No metadata cache TTL specified");
+          } else {
+            mdcache_ttl = strtoull(val, 0, 10);
+          }
+        }
+
+        // Get maximum number of metadata cache entries by default 100000
+        option_tag = "mdcachesize";
+
+        if (!strncmp(var, option_tag.c_str(), option_tag.length())) {
+          if (!(val = Config.GetWord())) {
+            error.Emsg("Configure ", "No metadata cache size specified");
+          } else {
+            mdcache_size = strtoull(val, 0, 10);
+          }
+        }
       }
     }
 
+    mMdCache.Configure(mdcache_ttl, mdcache_size);
+
+    if (mMdCache.IsEnabled()) {
+      error.Say("=====> eosauth.mdcachettl: ",
+                std::to_string(mdcache_ttl).c_str(), " ms");
+      error.Say("=====> eosauth.mdcachesize: ",
+                std::to_string(mdcache_size).c_str(), "");
+    }
+
     // Check and connect at least to an MGM master
     if (!mBackend1.first.empty()) {
       if ((XrdSysThread::Run(&proxy_tid, EosAuthOfs::StartAuthProxyThread,
@@ -548,46 +581,41 @@ EosAuthOfs::stat(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("stat path=%s", path);
-  // Create request object
-  RequestProto* req_proto = utils::GetStatRequest(RequestProto_OperationType_STAT,
-                            path, error, client, opaque);
+  unsigned long long generation = 0;
+  ResponseProto* resp_stat = GetCachedResponse(EosAuthMdCache::kStat, path,
+                             client, opaque, generation);
 
-  // Compute HMAC for request object
-  if (!utils::ComputeHMAC(req_proto)) {
-    eos_err("error HMAC FS stat");
-    delete req_proto;
-    return retc;
-  }
-
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+  if (!resp_stat) {
+    // Create request object
+    RequestProto* req_proto = utils::GetStatRequest(
+                                RequestProto_OperationType_STAT,
+                                path, error, client, opaque);
+    resp_stat = ForwardRequest(req_proto, "FS stat");
 
     if (resp_stat) {
-      retc = resp_stat->response();
+      mMdCache.Put(EosAuthMdCache::kStat, path, opaque, client, *resp_stat,
+                   generation);
+    }
+  }
 
-      if (resp_stat->has_error()) {
-        error.setErrInfo(resp_stat->error().code(),
-                         resp_stat->error().message().c_str());
-      }
+  if (resp_stat) {
+    retc = resp_stat->response();
 
-      // We retrieve the struct stat if response is ok
-      if ((retc == SFS_OK) && resp_stat->has_message()) {
-        buf = static_cast<struct stat*>(memcpy((void*)buf,
-                                               resp_stat->message().c_str(),
-                                               sizeof(struct stat)));
-      }
+    if (resp_stat->has_error()) {
+      error.setErrInfo(resp_stat->error().code(),
+                       resp_stat->error().message().c_str());
+    }
 
-      delete resp_stat;
+    // We retrieve the struct stat if response is ok
+    if ((retc == SFS_OK) && resp_stat->has_message()) {
+      buf = static_cast<struct stat*>(memcpy((void*)buf,
+                                             resp_stat->message().c_str(),
+                                             sizeof(struct stat)));
     }
+
+    delete resp_stat;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
   return retc;
 }
 
@@ -604,44 +632,38 @@ EosAuthOfs::stat(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("statm path=%s", path);
-  RequestProto* req_proto = utils::GetStatRequest(
-                              RequestProto_OperationType_STATM,
-                              path, error, client, opaque);
-
-  // Compute HMAC for request object
-  if (!utils::ComputeHMAC(req_proto)) {
-    eos_err("error HMAC FS statm");
-    delete req_proto;
-    return retc;
-  }
+  unsigned long long generation = 0;
+  ResponseProto* resp_stat = GetCachedResponse(EosAuthMdCache::kStatMode, path,
+                             client, opaque, generation);
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+  if (!resp_stat) {
+    RequestProto* req_proto = utils::GetStatRequest(
+                                RequestProto_OperationType_STATM,
+                                path, error, client, opaque);
+    resp_stat = ForwardRequest(req_proto, "FS statm");
 
     if (resp_stat) {
-      retc = resp_stat->response();
+      mMdCache.Put(EosAuthMdCache::kStatMode, path, opaque, client, *resp_stat,
+                   generation);
+    }
+  }
 
-      if (resp_stat->has_error()) {
-        error.setErrInfo(resp_stat->error().code(),
-                         resp_stat->error().message().c_str());
-      }
+  if (resp_stat) {
+    retc = resp_stat->response();
 
-      // We retrieve the open mode if response if ok
-      if ((retc == SFS_OK) && resp_stat->has_message()) {
-        memcpy((void*)&mode, resp_stat->message().c_str(), sizeof(mode_t));
-      }
+    if (resp_stat->has_error()) {
+      error.setErrInfo(resp_stat->error().code(),
+                       resp_stat->error().message().c_str());
+    }
 
-      delete resp_stat;
+    // We retrieve the open mode if response if ok
+    if ((retc == SFS_OK) && resp_stat->has_message()) {
+      memcpy((void*)&mode, resp_stat->message().c_str(), sizeof(mode_t));
     }
+
+    delete resp_stat;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
   return retc;
 }
 
@@ -674,6 +696,12 @@ EosAuthOfs::fsctl(const int cmd,
     return SFS_DATA;
   }
 
+  // Queries of the MGM can modify the namespace, drop all cached entries
+  if ((opcode != SFS_FSCTL_STATFS) && (opcode != SFS_FSCTL_STATLS) &&
+      (opcode != SFS_FSCTL_STATXA)) {
+    mMdCache.Clear();
+  }
+
   RequestProto* req_proto = utils::GetFsctlRequest(cmd, args, error, client);
 
   // Compute HMAC for request object
@@ -720,6 +748,7 @@ EosAuthOfs::FSctl(const int cmd,
 {
   int retc = SFS_ERROR;
   eos_debug("FSctl with cmd=%i", cmd);
+  mMdCache.Clear();
   RequestProto* req_proto = utils::GetFSctlRequest(cmd, args, error, client);
 
   // Compute HMAC for request object
@@ -767,6 +796,7 @@ EosAuthOfs::chmod(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("chmod path=%s mode=%o", path, mode);
+  mMdCache.Invalidate(path);
   RequestProto* req_proto = utils::GetChmodRequest(path, mode, error, client,
                             opaque);
 
@@ -796,6 +826,9 @@ EosAuthOfs::chmod(const char* path,
     }
   }
 
+  // Drop what was cached while the request was in flight
+  mMdCache.Invalidate(path);
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
@@ -865,42 +898,37 @@ EosAuthOfs::exists(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("exists path=%s", path);
-  RequestProto* req_proto = utils::GetExistsRequest(path, error, client, opaque);
+  unsigned long long generation = 0;
+  ResponseProto* resp_exists = GetCachedResponse(EosAuthMdCache::kExists, path,
+                               client, opaque, generation);
 
-  // Compute HMAC for request object
-  if (!utils::ComputeHMAC(req_proto)) {
-    eos_err("error HMAC FS exists");
-    delete req_proto;
-    return retc;
-  }
-
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_exists = static_cast<ResponseProto*>(GetResponse(socket));
+  if (!resp_exists) {
+    RequestProto* req_proto = utils::GetExistsRequest(path, error, client,
+                              opaque);
+    resp_exists = ForwardRequest(req_proto, "FS exists");
 
     if (resp_exists) {
-      retc = resp_exists->response();
-      eos_debug("exists retc=%i", retc);
+      mMdCache.Put(EosAuthMdCache::kExists, path, opaque, client, *resp_exists,
+                   generation);
+    }
+  }
 
-      if (resp_exists->has_error()) {
-        error.setErrInfo(resp_exists->error().code(),
-                         resp_exists->error().message().c_str());
-      }
+  if (resp_exists) {
+    retc = resp_exists->response();
+    eos_debug("exists retc=%i", retc);
 
-      if (resp_exists->has_message()) {
-        exists_flag = (XrdSfsFileExistence)atoi(resp_exists->message().c_str());
-      }
+    if (resp_exists->has_error()) {
+      error.setErrInfo(resp_exists->error().code(),
+                       resp_exists->error().message().c_str());
+    }
 
-      delete resp_exists;
+    if (resp_exists->has_message()) {
+      exists_flag = (XrdSfsFileExistence)atoi(resp_exists->message().c_str());
     }
+
+    delete resp_exists;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
-  delete req_proto;
   return retc;
 }
 
@@ -921,6 +949,7 @@ EosAuthOfs::mkdir(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("mkdir path=%s mode=%o", path, mode);
+  mMdCache.Invalidate(path);
   RequestProto* req_proto = utils::GetMkdirRequest(path, mode, error, client,
                             opaque);
 
@@ -951,6 +980,9 @@ EosAuthOfs::mkdir(const char* path,
     }
   }
 
+  // Drop what was cached while the request was in flight
+  mMdCache.Invalidate(path);
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
@@ -969,6 +1001,7 @@ EosAuthOfs::remdir(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("remdir path=%s", path);
+  mMdCache.Invalidate(path);
   RequestProto* req_proto = utils::GetRemdirRequest(path, error, client, opaque);
 
   // Compute HMAC for request object
@@ -998,6 +1031,9 @@ EosAuthOfs::remdir(const char* path,
     }
   }
 
+  // Drop what was cached while the request was in flight
+  mMdCache.Invalidate(path);
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
@@ -1016,6 +1052,7 @@ EosAuthOfs::rem(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("rem path=%s", path);
+  mMdCache.Invalidate(path);
   RequestProto* req_proto = utils::GetRemRequest(path, error, client, opaque);
 
   // Compute HMAC for request object
@@ -1045,6 +1082,9 @@ EosAuthOfs::rem(const char* path,
     }
   }
 
+  // Drop what was cached while the request was in flight
+  mMdCache.Invalidate(path);
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
@@ -1065,6 +1105,8 @@ EosAuthOfs::rename(const char* oldName,
 {
   int retc = SFS_ERROR;
   eos_debug("rename oldname=%s newname=%s", oldName, newName);
+  mMdCache.Invalidate(oldName);
+  mMdCache.Invalidate(newName);
   RequestProto* req_proto = utils::GetRenameRequest(oldName, newName, error,
                             client, opaqueO, opaqueN);
 
@@ -1095,6 +1137,10 @@ EosAuthOfs::rename(const char* oldName,
     }
   }
 
+  // Drop what was cached while the request was in flight
+  mMdCache.Invalidate(oldName);
+  mMdCache.Invalidate(newName);
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
@@ -1160,6 +1206,7 @@ EosAuthOfs::truncate(const char* path,
 {
   int retc = SFS_ERROR;
   eos_debug("truncate");
+  mMdCache.Invalidate(path);
   RequestProto* req_proto = utils::GetTruncateRequest(path, fileOffset, error,
                             client, opaque);
 
@@ -1190,6 +1237,9 @@ EosAuthOfs::truncate(const char* path,
     }
   }
 
+  // Drop what was cached while the request was in flight
+  mMdCache.Invalidate(path);
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
@@ -1198,15 +1248,74 @@ EosAuthOfs::truncate(const char* path,
 
 
 //------------------------------------------------------------------------------
-// getStats function - not supported by EOS, fake ok response HERE i.e. do not
+// getStats function - report the metadata cache counters HERE i.e. do not
 // build and send a request to the real MGM
 //------------------------------------------------------------------------------
 int
 EosAuthOfs::getStats(char* buff, int blen)
 {
-  int retc = SFS_OK;
   eos_debug("getStats");
-  return retc;
+
+  if (!mMdCache.IsEnabled()) {
+    return SFS_OK;
+  }
+
+  return mMdCache.PrintStats(buff, blen);
+}
+
+
+//------------------------------------------------------------------------------
+// Forward a request to the MGM and get the response
+//------------------------------------------------------------------------------
+ResponseProto*
+EosAuthOfs::ForwardRequest(RequestProto* req_proto, const char* op_name)
+{
+  ResponseProto* resp = 0;
+
+  // Compute HMAC for request object
+  if (!utils::ComputeHMAC(req_proto)) {
+    eos_err("error HMAC %s", op_name);
+    delete req_proto;
+    return resp;
+  }
+
+  // Get a socket object from the pool
+  zmq::socket_t* socket;
+  mPoolSocket.wait_pop(socket);
+
+  if (SendProtoBufRequest(socket, req_proto)) {
+    resp = static_cast<ResponseProto*>(GetResponse(socket));
+  }
+
+  // Release socket and free memory
+  mPoolSocket.push(socket);
+  delete req_proto;
+  return resp;
+}
+
+
+//------------------------------------------------------------------------------
+// Get a response from the metadata cache
+//------------------------------------------------------------------------------
+ResponseProto*
+EosAuthOfs::GetCachedResponse(EosAuthMdCache::Op op, const char* path,
+                              const XrdSecEntity* client, const char* opaque,
+                              unsigned long long& generation)
+{
+  if (!mMdCache.IsEnabled()) {
+    return 0;
+  }
+
+  ResponseProto* resp = new ResponseProto();
+
+  if (!mMdCache.Get(op, path, opaque, client, *resp, generation)) {
+    delete resp;
+    return 0;
+  }
+
+  eos_debug("%s path=%s served from the metadata cache",
+            EosAuthMdCache::GetOpName(op), path);
+  return resp;
 }
 
 
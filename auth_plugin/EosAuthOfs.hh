@@ -26,6 +26,7 @@
 
 #include "XrdOfs/XrdOfs.hh"
 #include "Namespace.hh"
+#include "EosAuthMdCache.hh"
 #include "common/ConcurrentQueue.hh"
 #include "mgm/ZMQ.hh"
 #include <string>
@@ -44,6 +45,8 @@ class Message;
 
 EOSAUTHNAMESPACE_BEGIN
 
+class RequestProto;
+
 //------------------------------------------------------------------------------
 //! Class EosAuthOfs built on top of XrdOfs
 /*! Decription: The libEosAuthOfs.so is inteded to be used as an OFS library
@@ -71,6 +74,15 @@ EOSAUTHNAMESPACE_BEGIN
         to the MGM node. Therefore, we set up a pool of sockets from the
         begining which can be used to send/receiver requests/responses.
         The default size is 10 sockets.
+    - eosauth.mdcachettl - time to live in milliseconds of the responses to
+        stat, exists and directory listing requests kept in the metadata
+        cache of the plugin. The cache is keyed by path, opaque information
+        and identity of the client connection and any modifying request going
+        through the plugin drops the affected entries. Changes done through
+        other MGM clients are seen only after the TTL expired. The default
+        is 0 i.e. the cache is disabled.
+    - eosauth.mdcachesize - maximum number of entries in the metadata cache.
+        The default is 100000 entries.
 
     MGM - configuration
     ===================
@@ -237,8 +249,8 @@ public:
                const char* opaque = 0);
 
   //--------------------------------------------------------------------------
-  //! getStats function - fake an ok response HERE i.e. do not build and sent
-  //! a request to the real MGM
+  //! getStats function - report the metadata cache counters HERE i.e. do not
+  //! build and sent a request to the real MGM
   //--------------------------------------------------------------------------
   int getStats(char* buff, int blen);
 
@@ -258,6 +270,7 @@ private:
   std::string mManagerIp; ///< auth ip address
   int mPort;   ///< port on which the current auth server runs
   int mLogLevel; ///< log level value 0 -7 (LOG_EMERG - LOG_DEBUG)
+  EosAuthMdCache mMdCache; ///< cache of stat, exists and listing responses
 
   //--------------------------------------------------------------------------
   //! Authentication proxy thread which forwards requests form the clients
@@ -293,6 +306,37 @@ private:
   //--------------------------------------------------------------------------
   google::protobuf::Message* GetResponse(zmq::socket_t*& socket);
 
+  //--------------------------------------------------------------------------
+  //! Forward a request to the MGM and get the response
+  //!
+  //! @param req_proto request object, deleted by this function
+  //! @param op_name name of the operation used in error messages
+  //!
+  //! @return pointer to received object, the user has the responsibility to
+  //!         delete the obtained object, 0 if an error occured
+  //!
+  //--------------------------------------------------------------------------
+  ResponseProto* ForwardRequest(RequestProto* req_proto, const char* op_name);
+
+  //--------------------------------------------------------------------------
+  //! Get a response from the metadata cache
+  //!
+  //! @param op operation type
+  //! @param path path of the request
+  //! @param client client identity
+  //! @param opaque opaque information of the request
+  //! @param generation filled on a miss, to be passed when storing the
+  //!        response obtained from the MGM
+  //!
+  //! @return pointer to a copy of the cached response, the user has the
+  //!         responsibility to delete the obtained object, 0 on a miss
+  //!
+  //--------------------------------------------------------------------------
+  ResponseProto* GetCachedResponse(EosAuthMdCache::Op op, const char* path,
+                                   const XrdSecEntity* client,
+                                   const char* opaque,
+                                   unsigned long long& generation);
+
   //--------------------------------------------------------------------------
   //! Update the socket pointing to the master MGM instance
   //!
@@ -37,7 +37,12 @@ EOSAUTHNAMESPACE_BEGIN
 EosAuthOfsDirectory::EosAuthOfsDirectory(char* user, int MonID):
   XrdSfsDirectory(user, MonID),
   LogId(),
-  mName("")
+  mName(""),
+  mClient(0),
+  mCached(false),
+  mCollect(false),
+  mGeneration(0),
+  mPos(0)
 {
   // empty
 }
@@ -62,7 +67,21 @@ EosAuthOfsDirectory::open(const char* name,
 {
   int retc = SFS_ERROR;
   eos_debug("dir open name=%s", name);
-  mName = name; // save only for debugging purposes
+  mName = name; // save for debugging and the metadata cache
+  mOpaque = (opaque ? opaque : "");
+  mClient = client;
+  mEntries.clear();
+  mPos = 0;
+  mCached = (gOFS->mMdCache.IsEnabled() &&
+             gOFS->mMdCache.GetListing(name, opaque, client, mEntries,
+                                       mGeneration));
+
+  if (mCached)
+  {
+    eos_debug("dir open name=%s served from the metadata cache", name);
+    return SFS_OK;
+  }
+
   std::ostringstream sstr;
   // Add the current machine's IP to the uuid in order to avoid collisions in case
   // we have multiple auth plugins connecting to the same MGM node 
@@ -93,6 +112,9 @@ EosAuthOfsDirectory::open(const char* name,
       delete resp_open;
     }
   }
+
+  // Collect the entries to cache the listing once it is read until the end
+  mCollect = ((retc == SFS_OK) && gOFS->mMdCache.IsEnabled());
   
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
@@ -109,6 +131,13 @@ EosAuthOfsDirectory::nextEntry()
 {
   int retc = SFS_ERROR;
   eos_debug("dir read name=%s", mName.c_str());
+
+  if (mCached)
+  {
+    return ((mPos < mEntries.size()) ? mEntries[mPos++].c_str() :
+            static_cast<const char*>(0));
+  }
+
   std::ostringstream sstr;
   sstr << gOFS->mManagerIp << ":" << this;
   RequestProto* req_proto = utils::GetDirReadRequest(sstr.str());
@@ -121,6 +150,9 @@ EosAuthOfsDirectory::nextEntry()
     return static_cast<const char*>(0) ;
   }
   
+  // A listing interrupted by a communication error is not cached
+  bool collect = mCollect;
+  mCollect = false;
   // Get a socket object from the pool
   zmq::socket_t* socket;
   gOFS->mPoolSocket.wait_pop(socket);
@@ -138,10 +170,22 @@ EosAuthOfsDirectory::nextEntry()
       {
         eos_debug("next entry is: %s", resp_read->message().c_str());
         mNextEntry = resp_read->message();
+
+        if (collect)
+        {
+          mEntries.push_back(mNextEntry);
+          mCollect = true;
+        }
       }
       else 
       {
         eos_debug("no more entries or error on server side");
+
+        if (collect)
+        {
+          gOFS->mMdCache.PutListing(mName.c_str(), mOpaque.c_str(), mClient,
+                                    mEntries, mGeneration);
+        }
       }
       
       delete resp_read;
@@ -163,6 +207,16 @@ EosAuthOfsDirectory::close()
 {
   int retc = SFS_ERROR;
   eos_debug("dir close name=%s", mName.c_str());
+  mCollect = false;
+  mEntries.clear();
+
+  // Nothing was opened on the MGM for a cached listing
+  if (mCached)
+  {
+    mCached = false;
+    return SFS_OK;
+  }
+
   std::ostringstream sstr;
   sstr << gOFS->mManagerIp << ":" << this;
   RequestProto* req_proto = utils::GetDirCloseRequest(sstr.str());
@@ -206,6 +260,12 @@ EosAuthOfsDirectory::FName()
 {
   int retc = SFS_ERROR;
   eos_debug("dir fname");
+
+  if (mCached)
+  {
+    return mName.c_str();
+  }
+
   std::ostringstream sstr;
   sstr << gOFS->mManagerIp << ":" << this;
   RequestProto* req_proto = utils::GetDirFnameRequest(sstr.str());
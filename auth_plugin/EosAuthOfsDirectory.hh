@@ -33,6 +33,9 @@
 #include "XrdSec/XrdSecEntity.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 /*----------------------------------------------------------------------------*/
+#include <string>
+#include <vector>
+/*----------------------------------------------------------------------------*/
 
 EOSAUTHNAMESPACE_BEGIN
 
@@ -81,8 +84,16 @@ class EosAuthOfsDirectory: public XrdSfsDirectory, public eos::common::LogId
 
   private:
 
-    std::string mName; ///< keep directory name just for debugging purposes
+    std::string mName; ///< directory name, also metadata cache key
     std::string mNextEntry; ///< next entry value in directory
+    std::string mOpaque; ///< opaque information used to open the directory
+    //! Client identity, the directory is only used during one client request
+    const XrdSecClientName* mClient;
+    bool mCached; ///< entries are served from the metadata cache
+    bool mCollect; ///< entries are collected for the metadata cache
+    unsigned long long mGeneration; ///< metadata cache generation at open
+    std::vector<std::string> mEntries; ///< directory entries
+    size_t mPos; ///< position of the next cached entry
 };
 
 EOSAUTHNAMESPACE_END
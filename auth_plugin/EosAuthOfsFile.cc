@@ -26,18 +26,46 @@
 #include "EosAuthOfs.hh"
 #include "ProtoUtils.hh"
 /*----------------------------------------------------------------------------*/
+#include "XrdOuc/XrdOucEnv.hh"
+/*----------------------------------------------------------------------------*/
+#include <set>
 #include <sstream>
 /*----------------------------------------------------------------------------*/
 
 EOSAUTHNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Check if opening a file can modify the namespace - proc commands which are
+// not known to be read-only are considered as modifying
+//------------------------------------------------------------------------------
+static bool
+IsModifyingOpen(const char* name, XrdSfsFileOpenMode openMode,
+                const char* opaque)
+{
+  static const std::set<std::string> read_cmds {"ls", "fileinfo", "find",
+      "whoami", "who", "version", "motd"};
+
+  if (openMode & (SFS_O_WRONLY | SFS_O_RDWR | SFS_O_CREAT | SFS_O_TRUNC)) {
+    return true;
+  }
+
+  if (strncmp(name, "/proc/", 6)) {
+    return false;
+  }
+
+  XrdOucEnv env(opaque);
+  const char* cmd = env.Get("mgm.cmd");
+  return (!cmd || !read_cmds.count(cmd));
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 EosAuthOfsFile::EosAuthOfsFile(char* user, int MonID):
   XrdSfsFile(user, MonID),
   eos::common::LogId(),
-  mName("")
+  mName(""),
+  mModify(false)
 {
   // emtpy
 }
@@ -65,6 +93,18 @@ EosAuthOfsFile::open(const char* fileName,
   int retc = SFS_ERROR;
   eos_debug("file open name=%s opaque=%s", fileName, opaque);
   mName = fileName;
+  mModify = IsModifyingOpen(fileName, openMode, opaque);
+
+  // Drop the cached metadata of files which are written or proc commands
+  // which can change anything
+  if (mModify) {
+    if (mName.find("/proc/") == 0) {
+      gOFS->mMdCache.Clear();
+    } else {
+      gOFS->mMdCache.Invalidate(fileName);
+    }
+  }
+
   // Save file pointer value which is used as a key on the MGM instance
   std::ostringstream sstr;
   // Add the current machine's IP to the uuid in order to avoid collisions in case
@@ -338,6 +378,11 @@ EosAuthOfsFile::close()
     }
   }
 
+  // Size and modification time of a written file are final only now
+  if (mModify && (mName.find("/proc/") != 0)) {
+    gOFS->mMdCache.Invalidate(mName.c_str());
+  }
+
   // Release socket and free memory
   gOFS->mPoolSocket.push(socket);
   delete req_proto;
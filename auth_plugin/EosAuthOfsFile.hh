@@ -160,6 +160,7 @@ class EosAuthOfsFile: public XrdSfsFile, public eos::common::LogId
   private:
 
     std::string mName; ///< file name
+    bool mModify; ///< open can modify the namespace
 
     //--------------------------------------------------------------------------
     //! Create an error message for a file object
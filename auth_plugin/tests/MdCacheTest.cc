@@ -0,0 +1,591 @@
+//------------------------------------------------------------------------------
+// File: MdCacheTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+/*----------------------------------------------------------------------------*/
+#include <cppunit/extensions/HelperMacros.h>
+/*----------------------------------------------------------------------------*/
+#include "auth_plugin/EosAuthMdCache.hh"
+#include "auth_plugin/ProtoUtils.hh"
+#include "XrdOuc/XrdOucErrInfo.hh"
+#include "XrdSec/XrdSecEntity.hh"
+#include "XrdSfs/XrdSfsInterface.hh"
+/*----------------------------------------------------------------------------*/
+#include <sys/stat.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <zmq.hpp>
+/*----------------------------------------------------------------------------*/
+
+using eos::auth::EosAuthMdCache;
+using eos::auth::RequestProto;
+using eos::auth::ResponseProto;
+
+//------------------------------------------------------------------------------
+//! MockMgm class - answers the requests of the auth plugin like the MGM and
+//! counts how many requests it received for each path
+//------------------------------------------------------------------------------
+class MockMgm
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor - start serving requests on the given endpoint
+  //----------------------------------------------------------------------------
+  MockMgm(zmq::context_t& ctx, const std::string& endpoint):
+    mSocket(ctx, ZMQ_REP), mRunning(true)
+  {
+    mSocket.bind(endpoint.c_str());
+    mThread = std::thread(&MockMgm::Serve, this);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~MockMgm()
+  {
+    mRunning = false;
+    mThread.join();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of requests received for a path
+  //----------------------------------------------------------------------------
+  int GetCount(const std::string& path)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCount[path];
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Answer requests until stopped
+  //----------------------------------------------------------------------------
+  void Serve()
+  {
+    zmq::pollitem_t items[] = {{(void*) mSocket, 0, ZMQ_POLLIN, 0}};
+
+    while (mRunning) {
+      zmq::poll(items, 1, 100);
+
+      if (!(items[0].revents & ZMQ_POLLIN)) {
+        continue;
+      }
+
+      zmq::message_t request;
+      mSocket.recv(&request);
+      RequestProto req_proto;
+      req_proto.ParseFromArray(request.data(), request.size());
+      ResponseProto resp;
+      Handle(req_proto, resp);
+      std::string out;
+      resp.SerializeToString(&out);
+      zmq::message_t reply(out.size());
+      memcpy(reply.data(), out.c_str(), out.size());
+      mSocket.send(reply);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Build the response to a request
+  //----------------------------------------------------------------------------
+  void Handle(const RequestProto& req_proto, ResponseProto& resp)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    resp.set_response(SFS_OK);
+
+    if ((req_proto.type() == RequestProto::STAT) ||
+        (req_proto.type() == RequestProto::STATM)) {
+      const std::string& path = req_proto.stat().path();
+      int count = ++mCount[path];
+
+      if ((path == "/eos/missing") || (path == "/eos/broken")) {
+        resp.set_response(SFS_ERROR);
+        resp.mutable_error()->set_user("mock");
+        resp.mutable_error()->set_code(path == "/eos/missing" ? ENOENT : EIO);
+        resp.mutable_error()->set_message("mock error");
+      } else {
+        // The size tells which request the answer belongs to
+        struct stat buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.st_size = count;
+        resp.set_message(&buf, sizeof(buf));
+      }
+    } else if (req_proto.type() == RequestProto::EXISTS) {
+      ++mCount[req_proto.exists().path()];
+      resp.set_message(std::to_string(XrdSfsFileExistIsFile));
+    } else if (req_proto.type() == RequestProto::DIROPEN) {
+      ++mCount[req_proto.diropen().name()];
+      mDirPos[req_proto.diropen().uuid()] = 0;
+    } else if (req_proto.type() == RequestProto::DIRREAD) {
+      int& pos = mDirPos[req_proto.dirread().uuid()];
+
+      if (pos < 3) {
+        resp.set_message("entry" + std::to_string(pos++));
+      } else {
+        resp.set_response(SFS_ERROR);
+      }
+    } else if (req_proto.type() == RequestProto::DIRCLOSE) {
+      mDirPos.erase(req_proto.dirclose().uuid());
+    } else {
+      resp.set_response(SFS_ERROR);
+    }
+  }
+
+  zmq::socket_t mSocket; ///< socket facing the auth plugin
+  std::atomic<bool> mRunning; ///< mark if the mock is serving
+  std::thread mThread; ///< serving thread
+  std::mutex mMutex; ///< mutex protecting the counters
+  std::map<std::string, int> mCount; ///< requests per path
+  std::map<std::string, int> mDirPos; ///< listing position per directory
+};
+
+
+//------------------------------------------------------------------------------
+//! MdCacheTest class
+//------------------------------------------------------------------------------
+class MdCacheTest: public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(MdCacheTest);
+  CPPUNIT_TEST(HitTest);
+  CPPUNIT_TEST(ExpiryTest);
+  CPPUNIT_TEST(ErrorTest);
+  CPPUNIT_TEST(InvalidateTest);
+  CPPUNIT_TEST(RaceTest);
+  CPPUNIT_TEST(DirListTest);
+  CPPUNIT_TEST(StatsTest);
+  CPPUNIT_TEST(IdentityTest);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  //----------------------------------------------------------------------------
+  //! setUp function called before each test is done
+  //----------------------------------------------------------------------------
+  void setUp(void);
+
+  //----------------------------------------------------------------------------
+  //! tearDown function after each test is done
+  //----------------------------------------------------------------------------
+  void tearDown(void);
+
+  //----------------------------------------------------------------------------
+  //! Repeated requests are served from the cache per identity class
+  //----------------------------------------------------------------------------
+  void HitTest();
+
+  //----------------------------------------------------------------------------
+  //! Entries expire after the TTL
+  //----------------------------------------------------------------------------
+  void ExpiryTest();
+
+  //----------------------------------------------------------------------------
+  //! Only "no such file" errors are cached
+  //----------------------------------------------------------------------------
+  void ErrorTest();
+
+  //----------------------------------------------------------------------------
+  //! Modifications drop the path, its parent and everything below it
+  //----------------------------------------------------------------------------
+  void InvalidateTest();
+
+  //----------------------------------------------------------------------------
+  //! A response racing with a modification is not stored
+  //----------------------------------------------------------------------------
+  void RaceTest();
+
+  //----------------------------------------------------------------------------
+  //! Directory listings are cached once read until the end
+  //----------------------------------------------------------------------------
+  void DirListTest();
+
+  //----------------------------------------------------------------------------
+  //! Hit rates per operation
+  //----------------------------------------------------------------------------
+  void StatsTest();
+
+  //----------------------------------------------------------------------------
+  //! Every identity field forwarded to the MGM separates the entries
+  //----------------------------------------------------------------------------
+  void IdentityTest();
+
+private:
+
+  //----------------------------------------------------------------------------
+  //! Send a request to the mock MGM and get the response
+  //----------------------------------------------------------------------------
+  ResponseProto* Forward(RequestProto* req_proto);
+
+  //----------------------------------------------------------------------------
+  //! Stat through the cache like EosAuthOfs::stat
+  //!
+  //! @return size of the file which is the number of stat requests seen by
+  //!         the mock MGM when it answered, -errno on error
+  //----------------------------------------------------------------------------
+  long long Stat(const char* path, const XrdSecEntity* client,
+                 const char* opaque = "");
+
+  //----------------------------------------------------------------------------
+  //! List a directory through the cache like EosAuthOfsDirectory
+  //----------------------------------------------------------------------------
+  std::vector<std::string> List(const char* path, const XrdSecEntity* client);
+
+  zmq::context_t* mCtx; ///< ZMQ context
+  MockMgm* mMgm; ///< mock MGM
+  zmq::socket_t* mSocket; ///< socket connected to the mock MGM
+  EosAuthMdCache* mCache; ///< cache under test
+  XrdSecEntity* mAlice; ///< client identity
+  XrdSecEntity* mBob; ///< client identity
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MdCacheTest);
+
+
+//------------------------------------------------------------------------------
+// setUp function called before each test is done
+//------------------------------------------------------------------------------
+void
+MdCacheTest::setUp()
+{
+  std::string endpoint = "inproc://mockmgm";
+  mCtx = new zmq::context_t(1);
+  mMgm = new MockMgm(*mCtx, endpoint);
+  mSocket = new zmq::socket_t(*mCtx, ZMQ_REQ);
+  mSocket->connect(endpoint.c_str());
+  mCache = new EosAuthMdCache();
+  mCache->Configure(60000, 1000);
+  mAlice = new XrdSecEntity("krb5");
+  mAlice->name = (char*) "alice";
+  mAlice->host = (char*) "client.cern.ch";
+  mBob = new XrdSecEntity("krb5");
+  mBob->name = (char*) "bob";
+  mBob->host = (char*) "client.cern.ch";
+}
+
+
+//------------------------------------------------------------------------------
+// tearDown function after each test is done
+//------------------------------------------------------------------------------
+void
+MdCacheTest::tearDown()
+{
+  mAlice->name = mAlice->host = mBob->name = mBob->host = 0;
+  delete mAlice;
+  delete mBob;
+  delete mCache;
+  delete mSocket;
+  delete mMgm;
+  delete mCtx;
+}
+
+
+//------------------------------------------------------------------------------
+// Send a request to the mock MGM and get the response
+//------------------------------------------------------------------------------
+ResponseProto*
+MdCacheTest::Forward(RequestProto* req_proto)
+{
+  std::string out;
+  req_proto->SerializeToString(&out);
+  delete req_proto;
+  zmq::message_t request(out.size());
+  memcpy(request.data(), out.c_str(), out.size());
+  CPPUNIT_ASSERT(mSocket->send(request));
+  zmq::message_t reply;
+  CPPUNIT_ASSERT(mSocket->recv(&reply));
+  ResponseProto* resp = new ResponseProto();
+  CPPUNIT_ASSERT(resp->ParseFromArray(reply.data(), reply.size()));
+  return resp;
+}
+
+
+//------------------------------------------------------------------------------
+// Stat through the cache
+//------------------------------------------------------------------------------
+long long
+MdCacheTest::Stat(const char* path, const XrdSecEntity* client,
+                  const char* opaque)
+{
+  ResponseProto resp;
+  unsigned long long generation = 0;
+
+  if (!mCache->Get(EosAuthMdCache::kStat, path, opaque, client, resp,
+                   generation)) {
+    XrdOucErrInfo error("test");
+    ResponseProto* mgm_resp = Forward(eos::auth::utils::GetStatRequest(
+                                        RequestProto::STAT, path, error, client, opaque));
+    mCache->Put(EosAuthMdCache::kStat, path, opaque, client, *mgm_resp,
+                generation);
+    resp.CopyFrom(*mgm_resp);
+    delete mgm_resp;
+  }
+
+  if (resp.response() != SFS_OK) {
+    return -resp.error().code();
+  }
+
+  struct stat buf;
+  CPPUNIT_ASSERT(resp.message().size() == sizeof(buf));
+  memcpy(&buf, resp.message().c_str(), sizeof(buf));
+  return buf.st_size;
+}
+
+
+//------------------------------------------------------------------------------
+// List a directory through the cache
+//------------------------------------------------------------------------------
+std::vector<std::string>
+MdCacheTest::List(const char* path, const XrdSecEntity* client)
+{
+  std::vector<std::string> entries;
+  unsigned long long generation = 0;
+
+  if (mCache->GetListing(path, "", client, entries, generation)) {
+    return entries;
+  }
+
+  std::string uuid = "test:" + std::string(path);
+  ResponseProto* resp = Forward(eos::auth::utils::GetDirOpenRequest(
+                                  std::string(uuid), path, client, "", "test", 0));
+  CPPUNIT_ASSERT(resp->response() == SFS_OK);
+  delete resp;
+
+  while (true) {
+    resp = Forward(eos::auth::utils::GetDirReadRequest(std::string(uuid)));
+
+    if (resp->response() != SFS_OK) {
+      delete resp;
+      break;
+    }
+
+    entries.push_back(resp->message());
+    delete resp;
+  }
+
+  mCache->PutListing(path, "", client, entries, generation);
+  delete Forward(eos::auth::utils::GetDirCloseRequest(std::string(uuid)));
+  return entries;
+}
+
+
+//------------------------------------------------------------------------------
+// Repeated requests are served from the cache per identity class
+//------------------------------------------------------------------------------
+void
+MdCacheTest::HitTest()
+{
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file/", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1, mMgm->GetCount("/eos/dir/file"));
+  // Other identity class and other opaque information are separate entries
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/dir/file", mBob));
+  CPPUNIT_ASSERT_EQUAL(3ll, Stat("/eos/dir/file", mAlice, "eos.ruid=0"));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/dir/file", mBob));
+  CPPUNIT_ASSERT_EQUAL(3, mMgm->GetCount("/eos/dir/file"));
+  CPPUNIT_ASSERT_EQUAL((size_t) 3, mCache->Size());
+  // A disabled cache does not store anything
+  mCache->Configure(0, 1000);
+  CPPUNIT_ASSERT_EQUAL(4ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL(5ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, mCache->Size());
+}
+
+
+//------------------------------------------------------------------------------
+// Entries expire after the TTL
+//------------------------------------------------------------------------------
+void
+MdCacheTest::ExpiryTest()
+{
+  mCache->Configure(50, 2);
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file", mAlice));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/dir/file", mAlice));
+  // The cache never grows beyond its maximum size
+  Stat("/eos/dir/file1", mAlice);
+  Stat("/eos/dir/file2", mAlice);
+  CPPUNIT_ASSERT(mCache->Size() <= 2);
+}
+
+
+//------------------------------------------------------------------------------
+// Only "no such file" errors are cached
+//------------------------------------------------------------------------------
+void
+MdCacheTest::ErrorTest()
+{
+  CPPUNIT_ASSERT_EQUAL(-(long long) ENOENT, Stat("/eos/missing", mAlice));
+  CPPUNIT_ASSERT_EQUAL(-(long long) ENOENT, Stat("/eos/missing", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1, mMgm->GetCount("/eos/missing"));
+  CPPUNIT_ASSERT_EQUAL(-(long long) EIO, Stat("/eos/broken", mAlice));
+  CPPUNIT_ASSERT_EQUAL(-(long long) EIO, Stat("/eos/broken", mAlice));
+  CPPUNIT_ASSERT_EQUAL(2, mMgm->GetCount("/eos/broken"));
+}
+
+
+//------------------------------------------------------------------------------
+// Modifications drop the path, its parent and everything below it
+//------------------------------------------------------------------------------
+void
+MdCacheTest::InvalidateTest()
+{
+  const char* paths[] = {"/eos/a", "/eos/a/b", "/eos/a/b/c", "/eos/a/b/c/d",
+                         "/eos/a/bb", "/eos/a/x"
+                        };
+
+  for (auto path : paths) {
+    CPPUNIT_ASSERT_EQUAL(1ll, Stat(path, mAlice));
+  }
+
+  // Create or delete /eos/a/b/c
+  mCache->Invalidate("/eos/a/b/c");
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/a", mAlice));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/a/b", mAlice));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/a/b/c", mAlice));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/a/b/c/d", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/a/bb", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/a/x", mAlice));
+  // Rename of a directory with a trailing slash
+  mCache->Invalidate("/eos/a/b/");
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/a", mAlice));
+  CPPUNIT_ASSERT_EQUAL(3ll, Stat("/eos/a/b/c/d", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/a/bb", mAlice));
+  // Everything is dropped
+  mCache->Clear();
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, mCache->Size());
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/a/x", mAlice));
+}
+
+
+//------------------------------------------------------------------------------
+// A response racing with a modification is not stored
+//------------------------------------------------------------------------------
+void
+MdCacheTest::RaceTest()
+{
+  ResponseProto resp;
+  unsigned long long generation = 0;
+  CPPUNIT_ASSERT(!mCache->Get(EosAuthMdCache::kStat, "/eos/dir/file", "",
+                              mAlice, resp, generation));
+  XrdOucErrInfo error("test");
+  ResponseProto* mgm_resp = Forward(eos::auth::utils::GetStatRequest(
+                                      RequestProto::STAT, "/eos/dir/file", error, mAlice, ""));
+  // Another client removes the file in the meantime
+  mCache->Invalidate("/eos/dir/file");
+  CPPUNIT_ASSERT(!mCache->Put(EosAuthMdCache::kStat, "/eos/dir/file", "",
+                              mAlice, *mgm_resp, generation));
+  delete mgm_resp;
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/dir/file", mAlice));
+}
+
+
+//------------------------------------------------------------------------------
+// Directory listings are cached once read until the end
+//------------------------------------------------------------------------------
+void
+MdCacheTest::DirListTest()
+{
+  std::vector<std::string> expected {"entry0", "entry1", "entry2"};
+  CPPUNIT_ASSERT(expected == List("/eos/dir/", mAlice));
+  CPPUNIT_ASSERT(expected == List("/eos/dir", mAlice));
+  CPPUNIT_ASSERT_EQUAL(1, mMgm->GetCount("/eos/dir/"));
+  CPPUNIT_ASSERT(expected == List("/eos/dir/", mBob));
+  CPPUNIT_ASSERT_EQUAL(2, mMgm->GetCount("/eos/dir/"));
+  // A new file in the directory drops the listing
+  mCache->Invalidate("/eos/dir/newfile");
+  CPPUNIT_ASSERT(expected == List("/eos/dir/", mAlice));
+  CPPUNIT_ASSERT_EQUAL(3, mMgm->GetCount("/eos/dir/"));
+}
+
+
+//------------------------------------------------------------------------------
+// Hit rates per operation
+//------------------------------------------------------------------------------
+void
+MdCacheTest::StatsTest()
+{
+  unsigned long long hits, misses;
+
+  for (int i = 0; i < 4; ++i) {
+    Stat("/eos/dir/file", mAlice);
+  }
+
+  List("/eos/dir", mAlice);
+  mCache->GetCounters(EosAuthMdCache::kStat, hits, misses);
+  CPPUNIT_ASSERT_EQUAL(3ull, hits);
+  CPPUNIT_ASSERT_EQUAL(1ull, misses);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(75.0, mCache->GetHitRate(EosAuthMdCache::kStat),
+                               0.001);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0,
+                               mCache->GetHitRate(EosAuthMdCache::kDirList),
+                               0.001);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0,
+                               mCache->GetHitRate(EosAuthMdCache::kExists),
+                               0.001);
+  char buff[1024];
+  int len = mCache->PrintStats(buff, sizeof(buff));
+  CPPUNIT_ASSERT(len > 0);
+  std::string stats(buff, len);
+  CPPUNIT_ASSERT(stats.find("<stat><hits>3</hits><misses>1</misses>"
+                            "<rate>75.00</rate></stat>") != std::string::npos);
+  CPPUNIT_ASSERT(stats.find("<readdir><hits>0</hits><misses>1</misses>") !=
+                 std::string::npos);
+  CPPUNIT_ASSERT_EQUAL(0, mCache->PrintStats(buff, 16));
+}
+
+
+//------------------------------------------------------------------------------
+// Every identity field forwarded to the MGM separates the entries
+//------------------------------------------------------------------------------
+void
+MdCacheTest::IdentityTest()
+{
+  XrdSecEntity other("krb5");
+  other.name = (char*) "alice";
+  other.host = (char*) "client.cern.ch";
+  CPPUNIT_ASSERT(EosAuthMdCache::GetIdentity(mAlice) ==
+                 EosAuthMdCache::GetIdentity(&other));
+  other.tident = "alice.1:2@client";
+  CPPUNIT_ASSERT(EosAuthMdCache::GetIdentity(mAlice) !=
+                 EosAuthMdCache::GetIdentity(&other));
+  other.tident = 0;
+  other.endorsements = (char*) "vo";
+  CPPUNIT_ASSERT(EosAuthMdCache::GetIdentity(mAlice) !=
+                 EosAuthMdCache::GetIdentity(&other));
+  other.endorsements = 0;
+  other.creds = (char*) "token";
+  other.credslen = 5;
+  CPPUNIT_ASSERT(EosAuthMdCache::GetIdentity(mAlice) !=
+                 EosAuthMdCache::GetIdentity(&other));
+  // Requests of another connection are not served from the cache
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file", mAlice));
+  CPPUNIT_ASSERT_EQUAL(2ll, Stat("/eos/dir/file", &other));
+  CPPUNIT_ASSERT_EQUAL(1ll, Stat("/eos/dir/file", mAlice));
+  other.name = other.host = other.creds = 0;
+  other.credslen = 0;
+}
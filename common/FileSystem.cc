@@ -48,6 +48,9 @@ FileSystem::FileSystem(const char* queuepath, const char* queue,
   cActiveTime = 0;
   cStatusTime = 0;
   cConfigTime = 0;
+  cSnapshotChangeId = 0;
+  cHash = nullptr;
+  cHashGeneration = ~0ull;
   std::string broadcast = queue;
 
   if (bc2mgm) {
@@ -469,6 +472,70 @@ FileSystem::CreateConfig(std::string& key, std::string& val)
   val = mHash->SerializeWithFilter("stat.");
 }
 
+//------------------------------------------------------------------------------
+// Get the shared hash of the file system
+//------------------------------------------------------------------------------
+XrdMqSharedHash*
+FileSystem::GetCachedHash()
+{
+  unsigned long long generation = mSom->GetHashGeneration();
+  XrdSysMutexHelper snap_lock(cSnapshotLock);
+
+  if (generation != cHashGeneration) {
+    cHash = mSom->GetObject(mQueuePath.c_str(), "hash");
+    cHashGeneration = generation;
+  }
+
+  return cHash;
+}
+
+//------------------------------------------------------------------------------
+// Get the values of several keys with a single lookup of the hash
+//------------------------------------------------------------------------------
+unsigned long long
+FileSystem::GetValues(const std::vector<std::string>& keys,
+                      std::vector<std::string>& values,
+                      unsigned long long known_id)
+{
+  XrdMqRWMutexReadLock lock(mSom->HashMutex);
+  XrdMqSharedHash* hash = GetCachedHash();
+
+  if (!hash) {
+    return 0;
+  }
+
+  unsigned long long change_id = hash->GetChangeId();
+
+  if (change_id == known_id) {
+    return change_id;
+  }
+
+  values.resize(keys.size());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    values[i] = hash->Get(keys[i]);
+  }
+
+  return change_id;
+}
+
+//------------------------------------------------------------------------------
+// Attach a watcher to the shared hash of the file system
+//------------------------------------------------------------------------------
+bool
+FileSystem::AddChangeWatcher(const XrdMqSharedHash::Watcher& watcher)
+{
+  XrdMqRWMutexReadLock lock(mSom->HashMutex);
+  XrdMqSharedHash* hash = GetCachedHash();
+
+  if (!hash) {
+    return false;
+  }
+
+  hash->AddWatcher(watcher);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Snapshots all variables of a filesystem into a snapsthot struct
 //------------------------------------------------------------------------------
@@ -479,7 +546,22 @@ FileSystem::SnapShotFileSystem(FileSystem::fs_snapshot_t& fs, bool dolock)
     mSom->HashMutex.LockRead();
   }
 
-  if ((mHash = mSom->GetObject(mQueuePath.c_str(), "hash"))) {
+  if ((mHash = GetCachedHash())) {
+    // The hash didn't change since the last snapshot, copy it
+    unsigned long long change_id = mHash->GetChangeId();
+    {
+      XrdSysMutexHelper snap_lock(cSnapshotLock);
+
+      if (change_id == cSnapshotChangeId) {
+        fs = cSnapshot;
+
+        if (dolock) {
+          mSom->HashMutex.UnLockRead();
+        }
+
+        return true;
+      }
+    }
     fs.mId = (fsid_t) mHash->GetUInt("id");
     fs.mQueue = mQueue;
     fs.mQueuePath = mQueuePath;
@@ -569,6 +651,13 @@ FileSystem::SnapShotFileSystem(FileSystem::fs_snapshot_t& fs, bool dolock)
     fs.mDrainPeriod = (time_t) mHash->GetLongLong("drainperiod");
     fs.mDrainerOn   = (mHash->Get("stat.drainer") == "on");
     fs.mBalThresh   = mHash->GetDouble("stat.balance.threshold");
+    {
+      // Any modification done while parsing has a newer change id, so the
+      // cached snapshot can't hide it
+      XrdSysMutexHelper snap_lock(cSnapshotLock);
+      cSnapshot = fs;
+      cSnapshotChangeId = change_id;
+    }
 
     if (dolock) {
       mSom->HashMutex.UnLockRead();
@@ -299,6 +299,18 @@ public:
   fsstatus_t cConfigStatus; ///< cached value of the config status
   XrdSysMutex cConfigLock; ///< lock protecting the cached config status
   time_t cConfigTime; ///< unix time stamp of last update of the cached config status
+  fs_snapshot_t cSnapshot; ///< last snapshot parsed from the hash
+  unsigned long long cSnapshotChangeId; ///< change id of the hash for cSnapshot
+  XrdMqSharedHash* cHash; ///< hash looked up at generation cHashGeneration
+  unsigned long long cHashGeneration; ///< hash generation of cHash
+  XrdSysMutex cSnapshotLock; ///< lock protecting the cached snapshot and hash
+
+  //----------------------------------------------------------------------------
+  //! Get the shared hash of the file system. The lookup is only repeated if
+  //! hashes were created or deleted since the previous call. The caller has
+  //! to hold the HashMutex read lock.
+  //----------------------------------------------------------------------------
+  XrdMqSharedHash* GetCachedHash();
 
   //----------------------------------------------------------------------------
   //! Open transcation to initiate bulk modifications on a file system
@@ -514,6 +526,30 @@ public:
     return snapshot.mActiveStatus;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get the values of several keys with a single lookup of the hash, unless
+  //! the hash didn't change since known_id
+  //!
+  //! @param keys keys to read
+  //! @param values filled with the values if the hash changed
+  //! @param known_id change id of the hash when the values were last read
+  //!
+  //! @return current change id of the hash or 0 if it doesn't exist
+  //----------------------------------------------------------------------------
+  unsigned long long GetValues(const std::vector<std::string>& keys,
+                               std::vector<std::string>& values,
+                               unsigned long long known_id);
+
+  //----------------------------------------------------------------------------
+  //! Attach a watcher to the shared hash of the file system, which is
+  //! incremented by every modification of the hash
+  //!
+  //! @param watcher counter to attach
+  //!
+  //! @return false if the hash doesn't exist
+  //----------------------------------------------------------------------------
+  bool AddChangeWatcher(const XrdMqSharedHash::Watcher& watcher);
+
   //----------------------------------------------------------------------------
   //! Get all keys in a vector of strings.
   //----------------------------------------------------------------------------
@@ -72,6 +72,10 @@ std::map<std::string, uid_t> Mapping::gPhysicalUserIdCache;
 std::map<std::string, gid_t> Mapping::gPhysicalGroupIdCache;
 
 Mapping::ip_cache Mapping::gIpCache(300);
+std::atomic<uint64_t> Mapping::gRulesVersion(1);
+std::shared_ptr<const Mapping::CompiledRules> Mapping::gRules;
+Mapping::IdMapCache Mapping::gIdMapCache(getenv("EOS_IDMAP_CACHE_SIZE") ?
+    strtoull(getenv("EOS_IDMAP_CACHE_SIZE"), 0, 10) : 65536, 60);
 /*----------------------------------------------------------------------------*/
 /**
  * Initialize Google maps
@@ -115,6 +119,7 @@ Mapping::Reset()
     XrdSysMutexHelper mLock(ActiveLock);
     ActiveTidents.clear();
   }
+  gIdMapCache.Clear();
 }
 
 
@@ -175,9 +180,124 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
 
   eos_static_debug("name:%s role:%s group:%s tident:%s", client->name,
                    client->role, client->grps, client->tident);
+  XrdOucEnv Env(env);
+  XrdOucString ruid = Env.Get("eos.ruid");
+  XrdOucString rgid = Env.Get("eos.rgid");
+  XrdOucString rapp = Env.Get("eos.app");
+  XrdOucString stident = tident;
+  XrdOucString mytident = "";
+  XrdOucString wildcardtident = "";
+  XrdOucString host = "";
+  ReduceTident(stident, wildcardtident, mytident, host);
+  std::shared_ptr<const CompiledRules> rules = GetRules();
+  // ---------------------------------------------------------------------------
+  // The result only depends on the authentication information, the connection
+  // independent part of the tident and the selected roles - a geo location
+  // set by the caller bypasses the cache
+  // ---------------------------------------------------------------------------
+  bool cacheable = vid.geolocation.empty();
+  std::string key;
+
+  if (cacheable) {
+    const char sep = '\x1f';
+    key = client->prot;
+    key += sep;
+    key += (client->name ? client->name : "");
+    key += sep;
+    key += mytident.c_str();
+    key += sep;
+    key += (client->host ? client->host : "");
+    key += sep;
+    key += (client->grps ? client->grps : "");
+    key += sep;
+    key += (client->role ? client->role : "");
+    key += sep;
+    key += ruid.c_str();
+    key += sep;
+    key += rgid.c_str();
+  }
+
+  VirtualIdentity cached;
+
+  if (cacheable && gIdMapCache.Get(key, rules->mVersion, cached)) {
+    // restore what the mapping doesn't set for this client
+    std::string app = vid.app;
+    std::string dn = vid.dn;
+    std::string grps = vid.grps;
+    std::string role = vid.role;
+    vid = cached;
+    vid.dn = dn;
+    vid.app = (rapp.length() ? rapp.c_str() : app);
+
+    if ((vid.prot != "gsi") || !client->grps) {
+      vid.grps = grps;
+      vid.role = role;
+    } else if (!client->role) {
+      vid.role = role;
+    }
+
+    // a failed VOMS translation leaves the nobody tident
+    if (vid.tident != "nobody@unknown") {
+      vid.tident = tident;
+    }
+  } else {
+    IdMapCompute(client, tident, Env, *rules, vid);
+
+    if (cacheable) {
+      gIdMapCache.Put(key, rules->mVersion, vid);
+    }
+  }
+
+  time_t now = time(NULL);
+
+  // ---------------------------------------------------------------------------
+  // Maintain the active client map and expire old entries
+  // ---------------------------------------------------------------------------
+  ActiveLock.Lock();
+
+  // ---------------------------------------------------------------------------
+  // safty measures not to exceed memory by 'nasty' clients
+  // ---------------------------------------------------------------------------
+  if (ActiveTidents.size() > 25000) {
+    ActiveExpire();
+  }
+
+  if (ActiveTidents.size() < 60000) {
+    char actident[1024];
+    snprintf(actident, sizeof(actident) - 1, "%d^%s^%s^%s^%s", vid.uid,
+             mytident.c_str(), vid.prot.c_str(), vid.host.c_str(), vid.app.c_str());
+    std::string intident = actident;
+    ActiveTidents[intident] = now;
+  }
+
+  ActiveLock.UnLock();
+  eos_static_debug("selected %d %d [%s %s]", vid.uid, vid.gid, ruid.c_str(),
+                   rgid.c_str());
+
+  if (log) {
+    eos_static_info("%s sec.tident=\"%s\"", eos::common::SecEntity::ToString(client,
+                    Env.Get("eos.app")).c_str(), tident);
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * Compute the virtual identity of a client from the compiled mapping rules
+ *
+ * @param client xrootd client authenticatino object
+ * @param tident trace identifier of the client
+ * @param Env opaque information containing role selection
+ * @param rules compiled mapping rules
+ * @param vid returned virtual identity
+ */
+/*----------------------------------------------------------------------------*/
+void
+Mapping::IdMapCompute(const XrdSecEntity* client, const char* tident,
+                      XrdOucEnv& Env, const CompiledRules& rules,
+                      Mapping::VirtualIdentity& vid)
+{
   // you first are 'nobody'
   Nobody(vid);
-  XrdOucEnv Env(env);
   vid.name = client->name;
   vid.tident = tident;
   vid.sudoer = false;
@@ -191,7 +311,6 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   XrdOucString groupalias = useralias;
   useralias += "uid";
   groupalias += "gid";
-  RWMutexReadLock lock(gMapMutex);
   vid.prot = client->prot;
 
   // ---------------------------------------------------------------------------
@@ -200,14 +319,14 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "krb5")) {
     eos_static_debug("krb5 mapping");
 
-    if (gVirtualUidMap.count("krb5:\"<pwd>\":uid")) {
+    if (rules.mUid.count("krb5:\"<pwd>\":uid")) {
       // use physical mapping for kerberos names
       Mapping::getPhysicalIds(client->name, vid);
       vid.gid = 99;
       vid.gid_list.clear();
     }
 
-    if (gVirtualGidMap.count("krb5:\"<pwd>\":gid")) {
+    if (rules.mGid.count("krb5:\"<pwd>\":gid")) {
       // use physical mapping for kerberos names
       uid_t uid = vid.uid;
       Mapping::getPhysicalIds(client->name, vid);
@@ -224,14 +343,14 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "gsi")) {
     eos_static_debug("gsi mapping");
 
-    if (gVirtualUidMap.count("gsi:\"<pwd>\":uid")) {
+    if (rules.mUid.count("gsi:\"<pwd>\":uid")) {
       // use physical mapping for gsi names
       Mapping::getPhysicalIds(client->name, vid);
       vid.gid = 99;
       vid.gid_list.clear();
     }
 
-    if (gVirtualGidMap.count("gsi:\"<pwd>\":gid")) {
+    if (rules.mGid.count("gsi:\"<pwd>\":gid")) {
       // use physical mapping for gsi names
       uid_t uid = vid.uid;
       Mapping::getPhysicalIds(client->name, vid);
@@ -263,28 +382,28 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       vomsgidstring += ":gid";
 
       // mapping to user
-      if (gVirtualUidMap.count(vomsuidstring)) {
+      if (rules.mUid.count(vomsuidstring)) {
         vid.uid_list.clear();
         vid.gid_list.clear();
         // use physical mapping for VOMS roles
         // convert mapped uid to user name
         int errc = 0;
-        std::string cname = Mapping::UidToUserName(gVirtualUidMap[vomsuidstring], errc);
+        std::string cname = Mapping::UidToUserName(rules.Uid(vomsuidstring), errc);
 
         if (!errc) {
           Mapping::getPhysicalIds(cname.c_str(), vid);
         } else {
           Nobody(vid);
           eos_static_err("voms-mapping: cannot translate uid=%d to user name with the password db",
-                         (int) gVirtualUidMap[vomsuidstring]);
+                         (int) rules.Uid(vomsuidstring));
         }
       }
 
       // mapping to group
-      if (gVirtualGidMap.count(vomsgidstring)) {
+      if (rules.mGid.count(vomsgidstring)) {
         // use group mapping for VOMS roles
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap[vomsgidstring];
+        vid.gid = rules.Gid(vomsgidstring);
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -296,23 +415,23 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "https")) {
     eos_static_debug("https mapping");
 
-    if (gVirtualUidMap.count("https:\"<pwd>\":uid")) {
-      if (gVirtualGidMap["https:\"<pwd>\":uid"] == 0) {
+    if (rules.mUid.count("https:\"<pwd>\":uid")) {
+      if (rules.Gid("https:\"<pwd>\":uid") == 0) {
         // use physical mapping for https names
         Mapping::getPhysicalIds(client->name, vid);
         vid.gid = 99;
         vid.gid_list.clear();
       } else {
         vid.uid_list.clear();
-        vid.uid_list.push_back(gVirtualGidMap["https:\"<pwd>\":uid"]);
+        vid.uid_list.push_back(rules.Gid("https:\"<pwd>\":uid"));
         vid.uid_list.push_back(99);
         vid.gid = 99;
         vid.gid_list.clear();
       }
     }
 
-    if (gVirtualGidMap.count("https:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["https:\"<pwd>\":gid"] == 0) {
+    if (rules.mGid.count("https:\"<pwd>\":gid")) {
+      if (rules.Gid("https:\"<pwd>\":gid") == 0) {
         // use physical mapping for gsi names
         uid_t uid = vid.uid;
         Mapping::getPhysicalIds(client->name, vid);
@@ -322,7 +441,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         vid.uid_list.push_back(99);
       } else {
         vid.gid_list.clear();
-        vid.gid_list.push_back(gVirtualGidMap["https:\"<pwd>\":gid"]);
+        vid.gid_list.push_back(rules.Gid("https:\"<pwd>\":gid"));
         vid.gid_list.push_back(99);
       }
     }
@@ -334,8 +453,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "sss")) {
     eos_static_debug("sss mapping");
 
-    if (gVirtualUidMap.count("sss:\"<pwd>\":uid")) {
-      if (gVirtualUidMap["sss:\"<pwd>\":uid"] == 0) {
+    if (rules.mUid.count("sss:\"<pwd>\":uid")) {
+      if (rules.Uid("sss:\"<pwd>\":uid") == 0) {
         eos_static_debug("sss uid mapping");
         Mapping::getPhysicalIds(client->name, vid);
         vid.gid = 99;
@@ -344,7 +463,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("sss uid forced mapping");
         // map to the requested id
         vid.uid_list.clear();
-        vid.uid = gVirtualUidMap["sss:\"<pwd>\":uid"];
+        vid.uid = rules.Uid("sss:\"<pwd>\":uid");
         vid.uid_list.push_back(vid.uid);
 
         if (vid.uid != 99) {
@@ -357,8 +476,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
 
-    if (gVirtualGidMap.count("sss:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["sss:\"<pwd>\":gid"] == 0) {
+    if (rules.mGid.count("sss:\"<pwd>\":gid")) {
+      if (rules.Gid("sss:\"<pwd>\":gid") == 0) {
         eos_static_debug("sss gid mapping");
         // use physical mapping for sss names
         uid_t uid = vid.uid;
@@ -371,7 +490,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("sss forced gid mapping");
         // map to the requested id
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap["sss:\"<pwd>\":gid"];
+        vid.gid = rules.Gid("sss:\"<pwd>\":gid");
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -383,8 +502,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   if ((vid.prot == "unix")) {
     eos_static_debug("unix mapping");
 
-    if (gVirtualUidMap.count("unix:\"<pwd>\":uid")) {
-      if (gVirtualUidMap["unix:\"<pwd>\":uid"] == 0) {
+    if (rules.mUid.count("unix:\"<pwd>\":uid")) {
+      if (rules.Uid("unix:\"<pwd>\":uid") == 0) {
         eos_static_debug("unix uid mapping");
         // use physical mapping for unix names
         Mapping::getPhysicalIds(client->name, vid);
@@ -394,7 +513,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("unix uid forced mapping");
         // map to the requested id
         vid.uid_list.clear();
-        vid.uid = gVirtualUidMap["unix:\"<pwd>\":uid"];
+        vid.uid = rules.Uid("unix:\"<pwd>\":uid");
         vid.uid_list.push_back(vid.uid);
 
         if (vid.uid != 99) {
@@ -407,8 +526,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
 
-    if (gVirtualGidMap.count("unix:\"<pwd>\":gid")) {
-      if (gVirtualGidMap["unix:\"<pwd>\":gid"] == 0) {
+    if (rules.mGid.count("unix:\"<pwd>\":gid")) {
+      if (rules.Gid("unix:\"<pwd>\":gid") == 0) {
         eos_static_debug("unix gid mapping");
         // use physical mapping for unix names
         uid_t uid = vid.uid;
@@ -421,7 +540,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
         eos_static_debug("unix forced gid mapping");
         // map to the requested id
         vid.gid_list.clear();
-        vid.gid = gVirtualGidMap["unix:\"<pwd>\":gid"];
+        vid.gid = rules.Gid("unix:\"<pwd>\":gid");
         vid.gid_list.push_back(vid.gid);
       }
     }
@@ -467,9 +586,9 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   eos_static_debug("swcuidtident=%s sprotuidtident=%s myrole=%s",
                    swcuidtident.c_str(), sprotuidtident.c_str(), myrole.c_str());
 
-  if ((gVirtualUidMap.count(suidtident.c_str()))) {
+  if ((rules.mUid.count(suidtident.c_str()))) {
     //    eos_static_debug("tident mapping");
-    vid.uid = gVirtualUidMap[suidtident.c_str()];
+    vid.uid = rules.Uid(suidtident.c_str());
 
     if (!HasUid(vid.uid, vid.uid_list)) {
       vid.uid_list.push_back(vid.uid);
@@ -480,9 +599,9 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  if ((gVirtualGidMap.count(sgidtident.c_str()))) {
+  if ((rules.mGid.count(sgidtident.c_str()))) {
     //    eos_static_debug("tident mapping");
-    vid.gid = gVirtualGidMap[sgidtident.c_str()];
+    vid.gid = rules.Gid(sgidtident.c_str());
 
     if (!HasGid(vid.gid, vid.gid_list)) {
       vid.gid_list.push_back(vid.gid);
@@ -501,18 +620,18 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   XrdOucString tuid = "";
   XrdOucString tgid = "";
 
-  if (gVirtualUidMap.count(swcuidtident.c_str())) {
+  if (rules.mUid.count(swcuidtident.c_str())) {
     // there is an entry like "*@<host:uid" matching all protocols
     tuid = swcuidtident.c_str();
   } else {
-    if (gVirtualUidMap.count(sprotuidtident.c_str())) {
+    if (rules.mUid.count(sprotuidtident.c_str())) {
       // there is a protocol specific entry "<prot>@<host>:uid"
       tuid = sprotuidtident.c_str();
     } else {
-      if (gAllowedTidentMatches.size()) {
+      if (rules.mTidentMatches.size()) {
         std::string sprot = vid.prot.c_str();
 
-        for (auto it = gAllowedTidentMatches.begin(); it != gAllowedTidentMatches.end();
+        for (auto it = rules.mTidentMatches.begin(); it != rules.mTidentMatches.end();
              ++it) {
           if (sprot != it->first.c_str()) {
             continue;
@@ -521,7 +640,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
           if (host.matches(it->second.c_str())) {
             sprotuidtident.replace(host.c_str(), it->second.c_str());
 
-            if (gVirtualUidMap.count(sprotuidtident.c_str())) {
+            if (rules.mUid.count(sprotuidtident.c_str())) {
               tuid = sprotuidtident.c_str();
               break;
             }
@@ -531,18 +650,18 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  if (gVirtualGidMap.count(swcgidtident.c_str())) {
+  if (rules.mGid.count(swcgidtident.c_str())) {
     // there is an entry like "*@<host>:gid" matching all protocols
     tgid = swcgidtident.c_str();
   } else {
-    if (gVirtualGidMap.count(sprotgidtident.c_str())) {
+    if (rules.mGid.count(sprotgidtident.c_str())) {
       // there is a protocol specific entry "<prot>@<host>:uid"
       tgid = sprotgidtident.c_str();
     } else {
-      if (gAllowedTidentMatches.size()) {
+      if (rules.mTidentMatches.size()) {
         std::string sprot = vid.prot.c_str();
 
-        for (auto it = gAllowedTidentMatches.begin(); it != gAllowedTidentMatches.end();
+        for (auto it = rules.mTidentMatches.begin(); it != rules.mTidentMatches.end();
              ++it) {
           if (sprot != it->first.c_str()) {
             continue;
@@ -551,7 +670,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
           if (host.matches(it->second.c_str())) {
             sprotuidtident.replace(host.c_str(), it->second.c_str());
 
-            if (gVirtualUidMap.count(sprotuidtident.c_str())) {
+            if (rules.mUid.count(sprotuidtident.c_str())) {
               tuid = sprotuidtident.c_str();
               break;
             }
@@ -563,8 +682,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
 
   eos_static_debug("tuid=%s tgid=%s", tuid.c_str(), tgid.c_str());
 
-  if (gVirtualUidMap.count(tuid.c_str())) {
-    if (!gVirtualUidMap[tuid.c_str()]) {
+  if (rules.mUid.count(tuid.c_str())) {
+    if (!rules.Uid(tuid.c_str())) {
       if (gRootSquash && (host != "localhost") && (host != "localhost.localdomain") &&
           (host != "localhost6.localdomain6") && (vid.name == "root") &&
           (myrole == "root")) {
@@ -594,7 +713,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       eos_static_debug("tident uid forced mapping");
       // map to the requested id
       vid.uid_list.clear();
-      vid.uid = gVirtualUidMap[tuid.c_str()];
+      vid.uid = rules.Uid(tuid.c_str());
       vid.uid_list.push_back(vid.uid);
 
       if (vid.uid != 99) {
@@ -607,8 +726,8 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     }
   }
 
-  if (gVirtualGidMap.count(tgid.c_str())) {
-    if (!gVirtualGidMap[tgid.c_str()]) {
+  if (rules.mGid.count(tgid.c_str())) {
+    if (!rules.Gid(tgid.c_str())) {
       if (gRootSquash && (host != "localhost") && (host != "localhost.localdomain") &&
           (vid.name == "root") && (myrole == "root")) {
         eos_static_debug("tident root gid squash");
@@ -635,7 +754,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       eos_static_debug("tident gid forced mapping");
       // map to the requested id
       vid.gid_list.clear();
-      vid.gid = gVirtualGidMap[tgid.c_str()];
+      vid.gid = rules.Gid(tgid.c_str());
       vid.gid_list.push_back(vid.gid);
     }
   }
@@ -664,15 +783,15 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // explicit virtual mapping overrules physical mappings - the second one comes from the physical mapping before
   // ---------------------------------------------------------------------------
-  vid.uid = (gVirtualUidMap.count(useralias.c_str())) ?
-            gVirtualUidMap[useralias.c_str() ] : vid.uid;
+  vid.uid = (rules.mUid.count(useralias.c_str())) ?
+            rules.Uid(useralias.c_str()) : vid.uid;
 
   if (!HasUid(vid.uid, vid.uid_list)) {
     vid.uid_list.insert(vid.uid_list.begin(), vid.uid);
   }
 
-  vid.gid = (gVirtualGidMap.count(groupalias.c_str())) ?
-            gVirtualGidMap[groupalias.c_str()] : vid.gid;
+  vid.gid = (rules.mGid.count(groupalias.c_str())) ?
+            rules.Gid(groupalias.c_str()) : vid.gid;
 
   // eos_static_debug("mapped %d %d", vid.uid,vid.gid);
 
@@ -683,21 +802,23 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // add virtual user and group roles - if any
   // ---------------------------------------------------------------------------
-  if (gUserRoleVector.count(vid.uid)) {
+  auto uroles = rules.mUserRoles.find(vid.uid);
+
+  if (uroles != rules.mUserRoles.end()) {
     uid_vector::const_iterator it;
 
-    for (it = gUserRoleVector[vid.uid].begin();
-         it != gUserRoleVector[vid.uid].end(); ++it)
+    for (it = uroles->second.begin(); it != uroles->second.end(); ++it)
       if (!HasUid((*it), vid.uid_list)) {
         vid.uid_list.push_back((*it));
       }
   }
 
-  if (gGroupRoleVector.count(vid.uid)) {
+  auto groles = rules.mGroupRoles.find(vid.uid);
+
+  if (groles != rules.mGroupRoles.end()) {
     gid_vector::const_iterator it;
 
-    for (it = gGroupRoleVector[vid.uid].begin();
-         it != gGroupRoleVector[vid.uid].end(); ++it)
+    for (it = groles->second.begin(); it != groles->second.end(); ++it)
       if (!HasGid((*it), vid.gid_list)) {
         vid.gid_list.push_back((*it));
       }
@@ -717,7 +838,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       int errc = 0;
       // try alias conversion
       std::string luid = ruid.c_str();
-      sel_uid = (gVirtualUidMap.count(ruid.c_str())) ? gVirtualUidMap[ruid.c_str() ] :
+      sel_uid = (rules.mUid.count(ruid.c_str())) ? rules.Uid(ruid.c_str()) :
                 99;
 
       if (sel_uid == 99) {
@@ -735,7 +856,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       int errc = 0;
       // try alias conversion
       std::string lgid = rgid.c_str();
-      sel_gid = (gVirtualGidMap.count(rgid.c_str())) ? gVirtualGidMap[rgid.c_str()] :
+      sel_gid = (rules.mGid.count(rgid.c_str())) ? rules.Gid(rgid.c_str()) :
                 99;
 
       if (sel_gid == 99) {
@@ -751,7 +872,7 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
   // ---------------------------------------------------------------------------
   // Sudoer flag setting
   // ---------------------------------------------------------------------------
-  if (gSudoerMap.count(vid.uid)) {
+  if (rules.mSudoers.count(vid.uid)) {
     vid.sudoer = true;
   }
 
@@ -812,18 +933,18 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     vid.app = rapp.c_str();
   }
 
-  time_t now = time(NULL);
-
   // ---------------------------------------------------------------------------
   // Check the Geo Location
   // ---------------------------------------------------------------------------
-  if ((!vid.geolocation.length()) && (gGeoMap.size())) {
+  if ((!vid.geolocation.length()) && (rules.mGeo.size())) {
     // if the geo location was not set externally and we have some recipe we try
     // to translate the host name and match a rule
 
     // if we have a default geo location we assume that a client in that one
-    if (gGeoMap.count("default")) {
-      vid.geolocation = gGeoMap["default"];
+    auto def = rules.mGeo.find("default");
+
+    if (def != rules.mGeo.end()) {
+      vid.geolocation = def->second;
     }
 
     std::string ipstring = gIpCache.GetIp(host.c_str());
@@ -831,12 +952,12 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
     if (ipstring.length()) {
       std::string sipstring = ipstring;
       GeoLocationMap_t::const_iterator it;
-      GeoLocationMap_t::const_iterator longuestmatch = gGeoMap.end();
+      GeoLocationMap_t::const_iterator longuestmatch = rules.mGeo.end();
 
       // we use the geo location with the longest name match
-      for (it = gGeoMap.begin(); it != gGeoMap.end(); ++it) {
+      for (it = rules.mGeo.begin(); it != rules.mGeo.end(); ++it) {
         // if we have a previously matched geoloc and if it's longer that the current one, try the next one
-        if (longuestmatch != gGeoMap.end() &&
+        if (longuestmatch != rules.mGeo.end() &&
             it->first.length() <= longuestmatch->first.length()) {
           continue;
         }
@@ -848,35 +969,127 @@ Mapping::IdMap(const XrdSecEntity* client, const char* env, const char* tident,
       }
     }
   }
+}
+
+//------------------------------------------------------------------------------
+// Get the current compiled rules, recompiling them if the rules changed
+//------------------------------------------------------------------------------
+std::shared_ptr<const Mapping::CompiledRules>
+Mapping::GetRules()
+{
+  std::shared_ptr<const CompiledRules> rules = std::atomic_load(&gRules);
+
+  if (rules && (rules->mVersion == gRulesVersion)) {
+    return rules;
+  }
 
-  // ---------------------------------------------------------------------------
-  // Maintain the active client map and expire old entries
-  // ---------------------------------------------------------------------------
-  ActiveLock.Lock();
+  // Writers bump the version with the write lock held, therefore the version
+  // read under the read lock matches the content of the maps
+  std::shared_ptr<CompiledRules> fresh = std::make_shared<CompiledRules>();
+  {
+    RWMutexReadLock lock(gMapMutex);
+    fresh->mVersion = gRulesVersion;
+    fresh->mUid.insert(gVirtualUidMap.begin(), gVirtualUidMap.end());
+    fresh->mGid.insert(gVirtualGidMap.begin(), gVirtualGidMap.end());
+    fresh->mUserRoles.insert(gUserRoleVector.begin(), gUserRoleVector.end());
+    fresh->mGroupRoles.insert(gGroupRoleVector.begin(), gGroupRoleVector.end());
+    fresh->mSudoers.insert(gSudoerMap.begin(), gSudoerMap.end());
+    fresh->mGeo = gGeoMap;
+    fresh->mTidentMatches = gAllowedTidentMatches;
+  }
+  eos_static_debug("compiled mapping rules version=%llu",
+                   (unsigned long long) fresh->mVersion);
+  rules = fresh;
+  std::atomic_store(&gRules, rules);
+  return rules;
+}
 
-  // ---------------------------------------------------------------------------
-  // safty measures not to exceed memory by 'nasty' clients
-  // ---------------------------------------------------------------------------
-  if (ActiveTidents.size() > 25000) {
-    ActiveExpire();
+//------------------------------------------------------------------------------
+// Get a cached identity
+//------------------------------------------------------------------------------
+bool
+Mapping::IdMapCache::Get(const std::string& key, uint64_t version,
+                         VirtualIdentity& vid)
+{
+  if (!mShardSize) {
+    return false;
   }
 
-  if (ActiveTidents.size() < 60000) {
-    char actident[1024];
-    snprintf(actident, sizeof(actident) - 1, "%d^%s^%s^%s^%s", vid.uid,
-             mytident.c_str(), vid.prot.c_str(), vid.host.c_str(), vid.app.c_str());
-    std::string intident = actident;
-    ActiveTidents[intident] = now;
+  Shard& shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+  auto it = shard.mEntries.find(key);
+
+  if ((it == shard.mEntries.end()) || (it->second.mVersion != version) ||
+      (it->second.mExpires < time(NULL))) {
+    return false;
   }
 
-  ActiveLock.UnLock();
-  eos_static_debug("selected %d %d [%s %s]", vid.uid, vid.gid, ruid.c_str(),
-                   rgid.c_str());
+  vid = it->second.mVid;
+  return true;
+}
 
-  if (log) {
-    eos_static_info("%s sec.tident=\"%s\"", eos::common::SecEntity::ToString(client,
-                    Env.Get("eos.app")).c_str(), tident);
+//------------------------------------------------------------------------------
+// Store an identity
+//------------------------------------------------------------------------------
+void
+Mapping::IdMapCache::Put(const std::string& key, uint64_t version,
+                         const VirtualIdentity& vid)
+{
+  if (!mShardSize) {
+    return;
+  }
+
+  time_t now = time(NULL);
+  Shard& shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mMutex);
+
+  if (shard.mEntries.size() >= mShardSize) {
+    // drop stale entries first and everything if that's not enough
+    for (auto it = shard.mEntries.begin(); it != shard.mEntries.end();) {
+      if ((it->second.mVersion != version) || (it->second.mExpires < now)) {
+        it = shard.mEntries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (shard.mEntries.size() >= mShardSize) {
+      shard.mEntries.clear();
+    }
   }
+
+  Entry& entry = shard.mEntries[key];
+  entry.mVersion = version;
+  entry.mExpires = now + mLifeTime;
+  entry.mVid = vid;
+}
+
+//------------------------------------------------------------------------------
+// Drop all entries
+//------------------------------------------------------------------------------
+void
+Mapping::IdMapCache::Clear()
+{
+  for (size_t i = 0; i < kShards; ++i) {
+    std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+    mShards[i].mEntries.clear();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Number of cached entries
+//------------------------------------------------------------------------------
+size_t
+Mapping::IdMapCache::Size()
+{
+  size_t size = 0;
+
+  for (size_t i = 0; i < kShards; ++i) {
+    std::lock_guard<std::mutex> lock(mShards[i].mMutex);
+    size += mShards[i].mEntries.size();
+  }
+
+  return size;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -39,15 +39,20 @@
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucHash.hh"
 /*----------------------------------------------------------------------------*/
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <google/dense_hash_map>
 
 /*----------------------------------------------------------------------------*/
 
 class XrdSecEntity;
+class XrdOucEnv;
 
 EOSCOMMONNAMESPACE_BEGIN
 
@@ -212,6 +217,133 @@ public:
   static void IdMap(const XrdSecEntity* client, const char* env,
                     const char* tident, Mapping::VirtualIdentity& vid, bool log = true);
 
+  //----------------------------------------------------------------------------
+  //! Immutable snapshot of the mapping rules used by IdMap. It is compiled
+  //! from the global maps whenever the rule version changes, so that IdMap
+  //! looks up rules in hash tables without holding gMapMutex.
+  //----------------------------------------------------------------------------
+  struct CompiledRules {
+    uint64_t mVersion; ///< Rule version the snapshot was compiled from
+    std::unordered_map<std::string, uid_t> mUid; ///< gVirtualUidMap
+    std::unordered_map<std::string, gid_t> mGid; ///< gVirtualGidMap
+    std::unordered_map<uid_t, uid_vector> mUserRoles; ///< gUserRoleVector
+    std::unordered_map<uid_t, gid_vector> mGroupRoles; ///< gGroupRoleVector
+    std::unordered_map<uid_t, bool> mSudoers; ///< gSudoerMap
+    GeoLocationMap_t mGeo; ///< gGeoMap, ordered for the prefix match
+    AllowedTidentMatches_t mTidentMatches; ///< gAllowedTidentMatches
+
+    //--------------------------------------------------------------------------
+    //! Get the uid of a rule or 0 if there is none
+    //--------------------------------------------------------------------------
+    uid_t Uid(const std::string& key) const
+    {
+      auto it = mUid.find(key);
+      return ((it != mUid.end()) ? it->second : 0);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Get the gid of a rule or 0 if there is none
+    //--------------------------------------------------------------------------
+    gid_t Gid(const std::string& key) const
+    {
+      auto it = mGid.find(key);
+      return ((it != mGid.end()) ? it->second : 0);
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  //! Bounded cache of IdMap results keyed by the authentication information.
+  //! Entries are only valid for the rule version they were computed with and
+  //! for a limited lifetime, since physical ids can change in the passwd db.
+  //----------------------------------------------------------------------------
+  class IdMapCache
+  {
+  public:
+    static constexpr size_t kShards = 16;
+
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param size maximum number of entries, 0 disables the cache
+    //! @param lifetime lifetime of an entry in seconds
+    //--------------------------------------------------------------------------
+    IdMapCache(size_t size, int lifetime):
+      mShardSize(size / kShards), mLifeTime(lifetime) {}
+
+    //--------------------------------------------------------------------------
+    //! Get a cached identity
+    //!
+    //! @return true if found for the given rule version and not expired
+    //--------------------------------------------------------------------------
+    bool Get(const std::string& key, uint64_t version, VirtualIdentity& vid);
+
+    //--------------------------------------------------------------------------
+    //! Store an identity
+    //--------------------------------------------------------------------------
+    void Put(const std::string& key, uint64_t version,
+             const VirtualIdentity& vid);
+
+    //--------------------------------------------------------------------------
+    //! Drop all entries
+    //--------------------------------------------------------------------------
+    void Clear();
+
+    //--------------------------------------------------------------------------
+    //! Number of cached entries
+    //--------------------------------------------------------------------------
+    size_t Size();
+
+  private:
+    struct Entry {
+      uint64_t mVersion;
+      time_t mExpires;
+      VirtualIdentity mVid;
+    };
+
+    struct Shard {
+      std::mutex mMutex;
+      std::unordered_map<std::string, Entry> mEntries;
+    };
+
+    Shard& GetShard(const std::string& key)
+    {
+      return mShards[std::hash<std::string>()(key) % kShards];
+    }
+
+    size_t mShardSize; ///< Maximum number of entries per shard
+    int mLifeTime; ///< Lifetime of an entry in seconds
+    Shard mShards[kShards];
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the current compiled rules, recompiling them if the rules changed
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<const CompiledRules> GetRules();
+
+  //----------------------------------------------------------------------------
+  //! Signal a change of the mapping rules - has to be called with gMapMutex
+  //! write-locked by every writer of the global maps
+  //----------------------------------------------------------------------------
+  static void RulesChanged()
+  {
+    gRulesVersion++;
+  }
+
+  // ---------------------------------------------------------------------------
+  //! Version of the mapping rules
+  // ---------------------------------------------------------------------------
+  static std::atomic<uint64_t> gRulesVersion;
+
+  // ---------------------------------------------------------------------------
+  //! Current compiled rules - accessed with std::atomic_load/store
+  // ---------------------------------------------------------------------------
+  static std::shared_ptr<const CompiledRules> gRules;
+
+  // ---------------------------------------------------------------------------
+  //! Cache of IdMap results, sized by EOS_IDMAP_CACHE_SIZE (default 65536)
+  // ---------------------------------------------------------------------------
+  static IdMapCache gIdMapCache;
+
   // ---------------------------------------------------------------------------
   //! Map describing which virtual user roles a user with a given uid has
   // ---------------------------------------------------------------------------
@@ -367,6 +499,14 @@ public:
   static const char* ReduceTident(XrdOucString& tident,
     XrdOucString& wildcardtident, XrdOucString& mytident, XrdOucString& myhost);
 
+  // ---------------------------------------------------------------------------
+  //! Compute the virtual identity of a client from the compiled rules, used
+  //! by IdMap if there is no cached result
+  // ---------------------------------------------------------------------------
+  static void IdMapCompute(const XrdSecEntity* client, const char* tident,
+                           XrdOucEnv& Env, const CompiledRules& rules,
+                           Mapping::VirtualIdentity& vid);
+
   // ---------------------------------------------------------------------------
   //! Convert a uid to a user name
   // ---------------------------------------------------------------------------
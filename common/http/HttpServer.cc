@@ -57,6 +57,7 @@ HttpServer::HttpServer(int port)
   mPort = port;
   mThreadId = 0;
   mRunning = false;
+  mThreadModel = "threads";
 }
 
 /*----------------------------------------------------------------------------*/
@@ -89,11 +90,14 @@ void*
 HttpServer::Run()
 {
 #ifdef EOS_MICRO_HTTPD
-  std::string thread_model = "threads";
+  std::string thread_model = mThreadModel;
   {
     // Delay to make sure xrootd is configured before serving
     XrdSysTimer::Snooze(1);
     int nthreads = 16;
+    // With epoll the number of connections is not bound to the number of
+    // threads, so allow many more than the select default of FD_SETSIZE
+    unsigned int nconnections = 16384;
 
     if (getenv("EOS_HTTP_THREADPOOL")) {
       thread_model = getenv("EOS_HTTP_THREADPOOL");
@@ -111,6 +115,14 @@ HttpServer::Run()
       }
     }
 
+    if (getenv("EOS_HTTP_CONNECTION_LIMIT")) {
+      nconnections = atoi(getenv("EOS_HTTP_CONNECTION_LIMIT"));
+
+      if (nconnections < 1) {
+        nconnections = 16384;
+      }
+    }
+
     if (thread_model == "threads") {
       eos_static_notice("msg=\"starting http server\" mode=\"thread-per-connection\"");
       mDaemon = MHD_start_daemon(MHD_USE_DEBUG |  MHD_USE_THREAD_PER_CONNECTION | MHD_USE_DUAL_STACK |
@@ -130,8 +142,8 @@ HttpServer::Run()
                                  MHD_OPTION_END
                                 );
     } else if (thread_model == "epoll") {
-      eos_static_notice("msg=\"starting http server\" mode=\"epoll\" threads=%d",
-                        nthreads);
+      eos_static_notice("msg=\"starting http server\" mode=\"epoll\" threads=%d "
+                        "max-connections=%u", nthreads, nconnections);
       mDaemon = MHD_start_daemon(MHD_USE_DEBUG |  MHD_USE_SELECT_INTERNALLY | MHD_USE_DUAL_STACK |
                                  MHD_USE_EPOLL_LINUX_ONLY,
                                  mPort,
@@ -141,6 +153,8 @@ HttpServer::Run()
                                  (void*) 0,
                                  MHD_OPTION_THREAD_POOL_SIZE,
                                  nthreads,
+                                 MHD_OPTION_CONNECTION_LIMIT,
+                                 nconnections,
                                  MHD_OPTION_NOTIFY_COMPLETED, &HttpServer::StaticCompleteHandler, NULL,
                                  MHD_OPTION_CONNECTION_MEMORY_LIMIT,
                                  getenv("EOS_HTTP_CONNECTION_MEMORY_LIMIT") ? atoi(
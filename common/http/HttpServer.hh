@@ -55,6 +55,8 @@ protected:
   int                mPort;     //!< The port this server listens on
   pthread_t          mThreadId; //!< This thread's ID
   bool               mRunning;  //!< Is this server running?
+  std::string        mThreadModel; //!< Default thread model if not set
+                                   //!< by EOS_HTTP_THREADPOOL
   static HttpServer *gHttp;     //!< This is the instance of the HTTP server
                                 //!< allowing the Handler function to call
                                 //!< class member functions
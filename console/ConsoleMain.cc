@@ -480,10 +480,10 @@ output_result(XrdOucEnv* result, bool highlighting)
 }
 
 //------------------------------------------------------------------------------
-// Execute user command
+// Build the proc path of a client command
 //------------------------------------------------------------------------------
-XrdOucEnv*
-client_command(XrdOucString& in, bool is_admin, std::string* reply)
+static XrdOucString
+client_command_path(XrdOucString& in, bool is_admin)
 {
   if (user_role.length()) {
     in += "&eos.ruid=";
@@ -507,9 +507,6 @@ client_command(XrdOucString& in, bool is_admin, std::string* reply)
     global_comment = "";
   }
 
-  XrdMqTiming mytiming("eos");
-  TIMING("start", &mytiming);
-  XrdOucString out = "";
   XrdOucString path = serveruri;
 
   if (is_admin) {
@@ -520,21 +517,63 @@ client_command(XrdOucString& in, bool is_admin, std::string* reply)
 
   path += "?";
   path += in;
+  return path;
+}
+
+//------------------------------------------------------------------------------
+// Execute user command
+//------------------------------------------------------------------------------
+XrdOucEnv*
+client_command(XrdOucString& in, bool is_admin, std::string* reply)
+{
+  std::string out;
+
+  if (!client_command_stream(in, is_admin, [&](const char* data, size_t len) {
+  out.append(data, len);
+  })) {
+    return nullptr;
+  }
+
+  if (debug) {
+    printf("out=%s\n", out.c_str());
+  }
+
+  CommandEnv = new XrdOucEnv(out.c_str());
+
+  // Save the reply string from the server
+  if (reply) {
+    reply->assign(out);
+  }
+
+  return CommandEnv;
+}
+
+//------------------------------------------------------------------------------
+// Execute user command streaming the response
+//------------------------------------------------------------------------------
+bool
+client_command_stream(XrdOucString& in, bool is_admin,
+                      const std::function<void(const char*, size_t)>& handler)
+{
+  XrdOucString path = client_command_path(in, is_admin);
+  XrdMqTiming mytiming("eos");
+  TIMING("start", &mytiming);
   XrdCl::OpenFlags::Flags flags_xrdcl = XrdCl::OpenFlags::Read;
   std::unique_ptr<XrdCl::File> client {new XrdCl::File()};
   XrdCl::XRootDStatus status = client->Open(path.c_str(), flags_xrdcl);
 
   if (status.IsOK()) {
+    // Large reads, the server hands out whatever output is available
+    const uint32_t buffer_size = 64 * 1024;
+    std::unique_ptr<char[]> buffer {new char[buffer_size]};
     off_t offset = 0;
     uint32_t nbytes = 0;
-    char buffer[4096 + 1];
-    status = client->Read(offset, 4096, buffer, nbytes);
+    status = client->Read(offset, buffer_size, buffer.get(), nbytes);
 
     while (status.IsOK() && (nbytes > 0)) {
-      buffer[nbytes] = 0;
-      out += buffer;
+      handler(buffer.get(), nbytes);
       offset += nbytes;
-      status = client->Read(offset, 4096, buffer, nbytes);
+      status = client->Read(offset, buffer_size, buffer.get(), nbytes);
     }
 
     status = client->Close();
@@ -544,25 +583,14 @@ client_command(XrdOucString& in, bool is_admin, std::string* reply)
       mytiming.Print();
     }
 
-    if (debug) {
-      printf("out=%s\n", out.c_str());
-    }
-
-    CommandEnv = new XrdOucEnv(out.c_str());
-
-    // Save the reply string from the server
-    if (reply) {
-      reply->assign(out.c_str());
-    }
-
-    return CommandEnv;
+    return true;
   } else {
     std::string errmsg;
     errmsg = status.GetErrorMessage();
     fprintf(stderr, "error: errc=%d msg=\"%s\"\n", status.errNo, errmsg.c_str());
   }
 
-  return nullptr;
+  return false;
 }
 
 //------------------------------------------------------------------------------
@@ -25,6 +25,7 @@
 #include "XrdOuc/XrdOucString.hh"
 
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <math.h>
@@ -69,6 +70,20 @@ extern XrdOucEnv* CommandEnv;
 extern XrdOucEnv* client_command(XrdOucString& in, bool is_admin = false,
                                  std::string* reply = nullptr);
 
+//------------------------------------------------------------------------------
+//! Send client command to the MGM and hand the server response to the handler
+//! chunk by chunk as it arrives, without keeping it in memory
+//!
+//! @param in command to be appended as opaque info to the XrdCl::File object
+//! @param is_admin if true execute as an admin command, otherwise as an user
+//!        command
+//! @param handler called for every chunk of the response
+//!
+//! @return true if successful, otherwise false
+//------------------------------------------------------------------------------
+extern bool client_command_stream(XrdOucString& in, bool is_admin,
+                                  const std::function<void(const char*, size_t)>& handler);
+
 typedef int CFunction(char*);
 //! Structure which contains information on the commands this program
 //! understands.
@@ -23,6 +23,7 @@
 
 #include "XrdOuc/XrdOucEnv.hh"
 #include "MgmExecute.hh"
+#include <functional>
 #include <memory>
 
 #ifndef BUILD_TESTS
@@ -42,13 +43,21 @@ int MgmExecute::proccess(const std::string& response)
     elem.second = response.find(elem.first);
   }
 
+  if ((tags[0].second != 0) || (tags[1].second == std::string::npos) ||
+      (tags[2].second == std::string::npos) ||
+      (tags[2].second < tags[1].second)) {
+    mError = "error: failed to parse response from server";
+    rstderr = mError.c_str();
+    return EINVAL;
+  }
+
   // Parse stdout
   mResult = response.substr(tags[0].first.length(),
-                            tags[1].second - tags[1].first.length());
+                            tags[1].second - tags[0].first.length());
   rstdout = mResult.c_str();
   // Parse stderr
-  mError = response.substr(tags[1].second + tags[1].first.length(),
-                           tags[2].second - tags[1].first.length());
+  size_t stderr_pos = tags[1].second + tags[1].first.length();
+  mError = response.substr(stderr_pos, tags[2].second - stderr_pos);
   rstderr = mError.c_str();
 
   // Parse return code
@@ -82,4 +91,73 @@ int MgmExecute::ExecuteCommand(const char* command, bool is_admin)
   }
 }
 
+//------------------------------------------------------------------------------
+// Execute user command streaming the stdout
+//------------------------------------------------------------------------------
+int MgmExecute::ExecuteCommand(const char* command, bool is_admin,
+                               const std::function<void(const std::string&)>& output)
+{
+  static const std::string stdout_tag = "mgm.proc.stdout=";
+  static const std::string stderr_tag = "&mgm.proc.stderr=";
+  XrdOucString command_xrd = XrdOucString(command);
+  // Response data not handed out yet, once the stderr tag was seen this is
+  // the rest of the response
+  std::string pending;
+  bool in_stdout = false;
+  bool done_stdout = false;
+  size_t received = 0;
+  bool ok = client_command_stream(command_xrd, is_admin,
+  [&](const char* data, size_t len) {
+    received += len;
+    pending.append(data, len);
+
+    if (done_stdout) {
+      return;
+    }
+
+    if (!in_stdout) {
+      if (pending.length() < stdout_tag.length()) {
+        return;
+      }
+
+      if (pending.compare(0, stdout_tag.length(), stdout_tag)) {
+        // Not a proc response, parsed as a whole at the end
+        done_stdout = true;
+        return;
+      }
+
+      pending.erase(0, stdout_tag.length());
+      in_stdout = true;
+    }
+
+    size_t pos = pending.find(stderr_tag);
+
+    if (pos != std::string::npos) {
+      done_stdout = true;
+    } else {
+      // The stderr tag contains no new line, complete lines can be handed out
+      pos = pending.rfind('\n');
+      pos = ((pos == std::string::npos) ? 0 : pos + 1);
+    }
+
+    if (pos) {
+      output(pending.substr(0, pos));
+      pending.erase(0, pos);
+    }
+  });
+
+  if (!ok || !received) {
+    return EIO;
+  }
+
+  int retc = proccess(in_stdout ? stdout_tag + pending : pending);
+
+  if (mResult.length()) {
+    output(mResult);
+    mResult.clear();
+  }
+
+  return retc;
+}
+
 #endif
@@ -57,6 +57,20 @@ public:
   //----------------------------------------------------------------------------
   int ExecuteCommand(const char* command, bool is_admin);
 
+  //----------------------------------------------------------------------------
+  //! Execute user command handing the stdout to the output function as it
+  //! arrives, split at line boundaries where possible. The result string
+  //! stays empty.
+  //!
+  //! @param command command to be executed
+  //! @param is_admin if true execute command as admin, otherwise as user
+  //! @param output function called with every piece of the stdout
+  //!
+  //! @return return code
+  //----------------------------------------------------------------------------
+  int ExecuteCommand(const char* command, bool is_admin,
+                     const std::function<void(const std::string&)>& output);
+
   //----------------------------------------------------------------------------
   //! Get result string
   //----------------------------------------------------------------------------
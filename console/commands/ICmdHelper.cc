@@ -46,29 +46,35 @@ ICmdHelper::Execute()
 
   std::string cmd = "mgm.cmd.proto=";
   cmd += b64buff;
-  int retc = mMgmExec.ExecuteCommand(cmd.c_str(), mIsAdmin);
+  int retc = 0;
 
-  if (retc) {
-    if (mMgmExec.GetError().length()) {
-      std::cerr << mMgmExec.GetError() << std::endl;
-    }
+  if (mIsSilent) {
+    retc = mMgmExec.ExecuteCommand(cmd.c_str(), mIsAdmin);
   } else {
-    if (!mIsSilent && mMgmExec.GetResult().size()) {
+    // Print the output as it arrives instead of holding all of it in memory
+    char last = '\n';
+    retc = mMgmExec.ExecuteCommand(cmd.c_str(), mIsAdmin,
+    [&](const std::string & data) {
+      std::string out = data;
+
       if (mHighlight) {
-        TextHighlight(mMgmExec.GetResult());
+        TextHighlight(out);
       }
 
-      // Add new line if necessary
-      std::string out = mMgmExec.GetResult();
-
-      if (*out.rbegin() != '\n') {
-        out += '\n';
-      }
+      last = *data.rbegin();
+      std::cout << out << std::flush;
+    });
 
-      std::cout << out;
+    // Add new line if necessary
+    if (last != '\n') {
+      std::cout << std::endl;
     }
   }
 
+  if (retc && mMgmExec.GetError().length()) {
+    std::cerr << mMgmExec.GetError() << std::endl;
+  }
+
   return retc;
 }
 
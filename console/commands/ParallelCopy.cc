@@ -0,0 +1,851 @@
+//------------------------------------------------------------------------------
+//! @file ParallelCopy.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "console/commands/ParallelCopy.hh"
+#include "common/StringConversion.hh"
+#include "XrdPosix/XrdPosixXrootd.hh"
+#include "XProtocol/XProtocol.hh"
+#include "XrdCl/XrdClFile.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+#include "XrdCl/XrdClURL.hh"
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Convert an XrdCl status to errno
+//------------------------------------------------------------------------------
+int
+StatusToErrno(const XrdCl::XRootDStatus& status)
+{
+  if (status.IsOK()) {
+    return 0;
+  }
+
+  if (status.code == XrdCl::errErrorResponse) {
+    return XProtocol::toErrno(status.errNo);
+  }
+
+  return EIO;
+}
+
+//------------------------------------------------------------------------------
+// Strip the file:// prefix and the opaque info from a local path
+//------------------------------------------------------------------------------
+std::string
+LocalPath(const std::string& path)
+{
+  std::string lpath = path;
+
+  if (lpath.compare(0, 7, "file://") == 0) {
+    lpath.erase(0, 7);
+  }
+
+  size_t qpos = lpath.find('?');
+
+  if (qpos != std::string::npos) {
+    lpath.erase(qpos);
+  }
+
+  return lpath;
+}
+
+//------------------------------------------------------------------------------
+// Create the parent directories of a local path
+//------------------------------------------------------------------------------
+int
+MakeLocalParent(const std::string& path)
+{
+  size_t pos = 0;
+
+  while ((pos = path.find('/', pos + 1)) != std::string::npos) {
+    std::string dir = path.substr(0, pos);
+
+    if (mkdir(dir.c_str(), 0755) && (errno != EEXIST)) {
+      return errno;
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Errors which are not worth a retry
+//------------------------------------------------------------------------------
+bool
+IsPermanent(int retc)
+{
+  return ((retc == ENOENT) || (retc == EEXIST) || (retc == EISDIR) ||
+          (retc == EACCES) || (retc == EPERM) || (retc == EINVAL) ||
+          (retc == ENOSPC) || (retc == EDQUOT));
+}
+
+//------------------------------------------------------------------------------
+// Seconds since the given monotonic time
+//------------------------------------------------------------------------------
+double
+Elapsed(const struct timespec& start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+//! One side of a transfer, either a local file or an XrdCl file
+//------------------------------------------------------------------------------
+class CopyEndpoint
+{
+public:
+  CopyEndpoint(const std::string& path):
+    mLocal(ParallelCopy::IsLocal(path)), mPath(path), mFd(-1)
+  {}
+
+  ~CopyEndpoint()
+  {
+    Close();
+  }
+
+  int OpenRead()
+  {
+    if (mLocal) {
+      mFd = open(LocalPath(mPath).c_str(), O_RDONLY);
+      return ((mFd < 0) ? errno : 0);
+    }
+
+    return StatusToErrno(mFile.Open(mPath, XrdCl::OpenFlags::Read));
+  }
+
+  int OpenWrite(bool no_overwrite)
+  {
+    if (mLocal) {
+      std::string lpath = LocalPath(mPath);
+      int retc = MakeLocalParent(lpath);
+
+      if (retc) {
+        return retc;
+      }
+
+      mFd = open(lpath.c_str(), O_WRONLY | O_CREAT |
+                 (no_overwrite ? O_EXCL : O_TRUNC), 0644);
+      return ((mFd < 0) ? errno : 0);
+    }
+
+    XrdCl::OpenFlags::Flags flags = XrdCl::OpenFlags::MakePath |
+                                    (no_overwrite ? XrdCl::OpenFlags::New :
+                                     XrdCl::OpenFlags::Delete);
+    XrdCl::Access::Mode mode = XrdCl::Access::UR | XrdCl::Access::UW |
+                               XrdCl::Access::GR | XrdCl::Access::OR;
+    return StatusToErrno(mFile.Open(mPath, flags, mode));
+  }
+
+  int Read(uint64_t offset, char* buffer, uint32_t length, uint32_t& nread)
+  {
+    if (mLocal) {
+      ssize_t rc = pread(mFd, buffer, length, offset);
+
+      if (rc < 0) {
+        return errno;
+      }
+
+      nread = (uint32_t) rc;
+      return 0;
+    }
+
+    return StatusToErrno(mFile.Read(offset, length, buffer, nread));
+  }
+
+  int Write(uint64_t offset, const char* buffer, uint32_t length)
+  {
+    if (mLocal) {
+      while (length) {
+        ssize_t rc = pwrite(mFd, buffer, length, offset);
+
+        if (rc < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+
+          return errno;
+        }
+
+        buffer += rc;
+        offset += rc;
+        length -= rc;
+      }
+
+      return 0;
+    }
+
+    return StatusToErrno(mFile.Write(offset, length, buffer));
+  }
+
+  int Close()
+  {
+    int retc = 0;
+
+    if (mLocal) {
+      if (mFd >= 0) {
+        retc = (close(mFd) ? errno : 0);
+        mFd = -1;
+      }
+    } else if (mFile.IsOpen()) {
+      retc = StatusToErrno(mFile.Close());
+    }
+
+    return retc;
+  }
+
+private:
+  bool mLocal;
+  std::string mPath;
+  int mFd;
+  XrdCl::File mFile;
+};
+}
+
+//------------------------------------------------------------------------------
+// Buffer pool constructor
+//------------------------------------------------------------------------------
+ParallelCopy::BufferPool::BufferPool(size_t nbuffers, size_t size)
+{
+  for (size_t i = 0; i < nbuffers; ++i) {
+    mBuffers.emplace_back(new char[size]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get a buffer from the pool, waiting for one to be returned if needed
+//------------------------------------------------------------------------------
+std::unique_ptr<char[]>
+ParallelCopy::BufferPool::Get()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCond.wait(lock, [this] { return !mBuffers.empty(); });
+  std::unique_ptr<char[]> buffer = std::move(mBuffers.back());
+  mBuffers.pop_back();
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+// Return a buffer to the pool
+//------------------------------------------------------------------------------
+void
+ParallelCopy::BufferPool::Put(std::unique_ptr<char[]>&& buffer)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBuffers.push_back(std::move(buffer));
+  }
+  mCond.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ParallelCopy::ParallelCopy(const Options& opts):
+  mOpts(opts), mPool(opts.mParallel ? opts.mParallel : 1, opts.mBufferSize),
+  mNextStat(0), mStatRunning(0), mTotalBytes(0), mCopiedFiles(0),
+  mCopiedBytes(0), mTransferredBytes(0), mFailedFiles(0), mDone(false)
+{
+  if (!mOpts.mParallel) {
+    mOpts.mParallel = 1;
+  }
+
+  mStart.tv_sec = mStart.tv_nsec = 0;
+}
+
+//------------------------------------------------------------------------------
+// Add a copy job
+//------------------------------------------------------------------------------
+void
+ParallelCopy::AddJob(const std::string& source, const std::string& target,
+                     const std::string& name)
+{
+  CopyJob job;
+  job.mSource = source;
+  job.mTarget = target;
+  job.mName = name;
+  mJobs.push_back(job);
+}
+
+//------------------------------------------------------------------------------
+// Check if a path is handled as a local file
+//------------------------------------------------------------------------------
+bool
+ParallelCopy::IsLocal(const std::string& path)
+{
+  return ((path.compare(0, 7, "file://") == 0) ||
+          (path.find("://") == std::string::npos));
+}
+
+//------------------------------------------------------------------------------
+// Build the target path of a source file
+//------------------------------------------------------------------------------
+std::string
+ParallelCopy::TargetName(const std::string& source,
+                         const std::string& source_base,
+                         const std::string& target, bool recursive)
+{
+  if (target.empty() || (target.back() != '/')) {
+    return target;
+  }
+
+  std::string name = source;
+  // The opaque info belongs to the source
+  size_t qpos = name.find('?');
+
+  if (qpos != std::string::npos) {
+    name.erase(qpos);
+  }
+
+  if (recursive) {
+    // Path relative to the parent of the copied tree, only the first match
+    // is removed, the source may be prefixed e.g. by a protocol
+    std::string parent = source_base;
+
+    if ((qpos = parent.find('?')) != std::string::npos) {
+      parent.erase(qpos);
+    }
+
+    while (!parent.empty() && (parent.back() == '/')) {
+      parent.pop_back();
+    }
+
+    size_t spos = parent.rfind('/');
+    parent = ((spos == std::string::npos) ? "" : parent.substr(0, spos + 1));
+    size_t ppos = name.find(parent);
+
+    if (parent.length() && (ppos != std::string::npos)) {
+      name.erase(0, ppos + parent.length());
+    }
+
+    while (!name.empty() && (name[0] == '/')) {
+      name.erase(0, 1);
+    }
+
+    return target + name;
+  }
+
+  while (!name.empty() && (name.back() == '/')) {
+    name.pop_back();
+  }
+
+  size_t spos = name.rfind('/');
+
+  if (spos != std::string::npos) {
+    name.erase(0, spos + 1);
+  }
+
+  return target + name;
+}
+
+//------------------------------------------------------------------------------
+// Stat stage - resolve size and times of the source
+//------------------------------------------------------------------------------
+int
+ParallelCopy::StatSource(CopyJob& job)
+{
+  if (IsLocal(job.mSource)) {
+    struct stat buf;
+
+    if (stat(LocalPath(job.mSource).c_str(), &buf)) {
+      return errno;
+    }
+
+    if (S_ISDIR(buf.st_mode)) {
+      return EISDIR;
+    }
+
+    job.mSize = buf.st_size;
+    job.mAtime.tv_sec = buf.st_atime;
+    job.mMtime.tv_sec = buf.st_mtime;
+    return 0;
+  }
+
+  XrdCl::URL url(job.mSource);
+
+  if (!url.IsValid()) {
+    return EINVAL;
+  }
+
+  XrdCl::FileSystem fs(url);
+  XrdCl::StatInfo* info = 0;
+  XrdCl::XRootDStatus status = fs.Stat(url.GetPathWithParams(), info);
+  std::unique_ptr<XrdCl::StatInfo> sinfo(info);
+
+  if (!status.IsOK()) {
+    return StatusToErrno(status);
+  }
+
+  if (sinfo->TestFlags(XrdCl::StatInfo::IsDir)) {
+    return EISDIR;
+  }
+
+  job.mSize = sinfo->GetSize();
+  job.mAtime.tv_sec = time(NULL);
+  job.mMtime.tv_sec = sinfo->GetModTime();
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Copy stage - transfer one file
+//------------------------------------------------------------------------------
+int
+ParallelCopy::CopyFile(CopyJob& job, char* buffer)
+{
+  std::string target = job.mTarget;
+
+  if (mOpts.mSizeHint && !IsLocal(target)) {
+    target += ((target.find('?') == std::string::npos) ? "?" : "&");
+    target += "eos.targetsize=" + std::to_string(job.mSize) +
+              "&eos.bookingsize=" + std::to_string(job.mSize);
+  }
+
+  CopyEndpoint src(job.mSource);
+  CopyEndpoint dst(target);
+  int retc = src.OpenRead();
+
+  if (retc) {
+    job.mError = "failed to open source";
+    return retc;
+  }
+
+  // A retry overwrites the partial target written by the previous attempt
+  if ((retc = dst.OpenWrite(mOpts.mNoOverwrite && !job.mTargetCreated))) {
+    job.mError = "failed to open target";
+    return retc;
+  }
+
+  job.mTargetCreated = true;
+
+  uint64_t offset = 0;
+
+  while (true) {
+    uint32_t nread = 0;
+
+    if ((retc = src.Read(offset, buffer, mOpts.mBufferSize, nread))) {
+      job.mError = "failed to read source";
+      return retc;
+    }
+
+    if (!nread) {
+      break;
+    }
+
+    if ((retc = dst.Write(offset, buffer, nread))) {
+      job.mError = "failed to write target";
+      return retc;
+    }
+
+    offset += nread;
+    mTransferredBytes += nread;
+  }
+
+  if ((retc = dst.Close())) {
+    job.mError = "failed to close target";
+    return retc;
+  }
+
+  if (offset != job.mSize) {
+    job.mError = "filesize differ between source and target file";
+    return EIO;
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Remove the target left by the failed attempts of a job
+//------------------------------------------------------------------------------
+void
+ParallelCopy::RemoveTarget(const CopyJob& job)
+{
+  if (!job.mTargetCreated) {
+    return;
+  }
+
+  if (IsLocal(job.mTarget)) {
+    unlink(LocalPath(job.mTarget).c_str());
+    return;
+  }
+
+  XrdCl::URL url(job.mTarget);
+
+  if (url.IsValid()) {
+    XrdCl::FileSystem fs(url);
+    (void) fs.Rm(url.GetPathWithParams());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply the source times to the target
+//------------------------------------------------------------------------------
+void
+ParallelCopy::PreserveTimes(const CopyJob& job)
+{
+  bool ok = false;
+
+  if (IsLocal(job.mTarget)) {
+    struct timeval times[2];
+    times[0].tv_sec = job.mAtime.tv_sec;
+    times[0].tv_usec = job.mAtime.tv_nsec / 1000;
+    times[1].tv_sec = job.mMtime.tv_sec;
+    times[1].tv_usec = job.mMtime.tv_nsec / 1000;
+    ok = !utimes(LocalPath(job.mTarget).c_str(), times);
+  } else {
+    std::string request = job.mTarget;
+    request += ((request.find('?') == std::string::npos) ? "?" : "&");
+    request += "mgm.pcmd=utimes&tv1_sec=" + std::to_string(job.mAtime.tv_sec) +
+               "&tv1_nsec=" + std::to_string(job.mAtime.tv_nsec) +
+               "&tv2_sec=" + std::to_string(job.mMtime.tv_sec) +
+               "&tv2_nsec=" + std::to_string(job.mMtime.tv_nsec);
+    char value[4096];
+    value[0] = 0;
+
+    if (XrdPosixXrootd::QueryOpaque(request.c_str(), value, sizeof(value)) >= 0) {
+      char tag[1024];
+      int retc = 0;
+      ok = ((sscanf(value, "%1023s retc=%d", tag, &retc) == 2) &&
+            !strcmp(tag, "utimes:"));
+    }
+  }
+
+  if (!ok) {
+    fprintf(stderr, "warning: creation/modification time could not be preserved "
+            "for %s\n", job.mName.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Loop of the stat threads
+//------------------------------------------------------------------------------
+void
+ParallelCopy::StatLoop()
+{
+  // Don't run further ahead than a few jobs per copy thread
+  const size_t max_ready = 4 * mOpts.mParallel;
+  size_t idx;
+
+  while ((idx = mNextStat++) < mJobs.size()) {
+    {
+      std::unique_lock<std::mutex> lock(mReadyMutex);
+      mSpaceCond.wait(lock, [&] { return mReady.size() < max_ready; });
+    }
+    CopyJob& job = mJobs[idx];
+    int retc = 0;
+
+    for (size_t attempt = 0; attempt <= mOpts.mRetries; ++attempt) {
+      if (!(retc = StatSource(job)) || IsPermanent(retc)) {
+        break;
+      }
+
+      std::this_thread::sleep_for(std::chrono::seconds(attempt + 1));
+    }
+
+    if (retc) {
+      job.mRetc = retc;
+      job.mError = "cannot get the file size of source file";
+      mFailedFiles++;
+      fprintf(stderr, "error: %s : %s (%s)\n", job.mError.c_str(),
+              job.mName.c_str(), strerror(retc));
+      continue;
+    }
+
+    mTotalBytes += job.mSize;
+
+    if (mOpts.mDebug) {
+      fprintf(stderr, "[eos-cp] path=%s size=%llu\n", job.mName.c_str(),
+              (unsigned long long) job.mSize);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mReadyMutex);
+      mReady.push_back(idx);
+    }
+    mReadyCond.notify_one();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mReadyMutex);
+    mStatRunning--;
+  }
+  mReadyCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Loop of the copy threads
+//------------------------------------------------------------------------------
+void
+ParallelCopy::CopyLoop()
+{
+  while (true) {
+    size_t idx;
+    {
+      std::unique_lock<std::mutex> lock(mReadyMutex);
+      mReadyCond.wait(lock, [this] { return !mReady.empty() || !mStatRunning; });
+
+      if (mReady.empty()) {
+        break;
+      }
+
+      idx = mReady.front();
+      mReady.pop_front();
+    }
+    mSpaceCond.notify_one();
+    CopyJob& job = mJobs[idx];
+    std::unique_ptr<char[]> buffer = mPool.Get();
+    int retc = 0;
+
+    for (size_t attempt = 0; attempt <= mOpts.mRetries; ++attempt) {
+      if (attempt) {
+        if (mOpts.mDebug) {
+          fprintf(stderr, "[eos-cp] retry %zu for %s : %s (%s)\n", attempt,
+                  job.mName.c_str(), job.mError.c_str(), strerror(retc));
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(attempt));
+      }
+
+      if (!(retc = CopyFile(job, buffer.get())) || IsPermanent(retc)) {
+        break;
+      }
+    }
+
+    mPool.Put(std::move(buffer));
+    job.mRetc = retc;
+
+    if (retc) {
+      mFailedFiles++;
+      // An existing target refused in no-overwrite mode is left untouched
+      RemoveTarget(job);
+
+      if (retc == EEXIST) {
+        fprintf(stderr, "warning: target file %s exists and you specified no "
+                "overwrite!\n", job.mName.c_str());
+      } else {
+        fprintf(stderr, "error: %s : %s (%s)\n", job.mError.c_str(),
+                job.mName.c_str(), strerror(retc));
+      }
+
+      continue;
+    }
+
+    job.mError.clear();
+
+    if (mOpts.mPreserve) {
+      PreserveTimes(job);
+    }
+
+    if (mOpts.mOnDone) {
+      mOpts.mOnDone(job);
+    }
+
+    mCopiedFiles++;
+    mCopiedBytes += job.mSize;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Print the progress line
+//------------------------------------------------------------------------------
+void
+ParallelCopy::PrintProgress(bool final)
+{
+  double passed = Elapsed(mStart);
+  XrdOucString done_str, total_str, rate_str;
+  uint64_t moved = mTransferredBytes;
+  fprintf(stderr, "\r[eos-cp] [ %llu/%zu files | %llu failed | %s / %s | %s ]%s",
+          (unsigned long long) mCopiedFiles.load(), mJobs.size(),
+          (unsigned long long) mFailedFiles.load(),
+          eos::common::StringConversion::GetReadableSizeString(done_str,
+              moved, "B"),
+          eos::common::StringConversion::GetReadableSizeString(total_str,
+              mTotalBytes.load(), "B"),
+          eos::common::StringConversion::GetReadableSizeString(rate_str,
+              (unsigned long long)(passed > 0 ? moved / passed : 0), "B/s"),
+          final ? "\n" : "");
+  fflush(stderr);
+}
+
+//------------------------------------------------------------------------------
+// Loop of the progress thread
+//------------------------------------------------------------------------------
+void
+ParallelCopy::ProgressLoop()
+{
+  std::unique_lock<std::mutex> lock(mDoneMutex);
+
+  while (!mDone) {
+    mDoneCond.wait_for(lock, std::chrono::seconds(1));
+
+    if (!mDone) {
+      PrintProgress(false);
+    }
+  }
+
+  PrintProgress(true);
+}
+
+//------------------------------------------------------------------------------
+// Run all jobs and wait for their completion
+//------------------------------------------------------------------------------
+int
+ParallelCopy::Run()
+{
+  clock_gettime(CLOCK_MONOTONIC, &mStart);
+  std::vector<std::thread> stat_threads;
+  std::vector<std::thread> copy_threads;
+  std::thread progress;
+  size_t nstat = std::min(mOpts.mParallel, mJobs.size());
+  mStatRunning = nstat;
+  mDone = false;
+
+  if (mOpts.mProgress) {
+    progress = std::thread(&ParallelCopy::ProgressLoop, this);
+  }
+
+  for (size_t i = 0; i < nstat; ++i) {
+    stat_threads.emplace_back(&ParallelCopy::StatLoop, this);
+  }
+
+  for (size_t i = 0; i < mOpts.mParallel; ++i) {
+    copy_threads.emplace_back(&ParallelCopy::CopyLoop, this);
+  }
+
+  for (auto& th : stat_threads) {
+    th.join();
+  }
+
+  for (auto& th : copy_threads) {
+    th.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mDoneMutex);
+    mDone = true;
+  }
+  mDoneCond.notify_all();
+
+  if (progress.joinable()) {
+    progress.join();
+  }
+
+  int retc = 0;
+
+  for (const auto& job : mJobs) {
+    if (job.mRetc) {
+      retc = job.mRetc;
+    }
+  }
+
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Copy files between two temporary local directories through the engine
+//------------------------------------------------------------------------------
+int
+ParallelCopy::Benchmark(const Options& opts, size_t nfiles, uint64_t size)
+{
+  const char* tmpdir = getenv("TMPDIR");
+  std::string base = (tmpdir ? tmpdir : "/tmp");
+  std::string src_tmpl = base + "/eos-cp-bench-src.XXXXXX";
+  std::string dst_tmpl = base + "/eos-cp-bench-dst.XXXXXX";
+  std::vector<char> src_dir(src_tmpl.begin(), src_tmpl.end());
+  std::vector<char> dst_dir(dst_tmpl.begin(), dst_tmpl.end());
+  src_dir.push_back(0);
+  dst_dir.push_back(0);
+
+  if (!mkdtemp(src_dir.data()) || !mkdtemp(dst_dir.data())) {
+    fprintf(stderr, "error: failed to create the benchmark directories\n");
+    return errno;
+  }
+
+  std::string src = src_dir.data();
+  std::string dst = dst_dir.data();
+  std::vector<char> data(std::min<uint64_t>(size ? size : 1, 1024 * 1024), 'e');
+  ParallelCopy engine(opts);
+  int retc = 0;
+
+  for (size_t i = 0; i < nfiles; ++i) {
+    std::string name = "/file." + std::to_string(i);
+    int fd = open((src + name).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+      retc = errno;
+      break;
+    }
+
+    for (uint64_t written = 0; written < size;) {
+      size_t len = std::min<uint64_t>(data.size(), size - written);
+      ssize_t nwrite = write(fd, data.data(), len);
+
+      if (nwrite <= 0) {
+        retc = EIO;
+        break;
+      }
+
+      written += nwrite;
+    }
+
+    close(fd);
+    engine.AddJob(src + name, dst + name, name);
+  }
+
+  XrdOucString size_str, rate_str;
+
+  if (!retc) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    retc = engine.Run();
+    double passed = Elapsed(start);
+    fprintf(stdout, "[eos-cp] benchmark files=%zu size=%s parallel=%zu "
+            "time=%.02fs rate=%.02f files/s bandwidth=%s\n", nfiles,
+            eos::common::StringConversion::GetReadableSizeString(size_str, size,
+                "B"), opts.mParallel, passed,
+            passed > 0 ? engine.GetCopiedFiles() / passed : 0.0,
+            eos::common::StringConversion::GetReadableSizeString(rate_str,
+                (unsigned long long)(passed > 0 ? engine.GetCopiedBytes() / passed : 0),
+                "B/s"));
+  }
+
+  for (size_t i = 0; i < nfiles; ++i) {
+    std::string name = "/file." + std::to_string(i);
+    unlink((src + name).c_str());
+    unlink((dst + name).c_str());
+  }
+
+  rmdir(src.c_str());
+  rmdir(dst.c_str());
+  return retc;
+}
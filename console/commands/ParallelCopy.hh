@@ -0,0 +1,256 @@
+//------------------------------------------------------------------------------
+//! @file ParallelCopy.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __PARALLELCOPY__HH__
+#define __PARALLELCOPY__HH__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+//------------------------------------------------------------------------------
+//! Description of one file copy handled by the ParallelCopy engine
+//------------------------------------------------------------------------------
+struct CopyJob {
+  std::string mSource; ///< Source XRootD URL or local path
+  std::string mTarget; ///< Target XRootD URL or local path
+  std::string mName; ///< Name used in messages
+  uint64_t mSize = 0; ///< Source size filled by the stat stage
+  struct timespec mAtime = {0, 0}; ///< Source access time
+  struct timespec mMtime = {0, 0}; ///< Source modification time
+  int mRetc = 0; ///< 0 if the copy succeeded, otherwise errno
+  std::string mError; ///< Error message of the last attempt
+  std::string mChecksum; ///< Filled by the completion callback if any
+  bool mTargetCreated = false; ///< Target was created by an attempt
+};
+
+//------------------------------------------------------------------------------
+//! Class ParallelCopy
+//!
+//! @description In-process copy engine used by 'eos cp' for many files. A set
+//!   of stat threads runs ahead of the copy threads and feeds a bounded queue
+//!   of ready jobs, the copy threads run concurrent XrdCl (or local) transfers
+//!   using buffers from a shared pool. Each file is retried individually and
+//!   the aggregate progress is reported on stderr.
+//------------------------------------------------------------------------------
+class ParallelCopy
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Engine options
+  //----------------------------------------------------------------------------
+  struct Options {
+    size_t mParallel = 8; ///< Number of concurrent transfers
+    size_t mBufferSize = 4 * 1024 * 1024; ///< Size of the pooled buffers
+    size_t mRetries = 2; ///< Number of retries per file
+    bool mNoOverwrite = false; ///< Fail if the target exists
+    bool mPreserve = false; ///< Preserve access/modification time
+    bool mProgress = true; ///< Print aggregate progress
+    bool mSizeHint = true; ///< Add eos.targetsize/bookingsize to EOS targets
+    bool mDebug = false; ///< Print debug messages
+    ///! Called in the copy thread after a successful copy
+    std::function<void(CopyJob&)> mOnDone;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param opts engine options
+  //----------------------------------------------------------------------------
+  ParallelCopy(const Options& opts);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ParallelCopy() = default;
+
+  //----------------------------------------------------------------------------
+  //! Add a copy job
+  //!
+  //! @param source source URL or local path
+  //! @param target target URL or local path
+  //! @param name name used in messages
+  //----------------------------------------------------------------------------
+  void AddJob(const std::string& source, const std::string& target,
+              const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Run all jobs and wait for their completion
+  //!
+  //! @return 0 if all files were copied, otherwise the errno of the last
+  //!         failed file
+  //----------------------------------------------------------------------------
+  int Run();
+
+  //----------------------------------------------------------------------------
+  //! Get the jobs with their result
+  //----------------------------------------------------------------------------
+  const std::vector<CopyJob>& GetJobs() const
+  {
+    return mJobs;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of successfully copied files
+  //----------------------------------------------------------------------------
+  uint64_t GetCopiedFiles() const
+  {
+    return mCopiedFiles;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of successfully copied bytes
+  //----------------------------------------------------------------------------
+  uint64_t GetCopiedBytes() const
+  {
+    return mCopiedBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if a path is handled as a local file
+  //----------------------------------------------------------------------------
+  static bool IsLocal(const std::string& path);
+
+  //----------------------------------------------------------------------------
+  //! Build the target path of a source file. If the target is a directory,
+  //! i.e. ends with '/', the source name is appended, or in recursive mode
+  //! the path of the source relative to the parent of the copied tree.
+  //!
+  //! @param source source path
+  //! @param source_base top directory of the copied tree in recursive mode
+  //! @param target target path
+  //! @param recursive true if copying a tree
+  //!
+  //! @return target path of the source file
+  //----------------------------------------------------------------------------
+  static std::string TargetName(const std::string& source,
+                                const std::string& source_base,
+                                const std::string& target, bool recursive);
+
+  //----------------------------------------------------------------------------
+  //! Copy nfiles files of the given size between two temporary local
+  //! directories through the engine and print the rates
+  //!
+  //! @param opts engine options
+  //! @param nfiles number of files
+  //! @param size size of each file
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
+  static int Benchmark(const Options& opts, size_t nfiles, uint64_t size);
+
+#ifdef BUILD_TESTS
+  // Allow the test class to access the copy stages
+public:
+#else
+private:
+#endif
+  //----------------------------------------------------------------------------
+  //! Pool of transfer buffers shared by the copy threads
+  //----------------------------------------------------------------------------
+  class BufferPool
+  {
+  public:
+    BufferPool(size_t nbuffers, size_t size);
+    std::unique_ptr<char[]> Get();
+    void Put(std::unique_ptr<char[]>&& buffer);
+
+  private:
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::vector<std::unique_ptr<char[]>> mBuffers;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Stat stage - resolve size and times of the source
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
+  int StatSource(CopyJob& job);
+
+  //----------------------------------------------------------------------------
+  //! Copy stage - transfer one file, retried by the caller. A target created
+  //! by a previous attempt is overwritten even in no-overwrite mode.
+  //!
+  //! @return 0 if successful, otherwise errno
+  //----------------------------------------------------------------------------
+  int CopyFile(CopyJob& job, char* buffer);
+
+  //----------------------------------------------------------------------------
+  //! Remove the target left by the failed attempts of a job, if created
+  //----------------------------------------------------------------------------
+  void RemoveTarget(const CopyJob& job);
+
+  //----------------------------------------------------------------------------
+  //! Apply the source times to the target
+  //----------------------------------------------------------------------------
+  void PreserveTimes(const CopyJob& job);
+
+  //----------------------------------------------------------------------------
+  //! Loop of the stat threads
+  //----------------------------------------------------------------------------
+  void StatLoop();
+
+  //----------------------------------------------------------------------------
+  //! Loop of the copy threads
+  //----------------------------------------------------------------------------
+  void CopyLoop();
+
+  //----------------------------------------------------------------------------
+  //! Loop of the progress thread
+  //----------------------------------------------------------------------------
+  void ProgressLoop();
+
+  //----------------------------------------------------------------------------
+  //! Print the progress line
+  //----------------------------------------------------------------------------
+  void PrintProgress(bool final);
+
+  Options mOpts; ///< Engine options
+  std::vector<CopyJob> mJobs; ///< All jobs
+  BufferPool mPool; ///< Shared buffers
+  std::atomic<size_t> mNextStat; ///< Next job to stat
+  std::atomic<size_t> mStatRunning; ///< Number of running stat threads
+  std::mutex mReadyMutex; ///< Protect the ready queue
+  std::condition_variable mReadyCond; ///< Signal jobs in the ready queue
+  std::condition_variable mSpaceCond; ///< Signal space in the ready queue
+  std::deque<size_t> mReady; ///< Jobs with a successful stat
+  std::atomic<uint64_t> mTotalBytes; ///< Bytes known from the stat stage
+  std::atomic<uint64_t> mCopiedFiles; ///< Successfully copied files
+  std::atomic<uint64_t> mCopiedBytes; ///< Successfully copied bytes
+  std::atomic<uint64_t> mTransferredBytes; ///< Bytes moved including retries
+  std::atomic<uint64_t> mFailedFiles; ///< Files failed after all retries
+  std::atomic<bool> mDone; ///< Mark end of the copy stage
+  std::mutex mDoneMutex; ///< Mutex for the progress condition
+  std::condition_variable mDoneCond; ///< Wake up the progress thread
+  struct timespec mStart; ///< Start time of Run
+};
+
+#endif //__PARALLELCOPY__HH__
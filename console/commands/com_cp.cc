@@ -26,11 +26,13 @@
 #include "console/ConsoleMain.hh"
 #include "common/Path.hh"
 #include "common/StringConversion.hh"
+#include "console/commands/ParallelCopy.hh"
 #include "XrdPosix/XrdPosixXrootd.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdCl/XrdClURL.hh"
 #include "XrdCl/XrdClFileSystem.hh"
 /*----------------------------------------------------------------------------*/
+#include <memory>
 #include <vector>
 /*----------------------------------------------------------------------------*/
 
@@ -42,7 +44,7 @@ int
 com_cp_usage()
 {
   fprintf(stdout,
-          "Usage: cp [--async] [--atomic] [--rate=<rate>] [--streams=<n>] [--recursive|-R|-r] [-a] [-n] [-S] [-s|--silent] [-d] [--checksum] <src> <dst>");
+          "Usage: cp [--async] [--atomic] [--rate=<rate>] [--streams=<n>] [--parallel=<n>] [--recursive|-R|-r] [-a] [-n] [-S] [-s|--silent] [-d] [--checksum] <src> <dst>");
   fprintf(stdout, "'[eos] cp ..' provides copy functionality to EOS.\n");
   fprintf(stdout, "Options:\n");
   fprintf(stdout,
@@ -54,6 +56,12 @@ com_cp_usage()
   fprintf(stdout, "       --rate          : limit the cp rate to <rate>\n");
   fprintf(stdout, "       --streams       : use <#> parallel streams\n");
   fprintf(stdout, "       --checksum      : output the checksums\n");
+  fprintf(stdout,
+          "       --parallel      : copy <#> files concurrently in-process for XRootD, EOS and local files [ default from EOS_CP_PARALLEL or 1 ]\n");
+  fprintf(stdout,
+          "       --retries       : retry each file <#> times when copying in parallel [ default 2 ]\n");
+  fprintf(stdout,
+          "       --benchmark=<n>[:<size>] : copy <n> files of <size> bytes [ default 4096 ] between two local temporary directories with the parallel engine\n");
   fprintf(stdout,
           " -p |--preserve : preserves file creation and modification time from the source\n");
   fprintf(stdout,
@@ -138,6 +146,10 @@ com_cp(char* argin)
   bool nooverwrite = false;
   bool preserve = false;
   XrdOucString atomic = "";
+  size_t parallel = (getenv("EOS_CP_PARALLEL") ?
+                     strtoul(getenv("EOS_CP_PARALLEL"), 0, 10) : 1);
+  size_t retries = 2;
+  XrdOucString benchmark = "";
   unsigned long long copysize = 0;
   int retc = 0;
   int copiedok = 0;
@@ -159,6 +171,24 @@ com_cp(char* argin)
       break;
     }
 
+    if (option.beginswith("--parallel=")) {
+      option.replace("--parallel=", "");
+      parallel = strtoul(option.c_str(), 0, 10);
+      continue;
+    }
+
+    if (option.beginswith("--retries=")) {
+      option.replace("--retries=", "");
+      retries = strtoul(option.c_str(), 0, 10);
+      continue;
+    }
+
+    if (option.beginswith("--benchmark=")) {
+      benchmark = option;
+      benchmark.replace("--benchmark=", "");
+      continue;
+    }
+
     if (option.beginswith("--rate=")) {
       rate = option;
       rate.replace("--rate=", "");
@@ -231,6 +261,30 @@ com_cp(char* argin)
     noprogress = true;
   }
 
+  if (benchmark.length()) {
+    ParallelCopy::Options opts;
+    opts.mParallel = parallel;
+    opts.mRetries = retries;
+    opts.mProgress = !noprogress;
+    opts.mDebug = debug;
+    int cpos = benchmark.find(":");
+    unsigned long long bsize = 4096;
+
+    if (cpos != STR_NPOS) {
+      bsize = strtoull(benchmark.c_str() + cpos + 1, 0, 10);
+      benchmark.erase(cpos);
+    }
+
+    unsigned long long nfiles = strtoull(benchmark.c_str(), 0, 10);
+
+    if (!nfiles) {
+      return com_cp_usage();
+    }
+
+    global_retc = ParallelCopy::Benchmark(opts, nfiles, bsize);
+    return (0);
+  }
+
   nextarg = subtokenizer.GetToken();
   lastarg = subtokenizer.GetToken();
 
@@ -539,6 +593,165 @@ com_cp(char* argin)
     }
   }
 
+  // copy many XRootD/EOS/local files with the in-process parallel engine
+  bool use_engine = (parallel > 1) && (!append) && (rate == "0") &&
+                    (streams == "0") && !(target == "-") &&
+                    (target.beginswith("/") || target.beginswith("root://"));
+
+  for (size_t nfile = 0; use_engine && (nfile < source_list.size()); nfile++) {
+    if (!source_list[nfile].beginswith("/eos/") &&
+        !source_list[nfile].beginswith("root:") &&
+        (source_list[nfile].find(":/") != STR_NPOS)) {
+      use_engine = false;
+    }
+  }
+
+  if (use_engine) {
+    // the 'role' switches used for all XRootD URLs
+    XrdOucString roles = "";
+
+    if (user_role.length() && group_role.length()) {
+      roles += "&eos.ruid=";
+      roles += user_role;
+      roles += "&eos.rgid=";
+      roles += group_role;
+    }
+
+    ParallelCopy::Options opts;
+    opts.mParallel = parallel;
+    opts.mRetries = retries;
+    opts.mNoOverwrite = nooverwrite;
+    opts.mPreserve = preserve;
+    opts.mProgress = !noprogress;
+    opts.mDebug = debug;
+
+    if (checksums && target.beginswith("/eos")) {
+      opts.mOnDone = [](CopyJob & job) {
+        XrdCl::URL url(job.mTarget);
+        XrdCl::FileSystem fs(url);
+        XrdCl::Buffer arg;
+        XrdCl::Buffer* response = 0;
+        arg.FromString(url.GetPath());
+        XrdCl::XRootDStatus status = fs.Query(XrdCl::QueryCode::Checksum, arg,
+                                              response);
+        std::unique_ptr<XrdCl::Buffer> sresponse(response);
+
+        if (status.IsOK() && sresponse) {
+          XrdOucString sanswer = sresponse->GetBuffer();
+          sanswer.replace("eos ", "");
+          job.mChecksum = sanswer.c_str();
+        }
+      };
+    }
+
+    ParallelCopy engine(opts);
+
+    for (size_t nfile = 0; nfile < source_list.size(); nfile++) {
+      XrdOucString prot;
+      XrdOucString hostport;
+      const char* urlpath = (eos::common::StringConversion::ParseUrl(
+                               source_list[nfile].c_str(), prot, hostport));
+      arg1 = source_list[nfile];
+
+      if (arg1.beginswith("./")) {
+        arg1.erase(0, 2);
+      }
+
+      std::string source = source_list[nfile].c_str();
+      std::string source_base = "";
+
+      if (recursive) {
+        source_base = source_base_list[nfile].c_str();
+      } else if (urlpath) {
+        source = urlpath;
+      }
+
+      arg2 = ParallelCopy::TargetName(source, source_base, target.c_str(),
+                                      recursive).c_str();
+
+      if (arg1.beginswith("/eos")) {
+        arg1.insert("/", 0);
+        arg1.insert(serveruri.c_str(), 0);
+      }
+
+      if (arg1.find(":/") != STR_NPOS) {
+        arg1 += ((arg1.find("?") == STR_NPOS) ? "?" : "&");
+        arg1 += "eos.app=eoscp";
+        arg1 += roles;
+      }
+
+      XrdOucString targetname = arg2;
+
+      if (arg2.beginswith("/eos")) {
+        arg2.insert("/", 0);
+        arg2.insert(serveruri.c_str(), 0);
+      }
+
+      if (arg2.find(":/") != STR_NPOS) {
+        arg2 += ((arg2.find("?") == STR_NPOS) ? "?" : "&");
+        arg2 += "eos.app=eoscp";
+        arg2 += atomic;
+        arg2 += roles;
+      } else {
+        while (arg2.replace("#AND#", "&")) {}
+      }
+
+      if (debug) {
+        fprintf(stderr, "[eos-cp] add %s => %s\n", arg1.c_str(), arg2.c_str());
+      }
+
+      engine.AddJob(arg1.c_str(), arg2.c_str(), targetname.c_str());
+    }
+
+    if (!silent) {
+      fprintf(stderr, "[eos-cp] going to copy %d files with %zu parallel "
+              "transfers\n", (int) source_list.size(), parallel);
+    }
+
+    gettimeofday(&tv1, &tz);
+    retc = engine.Run();
+    gettimeofday(&tv2, &tz);
+
+    if (checksums && !target.beginswith("/eos")) {
+      fprintf(stderr, "warning: checksums are only available for EOS targets\n");
+    } else if (checksums) {
+      for (const auto& job : engine.GetJobs()) {
+        if (job.mRetc) {
+          continue;
+        }
+
+        if (job.mChecksum.length()) {
+          fprintf(stdout, "path=%s size=%llu checksum=%s\n", job.mName.c_str(),
+                  (unsigned long long) job.mSize, job.mChecksum.c_str());
+        } else {
+          fprintf(stdout, "error: getting checksum for path=%s size=%llu\n",
+                  job.mName.c_str(), (unsigned long long) job.mSize);
+        }
+      }
+    }
+
+    float passed = (float)(((tv2.tv_sec - tv1.tv_sec) * 1000000 +
+                            (tv2.tv_usec - tv1.tv_usec)) / 1000000.0);
+    float crate = (engine.GetCopiedBytes() * 1.0 / passed);
+    XrdOucString sizestring = "";
+    XrdOucString sizestring2 = "";
+
+    if (!silent) {
+      fprintf(stderr,
+              "%s[eos-cp] copied %d/%d files and %s in %.02f seconds with %s\n",
+              retc ? "#WARNING " : "",
+              (int) engine.GetCopiedFiles(),
+              (int) source_list.size(),
+              eos::common::StringConversion::GetReadableSizeString(sizestring,
+                  engine.GetCopiedBytes(), "B"),
+              passed,
+              eos::common::StringConversion::GetReadableSizeString(sizestring2,
+                  (unsigned long long) crate, "B/s"));
+    }
+
+    exit(retc ? (retc & 0xff) : 0);
+  }
+
   // compute the size to copy
   std::vector<std::string> file_info;
 
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+//! @file ParallelCopyTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "ParallelCopyTest.hh"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelCopyTest);
+
+void ParallelCopyTest::setUp()
+{
+  char tmpl[] = "/tmp/eos-cp-test.XXXXXX";
+  CPPUNIT_ASSERT(mkdtemp(tmpl) != nullptr);
+  mDir = tmpl;
+}
+
+void ParallelCopyTest::tearDown()
+{
+  std::string cmd = "rm -rf " + mDir;
+  (void) system(cmd.c_str());
+}
+
+void ParallelCopyTest::WriteFile(const std::string& path,
+                                 const std::string& data)
+{
+  std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+  out << data;
+}
+
+std::string ParallelCopyTest::ReadFile(const std::string& path)
+{
+  std::ifstream in(path.c_str(), std::ios::binary);
+  std::stringstream data;
+  data << in.rdbuf();
+  return data.str();
+}
+
+void ParallelCopyTest::TestTargetName()
+{
+  // Plain target file
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/file"),
+                       ParallelCopy::TargetName("/data/a", "", "/eos/dst/file",
+                           false));
+  // Target directory gets the source name, including hidden names
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/a"),
+                       ParallelCopy::TargetName("/data/a", "", "/eos/dst/",
+                           false));
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/.foo"),
+                       ParallelCopy::TargetName("/data/.foo", "", "/eos/dst/",
+                           false));
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/.foo"),
+                       ParallelCopy::TargetName(".foo", "", "/eos/dst/", false));
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/a.txt"),
+                       ParallelCopy::TargetName("/data/a.txt?eos.ruid=0", "",
+                           "/eos/dst/", false));
+  // Recursive copy keeps the tree below the parent of the source directory
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/data/sub/a"),
+                       ParallelCopy::TargetName("/data/sub/a", "/data/",
+                           "/eos/dst/", true));
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/.foo/.bar.txt"),
+                       ParallelCopy::TargetName("/data/.foo/.bar.txt",
+                           "/data/.foo/", "/eos/dst/", true));
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/.foo/x.txt"),
+                       ParallelCopy::TargetName("./.foo/x.txt", "./.foo/",
+                           "/eos/dst/", true));
+  // Only the leading parent is removed
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/data/data/a"),
+                       ParallelCopy::TargetName("/x/data/data/a", "/x/data/",
+                           "/eos/dst/", true));
+  CPPUNIT_ASSERT_EQUAL(std::string("/eos/dst/src/a"),
+                       ParallelCopy::TargetName("src/a", "src/", "/eos/dst/",
+                           true));
+}
+
+void ParallelCopyTest::TestRetryNoOverwrite()
+{
+  std::string src = mDir + "/src";
+  std::string dst = mDir + "/dst";
+  WriteFile(src, "0123456789");
+  ParallelCopy::Options opts;
+  opts.mParallel = 1;
+  opts.mBufferSize = 4;
+  opts.mNoOverwrite = true;
+  opts.mProgress = false;
+  ParallelCopy engine(opts);
+  engine.AddJob(src, dst, "dst");
+  CopyJob& job = engine.mJobs[0];
+  CPPUNIT_ASSERT_EQUAL(0, engine.StatSource(job));
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 10, job.mSize);
+  std::vector<char> buffer(opts.mBufferSize);
+  // First attempt fails after creating the target
+  job.mSize = 11;
+  CPPUNIT_ASSERT_EQUAL(EIO, engine.CopyFile(job, buffer.data()));
+  CPPUNIT_ASSERT(job.mTargetCreated);
+  CPPUNIT_ASSERT_EQUAL(0, access(dst.c_str(), F_OK));
+  // The retry overwrites its own partial target despite no-overwrite
+  job.mSize = 10;
+  CPPUNIT_ASSERT_EQUAL(0, engine.CopyFile(job, buffer.data()));
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789"), ReadFile(dst));
+  // A failed job removes the target it created
+  job.mSize = 11;
+  CPPUNIT_ASSERT_EQUAL(EIO, engine.CopyFile(job, buffer.data()));
+  engine.RemoveTarget(job);
+  CPPUNIT_ASSERT(access(dst.c_str(), F_OK) != 0);
+}
+
+void ParallelCopyTest::TestNoOverwriteExisting()
+{
+  std::string src = mDir + "/src";
+  std::string dst = mDir + "/dst";
+  std::string new_dst = mDir + "/sub/new";
+  WriteFile(src, "new data");
+  WriteFile(dst, "old data");
+  ParallelCopy::Options opts;
+  opts.mParallel = 2;
+  opts.mRetries = 1;
+  opts.mNoOverwrite = true;
+  opts.mProgress = false;
+  ParallelCopy engine(opts);
+  engine.AddJob(src, dst, "dst");
+  engine.AddJob(src, new_dst, "new");
+  CPPUNIT_ASSERT_EQUAL(EEXIST, engine.Run());
+  // The existing target is neither overwritten nor removed
+  CPPUNIT_ASSERT_EQUAL(EEXIST, engine.GetJobs()[0].mRetc);
+  CPPUNIT_ASSERT_EQUAL(std::string("old data"), ReadFile(dst));
+  CPPUNIT_ASSERT_EQUAL(0, engine.GetJobs()[1].mRetc);
+  CPPUNIT_ASSERT_EQUAL(std::string("new data"), ReadFile(new_dst));
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 1, engine.GetCopiedFiles());
+}
@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+//! @file ParallelCopyTest.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __PARALLELCOPYTEST__HH__
+#define __PARALLELCOPYTEST__HH__
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+#include "console/commands/ParallelCopy.hh"
+
+class ParallelCopyTest : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(ParallelCopyTest);
+  CPPUNIT_TEST(TestTargetName);
+  CPPUNIT_TEST(TestRetryNoOverwrite);
+  CPPUNIT_TEST(TestNoOverwriteExisting);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  // CPPUNIT required methods
+  void setUp();
+  void tearDown();
+
+  // test helper method
+  void WriteFile(const std::string& path, const std::string& data);
+  std::string ReadFile(const std::string& path);
+
+  void TestTargetName();
+  void TestRetryNoOverwrite();
+  void TestNoOverwriteExisting();
+
+private:
+  std::string mDir; ///< Temporary directory of the test files
+};
+
+#endif //__PARALLELCOPYTEST__HH__
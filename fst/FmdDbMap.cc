@@ -35,6 +35,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
 
 #ifdef HAVE_FST_WITH_QUARKD
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
@@ -45,6 +46,7 @@ EOSFSTNAMESPACE_BEGIN
 
 // Global objects
 FmdDbMapHandler gFmdDbMapHandler;
+const size_t FmdDbMapHandler::sResyncBatchSize = 10000;
 
 using eos::common::LayoutId;
 
@@ -84,6 +86,55 @@ FmdDbMapHandler::EnvMgmToFmd(XrdOucEnv& env, struct Fmd& fmd)
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Convert a compact dumpmd record to an Fmd struct
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::CompactMgmToFmd(const char* line, struct Fmd& fmd)
+{
+  unsigned long long val[10];
+  const char* ptr = line;
+  char* end = nullptr;
+
+  for (int i = 0; i < 10; ++i) {
+    val[i] = strtoull(ptr, &end, 10);
+
+    if ((end == ptr) || (*end != ' ')) {
+      return false;
+    }
+
+    ptr = end + 1;
+  }
+
+  const char* xs_end = strchr(ptr, ' ');
+
+  if (!xs_end || (xs_end == ptr)) {
+    return false;
+  }
+
+  fmd.set_fid(val[0]);
+  fmd.set_cid(val[1]);
+  fmd.set_ctime(val[2]);
+  fmd.set_ctime_ns(val[3]);
+  fmd.set_mtime(val[4]);
+  fmd.set_mtime_ns(val[5]);
+  fmd.set_mgmsize(val[6]);
+  fmd.set_lid(val[7]);
+  fmd.set_uid((uid_t) val[8]);
+  fmd.set_gid((gid_t) val[9]);
+  fmd.set_mgmchecksum(ptr, xs_end - ptr);
+  ptr = xs_end + 1;
+  size_t loc_len = strcspn(ptr, " \r\n");
+
+  if ((loc_len == 1) && (*ptr == '-')) {
+    fmd.set_locations("");
+  } else {
+    fmd.set_locations(ptr, loc_len);
+  }
+
+  return true;
+}
+
 #ifdef HAVE_FST_WITH_QUARKDB
 //----------------------------------------------------------------------------
 // Convert namespace file metadata to an Fmd struct
@@ -308,7 +359,10 @@ FmdDbMapHandler::CallAutoRepair(const char* manager,
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-FmdDbMapHandler::FmdDbMapHandler()
+FmdDbMapHandler::FmdDbMapHandler():
+  mCommitMode(CommitMode::kGroup), mCommitWindowMs(2), mCommitMaxBatch(256),
+  mPendingSeq(0), mPendingCount(0), mFlusherRun(false), mResyncActive(0),
+  mResyncTotal(0)
 {
   using eos::common::FileSystem;
   SetLogId("CommonFmdDbMapHandler");
@@ -316,6 +370,247 @@ FmdDbMapHandler::FmdDbMapHandler()
   lvdboption.BloomFilterNbits = 0;
   mFsMtxMap.set_deleted_key(std::numeric_limits<FileSystem::fsid_t>::max() - 2);
   mFsMtxMap.set_empty_key(std::numeric_limits<FileSystem::fsid_t>::max() - 1);
+
+  // Group commit configuration
+  if (getenv("EOS_FST_FMD_COMMIT_MODE")) {
+    std::string mode = getenv("EOS_FST_FMD_COMMIT_MODE");
+
+    if (mode == "sync") {
+      mCommitMode = CommitMode::kSync;
+    } else if (mode == "async") {
+      mCommitMode = CommitMode::kAsync;
+    }
+  }
+
+  if (getenv("EOS_FST_FMD_COMMIT_WINDOW_MS")) {
+    mCommitWindowMs = strtoul(getenv("EOS_FST_FMD_COMMIT_WINDOW_MS"), 0, 10);
+  }
+
+  if (getenv("EOS_FST_FMD_COMMIT_BATCH")) {
+    mCommitMaxBatch = strtoul(getenv("EOS_FST_FMD_COMMIT_BATCH"), 0, 10);
+
+    if (!mCommitMaxBatch) {
+      mCommitMaxBatch = 1;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Configure the group commit
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::SetCommitMode(CommitMode mode, uint32_t window_ms,
+                               size_t max_batch)
+{
+  {
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+    mCommitWindowMs = window_ms;
+    mCommitMaxBatch = (max_batch ? max_batch : 1);
+    mCommitMode = mode;
+  }
+
+  if (mode == CommitMode::kSync) {
+    StopFlusher();
+  } else {
+    StartFlusher();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get a pending commit
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::GetPending(eos::common::FileId::fileid_t fid,
+                            eos::common::FileSystem::fsid_t fsid, Fmd* fmd)
+{
+  std::unique_lock<std::mutex> lock(mPendingMutex);
+  auto it_fs = mPending.find(fsid);
+
+  if (it_fs == mPending.end()) {
+    return false;
+  }
+
+  auto it = it_fs->second.mEntries.find(fid);
+
+  if (it == it_fs->second.mEntries.end()) {
+    return false;
+  }
+
+  if (fmd) {
+    *fmd = it->second;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Drop a pending commit
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::DropPending(eos::common::FileId::fileid_t fid,
+                             eos::common::FileSystem::fsid_t fsid)
+{
+  std::unique_lock<std::mutex> lock(mPendingMutex);
+  auto it_fs = mPending.find(fsid);
+
+  if ((it_fs == mPending.end()) || !it_fs->second.mEntries.erase(fid)) {
+    return false;
+  }
+
+  --mPendingCount;
+
+  if (it_fs->second.mEntries.empty()) {
+    // Nothing left to write, release the waiters of this filesystem
+    mFlushedSeq[fsid] = std::max(mFlushedSeq[fsid], it_fs->second.mLastSeq);
+    mPending.erase(it_fs);
+    mFlushedCv.notify_all();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Write all pending commits of a filesystem to the DB
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::FlushPending(eos::common::FileSystem::fsid_t fsid)
+{
+  {
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+
+    if (!mPending.count(fsid)) {
+      return true;
+    }
+  }
+
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsWriteLock wlock(fsid);
+  return FlushPendingLocked(fsid);
+}
+
+//------------------------------------------------------------------------------
+// Write the pending commits of a filesystem to the DB
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::FlushPendingLocked(eos::common::FileSystem::fsid_t fsid)
+{
+  PendingFmd pending;
+  {
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+    auto it_fs = mPending.find(fsid);
+
+    if (it_fs == mPending.end()) {
+      return true;
+    }
+
+    std::swap(pending, it_fs->second);
+    mPending.erase(it_fs);
+    mPendingCount -= pending.mEntries.size();
+  }
+  bool retc = true;
+
+  if (mDbMap.count(fsid)) {
+    std::string sval;
+    unsigned long cpt = 0;
+    mDbMap[fsid]->beginSetSequence();
+
+    for (const auto& elem : pending.mEntries) {
+      elem.second.SerializePartialToString(&sval);
+      mDbMap[fsid]->set(eos::common::Slice((const char*)&elem.first,
+                                           sizeof(elem.first)), sval, "");
+      ++cpt;
+    }
+
+    // The endSetSequence makes it impossible to know which key is faulty
+    if (mDbMap[fsid]->endSetSequence() != cpt) {
+      eos_err("unable to commit batch of %lu entries for fsid=%lu", cpt,
+              (unsigned long) fsid);
+      retc = false;
+    }
+  } else {
+    eos_crit("no %s DB open for fsid=%llu - dropping %lu pending commits",
+             eos::common::DbMap::getDbType().c_str(), (unsigned long) fsid,
+             pending.mEntries.size());
+    retc = false;
+  }
+
+  std::unique_lock<std::mutex> lock(mPendingMutex);
+  *pending.mFlushOk = retc;
+  mFlushedSeq[fsid] = std::max(mFlushedSeq[fsid], pending.mLastSeq);
+  mFlushedCv.notify_all();
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Flusher thread loop writing the pending commits in batches
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::FlusherLoop()
+{
+  std::vector<eos::common::FileSystem::fsid_t> to_flush;
+  std::unique_lock<std::mutex> lock(mPendingMutex);
+
+  while (mFlusherRun || mPendingCount) {
+    if (!mPendingCount) {
+      mPendingCv.wait(lock);
+      continue;
+    }
+
+    auto deadline = mPendingSince + std::chrono::milliseconds(mCommitWindowMs);
+
+    if (mFlusherRun && (mPendingCount < mCommitMaxBatch) &&
+        (std::chrono::steady_clock::now() < deadline)) {
+      mPendingCv.wait_until(lock, deadline);
+      continue;
+    }
+
+    to_flush.clear();
+
+    for (const auto& elem : mPending) {
+      to_flush.push_back(elem.first);
+    }
+
+    lock.unlock();
+
+    for (const auto& fsid : to_flush) {
+      (void) FlushPending(fsid);
+    }
+
+    lock.lock();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start the flusher thread if not already running
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::StartFlusher()
+{
+  std::unique_lock<std::mutex> lock(mPendingMutex);
+
+  if (mFlusherRun || (mCommitMode == CommitMode::kSync)) {
+    return;
+  }
+
+  mFlusherRun = true;
+  mFlusher = std::thread(&FmdDbMapHandler::FlusherLoop, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop the flusher thread and write all pending commits
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::StopFlusher()
+{
+  {
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+    mFlusherRun = false;
+    mPendingCv.notify_all();
+  }
+
+  if (mFlusher.joinable()) {
+    mFlusher.join();
+  }
 }
 
 
@@ -417,6 +712,7 @@ FmdDbMapHandler::SetDBFile(const char* meta_dir, int fsid)
     return false;
   }
 
+  StartFlusher();
   return true;
 }
 
@@ -428,6 +724,7 @@ FmdDbMapHandler::ShutdownDB(eos::common::FileSystem::fsid_t fsid)
 {
   eos_info("%s DB shutdown for fsid=%lu",
            eos::common::DbMap::getDbType().c_str(), (unsigned long) fsid);
+  (void) FlushPending(fsid);
   eos::common::RWMutexWriteLock lock(mMapMutex);
 
   if (mDbMap.count(fsid)) {
@@ -629,6 +926,7 @@ FmdDbMapHandler::LocalDeleteFmd(eos::common::FileId::fileid_t fid,
   bool rc = true;
   eos::common::RWMutexReadLock lock(mMapMutex);
   FsWriteLock wlock(fsid);
+  bool was_pending = DropPending(fid, fsid);
 
   if (LocalExistFmd(fid, fsid)) {
     if (mDbMap[fsid]->remove(eos::common::Slice((const char*)&fid, sizeof(fid)))) {
@@ -636,7 +934,7 @@ FmdDbMapHandler::LocalDeleteFmd(eos::common::FileId::fileid_t fid,
       rc = false;
     }
   } else {
-    rc = false;
+    rc = was_pending;
   }
 
   return rc;
@@ -662,6 +960,54 @@ FmdDbMapHandler::Commit(FmdHelper* fmd, bool lockit)
   fmd->mProtoFmd.set_mtime_ns(tv.tv_usec * 1000);
   fmd->mProtoFmd.set_atime_ns(tv.tv_usec * 1000);
 
+  // Callers already holding the filesystem lock can't wait for the flusher
+  if ((mCommitMode.load() != CommitMode::kSync) && lockit) {
+    {
+      eos::common::RWMutexReadLock lock(mMapMutex);
+
+      if (!mDbMap.count(fsid)) {
+        eos_crit("no %s DB open for fsid=%llu",
+                 eos::common::DbMap::getDbType().c_str(), (unsigned long) fsid);
+        return false;
+      }
+    }
+    std::unique_lock<std::mutex> lock(mPendingMutex);
+    // The mode may have changed meanwhile, with kSync or after a shutdown the
+    // flusher is stopped and nothing would write the commit - write directly
+    const CommitMode mode = mCommitMode.load();
+
+    if ((mode != CommitMode::kSync) && mFlusherRun) {
+      if (!mPendingCount) {
+        mPendingSince = std::chrono::steady_clock::now();
+      }
+
+      PendingFmd& pending = mPending[fsid];
+      std::shared_ptr<bool> flush_ok = pending.mFlushOk;
+
+      if (pending.mEntries.insert(std::make_pair(fid, fmd->mProtoFmd)).second) {
+        ++mPendingCount;
+      } else {
+        pending.mEntries[fid] = fmd->mProtoFmd;
+      }
+
+      uint64_t seq = pending.mLastSeq = ++mPendingSeq;
+
+      if ((mPendingCount >= mCommitMaxBatch) || (mPendingCount == 1)) {
+        mPendingCv.notify_one();
+      }
+
+      if (mode == CommitMode::kGroup) {
+        // Report the result of the write of the batch holding this commit
+        mFlushedCv.wait(lock, [&] {
+          return (mFlushedSeq[fsid] >= seq);
+        });
+        return *flush_ok;
+      }
+
+      return true;
+    }
+  }
+
   if (lockit) {
     mMapMutex.LockRead();
     FsLockWrite(fsid);
@@ -810,6 +1156,7 @@ FmdDbMapHandler::UpdateFromMgm(eos::common::FileSystem::fsid_t fsid,
 bool
 FmdDbMapHandler::ResetDiskInformation(eos::common::FileSystem::fsid_t fsid)
 {
+  (void) FlushPending(fsid);
   eos::common::RWMutexReadLock lock(mMapMutex);
   FsWriteLock wlock(fsid);
 
@@ -854,6 +1201,7 @@ FmdDbMapHandler::ResetDiskInformation(eos::common::FileSystem::fsid_t fsid)
 bool
 FmdDbMapHandler::ResetMgmInformation(eos::common::FileSystem::fsid_t fsid)
 {
+  (void) FlushPending(fsid);
   eos::common::RWMutexReadLock lock(mMapMutex);
   FsWriteLock vlock(fsid);
 
@@ -1145,6 +1493,85 @@ FmdDbMapHandler::ResyncMgm(eos::common::FileSystem::fsid_t fsid,
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Merge a batch of MGM records into the local database
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::CommitMgmBatch(eos::common::FileSystem::fsid_t fsid,
+                                const std::vector<Fmd>& batch)
+{
+  eos::common::RWMutexReadLock lock(mMapMutex);
+  FsWriteLock wlock(fsid);
+
+  if (!mDbMap.count(fsid)) {
+    eos_crit("no %s DB open for fsid=%llu", eos::common::DbMap::getDbType().c_str(),
+             (unsigned long) fsid);
+    return false;
+  }
+
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  Fmd valfmd;
+  unsigned long cpt = 0;
+  mDbMap[fsid]->beginSetSequence();
+
+  for (const auto& mgmfmd : batch) {
+    if (mgmfmd.fid() == 0) {
+      eos_info("skipping to insert a file with fid 0");
+      continue;
+    }
+
+    if (LocalExistFmd(mgmfmd.fid(), fsid)) {
+      valfmd = LocalRetrieveFmd(mgmfmd.fid(), fsid);
+    } else {
+      // New record - nothing is known about the disk replica
+      FmdHelper::Reset(valfmd);
+      valfmd.set_fid(mgmfmd.fid());
+      valfmd.set_fsid(fsid);
+      valfmd.set_atime(tv.tv_sec);
+      valfmd.set_atime_ns(tv.tv_usec * 1000);
+      valfmd.set_disksize(0xfffffffffff1ULL);
+    }
+
+    int layouterror = FmdHelper::LayoutError(mgmfmd, fsid);
+
+    if (valfmd.disksize() == 0xfffffffffff1ULL) {
+      layouterror |= LayoutId::kMissing;
+      eos_warning("found missing replica for fid=%08llx on fsid=%lu",
+                  mgmfmd.fid(), (unsigned long) fsid);
+    }
+
+    size_t cslen = LayoutId::GetChecksumLen(mgmfmd.lid()) * 2;
+    const std::string& xs = mgmfmd.mgmchecksum();
+    valfmd.set_mgmsize(mgmfmd.mgmsize());
+    valfmd.set_size(mgmfmd.mgmsize());
+    valfmd.set_checksum(xs.c_str(), std::min(xs.length(), cslen));
+    valfmd.set_mgmchecksum(xs.c_str(), std::min(xs.length(), cslen));
+    valfmd.set_cid(mgmfmd.cid());
+    valfmd.set_lid(mgmfmd.lid());
+    valfmd.set_uid(mgmfmd.uid());
+    valfmd.set_gid(mgmfmd.gid());
+    valfmd.set_ctime(mgmfmd.ctime());
+    valfmd.set_ctime_ns(mgmfmd.ctime_ns());
+    valfmd.set_mtime(mgmfmd.mtime());
+    valfmd.set_mtime_ns(mgmfmd.mtime_ns());
+    valfmd.set_layouterror(layouterror);
+    valfmd.set_locations(mgmfmd.locations());
+    // Inside a set sequence the return value is the number of buffered entries
+    (void) LocalPutFmd(mgmfmd.fid(), fsid, valfmd);
+    ++cpt;
+  }
+
+  // The endSetSequence makes it impossible to know which key is faulty
+  if (mDbMap[fsid]->endSetSequence() != cpt) {
+    eos_err("unable to commit resync batch of %lu entries for fsid=%lu", cpt,
+            (unsigned long) fsid);
+    return false;
+  }
+
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Resync all meta data from MGM into local database
 //------------------------------------------------------------------------------
@@ -1159,7 +1586,7 @@ FmdDbMapHandler::ResyncAllMgm(eos::common::FileSystem::fsid_t fsid,
 
   std::string tmpfile;
 
-  if (!ExecuteDumpmd(manager, fsid, tmpfile)) {
+  if (!ExecuteDumpmd(manager, fsid, tmpfile, true)) {
     return false;
   }
 
@@ -1168,52 +1595,79 @@ FmdDbMapHandler::ResyncAllMgm(eos::common::FileSystem::fsid_t fsid,
   std::string dumpentry;
   unlink(tmpfile.c_str());
   unsigned long long cnt = 0;
+  unsigned long long nerrors = 0;
+  bool compact = false;
+  std::vector<Fmd> batch;
+  batch.reserve(sResyncBatchSize);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ++mResyncActive;
+
+  // Older MGMs don't understand the compact format and reply with the env one
+  if (std::getline(inFile, dumpentry)) {
+    compact = (dumpentry.find("#eos.dumpmd.compact") == 0);
+
+    if (!compact) {
+      inFile.clear();
+      inFile.seekg(0);
+    }
+  }
 
   while (std::getline(inFile, dumpentry)) {
+    if (dumpentry.empty()) {
+      continue;
+    }
+
     cnt++;
     eos_debug("line=%s", dumpentry.c_str());
-    std::unique_ptr<XrdOucEnv> env(new XrdOucEnv(dumpentry.c_str()));
-
-    if (env) {
-      struct Fmd fMd;
-      FmdHelper::Reset(fMd);
-
-      if (EnvMgmToFmd(*env, fMd)) {
-        // get/create one
-        FmdHelper* fmd = LocalGetFmd(fMd.fid(), fsid, fMd.uid(), fMd.gid(),
-                                     fMd.lid(), true, true);
-        fMd.set_layouterror(FmdHelper::LayoutError(fMd, fsid));
-
-        if (fmd) {
-          // Check if it exists on disk
-          if (fmd->mProtoFmd.disksize() == 0xfffffffffff1ULL) {
-            fMd.set_layouterror(fMd.layouterror() | LayoutId::kMissing);
-            eos_warning("found missing replica for fid=%08llx on fsid=%lu", fMd.fid(),
-                        (unsigned long) fsid);
-          }
+    batch.emplace_back();
+    Fmd& fMd = batch.back();
+    FmdHelper::Reset(fMd);
+    bool ok;
 
-          if (!UpdateFromMgm(fsid, fMd.fid(), fMd.cid(), fMd.lid(), fMd.mgmsize(),
-                             fMd.mgmchecksum(), fMd.uid(), fMd.gid(), fMd.ctime(),
-                             fMd.ctime_ns(), fMd.mtime(), fMd.mtime_ns(),
-                             fMd.layouterror(), fMd.locations())) {
-            eos_err("failed to update fmd %s", dumpentry.c_str());
-          }
+    if (compact) {
+      ok = CompactMgmToFmd(dumpentry.c_str(), fMd);
+    } else {
+      XrdOucEnv env(dumpentry.c_str());
+      ok = EnvMgmToFmd(env, fMd);
+    }
 
-          delete fmd;
-        } else {
-          eos_err("failed to get/create fmd %s", dumpentry.c_str());
-        }
-      } else {
-        eos_err("failed to convert %s", dumpentry.c_str());
+    if (!ok) {
+      eos_err("failed to convert %s", dumpentry.c_str());
+      batch.pop_back();
+      ++nerrors;
+    }
+
+    if (batch.size() >= sResyncBatchSize) {
+      if (!CommitMgmBatch(fsid, batch)) {
+        nerrors += batch.size();
       }
+
+      mResyncTotal += batch.size();
+      batch.clear();
     }
 
-    if (!(cnt % 10000)) {
+    if (!(cnt % 100000)) {
       eos_info("msg=\"synced files so far\" nfiles=%llu fsid=%lu", cnt,
                (unsigned long) fsid);
     }
   }
 
+  if (!batch.empty()) {
+    if (!CommitMgmBatch(fsid, batch)) {
+      nerrors += batch.size();
+    }
+
+    mResyncTotal += batch.size();
+  }
+
+  --mResyncActive;
+  double duration = std::chrono::duration_cast<std::chrono::milliseconds>
+                    (std::chrono::steady_clock::now() - start).count() / 1000.0;
+  eos_info("msg=\"mgm resync done\" fsid=%lu format=%s nfiles=%llu "
+           "nerrors=%llu duration=%.02fs rate=%.02fHz active_fs=%d "
+           "total_files=%llu", (unsigned long) fsid, compact ? "compact" : "env",
+           cnt, nerrors, duration, (duration > 0) ? (cnt / duration) : (double) cnt,
+           mResyncActive.load(), mResyncTotal.load());
   mIsSyncing[fsid] = false;
   return true;
 }
@@ -1330,6 +1784,7 @@ FmdDbMapHandler::RemoveGhostEntries(const char* path,
   std::vector<eos::common::FileId::fileid_t> to_delete;
 
   if (!IsSyncing(fsid)) {
+    (void) FlushPending(fsid);
     {
       eos::common::RWMutexReadLock rd_lock(mMapMutex);
       FsReadLock fs_rd_lock(fsid);
@@ -1400,6 +1855,7 @@ FmdDbMapHandler::GetInconsistencyStatistics(eos::common::FileSystem::fsid_t
     std::map<std::string, size_t>& statistics,
     std::map<std::string, std::set < eos::common::FileId::fileid_t> >& fidset)
 {
+  (void) FlushPending(fsid);
   eos::common::RWMutexReadLock lock(mMapMutex);
 
   if (!mDbMap.count(fsid)) {
@@ -1521,6 +1977,7 @@ FmdDbMapHandler::ResetDB(eos::common::FileSystem::fsid_t fsid)
   // Erase the hash entry
   if (mDbMap.count(fsid)) {
     FsWriteLock fs_wr_lock(fsid);
+    (void) FlushPendingLocked(fsid);
 
     // Delete in the in-memory hash
     if (!mDbMap[fsid]->clear()) {
@@ -1544,6 +2001,7 @@ FmdDbMapHandler::TrimDB()
 {
   for (auto it = mDbMap.begin(); it != mDbMap.end(); ++it) {
     eos_static_info("Trimming fsid=%llu ", it->first);
+    (void) FlushPending(it->first);
 
     if (!it->second->trimDb()) {
       eos_static_err("Cannot trim the DB file for fsid=%llu ", it->first);
@@ -1563,6 +2021,7 @@ FmdDbMapHandler::TrimDB()
 long long
 FmdDbMapHandler::GetNumFiles(eos::common::FileSystem::fsid_t fsid)
 {
+  (void) FlushPending(fsid);
   eos::common::RWMutexReadLock lock(gFmdDbMapHandler.mMapMutex);
   FsReadLock fs_rd_lock(fsid);
 
@@ -1579,7 +2038,7 @@ FmdDbMapHandler::GetNumFiles(eos::common::FileSystem::fsid_t fsid)
 bool
 FmdDbMapHandler::ExecuteDumpmd(const std::string& mgm_host,
                                eos::common::FileSystem::fsid_t fsid,
-                               std::string& fn_output)
+                               std::string& fn_output, bool compact)
 {
   // Create temporary file used as output for the command
   char tmpfile[] = "/tmp/efstd.XXXXXX";
@@ -1599,6 +2058,7 @@ FmdDbMapHandler::ExecuteDumpmd(const std::string& mgm_host,
   FsProto_DumpMdProto* dumpmd = fs->mutable_dumpmd();
   dumpmd->set_fsid(fsid);
   dumpmd->set_display(eos::console::FsProto::DumpMdProto::MONITOR);
+  dumpmd->set_compact(compact);
   request.set_format(eos::console::RequestProto::FUSE);
   std::string b64buff;
   std::ostringstream cmd;
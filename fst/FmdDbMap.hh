@@ -27,6 +27,12 @@
 #include "common/FileId.hh"
 #include "common/LayoutId.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #ifdef HAVE_FST_WITH_QUARKDB
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
@@ -44,6 +50,18 @@ EOSFSTNAMESPACE_BEGIN
 class FmdDbMapHandler : public eos::common::LogId
 {
 public:
+  //----------------------------------------------------------------------------
+  //! Durability mode of the Commit calls
+  //!
+  //! kSync  - every commit is an individual DB write (legacy behaviour)
+  //! kGroup - commits are accumulated per filesystem and written in one batch,
+  //!          the caller waits until its batch has been written
+  //! kAsync - like kGroup but the caller does not wait for the batch write
+  //----------------------------------------------------------------------------
+  enum class CommitMode {
+    kSync, kGroup, kAsync
+  };
+
   //----------------------------------------------------------------------------
   //! Convert an FST env representation to an Fmd struct
   //!
@@ -54,6 +72,18 @@ public:
   //----------------------------------------------------------------------------
   static bool EnvMgmToFmd(XrdOucEnv& env, struct Fmd& fmd);
 
+  //----------------------------------------------------------------------------
+  //! Convert a compact dumpmd record to an Fmd struct. The record has the
+  //! positional format "fid cid ctime ctime_ns mtime mtime_ns size lid uid gid
+  //! checksum locations" and is parsed in place without temporary objects.
+  //!
+  //! @param line compact record (without the trailing new line)
+  //! @param fmd reference to Fmd struct
+  //!
+  //! @return true if successful otherwise false
+  //----------------------------------------------------------------------------
+  static bool CompactMgmToFmd(const char* line, struct Fmd& fmd);
+
 #ifdef HAVE_FST_WITH_QUARKDB
   //----------------------------------------------------------------------------
   //! Convert namespace file metadata to an Fmd struct
@@ -102,6 +132,24 @@ public:
     Shutdown();
   }
 
+  //----------------------------------------------------------------------------
+  //! Configure the group commit
+  //!
+  //! @param mode durability mode
+  //! @param window_ms max time a commit stays pending before being written
+  //! @param max_batch number of pending commits triggering a batch write
+  //----------------------------------------------------------------------------
+  void SetCommitMode(CommitMode mode, uint32_t window_ms, size_t max_batch);
+
+  //----------------------------------------------------------------------------
+  //! Write all pending commits of a filesystem to the DB
+  //!
+  //! @param fsid filesystem id
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool FlushPending(eos::common::FileSystem::fsid_t fsid);
+
   //----------------------------------------------------------------------------
   //! Set a new DB file for a filesystem id
   //!
@@ -388,6 +436,8 @@ public:
   void
   Shutdown()
   {
+    StopFlusher();
+
     for (auto it = mDbMap.begin(); it != mDbMap.end(); it++) {
       ShutdownDB(it->first);
     }
@@ -413,6 +463,8 @@ public:
   uint32_t GetNumFileSystems() const;
 
 private:
+  //! Number of records committed in one DB write batch during MGM resync
+  static const size_t sResyncBatchSize;
   std::map<eos::common::FileSystem::fsid_t, eos::common::DbMap*> mDbMap;
   mutable eos::common::RWMutex mMapMutex;//< Mutex protecting the Fmd handler
   eos::common::LvDbDbMapInterface::Option lvdboption;
@@ -424,6 +476,32 @@ private:
   google::dense_hash_map<eos::common::FileSystem::fsid_t, eos::common::RWMutex>
   mFsMtxMap;
   eos::common::RWMutex mFsMtxMapMutex; ///< Mutex protecting the previous map
+  //! Commits waiting to be written in a batch for one filesystem
+  struct PendingFmd {
+    std::map<eos::common::FileId::fileid_t, Fmd> mEntries;
+    uint64_t mLastSeq = 0; ///< Sequence number of the last enqueued commit
+    //! Result of the write of this batch, shared with the commit waiters
+    std::shared_ptr<bool> mFlushOk = std::make_shared<bool>(true);
+  };
+
+  std::atomic<CommitMode> mCommitMode; ///< Durability mode of the commits
+  uint32_t mCommitWindowMs; ///< Max time a commit stays pending
+  size_t mCommitMaxBatch; ///< Number of pending commits triggering a flush
+  std::mutex mPendingMutex; ///< Mutex protecting the pending commits
+  std::condition_variable mPendingCv; ///< Signal the flusher
+  std::condition_variable mFlushedCv; ///< Signal the commit waiters
+  std::map<eos::common::FileSystem::fsid_t, PendingFmd> mPending;
+  //! Sequence number up to which commits are in the DB for each filesystem
+  std::map<eos::common::FileSystem::fsid_t, uint64_t> mFlushedSeq;
+  uint64_t mPendingSeq; ///< Last sequence number handed out
+  size_t mPendingCount; ///< Number of pending commits for all filesystems
+  std::chrono::steady_clock::time_point mPendingSince; ///< Oldest pending
+  std::thread mFlusher; ///< Thread writing the pending batches
+  bool mFlusherRun; ///< Flag to stop the flusher thread
+  //! Number of filesystems currently resyncing from the MGM
+  std::atomic<int> mResyncActive;
+  //! Number of records resynced from the MGM by all filesystems
+  std::atomic<unsigned long long> mResyncTotal;
 
   //----------------------------------------------------------------------------
   //! Lock mutex corresponding to the given file systemd id
@@ -510,6 +588,10 @@ private:
       return false;
     }
 
+    if (GetPending(fid, fsid, nullptr)) {
+      return true;
+    }
+
     eos::common::DbMap::Tval val;
     bool retval = mDbMap[fsid]->get(eos::common::Slice((const char*)&fid,
                                     sizeof(fid)), &val);
@@ -529,9 +611,14 @@ private:
   Fmd LocalRetrieveFmd(eos::common::FileId::fileid_t fid,
                        eos::common::FileSystem::fsid_t fsid)
   {
+    Fmd retval;
+
+    if (GetPending(fid, fsid, &retval)) {
+      return retval;
+    }
+
     eos::common::DbMap::Tval val;
     mDbMap[fsid]->get(eos::common::Slice((const char*)&fid, sizeof(fid)), &val);
-    Fmd retval;
     retval.ParseFromString(val.value);
     return retval;
   }
@@ -550,24 +637,88 @@ private:
   bool LocalPutFmd(eos::common::FileId::fileid_t fid,
                    eos::common::FileSystem::fsid_t fsid, const Fmd& fmd)
   {
+    // A direct write supersedes any pending commit of the same record
+    (void) DropPending(fid, fsid);
     std::string sval;
     fmd.SerializePartialToString(&sval);
     return mDbMap[fsid]->set(eos::common::Slice((const char*)&fid, sizeof(fid)),
                              sval, "") == 0;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get a pending commit
+  //!
+  //! @param fid file id
+  //! @param fsid filesystem id
+  //! @param fmd if not null, filled with the pending record
+  //!
+  //! @return true if there is a pending commit for the record, otherwise false
+  //----------------------------------------------------------------------------
+  bool GetPending(eos::common::FileId::fileid_t fid,
+                  eos::common::FileSystem::fsid_t fsid, Fmd* fmd);
+
+  //----------------------------------------------------------------------------
+  //! Drop a pending commit
+  //!
+  //! @param fid file id
+  //! @param fsid filesystem id
+  //!
+  //! @return true if there was a pending commit for the record, otherwise false
+  //----------------------------------------------------------------------------
+  bool DropPending(eos::common::FileId::fileid_t fid,
+                   eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Write the pending commits of a filesystem to the DB
+  //!
+  //! @param fsid filesystem id
+  //!
+  //! @return true if successful, otherwise false
+  //! @note this function must be called with the mMapMutex locked and also the
+  //! mutex corresponding to the filesystem write locked
+  //----------------------------------------------------------------------------
+  bool FlushPendingLocked(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Flusher thread loop writing the pending commits in batches
+  //----------------------------------------------------------------------------
+  void FlusherLoop();
+
+  //----------------------------------------------------------------------------
+  //! Start the flusher thread if not already running
+  //----------------------------------------------------------------------------
+  void StartFlusher();
+
+  //----------------------------------------------------------------------------
+  //! Stop the flusher thread and write all pending commits
+  //----------------------------------------------------------------------------
+  void StopFlusher();
+
+  //----------------------------------------------------------------------------
+  //! Merge a batch of MGM records into the local database using a single
+  //! write batch and a single acquisition of the filesystem lock
+  //!
+  //! @param fsid filesystem id
+  //! @param batch MGM records to merge
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool CommitMgmBatch(eos::common::FileSystem::fsid_t fsid,
+                      const std::vector<Fmd>& batch);
+
   //----------------------------------------------------------------------------
   //! Execute "fs dumpmd" on the MGM node
   //!
   //! @param mgm_host MGM hostname
   //! @param fsid filesystem id
   //! @param fn_output file name where output is written
+  //! @param compact if true request the compact positional output format
   //!
   //! @return true if successful, otherwise false
   //----------------------------------------------------------------------------
   static bool ExecuteDumpmd(const std::string& mgm_hosst,
                             eos::common::FileSystem::fsid_t fsid,
-                            std::string& fn_output);
+                            std::string& fn_output, bool compact = false);
 
 #ifdef HAVE_FST_WITH_QUARKDB
   //----------------------------------------------------------------------------
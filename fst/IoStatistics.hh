@@ -0,0 +1,219 @@
+//------------------------------------------------------------------------------
+// File: IoStatistics.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_IOSTATISTICS_HH__
+#define __EOSFST_IOSTATISTICS_HH__
+
+#include "fst/Namespace.hh"
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class StreamingStats
+//!
+//! @brief Fixed size statistics of a stream of values (I/O sizes, latencies)
+//! which can be updated concurrently without locks. It keeps count, sum,
+//! min, max, the sums needed for the standard deviation and a histogram with
+//! one bucket per power of two used to estimate percentiles.
+//!
+//! The variance uses sums shifted by the first value instead of Welford's
+//! update, since the latter needs the count, the mean and M2 to be updated
+//! consistently, which is not possible with independent atomics. The shift
+//! avoids the cancellation of the naive sum of squares just as well for the
+//! value ranges seen here.
+//------------------------------------------------------------------------------
+class StreamingStats
+{
+public:
+  static constexpr int kBuckets = 65; ///< Bucket i holds [2^(i-1), 2^i)
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  StreamingStats():
+    mCount(0), mSum(0), mMin(UINT64_MAX), mMax(0), mShift(UINT64_MAX),
+    mShiftedSum(0), mShiftedSum2(0)
+  {
+    for (int i = 0; i < kBuckets; ++i) {
+      mHist[i] = 0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add a value
+  //----------------------------------------------------------------------------
+  void Add(uint64_t value)
+  {
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t cur = mMin.load(std::memory_order_relaxed);
+
+    while ((value < cur) &&
+           !mMin.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+
+    cur = mMax.load(std::memory_order_relaxed);
+
+    while ((value > cur) &&
+           !mMax.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+
+    // The first value becomes the shift of the variance sums
+    uint64_t shift = mShift.load(std::memory_order_relaxed);
+
+    if ((shift == UINT64_MAX) &&
+        mShift.compare_exchange_strong(shift, value, std::memory_order_relaxed)) {
+      shift = value;
+    }
+
+    double diff = (double) value - (double) shift;
+    AtomicAdd(mShiftedSum, diff);
+    AtomicAdd(mShiftedSum2, diff * diff);
+    mHist[Bucket(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of values
+  //----------------------------------------------------------------------------
+  uint64_t Count() const
+  {
+    return mCount.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Sum of all values
+  //----------------------------------------------------------------------------
+  uint64_t Sum() const
+  {
+    return mSum.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Minimum value or 0 if there are no values
+  //----------------------------------------------------------------------------
+  uint64_t Min() const
+  {
+    return (Count() ? mMin.load(std::memory_order_relaxed) : 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Maximum value
+  //----------------------------------------------------------------------------
+  uint64_t Max() const
+  {
+    return mMax.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Population standard deviation
+  //----------------------------------------------------------------------------
+  double Sigma() const
+  {
+    uint64_t n = Count();
+
+    if (!n) {
+      return 0;
+    }
+
+    double s1 = mShiftedSum.load(std::memory_order_relaxed);
+    double s2 = mShiftedSum2.load(std::memory_order_relaxed);
+    double var = (s2 - (s1 * s1) / n) / n;
+    return ((var > 0) ? sqrt(var) : 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Estimate a percentile from the histogram, interpolating linearly inside
+  //! the bucket and clamped to the observed min/max
+  //!
+  //! @param p percentile in the range [0, 1]
+  //----------------------------------------------------------------------------
+  double Percentile(double p) const
+  {
+    uint64_t counts[kBuckets];
+    uint64_t n = 0;
+
+    for (int i = 0; i < kBuckets; ++i) {
+      counts[i] = mHist[i].load(std::memory_order_relaxed);
+      n += counts[i];
+    }
+
+    if (!n) {
+      return 0;
+    }
+
+    double rank = p * n;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < kBuckets; ++i) {
+      if (!counts[i]) {
+        continue;
+      }
+
+      if (seen + counts[i] >= rank) {
+        double lo = (i ? std::ldexp(1.0, i - 1) : 0);
+        double hi = (i ? std::ldexp(1.0, i) : 1);
+        double value = lo + (hi - lo) * (rank - seen) / counts[i];
+        value = std::max(value, (double) Min());
+        return std::min(value, (double) Max());
+      }
+
+      seen += counts[i];
+    }
+
+    return Max();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Histogram bucket of a value
+  //----------------------------------------------------------------------------
+  static int Bucket(uint64_t value)
+  {
+    return (value ? 64 - __builtin_clzll(value) : 0);
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Lock-free add to an atomic double
+  //----------------------------------------------------------------------------
+  static void AtomicAdd(std::atomic<double>& target, double value)
+  {
+    double cur = target.load(std::memory_order_relaxed);
+
+    while (!target.compare_exchange_weak(cur, cur + value,
+                                         std::memory_order_relaxed)) {}
+  }
+
+  std::atomic<uint64_t> mCount; ///< Number of values
+  std::atomic<uint64_t> mSum; ///< Sum of values
+  std::atomic<uint64_t> mMin; ///< Minimum value
+  std::atomic<uint64_t> mMax; ///< Maximum value
+  std::atomic<uint64_t> mShift; ///< First value, set once
+  std::atomic<double> mShiftedSum; ///< Sum of (value - shift)
+  std::atomic<double> mShiftedSum2; ///< Sum of (value - shift)^2
+  std::atomic<uint64_t> mHist[kBuckets]; ///< Power of two histogram
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
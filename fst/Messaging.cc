@@ -48,8 +48,11 @@ Messaging::Listen()
       XrdSysThread::SetCancelOn();
     } else {
       XrdSysThread::SetCancelOn();
-      XrdSysTimer sleeper;
-      sleeper.Wait(2000);
+
+      if (!XrdMqMessaging::gMessageClient.LongPollWaited()) {
+        XrdSysTimer sleeper;
+        sleeper.Wait(2000);
+      }
     }
 
     XrdSysThread::CancelPoint();
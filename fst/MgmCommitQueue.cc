@@ -0,0 +1,491 @@
+//------------------------------------------------------------------------------
+// File: MgmCommitQueue.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/MgmCommitQueue.hh"
+#include "fst/XrdFstOfs.hh"
+#include "common/SymKeys.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+EOSFSTNAMESPACE_BEGIN
+
+//! Max length of the opaque information of a batch, the MGM accepts 16k
+static const size_t sMaxBatchOpaque = 15 * 1024;
+//! Time during which an MGM not knowing 'commits' gets individual commits
+static const time_t sUnsupportedRetry = 300;
+
+//------------------------------------------------------------------------------
+//! Response handler of a batch request
+//------------------------------------------------------------------------------
+class MgmCommitQueue::BatchHandler : public XrdCl::ResponseHandler
+{
+public:
+  BatchHandler(MgmCommitQueue* queue, const std::string& name,
+               std::vector<std::shared_ptr<Entry>>& entries):
+    mQueue(queue), mName(name)
+  {
+    mEntries.swap(entries);
+  }
+
+  virtual ~BatchHandler() {}
+
+  void HandleResponse(XrdCl::XRootDStatus* status,
+                      XrdCl::AnyObject* response) override
+  {
+    std::string reply;
+    bool ok = (status && status->IsOK());
+
+    if (ok) {
+      XrdCl::Buffer* buffer = 0;
+
+      if (response) {
+        response->Get(buffer);
+      }
+
+      if (buffer && buffer->GetBuffer()) {
+        reply.assign(buffer->GetBuffer(), buffer->GetSize());
+      }
+    } else if (status) {
+      reply = status->ToString();
+    }
+
+    mQueue->BatchDone(mName, mEntries, ok, reply);
+    delete status;
+    delete response;
+    delete this;
+  }
+
+private:
+  MgmCommitQueue* mQueue; ///< queue the batch belongs to
+  std::string mName; ///< MGM host:port
+  std::vector<std::shared_ptr<Entry>> mEntries; ///< commits of the batch
+};
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+MgmCommitQueue::MgmCommitQueue():
+  mMode(Mode::kBatch), mMaxBatch(64), mWindowMs(0), mMaxInFlight(4),
+  mRun(true)
+{
+  if (getenv("EOS_FST_MGM_COMMIT_MODE")) {
+    std::string mode = getenv("EOS_FST_MGM_COMMIT_MODE");
+
+    if (mode == "sync") {
+      mMode = Mode::kSync;
+    }
+  }
+
+  if (getenv("EOS_FST_MGM_COMMIT_BATCH")) {
+    mMaxBatch = strtoul(getenv("EOS_FST_MGM_COMMIT_BATCH"), 0, 10);
+
+    if (!mMaxBatch) {
+      mMaxBatch = 1;
+    }
+
+    // Keep within the limit of commits accepted by the MGM
+    if (mMaxBatch > 1024) {
+      mMaxBatch = 1024;
+    }
+  }
+
+  if (getenv("EOS_FST_MGM_COMMIT_WINDOW_MS")) {
+    mWindowMs = strtoul(getenv("EOS_FST_MGM_COMMIT_WINDOW_MS"), 0, 10);
+  }
+
+  if (getenv("EOS_FST_MGM_COMMIT_INFLIGHT")) {
+    mMaxInFlight = strtoul(getenv("EOS_FST_MGM_COMMIT_INFLIGHT"), 0, 10);
+
+    if (!mMaxInFlight) {
+      mMaxInFlight = 1;
+    }
+  }
+
+  eos_info("msg=\"mgm commit queue\" mode=%s batch=%lu window_ms=%u "
+           "inflight=%lu", (mMode == Mode::kSync ? "sync" : "batch"),
+           mMaxBatch, mWindowMs, mMaxInFlight);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+MgmCommitQueue::~MgmCommitQueue()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Stop the sender thread
+//------------------------------------------------------------------------------
+void
+MgmCommitQueue::Stop()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mRun = false;
+
+    // Queued commits are sent individually by their waiters, batches in
+    // flight are still answered by their handlers
+    for (auto& it : mManagers) {
+      for (auto& entry : it.second.mQueue) {
+        entry->mFallback = true;
+        entry->mDone = true;
+      }
+
+      it.second.mQueue.clear();
+    }
+  }
+
+  mQueueCv.notify_all();
+  mDoneCv.notify_all();
+
+  if (mSender.joinable()) {
+    mSender.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Commit a replica to the MGM
+//------------------------------------------------------------------------------
+int
+MgmCommitQueue::Commit(XrdOucErrInfo* error, const char* path,
+                       const char* manager, XrdOucString& capOpaqueFile)
+{
+  EPNAME("MgmCommit");
+
+  if ((mMode == Mode::kSync) || !manager) {
+    return gOFS.CallManager(error, path, manager, capOpaqueFile);
+  }
+
+  auto entry = std::make_shared<Entry>();
+  std::string opaque = capOpaqueFile.c_str();
+
+  if (opaque.compare(0, 2, "/?") == 0) {
+    opaque.erase(0, 2);
+  }
+
+  if (!eos::common::SymKey::Base64Encode(opaque.c_str(), opaque.length(),
+                                         entry->mEncoded) ||
+      (entry->mEncoded.length() + 64 > sMaxBatchOpaque)) {
+    return gOFS.CallManager(error, path, manager, capOpaqueFile);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    Manager& mgr = mManagers[manager];
+
+    if (!mRun || (mgr.mUnsupportedUntil > time(NULL))) {
+      entry->mFallback = true;
+    } else {
+      if (mgr.mQueue.empty()) {
+        mgr.mOldest = std::chrono::steady_clock::now();
+      }
+
+      mgr.mQueue.push_back(entry);
+
+      if (!mSender.joinable()) {
+        mSender = std::thread(&MgmCommitQueue::Sender, this);
+      }
+
+      mQueueCv.notify_one();
+      mDoneCv.wait(lock, [&] {return entry->mDone;});
+    }
+  }
+
+  if (entry->mFallback) {
+    return gOFS.CallManager(error, path, manager, capOpaqueFile);
+  }
+
+  if (!entry->mErrno) {
+    return SFS_OK;
+  }
+
+  // Map the error like the reply of an individual commit, keeping the error
+  // message of the MGM if it sent one
+  const char* msg = (entry->mErrMsg.length() ? entry->mErrMsg.c_str() : 0);
+
+  switch (entry->mErrno) {
+  case EIDRM:
+    gOFS.Emsg(epname, *error, EIDRM, msg ? msg : "commit replica [EIDRM]",
+              path);
+    return -EIDRM;
+
+  case EBADE:
+    gOFS.Emsg(epname, *error, EBADE, msg ? msg : "commit replica [EBADE]",
+              path);
+    return -EBADE;
+
+  case EBADR:
+    gOFS.Emsg(epname, *error, EBADR, msg ? msg : "commit replica [EBADR]",
+              path);
+    return -EBADR;
+
+  case EINVAL:
+    gOFS.Emsg(epname, *error, EINVAL, msg ? msg : "commit replica [EINVAL]",
+              path);
+    return -EINVAL;
+
+  case EADV:
+    gOFS.Emsg(epname, *error, EADV, msg ? msg : "commit replica [EADV]",
+              path);
+    return -EADV;
+
+  default:
+    gOFS.Emsg(epname, *error, ECOMM,
+              msg ? msg : "commit replica - error on the MGM", path);
+    return SFS_ERROR;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parse the reply of a 'commits' request
+//------------------------------------------------------------------------------
+bool
+MgmCommitQueue::ParseReply(const std::string& reply, std::vector<int>& errnos,
+                           std::vector<std::string>& msgs)
+{
+  static const std::string key = "mgm.commit.";
+  static const std::string msg_suffix = ".msg";
+  std::fill(errnos.begin(), errnos.end(), 0);
+  msgs.assign(errnos.size(), "");
+  // The reply may carry the string terminator
+  size_t end = reply.find('\0');
+
+  if (end == std::string::npos) {
+    end = reply.length();
+  }
+
+  if (reply.compare(0, 2, "OK") != 0) {
+    return false;
+  }
+
+  size_t pos = 2;
+
+  // Every failed commit is reported as &mgm.commit.<index>=<errno> followed
+  // by &mgm.commit.<index>.msg=<base64 encoded error message of the MGM>
+  while (pos < end) {
+    if (reply[pos] != '&') {
+      return false;
+    }
+
+    size_t next = reply.find('&', pos + 1);
+
+    if ((next == std::string::npos) || (next > end)) {
+      next = end;
+    }
+
+    std::string token = reply.substr(pos + 1, next - pos - 1);
+    size_t eq = token.find('=');
+
+    if ((token.compare(0, key.length(), key) != 0) ||
+        (eq == std::string::npos) || (eq == key.length()) ||
+        (eq + 1 == token.length())) {
+      return false;
+    }
+
+    char* ptr = 0;
+    unsigned long index = strtoul(token.c_str() + key.length(), &ptr, 10);
+
+    if ((ptr == token.c_str() + key.length()) || (index >= errnos.size())) {
+      return false;
+    }
+
+    if (ptr != token.c_str() + eq) {
+      if ((token.compare(ptr - token.c_str(), eq - (ptr - token.c_str()),
+                         msg_suffix) != 0) ||
+          !eos::common::SymKey::Base64Decode(token.c_str() + eq + 1,
+                                             msgs[index])) {
+        return false;
+      }
+
+      pos = next;
+      continue;
+    }
+
+    int ec = (int) strtol(token.c_str() + eq + 1, &ptr, 10);
+
+    if (*ptr || (ec <= 0)) {
+      return false;
+    }
+
+    errnos[index] = ec;
+    pos = next;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Loop sending the queued commits of all MGMs
+//------------------------------------------------------------------------------
+void
+MgmCommitQueue::Sender()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (mRun) {
+    auto now = std::chrono::steady_clock::now();
+    auto wakeup = now + std::chrono::seconds(1);
+
+    for (auto it = mManagers.begin(); it != mManagers.end(); ++it) {
+      Manager& mgr = it->second;
+
+      while (mRun && !mgr.mQueue.empty() && (mgr.mInFlight < mMaxInFlight)) {
+        // Without a window the batch goes out as soon as a request slot is
+        // free, otherwise it waits to be full or for the window to expire
+        if (mWindowMs && (mgr.mQueue.size() < mMaxBatch)) {
+          auto due = mgr.mOldest + std::chrono::milliseconds(mWindowMs);
+
+          if (now < due) {
+            if (due < wakeup) {
+              wakeup = due;
+            }
+
+            break;
+          }
+        }
+
+        SendBatch(lock, it->first, mgr);
+      }
+    }
+
+    mQueueCv.wait_until(lock, wakeup);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Send the next batch of an MGM
+//------------------------------------------------------------------------------
+void
+MgmCommitQueue::SendBatch(std::unique_lock<std::mutex>& lock,
+                          const std::string& name, Manager& mgr)
+{
+  std::vector<std::shared_ptr<Entry>> entries;
+  std::string opaque;
+
+  while (!mgr.mQueue.empty() && (entries.size() < mMaxBatch)) {
+    auto& entry = mgr.mQueue.front();
+    std::string item = "&mgm.commit.";
+    item += std::to_string(entries.size());
+    item += "=";
+    item += entry->mEncoded;
+
+    if (!entries.empty() &&
+        (opaque.length() + item.length() + 64 > sMaxBatchOpaque)) {
+      break;
+    }
+
+    opaque += item;
+    entries.push_back(entry);
+    mgr.mQueue.pop_front();
+  }
+
+  if (!mgr.mQueue.empty()) {
+    mgr.mOldest = std::chrono::steady_clock::now();
+  }
+
+  opaque.insert(0, "/?mgm.pcmd=commits&mgm.commits=" +
+                std::to_string(entries.size()));
+
+  if (!mgr.mFs) {
+    XrdCl::URL url("root://" + name + "//dummy");
+
+    if (!url.IsValid()) {
+      eos_err("msg=\"manager URL is not valid\" manager=%s", name.c_str());
+    }
+
+    mgr.mFs.reset(new XrdCl::FileSystem(url));
+  }
+
+  XrdCl::FileSystem* fs = mgr.mFs.get();
+  ++mgr.mInFlight;
+  // The handler takes over the entries and may run before Query returns
+  size_t nentries = entries.size();
+  BatchHandler* handler = new BatchHandler(this, name, entries);
+  lock.unlock();
+  XrdCl::Buffer arg;
+  arg.FromString(opaque);
+  XrdCl::XRootDStatus status = fs->Query(XrdCl::QueryCode::OpaqueFile, arg,
+                                         handler);
+
+  if (!status.IsOK()) {
+    eos_err("msg=\"failed to send commit batch\" manager=%s ncommits=%lu "
+            "status=\"%s\"", name.c_str(), nentries, status.ToString().c_str());
+    // The handler is not called if the request was not submitted
+    handler->HandleResponse(new XrdCl::XRootDStatus(status), 0);
+  } else {
+    eos_debug("msg=\"sent commit batch\" manager=%s ncommits=%lu",
+              name.c_str(), nentries);
+  }
+
+  lock.lock();
+}
+
+//------------------------------------------------------------------------------
+// Handle the reply of a batch
+//------------------------------------------------------------------------------
+void
+MgmCommitQueue::BatchDone(const std::string& name,
+                          std::vector<std::shared_ptr<Entry>>& entries,
+                          bool ok, const std::string& reply)
+{
+  std::vector<int> errnos(entries.size(), 0);
+  std::vector<std::string> msgs(entries.size());
+
+  if (ok && !ParseReply(reply, errnos, msgs)) {
+    eos_err("msg=\"invalid commit batch reply\" manager=%s reply=\"%s\"",
+            name.c_str(), reply.c_str());
+    ok = false;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  Manager& mgr = mManagers[name];
+  --mgr.mInFlight;
+
+  if (!ok) {
+    // An MGM which does not know the 'commits' command rejects the request
+    // as an unknown FSctl command - don't try again for a while
+    if (reply.find("execute FSctl command") != std::string::npos) {
+      eos_warning("msg=\"manager does not accept commit batches\" manager=%s",
+                  name.c_str());
+      mgr.mUnsupportedUntil = time(NULL) + sUnsupportedRetry;
+    } else {
+      eos_warning("msg=\"commit batch failed, committing individually\" "
+                  "manager=%s ncommits=%lu error=\"%s\"", name.c_str(),
+                  entries.size(), reply.c_str());
+    }
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    entries[i]->mFallback = !ok;
+    entries[i]->mErrno = errnos[i];
+    entries[i]->mErrMsg = msgs[i];
+    entries[i]->mDone = true;
+  }
+
+  lock.unlock();
+  mDoneCv.notify_all();
+  mQueueCv.notify_one();
+}
+
+EOSFSTNAMESPACE_END
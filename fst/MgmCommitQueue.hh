@@ -0,0 +1,175 @@
+//------------------------------------------------------------------------------
+// File: MgmCommitQueue.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSFST_MGMCOMMITQUEUE_HH__
+#define __EOSFST_MGMCOMMITQUEUE_HH__
+
+#include "fst/Namespace.hh"
+#include "common/Logging.hh"
+#include "XrdOuc/XrdOucErrInfo.hh"
+#include "XrdOuc/XrdOucString.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class MgmCommitQueue
+//!
+//! @brief Coalesces the replica commits sent to the MGM when files are closed.
+//! Commits are queued per MGM and sent as one 'commits' request carrying up
+//! to a batch of commits over a persistent XrdCl::FileSystem, with several
+//! requests in flight per MGM. A batch is sent as soon as a request slot is
+//! free, or after the batching window if one is configured, so commits pile
+//! up only while the MGM is busy.
+//!
+//! The caller of Commit still waits for the result of its own commit, hence
+//! the close semantics are unchanged. Commits which can not be sent in a
+//! batch e.g. because the MGM does not know the 'commits' command or the
+//! request failed are sent with XrdFstOfs::CallManager as before.
+//------------------------------------------------------------------------------
+class MgmCommitQueue : public eos::common::LogId
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Commit mode
+  //!
+  //! kSync  - every commit is an individual request (legacy behaviour)
+  //! kBatch - commits are coalesced per MGM, the caller waits for its result
+  //----------------------------------------------------------------------------
+  enum class Mode {
+    kSync, kBatch
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor - the configuration is taken from the environment
+  //----------------------------------------------------------------------------
+  MgmCommitQueue();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~MgmCommitQueue();
+
+  //----------------------------------------------------------------------------
+  //! Commit a replica to the MGM
+  //!
+  //! @param error error object
+  //! @param path path of the file
+  //! @param manager MGM host:port
+  //! @param capOpaqueFile opaque commit information
+  //!
+  //! @return same as XrdFstOfs::CallManager e.g. SFS_OK, -EIDRM, -EBADE ...
+  //----------------------------------------------------------------------------
+  int Commit(XrdOucErrInfo* error, const char* path, const char* manager,
+             XrdOucString& capOpaqueFile);
+
+  //----------------------------------------------------------------------------
+  //! Stop the sender thread, queued commits are sent individually
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Parse the reply of a 'commits' request
+  //!
+  //! @param reply reply of the MGM
+  //! @param errnos filled with the error of every commit, 0 if successful
+  //! @param msgs filled with the error message of every commit, empty if the
+  //!        MGM did not send one
+  //!
+  //! @return true if the reply is valid, otherwise false
+  //----------------------------------------------------------------------------
+  static bool ParseReply(const std::string& reply, std::vector<int>& errnos,
+                         std::vector<std::string>& msgs);
+
+private:
+  //! Commit waiting for its result
+  struct Entry {
+    Entry(): mDone(false), mFallback(false), mErrno(0) {}
+
+    std::string mEncoded; ///< base64 encoded opaque commit information
+    bool mDone; ///< true once the result is known
+    bool mFallback; ///< true if the commit has to be sent individually
+    int mErrno; ///< error reported by the MGM for this commit
+    std::string mErrMsg; ///< error message of the MGM for this commit
+  };
+
+  //! Commits queued for one MGM
+  struct Manager {
+    Manager(): mInFlight(0), mUnsupportedUntil(0) {}
+
+    std::unique_ptr<XrdCl::FileSystem> mFs; ///< persistent MGM connection
+    std::deque<std::shared_ptr<Entry>> mQueue; ///< commits not yet sent
+    std::chrono::steady_clock::time_point mOldest; ///< enqueue time of front
+    size_t mInFlight; ///< number of batches sent and not yet answered
+    time_t mUnsupportedUntil; ///< MGM does not know 'commits' before this
+  };
+
+  class BatchHandler;
+
+  //----------------------------------------------------------------------------
+  //! Loop sending the queued commits of all MGMs
+  //----------------------------------------------------------------------------
+  void Sender();
+
+  //----------------------------------------------------------------------------
+  //! Send the next batch of an MGM - mMutex must be locked, it is released
+  //! while the request is submitted
+  //----------------------------------------------------------------------------
+  void SendBatch(std::unique_lock<std::mutex>& lock, const std::string& name,
+                 Manager& mgr);
+
+  //----------------------------------------------------------------------------
+  //! Handle the reply of a batch
+  //!
+  //! @param name MGM host:port
+  //! @param entries commits of the batch
+  //! @param ok true if the request was successful
+  //! @param reply reply or error message of the request
+  //----------------------------------------------------------------------------
+  void BatchDone(const std::string& name,
+                 std::vector<std::shared_ptr<Entry>>& entries, bool ok,
+                 const std::string& reply);
+
+  Mode mMode; ///< commit mode
+  size_t mMaxBatch; ///< max number of commits in one request
+  uint32_t mWindowMs; ///< max time a commit waits for a full batch
+  size_t mMaxInFlight; ///< max number of requests in flight per MGM
+  std::mutex mMutex; ///< mutex protecting the queues
+  std::condition_variable mQueueCv; ///< signal the sender thread
+  std::condition_variable mDoneCv; ///< signal the commit waiters
+  std::map<std::string, Manager> mManagers; ///< queued commits by MGM
+  std::thread mSender; ///< thread sending the batches
+  bool mRun; ///< flag to stop the sender thread
+};
+
+EOSFSTNAMESPACE_END
+
+#endif
@@ -29,6 +29,7 @@
 #include "fst/storage/FileSystem.hh"
 #include "fst/storage/Storage.hh"
 #include "fst/Messaging.hh"
+#include "fst/MgmCommitQueue.hh"
 #include "fst/http/HttpServer.hh"
 #include "common/FileId.hh"
 #include "common/FileSystem.hh"
@@ -124,6 +125,7 @@ XrdFstOfs::XrdFstOfs() :
   Eroute = 0;
   Messaging = 0;
   Storage = 0;
+  MgmCommits = 0;
   TransferScheduler = 0;
   TpcMap.resize(2);
   TpcMap[0].set_deleted_key(""); // readers
@@ -246,6 +248,13 @@ XrdFstOfs::xrdfstofs_shutdown(int sig)
   sleeper.Wait(1000);
   gOFS.Storage->ShutdownThreads();
   eos_static_warning("op=shutdown msg=\"stop messaging\"");
+
+  if (gOFS.MgmCommits) {
+    // Queued commits are sent individually from now on
+    eos_static_warning("%s", "op=shutdown msg=\"stop mgm commit queue\"");
+    gOFS.MgmCommits->Stop();
+  }
+
   eos_static_warning("%s", "op=shutdown msg=\"shutdown fmddbmap handler\"");
   gFmdDbMapHandler.Shutdown();
   kill(watchdog, 9);
@@ -317,6 +326,13 @@ XrdFstOfs::xrdfstofs_graceful_shutdown(int sig)
   XrdSysTimer sleeper;
   sleeper.Wait(1000);
   gOFS.Storage->ShutdownThreads();
+
+  if (gOFS.MgmCommits) {
+    // Queued commits are sent individually from now on
+    eos_static_warning("%s", "op=shutdown msg=\"stop mgm commit queue\"");
+    gOFS.MgmCommits->Stop();
+  }
+
   eos_static_warning("op=shutdown msg=\"shutdown fmddbmap handler\"");
   gFmdDbMapHandler.Shutdown();
   kill(watchdog, 9);
@@ -617,6 +633,8 @@ XrdFstOfs::Configure(XrdSysError& Eroute, XrdOucEnv* envP)
     return 1;
   }
 
+  // Commits of closed files are coalesced per MGM
+  MgmCommits = new eos::fst::MgmCommitQueue();
   XrdSysTimer sleeper;
   sleeper.Snooze(5);
   ObjectNotifier.SetShareObjectManager(&ObjectManager);
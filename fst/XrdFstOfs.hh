@@ -62,6 +62,7 @@ class ReplicaParLayout;
 class RaidMetaLayout;
 class HttpServer;
 class Storage;
+class MgmCommitQueue;
 class Messaging;
 
 //------------------------------------------------------------------------------
@@ -333,6 +334,7 @@ public:
   XrdSysError* Eroute;
   eos::fst::Messaging* Messaging; ///< messaging interface class
   eos::fst::Storage* Storage; ///< Meta data & filesytem store object
+  eos::fst::MgmCommitQueue* MgmCommits; ///< Coalescing commits to the MGM
   XrdSysMutex OpenFidMutex;
 
   google::sparse_hash_map<eos::common::FileSystem::fsid_t,
@@ -29,6 +29,7 @@
 #include "common/SecEntity.hh"
 #include "fst/XrdFstOfsFile.hh"
 #include "fst/XrdFstOfs.hh"
+#include "fst/MgmCommitQueue.hh"
 #include "fst/layout/Layout.hh"
 #include "fst/layout/LayoutPlugin.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
@@ -1129,6 +1130,7 @@ XrdFstOfsFile::AddReadTime()
                       (lrTime.tv_usec - cTime.tv_usec);
   rTime.tv_sec += (mus / 1000000);
   rTime.tv_usec += (mus % 1000000);
+  rLatency.Add(mus);
 }
 
 //------------------------------------------------------------------------------
@@ -1141,6 +1143,7 @@ XrdFstOfsFile::AddReadVTime()
                       (lrvTime.tv_usec - cTime.tv_usec);
   rvTime.tv_sec += (mus / 1000000);
   rvTime.tv_usec += (mus % 1000000);
+  rvLatency.Add(mus);
 }
 
 //------------------------------------------------------------------------------
@@ -1153,6 +1156,7 @@ XrdFstOfsFile::AddWriteTime()
                       lwTime.tv_usec - cTime.tv_usec;
   wTime.tv_sec += (mus / 1000000);
   wTime.tv_usec += (mus % 1000000);
+  wLatency.Add(mus);
 }
 
 //------------------------------------------------------------------------------
@@ -1161,30 +1165,9 @@ XrdFstOfsFile::AddWriteTime()
 void
 XrdFstOfsFile::MakeReportEnv(XrdOucString& reportString)
 {
-  // compute avg, min, max, sigma for read and written bytes
-  unsigned long long rmin, rmax, rsum;
-  unsigned long long rvmin, rvmax, rvsum; // readv bytes
-  unsigned long long rsmin, rsmax, rssum; // read single bytes
-  unsigned long rcmin, rcmax, rcsum;      // readv count
-  unsigned long long wmin, wmax, wsum;
-  double rsigma, rvsigma, rssigma, rcsigma, wsigma;
+  // The statistics are kept up to date by every I/O, just read them out
   {
-    XrdSysMutexHelper vecLock(vecMutex);
-    ComputeStatistics(rvec, rmin, rmax, rsum, rsigma);
-    ComputeStatistics(wvec, wmin, wmax, wsum, wsigma);
-    ComputeStatistics(monReadvBytes, rvmin, rvmax, rvsum, rvsigma);
-    ComputeStatistics(monReadSingleBytes, rsmin, rsmax, rssum, rssigma);
-    ComputeStatistics(monReadvCount, rcmin, rcmax, rcsum, rcsigma);
     char report[16384];
-
-    if (rmin == 0xffffffff) {
-      rmin = 0;
-    }
-
-    if (wmin == 0xffffffff) {
-      wmin = 0;
-    }
-
     snprintf(report, sizeof(report) - 1,
              "log=%s&path=%s&ruid=%u&rgid=%u&td=%s&"
              "host=%s&lid=%lu&fid=%llu&fsid=%lu&"
@@ -1198,7 +1181,12 @@ XrdFstOfsFile::MakeReportEnv(XrdOucString& reportString)
              "wb=%llu&wb_min=%llu&wb_max=%llu&wb_sigma=%.02f&"
              "sfwdb=%llu&sbwdb=%llu&sxlfwdb=%llu&sxlbwdb=%llu&"
              "nfwds=%lu&nbwds=%lu&nxlfwds=%lu&nxlbwds=%lu&"
-             "rt=%.02f&rvt=%.02f&wt=%.02f&osize=%llu&csize=%llu&%s"
+             "rt=%.02f&rvt=%.02f&wt=%.02f&osize=%llu&csize=%llu&"
+             "rb_p50=%.0f&rb_p90=%.0f&rb_p99=%.0f&"
+             "rsb_p50=%.0f&rsb_p90=%.0f&rsb_p99=%.0f&"
+             "wb_p50=%.0f&wb_p90=%.0f&wb_p99=%.0f&"
+             "rt_p50=%.03f&rt_p99=%.03f&rvt_p50=%.03f&rvt_p99=%.03f&"
+             "wt_p50=%.03f&wt_p99=%.03f&%s"
              , this->logId
 	     , capOpaque->Get("mgm.path")?capOpaque->Get("mgm.path"):Path.c_str()
 	     , this->vid.uid, this->vid.gid, tIdent.c_str()
@@ -1206,14 +1194,24 @@ XrdFstOfsFile::MakeReportEnv(XrdOucString& reportString)
              , openTime.tv_sec, (unsigned long) openTime.tv_usec / 1000
              , closeTime.tv_sec, (unsigned long) closeTime.tv_usec / 1000
              , rCalls, wCalls
-             , rsum, rmin, rmax, rsigma
-             , (unsigned long long)monReadvBytes.size(), rvmin, rvmax, rvsum, rvsigma
-             , (unsigned long long)monReadSingleBytes.size(), rsmin, rsmax, rssum, rssigma
-             , rcmin, rcmax, rcsum, rcsigma
-             , wsum
-             , wmin
-             , wmax
-             , wsigma
+             , (unsigned long long) rStats.Sum(), (unsigned long long) rStats.Min()
+             , (unsigned long long) rStats.Max(), rStats.Sigma()
+             , (unsigned long long) monReadvBytes.Count()
+             , (unsigned long long) monReadvBytes.Min()
+             , (unsigned long long) monReadvBytes.Max()
+             , (unsigned long long) monReadvBytes.Sum(), monReadvBytes.Sigma()
+             , (unsigned long long) monReadSingleBytes.Count()
+             , (unsigned long long) monReadSingleBytes.Min()
+             , (unsigned long long) monReadSingleBytes.Max()
+             , (unsigned long long) monReadSingleBytes.Sum()
+             , monReadSingleBytes.Sigma()
+             , (unsigned long) monReadvCount.Min()
+             , (unsigned long) monReadvCount.Max()
+             , (unsigned long) monReadvCount.Sum(), monReadvCount.Sigma()
+             , (unsigned long long) wStats.Sum()
+             , (unsigned long long) wStats.Min()
+             , (unsigned long long) wStats.Max()
+             , wStats.Sigma()
              , sFwdBytes
              , sBwdBytes
              , sXlFwdBytes
@@ -1227,6 +1225,14 @@ XrdFstOfsFile::MakeReportEnv(XrdOucString& reportString)
              , ((wTime.tv_sec * 1000.0) + (wTime.tv_usec / 1000.0))
              , (unsigned long long) openSize
              , (unsigned long long) closeSize
+             , rStats.Percentile(0.5), rStats.Percentile(0.9), rStats.Percentile(0.99)
+             , monReadSingleBytes.Percentile(0.5)
+             , monReadSingleBytes.Percentile(0.9)
+             , monReadSingleBytes.Percentile(0.99)
+             , wStats.Percentile(0.5), wStats.Percentile(0.9), wStats.Percentile(0.99)
+             , rLatency.Percentile(0.5) / 1000.0, rLatency.Percentile(0.99) / 1000.0
+             , rvLatency.Percentile(0.5) / 1000.0, rvLatency.Percentile(0.99) / 1000.0
+             , wLatency.Percentile(0.5) / 1000.0, wLatency.Percentile(0.99) / 1000.0
              , eos::common::SecEntity::ToEnv(SecString.c_str(),
                  ((tpcFlag == kTpcDstSetup) ||
                   (tpcFlag == kTpcSrcRead)) ? "tpc" : 0).c_str());
@@ -1812,8 +1818,9 @@ XrdFstOfsFile::close()
               capOpaqueFile += eos::common::OwnCloud::FilterOcQuery(openOpaque->Env(envlen));
             }
 
-            rc = gOFS.CallManager(&error, capOpaque->Get("mgm.path"),
-                                  capOpaque->Get("mgm.manager"), capOpaqueFile);
+            rc = gOFS.MgmCommits->Commit(&error, capOpaque->Get("mgm.path"),
+                                         capOpaque->Get("mgm.manager"),
+                                         capOpaqueFile);
 
             if (rc) {
               if ((rc == -EIDRM) || (rc == -EBADE) || (rc == -EBADR)) {
@@ -2242,8 +2249,7 @@ XrdFstOfsFile::readofs(XrdSfsFileOffset fileOffset, char* buffer,
 
   if (rc > 0) {
     if (layOut->IsEntryServer()) {
-      XrdSysMutexHelper vecLock(vecMutex);
-      rvec.push_back(rc);
+      rStats.Add(rc);
     }
 
     rOffset = fileOffset + rc;
@@ -2333,6 +2339,69 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
   return rc;
 }
 
+//------------------------------------------------------------------------------
+// Get a duplicate of the local file descriptor for zero-copy reads
+//------------------------------------------------------------------------------
+int
+XrdFstOfsFile::GetZeroCopyFd(off_t offset, size_t length)
+{
+  if (isRW || (tpcFlag != kTpcNone) || !layOut) {
+    return -1;
+  }
+
+  {
+    // A full read verifies the checksum, it has to go through the read path
+    XrdSysMutexHelper cLock(ChecksumMutex);
+
+    if (checkSum && (offset == 0) &&
+        (length >= static_cast<size_t>(openSize))) {
+      return -1;
+    }
+  }
+
+  if ((eos::common::LayoutId::GetLayoutType(lid) !=
+       eos::common::LayoutId::kPlain) &&
+      (eos::common::LayoutId::GetLayoutType(lid) !=
+       eos::common::LayoutId::kReplica)) {
+    return -1;
+  }
+
+  XrdOucErrInfo fd_error;
+
+  if (XrdOfsFile::fctl(SFS_FCTL_GETFD, 0, fd_error)) {
+    return -1;
+  }
+
+  int fd = fd_error.getErrInfo();
+
+  if (fd < 0) {
+    return -1;
+  }
+
+  int dup_fd = dup(fd);
+
+  if (dup_fd < 0) {
+    eos_err("msg=\"failed to duplicate fd\" errno=%d", errno);
+    return -1;
+  }
+
+  // Account the read as if done by readofs, the data is sent by the kernel
+  gettimeofday(&cTime, &tz);
+  rCalls++;
+
+  if (length) {
+    if (layOut->IsEntryServer()) {
+      rStats.Add(length);
+    }
+
+    rOffset = offset + length;
+  }
+
+  gettimeofday(&lrTime, &tz);
+  AddReadTime();
+  return dup_fd;
+}
+
 //------------------------------------------------------------------------------
 // Vector read - low level ofs method which is called from one of the
 // layout plugins
@@ -2347,17 +2416,12 @@ XrdFstOfsFile::readvofs(XrdOucIOVec* readV,
   gettimeofday(&lrvTime, &tz);
   AddReadVTime();
   // Collect monitoring info
-  {
-    XrdSysMutexHelper scope_lock(vecMutex);
-
-    // If this is the last read of sequential reading, we can verify the checksum now
-    for (uint32_t i = 0; i < readCount; ++i) {
-      monReadSingleBytes.push_back(readV[i].size);
-    }
-
-    monReadvBytes.push_back(sz);
-    monReadvCount.push_back(readCount);
+  for (uint32_t i = 0; i < readCount; ++i) {
+    monReadSingleBytes.Add(readV[i].size);
   }
+
+  monReadvBytes.Add(sz);
+  monReadvCount.Add(readCount);
   return sz;
 }
 
@@ -2476,8 +2540,7 @@ XrdFstOfsFile::writeofs(XrdSfsFileOffset fileOffset,
 
   if (rc > 0) {
     if (layOut->IsEntryServer()) {
-      XrdSysMutexHelper(vecMutex);
-      wvec.push_back(rc);
+      wStats.Add(rc);
     }
 
     wOffset = fileOffset + rc;
@@ -27,6 +27,7 @@
 
 #include <numeric>
 #include "fst/Namespace.hh"
+#include "fst/IoStatistics.hh"
 #include "fst/checksum/CheckSum.hh"
 #include "fst/FmdDbMap.hh"
 #include "fst/storage/Storage.hh"
@@ -347,6 +348,20 @@ public:
     return isOCchunk;
   }
 
+  //--------------------------------------------------------------------------
+  //! Get a duplicate of the local file descriptor to serve a read using
+  //! zero-copy (sendfile). This is only possible for plain and replica files
+  //! opened read-only outside of a TPC transfer, and not for a full read of a
+  //! file with a checksum since that one is verified by the read path. The
+  //! read is accounted when the descriptor is handed out.
+  //!
+  //! @param offset offset of the read
+  //! @param length length of the read
+  //!
+  //! @return file descriptor owned by the caller or -1 if not possible
+  //--------------------------------------------------------------------------
+  int GetZeroCopyFd(off_t offset, size_t length);
+
   //--------------------------------------------------------------------------
   static int LayoutReadCB(eos::fst::CheckSum::ReadCallBack::callback_data_t* cbd);
   static int FileIoReadCB(eos::fst::CheckSum::ReadCallBack::callback_data_t* cbd);
@@ -447,11 +462,8 @@ private:
   struct timeval openTime; //! time when a file was opened
   struct timeval closeTime; //! time when a file was closed
   struct timezone tz; //! timezone
-  XrdSysMutex vecMutex; //! mutex protecting the rvec/wvec variables
-  std::vector<unsigned long long>
-  rvec; //! vector with all read  sizes -> to compute sigma,min,max,total
-  std::vector<unsigned long long>
-  wvec; //! vector with all write sizes -> to compute sigma,min,max,total
+  StreamingStats rStats; //! read sizes -> sigma,min,max,total,percentiles
+  StreamingStats wStats; //! write sizes -> sigma,min,max,total,percentiles
   unsigned long long rBytes; //! sum bytes read
   unsigned long long wBytes; //! sum bytes written
   unsigned long long sFwdBytes; //! sum bytes seeked forward
@@ -468,12 +480,15 @@ private:
   unsigned long nXlBwdSeeks; //! number of seeks backward
   unsigned long long rOffset; //! offset since last read operation on this file
   unsigned long long wOffset; //! offset since last write operation on this file
-  //! vector with all readv sizes -> to compute min,max,etc.
-  std::vector<unsigned long long> monReadvBytes;
+  //! readv sizes -> to compute min,max,etc.
+  StreamingStats monReadvBytes;
   //! size of each read call coming from readv requests -> to compute min,max, etc.
-  std::vector<unsigned long long> monReadSingleBytes;
+  StreamingStats monReadSingleBytes;
   //! number of individual read op. in each readv call -> to compute min,max, etc.
-  std::vector<unsigned long> monReadvCount;
+  StreamingStats monReadvCount;
+  StreamingStats rLatency; ///< latency of read requests in us
+  StreamingStats rvLatency; ///< latency of readv requests in us
+  StreamingStats wLatency; ///< latency of write requests in us
 
   struct timeval cTime; ///< current time
   struct timeval lrTime; ///<last read time
@@ -501,53 +516,6 @@ private:
   //--------------------------------------------------------------------------
   void AddWriteTime();
 
-  //--------------------------------------------------------------------------
-  //! Compute general statistics on a set of input values
-  //!
-  //! @param vect input collection
-  //! @param min miniumum element
-  //! @param max maximum element
-  //! @param sum sum of the elements
-  //! @param avg average value
-  //! @param sigma sigma of the elements
-  //--------------------------------------------------------------------------
-  template <typename T>
-  void ComputeStatistics(const std::vector<T>& vect, T& min, T& max,
-                         T& sum, double& sigma)
-  {
-    double avg, sum2;
-    max = sum = sum2 = avg = sigma = 0;
-    min = 0xffffffff;
-    sum = std::accumulate(vect.begin(), vect.end(),
-                          static_cast<unsigned long long>(0));
-    avg = vect.size() ? (1.0 * sum / vect.size()) : 0;
-
-    // For when the compiler will be smart enough
-    //sigma = std::accumulate(begin(vect), end(vect), 0,
-    //                      [&avg] (const T& init, const T& elem)
-    //                      {
-    //                        return elem + std::pwd((elem - avg), 2);
-    //                      });
-
-    for (auto it = vect.begin(); it != vect.end(); ++it) {
-      if (*it > max) {
-        max = *it;
-      }
-
-      if (*it < min) {
-        min = *it;
-      }
-
-      sum2 += std::pow((*it - avg), 2);
-    }
-
-    sigma = vect.size() ? (sqrt(sum2 / vect.size())) : 0;
-
-    if (min == 0xffffffff) {
-      min = 0;
-    }
-  }
-
   //----------------------------------------------------------------------------
   //! Create report as a string
   //----------------------------------------------------------------------------
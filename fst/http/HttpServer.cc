@@ -30,6 +30,7 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 /*----------------------------------------------------------------------------*/
+#include <unistd.h>
 
 /*----------------------------------------------------------------------------*/
 
@@ -147,7 +148,10 @@ HttpServer::Handler(void* cls,
   // Create the MHD response
   struct MHD_Response* mhdResponse;
 
-  if (response->mUseFileReaderCallback) {
+  if (response->mUseFileReaderCallback &&
+      (mhdResponse = CreateZeroCopyResponse(protocolHandler, response))) {
+    eos_static_debug("response length=%d zero-copy", response->mResponseLength);
+  } else if (response->mUseFileReaderCallback) {
     eos_static_debug("response length=%d", response->mResponseLength);
     mhdResponse = MHD_create_response_from_callback(response->mResponseLength,
                   4 * 1024 * 1024, /* 4M page size */
@@ -179,6 +183,46 @@ HttpServer::Handler(void* cls,
   }
 }
 
+/*----------------------------------------------------------------------------*/
+struct MHD_Response*
+HttpServer::CreateZeroCopyResponse(eos::common::ProtocolHandler* handler,
+                                   eos::common::HttpResponse* response)
+{
+  if (!mZeroCopy) {
+    return 0;
+  }
+
+  eos::fst::HttpHandler* httpHandle = dynamic_cast<eos::fst::HttpHandler*>
+                                      (handler);
+
+  if (!httpHandle || !httpHandle->mFile ||
+      (httpHandle->mRangeRequest && (httpHandle->mOffsetMap.size() != 1))) {
+    return 0;
+  }
+
+  off_t offset = 0;
+
+  if (httpHandle->mRangeRequest) {
+    offset = httpHandle->mOffsetMap.begin()->first;
+  }
+
+  // The fd is owned and closed by the MHD response
+  int fd = httpHandle->mFile->GetZeroCopyFd(offset, response->mResponseLength);
+
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct MHD_Response* mhdResponse = MHD_create_response_from_fd_at_offset(
+                                       response->mResponseLength, fd, offset);
+
+  if (!mhdResponse) {
+    close(fd);
+  }
+
+  return mhdResponse;
+}
+
 /*----------------------------------------------------------------------------*/
 ssize_t
 HttpServer::FileReaderCallback(void* cls, uint64_t pos, char* buf, size_t max)
@@ -35,6 +35,8 @@
 #include "common/Logging.hh"
 #include "common/http/HttpServer.hh"
 /*----------------------------------------------------------------------------*/
+#include <cstdlib>
+#include <cstring>
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
 
@@ -48,7 +50,17 @@ public:
   /**
    * Constructor
    */
-  HttpServer(int port = 8001) : eos::common::HttpServer::HttpServer(port) {};
+  HttpServer(int port = 8001) : eos::common::HttpServer::HttpServer(port)
+  {
+    const char* zerocopy = getenv("EOS_FST_HTTP_ZEROCOPY");
+    // Keep one thread per connection by default: the read callbacks block on
+    // the disk, so with EOS_HTTP_THREADPOOL=epoll at most
+    // EOS_HTTP_THREADPOOL_SIZE transfers make progress at the same time
+    mThreadModel = "threads";
+    // Zero-copy is opt-in, it is not used for reads verifying the checksum
+    mZeroCopy = (zerocopy && (!strcmp(zerocopy, "1") ||
+                              !strcmp(zerocopy, "on")));
+  };
 
   /**
    * Destructor
@@ -95,7 +107,25 @@ public:
   static ssize_t
   FileReaderCallback(void* cls, uint64_t pos, char* buf, size_t max);
 
+  /**
+   * Create a zero-copy response served by the kernel (sendfile) from the
+   * local replica. This is only used if EOS_FST_HTTP_ZEROCOPY is on, for
+   * plain/replica files and requests without or with a single range which
+   * don't need a checksum verification.
+   *
+   * @param handler the protocol handler holding the open file
+   * @param response the response to be sent
+   *
+   * @return MHD response or 0 if zero-copy is not possible
+   */
+  struct MHD_Response*
+  CreateZeroCopyResponse(eos::common::ProtocolHandler* handler,
+                         eos::common::HttpResponse* response);
+
 #endif
+
+private:
+  bool mZeroCopy; ///< Serve plain reads with sendfile
 };
 
 EOSFSTNAMESPACE_END
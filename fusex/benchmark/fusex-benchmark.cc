@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <string>
 
 #include "common/Timing.hh"
 #include "common/ShellCmd.hh"
@@ -20,6 +22,7 @@
 #define LOOP_12 10
 #define LOOP_13 10
 #define LOOP_14 100
+#define LOOP_15 100000
 
 int main(int argc, char* argv[])
 {
@@ -564,6 +567,82 @@ int main(int argc, char* argv[])
     COMMONTIMING("rename-circular-loop", &tm);
   }
 
+  // ------------------------------------------------------------------------ //
+  testno = 15;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+
+    // 'ls -l' of a large directory: with readdirplus the attributes arrive
+    // with the listing, compare the lookup/getattr counters of the eosxd
+    // statistics file with 'no-readdirplus' set to 0 and 1
+    if (mkdir("test-ls", S_IRWXU)) {
+      fprintf(stderr, "[test=%03d] mkdir failed\n", testno);
+      exit(testno);
+    }
+
+    for (size_t i = 0; i < LOOP_15; i++) {
+      snprintf(name, sizeof(name), "test-ls/f-%06lu", i);
+      int fd = creat(name, S_IRWXU);
+
+      if (fd < 0) {
+        fprintf(stderr, "[test=%03d] creat failed i=%lu\n", testno, i);
+        exit(testno);
+      }
+
+      close(fd);
+    }
+
+    COMMONTIMING("ls-create-loop", &tm);
+    eos::common::Timing lstm("ls");
+    COMMONTIMING("start", &lstm);
+    DIR* dir = opendir("test-ls");
+    size_t n_entries = 0;
+    size_t n_stats = 0;
+    struct dirent* entry = 0;
+
+    while (dir && (entry = readdir(dir))) {
+      std::string path = std::string("test-ls/") + entry->d_name;
+      n_entries++;
+
+      if (!lstat(path.c_str(), &buf)) {
+        n_stats++;
+      }
+    }
+
+    if (dir) {
+      closedir(dir);
+    }
+
+    COMMONTIMING("stop", &lstm);
+
+    if (n_entries != LOOP_15 + 2) {
+      fprintf(stderr, "[test=%03d] listing has %lu entries\n", testno, n_entries);
+      exit(testno);
+    }
+
+    fprintf(stderr, "[test=%03d] entries=%lu lstat=%lu time=%.02f ms per-entry=%.03f ms\n",
+            testno, n_entries, n_stats, lstm.RealTime(), lstm.RealTime() / n_entries);
+    COMMONTIMING("ls-readdir-lstat", &tm);
+    eos::common::ShellCmd lsl("ls -l test-ls > /dev/null");
+    eos::common::cmd_status rc = lsl.wait(600);
+
+    if (rc.exit_code) {
+      fprintf(stderr, "[test=%03d] ls -l failed\n", testno);
+      exit(testno);
+    }
+
+    COMMONTIMING("ls-l", &tm);
+    eos::common::ShellCmd removethefiles("rm -rf test-ls");
+    rc = removethefiles.wait(600);
+
+    if (rc.exit_code) {
+      fprintf(stderr, "[test=%03d] rm -rf failed\n", testno);
+      exit(testno);
+    }
+
+    COMMONTIMING("ls-delete", &tm);
+  }
 
   tm.Print();
   fprintf(stdout, "realtime = %.02f", tm.RealTime());
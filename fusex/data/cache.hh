@@ -32,8 +32,10 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdCl/XrdClFile.hh"
 #include "xrdclproxy.hh"
+#include "extentmap.hh"
 #include <map>
 #include <string>
+#include <vector>
 
 class cache
 {
@@ -61,6 +63,14 @@ public:
     return 0;
   }
 
+  // ranges of [offset, offset+count) not held by the cache, returns false if
+  // the cache does not keep track of the ranges it holds
+  virtual bool missing(off_t offset, size_t count,
+                       std::vector<extentmap::extent_t>& ranges)
+  {
+    return false;
+  }
+
   virtual int set_attr(const std::string& key, const std::string& value) = 0;
   virtual int attr(const std::string &key, std::string& value) = 0;
 
@@ -36,6 +36,7 @@
 
 
 bufferllmanager data::datax::sBufferManager;
+data::datax::cachestat data::datax::sCacheStat;
 
 /* -------------------------------------------------------------------------- */
 data::data()
@@ -617,7 +618,9 @@ data::datax::WaitPrefetch(fuse_req_t req, bool lock)
       if (status.IsOK())
       {
         eos_info("pre-read done with size=%lu md-size=%lu", mPrefetchHandler->vbuffer().size(), file_size);
-        if ((mPrefetchHandler->vbuffer().size() == file_size) && mFile->file())
+        // the cache keeps track of the ranges it holds, a partial file start
+        // is fine
+        if (mPrefetchHandler->vbuffer().size() && mFile->file())
         {
           ssize_t nwrite = mFile->file()->pwrite(mPrefetchHandler->buffer(), mPrefetchHandler->vbuffer().size(), 0);
           eos_debug("nwb=%lu to local cache", nwrite);
@@ -633,6 +636,111 @@ data::datax::WaitPrefetch(fuse_req_t req, bool lock)
   }
 }
 
+/* -------------------------------------------------------------------------- */
+XrdCl::XRootDStatus
+/* -------------------------------------------------------------------------- */
+data::datax::cache_read(XrdCl::Proxy* proxy, off_t offset, uint32_t size,
+                        char* buf, uint32_t& bytesRead, uint32_t& localRead,
+                        bool populate)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<extentmap::extent_t> ranges;
+  XrdCl::XRootDStatus status;
+  bytesRead = 0;
+  localRead = 0;
+
+  bool tracked = (mFile->file() && mFile->file()->missing(offset, size,
+                  ranges));
+
+  if (!tracked || ((ranges.size() == 1) && (ranges[0].first == offset) &&
+                   (ranges[0].second == size))) {
+    // nothing of the range is cached
+    status = proxy->Read(offset, size, buf, bytesRead);
+
+    if (status.IsOK() && tracked && populate && bytesRead) {
+      mFile->file()->pwrite(buf, bytesRead, offset);
+    }
+
+    return status;
+  }
+
+  eos_debug("offset=%lu size=%u missing-ranges=%lu", offset, size,
+            ranges.size());
+  // fetch the missing ranges in parallel
+  std::vector<XrdCl::Proxy::read_handler> handlers;
+
+  for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+    XrdCl::Proxy::read_handler handler =
+      std::make_shared<XrdCl::Proxy::ReadAsyncHandler>(proxy, it->first,
+          it->second);
+    status = proxy->PreReadAsync(it->first, it->second, handler, 0);
+
+    if (!status.IsOK()) {
+      break;
+    }
+
+    handlers.push_back(handler);
+  }
+
+  bool complete = status.IsOK();
+  // fill the ranges in between from the cache
+  off_t pos = offset;
+
+  for (size_t i = 0; complete && (i <= ranges.size()); ++i) {
+    off_t stop = (i < ranges.size()) ? ranges[i].first : (off_t)(offset + size);
+
+    if (stop > pos) {
+      ssize_t nread = mFile->file()->pread(buf + (pos - offset), stop - pos, pos);
+
+      if (nread != (ssize_t)(stop - pos)) {
+        // the cache changed in the meanwhile
+        complete = false;
+      }
+
+      localRead += (nread > 0) ? nread : 0;
+    }
+
+    if (i < ranges.size()) {
+      pos = ranges[i].first + ranges[i].second;
+    }
+  }
+
+  // a short remote range is the end of the file
+  uint32_t end = size;
+
+  for (size_t i = 0; i < handlers.size(); ++i) {
+    XrdCl::XRootDStatus rstatus = proxy->WaitRead(handlers[i]);
+
+    if (!rstatus.IsOK()) {
+      status = rstatus;
+      complete = false;
+      continue;
+    }
+
+    size_t nread = handlers[i]->vbuffer().size();
+    memcpy(buf + (ranges[i].first - offset), handlers[i]->buffer(), nread);
+
+    if (nread < ranges[i].second) {
+      end = std::min(end, (uint32_t)(ranges[i].first - offset + nread));
+    }
+
+    if (populate && nread) {
+      mFile->file()->pwrite(handlers[i]->buffer(), nread, ranges[i].first);
+    }
+  }
+
+  if (!complete) {
+    eos_warning("partial cache read failed, reading remote offset=%lu size=%u",
+                offset, size);
+    localRead = 0;
+    return proxy->Read(offset, size, buf, bytesRead);
+  }
+
+  bytesRead = end;
+  localRead = std::min(localRead, end);
+  return status;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 /* -------------------------------------------------------------------------- */
@@ -1488,6 +1596,7 @@ data::datax::pread(fuse_req_t req, void* buf, size_t count, off_t offset)
 
   if (br == (ssize_t) count) {
     mLock.UnLock();
+    sCacheStat.account(br, 0);
     return br;
   }
 
@@ -1504,6 +1613,7 @@ data::datax::pread(fuse_req_t req, void* buf, size_t count, off_t offset)
       }
 
       if (br == (ssize_t) count) {
+        sCacheStat.account(0, br);
         return br;
       }
     } else {
@@ -1526,6 +1636,7 @@ data::datax::pread(fuse_req_t req, void* buf, size_t count, off_t offset)
 
   if ((br + jr) == (ssize_t) count) {
     mLock.UnLock();
+    sCacheStat.account(br + jr, 0);
     return (br + jr);
   }
 
@@ -1542,12 +1653,14 @@ data::datax::pread(fuse_req_t req, void* buf, size_t count, off_t offset)
     }
 
     uint32_t bytesRead = 0;
+    uint32_t localRead = 0;
 
-    if (proxy->Read(offset + br ,
-                    count - br ,
-                    (char*) buf + br ,
-                    bytesRead).IsOK()) {
+    if (cache_read(proxy, offset + br ,
+                   count - br ,
+                   (char*) buf + br ,
+                   bytesRead, localRead, !mFile->has_xrdiorw(req)).IsOK()) {
       mLock.UnLock();
+      sCacheStat.account(br + localRead, bytesRead - localRead);
       std::vector<journalcache::chunk_t> chunks;
 
       if (mFile->journal()) {
@@ -1599,9 +1712,13 @@ data::datax::pwrite(fuse_req_t req, const void* buf, size_t count, off_t offset)
   ssize_t dw = 0 ;
 
   if (mFile->file()) {
-    if (mFile->file()->size() || (mFlags & O_CREAT))
+    std::vector<extentmap::extent_t> ranges;
+
+    if (mFile->file()->size() || (mFlags & O_CREAT) ||
+        mFile->file()->missing(offset, count, ranges))
     {
       // don't write into the file start cache, if it is currently empty and it is not a newly created file
+      // - a cache tracking its valid ranges takes every write
       dw = mFile->file()->pwrite(buf, count, offset);
     }
   }
@@ -1735,6 +1852,7 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
     }
 
     if ((br == (ssize_t) count) || (br == (ssize_t) mMd->size())) {
+      sCacheStat.account(br, 0);
       return br;
     }
   }
@@ -1749,6 +1867,7 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
       }
 
       if (br == (ssize_t) count) {
+        sCacheStat.account(0, br);
         return br;
       }
     }
@@ -1765,6 +1884,7 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
     }
 
     if ((br + jr) == (ssize_t) count) {
+      sCacheStat.account(br + jr, 0);
       return (br + jr);
     }
   }
@@ -1814,14 +1934,15 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
     }
 
     uint32_t bytesRead = 0;
+    uint32_t localRead = 0;
     int recovery = 0;
 
     do {
       proxy = mFile->has_xrdioro(req) ? mFile->xrdioro(req) : mFile->xrdiorw(req); // recovery might change the proxy object
-      status = proxy->Read(offset + br + jr,
-			   count - br - jr,
-			   (char*) buf + br + jr,
-			   bytesRead);
+      status = cache_read(proxy, offset + br + jr,
+                          count - br - jr,
+                          (char*) buf + br + jr,
+                          bytesRead, localRead, !mFile->has_xrdiorw(req));
     } while (!status.IsOK() && (!(recovery = TryRecovery(req, false))));
 
     if (recovery)
@@ -1832,6 +1953,7 @@ data::datax::peek_pread(fuse_req_t req, char*& buf, size_t count, off_t offset)
     }
 
     if (status. IsOK()) {
+      sCacheStat.account(br + jr + localRead, bytesRead - localRead);
       std::vector<journalcache::chunk_t> chunks;
 
       if (mFile->journal()) {
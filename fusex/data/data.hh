@@ -126,6 +126,12 @@ public:
     void WaitPrefetch(fuse_req_t req, bool lock = true);
     void WaitOpen();
 
+    // remote read serving the ranges held by the file cache locally
+    XrdCl::XRootDStatus cache_read(XrdCl::Proxy* proxy, off_t offset,
+                                   uint32_t size, char* buf,
+                                   uint32_t& bytesRead, uint32_t& localRead,
+                                   bool populate);
+
 
     // IO recovery functions
     int TryRecovery(fuse_req_t req, bool is_write);
@@ -171,6 +177,41 @@ public:
 
     static bufferllmanager sBufferManager;
 
+    // read statistics of the file cache
+    struct cachestat {
+      std::atomic<uint64_t> hit_reads; // served only from the cache
+      std::atomic<uint64_t> partial_reads; // served partially from the cache
+      std::atomic<uint64_t> miss_reads; // served only remote
+      std::atomic<uint64_t> local_bytes;
+      std::atomic<uint64_t> remote_bytes;
+
+      cachestat() : hit_reads(0), partial_reads(0), miss_reads(0),
+        local_bytes(0), remote_bytes(0) {}
+
+      void account(uint64_t local, uint64_t remote)
+      {
+        if (!remote) {
+          hit_reads++;
+        } else if (local) {
+          partial_reads++;
+        } else {
+          miss_reads++;
+        }
+
+        local_bytes += local;
+        remote_bytes += remote;
+      }
+
+      // percentage of the bytes served from the cache
+      double hit_ratio()
+      {
+        uint64_t total = local_bytes + remote_bytes;
+        return total ? 100.0 * local_bytes / total : 0;
+      }
+    } ;
+
+    static cachestat sCacheStat;
+
     bool simulate_write_error_in_flusher() 
     {
       return mSimulateWriteErrorInFlusher;
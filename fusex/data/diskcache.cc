@@ -26,6 +26,7 @@
 #include "common/Logging.hh"
 #include "common/Path.hh"
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #ifdef __APPLE__
 #define EKEYEXPIRED 127
@@ -38,6 +39,73 @@ std::string diskcache::sLocation;
 bufferllmanager diskcache::sBufferManager;
 off_t diskcache::sMaxSize = 2 * 1024 * 1024ll;
 shared_ptr<dircleaner> diskcache::sDirCleaner;
+XrdSysMutex diskcache::sLruMutex;
+diskcache::lru_list_t diskcache::sLru;
+std::map<diskcache::lru_block_t, diskcache::lru_entry_t> diskcache::sLruIndex;
+std::set<fuse_ino_t> diskcache::sLruAttached;
+std::atomic<uint64_t> diskcache::sLruBytes(0);
+std::atomic<uint64_t> diskcache::sLruEvictedBytes(0);
+uint64_t diskcache::sLruMaxBytes = 0;
+const size_t diskcache::sMaxExtents;
+const off_t diskcache::sLruBlockSize;
+const size_t diskcache::sCoalesceGap;
+
+// extended attribute keeping the valid ranges of a cache file
+static const char* sExtentAttr = "user.eos.cache.extents";
+
+/* -------------------------------------------------------------------------- */
+static int
+/* -------------------------------------------------------------------------- */
+get_extents(int fd, extentmap& extents)
+/* -------------------------------------------------------------------------- */
+{
+  std::string value;
+  value.resize(4096);
+  ssize_t n = 0;
+#ifdef __APPLE__
+  n = fgetxattr(fd, sExtentAttr, (void*) value.c_str(), value.size(), 0 , 0);
+#else
+  n = fgetxattr(fd, sExtentAttr, (void*) value.c_str(), value.size());
+#endif
+
+  if (n < 0) {
+    extents.clear();
+    return -1;
+  }
+
+  value.resize(n);
+  return extents.load(value) ? 0 : -1;
+}
+
+/* -------------------------------------------------------------------------- */
+static int
+/* -------------------------------------------------------------------------- */
+set_extents(int fd, const extentmap& extents)
+/* -------------------------------------------------------------------------- */
+{
+  std::string value = extents.dump();
+#ifdef __APPLE__
+  return fsetxattr(fd, sExtentAttr, value.c_str(), value.size(), 0, 0);
+#else
+  return fsetxattr(fd, sExtentAttr, value.c_str(), value.size(), 0);
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+static void
+/* -------------------------------------------------------------------------- */
+punch_hole(int fd, off_t offset, size_t count)
+/* -------------------------------------------------------------------------- */
+{
+  // release the disk space, the range is not valid anymore in any case
+#ifndef __APPLE__
+
+  if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, count)) {
+    eos_static_debug("punch hole failed errno=%d", errno);
+  }
+
+#endif
+}
 
 /* -------------------------------------------------------------------------- */
 int
@@ -71,6 +139,9 @@ diskcache::init_daemonized(const cacheconfig& config)
   sDirCleaner = std::make_shared<dircleaner>(config.location,
                 config.total_file_cache_size);
   sDirCleaner->set_trim_suffix(".dc");
+  // the extent LRU keeps the cached ranges within the same budget, the
+  // dircleaner trims files which were not attached since the start
+  sLruMaxBytes = config.total_file_cache_size;
 
   if (config.clean_on_startup) {
     eos_static_info("cleaning cache path=%s", config.location.c_str());
@@ -106,6 +177,14 @@ diskcache::~diskcache()
 int
 diskcache::location(std::string& path, bool mkpath)
 /* -------------------------------------------------------------------------- */
+{
+  return location(ino, path, mkpath);
+}
+
+/* -------------------------------------------------------------------------- */
+int
+diskcache::location(fuse_ino_t ino, std::string& path, bool mkpath)
+/* -------------------------------------------------------------------------- */
 {
   char cache_path[1024 + 20];
   snprintf(cache_path, sizeof(cache_path), "%s/%08lx/%08lX.dc",
@@ -140,6 +219,12 @@ diskcache::attach(fuse_req_t req, std::string& acookie, int flag)
       return rc;
     }
 
+    {
+      // from now on the LRU leaves the cache file to us
+      XrdSysMutexHelper lruLock(sLruMutex);
+      sLruAttached.insert(ino);
+    }
+
     if (stat(path.c_str(), &attachstat)) {
       // a new file
       sDirCleaner->get_external_tree().change(0, 1);
@@ -149,8 +234,19 @@ diskcache::attach(fuse_req_t req, std::string& acookie, int flag)
     fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRWXU);
 
     if (fd < 0) {
-      return -errno;
+      rc = -errno;
+      XrdSysMutexHelper lruLock(sLruMutex);
+      sLruAttached.erase(ino);
+      return rc;
+    }
+
+    // a file without extent information is considered empty
+    get_extents(fd, extents);
+    {
+      XrdSysMutexHelper lruLock(sLruMutex);
+      forget_nolru();
     }
+    touch(0, extents.count() ? sMaxSize : 0, true);
   }
 
   std::string ccookie;
@@ -166,7 +262,7 @@ diskcache::attach(fuse_req_t req, std::string& acookie, int flag)
       eos_static_debug("diskcache::attach truncating for cookie: %s <=> %s\n",
                        ccookie.c_str(), acookie.c_str());
 
-      if (truncate(0)) {
+      if (truncate_nolock(0)) {
         char msg[1024];
         snprintf(msg, sizeof(msg),
                  "failed to truncate to invalidate cache file - ino=%08lx", ino);
@@ -195,6 +291,8 @@ diskcache::detach(std::string& cookie)
 
   if (!nattached)
   {
+    store_extents();
+
     if (fstat(fd, &detachstat))
     {
       return errno;
@@ -203,6 +301,10 @@ diskcache::detach(std::string& cookie)
     int rc = close(fd);
     
     fd = -1;
+    {
+      XrdSysMutexHelper lruLock(sLruMutex);
+      sLruAttached.erase(ino);
+    }
 
     if (rc) {
       return errno;
@@ -218,6 +320,12 @@ int
 diskcache::unlink()
 /* -------------------------------------------------------------------------- */
 {
+  {
+    XrdSysMutexHelper lLock(mMutex);
+    extents.clear();
+    XrdSysMutexHelper lruLock(sLruMutex);
+    forget_nolru();
+  }
   std::string path;
   int rc = location(path);
 
@@ -245,6 +353,7 @@ diskcache::pread(void* buf, size_t count, off_t offset)
 /* -------------------------------------------------------------------------- */
 {
   eos_static_debug("diskcache::pread %lu %lu\n", count, offset);
+  XrdSysMutexHelper lLock(mMutex);
 
   // restrict to our local max size cache size
   if (offset >= sMaxSize) {
@@ -255,7 +364,20 @@ diskcache::pread(void* buf, size_t count, off_t offset)
     count = sMaxSize - offset;
   }
 
-  return ::pread(fd, buf, count, offset);
+  // return only the valid range starting at offset
+  count = extents.valid(offset, count);
+
+  if (!count) {
+    return 0;
+  }
+
+  ssize_t nread = ::pread(fd, buf, count, offset);
+
+  if (nread > 0) {
+    touch(offset, nread, false);
+  }
+
+  return nread;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -264,6 +386,7 @@ diskcache::pwrite(const void* buf, size_t count, off_t offset)
 /* -------------------------------------------------------------------------- */
 {
   eos_static_debug("diskcache::pwrite %lu %lu\n", count, offset);
+  XrdSysMutexHelper lLock(mMutex);
 
   if ((off_t) offset >= sMaxSize) {
     return 0;
@@ -273,7 +396,24 @@ diskcache::pwrite(const void* buf, size_t count, off_t offset)
     count = sMaxSize - offset;
   }
 
-  return ::pwrite(fd, buf, count, offset);
+  ssize_t nwrite = ::pwrite(fd, buf, count, offset);
+
+  if (nwrite > 0) {
+    extents.add(offset, nwrite);
+
+    if (extents.count() > sMaxExtents) {
+      // keep the extent map bounded, give up the smallest extent
+      extentmap::extent_t small = extents.smallest();
+      extents.remove(small.first, small.second);
+      punch_hole(fd, small.first, small.second);
+      store_extents();
+      touch(small.first, small.second, true);
+    }
+
+    touch(offset, nwrite, true);
+  }
+
+  return nwrite;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -281,6 +421,16 @@ int
 /* -------------------------------------------------------------------------- */
 diskcache::truncate(off_t offset)
 /* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+  return truncate_nolock(offset);
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+diskcache::truncate_nolock(off_t offset)
+/* -------------------------------------------------------------------------- */
 {
   eos_static_debug( "diskcache::truncate %lu\n", offset);
 
@@ -303,6 +453,9 @@ diskcache::truncate(off_t offset)
     attachstat.st_size = offset;
   }
 
+  extents.truncate(offset);
+  store_extents();
+  touch(offset, sMaxSize - offset, true);
   return rc;
 }
 
@@ -312,6 +465,8 @@ int
 diskcache::sync()
 /* -------------------------------------------------------------------------- */
 {
+  XrdSysMutexHelper lLock(mMutex);
+  store_extents();
   return ::fdatasync(fd);
 }
 
@@ -321,16 +476,12 @@ size_t
 diskcache::size()
 /* -------------------------------------------------------------------------- */
 {
-  struct stat buf;
-  buf.st_size = 0;
+  XrdSysMutexHelper lLock(mMutex);
 
   if (fd>0)
   {
-    if (::fstat(fd, &buf)) {
-      throw std::runtime_error("diskcache stat failure");
-    }
-
-    return buf.st_size;
+    // the size of the valid file start
+    return extents.valid(0, sMaxSize);
   }
   else
   {
@@ -338,6 +489,168 @@ diskcache::size()
   }  
 }
 
+/* -------------------------------------------------------------------------- */
+bool
+/* -------------------------------------------------------------------------- */
+diskcache::missing(off_t offset, size_t count,
+                   std::vector<extentmap::extent_t>& ranges)
+/* -------------------------------------------------------------------------- */
+{
+  XrdSysMutexHelper lLock(mMutex);
+
+  if (offset >= sMaxSize) {
+    return false;
+  }
+
+  extents.missing(offset, count, sCoalesceGap, ranges);
+  return true;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+diskcache::store_extents()
+/* -------------------------------------------------------------------------- */
+{
+  if (fd > 0) {
+    return set_extents(fd, extents);
+  }
+
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+diskcache::touch(off_t offset, size_t count, bool changed)
+/* -------------------------------------------------------------------------- */
+{
+  if (!count) {
+    return;
+  }
+
+  XrdSysMutexHelper lruLock(sLruMutex);
+
+  for (off_t block = offset / sLruBlockSize;
+       block * sLruBlockSize < (off_t)(offset + count); ++block) {
+    lru_block_t key(ino, block);
+    auto it = sLruIndex.find(key);
+    size_t bytes = (changed || (it == sLruIndex.end())) ?
+                   extents.bytes(block * sLruBlockSize, sLruBlockSize) : it->second.bytes;
+
+    if (it == sLruIndex.end()) {
+      if (bytes) {
+        sLru.push_front(key);
+        sLruIndex[key] = lru_entry_t{sLru.begin(), bytes};
+        sLruBytes += bytes;
+      }
+
+      continue;
+    }
+
+    sLruBytes -= it->second.bytes;
+
+    if (!bytes) {
+      sLru.erase(it->second.pos);
+      sLruIndex.erase(it);
+      continue;
+    }
+
+    sLruBytes += bytes;
+    it->second.bytes = bytes;
+    sLru.splice(sLru.begin(), sLru, it->second.pos);
+  }
+
+  evict_nolru();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+diskcache::evict_nolru()
+/* -------------------------------------------------------------------------- */
+{
+  if (!sLruMaxBytes) {
+    return;
+  }
+
+  bool stored = true;
+
+  // look at every block at most once, attached files of others are skipped
+  for (size_t n = sLru.size(); n && (sLruBytes > sLruMaxBytes); --n) {
+    lru_block_t key = sLru.back();
+    auto it = sLruIndex.find(key);
+    off_t offset = key.second * sLruBlockSize;
+
+    if (key.first == ino) {
+      extents.remove(offset, sLruBlockSize);
+      punch_hole(fd, offset, sLruBlockSize);
+      stored = false;
+    } else if (sLruAttached.count(key.first)) {
+      sLru.splice(sLru.begin(), sLru, it->second.pos);
+      continue;
+    } else {
+      evict_file_nolru(key.first, offset, sLruBlockSize);
+    }
+
+    eos_static_debug("evicted ino=%08lx offset=%ld bytes=%lu", key.first, offset,
+                     it->second.bytes);
+    sLruBytes -= it->second.bytes;
+    sLruEvictedBytes += it->second.bytes;
+    sLru.pop_back();
+    sLruIndex.erase(it);
+  }
+
+  if (!stored) {
+    store_extents();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+diskcache::forget_nolru()
+/* -------------------------------------------------------------------------- */
+{
+  for (auto it = sLruIndex.lower_bound(lru_block_t(ino, 0));
+       (it != sLruIndex.end()) && (it->first.first == ino);) {
+    sLruBytes -= it->second.bytes;
+    sLru.erase(it->second.pos);
+    it = sLruIndex.erase(it);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+diskcache::evict_file_nolru(fuse_ino_t ino, off_t offset, size_t count)
+/* -------------------------------------------------------------------------- */
+{
+  // the file is not attached, sLruMutex keeps it like this
+  std::string path;
+
+  if (location(ino, path, false)) {
+    return;
+  }
+
+  int efd = open(path.c_str(), O_RDWR);
+
+  if (efd < 0) {
+    // already removed by the dircleaner
+    return;
+  }
+
+  extentmap fextents;
+
+  if (!get_extents(efd, fextents)) {
+    fextents.remove(offset, count);
+    punch_hole(efd, offset, count);
+    set_extents(efd, fextents);
+  }
+
+  close(efd);
+}
+
 /* -------------------------------------------------------------------------- */
 int
 /* -------------------------------------------------------------------------- */
@@ -32,8 +32,12 @@
 #include "data/cache.hh"
 #include "data/dircleaner.hh"
 #include "data/cacheconfig.hh"
+#include "data/extentmap.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <atomic>
+#include <list>
 #include <map>
+#include <set>
 #include <string>
 
 class diskcache : public cache
@@ -70,11 +74,46 @@ public:
     return sMaxSize;
   }
 
+  virtual bool missing(off_t offset, size_t count,
+                       std::vector<extentmap::extent_t>& ranges) override;
+
+  // bytes of all extents accounted in the LRU
+  static uint64_t extent_bytes()
+  {
+    return sLruBytes;
+  }
+
+  // bytes evicted by the LRU
+  static uint64_t evicted_bytes()
+  {
+    return sLruEvictedBytes;
+  }
+
+  // maximum number of extents of a cache file
+  static const size_t sMaxExtents = 128;
+  // granularity of the extent LRU
+  static const off_t sLruBlockSize = 1024 * 1024ll;
+  // missing ranges closer than this are fetched with a single read
+  static const size_t sCoalesceGap = 64 * 1024;
+
 private:
   XrdSysMutex mMutex;
   int location(std::string& path, bool mkpath = true);
+  static int location(fuse_ino_t ino, std::string& path, bool mkpath = true);
   static off_t sMaxSize;
 
+  int truncate_nolock(off_t);
+  int store_extents();
+
+  // account the extents of [offset, offset+count) in the LRU and evict the
+  // least recently used blocks beyond the global budget
+  void touch(off_t offset, size_t count, bool changed);
+  void evict_nolru();
+  void forget_nolru();
+  static void evict_file_nolru(fuse_ino_t ino, off_t offset, size_t count);
+
+  extentmap extents; // valid ranges of the cache file
+
   fuse_ino_t ino;
   size_t nattached;
   int fd;
@@ -89,6 +128,21 @@ private:
 
   static shared_ptr<dircleaner> sDirCleaner;
 
+  typedef std::pair<fuse_ino_t, off_t> lru_block_t; // inode, block index
+  typedef std::list<lru_block_t> lru_list_t; // most recently used first
+
+  struct lru_entry_t {
+    lru_list_t::iterator pos;
+    size_t bytes;
+  } ;
+
+  static XrdSysMutex sLruMutex;
+  static lru_list_t sLru;
+  static std::map<lru_block_t, lru_entry_t> sLruIndex;
+  static std::set<fuse_ino_t> sLruAttached; // cache files attached right now
+  static std::atomic<uint64_t> sLruBytes;
+  static std::atomic<uint64_t> sLruEvictedBytes;
+  static uint64_t sLruMaxBytes;
 } ;
 
 #endif /* FUSE_JOURNALCACHE_HH_ */
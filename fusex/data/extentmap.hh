@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------------
+//! @file extentmap.hh
+//! @brief map of the valid byte ranges of a sparse cache file
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef FUSE_EXTENTMAP_HH_
+#define FUSE_EXTENTMAP_HH_
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ordered set of non-overlapping [offset, end) ranges holding valid data,
+// touching or overlapping ranges are merged when they are added
+
+class extentmap
+{
+public:
+  // offset, size
+  typedef std::pair<off_t, size_t> extent_t;
+
+  extentmap() : nbytes(0) { }
+
+  // mark [offset, offset + size) as valid
+  void add(off_t offset, size_t size)
+  {
+    if (!size) {
+      return;
+    }
+
+    off_t start = offset;
+    off_t end = offset + size;
+    auto it = first(start, true);
+
+    while ((it != extents.end()) && (it->first <= end)) {
+      start = std::min(start, it->first);
+      end = std::max(end, it->second);
+      nbytes -= it->second - it->first;
+      it = extents.erase(it);
+    }
+
+    extents[start] = end;
+    nbytes += end - start;
+  }
+
+  // mark [offset, offset + size) as invalid
+  void remove(off_t offset, size_t size)
+  {
+    if (!size) {
+      return;
+    }
+
+    off_t end = offset + size;
+    auto it = first(offset, false);
+
+    while ((it != extents.end()) && (it->first < end)) {
+      off_t s = it->first;
+      off_t e = it->second;
+      nbytes -= e - s;
+      it = extents.erase(it);
+
+      if (s < offset) {
+        extents[s] = offset;
+        nbytes += offset - s;
+      }
+
+      if (e > end) {
+        extents[end] = e;
+        nbytes += e - end;
+        break;
+      }
+    }
+  }
+
+  // invalidate everything behind offset
+  void truncate(off_t offset)
+  {
+    remove(offset, std::numeric_limits<off_t>::max() - offset);
+  }
+
+  void clear()
+  {
+    extents.clear();
+    nbytes = 0;
+  }
+
+  // number of contiguous valid bytes starting at offset, at most size
+  size_t valid(off_t offset, size_t size) const
+  {
+    auto it = extents.upper_bound(offset);
+
+    if (it == extents.begin()) {
+      return 0;
+    }
+
+    --it;
+
+    if (it->second <= offset) {
+      return 0;
+    }
+
+    return std::min((off_t) size, it->second - offset);
+  }
+
+  // number of valid bytes in [offset, offset + size)
+  size_t bytes(off_t offset, size_t size) const
+  {
+    off_t end = offset + size;
+    size_t n = 0;
+
+    for (auto it = first(offset, false);
+         (it != extents.end()) && (it->first < end); ++it) {
+      n += std::min(end, it->second) - std::max(offset, it->first);
+    }
+
+    return n;
+  }
+
+  // number of valid bytes
+  size_t bytes() const
+  {
+    return nbytes;
+  }
+
+  // number of extents
+  size_t count() const
+  {
+    return extents.size();
+  }
+
+  // ranges of [offset, offset + size) which are not valid - missing ranges
+  // separated by less than gap valid bytes are merged into one range
+  // returns true if any byte of [offset, offset + size) is valid
+  bool missing(off_t offset, size_t size, size_t gap,
+               std::vector<extent_t>& ranges) const
+  {
+    off_t pos = offset;
+    off_t end = offset + size;
+    bool cached = false;
+    ranges.clear();
+
+    for (auto it = first(offset, false);
+         (it != extents.end()) && (it->first < end); ++it) {
+      cached = true;
+
+      if (it->first > pos) {
+        append(ranges, pos, it->first, gap);
+      }
+
+      pos = std::max(pos, it->second);
+    }
+
+    if (pos < end) {
+      append(ranges, pos, end, gap);
+    }
+
+    return cached;
+  }
+
+  // the smallest extent, (0,0) if empty
+  extent_t smallest() const
+  {
+    extent_t small(0, 0);
+
+    for (auto it = extents.begin(); it != extents.end(); ++it) {
+      if (!small.second || ((size_t)(it->second - it->first) < small.second)) {
+        small = extent_t(it->first, it->second - it->first);
+      }
+    }
+
+    return small;
+  }
+
+  // serialize as '<hex-offset>+<hex-size>,...'
+  std::string dump() const
+  {
+    std::string out;
+    char entry[64];
+
+    for (auto it = extents.begin(); it != extents.end(); ++it) {
+      snprintf(entry, sizeof(entry), "%llx+%llx,", (unsigned long long) it->first,
+               (unsigned long long)(it->second - it->first));
+      out += entry;
+    }
+
+    return out;
+  }
+
+  // parse a dump, the map stays empty if it is not well formed
+  bool load(const std::string& in)
+  {
+    clear();
+    const char* ptr = in.c_str();
+
+    while (*ptr) {
+      char* next = 0;
+      unsigned long long off = strtoull(ptr, &next, 16);
+
+      if (*next != '+') {
+        clear();
+        return false;
+      }
+
+      ptr = next + 1;
+      unsigned long long len = strtoull(ptr, &next, 16);
+
+      if ((*next != ',') || (next == ptr)) {
+        clear();
+        return false;
+      }
+
+      ptr = next + 1;
+      add(off, len);
+    }
+
+    return true;
+  }
+
+private:
+  typedef std::map<off_t, off_t> extent_map_t;
+
+  // first extent ending behind offset, or at offset if touching is true
+  extent_map_t::const_iterator first(off_t offset, bool touching) const
+  {
+    auto it = extents.upper_bound(offset);
+
+    if (it != extents.begin()) {
+      auto prev = std::prev(it);
+
+      if ((prev->second > offset) || (touching && (prev->second == offset))) {
+        return prev;
+      }
+    }
+
+    return it;
+  }
+
+  extent_map_t::iterator first(off_t offset, bool touching)
+  {
+    auto it = static_cast<const extentmap*>(this)->first(offset, touching);
+    return extents.erase(it, it);
+  }
+
+  static void append(std::vector<extent_t>& ranges, off_t start, off_t end,
+                     size_t gap)
+  {
+    if (!ranges.empty() &&
+        ((size_t)(start - ranges.back().first - ranges.back().second) < gap)) {
+      ranges.back().second = end - ranges.back().first;
+    } else {
+      ranges.push_back(extent_t(start, end - start));
+    }
+  }
+
+  extent_map_t extents; // offset => end
+  size_t nbytes;
+} ;
+
+#endif /* FUSE_EXTENTMAP_HH_ */
@@ -76,6 +76,7 @@
 #include "kv/kv.hh"
 #include "data/cache.hh"
 #include "data/cachehandler.hh"
+#include "data/diskcache.hh"
 
 #if ( FUSE_USE_VERSION > 28 )
 #include "EosFuseSessionLoop.hh"
@@ -410,6 +411,10 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       root["options"]["no-xattr"] = 0;
     }
 
+    if (!root["options"].isMember("no-readdirplus")) {
+      root["options"]["no-readdirplus"] = 0;
+    }
+
     if (!root["auth"].isMember("forknoexec-heuristic")) {
       root["auth"]["forknoexec-heuristic"] = 1;
     }
@@ -512,6 +517,12 @@ EosFuse::run(int argc, char* argv[], void* userdata)
       disable_xattr();
     }
 
+    config.options.no_readdirplus = root["options"]["no-readdirplus"].asInt();
+
+    if (config.options.no_readdirplus) {
+      disable_readdirplus();
+    }
+
     config.recovery.read = root["recovery"]["read"].asInt();
     config.recovery.read_open = root["recovery"]["read-open"].asInt();
     config.recovery.read_open_noserver =
@@ -1075,6 +1086,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     fusestat.Add("lookup", 0, 0, 0);
     fusestat.Add("opendir", 0, 0, 0);
     fusestat.Add("readdir", 0, 0, 0);
+    fusestat.Add("readdirplus", 0, 0, 0);
     fusestat.Add("releasedir", 0, 0, 0);
     fusestat.Add("statfs", 0, 0, 0);
     fusestat.Add("mknod", 0, 0, 0);
@@ -1113,7 +1125,7 @@ EosFuse::run(int argc, char* argv[], void* userdata)
     eos_static_warning("zmq-connection         := %s", config.mqtargethost.c_str());
     eos_static_warning("zmq-identity           := %s", config.mqidentity.c_str());
     eos_static_warning("fd-limit               := %lu", config.options.fdlimit);
-    eos_static_warning("options                := md-cache:%d md-enoent:%.02f md-timeout:%.02f data-cache:%d mkdir-sync:%d create-sync:%d symlink-sync:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d locking:%d no-fsync:%s ol-mode:%03o show-tree-size:%d free-md-asap:%d core-affinity:%d no-xattr:%d",
+    eos_static_warning("options                := md-cache:%d md-enoent:%.02f md-timeout:%.02f data-cache:%d mkdir-sync:%d create-sync:%d symlink-sync:%d rename-sync:%d rmdir-sync:%d flush:%d flush-w-open:%d locking:%d no-fsync:%s ol-mode:%03o show-tree-size:%d free-md-asap:%d core-affinity:%d no-xattr:%d no-readdirplus:%d",
                        config.options.md_kernelcache,
                        config.options.md_kernelcache_enoent_timeout,
                        config.options.md_backend_timeout,
@@ -1131,7 +1143,8 @@ EosFuse::run(int argc, char* argv[], void* userdata)
                        config.options.show_tree_size,
                        config.options.free_md_asap,
                        config.options.cpu_core_affinity,
-                       config.options.no_xattr
+                       config.options.no_xattr,
+                       config.options.no_readdirplus
                       );
     eos_static_warning("cache                  := rh-type:%s rh-nom:%d rh-max:%d tot-size=%ld dc-loc:%s jc-loc:%s",
                        cconfig.read_ahead_strategy.c_str(),
@@ -1364,6 +1377,34 @@ EosFuse::DumpStatistic(ThreadAssistant& assistant)
              EosFuse::Instance().config.hostport.c_str()
             );
     sout += ino_stat;
+    std::string s9;
+    std::string s10;
+    std::string s11;
+    std::string s12;
+    snprintf(ino_stat, sizeof(ino_stat),
+             "ALL        rd-cache-hit        := %lu\n"
+             "ALL        rd-cache-partial    := %lu\n"
+             "ALL        rd-cache-miss       := %lu\n"
+             "ALL        rd-cache-local      := %s\n"
+             "ALL        rd-cache-remote     := %s\n"
+             "ALL        rd-cache-hit-ratio  := %.02f %%\n"
+             "ALL        dc-extents          := %s\n"
+             "ALL        dc-evicted          := %s\n"
+             "# -----------------------------------------------------------------------------------------------------------\n",
+             (unsigned long) data::datax::sCacheStat.hit_reads,
+             (unsigned long) data::datax::sCacheStat.partial_reads,
+             (unsigned long) data::datax::sCacheStat.miss_reads,
+             eos::common::StringConversion::GetReadableSizeString(s9,
+                 data::datax::sCacheStat.local_bytes, "b"),
+             eos::common::StringConversion::GetReadableSizeString(s10,
+                 data::datax::sCacheStat.remote_bytes, "b"),
+             data::datax::sCacheStat.hit_ratio(),
+             eos::common::StringConversion::GetReadableSizeString(s11,
+                 diskcache::extent_bytes(), "b"),
+             eos::common::StringConversion::GetReadableSizeString(s12,
+                 diskcache::evicted_bytes(), "b")
+            );
+    sout += ino_stat;
     std::ofstream dumpfile(EosFuse::Instance().config.statfilepath);
     dumpfile << sout;
     assistant.wait_for(std::chrono::seconds(1));
@@ -1895,14 +1936,41 @@ void
 EosFuse::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
                  struct fuse_file_info* fi)
 /* -------------------------------------------------------------------------- */
+{
+  readdir(req, ino, size, off, fi, false);
+}
+
+#ifdef _FUSE3
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+EosFuse::readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                     struct fuse_file_info* fi)
+/* -------------------------------------------------------------------------- */
+/*
+ like readdir, but every entry carries the attributes of the cached child md
+ and counts as a lookup of the child, saving the lookup/getattr per entry
+ */
+{
+  readdir(req, ino, size, off, fi, true);
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+EosFuse::readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                 struct fuse_file_info* fi, bool plus)
+/* -------------------------------------------------------------------------- */
 /*
 EBADF  Invalid directory stream descriptor fi->fh
  */
 {
   eos::common::Timing timing(__func__);
   COMMONTIMING("_start_", &timing);
-  EXEC_TIMING_BEGIN(__func__);
-  ADD_FUSE_STAT(__func__, req);
+  const char* op = plus ? "readdirplus" : "readdir";
+  EXEC_TIMING_BEGIN(op);
+  ADD_FUSE_STAT(op, req);
   int rc = 0;
   fuse_id id(req);
 
@@ -1934,13 +2002,42 @@ EBADF  Invalid directory stream descriptor fi->fh
         }
       }
     }
+    // the kernel may cache the returned entries only as long as the directory
+    // cap guarantees that we get informed about changes
+    double cap_lifetime = 0;
+
+    if (plus) {
+      cap::shared_cap pcap = Instance().caps.get(ino,
+                             cap::capx::getclientid(req));
+      XrdSysMutexHelper cLock(pcap->Locker());
+
+      if (pcap->id() && pcap->valid(false)) {
+        struct timespec ts;
+        ts.tv_sec = pcap->vtime();
+        ts.tv_nsec = pcap->vtime_ns();
+        cap_lifetime = -eos::common::Timing::GetCoarseAgeInNs(&ts, 0) / 1000000000.0;
+      }
+    }
+
     // only one readdir at a time
     XrdSysMutexHelper lLock(md->items_lock);
     auto it = pmd_children.begin();
-    eos_static_info("off=%lu size-%lu", off, pmd_children.size());
+    eos_static_info("off=%lu size-%lu plus=%d", off, pmd_children.size(), plus);
     char b[size];
     char* b_ptr = b;
     off_t b_size = 0;
+    // add an entry to the reply buffer, returns the size the entry needs
+    auto add_entry = [&](const std::string & bname,
+                         struct fuse_entry_param & e) -> size_t {
+#ifdef _FUSE3
+      if (plus) {
+        return fuse_add_direntry_plus(req, b_ptr, size - b_size, bname.c_str(),
+                                      &e, ++off);
+      }
+#endif
+      return fuse_add_direntry(req, b_ptr, size - b_size, bname.c_str(),
+                               &e.attr, ++off);
+    };
 
     // the root directory adds only '.', all other add '.' and '..' for off=0
     if (off == 0) {
@@ -1949,12 +2046,12 @@ EBADF  Invalid directory stream descriptor fi->fh
       fuse_ino_t cino = pmd_id;
       eos_static_debug("list: %08x %s", cino, bname.c_str());
       mode_t mode = pmd_mode;
-      struct stat stbuf;
-      memset(&stbuf, 0, sizeof(struct stat));
-      stbuf.st_ino = cino;
-      stbuf.st_mode = mode;
-      size_t a_size = fuse_add_direntry(req, b_ptr , size - b_size,
-                                        bname.c_str(), &stbuf, ++off);
+      // '.' and '..' are not looked up by readdirplus, ino stays 0
+      struct fuse_entry_param e;
+      memset(&e, 0, sizeof(e));
+      e.attr.st_ino = cino;
+      e.attr.st_mode = mode;
+      size_t a_size = add_entry(bname, e);
       eos_static_info("name=%s ino=%08lx mode=%08x bytes=%u/%u",
                       bname.c_str(), cino, mode, a_size, size - b_size);
       b_ptr += a_size;
@@ -1973,12 +2070,11 @@ EBADF  Invalid directory stream descriptor fi->fh
         }
         std::string bname = "..";
         eos_static_debug("list: %08x %s", cino, bname.c_str());
-        struct stat stbuf;
-        memset(&stbuf, 0, sizeof(struct stat));
-        stbuf.st_ino = cino;
-        stbuf.st_mode = mode;
-        size_t a_size = fuse_add_direntry(req, b_ptr , size - b_size,
-                                          bname.c_str(), &stbuf, ++off);
+        struct fuse_entry_param e;
+        memset(&e, 0, sizeof(e));
+        e.attr.st_ino = cino;
+        e.attr.st_mode = mode;
+        size_t a_size = add_entry(bname, e);
         eos_static_info("name=%s ino=%08lx mode=%08x bytes=%u/%u",
                         bname.c_str(), cino, mode, a_size, size - b_size);
         b_ptr += a_size;
@@ -2007,29 +2103,39 @@ EBADF  Invalid directory stream descriptor fi->fh
       metad::shared_md cmd = Instance().mds.get(req, cino, "" , 0, 0, 0, true);
       eos_static_debug("list: %08x %s (d=%d)", cino, it->first.c_str(),
                        cmd->deleted());
-      mode_t mode;
+      struct fuse_entry_param e;
+      memset(&e, 0, sizeof(e));
       {
         XrdSysMutexHelper cLock(cmd->Locker());
-        mode = cmd->mode();
 
         // skip deleted entries or hidden entries
         if (cmd->deleted()) {
           continue;
         }
+
+        if (plus && (cmd->id() == cino)) {
+          cmd->convert(e);
+          e.attr_timeout = std::min(e.attr_timeout, cap_lifetime);
+          e.entry_timeout = std::min(e.entry_timeout, cap_lifetime);
+        } else {
+          // without a cached child the kernel has to look the entry up
+          e.attr.st_ino = cino;
+          e.attr.st_mode = cmd->mode();
+        }
       }
-      struct stat stbuf;
-      memset(&stbuf, 0, sizeof(struct stat));
-      stbuf.st_ino = cino;
-      stbuf.st_mode = mode;
-      size_t a_size = fuse_add_direntry(req, b_ptr , size - b_size,
-                                        bname.c_str(), &stbuf, ++off);
+      size_t a_size = add_entry(bname, e);
       eos_static_info("name=%s ino=%08lx mode=%08x bytes=%u/%u",
-                      bname.c_str(), cino, mode, a_size, size - b_size);
+                      bname.c_str(), cino, e.attr.st_mode, a_size, size - b_size);
 
       if (a_size > (size - b_size)) {
         break;
       }
 
+      if (e.ino) {
+        // the kernel counts every returned entry as a lookup
+        cmd->lookup_inc();
+      }
+
       // add to the shown list
       md->readdir_items.insert(it->first);
       b_ptr += a_size;
@@ -2045,7 +2151,7 @@ EBADF  Invalid directory stream descriptor fi->fh
     eos_static_debug("size=%lu off=%llu reply-size=%lu", size, off, b_size);
   }
 
-  EXEC_TIMING_END(__func__);
+  EXEC_TIMING_END(op);
   COMMONTIMING("_stop_", &timing);
   eos_static_notice("t(ms)=%.03f %s", timing.RealTime(),
                     dump(id, ino, 0, rc).c_str());
@@ -80,6 +80,14 @@ public:
   static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
                       struct fuse_file_info* fi);
 
+#ifdef _FUSE3
+  static void readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size,
+                          off_t off, struct fuse_file_info* fi);
+#endif
+
+  static void readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                      struct fuse_file_info* fi, bool plus);
+
   static void releasedir(fuse_req_t req, fuse_ino_t ino,
                          struct fuse_file_info* fi);
 
@@ -218,6 +226,7 @@ public:
       int cpu_core_affinity;
       mode_t overlay_mode;
       int no_xattr;
+      int no_readdirplus;
       std::vector<std::string> no_fsync_suffixes;
     } options_t;
     
@@ -100,6 +100,13 @@ protected:
     operations.removexattr = 0;
   }
 
+  void disable_readdirplus()
+  {
+#ifdef _FUSE3
+    operations.readdirplus = 0;
+#endif
+  }
+
   //------------------------------------------------------------------------
   //! Constructor
   //!
@@ -117,6 +124,9 @@ protected:
     operations.opendir = &T::opendir;
     operations.access = &T::access;
     operations.readdir = &T::readdir;
+#ifdef _FUSE3
+    operations.readdirplus = &T::readdirplus;
+#endif
     operations.mkdir = &T::mkdir;
     operations.unlink = &T::unlink;
     operations.rmdir = &T::rmdir;
@@ -0,0 +1,103 @@
+/*
+ * extent-map.cc
+ *
+ ************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/data/extentmap.hh"
+#include <vector>
+#include "gtest/gtest.h"
+
+TEST(ExtentMap, AddRemove)
+{
+  extentmap map;
+  map.add(100, 100);
+  map.add(300, 100);
+  ASSERT_EQ(2u, map.count());
+  ASSERT_EQ(200u, map.bytes());
+  // touching extents are merged
+  map.add(200, 50);
+  ASSERT_EQ(2u, map.count());
+  ASSERT_EQ(250u, map.bytes());
+  // overlapping extents are merged
+  map.add(50, 300);
+  ASSERT_EQ(1u, map.count());
+  ASSERT_EQ(350u, map.bytes());
+  ASSERT_EQ(350u, map.valid(50, 1000));
+  ASSERT_EQ(10u, map.valid(390, 10));
+  ASSERT_EQ(0u, map.valid(400, 10));
+  ASSERT_EQ(0u, map.valid(0, 10));
+  // punching a hole splits the extent
+  map.remove(150, 50);
+  ASSERT_EQ(2u, map.count());
+  ASSERT_EQ(300u, map.bytes());
+  ASSERT_EQ(100u, map.valid(50, 1000));
+  ASSERT_EQ(0u, map.valid(150, 10));
+  ASSERT_EQ(200u, map.valid(200, 1000));
+  ASSERT_EQ(110u, map.bytes(100, 160));
+  map.truncate(250);
+  ASSERT_EQ(150u, map.bytes());
+  ASSERT_EQ(50u, map.valid(200, 1000));
+  map.remove(0, 1000);
+  ASSERT_EQ(0u, map.count());
+  ASSERT_EQ(0u, map.bytes());
+}
+
+TEST(ExtentMap, Missing)
+{
+  extentmap map;
+  std::vector<extentmap::extent_t> ranges;
+  ASSERT_FALSE(map.missing(0, 1000, 0, ranges));
+  ASSERT_EQ(1u, ranges.size());
+  ASSERT_EQ(0, ranges[0].first);
+  ASSERT_EQ(1000u, ranges[0].second);
+  map.add(100, 100);
+  map.add(250, 10);
+  map.add(600, 100);
+  ASSERT_TRUE(map.missing(0, 1000, 0, ranges));
+  ASSERT_EQ(4u, ranges.size());
+  ASSERT_EQ(extentmap::extent_t(0, 100), ranges[0]);
+  ASSERT_EQ(extentmap::extent_t(200, 50), ranges[1]);
+  ASSERT_EQ(extentmap::extent_t(260, 340), ranges[2]);
+  ASSERT_EQ(extentmap::extent_t(700, 300), ranges[3]);
+  // the small extent in between is fetched again instead of a second read
+  ASSERT_TRUE(map.missing(150, 500, 20, ranges));
+  ASSERT_EQ(1u, ranges.size());
+  ASSERT_EQ(extentmap::extent_t(200, 400), ranges[0]);
+  ASSERT_TRUE(map.missing(100, 100, 20, ranges));
+  ASSERT_EQ(0u, ranges.size());
+}
+
+TEST(ExtentMap, DumpLoad)
+{
+  extentmap map;
+
+  for (off_t i = 0; i < 64; ++i) {
+    map.add(i * 4096 * 3, 4096 + i);
+  }
+
+  extentmap copy;
+  ASSERT_TRUE(copy.load(map.dump()));
+  ASSERT_EQ(map.dump(), copy.dump());
+  ASSERT_EQ(map.bytes(), copy.bytes());
+  ASSERT_EQ(extentmap::extent_t(0, 4096), copy.smallest());
+  ASSERT_FALSE(copy.load("10+"));
+  ASSERT_EQ(0u, copy.count());
+  ASSERT_FALSE(copy.load("garbage"));
+  ASSERT_TRUE(copy.load(""));
+}
@@ -28,6 +28,10 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+std::mutex Acl::sCacheMutex;
+std::unordered_map<std::string, std::shared_ptr<const Acl::CompiledAcl>>
+    Acl::sCache;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -81,22 +85,6 @@ void
 Acl::Set(std::string sysacl, std::string useracl,
          eos::common::Mapping::VirtualIdentity& vid, bool allowUserAcl)
 {
-  std::string acl = "";
-
-  if (sysacl.length()) {
-    acl += sysacl;
-  }
-
-  if (allowUserAcl) {
-    if (useracl.length()) {
-      if (sysacl.length()) {
-        acl += ",";
-      }
-
-      acl += useracl;
-    }
-  }
-
   // By default nothing is granted
   mHasAcl = false;
   mCanRead = false;
@@ -111,203 +99,355 @@ Acl::Set(std::string sysacl, std::string useracl,
   mCanDelete = false;
   mCanSetQuota = false;
   mHasEgroup = false;
+  mEgroupPending = false;
   mIsMutable = true;
   mCanArchive = false;
   mCanPrepare = false;
 
+  std::shared_ptr<const CompiledAcl> compiled = Compile(sysacl, useracl,
+      allowUserAcl);
+
+  if (compiled->mRules.size()) {
+    Evaluate(*compiled, vid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the compiled form of an ACL definition
+//------------------------------------------------------------------------------
+std::shared_ptr<const Acl::CompiledAcl>
+Acl::Compile(const std::string& sysacl, const std::string& useracl,
+             bool allowUserAcl)
+{
+  std::string key = sysacl;
+
+  if (allowUserAcl) {
+    key += '\0';
+    key += useracl;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sCacheMutex);
+    auto it = sCache.find(key);
+
+    if (it != sCache.end()) {
+      return it->second;
+    }
+  }
+
+  std::shared_ptr<const CompiledAcl> compiled = DoCompile(sysacl, useracl,
+      allowUserAcl);
+  std::lock_guard<std::mutex> lock(sCacheMutex);
+
+  if (sCache.size() >= sMaxCacheSize) {
+    sCache.clear();
+  }
+
+  sCache[key] = compiled;
+  return compiled;
+}
+
+//------------------------------------------------------------------------------
+// Compile an ACL definition without using the cache
+//------------------------------------------------------------------------------
+std::shared_ptr<const Acl::CompiledAcl>
+Acl::DoCompile(const std::string& sysacl, const std::string& useracl,
+               bool allowUserAcl)
+{
+  std::shared_ptr<CompiledAcl> compiled = std::make_shared<CompiledAcl>();
+  std::string acl = "";
+
+  if (sysacl.length()) {
+    acl += sysacl;
+  }
+
+  if (allowUserAcl) {
+    if (useracl.length()) {
+      if (sysacl.length()) {
+        acl += ",";
+      }
+
+      acl += useracl;
+    }
+  }
+
   // no acl definition
   if (!acl.length()) {
-    return;
+    return compiled;
   }
 
-  int errc = 0;
   std::vector<std::string> rules;
   std::string delimiter = ",";
   eos::common::StringConversion::Tokenize(acl, rules, delimiter);
-  std::vector<std::string>::const_iterator it;
-  XrdOucString sizestring1;
-  XrdOucString sizestring2;
 
-  for (size_t n_gid = 0; n_gid < vid.gid_list.size(); ++n_gid) {
-    gid_t chk_gid = vid.gid_list[n_gid];
+  for (auto it = rules.begin(); it != rules.end(); ++it) {
+    CompiledAcl::Rule rule;
+    std::vector<std::string> entry;
+    eos::common::StringConversion::Tokenize(*it, entry, ":");
+    std::string perms;
 
-    // Only check non-system groups
-    if (chk_gid < 3) {
+    if (!it->compare(0, strlen("egroup:"), "egroup:")) {
+      if (entry.size() < 3) {
+        continue;
+      }
+
+      rule.mKind = CompiledAcl::kEgroup;
+      rule.mName = entry[1];
+      perms = entry[2];
+      compiled->mNeedUserName = true;
+    } else if (!it->compare(0, 2, "u:") || !it->compare(0, 2, "g:")) {
+      // the id is matched as 'u:<id>:' prefix
+      size_t pos = it->find(':', 2);
+
+      if ((pos == std::string::npos) || (pos == 2) || (entry.size() < 3)) {
+        continue;
+      }
+
+      rule.mKind = ((*it)[0] == 'u') ? CompiledAcl::kUser : CompiledAcl::kGroup;
+      rule.mName = it->substr(2, pos - 2);
+      perms = entry[2];
+    } else if (!it->compare(0, 2, "z:")) {
+      // z tag entries have only two fields
+      if (entry.size() < 2) {
+        continue;
+      }
+
+      rule.mKind = CompiledAcl::kZ;
+      perms = (entry.size() < 3) ? entry[1] : entry[2];
+    } else {
       continue;
     }
 
-    std::string userid = eos::common::StringConversion::GetSizeString(sizestring1,
-                         (unsigned long long) vid.uid);
-    std::string groupid = eos::common::StringConversion::GetSizeString(sizestring2,
-                          (unsigned long long) chk_gid);
-    std::string usertag = "u:";
-    usertag += userid;
-    usertag += ":";
-    std::string grouptag = "g:";
-    grouptag += groupid;
-    grouptag += ":";
-    std::string username = eos::common::Mapping::UidToUserName(vid.uid, errc);
+    // ids are numeric if given in canonical decimal form
+    rule.mNumeric = false;
+    rule.mId = 0;
 
-    if (errc) {
-      username = "_INVAL_";
+    if ((rule.mKind == CompiledAcl::kUser) || (rule.mKind == CompiledAcl::kGroup)) {
+      rule.mNumeric = (rule.mName.find_first_not_of("0123456789") ==
+                       std::string::npos) && (rule.mName.length() < 10) &&
+                      ((rule.mName[0] != '0') || (rule.mName.length() == 1));
+
+      if (rule.mNumeric) {
+        rule.mId = strtoul(rule.mName.c_str(), 0, 10);
+      } else if (rule.mKind == CompiledAcl::kUser) {
+        compiled->mNeedUserName = true;
+      } else {
+        compiled->mNeedGroupName = true;
+      }
     }
 
-    std::string groupname = eos::common::Mapping::GidToGroupName(chk_gid, errc);
+    // 'c' and 'q' are only valid if specified as a sysacl
+    bool is_sys = (sysacl.find(*it) != std::string::npos);
+    uint32_t flags = 0;
 
-    if (errc) {
-      groupname = "_INVAL_";
+    if (perms.find('a') != std::string::npos) {
+      flags |= CompiledAcl::kArchive;
     }
 
-    std::string usr_name_tag = "u:";
-    usr_name_tag += username;
-    usr_name_tag += ":";
-    std::string grp_name_tag = "g:";
-    grp_name_tag += groupname;
-    grp_name_tag += ":";
-    std::string ztag = "z:";
-    eos_static_debug("%s %s %s %s", usertag.c_str(), grouptag.c_str(),
-                     usr_name_tag.c_str(), grp_name_tag.c_str());
+    if (perms.find('r') != std::string::npos) {
+      flags |= CompiledAcl::kRead;
+    }
 
-    // Rule interpretation logic
-    for (it = rules.begin(); it != rules.end(); it++) {
-      bool egroupmatch = false;
+    if (perms.find('x') != std::string::npos) {
+      flags |= CompiledAcl::kBrowse;
+    }
 
-      // Check for e-group membership
-      if (!it->compare(0, strlen("egroup:"), "egroup:")) {
-        std::vector<std::string> entry;
-        std::string delimiter = ":";
-        eos::common::StringConversion::Tokenize(*it, entry, delimiter);
+    if (perms.find('p') != std::string::npos) {
+      flags |= CompiledAcl::kPrepare;
+    }
 
-        if (entry.size() < 3) {
-          continue;
-        }
+    if (perms.find("!m") != std::string::npos) {
+      flags |= CompiledAcl::kNotChmod;
+    } else if (perms.find('m') != std::string::npos) {
+      flags |= CompiledAcl::kChmod;
+    }
 
-        egroupmatch = Egroup::Member(username, entry[1]);
-        mHasEgroup = egroupmatch;
+    if (is_sys && (perms.find('c') != std::string::npos)) {
+      flags |= CompiledAcl::kChown;
+    }
+
+    if (perms.find("!d") != std::string::npos) {
+      flags |= CompiledAcl::kNotDelete;
+    }
+
+    if (perms.find("+d") != std::string::npos) {
+      flags |= CompiledAcl::kDelete;
+    }
+
+    if (perms.find("!u") != std::string::npos) {
+      flags |= CompiledAcl::kNotUpdate;
+    }
+
+    if (perms.find("+u") != std::string::npos) {
+      flags |= CompiledAcl::kUpdate;
+    }
+
+    if (perms.find("wo") != std::string::npos) {
+      flags |= CompiledAcl::kWriteOnce;
+    }
+
+    if (perms.find('w') != std::string::npos) {
+      flags |= CompiledAcl::kWrite;
+    }
+
+    if (is_sys && (perms.find('q') != std::string::npos)) {
+      flags |= CompiledAcl::kQuota;
+    }
+
+    if (perms.find('i') != std::string::npos) {
+      flags |= CompiledAcl::kImmutable;
+    }
+
+    rule.mFlags = flags;
+    compiled->mRules.push_back(rule);
+  }
+
+  return compiled;
+}
+
+//------------------------------------------------------------------------------
+// Evaluate compiled rules for a virtual identity
+//------------------------------------------------------------------------------
+void
+Acl::Evaluate(const CompiledAcl& acl,
+              const eos::common::Mapping::VirtualIdentity& vid)
+{
+  int errc = 0;
+  std::string username;
+  std::string groupname;
+  // e-group membership resolved once per rule: -1 unknown, 0 no, 1 yes
+  std::vector<signed char> egroups(acl.mRules.size(), -1);
+
+  if (acl.mNeedUserName) {
+    username = eos::common::Mapping::UidToUserName(vid.uid, errc);
+
+    if (errc) {
+      username = "_INVAL_";
+    }
+  }
+
+  for (size_t n_gid = 0; n_gid < vid.gid_list.size(); ++n_gid) {
+    gid_t chk_gid = vid.gid_list[n_gid];
+
+    // Only check non-system groups
+    if (chk_gid < 3) {
+      continue;
+    }
+
+    if (acl.mNeedGroupName) {
+      groupname = eos::common::Mapping::GidToGroupName(chk_gid, errc);
+
+      if (errc) {
+        groupname = "_INVAL_";
       }
+    }
 
-      // Match 'our' rule
-      if ((!it->compare(0, usertag.length(), usertag)) ||
-          (!it->compare(0, grouptag.length(), grouptag)) ||
-          (!it->compare(0, ztag.length(), ztag)) ||
-          (egroupmatch) ||
-          (!it->compare(0, usr_name_tag.length(), usr_name_tag)) ||
-          (!it->compare(0, grp_name_tag.length(), grp_name_tag))) {
-        std::vector<std::string> entry;
-        std::string delimiter = ":";
-        eos::common::StringConversion::Tokenize(*it, entry, delimiter);
-
-        if (entry.size() < 3) {
-          // z tag entries have only two fields
-          if (it->compare(0, ztag.length(), ztag) || (entry.size() < 2)) {
-            continue;
+    // Rule interpretation logic
+    for (size_t i = 0; i < acl.mRules.size(); ++i) {
+      const CompiledAcl::Rule& rule = acl.mRules[i];
+      bool match = false;
+
+      switch (rule.mKind) {
+      case CompiledAcl::kUser:
+        match = (rule.mNumeric ? (rule.mId == vid.uid) : (rule.mName == username));
+        break;
+
+      case CompiledAcl::kGroup:
+        match = (rule.mNumeric ? (rule.mId == chk_gid) :
+                 (rule.mName == groupname));
+        break;
+
+      case CompiledAcl::kZ:
+        match = true;
+        break;
+
+      case CompiledAcl::kEgroup:
+        if (egroups[i] < 0) {
+          std::string egroup = rule.mName;
+          // never block on the lookup, the namespace is locked
+          Egroup::Status status = Egroup::Query(username, egroup);
+          egroups[i] = (status == Egroup::kMember) ? 1 : 0;
+
+          if (status == Egroup::kPending) {
+            mEgroupPending = true;
           }
-
-          // add an empty entry field
-          entry.resize(3);
-          entry[2] = entry[1];
         }
 
-        // 'a' defines archiving permission
-        if ((entry[2].find('a')) != std::string::npos) {
-          mCanArchive = true;
-          mHasAcl = true;
-        }
+        match = (egroups[i] == 1);
+        mHasEgroup = match;
+        break;
+      }
 
-        // 'r' defines read permission
-        if ((entry[2].find('r')) != std::string::npos) {
-          mCanRead = true;
-          mHasAcl = true;
-        }
+      if (!match || !rule.mFlags) {
+        continue;
+      }
 
-        // 'x' defines browsing permission
-        if ((entry[2].find('x')) != std::string::npos) {
-          mCanBrowse = true;
-          mHasAcl = true;
-        }
+      uint32_t flags = rule.mFlags;
+      mHasAcl = true;
 
-        // 'p' defines workflow permission
-        if ((entry[2].find('p')) != std::string::npos) {
-          mCanPrepare = true;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kArchive) {
+        mCanArchive = true;
+      }
 
-        // 'm' defines mode change permission
-        if ((entry[2].find('m')) != std::string::npos) {
-          if ((entry[2].find("!m")) != std::string::npos) {
-            mCanNotChmod = true;
-          } else {
-            mCanChmod = true;
-          }
+      if (flags & CompiledAcl::kRead) {
+        mCanRead = true;
+      }
 
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kBrowse) {
+        mCanBrowse = true;
+      }
 
-        // 'c' defines owner change permission (for directories)
-        if ((sysacl.find(*it) != std::string::npos) &&
-            ((entry[2].find('c')) != std::string::npos)) {
-          // this is only valid if it is specified as a sysacl
-          mCanChown = true;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kPrepare) {
+        mCanPrepare = true;
+      }
 
-        // '!d' forbids deletion
-        if ((entry[2].find("!d")) != std::string::npos) {
-          // canDelete is true, if deletion has been explicitly allowed by a rule
-          // and in this case we don't forbid deletion even if another rule
-          // says that
-          if (!mCanDelete) {
-            mCanNotDelete = true;
-          }
+      if (flags & CompiledAcl::kNotChmod) {
+        mCanNotChmod = true;
+      }
 
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kChmod) {
+        mCanChmod = true;
+      }
 
-        // '+d' adds deletion
-        if ((entry[2].find("+d")) != std::string::npos) {
-          mCanDelete = true;
-          mCanNotDelete = false;
-          mCanWriteOnce = false;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kChown) {
+        mCanChown = true;
+      }
 
-        // '!u' removes update
-        if ((entry[2].find("!u")) != std::string::npos) {
-          mCanUpdate = false;
-          mHasAcl = true;
-        }
+      // canDelete is true, if deletion has been explicitly allowed by a rule
+      // and in this case we don't forbid deletion even if another rule says so
+      if ((flags & CompiledAcl::kNotDelete) && !mCanDelete) {
+        mCanNotDelete = true;
+      }
 
-        // '+u' adds update
-        if ((entry[2].find("+u")) != std::string::npos) {
-          mCanUpdate = true;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kDelete) {
+        mCanDelete = true;
+        mCanNotDelete = false;
+        mCanWriteOnce = false;
+      }
 
-        // 'wo' defines write once permissions
-        if (((entry[2].find("wo")) != std::string::npos)) {
-          mCanWriteOnce = true;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kNotUpdate) {
+        mCanUpdate = false;
+      }
 
-        // 'w' defines write permissions if 'wo' is not granted
-        if ((!mCanWriteOnce) && (entry[2].find('w')) != std::string::npos) {
-          mCanWrite = true;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kUpdate) {
+        mCanUpdate = true;
+      }
 
-        // 'q' defines quota set permission
-        if (((sysacl.find(*it) != std::string::npos)) &&
-            ((entry[2].find('q')) != std::string::npos)) {
-          // this is only valid if it is specified as a sysacl
-          mCanSetQuota = true;
-          mHasAcl = true;
-        }
+      if (flags & CompiledAcl::kWriteOnce) {
+        mCanWriteOnce = true;
+      }
 
-        // 'i' makes directories immutable
-        if ((entry[2].find('i')) != std::string::npos) {
-          mIsMutable = false;
-          mHasAcl = true;
-        }
+      // 'w' defines write permissions if 'wo' is not granted
+      if ((flags & CompiledAcl::kWrite) && !mCanWriteOnce) {
+        mCanWrite = true;
+      }
+
+      if (flags & CompiledAcl::kQuota) {
+        mCanSetQuota = true;
+      }
+
+      if (flags & CompiledAcl::kImmutable) {
+        mIsMutable = false;
       }
     }
   }
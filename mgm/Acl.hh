@@ -25,7 +25,11 @@
 #include "common/Mapping.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include <sys/types.h>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #define	P_OK	8		/* Test for workflow permission.  */
 
@@ -80,6 +84,58 @@ public:
   //----------------------------------------------------------------------------
   static void ConvertIds(std::string& acl_val, bool to_string = false);
 
+  //----------------------------------------------------------------------------
+  //! ACL rules compiled from the sys.acl and user.acl strings. Only the rules
+  //! which can match an identity are kept, with the permission letters turned
+  //! into a bit mask, so that the evaluation does no string parsing.
+  //----------------------------------------------------------------------------
+  struct CompiledAcl {
+    enum Kind { kUser, kGroup, kZ, kEgroup };
+
+    enum Flag {
+      kArchive = 1 << 0, ///< 'a'
+      kRead = 1 << 1, ///< 'r'
+      kBrowse = 1 << 2, ///< 'x'
+      kPrepare = 1 << 3, ///< 'p'
+      kChmod = 1 << 4, ///< 'm'
+      kNotChmod = 1 << 5, ///< '!m'
+      kChown = 1 << 6, ///< 'c' in a sys.acl rule
+      kNotDelete = 1 << 7, ///< '!d'
+      kDelete = 1 << 8, ///< '+d'
+      kNotUpdate = 1 << 9, ///< '!u'
+      kUpdate = 1 << 10, ///< '+u'
+      kWriteOnce = 1 << 11, ///< 'wo'
+      kWrite = 1 << 12, ///< 'w'
+      kQuota = 1 << 13, ///< 'q' in a sys.acl rule
+      kImmutable = 1 << 14 ///< 'i'
+    };
+
+    struct Rule {
+      Kind mKind; ///< type of the rule
+      bool mNumeric; ///< id given as number
+      uint32_t mId; ///< numeric uid/gid
+      std::string mName; ///< user/group/egroup name
+      uint32_t mFlags; ///< permission bit mask
+    };
+
+    std::vector<Rule> mRules; ///< rules in definition order
+    bool mNeedUserName = false; ///< a rule matches the user name
+    bool mNeedGroupName = false; ///< a rule matches the group name
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the compiled form of an ACL definition. The result is cached by the
+  //! definition strings, so that a modified attribute naturally maps to a new
+  //! entry.
+  //!
+  //! @param sysacl system acl definition string
+  //! @param useracl user acl definition string
+  //! @param allowUserAcl if true the user acl is evaluated as well
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<const CompiledAcl>
+  Compile(const std::string& sysacl, const std::string& useracl,
+          bool allowUserAcl);
+
   //----------------------------------------------------------------------------
   //! Default Constructor
   //----------------------------------------------------------------------------
@@ -87,7 +143,8 @@ public:
     mCanRead(false), mCanWrite(false), mCanWriteOnce(false), mCanUpdate(false),
     mCanBrowse(false), mCanChmod(false), mCanChown(false), mCanNotDelete(false),
     mCanNotChmod(false), mCanDelete(false), mCanSetQuota(false), mHasAcl(false),
-    mHasEgroup(false), mIsMutable(false), mCanArchive(false), mCanPrepare(false)
+    mHasEgroup(false), mEgroupPending(false), mIsMutable(false),
+    mCanArchive(false), mCanPrepare(false)
   {}
 
   //----------------------------------------------------------------------------
@@ -213,6 +270,15 @@ public:
     return mHasEgroup;
   }
 
+  //----------------------------------------------------------------------------
+  //! An egroup rule could not be evaluated since the membership is not known
+  //! yet - the caller should stall the client instead of denying access
+  //----------------------------------------------------------------------------
+  inline bool EgroupPending() const
+  {
+    return mEgroupPending;
+  }
+
   //----------------------------------------------------------------------------
   //! It should not have the 'i' flag to be mutable
   //----------------------------------------------------------------------------
@@ -238,6 +304,25 @@ public:
   }
 
 private:
+  //----------------------------------------------------------------------------
+  //! Compile an ACL definition without using the cache
+  //----------------------------------------------------------------------------
+  static std::shared_ptr<const CompiledAcl>
+  DoCompile(const std::string& sysacl, const std::string& useracl,
+            bool allowUserAcl);
+
+  //----------------------------------------------------------------------------
+  //! Evaluate compiled rules for a virtual identity
+  //----------------------------------------------------------------------------
+  void Evaluate(const CompiledAcl& acl,
+                const eos::common::Mapping::VirtualIdentity& vid);
+
+  static constexpr size_t sMaxCacheSize = 16384; ///< compiled acl cache size
+  static std::mutex sCacheMutex; ///< protects sCache
+  ///! compiled acls keyed by the definition strings
+  static std::unordered_map<std::string, std::shared_ptr<const CompiledAcl>>
+      sCache;
+
   bool mCanRead; ///< acl allows read access
   bool mCanWrite; ///< acl allows write access
   bool mCanWriteOnce; ///< acl allows write-once access (creation, no delete)
@@ -251,6 +336,7 @@ private:
   bool mCanSetQuota; ///< acl allows to set quota
   bool mHasAcl; ///< acl is valid
   bool mHasEgroup; ///< acl contains egroup rule
+  bool mEgroupPending; ///< egroup membership lookup is pending
   bool mIsMutable; ///< acl does not contain the immutable flag
   bool mCanArchive; ///< acl which allows archiving
   bool mCanPrepare; ///< acl which allows triggering workflows
@@ -52,16 +52,19 @@ XrdSysMutex eos::mgm::Converter::gSchedulerMutex;
 XrdScheduler* eos::mgm::Converter::gScheduler;
 XrdSysMutex eos::mgm::Converter::gConverterMapMutex;
 std::map<std::string, Converter*> eos::mgm::Converter::gConverterMap;
+JobQueue eos::mgm::Converter::gQueue("conversion");
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 ConverterJob::ConverterJob(eos::common::FileId::fileid_t fid,
                            const char* conversionlayout,
-                           std::string& convertername):
+                           std::string& convertername,
+                           uint64_t job_id):
   mFid(fid),
   mConversionLayout(conversionlayout),
-  mConverterName(convertername)
+  mConverterName(convertername),
+  mJobId(job_id)
 {
   mProcPath = gOFS->MgmProcConversionPath.c_str();
   mProcPath += "/";
@@ -157,6 +160,15 @@ ConverterJob::DoIt()
   }
   bool success = false;
 
+  // The conversion entry is only created now that the job runs, it is the
+  // target of the transfer and merged into the source file at the end
+  if (mTargetCGI.length() &&
+      gOFS->_touch(mProcPath.c_str(), error, rootvid, 0)) {
+    eos_static_err("msg=\"failed to create conversion entry\" path=\"%s\"",
+                   mProcPath.c_str());
+    mTargetCGI = "";
+  }
+
   if (mTargetCGI.length()) {
     // This is a properly defined job
     eos_static_info("msg=\"conversion layout correct\" fxid=%016x cgi=\"%s\"",
@@ -293,6 +305,7 @@ ConverterJob::DoIt()
     gOFS->MgmStats.Add("ConversionFailed", owner_uid, owner_gid, 1);
   }
 
+  Converter::gQueue.Done(mJobId);
   delete this;
 }
 
@@ -381,16 +394,12 @@ Converter::Convert(void)
   XrdSysTimer sleeper;
   sleeper.Snooze(10);
 
-  // Reset old jobs pending from service restart/crash
-  if (gOFS->MgmMaster.IsMaster()) {
-    ResetJobs();
-  }
+  // Conversion entries created in the proc directory by other tools, by a
+  // previous version or left by a previous master are imported regularly
+  const time_t import_interval = 60;
+  time_t next_import = 0;
 
   // loop forever until cancelled
-  // the conversion fid set points from file id to conversion attribute name in
-  // the parent container of the fid
-  std::map<eos::common::FileId::fileid_t, std::string> lConversionFidMap;
-
   while (1) {
     bool IsSpaceConverter = true;
     bool IsMaster = true;
@@ -424,94 +433,51 @@ Converter::Convert(void)
       FsView::gFsView.ViewMutex.UnLockRead();
     }
     IsMaster = gOFS->MgmMaster.IsMaster();
+    // pick up the jobs queued by the previous master
+    gQueue.SetMaster(IsMaster);
+
+    if (IsMaster && (time(NULL) >= next_import)) {
+      ResetJobs();
+      next_import = time(NULL) + import_interval;
+    } else if (!IsMaster) {
+      // import right away once this MGM becomes the master
+      next_import = 0;
+    }
 
     if (IsMaster && IsSpaceConverter) {
-      if (!lConversionFidMap.size()) {
-        XrdMgmOfsDirectory dir;
-        int listrc = 0;
-        // fill the conversion queue with the existing entries
-        listrc = dir.open(gOFS->MgmProcConversionPath.c_str(), rootvid,
-                          (const char*) 0);
-
-        if (listrc == SFS_OK) {
-          const char* val;
-
-          while ((val = dir.nextEntry())) {
-            XrdOucString sfxid = val;
-
-            if ((sfxid == ".") || (sfxid == "..")) {
-              continue;
-            }
-
-            XrdOucString fxid;
-            XrdOucString conversionattribute;
-            eos_static_info("name=\"%s\"", sfxid.c_str());
-            std::string lFullConversionFilePath =
-              gOFS->MgmProcConversionPath.c_str();
-            lFullConversionFilePath += "/";
-            lFullConversionFilePath += val;
-            struct stat buf;
-
-            if (gOFS->_stat(lFullConversionFilePath.c_str(), &buf, error, rootvid, "")) {
-              continue;
-            }
-
-            if ((buf.st_uid != 0) /* this is a failed or scheduled entry */) {
-              continue;
-            }
-
-            if (StringConversion::SplitKeyValue(sfxid, fxid,
-                                                conversionattribute) &&
-                (eos::common::FileId::Hex2Fid(fxid.c_str())) &&
-                (fxid.length() == 16)) {
-              if (conversionattribute.beginswith(mSpaceName.c_str())) {
-                // This is a valid entry like <fxid>:<attribute> and we add it
-                // to the set if <attribute> starts with our space name!
-                lConversionFidMap[eos::common::FileId::Hex2Fid(fxid.c_str())] =
-                  conversionattribute.c_str();
-
-                // We set owner admin to indicate that this is a scheduled entry
-                if (!gOFS->_chown(lFullConversionFilePath.c_str(), 3, 4, error,
-                                  rootvid, (const char*) 0)) {
-                  eos_static_info("msg=\"tagged scheduled conversion entry with"
-                                  " owner admin\" name=\"%s\"",
-                                  conversionattribute.c_str());
-                } else {
-                  eos_static_err("msg=\"failed to tag with owner admin scheduled"
-                                 " conversion job entry\" name=\"%s\"",
-                                 conversionattribute.c_str());
-                }
-              }
-            } else {
-              eos_static_warning("split=%d fxid=%llu fxid=|%s|length=%u",
-                                 StringConversion::SplitKeyValue(sfxid, fxid,
-                                     conversionattribute),
-                                 eos::common::FileId::Hex2Fid(fxid.c_str()),
-                                 fxid.c_str(), fxid.length());
-
-              // This is an invalid entry not following the <key(016x)>:<value>
-              // syntax - just remove it
-              if (!gOFS->_rem(lFullConversionFilePath.c_str(), error, rootvid,
-                              (const char*) 0)) {
-                eos_static_warning("msg=\"deleted invalid conversion entry\" "
-                                   "name=\"%s\"", val);
-              }
-            }
-          }
-
-          dir.close();
-        } else {
-          eos_static_err("msg=\"failed to list conversion directory\" path=\"%s\"",
-                         gOFS->MgmProcConversionPath.c_str());
+      // Schedule the due conversion jobs of this space, the queue bounds the
+      // number of running jobs
+      std::vector<JobQueue::Job> jobs;
+      gQueue.Dequeue(mSpaceName, (lSpaceTransfers > 0) ? lSpaceTransfers : 0,
+                     jobs);
+
+      for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        XrdOucString sfxid = it->mKey.c_str();
+        XrdOucString fxid;
+        XrdOucString conversionattribute;
+
+        if (!StringConversion::SplitKeyValue(sfxid, fxid, conversionattribute) ||
+            !eos::common::FileId::Hex2Fid(fxid.c_str()) ||
+            (fxid.length() != 16)) {
+          eos_static_warning("msg=\"dropping invalid conversion job\" name=\"%s\"",
+                             it->mKey.c_str());
+          gQueue.Done(it->mId);
+          continue;
         }
+
+        eos_static_info("name=\"%s\"", it->mKey.c_str());
+        ConverterJob* job = new ConverterJob(
+          eos::common::FileId::Hex2Fid(fxid.c_str()), conversionattribute.c_str(),
+          mSpaceName, it->mId);
+        // use the global shared scheduler
+        XrdSysMutexHelper sLock(gSchedulerMutex);
+        gScheduler->Schedule((XrdJob*) job);
+        IncActiveJobs();
       }
 
       eos_static_info("converter is enabled ntx=%d nqueued=%d",
-                      lSpaceTransfers,
-                      lConversionFidMap.size());
+                      lSpaceTransfers, gQueue.GetPending(mSpaceName));
     } else {
-      lConversionFidMap.clear();
-
       if (IsMaster) {
         eos_static_debug("converter is disabled");
       } else {
@@ -519,26 +485,6 @@ Converter::Convert(void)
       }
     }
 
-    // Schedule some conversion jobs if any
-    int nschedule = lSpaceTransfers - mActiveJobs;
-
-    for (int i = 0; i < nschedule; i++) {
-      if (lConversionFidMap.size()) {
-        auto it = lConversionFidMap.begin();
-        ConverterJob* job = new ConverterJob(it->first,
-                                             it->second.c_str(),
-                                             mSpaceName);
-        // use the global shared scheduler
-        XrdSysMutexHelper sLock(gSchedulerMutex);
-        gScheduler->Schedule((XrdJob*) job);
-        IncActiveJobs();
-        // Remove the entry from the conversion map
-        lConversionFidMap.erase(lConversionFidMap.begin());
-      } else {
-        break;
-      }
-    }
-
     XrdSysThread::SetCancelOn();
     // Let some time pass or wait for a notification
     mDoneSignal.Wait(10);
@@ -566,11 +512,12 @@ Converter::PublishActiveJobs()
 }
 
 //------------------------------------------------------------------------------
-// Reset pending conversion entries
+// Move the conversion entries found in the proc directory into the queue
 //------------------------------------------------------------------------------
 void
 Converter::ResetJobs()
 {
+  using eos::common::StringConversion;
   eos::common::Mapping::VirtualIdentity rootvid;
   eos::common::Mapping::Root(rootvid);
   XrdOucErrInfo error;
@@ -583,8 +530,10 @@ Converter::ResetJobs()
 
     while ((val = dir.nextEntry())) {
       XrdOucString sfxid = val;
+      XrdOucString fxid;
+      XrdOucString conversionattribute;
 
-      if ((sfxid == ".") || (sfxid == "..")) {
+      if ((sfxid == ".") || (sfxid == "..") || IsScheduled(val)) {
         continue;
       }
 
@@ -593,13 +542,29 @@ Converter::ResetJobs()
       lFullConversionFilePath += "/";
       lFullConversionFilePath += val;
 
-      if (!gOFS->_chown(lFullConversionFilePath.c_str(), 0, 0, error,
-                        rootvid, (const char*) 0)) {
-        eos_static_info("msg=\"reset scheduled conversion entry with owner "
-                        "root\" name=\"%s\"", lFullConversionFilePath.c_str());
-      } else {
-        eos_static_err("msg=\"failed to reset with owner root scheduled old "
-                       "job entry\" name=\"%s\"", lFullConversionFilePath.c_str());
+      if (StringConversion::SplitKeyValue(sfxid, fxid, conversionattribute) &&
+          (eos::common::FileId::Hex2Fid(fxid.c_str())) &&
+          (fxid.length() == 16)) {
+        if (!conversionattribute.beginswith(mSpaceName.c_str())) {
+          continue;
+        }
+
+        if (!Schedule(val)) {
+          eos_static_err("msg=\"failed to queue old conversion entry\" "
+                         "name=\"%s\"", lFullConversionFilePath.c_str());
+          continue;
+        }
+
+        eos_static_info("msg=\"queued old conversion entry\" name=\"%s\"",
+                        lFullConversionFilePath.c_str());
+      }
+
+      // Invalid entries not following the <key(016x)>:<value> syntax and
+      // queued ones are removed
+      if (gOFS->_rem(lFullConversionFilePath.c_str(), error, rootvid,
+                     (const char*) 0)) {
+        eos_static_err("msg=\"failed to remove old conversion entry\" "
+                       "name=\"%s\"", lFullConversionFilePath.c_str());
       }
     }
   }
@@ -607,4 +572,48 @@ Converter::ResetJobs()
   dir.close();
 }
 
+//------------------------------------------------------------------------------
+// Attach the db of the conversion queue
+//------------------------------------------------------------------------------
+bool
+Converter::OpenQueue(const std::string& db_file,
+                     const std::string& qdb_cluster)
+{
+  if (!qdb_cluster.empty()) {
+    return gQueue.OpenQdb(qdb_cluster);
+  }
+
+  return gQueue.Open(db_file);
+}
+
+//------------------------------------------------------------------------------
+// Queue a conversion job
+//------------------------------------------------------------------------------
+bool
+Converter::Schedule(const std::string& conversion)
+{
+  // The job belongs to the space the conversion layout starts with i.e.
+  // !<fid(016x)!>:!<space[.group]!>#!<layout!>
+  size_t pos = conversion.find(':');
+
+  if (pos == std::string::npos) {
+    eos_static_err("msg=\"illegal conversion job\" name=\"%s\"",
+                   conversion.c_str());
+    return false;
+  }
+
+  std::string space = conversion.substr(pos + 1);
+  space = space.substr(0, space.find_first_of(".#"));
+  return gQueue.Enqueue(space, conversion, "");
+}
+
+//------------------------------------------------------------------------------
+// Check if a conversion job is queued or running
+//------------------------------------------------------------------------------
+bool
+Converter::IsScheduled(const std::string& conversion)
+{
+  return gQueue.IsQueued(conversion);
+}
+
 EOSMGMNAMESPACE_END
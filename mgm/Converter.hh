@@ -27,6 +27,7 @@
 #include "mgm/Namespace.hh"
 #include "common/Logging.hh"
 #include "common/FileId.hh"
+#include "mgm/JobQueue.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "Xrd/XrdJob.hh"
 #include <string>
@@ -48,10 +49,12 @@ public:
   //! @param fid file id of the file to convert
   //! @param conversionlayout string describing the conversion layout to use
   //! @param convertername to be used
+  //! @param job_id id of the job in the conversion queue
   //----------------------------------------------------------------------------
   ConverterJob(eos::common::FileId::fileid_t fid,
                const char* conversionlayout,
-               std::string& convertername);
+               std::string& convertername,
+               uint64_t job_id);
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -71,16 +74,23 @@ private:
   std::string mTargetCGI; ///< target CGI of the conversion job
   XrdOucString mConversionLayout; ///< layout name of the target file
   std::string mConverterName; ///< target space name of the conversion
+  uint64_t mJobId; ///< id of the job in the conversion queue
 };
 
 //------------------------------------------------------------------------------
 //! @brief Class running the file layout conversion service per space
 //!
 //! This class run's an eternal thread per configured space which is responsible
-//! to pick-up conversion
-//! jobs from the directory /eos/../proc/conversion/\n\n
+//! to pick-up conversion jobs of its space from the conversion queue, a
+//! persistent JobQueue stored in the QuarkDB cluster of the MGM, so that a new
+//! master continues with the jobs queued by the previous one. Without a
+//! QuarkDB cluster the queue is stored next to the namespace changelogs and is
+//! local to the master MGM. The proc directory is scanned for new entries
+//! every minute.\n\n
 //! It uses the XrdScheduler class to run third party clients copying files
 //! into the conversion definition files named !<fid(016x)!>:!<conversionlayout!>
+//! in the directory /eos/../proc/conversion/, which are created when the job
+//! starts.
 //! If a third party conversion finished successfully the layout & replica of the
 //! converted temporary file will be merged into the existing file and the
 //! previous layout will be dropped.
@@ -160,15 +170,47 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  //! Reset pending conversion entries
+  //! Move the conversion entries of this space found in the proc directory
+  //! into the conversion queue. They are created by other tools or by a
+  //! previous version, or are the entries of jobs which were running on a
+  //! previous master. Entries of jobs queued or running here are skipped.
   //----------------------------------------------------------------------------
   void ResetJobs();
 
+  //----------------------------------------------------------------------------
+  //! Attach the db of the conversion queue
+  //!
+  //! @param db_file path of the local db
+  //! @param qdb_cluster QuarkDB cluster members, if not empty the queue is
+  //!        stored there instead of the local db
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool OpenQueue(const std::string& db_file,
+                        const std::string& qdb_cluster);
+
+  //----------------------------------------------------------------------------
+  //! Queue a conversion job
+  //!
+  //! @param conversion conversion job name !<fid(016x)!>:!<conversionlayout!>
+  //!
+  //! @return true if queued, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Schedule(const std::string& conversion);
+
+  //----------------------------------------------------------------------------
+  //! Check if a conversion job is queued or running
+  //!
+  //! @param conversion conversion job name !<fid(016x)!>:!<conversionlayout!>
+  //----------------------------------------------------------------------------
+  static bool IsScheduled(const std::string& conversion);
+
   static XrdSysMutex gSchedulerMutex; ///< Used for scheduler singleton
   static XrdScheduler* gScheduler; ///< Scheduler singleton
   static XrdSysMutex gConverterMapMutex; ///< Mutex protecting converter map
   //! Map containing the current allocated converter objects
   static std::map<std::string, Converter*> gConverterMap;
+  static JobQueue gQueue; ///< Queue of the conversion jobs of all spaces
 
 private:
   pthread_t mThread; ///< Thread id
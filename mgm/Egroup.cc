@@ -27,23 +27,47 @@
 #include "common/Logging.hh"
 /*----------------------------------------------------------------------------*/
 #include <ldap.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
 
 
 EOSMGMNAMESPACE_BEGIN
 
-XrdSysMutex Egroup::Mutex;
-std::map < std::string, std::map < std::string, bool > > Egroup::Map;
-std::map < std::string, std::map < std::string, time_t > > Egroup::LifeTime;
-std::deque <std::pair<std::string, std::string > > Egroup::LdapQueue;
-XrdSysCondVar Egroup::mCond;
+std::atomic<bool> Egroup::Shutdown(false);
+std::atomic<bool> Egroup::Running(false);
+std::unordered_map < std::string,
+    std::unordered_map < std::string, Egroup::Entry > > Egroup::Cache;
+eos::common::RWMutex Egroup::CacheMutex;
+std::map < std::string, std::set < std::string > > Egroup::Queue;
+std::mutex Egroup::QueueMutex;
+std::condition_variable Egroup::QueueCond;
+std::mutex Egroup::DirectoryMutex;
+std::string Egroup::DirectoryPath;
+time_t Egroup::DirectoryMtime = 0;
+std::map < std::string, std::set < std::string > > Egroup::Directory;
+std::atomic<unsigned long long> Egroup::NumHits(0);
+std::atomic<unsigned long long> Egroup::NumStale(0);
+std::atomic<unsigned long long> Egroup::NumMisses(0);
+std::atomic<unsigned long long> Egroup::NumPending(0);
+std::atomic<unsigned long long> Egroup::NumRefreshes(0);
+std::atomic<unsigned long long> Egroup::NumResolved(0);
+std::atomic<unsigned long long> Egroup::NumFailed(0);
+std::atomic<unsigned long long> Egroup::RefreshMicroSec(0);
+std::atomic<unsigned long long> Egroup::RefreshMaxMicroSec(0);
+
+/// maximum number of users resolved with one LDAP query
+static const size_t sLdapBatchSize = 100;
+/// lifetime of a non-membership stored after a failed query for a new entry
+static const time_t sFailedCacheTime = 60;
 
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Constructor
  */
 /*----------------------------------------------------------------------------*/
-Egroup::Egroup():
-  mThread(0)
+Egroup::Egroup()
 {}
 
 bool
@@ -57,12 +81,19 @@ Egroup::Start()
 {
   // run an asynchronous refresh thread
   eos_static_info("Start");
-  mThread = 0;
-  XrdSysThread::Run(&mThread, Egroup::StaticRefresh,
-                    static_cast<void*>(this),
-                    XRDSYSTHREAD_HOLD,
-                    "Egroup refresh Thread");
-  return (mThread ? true : false);
+
+  if (getenv("EOS_EGROUP_DIRECTORY")) {
+    SetDirectory(getenv("EOS_EGROUP_DIRECTORY"));
+  }
+
+  if (mThread.joinable()) {
+    return true;
+  }
+
+  Shutdown = false;
+  mThread = std::thread(&Egroup::Refresh, this);
+  Running = true;
+  return true;
 }
 
 void
@@ -75,11 +106,15 @@ Egroup::Stop()
  */
 /*----------------------------------------------------------------------------*/
 {
-  // cancel the asynchronous resfresh thread
-  if (mThread) {
-    XrdSysThread::Cancel(mThread);
-    XrdSysThread::Join(mThread, 0);
-    mThread = 0;
+  // stop the asynchronous refresh thread
+  if (mThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(QueueMutex);
+      Shutdown = true;
+    }
+    QueueCond.notify_all();
+    mThread.join();
+    Running = false;
   }
 }
 
@@ -89,14 +124,42 @@ Egroup::~Egroup()
 /**
  * @brief Destructor
  *
- * We are cancelling and joining the asynchronous prefetch thread here.
+ * We are stopping and joining the asynchronous refresh thread here.
  */
 /*----------------------------------------------------------------------------*/
 {
-  // cancel the asynchronous resfresh thread
   Stop();
 }
 
+/*----------------------------------------------------------------------------*/
+bool
+Egroup::Lookup(const std::string& username, const std::string& egroupname,
+               Entry& entry)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Lookup an egroup/username pair in the cache
+ *
+ * @return true if found
+ */
+/*----------------------------------------------------------------------------*/
+{
+  eos::common::RWMutexReadLock lock(CacheMutex);
+  auto git = Cache.find(egroupname);
+
+  if (git == Cache.end()) {
+    return false;
+  }
+
+  auto uit = git->second.find(username);
+
+  if (uit == git->second.end()) {
+    return false;
+  }
+
+  entry = uit->second;
+  return true;
+}
+
 /*----------------------------------------------------------------------------*/
 bool
 Egroup::Member(std::string& username, std::string& egroupname)
@@ -106,191 +169,113 @@ Egroup::Member(std::string& username, std::string& egroupname)
  * @param username name of the user to check Egroup membership
  * @param egroupname name of Egroup where to look for membership
  *
+ * Unknown entries are resolved synchronously, therefore this must not be
+ * called with the namespace lock held - use Query there.
+ *
  * @return true if member otherwise false
  */
 /*----------------------------------------------------------------------------*/
 {
-  Mutex.Lock();
-  time_t now = time(NULL);
-  bool iscached = false;
-  bool member = false;
-  bool isMember = false;
-
-  if (Map.count(egroupname)) {
-    if (Map[egroupname].count(username)) {
-      member = Map[egroupname][username];
-      time_t age = labs(LifeTime[egroupname][username] - now);
-
-      // we know that user, it has a cached entry which is not too old
-      if (LifeTime[egroupname].count(username) &&
-          (LifeTime[egroupname][username] > now) && (age < EOSEGROUPCACHETIME)) {
-        // that is ok, we can return member or not member from the cache
-        Mutex.UnLock();
-        return member;
-      } else {
-        // we have already an entry, we just schedule an asynchronous update
-        iscached = true;
-      }
-    }
-  }
-
-  Mutex.UnLock();
-  // run the command not in the locked section !!!
-
-  if (!iscached) {
-    eos_static_info("msg=\"lookup\" user=\"%s\" e-group=\"%s\"", username.c_str(),
-                    egroupname.c_str());
-    // run the LDAP query
-    LDAP* ld = NULL;
-    int version = LDAP_VERSION3;
-    // currently hard coded to server name 'lxadp'
-    ldap_initialize(&ld, "ldap://xldap");
+  Entry entry;
 
-    if (ld == NULL) {
-      fprintf(stderr, "error: failed to initialize LDAP\n");
+  if (Lookup(username, egroupname, entry)) {
+    if (entry.lifetime > time(NULL)) {
+      NumHits++;
     } else {
-      (void) ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
-      // the LDAP base
-      std::string sbase = "CN=";
-      sbase += username;
-      sbase += ",OU=Users,Ou=Organic Units,DC=cern,DC=ch";
-      // the LDAP attribute (recursive search)
-      std::string attr = "cn";
-      // the LDAP filter
-      std::string filter;
-      filter = "(memberOf:1.2.840.113556.1.4.1941:=CN=";
-      filter += egroupname;
-      filter += ",OU=e-groups,OU=Workgroups,DC=cern,DC=ch)";
-      char* attrs[2];
-      attrs[0] = (char*) attr.c_str();
-      attrs[1] = NULL;
-      LDAPMessage* res = NULL;
-      struct timeval timeout;
-      timeout.tv_sec = 10;
-      timeout.tv_usec = 0;
-      std::string match = username;
-      eos_static_debug("base=%s attr=%s filter=%s match=%s\n", sbase.c_str(),
-                       attr.c_str(), filter.c_str(), match.c_str());
-      int rc = ldap_search_ext_s(ld, sbase.c_str(), LDAP_SCOPE_SUBTREE,
-                                 filter.c_str(),
-                                 attrs, 0, NULL, NULL,
-                                 &timeout, LDAP_NO_LIMIT, &res);
-
-      if ((rc == LDAP_SUCCESS) && (ldap_count_entries(ld, res) != 0)) {
-        LDAPMessage* e = NULL;
-
-        for (e = ldap_first_entry(ld, res); e != NULL; e = ldap_next_entry(ld, e)) {
-          struct berval** v = ldap_get_values_len(ld, e, attr.c_str());
-
-          if (v != NULL) {
-            int n = ldap_count_values_len(v);
-            int j;
-
-            for (j = 0; j < n; j++) {
-              std::string result = v[ j ]->bv_val;
-              eos_static_info("result=%d %s\n", n, result.c_str());
-
-              if ((result.find(match)) != std::string::npos) {
-                isMember = true;
-              }
-            }
-
-            ldap_value_free_len(v);
-          }
-        }
-      } else {
-        if (rc != LDAP_SUCCESS) {
-          eos_static_warning("member=false user=\"%s\" e-group=\"%s\" "
-                             "cachetime=<stale-information> "
-                             "msg=\"ldap query failed or timed out\"",
-                             username.c_str(),
-                             egroupname.c_str());
-        }
-      }
-
-      ldap_msgfree(res);
-
-      if (ld != NULL) {
-        ldap_unbind_ext(ld, NULL, NULL);
-      }
+      // serve the stale information and refresh in the background
+      NumStale++;
+      AsyncRefresh(egroupname, username);
     }
 
-    if (isMember)
-      eos_static_info("member=true user=\"%s\" e-group=\"%s\" cachetime=%lu",
-                      username.c_str(), egroupname.c_str(),
-                      now + EOSEGROUPCACHETIME);
-    else
-      eos_static_info("member=false user=\"%s\" e-group=\"%s\" cachetime=%lu",
-                      username.c_str(), egroupname.c_str(),
-                      now + EOSEGROUPCACHETIME);
-
-    Mutex.Lock();
-    Map[egroupname][username] = isMember;
-    LifeTime[egroupname][username] = now + EOSEGROUPCACHETIME;
-    Mutex.UnLock();
-    return isMember;
-  } else {
-    // just ask for asynchronous refresh
-    AsyncRefresh(egroupname, username);
-    return member;
+    return entry.member;
   }
+
+  NumMisses++;
+  std::set<std::string> usernames;
+  usernames.insert(username);
+  DoRefresh(egroupname, usernames);
+  return (Lookup(username, egroupname, entry) ? entry.member : false);
 }
 
 /*----------------------------------------------------------------------------*/
-void*
-Egroup::StaticRefresh(void* arg)
+Egroup::Status
+Egroup::Query(std::string& username, std::string& egroupname)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Thread startup function
- * @param arg Egroup object
- * @return Should never return until cancelled.
+ * @brief Query
+ * @param username name of the user to check Egroup membership
+ * @param egroupname name of Egroup where to look for membership
+ *
+ * Never blocks on a lookup: unknown entries are queued for the refresh thread
+ * and reported as pending, the caller should ask the client to retry.
+ *
+ * @return kMember, kNotMember or kPending
  */
 /*----------------------------------------------------------------------------*/
 {
-  return reinterpret_cast<Egroup*>(arg)->Refresh();
+  if (!Running) {
+    // without a refresh thread e.g. in tools resolve synchronously
+    return (Member(username, egroupname) ? kMember : kNotMember);
+  }
+
+  Entry entry;
+
+  if (Lookup(username, egroupname, entry)) {
+    if (entry.lifetime > time(NULL)) {
+      NumHits++;
+    } else {
+      // serve the stale information and refresh in the background
+      NumStale++;
+      AsyncRefresh(egroupname, username);
+    }
+
+    return (entry.member ? kMember : kNotMember);
+  }
+
+  NumMisses++;
+  NumPending++;
+  AsyncRefresh(egroupname, username);
+  eos_static_info("user=\"%s\" e-group=\"%s\" msg=\"lookup pending\"",
+                  username.c_str(), egroupname.c_str());
+  return kPending;
 }
 
 /*----------------------------------------------------------------------------*/
-void*
+void
+Egroup::Refresh()
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Asynchronous refresh loop
  *
- * The looping thread takes Egroup requests and run's LDAP queries pushing
- * results into the Egroup membership map and updates the lifetime of the
- * resolved entry.
- *
- * @return Should never return until cancelled.
+ * The looping thread takes all queued Egroup requests and runs one query per
+ * egroup for all its queued users, pushing the results into the membership
+ * cache.
  */
 /*----------------------------------------------------------------------------*/
-Egroup::Refresh()
 {
   eos_static_info("msg=\"async egroup fetch thread started\"");
 
-  // infinite loop waiting to run refresh requests indicated by conditions
-  // variable
-  while (1) {
-    // wait for anything to do ...
-    mCond.Wait();
-    XrdSysThread::SetCancelOff();
-    std::pair<std::string, std::string> resolve;
+  while (true) {
+    std::map < std::string, std::set < std::string > > batch;
     {
-      XrdSysMutexHelper lLock(Mutex);
+      std::unique_lock<std::mutex> lock(QueueMutex);
+      QueueCond.wait(lock, []() {
+        return (Shutdown || !Queue.empty());
+      });
 
-      if (LdapQueue.size()) {
-        resolve = LdapQueue.front();
-        LdapQueue.pop_front();
+      if (Shutdown) {
+        break;
       }
-    }
 
-    if (resolve.first.length()) {
-      DoRefresh(resolve.first, resolve.second);
+      batch.swap(Queue);
     }
 
-    XrdSysThread::SetCancelOn();
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+      DoRefresh(it->first, it->second);
+    }
   }
 
-  return 0;
+  eos_static_info("msg=\"async egroup fetch thread stopped\"");
 }
 
 void
@@ -301,153 +286,306 @@ Egroup::AsyncRefresh(std::string& egroupname, std::string& username)
  */
 /*----------------------------------------------------------------------------*/
 {
-  // push a egroup/username pair into the async refresh queue
-  {
-    XrdSysMutexHelper qMutex(Mutex);
-    LdapQueue.push_back(std::make_pair(egroupname, username));
-  }
   {
-    // signal to async thread
-    mCond.Signal();
+    std::lock_guard<std::mutex> lock(QueueMutex);
+    Queue[egroupname].insert(username);
   }
+  QueueCond.notify_one();
 }
 
 /*----------------------------------------------------------------------------*/
 void
-Egroup::DoRefresh(std::string& egroupname, std::string& username)
+Egroup::SetDirectory(const std::string& path)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Run a synchronous LDAP query for Egroup/username and update the Map
+ * @brief Use a local directory file instead of LDAP
  *
- * The asynchronous thread uses this function to update the Egroup Map.
+ * @param path file with lines '<egroup> <user> [<user> ...]', empty for LDAP
  */
 /*----------------------------------------------------------------------------*/
 {
-  Mutex.Lock();
-  time_t now = time(NULL);
-  bool isMember = false;
-
-  if (Map.count(egroupname)) {
-    if (Map[egroupname].count(username)) {
-      // we know that user
-      if (LifeTime[egroupname].count(username) &&
-          (LifeTime[egroupname][username] > now)) {
-        // we don't update, we have already a fresh value
-        Mutex.UnLock();
-        return;
+  std::lock_guard<std::mutex> lock(DirectoryMutex);
+  DirectoryPath = path;
+  DirectoryMtime = 0;
+  Directory.clear();
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+Egroup::DirectoryMembers(const std::string& egroupname,
+                         const std::set<std::string>& usernames,
+                         std::set<std::string>& members)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Resolve users of an egroup from the local directory file
+ *
+ * The file is reloaded whenever its modification time changes.
+ *
+ * @return true if the directory could be read
+ */
+/*----------------------------------------------------------------------------*/
+{
+  std::lock_guard<std::mutex> lock(DirectoryMutex);
+  struct stat buf;
+
+  if (::stat(DirectoryPath.c_str(), &buf)) {
+    eos_static_err("msg=\"cannot stat e-group directory\" path=\"%s\"",
+                   DirectoryPath.c_str());
+    return false;
+  }
+
+  if (buf.st_mtime != DirectoryMtime) {
+    std::ifstream file(DirectoryPath);
+    std::string line;
+    Directory.clear();
+
+    while (std::getline(file, line)) {
+      if (line.empty() || (line[0] == '#')) {
+        continue;
+      }
+
+      std::istringstream iss(line);
+      std::string egroup, user;
+
+      if (!(iss >> egroup)) {
+        continue;
+      }
+
+      std::set<std::string>& group = Directory[egroup];
+
+      while (iss >> user) {
+        group.insert(user);
       }
     }
+
+    DirectoryMtime = buf.st_mtime;
   }
 
-  Mutex.UnLock();
-  eos_static_info("msg=\"async-lookup\" user=\"%s\" e-group=\"%s\"",
-                  username.c_str(), egroupname.c_str());
-  // run the LDAP query
+  auto it = Directory.find(egroupname);
+
+  if (it != Directory.end()) {
+    for (auto uit = usernames.begin(); uit != usernames.end(); ++uit) {
+      if (it->second.count(*uit)) {
+        members.insert(*uit);
+      }
+    }
+  }
+
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+Egroup::LdapMembers(const std::string& egroupname,
+                    const std::set<std::string>& usernames,
+                    std::set<std::string>& members)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Resolve users of an egroup with LDAP queries
+ *
+ * The users are resolved in chunks of sLdapBatchSize with one recursive
+ * memberOf query each, returning the common names of the members.
+ *
+ * @return true if all queries succeeded
+ */
+/*----------------------------------------------------------------------------*/
+{
   LDAP* ld = NULL;
   int version = LDAP_VERSION3;
   // currently hard coded to server name 'xldap'
   ldap_initialize(&ld, "ldap://xldap");
-  bool keepCached = true;
 
   if (ld == NULL) {
-    fprintf(stderr, "error: failed to initialize LDAP\n");
-  } else {
-    (void) ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
-    // the LDAP base
-    std::string sbase = "CN=";
-    sbase += username;
-    sbase += ",OU=Users,Ou=Organic Units,DC=cern,DC=ch";
-    // the LDAP attribute (recursive search)
-    std::string attr = "cn";
-    // the LDAP filter
-    std::string filter;
-    filter = "(memberOf:1.2.840.113556.1.4.1941:=CN=";
+    eos_static_err("msg=\"failed to initialize LDAP\"");
+    return false;
+  }
+
+  (void) ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+  // the LDAP base
+  std::string sbase = "OU=Users,Ou=Organic Units,DC=cern,DC=ch";
+  // the LDAP attribute (recursive search)
+  std::string attr = "cn";
+  char* attrs[2];
+  attrs[0] = (char*) attr.c_str();
+  attrs[1] = NULL;
+  bool ok = true;
+  auto uit = usernames.begin();
+
+  while (uit != usernames.end()) {
+    // the LDAP filter for a chunk of users
+    std::string filter = "(&(memberOf:1.2.840.113556.1.4.1941:=CN=";
     filter += egroupname;
-    filter += ",OU=e-groups,OU=Workgroups,DC=cern,DC=ch)";
-    char* attrs[2];
-    attrs[0] = (char*) attr.c_str();
-    attrs[1] = NULL;
+    filter += ",OU=e-groups,OU=Workgroups,DC=cern,DC=ch)(|";
+
+    for (size_t n = 0; (n < sLdapBatchSize) && (uit != usernames.end());
+         ++n, ++uit) {
+      filter += "(cn=";
+      filter += *uit;
+      filter += ")";
+    }
+
+    filter += "))";
     LDAPMessage* res = NULL;
     struct timeval timeout;
     timeout.tv_sec = 10;
     timeout.tv_usec = 0;
-    std::string match = username;
-    eos_static_debug("base=%s attr=%s filter=%s match=%s\n", sbase.c_str(),
-                     attr.c_str(), filter.c_str(), match.c_str());
+    eos_static_debug("base=%s attr=%s filter=%s\n", sbase.c_str(),
+                     attr.c_str(), filter.c_str());
     int rc = ldap_search_ext_s(ld, sbase.c_str(), LDAP_SCOPE_SUBTREE,
                                filter.c_str(), attrs, 0, NULL, NULL,
                                &timeout, LDAP_NO_LIMIT, &res);
 
-    if ((rc == LDAP_SUCCESS) && (ldap_count_entries(ld, res) != 0)) {
+    if (rc == LDAP_SUCCESS) {
       LDAPMessage* e = NULL;
-      keepCached = false;
 
       for (e = ldap_first_entry(ld, res); e != NULL; e = ldap_next_entry(ld, e)) {
         struct berval** v = ldap_get_values_len(ld, e, attr.c_str());
 
         if (v != NULL) {
           int n = ldap_count_values_len(v);
-          int j;
 
-          for (j = 0; j < n; j++) {
-            std::string result = v[ j ]->bv_val;
+          for (int j = 0; j < n; j++) {
+            std::string result(v[j]->bv_val, v[j]->bv_len);
 
-            if ((result.find(match)) != std::string::npos) {
-              isMember = true;
+            if (usernames.count(result)) {
+              members.insert(result);
             }
           }
 
           ldap_value_free_len(v);
         }
       }
+    } else {
+      eos_static_warning("e-group=\"%s\" msg=\"ldap query failed or timed out\" "
+                         "rc=%d", egroupname.c_str(), rc);
+      ok = false;
     }
 
     ldap_msgfree(res);
 
-    if (ld != NULL) {
-      ldap_unbind_ext(ld, NULL, NULL);
+    if (!ok) {
+      break;
     }
   }
 
-  if (!keepCached) {
-    if (isMember)
-      eos_static_info("member=true user=\"%s\" e-group=\"%s\" cachetime=%lu",
-                      username.c_str(), egroupname.c_str(),
-                      now + EOSEGROUPCACHETIME);
-    else
-      eos_static_info("member=false user=\"%s\" e-group=\"%s\" cachetime=%lu",
-                      username.c_str(), egroupname.c_str(),
-                      now + EOSEGROUPCACHETIME);
-
-    Mutex.Lock();
-    Map[egroupname][username] = isMember;
-    LifeTime[egroupname][username] = now + EOSEGROUPCACHETIME;
-    Mutex.UnLock();
-  } else {
-    Mutex.Lock();
+  ldap_unbind_ext(ld, NULL, NULL);
+  return ok;
+}
 
-    if (Map.count(egroupname) && Map[egroupname].count(username)) {
-      isMember = Map[egroupname][username];
-    } else {
-      isMember = false;
+/*----------------------------------------------------------------------------*/
+void
+Egroup::DoRefresh(const std::string& egroupname,
+                  const std::set<std::string>& usernames)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Run a synchronous query for the users of an Egroup and update the
+ *        cache
+ *
+ * The asynchronous thread uses this function to update the Egroup cache.
+ * Users which got a fresh entry in the meanwhile are skipped. If the query
+ * fails the existing entries are kept stale.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  time_t now = time(NULL);
+  std::set<std::string> todo;
+  {
+    eos::common::RWMutexReadLock lock(CacheMutex);
+    auto git = Cache.find(egroupname);
+
+    for (auto it = usernames.begin(); it != usernames.end(); ++it) {
+      if (git != Cache.end()) {
+        auto uit = git->second.find(*it);
+
+        if ((uit != git->second.end()) && (uit->second.lifetime > now)) {
+          // we don't update, we have already a fresh value
+          continue;
+        }
+      }
+
+      todo.insert(*it);
     }
+  }
 
-    Mutex.UnLock();
+  if (todo.empty()) {
+    return;
+  }
 
-    if (isMember) {
-      eos_static_warning("member=true user=\"%s\" e-group=\"%s\" "
-                         "cachetime=<stale-information>",
-                         username.c_str(),
-                         egroupname.c_str());
-    } else {
-      eos_static_warning("member=false user=\"%s\" e-group=\"%s\" "
-                         "cachetime=<stale-information>",
-                         username.c_str(),
-                         egroupname.c_str());
+  eos_static_info("msg=\"async-lookup\" e-group=\"%s\" users=%lu",
+                  egroupname.c_str(), (unsigned long) todo.size());
+  std::set<std::string> members;
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(DirectoryMutex);
+    path = DirectoryPath;
+  }
+  auto start = std::chrono::steady_clock::now();
+  bool ok = (path.empty() ? LdapMembers(egroupname, todo, members) :
+             DirectoryMembers(egroupname, todo, members));
+  unsigned long long usec =
+    std::chrono::duration_cast<std::chrono::microseconds>
+    (std::chrono::steady_clock::now() - start).count();
+  NumRefreshes++;
+  RefreshMicroSec += usec;
+  unsigned long long max = RefreshMaxMicroSec;
+
+  while ((usec > max) && !RefreshMaxMicroSec.compare_exchange_weak(max, usec)) {}
+
+  if (!ok) {
+    NumFailed++;
+  }
+
+  {
+    eos::common::RWMutexWriteLock lock(CacheMutex);
+    std::unordered_map<std::string, Entry>& group = Cache[egroupname];
+
+    for (auto it = todo.begin(); it != todo.end(); ++it) {
+      auto uit = group.find(*it);
+
+      if (ok) {
+        Entry& entry = group[*it];
+        entry.member = members.count(*it);
+        entry.lifetime = now + EOSEGROUPCACHETIME;
+        NumResolved++;
+        eos_static_info("member=%s user=\"%s\" e-group=\"%s\" cachetime=%lu",
+                        entry.member ? "true" : "false", it->c_str(),
+                        egroupname.c_str(), entry.lifetime);
+      } else if (uit == group.end()) {
+        // new entry - store a short lived non-membership
+        Entry& entry = group[*it];
+        entry.member = false;
+        entry.lifetime = now + sFailedCacheTime;
+      } else {
+        eos_static_warning("member=%s user=\"%s\" e-group=\"%s\" "
+                           "cachetime=<stale-information>",
+                           uit->second.member ? "true" : "false",
+                           it->c_str(), egroupname.c_str());
+      }
     }
   }
+}
 
-  return;
+/*----------------------------------------------------------------------------*/
+Egroup::Stats
+Egroup::GetStats()
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Get the cache statistics
+ */
+/*----------------------------------------------------------------------------*/
+{
+  Stats stats;
+  stats.hits = NumHits;
+  stats.stale = NumStale;
+  stats.misses = NumMisses;
+  stats.pending = NumPending;
+  stats.refreshes = NumRefreshes;
+  stats.resolved = NumResolved;
+  stats.failed = NumFailed;
+  stats.refresh_avg_ms = (stats.refreshes ?
+                          RefreshMicroSec / 1000.0 / stats.refreshes : 0);
+  stats.refresh_max_ms = RefreshMaxMicroSec / 1000.0;
+  return stats;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -465,16 +603,14 @@ Egroup::DumpMember(std::string& username, std::string& egroupname)
 {
   // trigger refresh
   Member(username, egroupname);
-  XrdSysMutexHelper lLock(Mutex);
   bool member = false;
   time_t timetolive = 0;
   time_t now = time(NULL);
+  Entry entry;
 
-  if (Map.count(egroupname)) {
-    if (Map[egroupname].count(username)) {
-      member = Map[egroupname][username];
-      timetolive = labs(LifeTime[egroupname][username] - now);
-    }
+  if (Lookup(username, egroupname, entry)) {
+    member = entry.member;
+    timetolive = labs(entry.lifetime - now);
   }
 
   std::string rs;
@@ -502,38 +638,52 @@ Egroup::DumpMembers()
 /**
  * @brief DumpMember
  *
- * @return egroup dump for all users
+ * @return egroup dump for all users followed by the cache statistics
  */
 /*----------------------------------------------------------------------------*/
 {
-  XrdSysMutexHelper lLock(Mutex);
   time_t timetolive = 0;
   time_t now = time(NULL);
   std::string rs;
-  std::map < std::string, std::map <std::string, bool > >::iterator it;
+  // sorted copy for a stable output
+  std::map < std::string, std::map < std::string, Entry > > sorted;
+  {
+    eos::common::RWMutexReadLock lock(CacheMutex);
 
-  for (it = Map.begin(); it != Map.end(); ++it) {
-    std::map <std::string, bool>::iterator uit;
+    for (auto it = Cache.begin(); it != Cache.end(); ++it) {
+      sorted[it->first].insert(it->second.begin(), it->second.end());
+    }
+  }
 
-    for (uit = it->second.begin(); uit != it->second.end(); ++uit) {
+  for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+    for (auto uit = it->second.begin(); uit != it->second.end(); ++uit) {
       rs += "egroup=";
       rs += it->first;
       rs += " user=";
       rs += uit->first;
 
-      if (uit->second) {
+      if (uit->second.member) {
         rs += " member=true";
       } else {
         rs += " member=false";
       }
 
-      timetolive = labs(LifeTime[it->first][uit->first] - now);
+      timetolive = labs(uit->second.lifetime - now);
       rs += " lifetime=";
       rs += std::to_string((long long)timetolive);
       rs += "\n";
     }
   }
 
+  Stats stats = GetStats();
+  char line[512];
+  snprintf(line, sizeof(line), "stats hits=%llu stale=%llu misses=%llu "
+           "pending=%llu refreshes=%llu resolved=%llu failed=%llu "
+           "refresh-avg-ms=%.02f refresh-max-ms=%.02f\n", stats.hits,
+           stats.stale, stats.misses, stats.pending, stats.refreshes,
+           stats.resolved, stats.failed, stats.refresh_avg_ms,
+           stats.refresh_max_ms);
+  rs += line;
   return rs;
 }
 
@@ -27,10 +27,18 @@
 /*----------------------------------------------------------------------------*/
 #include "mgm/Namespace.hh"
 #include "common/Mapping.hh"
+#include "common/RWMutex.hh"
 /*----------------------------------------------------------------------------*/
 #include <sys/types.h>
-#include <string>
+#include <atomic>
+#include <condition_variable>
 #include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 /*----------------------------------------------------------------------------*/
 
@@ -57,39 +65,45 @@ EOSMGMNAMESPACE_BEGIN
  * Egroup membership update requests. \n
  * The application has to generate a single Egroup object and should use the
  * static Egroup::Member function to check Egroup membership.\n\n
- * The problem here is that the calling function in the MGM
- * has a read lock durign the Egroup::Member call and the
- * refreshing of Egroup permissions should be done if possible asynchronous to
- * avoid mutex starvation.
+ * The ACL evaluation holds the namespace lock, therefore it uses
+ * Egroup::Query which never runs an LDAP query itself: expired entries are
+ * served stale while the refresh thread updates them and unknown entries are
+ * reported as pending, so that the caller can stall the client until the
+ * refresh thread has resolved them. Egroup::Member must be called without the
+ * namespace lock and resolves unknown entries synchronously.
+ * The refresh thread resolves all queued users of an egroup with a single
+ * LDAP query. If EOS_EGROUP_DIRECTORY points to a local file with lines
+ * '<egroup> <user> [<user> ...]' it is used instead of LDAP e.g. for tests.
  */
 /*----------------------------------------------------------------------------*/
 class Egroup
 {
-private:
-  /// thread id of the async refresh thread
-  pthread_t mThread;
-
-  // ---------------------------------------------------------------------------
-  // Synchronous refresh function doing an LDAP query for a given Egroup/user
-  // ---------------------------------------------------------------------------
-  void DoRefresh (std::string &egroupname, std::string &username);
-
 public:
-  /// static queue with pairs of egroup/username
-  static std::deque <std::pair<std::string, std::string > > LdapQueue;
-
-  /// static mutex protecting static Egroup objects
-  static XrdSysMutex Mutex;
-
-  /// static map indicating egroup memebership for egroup/username pairs
-  static std::map < std::string, std::map <std::string, bool > > Map;
-
-  /// static map storing the validity of egroup/username pairs in Map
-  static std::map < std::string, std::map <std::string, time_t > > LifeTime;
-
-  /// static condition variable to notify the asynchronous update thread about
-  /// a new egroup request
-  static XrdSysCondVar mCond;
+  /// cached membership of an egroup/username pair
+  struct Entry {
+    bool member; ///< member or not
+    time_t lifetime; ///< expiry time of the entry
+  };
+
+  /// result of a membership query
+  enum Status {
+    kNotMember, ///< not a member
+    kMember, ///< member
+    kPending ///< unknown yet, resolution is queued
+  };
+
+  /// cache statistics
+  struct Stats {
+    unsigned long long hits; ///< served from a valid entry
+    unsigned long long stale; ///< served from an expired entry
+    unsigned long long misses; ///< unknown entry
+    unsigned long long pending; ///< misses reported as pending
+    unsigned long long refreshes; ///< refresh batches run
+    unsigned long long resolved; ///< egroup/username pairs resolved
+    unsigned long long failed; ///< failed refresh batches
+    double refresh_avg_ms; ///< average latency of a refresh batch
+    double refresh_max_ms; ///< maximum latency of a refresh batch
+  };
 
   // ---------------------------------------------------------------------------
   // Constructor
@@ -107,9 +121,8 @@ public:
   // ---------------------------------------------------------------------------
   static void Reset ()
   {
-    XrdSysMutexHelper mLock(Mutex);
-    Map.clear();
-    LifeTime.clear();
+    eos::common::RWMutexWriteLock lock(CacheMutex);
+    Cache.clear();
   }
 
   // ---------------------------------------------------------------------------
@@ -123,10 +136,17 @@ public:
   void Stop ();
 
   // ---------------------------------------------------------------------------
-  // static function to check if username is member in egroupname
+  // static function to check if username is member in egroupname, resolving
+  // unknown entries synchronously - don't call it with the namespace locked
   // ---------------------------------------------------------------------------
   static bool Member (std::string &username, std::string &egroupname);
 
+  // ---------------------------------------------------------------------------
+  // static function to check if username is member in egroupname without
+  // blocking, unknown entries are queued for resolution and reported pending
+  // ---------------------------------------------------------------------------
+  static Status Query (std::string &username, std::string &egroupname);
+
   // ---------------------------------------------------------------------------
   // static function to display info for username in egroupname
   // ---------------------------------------------------------------------------
@@ -137,20 +157,83 @@ public:
   // ---------------------------------------------------------------------------
   static std::string DumpMembers ();
 
+  // ---------------------------------------------------------------------------
+  // static function to get the cache statistics
+  // ---------------------------------------------------------------------------
+  static Stats GetStats ();
+
   // ---------------------------------------------------------------------------
   // static function to schedule an asynchronous refresh for egroup/username
   // ---------------------------------------------------------------------------
   static void AsyncRefresh (std::string &egroupname, std::string &username);
 
+  // ---------------------------------------------------------------------------
+  // static function to use a local directory file instead of LDAP, an empty
+  // path selects LDAP
+  // ---------------------------------------------------------------------------
+  static void SetDirectory (const std::string &path);
+
+private:
   // ---------------------------------------------------------------------------
   // asynchronous thread loop doing egroup/username fetching
   // ---------------------------------------------------------------------------
-  void* Refresh ();
+  void Refresh ();
+
+  // ---------------------------------------------------------------------------
+  // Synchronous refresh of all given users of an egroup
+  // ---------------------------------------------------------------------------
+  static void DoRefresh (const std::string &egroupname,
+                         const std::set<std::string> &usernames);
+
+  // ---------------------------------------------------------------------------
+  // LDAP query returning the members among usernames, false if it failed
+  // ---------------------------------------------------------------------------
+  static bool LdapMembers (const std::string &egroupname,
+                           const std::set<std::string> &usernames,
+                           std::set<std::string> &members);
 
   // ---------------------------------------------------------------------------
-  // static thread startup function
+  // Local directory lookup returning the members among usernames
   // ---------------------------------------------------------------------------
-  static void* StaticRefresh (void* arg);
+  static bool DirectoryMembers (const std::string &egroupname,
+                                const std::set<std::string> &usernames,
+                                std::set<std::string> &members);
+
+  // ---------------------------------------------------------------------------
+  // Lookup in the cache
+  // ---------------------------------------------------------------------------
+  static bool Lookup (const std::string &username,
+                      const std::string &egroupname, Entry &entry);
+
+  std::thread mThread; ///< async refresh thread
+  static std::atomic<bool> Shutdown; ///< stop the refresh thread
+  static std::atomic<bool> Running; ///< refresh thread is running
+
+  /// egroup => username => membership, read-mostly
+  static std::unordered_map < std::string,
+         std::unordered_map < std::string, Entry > > Cache;
+  static eos::common::RWMutex CacheMutex; ///< protects Cache
+
+  /// refresh requests egroup => usernames, merged per egroup
+  static std::map < std::string, std::set < std::string > > Queue;
+  static std::mutex QueueMutex; ///< protects Queue
+  static std::condition_variable QueueCond; ///< signals a new request
+
+  static std::mutex DirectoryMutex; ///< protects the directory
+  static std::string DirectoryPath; ///< local directory file if any
+  static time_t DirectoryMtime; ///< mtime of the loaded directory
+  /// egroup => members from the local directory
+  static std::map < std::string, std::set < std::string > > Directory;
+
+  static std::atomic<unsigned long long> NumHits;
+  static std::atomic<unsigned long long> NumStale;
+  static std::atomic<unsigned long long> NumMisses;
+  static std::atomic<unsigned long long> NumPending;
+  static std::atomic<unsigned long long> NumRefreshes;
+  static std::atomic<unsigned long long> NumResolved;
+  static std::atomic<unsigned long long> NumFailed;
+  static std::atomic<unsigned long long> RefreshMicroSec; ///< total latency
+  static std::atomic<unsigned long long> RefreshMaxMicroSec; ///< max latency
 };
 
 EOSMGMNAMESPACE_END
@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------
+// File: FindWalker.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FindWalker.hh"
+#include <algorithm>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr size_t FindWalker::kMaxBuffered;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FindWalker::FindWalker(const ListFunc& list, const EmitFunc& emit,
+                       int maxdepth):
+  mList(list), mEmit(emit), mMaxDepth(maxdepth)
+{}
+
+//------------------------------------------------------------------------------
+// Walk a sub-tree
+//------------------------------------------------------------------------------
+uint64_t
+FindWalker::Walk(const std::string& path, eos::common::ThreadPool* pool,
+                 unsigned int helpers)
+{
+  auto state = std::make_shared<State>();
+  auto root = std::make_shared<Node>(Dir{path, 0, true});
+  state->mPending.push_back(root);
+  state->mOrder.push_back(root);
+  root.reset();
+
+  if (pool) {
+    for (unsigned int i = 0; i < helpers; ++i) {
+      pool->PushTask<void>([this, state]() {
+        {
+          std::lock_guard<std::mutex> lock(state->mMutex);
+
+          // Helpers which did not start in time must not touch the walker
+          if (state->mDone) {
+            return;
+          }
+
+          ++state->mJoined;
+        }
+
+        Run(*state);
+        std::lock_guard<std::mutex> lock(state->mMutex);
+        --state->mJoined;
+        state->mCond.notify_all();
+      });
+    }
+  }
+
+  Run(*state);
+  std::unique_lock<std::mutex> lock(state->mMutex);
+  state->mCond.wait(lock, [&]() {
+    return !state->mJoined;
+  });
+  state->mDone = true;
+  // Hand out what was listed before the walk stopped
+  Drain(*state, lock, true);
+  return state->mEmitted;
+}
+
+//------------------------------------------------------------------------------
+// Get the next directory to list
+//------------------------------------------------------------------------------
+std::shared_ptr<FindWalker::Node>
+FindWalker::Next(State& state) const
+{
+  // Drop the directories which were taken out of the stack order
+  while (state.mPending.size() && state.mPending.back()->mTaken) {
+    state.mPending.pop_back();
+  }
+
+  if (state.mPending.empty()) {
+    return nullptr;
+  }
+
+  if (state.mBuffered < kMaxBuffered) {
+    std::shared_ptr<Node> node = std::move(state.mPending.back());
+    state.mPending.pop_back();
+    return node;
+  }
+
+  // The buffer is full, only the directory handed out next is listed
+  if (state.mOrder.size() && !state.mOrder.back()->mTaken) {
+    return state.mOrder.back();
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// List directories until the sub-tree is listed or the walk is stopped
+//------------------------------------------------------------------------------
+void
+FindWalker::Run(State& state) const
+{
+  std::unique_lock<std::mutex> lock(state.mMutex);
+
+  while (true) {
+    std::shared_ptr<Node> node;
+    state.mCond.wait(lock, [&]() {
+      if (state.mStop) {
+        return true;
+      }
+
+      node = Next(state);
+      return (node || (state.mPending.empty() && !state.mActive));
+    });
+
+    if (state.mStop || !node) {
+      break;
+    }
+
+    node->mTaken = true;
+    ++state.mActive;
+    lock.unlock();
+    std::vector<Dir> subdirs;
+    std::set<std::string> files;
+    bool exists = (node->mDir.mDepth != 0);
+    bool ok = true;
+
+    if ((!mMaxDepth) || (node->mDir.mDepth < mMaxDepth)) {
+      ok = mList(node->mDir, subdirs, files, exists);
+    }
+
+    // Children in path order give the results in the order of a map
+    std::sort(subdirs.begin(), subdirs.end(), [](const Dir & a, const Dir & b) {
+      return (a.mPath < b.mPath);
+    });
+    std::vector<std::shared_ptr<Node>> children;
+    children.reserve(subdirs.size());
+
+    for (const auto& subdir : subdirs) {
+      children.push_back(std::make_shared<Node>(subdir));
+
+      if (!ok) {
+        // Part of the result without being listed
+        children.back()->mTaken = true;
+        children.back()->mListed = true;
+        children.back()->mEmit = subdir.mMatched;
+      }
+    }
+
+    lock.lock();
+    --state.mActive;
+    // Directories found by their parent are part of the result even if they
+    // could not be listed, the start directory only if it exists
+    node->mEmit = ((exists && node->mDir.mMatched) || files.size());
+    node->mFiles.swap(files);
+    node->mListed = true;
+    ++state.mBuffered;
+
+    if (ok) {
+      // Push in reverse order to list the sub-directories in path order,
+      // depth first to keep the stack small
+      for (auto it = children.rbegin(); it != children.rend(); ++it) {
+        state.mPending.push_back(*it);
+      }
+    } else {
+      state.mStop = true;
+      state.mBuffered += children.size();
+    }
+
+    node->mChildren.swap(children);
+    node.reset();
+    Drain(state, lock, false);
+    state.mCond.notify_all();
+  }
+
+  state.mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Hand out the listed directories in path order
+//------------------------------------------------------------------------------
+void
+FindWalker::Drain(State& state, std::unique_lock<std::mutex>& lock,
+                  bool final) const
+{
+  // The thread already handing out picks up what was listed meanwhile
+  if (state.mDraining) {
+    return;
+  }
+
+  state.mDraining = true;
+
+  while (!state.mAborted && state.mOrder.size()) {
+    std::shared_ptr<Node> node = state.mOrder.back();
+
+    if (!node->mListed) {
+      if (!final) {
+        break;
+      }
+
+      state.mOrder.pop_back();
+      continue;
+    }
+
+    state.mOrder.pop_back();
+    --state.mBuffered;
+
+    // The children follow their parent in path order
+    for (auto it = node->mChildren.rbegin(); it != node->mChildren.rend(); ++it) {
+      state.mOrder.push_back(std::move(*it));
+    }
+
+    node->mChildren.clear();
+
+    if (node->mEmit) {
+      lock.unlock();
+      bool ok = mEmit(node->mDir.mPath, node->mFiles);
+      lock.lock();
+      ++state.mEmitted;
+
+      if (!ok) {
+        state.mAborted = true;
+        state.mStop = true;
+      }
+    }
+
+    state.mCond.notify_all();
+  }
+
+  state.mDraining = false;
+}
+
+EOSMGMNAMESPACE_END
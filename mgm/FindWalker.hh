@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+// File: FindWalker.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_FINDWALKER__HH__
+#define __EOSMGM_FINDWALKER__HH__
+
+#include "mgm/Namespace.hh"
+#include "common/ThreadPool.hh"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FindWalker
+//!
+//! @brief Walk of a directory sub-tree for find. Directories are listed by
+//! the calling thread and optionally by helper tasks of a thread pool, but
+//! the results are always handed out in path order - the order of a map
+//! keyed by the directory paths - by one thread at a time.
+//!
+//! Directories which are listed but can not be handed out yet, because a
+//! directory before them in path order is still being listed, are buffered.
+//! Once kMaxBuffered of them are waiting, the listing threads only take the
+//! directory which is handed out next.
+//------------------------------------------------------------------------------
+class FindWalker
+{
+public:
+  //! Maximum number of listed directories waiting to be handed out
+  static constexpr size_t kMaxBuffered = 4096;
+
+  //! Directory of the sub-tree
+  struct Dir {
+    std::string mPath; ///< path with a trailing '/'
+    int mDepth; ///< depth below the start directory
+    bool mMatched; ///< true if the directory itself is part of the result
+  };
+
+  //----------------------------------------------------------------------------
+  //! List a directory: fill its sub-directories and its files, set exists to
+  //! false if the directory does not exist. Returns false if the walk has to
+  //! stop after this directory e.g. a limit was reached, the sub-directories
+  //! found so far are then part of the result without being listed. Called
+  //! concurrently when helpers are used.
+  //----------------------------------------------------------------------------
+  using ListFunc = std::function<bool(const Dir& dir, std::vector<Dir>& subdirs,
+                                      std::set<std::string>& files,
+                                      bool& exists)>;
+
+  //----------------------------------------------------------------------------
+  //! Receive the files of a directory part of the result, return false to
+  //! abort the walk. Never called concurrently.
+  //----------------------------------------------------------------------------
+  using EmitFunc = std::function<bool(const std::string& dir,
+                                      std::set<std::string>& files)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param list function listing a directory
+  //! @param emit function receiving the results
+  //! @param maxdepth directories at this depth are not listed, 0 for no limit
+  //----------------------------------------------------------------------------
+  FindWalker(const ListFunc& list, const EmitFunc& emit, int maxdepth);
+
+  //----------------------------------------------------------------------------
+  //! Walk a sub-tree
+  //!
+  //! @param path start directory with a trailing '/'
+  //! @param pool pool running the helpers, nullptr to walk in this thread
+  //! @param helpers number of pool tasks helping to list the sub-tree
+  //!
+  //! @return number of directories handed out
+  //----------------------------------------------------------------------------
+  uint64_t Walk(const std::string& path, eos::common::ThreadPool* pool,
+                unsigned int helpers);
+
+private:
+  //! Directory of the sub-tree with its listing
+  struct Node {
+    explicit Node(const Dir& dir): mDir(dir) {}
+
+    Dir mDir; ///< directory
+    bool mTaken = false; ///< true once a thread started to list it
+    bool mListed = false; ///< true once the listing is done
+    bool mEmit = false; ///< true if the directory is part of the result
+    std::set<std::string> mFiles; ///< files found by the listing
+    std::vector<std::shared_ptr<Node>> mChildren; ///< sub-dirs in path order
+  };
+
+  //! State shared by the threads walking the sub-tree
+  struct State {
+    std::mutex mMutex; ///< protects the members below
+    std::condition_variable mCond; ///< signals changes of the state
+    std::vector<std::shared_ptr<Node>> mPending; ///< to list, used as a stack
+    std::vector<std::shared_ptr<Node>> mOrder; ///< to hand out, as a stack
+    size_t mBuffered = 0; ///< listed directories not handed out yet
+    size_t mActive = 0; ///< number of directories being listed
+    size_t mJoined = 0; ///< number of pool tasks working on the walk
+    bool mDraining = false; ///< true while a thread hands out results
+    bool mStop = false; ///< true if no more directories are listed
+    bool mAborted = false; ///< true once the emit function asked to stop
+    bool mDone = false; ///< true once the walk returned
+    uint64_t mEmitted = 0; ///< number of directories handed out
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the next directory to list or nullptr if there is none to take now,
+  //! the state mutex has to be held
+  //----------------------------------------------------------------------------
+  std::shared_ptr<Node> Next(State& state) const;
+
+  //----------------------------------------------------------------------------
+  //! List directories until the sub-tree is listed or the walk is stopped
+  //----------------------------------------------------------------------------
+  void Run(State& state) const;
+
+  //----------------------------------------------------------------------------
+  //! Hand out the listed directories in path order, the lock of the state
+  //! mutex is released while calling the emit function
+  //!
+  //! @param lock lock of the state mutex
+  //! @param final if true the directories which were not listed are skipped
+  //----------------------------------------------------------------------------
+  void Drain(State& state, std::unique_lock<std::mutex>& lock,
+             bool final) const;
+
+  ListFunc mList; ///< function listing a directory
+  EmitFunc mEmit; ///< function receiving the results
+  int mMaxDepth; ///< depth at which directories are not listed, 0 no limit
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
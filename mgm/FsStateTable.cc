@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+// File: FsStateTable.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FsStateTable.hh"
+#include <cerrno>
+#include <cstdlib>
+
+EOSMGMNAMESPACE_BEGIN
+
+using eos::common::FileSystem;
+
+constexpr size_t FsStateTable::kRowShards;
+
+// Columns needed for the status flags of every row
+static const size_t sConfigStatusCol = 0;
+static const size_t sBootCol = 1;
+static const size_t sActiveCol = 2;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FsStateTable::FsStateTable()
+{
+  GetColumn("configstatus");
+  GetColumn("stat.boot");
+  GetColumn("stat.active");
+}
+
+//------------------------------------------------------------------------------
+// Get the column of a key, registering it if needed
+//------------------------------------------------------------------------------
+size_t
+FsStateTable::GetColumn(const std::string& key)
+{
+  {
+    eos::common::RWMutexReadLock rd_lock(mMutex);
+    auto it = mKeyColumn.find(key);
+
+    if (it != mKeyColumn.end()) {
+      return it->second;
+    }
+  }
+
+  eos::common::RWMutexWriteLock wr_lock(mMutex);
+  auto it = mKeyColumn.find(key);
+
+  if (it != mKeyColumn.end()) {
+    return it->second;
+  }
+
+  size_t nrows = mChangeIds.size();
+  Column col;
+  col.mKey = key;
+  col.mStrings.resize(nrows);
+  col.mLongs.resize(nrows, 0);
+  col.mDoubles.resize(nrows, 0);
+  mColumns.push_back(std::move(col));
+  mKeys.push_back(key);
+  mKeyColumn[key] = mKeys.size() - 1;
+  return mKeys.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+// Make sure the table has a row for all file system ids up to the given one
+//------------------------------------------------------------------------------
+void
+FsStateTable::Reserve(FileSystem::fsid_t fsid)
+{
+  {
+    eos::common::RWMutexReadLock rd_lock(mMutex);
+
+    if (fsid < mChangeIds.size()) {
+      return;
+    }
+  }
+
+  eos::common::RWMutexWriteLock wr_lock(mMutex);
+
+  if (fsid < mChangeIds.size()) {
+    return;
+  }
+
+  size_t nrows = (size_t) fsid + 1;
+  mChangeIds.resize(nrows, 0);
+  mNumColumns.resize(nrows, 0);
+  mConsidered.resize(nrows, 0);
+  mAvailable.resize(nrows, 0);
+
+  for (auto& col : mColumns) {
+    col.mStrings.resize(nrows);
+    col.mLongs.resize(nrows, 0);
+    col.mDoubles.resize(nrows, 0);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Bring the row of a file system up to date
+//------------------------------------------------------------------------------
+bool
+FsStateTable::Refresh(FileSystem::fsid_t fsid, FileSystem* fs)
+{
+  RowShard& shard = mRowShards[fsid % kRowShards];
+  std::lock_guard<std::mutex> row_lock(shard.mMutex);
+  std::vector<std::string>& values = shard.mValues;
+  // Rows which miss a column registered after their last read are re-read
+  unsigned long long known_id = ((mNumColumns[fsid] == mKeys.size()) ?
+                                 mChangeIds[fsid] : 0);
+  unsigned long long change_id = (fs ? fs->GetValues(mKeys, values, known_id) :
+                                  0);
+
+  if (change_id && (change_id == known_id)) {
+    return false;
+  }
+
+  if (!change_id) {
+    // No hash, all getters return empty values
+    values.assign(mKeys.size(), "");
+  }
+
+  mChangeIds[fsid] = change_id;
+  mNumColumns[fsid] = mKeys.size();
+  Store(fsid, values);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Convert the values read for a row
+//------------------------------------------------------------------------------
+void
+FsStateTable::Store(FileSystem::fsid_t fsid, std::vector<std::string>& values)
+{
+  for (size_t i = 0; i < mKeys.size(); ++i) {
+    Column& col = mColumns[i];
+    std::string& value = values[i];
+    long long lvalue = 0;
+    double dvalue = 0;
+
+    if (value.length()) {
+      errno = 0;
+      lvalue = strtoll(value.c_str(), 0, 10);
+
+      if (errno) {
+        lvalue = 0;
+      }
+
+      dvalue = atof(value.c_str());
+    }
+
+    // Like FileSystem::GetString and GetLongLong but not GetDouble
+    if (mKeys[i] == "<n>") {
+      value = "1";
+      lvalue = 1;
+    }
+
+    col.mStrings[fsid].swap(value);
+    col.mLongs[fsid] = lvalue;
+    col.mDoubles[fsid] = dvalue;
+  }
+
+  const std::string& active = mColumns[sActiveCol].mStrings[fsid];
+  bool booted = (FileSystem::GetStatusFromString(
+                   mColumns[sBootCol].mStrings[fsid].c_str()) ==
+                 FileSystem::kBooted);
+  mAvailable[fsid] = (booted &&
+                      FileSystem::GetActiveStatusFromString(active.c_str()));
+  mConsidered[fsid] = (booted && (active == "online") &&
+                       (FileSystem::GetConfigStatusFromString(
+                          mColumns[sConfigStatusCol].mStrings[fsid].c_str()) >=
+                        FileSystem::kRO));
+}
+
+EOSMGMNAMESPACE_END
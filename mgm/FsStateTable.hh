@@ -0,0 +1,206 @@
+//------------------------------------------------------------------------------
+// File: FsStateTable.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_FSSTATETABLE__HH__
+#define __EOSMGM_FSSTATETABLE__HH__
+
+#include "mgm/Namespace.hh"
+#include "common/FileSystem.hh"
+#include "common/RWMutex.hh"
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FsStateTable
+//!
+//! @brief Typed copy of the shared hash values of all file systems, stored by
+//! column (one vector per key and type) and indexed by file system id. A row
+//! is only re-read and converted when the change id of the file system hash
+//! moved since the previous refresh, so that aggregations over many file
+//! systems become plain scans of the column vectors.
+//!
+//! Columns are registered on first use. The string, long long and double
+//! values have exactly the semantics of FileSystem::GetString, GetLongLong
+//! and GetDouble.
+//!
+//! Locking: GetColumn and Reserve change the layout of the table and take
+//! the table mutex exclusively, so they must be called without holding it.
+//! Refreshing and reading rows requires the table mutex held shared and,
+//! since several views share rows, the mutex of the row: Refresh takes it
+//! itself, readers take GetRowMutex. Rows are spread over a fixed number of
+//! mutexes, hence views refresh and read their members in parallel.
+//------------------------------------------------------------------------------
+class FsStateTable
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  FsStateTable();
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~FsStateTable() = default;
+
+  //----------------------------------------------------------------------------
+  //! Get the mutex protecting the layout of the table
+  //----------------------------------------------------------------------------
+  inline eos::common::RWMutex& GetMutex()
+  {
+    return mMutex;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the mutex protecting the values of a row
+  //----------------------------------------------------------------------------
+  inline std::mutex& GetRowMutex(eos::common::FileSystem::fsid_t fsid) const
+  {
+    return mRowShards[fsid % kRowShards].mMutex;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the column of a key, registering it if needed. A new column forces
+  //! a full re-read of all rows on their next refresh.
+  //!
+  //! @param key hash key
+  //!
+  //! @return column index
+  //----------------------------------------------------------------------------
+  size_t GetColumn(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Make sure the table has a row for all file system ids up to the given one
+  //----------------------------------------------------------------------------
+  void Reserve(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Bring the row of a file system up to date, the row has to be reserved
+  //!
+  //! @param fsid file system id
+  //! @param fs file system object, if null the row is cleared
+  //!
+  //! @return true if the row was re-read, false if it was up to date
+  //----------------------------------------------------------------------------
+  bool Refresh(eos::common::FileSystem::fsid_t fsid,
+               eos::common::FileSystem* fs);
+
+  //----------------------------------------------------------------------------
+  //! Get the change id of the hash the row was last read from
+  //----------------------------------------------------------------------------
+  inline unsigned long long
+  GetChangeId(eos::common::FileSystem::fsid_t fsid) const
+  {
+    return mChangeIds[fsid];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get a value as string
+  //----------------------------------------------------------------------------
+  inline const std::string&
+  GetString(eos::common::FileSystem::fsid_t fsid, size_t col) const
+  {
+    return mColumns[col].mStrings[fsid];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get a value as long long
+  //----------------------------------------------------------------------------
+  inline long long
+  GetLongLong(eos::common::FileSystem::fsid_t fsid, size_t col) const
+  {
+    return mColumns[col].mLongs[fsid];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get a value as double
+  //----------------------------------------------------------------------------
+  inline double
+  GetDouble(eos::common::FileSystem::fsid_t fsid, size_t col) const
+  {
+    return mColumns[col].mDoubles[fsid];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the file system is at least read-only, booted and online i.e.
+  //! if it is considered for the group averages
+  //----------------------------------------------------------------------------
+  inline bool IsConsidered(eos::common::FileSystem::fsid_t fsid) const
+  {
+    return mConsidered[fsid];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if the file system is booted and online i.e. if it is counted by
+  //! the query sums
+  //----------------------------------------------------------------------------
+  inline bool IsAvailable(eos::common::FileSystem::fsid_t fsid) const
+  {
+    return mAvailable[fsid];
+  }
+
+private:
+  //! Number of mutexes the rows are spread over
+  static constexpr size_t kRowShards = 64;
+
+  //----------------------------------------------------------------------------
+  //! Mutex of the rows of a shard and the buffer their refresh reads into
+  //----------------------------------------------------------------------------
+  struct RowShard {
+    std::mutex mMutex; ///< Mutex protecting the rows
+    std::vector<std::string> mValues; ///< Values read by the last refresh
+  };
+
+  //----------------------------------------------------------------------------
+  //! Values of one key for all rows
+  //----------------------------------------------------------------------------
+  struct Column {
+    std::string mKey; ///< Hash key
+    std::vector<std::string> mStrings; ///< Values as string
+    std::vector<long long> mLongs; ///< Values as long long
+    std::vector<double> mDoubles; ///< Values as double
+  };
+
+  //----------------------------------------------------------------------------
+  //! Convert the values read for a row
+  //----------------------------------------------------------------------------
+  void Store(eos::common::FileSystem::fsid_t fsid,
+             std::vector<std::string>& values);
+
+  eos::common::RWMutex mMutex; ///< Mutex protecting the layout of the table
+  mutable RowShard mRowShards[kRowShards]; ///< Mutexes of the rows
+  std::vector<std::string> mKeys; ///< Keys of all columns
+  std::map<std::string, size_t> mKeyColumn; ///< Map key to column
+  std::vector<Column> mColumns; ///< Columns
+  std::vector<unsigned long long> mChangeIds; ///< Change id of each row
+  std::vector<size_t> mNumColumns; ///< Number of columns read for each row
+  std::vector<char> mConsidered; ///< Row counted by the group averages
+  std::vector<char> mAvailable; ///< Row counted by the query sums
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
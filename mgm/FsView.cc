@@ -21,6 +21,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 
+#include <algorithm>
 #include <cfloat>
 #include "mgm/TableFormatter/TableFormatterBase.hh"
 #include "mgm/FsView.hh"
@@ -61,7 +62,7 @@ GeoTreeElement::~GeoTreeElement()
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-GeoTree::GeoTree() : pLevels(8)
+GeoTree::GeoTree() : pLevels(8), pGeneration(0)
 {
   pLevels.resize(1);
   pRoot = new tElement;
@@ -176,6 +177,7 @@ bool GeoTree::insert(const fsid_t& fs)
   if (!currentleaf->mFsIds.count(fs)) {
     currentleaf->mFsIds.insert(fs);
     pLeaves[fs] = currentleaf;
+    ++pGeneration;
   } else {
     return false;
   }
@@ -209,6 +211,7 @@ bool GeoTree::erase(const fsid_t& fs)
 
   pLeaves.erase(fs);
   leaf->mFsIds.erase(fs);
+  ++pGeneration;
   tElement* father = leaf;
 
   if (leaf->mFsIds.empty() && leaf->mSons.empty()) {
@@ -284,6 +287,36 @@ bool GeoTree::getGeoTagInTree(const fsid_t& fs , std::string& geoTag)
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Get the full geotag of the element whose FileSystems are the given set
+//------------------------------------------------------------------------------
+const std::string* GeoTree::getElementTag(const std::set<fsid_t>* fsids) const
+{
+  if (!fsids || fsids->empty()) {
+    return nullptr;
+  }
+
+  auto it = pLeaves.find(*fsids->begin());
+
+  if ((it == pLeaves.end()) || (&it->second->mFsIds != fsids)) {
+    return nullptr;
+  }
+
+  return &it->second->mFullTag;
+}
+
+//------------------------------------------------------------------------------
+// Get the full geotags of all the elements holding FileSystems
+//------------------------------------------------------------------------------
+void GeoTree::getElementTags(std::set<std::string>& tags) const
+{
+  tags.clear();
+
+  for (auto it = pLeaves.begin(); it != pLeaves.end(); it++) {
+    tags.insert(it->second->mFullTag);
+  }
+}
+
 //------------------------------------------------------------------------------
 // @brief Get the geotag of FileSystem
 // @param fs the fsid of the FileSystem
@@ -3064,6 +3097,122 @@ FsView::ApplyGlobalConfig(const char* key, std::string& val)
 }
 #endif
 
+//------------------------------------------------------------------------------
+// Refresh the state table rows of the members or of the subset
+//------------------------------------------------------------------------------
+void
+BaseView::RefreshMembers(const std::set<eos::common::FileSystem::fsid_t>*
+                         subset,
+                         std::vector<eos::common::FileSystem::fsid_t>& fsids,
+                         eos::common::RWMutexReadLock& table_lock)
+{
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  eos::common::FileSystem::fsid_t max_fsid = 0;
+  fsids.clear();
+
+  if (subset) {
+    fsids.assign(subset->begin(), subset->end());
+  } else {
+    fsids.reserve(size());
+
+    for (auto it = begin(); it != end(); it++) {
+      fsids.push_back(*it);
+    }
+  }
+
+  for (auto fsid : fsids) {
+    max_fsid = std::max(max_fsid, fsid);
+  }
+
+  // Rows are added with the table mutex locked exclusively
+  table.Reserve(max_fsid);
+  table_lock.Grab(table.GetMutex());
+
+  for (auto fsid : fsids) {
+    auto it = FsView::gFsView.mIdView.find(fsid);
+    table.Refresh(fsid, (it != FsView::gFsView.mIdView.end()) ? it->second :
+                  nullptr);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Bring the aggregates of the members or of a GeoTree element up to date
+//------------------------------------------------------------------------------
+const FsViewAggregate*
+BaseView::SyncAggregate(const std::set<eos::common::FileSystem::fsid_t>*
+                        subset, size_t col)
+{
+  WatchedAggregate* watched = &mAggregate;
+
+  if (subset) {
+    const std::string* tag = getElementTag(subset);
+
+    if (!tag) {
+      return nullptr;
+    }
+
+    // Drop the aggregates of the elements which left the tree
+    if (mElementGeneration != getGeneration()) {
+      std::set<std::string> tags;
+      getElementTags(tags);
+
+      for (auto it = mElementAggregates.begin();
+           it != mElementAggregates.end();) {
+        if (tags.count(it->first)) {
+          ++it;
+        } else {
+          it = mElementAggregates.erase(it);
+        }
+      }
+
+      mElementGeneration = getGeneration();
+    }
+
+    watched = &mElementAggregates[*tag];
+  }
+
+  XrdMqSharedObjectManager* som = eos::common::GlobalConfig::gConfig.SOM();
+  // Members join or leave the view, or their hashes are replaced
+  unsigned long long membership = (som ? som->GetHashGeneration() : 0) +
+                                  getGeneration();
+
+  if (membership != watched->mWatchedMembership) {
+    // Watchers of departed members stay attached and only cause refreshes
+    auto attach = [&](eos::common::FileSystem::fsid_t fsid) {
+      auto fs = FsView::gFsView.mIdView.find(fsid);
+
+      if (fs != FsView::gFsView.mIdView.end()) {
+        fs->second->AddChangeWatcher(watched->mChanges);
+      }
+    };
+
+    if (subset) {
+      for (auto fsid : *subset) {
+        attach(fsid);
+      }
+    } else {
+      for (auto it = begin(); it != end(); it++) {
+        attach(*it);
+      }
+    }
+
+    watched->mWatchedMembership = membership;
+  }
+
+  // All parts only grow, so their sum changes whenever one of them changes
+  unsigned long long stamp = watched->mChanges->load() + membership;
+
+  if (watched->mAggregate.IsStale(stamp, col)) {
+    std::vector<eos::common::FileSystem::fsid_t> fsids;
+    eos::common::RWMutexReadLock table_lock;
+    RefreshMembers(subset, fsids, table_lock);
+    watched->mAggregate.Update(FsView::gFsView.mStateTable, fsids,
+                               (mType != "groupview"), stamp, col);
+  }
+
+  return &watched->mAggregate;
+}
+
 //------------------------------------------------------------------------------
 // Computes the sum for <param> as long
 // param="<param>[?<key>=<value] allows to select with matches
@@ -3104,56 +3253,44 @@ BaseView::SumLongLong(const char* param, bool lock,
     }
   }
 
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      eos::common::FileSystem::fs_snapshot snapshot;
-
-      // for query sum's we always fold in that a group and host has to be enabled
-      if ((!key.length())
-          || (FsView::gFsView.mIdView[*it]->GetString(key.c_str()) == value)) {
-        if (isquery &&
-            ((!eos::common::FileSystem::GetActiveStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.active").c_str())) ||
-             (eos::common::FileSystem::GetStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.boot").c_str()) !=
-              eos::common::FileSystem::kBooted))) {
-          continue;
-        }
-
-        long long v = FsView::gFsView.mIdView[*it]->GetLongLong(sparam.c_str());
+  {
+    FsStateTable& table = FsView::gFsView.mStateTable;
+    size_t col = table.GetColumn(sparam);
+    const FsViewAggregate* aggregate = nullptr;
 
-        if (isquery && v && (sparam == "stat.statfs.capacity")) {
-          // Correct the capacity(rw) value for headroom
-          v -= FsView::gFsView.mIdView[*it]->GetLongLong("headroom");
-        }
+    if (!isquery) {
+      std::lock_guard<std::mutex> aggregate_lock(mAggregateMutex);
 
-        sum += v;
+      if ((aggregate = SyncAggregate(subset, col))) {
+        sum = aggregate->SumLongLong(col);
       }
     }
-  } else {
-    for (auto it = begin(); it != end(); it++) {
-      eos::common::FileSystem::fs_snapshot snapshot;
-
-      // for query sum's we always fold in that a group and host has to be enabled
-      if ((!key.length())
-          || (FsView::gFsView.mIdView[*it]->GetString(key.c_str()) == value)) {
-        if (isquery &&
-            ((!eos::common::FileSystem::GetActiveStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.active").c_str())) ||
-             (eos::common::FileSystem::GetStatusFromString(
-                FsView::gFsView.mIdView[*it]->GetString("stat.boot").c_str()) !=
-              eos::common::FileSystem::kBooted))) {
-          continue;
-        }
 
-        long long v = FsView::gFsView.mIdView[*it]->GetLongLong(sparam.c_str());
+    if (!aggregate) {
+      size_t key_col = (key.length() ? table.GetColumn(key) : 0);
+      size_t headroom_col = table.GetColumn("headroom");
+      std::vector<eos::common::FileSystem::fsid_t> fsids;
+      eos::common::RWMutexReadLock table_lock;
+      RefreshMembers(subset, fsids, table_lock);
 
-        if (isquery && v && (sparam == "stat.statfs.capacity")) {
-          // correct the capacity(rw) value for headroom
-          v -= FsView::gFsView.mIdView[*it]->GetLongLong("headroom");
-        }
+      for (auto fsid : fsids) {
+        std::lock_guard<std::mutex> row_lock(table.GetRowMutex(fsid));
+
+        // for query sum's we always fold in that a group and host has to be enabled
+        if ((!key.length()) || (table.GetString(fsid, key_col) == value)) {
+          if (isquery && !table.IsAvailable(fsid)) {
+            continue;
+          }
+
+          long long v = table.GetLongLong(fsid, col);
 
-        sum += v;
+          if (isquery && v && (sparam == "stat.statfs.capacity")) {
+            // Correct the capacity(rw) value for headroom
+            v -= table.GetLongLong(fsid, headroom_col);
+          }
+
+          sum += v;
+        }
       }
     }
   }
@@ -3202,14 +3339,22 @@ BaseView::SumDouble(const char* param, bool lock,
   }
 
   double sum = 0;
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  size_t col = table.GetColumn(param);
+  std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+  const FsViewAggregate* aggregate = SyncAggregate(subset, col);
 
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      sum += FsView::gFsView.mIdView[*it]->GetDouble(param);
-    }
+  if (aggregate) {
+    sum = aggregate->SumDouble(col);
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      sum += FsView::gFsView.mIdView[*it]->GetDouble(param);
+    aggregate_lock.unlock();
+    std::vector<eos::common::FileSystem::fsid_t> fsids;
+    eos::common::RWMutexReadLock table_lock;
+    RefreshMembers(subset, fsids, table_lock);
+
+    for (auto fsid : fsids) {
+      std::lock_guard<std::mutex> row_lock(table.GetRowMutex(fsid));
+      sum += table.GetDouble(fsid, col);
     }
   }
 
@@ -3233,58 +3378,66 @@ BaseView::AverageDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
-  double sum = 0;
-  int cnt = 0;
-
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+  double avg = 0;
+  // we only count filesystem which are >=kRO and booted for averages in the group view
+  bool all = (mType != "groupview");
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  size_t col = table.GetColumn(param);
+  std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+  const FsViewAggregate* aggregate = SyncAggregate(subset, col);
 
-      if (consider) {
-        cnt++;
-        sum += FsView::gFsView.mIdView[*it]->GetDouble(param);
-      }
-    }
+  if (aggregate) {
+    avg = aggregate->AverageDouble(col);
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+    aggregate_lock.unlock();
+    double sum = 0;
+    int cnt = 0;
+    std::vector<eos::common::FileSystem::fsid_t> fsids;
+    eos::common::RWMutexReadLock table_lock;
+    RefreshMembers(subset, fsids, table_lock);
 
-      if (consider) {
+    for (auto fsid : fsids) {
+      std::lock_guard<std::mutex> row_lock(table.GetRowMutex(fsid));
+
+      if (all || table.IsConsidered(fsid)) {
         cnt++;
-        sum += FsView::gFsView.mIdView[*it]->GetDouble(param);
+        sum += table.GetDouble(fsid, col);
       }
     }
+
+    avg = (cnt) ? (double)(1.0 * sum / cnt) : 0;
   }
 
   if (lock) {
     FsView::gFsView.ViewMutex.UnLockRead();
   }
 
-  return (cnt) ? (double)(1.0 * sum / cnt) : 0;
+  return avg;
+}
+
+//------------------------------------------------------------------------------
+// Collect the values of <param> of the counted members of a subset which is
+// not aggregated
+//------------------------------------------------------------------------------
+void
+BaseView::ScanCounted(size_t col,
+                      const std::set<eos::common::FileSystem::fsid_t>* subset,
+                      std::vector<double>& values)
+{
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  bool all = (mType != "groupview");
+  std::vector<eos::common::FileSystem::fsid_t> fsids;
+  eos::common::RWMutexReadLock table_lock;
+  RefreshMembers(subset, fsids, table_lock);
+  values.clear();
+
+  for (auto fsid : fsids) {
+    std::lock_guard<std::mutex> row_lock(table.GetRowMutex(fsid));
+
+    if (all || table.IsConsidered(fsid)) {
+      values.push_back(table.GetDouble(fsid, col));
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -3298,56 +3451,29 @@ BaseView::MaxAbsDeviation(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
-  double avg = AverageDouble(param, false);
   double maxabsdev = 0;
   double dev = 0;
-
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
-
-      dev = fabs(avg - FsView::gFsView.mIdView[*it]->GetDouble(param));
-
-      if (consider) {
-        if (dev > maxabsdev) {
-          maxabsdev = dev;
-        }
-      }
-    }
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  size_t col = table.GetColumn(param);
+  std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+  // Deviations of a subset are taken from the average of the whole view
+  const FsViewAggregate* members = SyncAggregate(nullptr, col);
+  double avg = members->AverageDouble(col);
+  const FsViewAggregate* aggregate = (subset ? SyncAggregate(subset, col) :
+                                      members);
+
+  if (aggregate) {
+    maxabsdev = aggregate->MaxAbsDeviation(col, avg);
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+    aggregate_lock.unlock();
+    std::vector<double> values;
+    ScanCounted(col, subset, values);
 
-      dev = fabs(avg - FsView::gFsView.mIdView[*it]->GetDouble(param));
+    for (auto v : values) {
+      dev = fabs(avg - v);
 
-      if (consider) {
-        if (dev > maxabsdev) {
-          maxabsdev = dev;
-        }
+      if (dev > maxabsdev) {
+        maxabsdev = dev;
       }
     }
   }
@@ -3371,56 +3497,28 @@ BaseView::MaxDeviation(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
-  double avg = AverageDouble(param, false);
   double maxdev = -DBL_MAX;
   double dev = 0;
-
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
-
-      dev = -(avg - FsView::gFsView.mIdView[*it]->GetDouble(param));
-
-      if (consider) {
-        if (dev > maxdev) {
-          maxdev = dev;
-        }
-      }
-    }
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  size_t col = table.GetColumn(param);
+  std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+  const FsViewAggregate* members = SyncAggregate(nullptr, col);
+  double avg = members->AverageDouble(col);
+  const FsViewAggregate* aggregate = (subset ? SyncAggregate(subset, col) :
+                                      members);
+
+  if (aggregate) {
+    maxdev = aggregate->MaxDeviation(col, avg);
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+    aggregate_lock.unlock();
+    std::vector<double> values;
+    ScanCounted(col, subset, values);
 
-      dev = -(avg - FsView::gFsView.mIdView[*it]->GetDouble(param));
+    for (auto v : values) {
+      dev = -(avg - v);
 
-      if (consider) {
-        if (dev > maxdev) {
-          maxdev = dev;
-        }
+      if (dev > maxdev) {
+        maxdev = dev;
       }
     }
   }
@@ -3443,56 +3541,28 @@ BaseView::MinDeviation(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
-  double avg = AverageDouble(param, false);
   double mindev = DBL_MAX;
   double dev = 0;
-
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
-
-      dev = -(avg - FsView::gFsView.mIdView[*it]->GetDouble(param));
-
-      if (consider) {
-        if (dev < mindev) {
-          mindev = dev;
-        }
-      }
-    }
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  size_t col = table.GetColumn(param);
+  std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+  const FsViewAggregate* members = SyncAggregate(nullptr, col);
+  double avg = members->AverageDouble(col);
+  const FsViewAggregate* aggregate = (subset ? SyncAggregate(subset, col) :
+                                      members);
+
+  if (aggregate) {
+    mindev = aggregate->MinDeviation(col, avg);
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+    aggregate_lock.unlock();
+    std::vector<double> values;
+    ScanCounted(col, subset, values);
 
-      dev = -(avg - FsView::gFsView.mIdView[*it]->GetDouble(param));
+    for (auto v : values) {
+      dev = -(avg - v);
 
-      if (consider) {
-        if (dev < mindev) {
-          mindev = dev;
-        }
+      if (dev < mindev) {
+        mindev = dev;
       }
     }
   }
@@ -3515,61 +3585,35 @@ BaseView::SigmaDouble(const char* param, bool lock,
     FsView::gFsView.ViewMutex.LockRead();
   }
 
-  double avg = AverageDouble(param, false);
-  double sumsquare = 0;
-  int cnt = 0;
+  double sigma = 0;
+  FsStateTable& table = FsView::gFsView.mStateTable;
+  size_t col = table.GetColumn(param);
+  std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+  const FsViewAggregate* members = SyncAggregate(nullptr, col);
+  double avg = members->AverageDouble(col);
+  const FsViewAggregate* aggregate = (subset ? SyncAggregate(subset, col) :
+                                      members);
 
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
-
-      if (consider) {
-        cnt++;
-        sumsquare += pow((avg - FsView::gFsView.mIdView[*it]->GetDouble(param)), 2);
-      }
-    }
+  if (aggregate) {
+    sigma = aggregate->SigmaDouble(col, avg);
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+    aggregate_lock.unlock();
+    double sumsquare = 0;
+    std::vector<double> values;
+    ScanCounted(col, subset, values);
 
-      if (consider) {
-        cnt++;
-        sumsquare += pow((avg - FsView::gFsView.mIdView[*it]->GetDouble(param)), 2);
-      }
+    for (auto v : values) {
+      sumsquare += pow((avg - v), 2);
     }
-  }
 
-  sumsquare = (cnt) ? sqrt(sumsquare / cnt) : 0;
+    sigma = (values.size()) ? sqrt(sumsquare / values.size()) : 0;
+  }
 
   if (lock) {
     FsView::gFsView.ViewMutex.UnLockRead();
   }
 
-  return sumsquare;
+  return sigma;
 }
 
 //------------------------------------------------------------------------------
@@ -3585,44 +3629,28 @@ BaseView::ConsiderCount(bool lock,
 
   long long cnt = 0;
 
-  if (subset) {
-    for (auto it = subset->begin(); it != subset->end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
-
-      if (consider) {
-        cnt++;
-      }
-    }
+  if (mType != "groupview") {
+    cnt = (subset ? subset->size() : size());
   } else {
-    for (auto it = begin(); it != end(); it++) {
-      bool consider = true;
-
-      if (mType == "groupview") {
-        // we only count filesystem which are >=kRO and booted for averages in the group view
-        if ((FsView::gFsView.mIdView[*it]->GetConfigStatus() <
-             eos::common::FileSystem::kRO) ||
-            (FsView::gFsView.mIdView[*it]->GetStatus() != eos::common::FileSystem::kBooted)
-            ||
-            (FsView::gFsView.mIdView[*it]->GetActiveStatus() ==
-             eos::common::FileSystem::kOffline)) {
-          consider = false;
-        }
-      }
+    std::unique_lock<std::mutex> aggregate_lock(mAggregateMutex);
+    const FsViewAggregate* aggregate =
+      SyncAggregate(subset, FsViewAggregate::kNoColumn);
 
-      if (consider) {
-        cnt++;
+    if (aggregate) {
+      cnt = aggregate->GetCountedCount();
+    } else {
+      aggregate_lock.unlock();
+      FsStateTable& table = FsView::gFsView.mStateTable;
+      std::vector<eos::common::FileSystem::fsid_t> fsids;
+      eos::common::RWMutexReadLock table_lock;
+      RefreshMembers(subset, fsids, table_lock);
+
+      for (auto fsid : fsids) {
+        std::lock_guard<std::mutex> row_lock(table.GetRowMutex(fsid));
+
+        if (table.IsConsidered(fsid)) {
+          cnt++;
+        }
       }
     }
   }
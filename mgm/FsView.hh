@@ -26,6 +26,8 @@
 
 #include "mgm/Namespace.hh"
 #include "mgm/FileSystem.hh"
+#include "mgm/FsStateTable.hh"
+#include "mgm/FsViewAggregate.hh"
 #include "common/RWMutex.hh"
 #include "common/SymKeys.hh"
 #include "common/Logging.hh"
@@ -38,6 +40,7 @@
 #include <sys/mount.h>
 #endif
 #include <map>
+#include <mutex>
 #include <set>
 #ifndef EOSMGMFSVIEWTEST
 #include "mgm/IConfigEngine.hh"
@@ -161,6 +164,9 @@ class GeoTree
   //! All the leaves of the tree
   std::map<fsid_t, tElement*> pLeaves;
 
+  //! Number of insertions and removals
+  unsigned long long pGeneration;
+
   //----------------------------------------------------------------------------
   //! Get the geotag of FileSystem
   //----------------------------------------------------------------------------
@@ -193,11 +199,30 @@ public:
   //----------------------------------------------------------------------------
   bool getGeoTagInTree(const fsid_t& fs , std::string& geoTag);
 
+  //----------------------------------------------------------------------------
+  //! Get the full geotag of the element of the tree whose FileSystems are the
+  //! given set, nullptr if the set doesn't belong to an element of the tree
+  //----------------------------------------------------------------------------
+  const std::string* getElementTag(const std::set<fsid_t>* fsids) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the full geotags of all the elements holding FileSystems
+  //----------------------------------------------------------------------------
+  void getElementTags(std::set<std::string>& tags) const;
+
   //----------------------------------------------------------------------------
   //! Number of FileSystems in the tree
   //----------------------------------------------------------------------------
   size_t size() const;
 
+  //----------------------------------------------------------------------------
+  //! Generation of the tree, it changes with every insertion and removal
+  //----------------------------------------------------------------------------
+  unsigned long long getGeneration() const
+  {
+    return pGeneration;
+  }
+
   //----------------------------------------------------------------------------
   //! STL const_iterator class
   //!
@@ -284,6 +309,37 @@ private:
   //! Number of items in queue (meaning depends on inheritor)
   size_t mInQueue;
 
+  //----------------------------------------------------------------------------
+  //! Aggregates of a set of members and the watcher of their hashes
+  //----------------------------------------------------------------------------
+  struct WatchedAggregate {
+    //! Aggregates of the members
+    FsViewAggregate mAggregate;
+
+    //! Incremented by every change of the hash of a member
+    XrdMqSharedHash::Watcher mChanges;
+
+    //! Membership generation at which mChanges was attached to the members
+    unsigned long long mWatchedMembership;
+
+    WatchedAggregate():
+      mChanges(std::make_shared<std::atomic<unsigned long long>>(0)),
+      mWatchedMembership(~0ull)
+    {}
+  };
+
+  //! Mutex protecting the aggregates
+  std::mutex mAggregateMutex;
+
+  //! Aggregates of all the members
+  WatchedAggregate mAggregate;
+
+  //! Aggregates of the members attached to each GeoTree element by geotag
+  std::map<std::string, WatchedAggregate> mElementAggregates;
+
+  //! Tree generation at which the element aggregates were last pruned
+  unsigned long long mElementGeneration;
+
 public:
 
   std::string mName; ///< Name of the base view
@@ -297,6 +353,7 @@ public:
     mStatus = "unknown";
     mHeartBeat = 0;
     mInQueue = 0;
+    mElementGeneration = 0;
   }
 
   //----------------------------------------------------------------------------
@@ -442,6 +499,50 @@ public:
   //----------------------------------------------------------------------------
   long long TotalCount(bool lock,
                        const std::set<eos::common::FileSystem::fsid_t>* subset);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Refresh the state table rows of the members, or of the subset if given,
+  //! and collect their ids. The caller has to hold the ViewMutex but not the
+  //! state table mutex, which is returned locked shared.
+  //!
+  //! @param subset subset of the members or nullptr
+  //! @param fsids ids of the refreshed rows
+  //! @param table_lock lock taking the state table mutex
+  //----------------------------------------------------------------------------
+  void RefreshMembers(const std::set<eos::common::FileSystem::fsid_t>* subset,
+                      std::vector<eos::common::FileSystem::fsid_t>& fsids,
+                      eos::common::RWMutexReadLock& table_lock);
+
+  //----------------------------------------------------------------------------
+  //! Bring the aggregates of the members, or of the GeoTree element holding
+  //! the subset, up to date. They are only refreshed if a member hash changed,
+  //! which is tracked with a watcher attached to the hashes of the members,
+  //! or if the membership changed. Other subsets and ?key@value queries are
+  //! not aggregated and scan the state table. The caller has to hold the
+  //! ViewMutex and mAggregateMutex but not the state table mutex.
+  //!
+  //! @param subset subset of the members or nullptr
+  //! @param col state table column needed or FsViewAggregate::kNoColumn
+  //!
+  //! @return aggregates, nullptr if the subset is not a GeoTree element
+  //----------------------------------------------------------------------------
+  const FsViewAggregate*
+  SyncAggregate(const std::set<eos::common::FileSystem::fsid_t>* subset,
+                size_t col);
+
+  //----------------------------------------------------------------------------
+  //! Collect the values of a state table column for the counted members of a
+  //! subset which is not aggregated. The caller has to hold the ViewMutex but
+  //! not the state table mutex.
+  //!
+  //! @param col state table column
+  //! @param subset subset of the members
+  //! @param values values of the counted members
+  //----------------------------------------------------------------------------
+  void ScanCounted(size_t col,
+                   const std::set<eos::common::FileSystem::fsid_t>* subset,
+                   std::vector<double>& values);
 };
 
 //------------------------------------------------------------------------------
@@ -818,6 +919,9 @@ public:
   //! Map translating a filesystem object pointer to a filesystem ID
   std::map<FileSystem*, eos::common::FileSystem::fsid_t> mFileSystemView;
 
+  //! Typed values of the filesystems used by the view aggregations
+  FsStateTable mStateTable;
+
   //! Mutex protecting the set of gateway nodes mGwNodes
   eos::common::RWMutex GwMutex;
 
@@ -0,0 +1,451 @@
+//------------------------------------------------------------------------------
+// File: FsViewAggregate.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/FsViewAggregate.hh"
+#include <algorithm>
+#include <cmath>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr size_t FsViewAggregate::kNoColumn;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FsViewAggregate::FsViewAggregate():
+  mCounted(0), mStamp(0), mMark(0), mAllCounted(true)
+{}
+
+//------------------------------------------------------------------------------
+// Add a value to a running sum
+//------------------------------------------------------------------------------
+void
+FsViewAggregate::RunningSum::Add(double value)
+{
+  double sum = mSum + value;
+
+  if (fabs(mSum) >= fabs(value)) {
+    mCompensation += (mSum - sum) + value;
+  } else {
+    mCompensation += (value - sum) + mSum;
+  }
+
+  mSum = sum;
+}
+
+//------------------------------------------------------------------------------
+// Get the index of a table column in mColumns
+//------------------------------------------------------------------------------
+size_t
+FsViewAggregate::Find(size_t col) const
+{
+  size_t i = 0;
+
+  while ((i < mColumns.size()) && (mColumns[i].mColumn != col)) {
+    ++i;
+  }
+
+  return i;
+}
+
+//------------------------------------------------------------------------------
+// Check if the aggregates have to be updated
+//------------------------------------------------------------------------------
+bool
+FsViewAggregate::IsStale(unsigned long long stamp, size_t col) const
+{
+  if (stamp != mStamp) {
+    return true;
+  }
+
+  return ((col != kNoColumn) && (Find(col) == mColumns.size()));
+}
+
+//------------------------------------------------------------------------------
+// Read the values of a member from the table
+//------------------------------------------------------------------------------
+void
+FsViewAggregate::Read(const FsStateTable& table,
+                      eos::common::FileSystem::fsid_t fsid, bool all_counted,
+                      Member& member) const
+{
+  member.mChangeId = table.GetChangeId(fsid);
+  member.mCounted = (all_counted || table.IsConsidered(fsid));
+  member.mLongs.resize(mColumns.size());
+  member.mDoubles.resize(mColumns.size());
+
+  for (size_t i = 0; i < mColumns.size(); ++i) {
+    member.mLongs[i] = table.GetLongLong(fsid, mColumns[i].mColumn);
+    member.mDoubles[i] = table.GetDouble(fsid, mColumns[i].mColumn);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add or subtract the contribution of a member to the aggregates
+//------------------------------------------------------------------------------
+void
+FsViewAggregate::Apply(const Member& member, bool add)
+{
+  if (member.mCounted) {
+    mCounted += (add ? 1 : -1);
+  }
+
+  for (size_t i = 0; i < mColumns.size(); ++i) {
+    Column& column = mColumns[i];
+
+    // Unsigned arithmetic wraps around like the sum of the members would
+    if (add) {
+      column.mLongSum += (unsigned long long) member.mLongs[i];
+    } else {
+      column.mLongSum -= (unsigned long long) member.mLongs[i];
+      ++column.mReplaced;
+    }
+
+    double value = member.mDoubles[i];
+
+    if (!std::isfinite(value)) {
+      column.mNonFinite += (add ? 1 : -1);
+      continue;
+    }
+
+    double sign = (add ? 1.0 : -1.0);
+    column.mSum.Add(sign * value);
+
+    if (member.mCounted) {
+      double dist = value - column.mShift;
+      column.mCountedSum.Add(sign * value);
+      column.mSquares.Add(sign * dist * dist);
+
+      if (add) {
+        column.mCountedValues.insert(value);
+      } else {
+        column.mCountedValues.erase(column.mCountedValues.find(value));
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Recompute the running double sums of a column from the members
+//------------------------------------------------------------------------------
+void
+FsViewAggregate::Rebuild(Column& column, size_t i)
+{
+  column.mSum = RunningSum();
+  column.mCountedSum = RunningSum();
+  column.mSquares = RunningSum();
+
+  for (const auto& it : mMembers) {
+    double value = it.second.mDoubles[i];
+
+    if (std::isfinite(value)) {
+      column.mSum.Add(value);
+
+      if (it.second.mCounted) {
+        column.mCountedSum.Add(value);
+      }
+    }
+  }
+
+  // Squares around the current average stay well conditioned
+  column.mShift = (column.mCountedValues.empty() ? 0 :
+                   column.mCountedSum.Get() / column.mCountedValues.size());
+
+  for (const auto& it : mMembers) {
+    double value = it.second.mDoubles[i];
+
+    if (it.second.mCounted && std::isfinite(value)) {
+      double dist = value - column.mShift;
+      column.mSquares.Add(dist * dist);
+    }
+  }
+
+  column.mReplaced = 0;
+}
+
+//------------------------------------------------------------------------------
+// Update the aggregates with the current members of the view
+//------------------------------------------------------------------------------
+void
+FsViewAggregate::Update(const FsStateTable& table,
+                        const std::vector<eos::common::FileSystem::fsid_t>& fsids,
+                        bool all_counted, unsigned long long stamp, size_t col)
+{
+  bool changed = (all_counted != mAllCounted);
+
+  if ((col != kNoColumn) && (Find(col) == mColumns.size())) {
+    mColumns.emplace_back();
+    mColumns.back().mColumn = col;
+    changed = true;
+  }
+
+  if (changed) {
+    for (auto& column : mColumns) {
+      size_t id = column.mColumn;
+      column = Column();
+      column.mColumn = id;
+    }
+
+    mMembers.clear();
+    mCounted = 0;
+    mAllCounted = all_counted;
+  }
+
+  ++mMark;
+
+  for (auto fsid : fsids) {
+    std::lock_guard<std::mutex> row_lock(table.GetRowMutex(fsid));
+    auto it = mMembers.find(fsid);
+
+    if (it == mMembers.end()) {
+      Member& member = mMembers[fsid];
+      Read(table, fsid, all_counted, member);
+      Apply(member, true);
+      member.mMark = mMark;
+      continue;
+    }
+
+    Member& member = it->second;
+    member.mMark = mMark;
+
+    if (member.mChangeId != table.GetChangeId(fsid)) {
+      Apply(member, false);
+      Read(table, fsid, all_counted, member);
+      Apply(member, true);
+    }
+  }
+
+  // Drop the members which left the view
+  if (mMembers.size() != fsids.size()) {
+    for (auto it = mMembers.begin(); it != mMembers.end();) {
+      if (it->second.mMark != mMark) {
+        Apply(it->second, false);
+        it = mMembers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < mColumns.size(); ++i) {
+    Column& column = mColumns[i];
+    size_t n = column.mCountedValues.size();
+    bool far = false;
+
+    if (n) {
+      // Squares taken far from the values lose their precision in Compute
+      double mean = column.mCountedSum.Get() / n;
+      double offset = mean - column.mShift;
+      double variance = column.mSquares.Get() / n - offset * offset;
+      far = (offset * offset > 1024 * std::max(variance,
+                                               DBL_EPSILON * mean * mean));
+    }
+
+    if (changed || far || (column.mReplaced > mMembers.size())) {
+      Rebuild(column, i);
+    }
+  }
+
+  mStamp = stamp;
+}
+
+//------------------------------------------------------------------------------
+// Get the double results of a column
+//------------------------------------------------------------------------------
+FsViewAggregate::Results
+FsViewAggregate::Compute(size_t col, const double* ref) const
+{
+  Results results;
+  size_t i = Find(col);
+
+  if (i == mColumns.size()) {
+    return results;
+  }
+
+  const Column& column = mColumns[i];
+
+  if (column.mNonFinite) {
+    // NaN and infinities propagate like in a pass over the values
+    double counted_sum = 0;
+    int cnt = 0;
+
+    for (const auto& it : mMembers) {
+      results.mSum += it.second.mDoubles[i];
+
+      if (it.second.mCounted) {
+        cnt++;
+        counted_sum += it.second.mDoubles[i];
+      }
+    }
+
+    results.mAverage = (cnt) ? (double)(1.0 * counted_sum / cnt) : 0;
+    double avg = (ref ? *ref : results.mAverage);
+    double sumsquare = 0;
+    double dev = 0;
+
+    for (const auto& it : mMembers) {
+      if (it.second.mCounted) {
+        sumsquare += pow((avg - it.second.mDoubles[i]), 2);
+        dev = fabs(avg - it.second.mDoubles[i]);
+
+        if (dev > results.mMaxAbsDev) {
+          results.mMaxAbsDev = dev;
+        }
+
+        dev = -(avg - it.second.mDoubles[i]);
+
+        if (dev > results.mMaxDev) {
+          results.mMaxDev = dev;
+        }
+
+        if (dev < results.mMinDev) {
+          results.mMinDev = dev;
+        }
+      }
+    }
+
+    results.mSigma = (cnt) ? sqrt(sumsquare / cnt) : 0;
+    return results;
+  }
+
+  results.mSum = column.mSum.Get();
+
+  if (mCounted) {
+    results.mAverage = column.mCountedSum.Get() / mCounted;
+    double avg = (ref ? *ref : results.mAverage);
+    // Mean square distance to avg from the one to the shift:
+    // sum((x - avg)^2) = sum((x - s)^2) - 2 (avg - s) sum(x - s) + n (avg - s)^2
+    double offset = avg - column.mShift;
+    double mean_offset = results.mAverage - column.mShift;
+    double variance = column.mSquares.Get() / mCounted - 2 * offset * mean_offset
+                      + offset * offset;
+    results.mSigma = ((variance > 0) ? sqrt(variance) : 0);
+    results.mMaxDev = *column.mCountedValues.rbegin() - avg;
+    results.mMinDev = *column.mCountedValues.begin() - avg;
+    results.mMaxAbsDev = std::max(0.0, std::max(results.mMaxDev,
+                                  -results.mMinDev));
+  }
+
+  return results;
+}
+
+//------------------------------------------------------------------------------
+// Sum of a column over all members as long long
+//------------------------------------------------------------------------------
+long long
+FsViewAggregate::SumLongLong(size_t col) const
+{
+  size_t i = Find(col);
+  return ((i < mColumns.size()) ? (long long) mColumns[i].mLongSum : 0);
+}
+
+//------------------------------------------------------------------------------
+// Sum of a column over all members as double
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::SumDouble(size_t col) const
+{
+  return Compute(col).mSum;
+}
+
+//------------------------------------------------------------------------------
+// Average of a column over the counted members
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::AverageDouble(size_t col) const
+{
+  return Compute(col).mAverage;
+}
+
+//------------------------------------------------------------------------------
+// Standard deviation of a column over the counted members
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::SigmaDouble(size_t col) const
+{
+  return Compute(col).mSigma;
+}
+
+//------------------------------------------------------------------------------
+// Maximum absolute deviation from the average over the counted members
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::MaxAbsDeviation(size_t col) const
+{
+  return Compute(col).mMaxAbsDev;
+}
+
+//------------------------------------------------------------------------------
+// Maximum deviation from the average over the counted members
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::MaxDeviation(size_t col) const
+{
+  return Compute(col).mMaxDev;
+}
+
+//------------------------------------------------------------------------------
+// Minimum deviation from the average over the counted members
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::MinDeviation(size_t col) const
+{
+  return Compute(col).mMinDev;
+}
+
+//------------------------------------------------------------------------------
+// Root mean square deviation of the counted members from a reference average
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::SigmaDouble(size_t col, double avg) const
+{
+  return Compute(col, &avg).mSigma;
+}
+
+//------------------------------------------------------------------------------
+// Maximum absolute deviation of the counted members from a reference average
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::MaxAbsDeviation(size_t col, double avg) const
+{
+  return Compute(col, &avg).mMaxAbsDev;
+}
+
+//------------------------------------------------------------------------------
+// Maximum deviation of the counted members from a reference average
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::MaxDeviation(size_t col, double avg) const
+{
+  return Compute(col, &avg).mMaxDev;
+}
+
+//------------------------------------------------------------------------------
+// Minimum deviation of the counted members from a reference average
+//------------------------------------------------------------------------------
+double
+FsViewAggregate::MinDeviation(size_t col, double avg) const
+{
+  return Compute(col, &avg).mMinDev;
+}
+
+EOSMGMNAMESPACE_END
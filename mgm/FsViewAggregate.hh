@@ -0,0 +1,255 @@
+//------------------------------------------------------------------------------
+// File: FsViewAggregate.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_FSVIEWAGGREGATE__HH__
+#define __EOSMGM_FSVIEWAGGREGATE__HH__
+
+#include "mgm/Namespace.hh"
+#include "mgm/FsStateTable.hh"
+#include <cfloat>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FsViewAggregate
+//!
+//! @brief Cached aggregates of the state table columns over the members of a
+//! view or of a GeoTree element. Every member keeps the values it was last
+//! read with, so that when the view changes only the members whose row
+//! changed are read again and their old contribution is replaced.
+//!
+//! Long long sums and the number of counted members are exact. For doubles
+//! the aggregate keeps running compensated sums, a sum of squares shifted by
+//! a reference value and the ordered counted values, so that every result is
+//! available without a pass over the members. The running sums are rebuilt
+//! from the members once the number of replaced contributions exceeds the
+//! number of members, or once the average moved far from the reference value
+//! of the squares, which bounds the rounding error at an amortized constant
+//! cost. Non-finite values are counted apart and, while present,
+//! the double results of the column are computed by a pass over the members.
+//!
+//! "Counted" members are the ones considered for averages: all members, or
+//! for group views only those which are at least read-only, booted and
+//! online. The caller has to serialize the access to the aggregate and to
+//! hold the state table mutex shared while updating it.
+//------------------------------------------------------------------------------
+class FsViewAggregate
+{
+public:
+  //! Column argument of updates which don't need any column
+  static constexpr size_t kNoColumn = ~((size_t) 0);
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  FsViewAggregate();
+
+  //----------------------------------------------------------------------------
+  //! Check if the aggregates have to be updated
+  //!
+  //! @param stamp current change stamp of the members
+  //! @param col table column needed by the query
+  //----------------------------------------------------------------------------
+  bool IsStale(unsigned long long stamp, size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Update the aggregates with the current members of the view, whose rows
+  //! must be up to date in the table
+  //!
+  //! @param table state table
+  //! @param fsids current members
+  //! @param all_counted if true all members are counted for averages
+  //! @param stamp change stamp the members correspond to
+  //! @param col table column to aggregate if not aggregated yet, or kNoColumn
+  //----------------------------------------------------------------------------
+  void Update(const FsStateTable& table,
+              const std::vector<eos::common::FileSystem::fsid_t>& fsids,
+              bool all_counted, unsigned long long stamp, size_t col);
+
+  //----------------------------------------------------------------------------
+  //! Number of members
+  //----------------------------------------------------------------------------
+  inline size_t GetCount() const
+  {
+    return mMembers.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of counted members
+  //----------------------------------------------------------------------------
+  inline long long GetCountedCount() const
+  {
+    return mCounted;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Sum of a column over all members as long long
+  //----------------------------------------------------------------------------
+  long long SumLongLong(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Sum of a column over all members as double
+  //----------------------------------------------------------------------------
+  double SumDouble(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Average of a column over the counted members, 0 if there are none
+  //----------------------------------------------------------------------------
+  double AverageDouble(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Standard deviation of a column over the counted members
+  //----------------------------------------------------------------------------
+  double SigmaDouble(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Maximum absolute deviation from the average over the counted members
+  //----------------------------------------------------------------------------
+  double MaxAbsDeviation(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Maximum deviation from the average over the counted members
+  //----------------------------------------------------------------------------
+  double MaxDeviation(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Minimum deviation from the average over the counted members
+  //----------------------------------------------------------------------------
+  double MinDeviation(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Deviations of the counted members from a reference average, e.g. the one
+  //! of the whole view for the members of a GeoTree element
+  //!
+  //! @param col table column
+  //! @param avg reference average
+  //----------------------------------------------------------------------------
+  double SigmaDouble(size_t col, double avg) const;
+  double MaxAbsDeviation(size_t col, double avg) const;
+  double MaxDeviation(size_t col, double avg) const;
+  double MinDeviation(size_t col, double avg) const;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Running sum of doubles with Neumaier compensation
+  //----------------------------------------------------------------------------
+  struct RunningSum {
+    double mSum = 0; ///< Sum
+    double mCompensation = 0; ///< Lost low order bits of the sum
+
+    //--------------------------------------------------------------------------
+    //! Add a value
+    //--------------------------------------------------------------------------
+    void Add(double value);
+
+    //--------------------------------------------------------------------------
+    //! Get the compensated sum
+    //--------------------------------------------------------------------------
+    inline double Get() const
+    {
+      return mSum + mCompensation;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  //! Double results of one column
+  //----------------------------------------------------------------------------
+  struct Results {
+    double mSum = 0; ///< Sum of all members
+    double mAverage = 0; ///< Average of the counted members
+    double mSigma = 0; ///< Root mean square deviation from the reference
+    double mMaxAbsDev = 0; ///< Maximum absolute deviation
+    double mMaxDev = -DBL_MAX; ///< Maximum deviation
+    double mMinDev = DBL_MAX; ///< Minimum deviation
+  };
+
+  //----------------------------------------------------------------------------
+  //! Aggregates of one column
+  //----------------------------------------------------------------------------
+  struct Column {
+    size_t mColumn = 0; ///< Table column
+    unsigned long long mLongSum = 0; ///< Sum as long long of all members
+    RunningSum mSum; ///< Sum of the finite values of all members
+    RunningSum mCountedSum; ///< Sum of the finite counted values
+    RunningSum mSquares; ///< Sum of the squared distances to mShift
+    double mShift = 0; ///< Reference value of the squares
+    std::multiset<double> mCountedValues; ///< Finite counted values
+    long long mNonFinite = 0; ///< Number of members with a non-finite value
+    size_t mReplaced = 0; ///< Contributions removed since the last rebuild
+  };
+
+  //----------------------------------------------------------------------------
+  //! Values contributed by a member
+  //----------------------------------------------------------------------------
+  struct Member {
+    unsigned long long mChangeId = 0; ///< Table change id of the values
+    unsigned long long mMark = 0; ///< Last update which saw the member
+    bool mCounted = false; ///< Member counted for averages
+    std::vector<long long> mLongs; ///< Values per aggregated column
+    std::vector<double> mDoubles; ///< Values per aggregated column
+  };
+
+  //----------------------------------------------------------------------------
+  //! Add or subtract the contribution of a member to the aggregates
+  //----------------------------------------------------------------------------
+  void Apply(const Member& member, bool add);
+
+  //----------------------------------------------------------------------------
+  //! Recompute the running double sums of a column from the members
+  //----------------------------------------------------------------------------
+  void Rebuild(Column& column, size_t i);
+
+  //----------------------------------------------------------------------------
+  //! Read the values of a member from the table
+  //----------------------------------------------------------------------------
+  void Read(const FsStateTable& table, eos::common::FileSystem::fsid_t fsid,
+            bool all_counted, Member& member) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the index of a table column in mColumns, mColumns.size() if it is
+  //! not aggregated
+  //----------------------------------------------------------------------------
+  size_t Find(size_t col) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the double results of a column
+  //!
+  //! @param col table column
+  //! @param ref reference average of the deviations, nullptr for the average
+  //!        of the counted members
+  //----------------------------------------------------------------------------
+  Results Compute(size_t col, const double* ref = nullptr) const;
+
+  std::vector<Column> mColumns; ///< Aggregated columns
+  std::unordered_map<eos::common::FileSystem::fsid_t, Member> mMembers;
+  long long mCounted; ///< Number of counted members
+  unsigned long long mStamp; ///< Change stamp of the last update
+  unsigned long long mMark; ///< Number of update passes
+  bool mAllCounted; ///< Counting mode of the last update
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
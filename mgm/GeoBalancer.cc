@@ -25,6 +25,7 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/XrdMgmOfsDirectory.hh"
 #include "mgm/FsView.hh"
+#include "mgm/Converter.hh"
 #include "mgm/Master.hh"
 #include "namespace/interface/IFsView.hh"
 #include "namespace/interface/IView.hh"
@@ -312,11 +313,11 @@ GeoBalancer::getFileProcTransferNameAndSize(eos::common::FileId::fileid_t fid,
     uint64_t* size)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Produces a file conversion path to be placed in the proc directory
+ * @brief Produces a file conversion job name to be queued to the converter
  *        and also returns its size
  * @param fid the file ID
  * @param size return address for the size of the file
- * @return the file path
+ * @return the conversion job name
  */
 /*----------------------------------------------------------------------------*/
 {
@@ -371,8 +372,7 @@ GeoBalancer::getFileProcTransferNameAndSize(eos::common::FileId::fileid_t fid,
   }
   snprintf(fileName,
            1024,
-           "%s/%016llx:%s#%08lx",
-           gOFS->MgmProcConversionPath.c_str(),
+           "%016llx:%s#%08lx",
            fileid,
            mSpaceName.c_str(),
            (unsigned long) layoutid);
@@ -384,21 +384,15 @@ void
 GeoBalancer::updateTransferList()
 /*----------------------------------------------------------------------------*/
 /**
- * @brief For each entry in mTransfers, checks if the files' paths exist, if
- *        they don't, they are deleted from the mTransfers
+ * @brief For each entry in mTransfers, checks if the conversion job is still
+ *        queued or running, if not it is deleted from the mTransfers
  */
 /*----------------------------------------------------------------------------*/
 {
   std::map<eos::common::FileId::fileid_t, std::string>::iterator it;
 
   for (it = mTransfers.begin(); it != mTransfers.end();) {
-    eos::common::Mapping::VirtualIdentity rootvid;
-    eos::common::Mapping::Root(rootvid);
-    XrdOucErrInfo error;
-    const std::string& fileName = (*it).second;
-    struct stat buf;
-
-    if (gOFS->_stat(fileName.c_str(), &buf, error, rootvid, "")) {
+    if (!Converter::IsScheduled((*it).second)) {
       mTransfers.erase(it++);
     } else {
       ++it;
@@ -414,7 +408,7 @@ GeoBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
                               const std::string& fromGeotag)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Creates the conversion file in proc for the file ID, from the given
+ * @brief Queues the conversion job for the file ID, from the given
  *        fromGeotag (updates the cache structures)
  * @param fid the id of the file to be transferred
  * @param fromGeotag the geotag of the location where the file is located
@@ -422,9 +416,6 @@ GeoBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
  */
 /*----------------------------------------------------------------------------*/
 {
-  eos::common::Mapping::VirtualIdentity rootvid;
-  eos::common::Mapping::Root(rootvid);
-  XrdOucErrInfo mError;
   uint64_t size = 0;
   std::string fileName = getFileProcTransferNameAndSize(fid, &size);
 
@@ -432,7 +423,7 @@ GeoBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
     return false;
   }
 
-  if (!gOFS->_touch(fileName.c_str(), mError, rootvid, 0)) {
+  if (Converter::Schedule(fileName)) {
     eos_static_info("scheduledfile=%s", fileName.c_str());
   } else {
     eos_static_err("msg=\"failed to schedule transfer\" schedulingfile=\"%s\"",
@@ -488,22 +479,13 @@ GeoBalancer::chooseFidFromGeotag(const std::string& geotag)
     return -1;
   }
 
-  int attempts = 10;
-
-  while (attempts-- > 0) {
-    rndIndex = getRandom(fsid_size - 1);
-
-    for (auto it_fid = gOFS->eosFsView->getFileList(fsid);
-         (it_fid && it_fid->valid()); it_fid->next()) {
-      // Jump to random location
-      if (rndIndex > 0) {
-        --rndIndex;
-        continue;
-      }
+  // Pick a few random files, skipping the ones already scheduled
+  std::vector<eos::IFileMD::id_t> fids;
+  gOFS->eosFsView->getRandomFiles(fsid, 10, fids);
 
-      if (mTransfers.count(it_fid->getElement()) == 0) {
-        return it_fid->getElement();
-      }
+  for (auto fid : fids) {
+    if (mTransfers.count(fid) == 0) {
+      return fid;
     }
   }
 
@@ -25,6 +25,7 @@
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/XrdMgmOfsDirectory.hh"
 #include "mgm/FsView.hh"
+#include "mgm/Converter.hh"
 #include "mgm/Master.hh"
 #include "namespace/interface/IFsView.hh"
 #include "namespace/interface/IView.hh"
@@ -315,13 +316,13 @@ GroupBalancer::getFileProcTransferNameAndSize(eos::common::FileId::fileid_t fid,
     uint64_t* size)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Produces a file conversion path to be placed in the proc directory
+ * @brief Produces a file conversion job name to be queued to the converter
  *        taking into account the given group and also returns its size
  * @param fid the file ID
  * @param group the group to which the file will be transferred
  * @param size return address for the size of the file
  *
- * @return name of the proc transfer file
+ * @return name of the conversion job
  */
 /*----------------------------------------------------------------------------*/
 {
@@ -360,8 +361,7 @@ GroupBalancer::getFileProcTransferNameAndSize(eos::common::FileId::fileid_t fid,
       return std::string("");
     }
   }
-  snprintf(fileName, 1024, "%s/%016llx:%s#%08lx",
-           gOFS->MgmProcConversionPath.c_str(),
+  snprintf(fileName, 1024, "%016llx:%s#%08lx",
            fileid, group->mName.c_str(), (unsigned long) layoutid);
   return std::string(fileName);
 }
@@ -371,19 +371,13 @@ void
 GroupBalancer::updateTransferList()
 /*----------------------------------------------------------------------------*/
 /**
- * @brief For each entry in mTransfers, checks if the files' paths exist, if
- *        they don't, they are deleted from the mTransfers
+ * @brief For each entry in mTransfers, checks if the conversion job is still
+ *        queued or running, if not it is deleted from the mTransfers
  */
 /*----------------------------------------------------------------------------*/
 {
   for (auto it = mTransfers.begin(); it != mTransfers.end();) {
-    eos::common::Mapping::VirtualIdentity rootvid;
-    eos::common::Mapping::Root(rootvid);
-    XrdOucErrInfo error;
-    const std::string& fileName = (*it).second;
-    struct stat buf;
-
-    if (gOFS->_stat(fileName.c_str(), &buf, error, rootvid, "")) {
+    if (!Converter::IsScheduled((*it).second)) {
       mTransfers.erase(it++);
     } else {
       ++it;
@@ -400,7 +394,7 @@ GroupBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
                                 FsGroup* targetGroup)
 /*----------------------------------------------------------------------------*/
 /**
- * @brief Creates the conversion file in proc for the file ID, from the given
+ * @brief Queues the conversion job for the file ID, from the given
  *        sourceGroup, to the targetGroup (and updates the cache structures)
  * @param fid the id of the file to be transferred
  * @param sourceGroup the group where the file is currently located
@@ -415,9 +409,6 @@ GroupBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
     return;
   }
 
-  eos::common::Mapping::VirtualIdentity rootvid;
-  eos::common::Mapping::Root(rootvid);
-  XrdOucErrInfo mError;
   uint64_t size = -1;
   std::string fileName = getFileProcTransferNameAndSize(fid, targetGroup, &size);
 
@@ -425,7 +416,7 @@ GroupBalancer::scheduleTransfer(eos::common::FileId::fileid_t fid,
     return;
   }
 
-  if (!gOFS->_touch(fileName.c_str(), mError, rootvid, 0)) {
+  if (Converter::Schedule(fileName)) {
     eos_static_info("scheduledfile=%s", fileName.c_str());
   } else {
     eos_static_err("msg=\"failed to schedule transfer\" schedulingfile=\"%s\"",
@@ -466,9 +457,9 @@ GroupBalancer::chooseFidFromGroup(FsGroup* group)
 
   while (validFsIndexes.size() > 0) {
     fs_it = group->begin();
-    fsid = *fs_it;
     rndIndex = getRandom(validFsIndexes.size() - 1);
     std::advance(fs_it, validFsIndexes[rndIndex]);
+    fsid = *fs_it;
 
     // Accept only active file systems
     if (FsView::gFsView.mIdView[fsid]->GetActiveStatus() ==
@@ -489,22 +480,13 @@ GroupBalancer::chooseFidFromGroup(FsGroup* group)
     return -1;
   }
 
-  int attempts = 10;
+  // Pick a few random files, skipping the ones already scheduled
+  std::vector<eos::IFileMD::id_t> fids;
+  gOFS->eosFsView->getRandomFiles(fsid, 10, fids);
 
-  while (attempts-- > 0) {
-    rndIndex = getRandom(fsid_size - 1);
-
-    for (auto it_fid = gOFS->eosFsView->getFileList(fsid);
-         (it_fid && it_fid->valid()); it_fid->next()) {
-      // Jump to random location
-      if (rndIndex > 0) {
-        --rndIndex;
-        continue;
-      }
-
-      if (mTransfers.count(it_fid->getElement()) == 0) {
-        return it_fid->getElement();
-      }
+  for (auto fid : fids) {
+    if (mTransfers.count(fid) == 0) {
+      return fid;
     }
   }
 
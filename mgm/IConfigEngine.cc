@@ -368,6 +368,7 @@ IConfigEngine::ApplyConfig(XrdOucString& err)
   (void) Quota::CleanUp();
   {
     eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
+    eos::common::Mapping::RulesChanged();
     eos::common::Mapping::gUserRoleVector.clear();
     eos::common::Mapping::gGroupRoleVector.clear();
     eos::common::Mapping::gVirtualUidMap.clear();
@@ -606,6 +607,7 @@ IConfigEngine::ResetConfig()
   (void) Quota::CleanUp();
   {
     eos::common::RWMutexWriteLock wr_lock(eos::common::Mapping::gMapMutex);
+    eos::common::Mapping::RulesChanged();
     eos::common::Mapping::gUserRoleVector.clear();
     eos::common::Mapping::gGroupRoleVector.clear();
     eos::common::Mapping::gVirtualUidMap.clear();
@@ -48,6 +48,39 @@ const char* Iostat::gIostatReportNamespace = "iostat::reportnamespace";
 const char* Iostat::gIostatPopularity = "iostat::popularity";
 const char* Iostat::gIostatUdpTargetList = "iostat::udptargets";
 
+const char* Iostat::gIostatTagNames[kIostatNumTags] = {
+  "bytes_read",
+  "bytes_written",
+  "read_calls",
+  "readv_calls",
+  "write_calls",
+  "fwd_seeks",
+  "bwd_seeks",
+  "xl_fwd_seeks",
+  "xl_bwd_seeks",
+  "bytes_fwd_seek",
+  "bytes_bwd_wseek",
+  "bytes_xl_fwd_seek",
+  "bytes_xl_bwd_wseek",
+  "disk_time_read",
+  "disk_time_write"
+};
+
+//------------------------------------------------------------------------------
+// Get the index of a tag name or -1 if unknown
+//------------------------------------------------------------------------------
+int
+Iostat::GetTagIndex(const char* tag)
+{
+  for (int i = 0; i < kIostatNumTags; ++i) {
+    if (!strcmp(tag, gIostatTagNames[i])) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
 /* ------------------------------------------------------------------------- */
 Iostat::Iostat()
 {
@@ -56,6 +89,11 @@ Iostat::Iostat()
   mStoreFileName = "";
   cthread = 0;
   thread = 0;
+  mNextShard = 0;
+  mShutdown = false;
+  mOpenReportFd = 0;
+  memset(IostatTotal, 0, sizeof(IostatTotal));
+  mSnapshot = std::make_shared<IostatSnapshot>();
   // push default domains to watch TODO: make generic
   IoDomains.insert(".ch");
   IoDomains.insert(".it");
@@ -200,6 +238,24 @@ Iostat::Start()
   }
 
   if (!mRunning) {
+    size_t nthreads = 4;
+
+    if (getenv("EOS_MGM_IOSTAT_THREADS")) {
+      nthreads = strtoul(getenv("EOS_MGM_IOSTAT_THREADS"), 0, 10);
+
+      if (!nthreads) {
+        nthreads = 1;
+      }
+    }
+
+    mShutdown = false;
+
+    for (size_t i = 0; i < nthreads; ++i) {
+      mShards.emplace_back(new IngestShard());
+      mShards.back()->mThread = std::thread(&Iostat::Ingest, this,
+                                            mShards.back().get());
+    }
+
     mClient.Subscribe();
     XrdSysThread::Run(&thread, Iostat::StaticReceive, static_cast<void*>(this),
                       XRDSYSTHREAD_HOLD, "Report Receiver Thread");
@@ -217,6 +273,18 @@ Iostat::Stop()
   if (mRunning) {
     XrdSysThread::Cancel(thread);
     XrdSysThread::Join(thread, NULL);
+    // Let the ingestion threads drain their queues and exit
+    mShutdown = true;
+
+    for (auto& shard : mShards) {
+      {
+        std::lock_guard<std::mutex> lock(shard->mMutex);
+        shard->mCond.notify_all();
+      }
+      shard->mThread.join();
+    }
+
+    mShards.clear();
     mRunning = false;
     mClient.Unsubscribe();
     return true;
@@ -236,6 +304,10 @@ Iostat::~Iostat()
     XrdSysThread::Cancel(cthread);
     XrdSysThread::Join(cthread, NULL);
   }
+
+  if (mOpenReportFd) {
+    fclose(mOpenReportFd);
+  }
 }
 
 /* ------------------------------------------------------------------------- */
@@ -256,232 +328,375 @@ Iostat::StaticCirculate(void* arg)
 void*
 Iostat::Receive(void)
 {
+  // ---------------------------------------------------------------------------
+  // ! only dispatch the messages, parsing and accounting is done by the
+  // ! ingestion threads
+  // ---------------------------------------------------------------------------
   while (1) {
     XrdMqMessage* newmessage = 0;
 
     while ((newmessage = mClient.RecvMessage())) {
-      XrdOucString body = newmessage->GetBody();
+      IngestShard* shard = mShards[mNextShard++ % mShards.size()].get();
+      std::lock_guard<std::mutex> lock(shard->mMutex);
+      shard->mQueue.push_back(newmessage);
+      shard->mCond.notify_one();
+    }
 
-      while (body.replace("&&", "&")) {
-      }
+    XrdSysThread::SetCancelOn();
+    XrdSysTimer sleeper;
+    sleeper.Snooze(1);
+    XrdSysThread::CancelPoint();
+    XrdSysThread::SetCancelOff();
+  }
 
-      XrdOucEnv ioreport(body.c_str());
-      eos::common::Report* report = new eos::common::Report(ioreport);
-      Add("bytes_read", report->uid, report->gid, report->rb, report->ots,
-          report->cts);
-      Add("bytes_written", report->uid, report->gid, report->wb, report->ots,
-          report->cts);
-      Add("read_calls", report->uid, report->gid, report->nrc, report->ots,
-          report->cts);
-      Add("readv_calls", report->uid, report->gid, report->rv_op, report->ots,
-          report->cts);
-      Add("write_calls", report->uid, report->gid, report->nwc, report->ots,
-          report->cts);
-      Add("fwd_seeks", report->uid, report->gid, report->nfwds, report->ots,
-          report->cts);
-      Add("bwd_seeks", report->uid, report->gid, report->nbwds, report->ots,
-          report->cts);
-      Add("xl_fwd_seeks", report->uid, report->gid, report->nxlfwds, report->ots,
-          report->cts);
-      Add("xl_bwd_seeks", report->uid, report->gid, report->nxlbwds, report->ots,
-          report->cts);
-      Add("bytes_fwd_seek", report->uid, report->gid, report->sfwdb, report->ots,
-          report->cts);
-      Add("bytes_bwd_wseek", report->uid, report->gid, report->sbwdb, report->ots,
-          report->cts);
-      Add("bytes_xl_fwd_seek", report->uid, report->gid, report->sxlfwdb, report->ots,
-          report->cts);
-      Add("bytes_xl_bwd_wseek", report->uid, report->gid, report->sxlbwdb,
-          report->ots, report->cts);
-      Add("disk_time_read", report->uid, report->gid, (unsigned long long) report->rt,
-          report->ots, report->cts);
-      Add("disk_time_write", report->uid, report->gid,
-          (unsigned long long) report->wt, report->ots, report->cts);
-      // do the UDP broadcasting here
-      {
-        XrdSysMutexHelper mLock(BroadcastMutex);
+  return 0;
+}
 
-        if (mUdpPopularityTarget.size()) {
-          UdpBroadCast(report);
-        }
-      }
+/* ------------------------------------------------------------------------- */
+void
+Iostat::Ingest(IngestShard* shard)
+{
+  // ---------------------------------------------------------------------------
+  // ! parse the queued messages of a shard and apply them in one batch
+  // ---------------------------------------------------------------------------
+  std::deque<XrdMqMessage*> batch;
+  std::vector<IostatRecord> records;
 
-      // do the domain accounting here
-      if (report->path.substr(0, 11) == "/replicate:") {
-        // check if this is a replication path
-        // push into the 'eos' domain
-        Mutex.Lock();
+  while (1) {
+    {
+      std::unique_lock<std::mutex> lock(shard->mMutex);
 
-        if (report->rb) {
-          IostatAvgDomainIOrb["eos"].Add(report->rb, report->ots, report->cts);
-        }
+      while (shard->mQueue.empty() && !mShutdown) {
+        shard->mCond.wait(lock);
+      }
 
-        if (report->wb) {
-          IostatAvgDomainIOwb["eos"].Add(report->wb, report->ots, report->cts);
-        }
+      if (shard->mQueue.empty()) {
+        break;
+      }
 
-        Mutex.UnLock();
-      } else {
-        bool dfound = false;
+      batch.swap(shard->mQueue);
+    }
 
-        if (mReportPopularity) {
-          // do the popularity accounting here for everything which is not replication!
-          AddToPopularity(report->path, report->rb, report->ots, report->cts);
-        }
+    records.resize(batch.size());
 
-        size_t pos = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      ParseReport(batch[i], records[i]);
+      delete batch[i];
+    }
 
-        if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
-          // we can sort in by domain
-          std::string sdomain = report->sec_domain.substr(pos);
+    batch.clear();
+    Apply(records);
+  }
+}
 
-          if (IoDomains.find(sdomain) != IoDomains.end()) {
-            Mutex.Lock();
+/* ------------------------------------------------------------------------- */
+void
+Iostat::ParseReport(XrdMqMessage* message, IostatRecord& record)
+{
+  // ---------------------------------------------------------------------------
+  // ! reduce a report message to a record, do the popularity accounting, UDP
+  // ! broadcast and report logging on the way
+  // ---------------------------------------------------------------------------
+  const char* in = message->GetBody();
+  std::string body;
+  body.reserve(strlen(in));
+
+  // collapse '&&' into '&' in one pass
+  for (; *in; ++in) {
+    if ((*in != '&') || body.empty() || (body.back() != '&')) {
+      body += *in;
+    }
+  }
 
-            if (report->rb) {
-              IostatAvgDomainIOrb[sdomain].Add(report->rb, report->ots, report->cts);
-            }
+  XrdOucEnv ioreport(body.c_str());
+  eos::common::Report* report = new eos::common::Report(ioreport);
+  record.uid = report->uid;
+  record.gid = report->gid;
+  record.ots = report->ots;
+  record.cts = report->cts;
+  record.val[kIostatBytesRead] = report->rb;
+  record.val[kIostatBytesWritten] = report->wb;
+  record.val[kIostatReadCalls] = report->nrc;
+  record.val[kIostatReadvCalls] = report->rv_op;
+  record.val[kIostatWriteCalls] = report->nwc;
+  record.val[kIostatFwdSeeks] = report->nfwds;
+  record.val[kIostatBwdSeeks] = report->nbwds;
+  record.val[kIostatXlFwdSeeks] = report->nxlfwds;
+  record.val[kIostatXlBwdSeeks] = report->nxlbwds;
+  record.val[kIostatBytesFwdSeek] = report->sfwdb;
+  record.val[kIostatBytesBwdSeek] = report->sbwdb;
+  record.val[kIostatBytesXlFwdSeek] = report->sxlfwdb;
+  record.val[kIostatBytesXlBwdSeek] = report->sxlbwdb;
+  record.val[kIostatDiskTimeRead] = (unsigned long long) report->rt;
+  record.val[kIostatDiskTimeWrite] = (unsigned long long) report->wt;
+  record.domains.clear();
+  // do the UDP broadcasting here
+  {
+    XrdSysMutexHelper mLock(BroadcastMutex);
 
-            if (report->wb) {
-              IostatAvgDomainIOwb[sdomain].Add(report->wb, report->ots, report->cts);
-            }
+    if (mUdpPopularityTarget.size()) {
+      UdpBroadCast(report);
+    }
+  }
 
-            Mutex.UnLock();
-            dfound = true;
-          }
-        }
+  // do the domain accounting here
+  if (report->path.substr(0, 11) == "/replicate:") {
+    // check if this is a replication path
+    // push into the 'eos' domain
+    record.domains.push_back("eos");
+  } else {
+    if (mReportPopularity) {
+      // do the popularity accounting here for everything which is not replication!
+      AddToPopularity(report->path, report->rb, report->ots, report->cts);
+    }
 
-        // do the node accounting here - keep the node list small !!!
-        std::set<std::string>::const_iterator nit;
+    size_t pos = 0;
 
-        for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
-          if (*nit == report->sec_host.substr(0, nit->length())) {
-            Mutex.Lock();
+    if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
+      // we can sort in by domain
+      std::string sdomain = report->sec_domain.substr(pos);
 
-            if (report->rb) {
-              IostatAvgDomainIOrb[*nit].Add(report->rb, report->ots, report->cts);
-            }
+      if (IoDomains.find(sdomain) != IoDomains.end()) {
+        record.domains.push_back(sdomain);
+      }
+    }
 
-            if (report->wb) {
-              IostatAvgDomainIOwb[*nit].Add(report->wb, report->ots, report->cts);
-            }
+    // do the node accounting here - keep the node list small !!!
+    for (auto nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
+      if (*nit == report->sec_host.substr(0, nit->length())) {
+        record.domains.push_back(*nit);
+      }
+    }
 
-            Mutex.UnLock();
-            dfound = true;
-          }
-        }
+    if (record.domains.empty()) {
+      // push into the 'other' domain
+      record.domains.push_back("other");
+    }
+  }
 
-        if (!dfound) {
-          // push into the 'other' domain
-          Mutex.Lock();
+  // do the application accounting here
+  record.app = (report->sec_app.length() ? report->sec_app : "other");
 
-          if (report->rb) {
-            IostatAvgDomainIOrb["other"].Add(report->rb, report->ots, report->cts);
-          }
+  if (mReport || mReportNamespace) {
+    WriteReport(body, report);
+  }
 
-          if (report->wb) {
-            IostatAvgDomainIOwb["other"].Add(report->wb, report->ots, report->cts);
-          }
+  delete report;
+}
 
-          Mutex.UnLock();
-        }
+/* ------------------------------------------------------------------------- */
+void
+Iostat::Apply(const std::vector<IostatRecord>& records)
+{
+  // ---------------------------------------------------------------------------
+  // ! add a batch of records to the counters and averages
+  // ---------------------------------------------------------------------------
+  XrdSysMutexHelper mLock(Mutex);
+
+  for (const auto& rec : records) {
+    for (int i = 0; i < kIostatNumTags; ++i) {
+      unsigned long long val = rec.val[i];
+      IostatUid[i][rec.uid] += val;
+      IostatGid[i][rec.gid] += val;
+      IostatTotal[i] += val;
+      IostatAvg& uavg = IostatAvgUid[i][rec.uid];
+      IostatAvg& gavg = IostatAvgGid[i][rec.gid];
+
+      // a zero value only has to show up in the tables
+      if (val) {
+        uavg.Add(val, rec.ots, rec.cts);
+        gavg.Add(val, rec.ots, rec.cts);
+        IostatAvgTotal[i].Add(val, rec.ots, rec.cts);
       }
+    }
 
-      // do the application accounting here
-      std::string apptag = "other";
+    unsigned long long rb = rec.val[kIostatBytesRead];
+    unsigned long long wb = rec.val[kIostatBytesWritten];
 
-      if (report->sec_app.length()) {
-        apptag = report->sec_app;
+    for (const auto& domain : rec.domains) {
+      if (rb) {
+        IostatAvgDomainIOrb[domain].Add(rb, rec.ots, rec.cts);
       }
 
-      // Push into app accounting
-      Mutex.Lock();
-
-      if (report->rb) {
-        IostatAvgAppIOrb[apptag].Add(report->rb, report->ots, report->cts);
+      if (wb) {
+        IostatAvgDomainIOwb[domain].Add(wb, rec.ots, rec.cts);
       }
+    }
 
-      if (report->wb) {
-        IostatAvgAppIOwb[apptag].Add(report->wb, report->ots, report->cts);
-      }
+    // Push into app accounting
+    if (rb) {
+      IostatAvgAppIOrb[rec.app].Add(rb, rec.ots, rec.cts);
+    }
 
-      Mutex.UnLock();
-
-      if (mReport) {
-        // add the record to a daily report log file
-        static XrdOucString openreportfile = "";
-        static FILE* openreportfd = 0;
-        time_t now = time(NULL);
-        struct tm nowtm;
-        XrdOucString reportfile = "";
-
-        if (localtime_r(&now, &nowtm)) {
-          static char logfile[4096];
-          snprintf(logfile, sizeof(logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
-                   gOFS->IoReportStorePath.c_str(),
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   nowtm.tm_mday);
-          reportfile = logfile;
-
-          if (reportfile == openreportfile) {
-            // just add it here;
-            if (openreportfd) {
-              fprintf(openreportfd, "%s\n", body.c_str());
-              fflush(openreportfd);
-            }
-          } else {
-            if (openreportfd) {
-              fclose(openreportfd);
-            }
-
-            eos::common::Path cPath(reportfile.c_str());
-
-            if (cPath.MakeParentPath(S_IRWXU)) {
-              openreportfd = fopen(reportfile.c_str(), "a+");
-
-              if (openreportfd) {
-                fprintf(openreportfd, "%s\n", body.c_str());
-                fflush(openreportfd);
-              }
-
-              openreportfile = reportfile;
-            }
-          }
+    if (wb) {
+      IostatAvgAppIOwb[rec.app].Add(wb, rec.ots, rec.cts);
+    }
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+Iostat::IostatRates
+Iostat::GetRates(const IostatAvg& avg)
+{
+  IostatRates rates;
+  rates.avg60 = avg.GetAvg60();
+  rates.avg300 = avg.GetAvg300();
+  rates.avg3600 = avg.GetAvg3600();
+  rates.avg86400 = avg.GetAvg86400();
+  return rates;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+Iostat::Copy(IostatCopy& copy)
+{
+  // ---------------------------------------------------------------------------
+  // ! flat copy of the counters and rates - Mutex has to be locked, keep this
+  // ! short since it blocks the ingestion
+  // ---------------------------------------------------------------------------
+  for (int tag = 0; tag < kIostatNumTags; ++tag) {
+    copy.uid[tag].assign(IostatUid[tag].begin(), IostatUid[tag].end());
+    copy.gid[tag].assign(IostatGid[tag].begin(), IostatGid[tag].end());
+    copy.avgUid[tag].reserve(IostatAvgUid[tag].size());
+
+    for (auto it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end();
+         ++it) {
+      copy.avgUid[tag].emplace_back(it->first, GetRates(it->second));
+    }
+
+    copy.avgGid[tag].reserve(IostatAvgGid[tag].size());
+
+    for (auto it = IostatAvgGid[tag].begin(); it != IostatAvgGid[tag].end();
+         ++it) {
+      copy.avgGid[tag].emplace_back(it->first, GetRates(it->second));
+    }
+
+    copy.total[tag] = IostatTotal[tag];
+    copy.avgTotal[tag] = GetRates(IostatAvgTotal[tag]);
+  }
+
+  for (auto it = IostatAvgDomainIOrb.begin(); it != IostatAvgDomainIOrb.end();
+       ++it) {
+    copy.domainIOrb.emplace_back(it->first, GetRates(it->second));
+  }
+
+  for (auto it = IostatAvgDomainIOwb.begin(); it != IostatAvgDomainIOwb.end();
+       ++it) {
+    copy.domainIOwb.emplace_back(it->first, GetRates(it->second));
+  }
+
+  for (auto it = IostatAvgAppIOrb.begin(); it != IostatAvgAppIOrb.end(); ++it) {
+    copy.appIOrb.emplace_back(it->first, GetRates(it->second));
+  }
+
+  for (auto it = IostatAvgAppIOwb.begin(); it != IostatAvgAppIOwb.end(); ++it) {
+    copy.appIOwb.emplace_back(it->first, GetRates(it->second));
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+void
+Iostat::Publish(const IostatCopy& copy)
+{
+  // ---------------------------------------------------------------------------
+  // ! build the sorted snapshot for the reporting from a copy - runs without
+  // ! the Mutex
+  // ---------------------------------------------------------------------------
+  std::shared_ptr<IostatSnapshot> snapshot = std::make_shared<IostatSnapshot>();
+
+  for (int tag = 0; tag < kIostatNumTags; ++tag) {
+    snapshot->uid[tag].insert(copy.uid[tag].begin(), copy.uid[tag].end());
+    snapshot->gid[tag].insert(copy.gid[tag].begin(), copy.gid[tag].end());
+    snapshot->avgUid[tag].insert(copy.avgUid[tag].begin(),
+                                 copy.avgUid[tag].end());
+    snapshot->avgGid[tag].insert(copy.avgGid[tag].begin(),
+                                 copy.avgGid[tag].end());
+    snapshot->total[tag] = copy.total[tag];
+    snapshot->avgTotal[tag] = copy.avgTotal[tag];
+  }
+
+  snapshot->domainIOrb.insert(copy.domainIOrb.begin(), copy.domainIOrb.end());
+  snapshot->domainIOwb.insert(copy.domainIOwb.begin(), copy.domainIOwb.end());
+  snapshot->appIOrb.insert(copy.appIOrb.begin(), copy.appIOrb.end());
+  snapshot->appIOwb.insert(copy.appIOwb.begin(), copy.appIOwb.end());
+  std::lock_guard<std::mutex> lock(mSnapshotMutex);
+  mSnapshot = snapshot;
+}
+
+/* ------------------------------------------------------------------------- */
+std::shared_ptr<const Iostat::IostatSnapshot>
+Iostat::GetSnapshot()
+{
+  std::lock_guard<std::mutex> lock(mSnapshotMutex);
+  return mSnapshot;
+}
+
+/* ------------------------------------------------------------------------- */
+void
+Iostat::WriteReport(const std::string& body, eos::common::Report* report)
+{
+  if (mReport) {
+    // add the record to a daily report log file
+    time_t now = time(NULL);
+    struct tm nowtm;
+    XrdOucString reportfile = "";
+
+    if (localtime_r(&now, &nowtm)) {
+      char logfile[4096];
+      snprintf(logfile, sizeof(logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
+               gOFS->IoReportStorePath.c_str(),
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               nowtm.tm_mday);
+      reportfile = logfile;
+      std::lock_guard<std::mutex> lock(mReportFileMutex);
+
+      if (reportfile == mOpenReportFile) {
+        // just add it here;
+        if (mOpenReportFd) {
+          fprintf(mOpenReportFd, "%s\n", body.c_str());
+          fflush(mOpenReportFd);
+        }
+      } else {
+        if (mOpenReportFd) {
+          fclose(mOpenReportFd);
+          mOpenReportFd = 0;
         }
-      }
 
-      if (mReportNamespace) {
-        // add the record into the report namespace file
-        char path[4096];
-        snprintf(path, sizeof(path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(),
-                 report->path.c_str());
-        eos::common::Path cPath(path);
+        eos::common::Path cPath(reportfile.c_str());
 
         if (cPath.MakeParentPath(S_IRWXU)) {
-          FILE* freport = fopen(path, "a+");
+          mOpenReportFd = fopen(reportfile.c_str(), "a+");
 
-          if (freport) {
-            fprintf(freport, "%s\n", body.c_str());
-            fclose(freport);
+          if (mOpenReportFd) {
+            fprintf(mOpenReportFd, "%s\n", body.c_str());
+            fflush(mOpenReportFd);
           }
+
+          mOpenReportFile = reportfile;
         }
       }
-
-      delete report;
-      delete newmessage;
     }
-
-    XrdSysThread::SetCancelOn();
-    XrdSysTimer sleeper;
-    sleeper.Snooze(1);
-    XrdSysThread::CancelPoint();
-    XrdSysThread::SetCancelOff();
   }
 
-  return 0;
+  if (mReportNamespace) {
+    // add the record into the report namespace file
+    char path[4096];
+    snprintf(path, sizeof(path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(),
+             report->path.c_str());
+    eos::common::Path cPath(path);
+
+    if (cPath.MakeParentPath(S_IRWXU)) {
+      FILE* freport = fopen(path, "a+");
+
+      if (freport) {
+        fprintf(freport, "%s\n", body.c_str());
+        fclose(freport);
+      }
+    }
+  }
 }
 
 /* ------------------------------------------------------------------------- */
@@ -490,18 +705,22 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
                  bool monitoring, bool numerical, bool top,
                  bool domain, bool apps, XrdOucString option)
 {
-  Mutex.Lock();
+  std::shared_ptr<const IostatSnapshot> snapshot = GetSnapshot();
   std::string format_s = (!monitoring ? "s" : "os");
   std::string format_ss = (!monitoring ? "-s" : "os");
   std::string format_l = (!monitoring ? "+l" : "ol");
   std::string format_ll = (!monitoring ? "l." : "ol");
-  std::vector<std::string> tags;
+  std::vector<int> tags;
 
-  for (auto tit = IostatUid.begin(); tit != IostatUid.end(); ++tit) {
-    tags.push_back(tit->first);
+  for (int i = 0; i < kIostatNumTags; ++i) {
+    if (!snapshot->uid[i].empty()) {
+      tags.push_back(i);
+    }
   }
 
-  std::sort(tags.begin(), tags.end());
+  std::sort(tags.begin(), tags.end(), [](int a, int b) {
+    return (strcmp(gIostatTagNames[a], gIostatTagNames[b]) < 0);
+  });
 
   if (summary) {
     TableFormatterBase table;
@@ -530,8 +749,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
-    for (const auto& elem : tags) {
-      const char* tag = elem.c_str();
+    for (int tag : tags) {
       table_data.emplace_back();
       TableRow& row = table_data.back();
       row.push_back(TableCell("all", format_ss));
@@ -540,12 +758,13 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
         row.push_back(TableCell("all", format_s));
       }
 
-      row.push_back(TableCell(tag, format_s));
-      row.push_back(TableCell(GetTotal(tag), format_l));
-      row.push_back(TableCell(GetTotalAvg60(tag), format_l));
-      row.push_back(TableCell(GetTotalAvg300(tag), format_l));
-      row.push_back(TableCell(GetTotalAvg3600(tag), format_l));
-      row.push_back(TableCell(GetTotalAvg86400(tag), format_l));
+      row.push_back(TableCell(gIostatTagNames[tag], format_s));
+      const IostatRates& rates = snapshot->avgTotal[tag];
+      row.push_back(TableCell(snapshot->total[tag], format_l));
+      row.push_back(TableCell(rates.avg60, format_l));
+      row.push_back(TableCell(rates.avg300, format_l));
+      row.push_back(TableCell(rates.avg3600, format_l));
+      row.push_back(TableCell(rates.avg86400, format_l));
     }
 
     table.AddRows(table_data);
@@ -606,8 +825,9 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
-    for (auto tuit = IostatAvgUid.begin(); tuit != IostatAvgUid.end(); tuit++) {
-      for (auto it = tuit->second.begin(); it != tuit->second.end(); ++it) {
+    for (int tag = 0; tag < kIostatNumTags; ++tag) {
+      for (auto it = snapshot->avgUid[tag].begin();
+           it != snapshot->avgUid[tag].end(); ++it) {
         std::string username;
 
         if (numerical) {
@@ -617,10 +837,12 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
           username = eos::common::Mapping::UidToUserName(it->first, terrc);
         }
 
-        uidout.push_back(std::make_tuple(username, tuit->first.c_str(),
-                                         IostatUid[tuit->first.c_str()][it->first],
-                                         it->second.GetAvg60(), it->second.GetAvg300(),
-                                         it->second.GetAvg3600(), it->second.GetAvg86400()));
+        auto cit = snapshot->uid[tag].find(it->first);
+        uidout.push_back(std::make_tuple(username, gIostatTagNames[tag],
+                                         (cit != snapshot->uid[tag].end() ?
+                                          cit->second : 0ull),
+                                         it->second.avg60, it->second.avg300,
+                                         it->second.avg3600, it->second.avg86400));
       }
     }
 
@@ -666,8 +888,9 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       });
     }
 
-    for (auto tgit = IostatAvgGid.begin(); tgit != IostatAvgGid.end(); tgit++) {
-      for (auto it = tgit->second.begin(); it != tgit->second.end(); ++it) {
+    for (int tag = 0; tag < kIostatNumTags; ++tag) {
+      for (auto it = snapshot->avgGid[tag].begin();
+           it != snapshot->avgGid[tag].end(); ++it) {
         std::string groupname;
 
         if (numerical) {
@@ -677,10 +900,12 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
           groupname = eos::common::Mapping::GidToGroupName(it->first, terrc);
         }
 
-        gidout.push_back(std::make_tuple(groupname, tgit->first.c_str(),
-                                         IostatGid[tgit->first.c_str()][it->first],
-                                         it->second.GetAvg60(), it->second.GetAvg300(),
-                                         it->second.GetAvg3600(), it->second.GetAvg86400()));
+        auto cit = snapshot->gid[tag].find(it->first);
+        gidout.push_back(std::make_tuple(groupname, gIostatTagNames[tag],
+                                         (cit != snapshot->gid[tag].end() ?
+                                          cit->second : 0ull),
+                                         it->second.avg60, it->second.avg300,
+                                         it->second.avg3600, it->second.avg86400));
       }
     }
 
@@ -729,7 +954,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       table.AddSeparator();
 
       // by uid name
-      for (auto sit : IostatUid[*it]) {
+      for (auto sit : snapshot->uid[*it]) {
         uidout.push_back(std::make_tuple(sit.second, sit.first));
       }
 
@@ -752,7 +977,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
 
         table_data.emplace_back();
         TableRow& row = table_data.back();
-        row.push_back(TableCell(it->c_str(), format_ss));
+        row.push_back(TableCell(gIostatTagNames[*it], format_ss));
 
         if (!monitoring) {
           row.push_back(TableCell("user", format_s));
@@ -769,7 +994,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
       }
 
       // by gid name
-      for (auto sit : IostatGid[*it]) {
+      for (auto sit : snapshot->gid[*it]) {
         gidout.push_back(std::make_tuple(sit.second, sit.first));
       }
 
@@ -792,7 +1017,7 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
 
         table_data.emplace_back();
         TableRow& row = table_data.back();
-        row.push_back(TableCell(it->c_str(), format_ss));
+        row.push_back(TableCell(gIostatTagNames[*it], format_ss));
 
         if (!monitoring) {
           row.push_back(TableCell("group", format_s));
@@ -838,31 +1063,31 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
     }
 
     // IO out bytes
-    for (auto it = IostatAvgDomainIOrb.begin(); it != IostatAvgDomainIOrb.end();
-         ++it) {
+    for (auto it = snapshot->domainIOrb.begin();
+         it != snapshot->domainIOrb.end(); ++it) {
       table_data.emplace_back();
       TableRow& row = table_data.back();
       std::string name = !monitoring ? "out" : "domain_io_out";
       row.push_back(TableCell(name, format_ss));
       row.push_back(TableCell(it->first.c_str(), format_s));
-      row.push_back(TableCell(it->second.GetAvg60(), format_l));
-      row.push_back(TableCell(it->second.GetAvg300(), format_l));
-      row.push_back(TableCell(it->second.GetAvg3600(), format_l));
-      row.push_back(TableCell(it->second.GetAvg86400(), format_l));
+      row.push_back(TableCell(it->second.avg60, format_l));
+      row.push_back(TableCell(it->second.avg300, format_l));
+      row.push_back(TableCell(it->second.avg3600, format_l));
+      row.push_back(TableCell(it->second.avg86400, format_l));
     }
 
     // IO in bytes
-    for (auto it = IostatAvgDomainIOwb.begin(); it != IostatAvgDomainIOwb.end();
-         ++it) {
+    for (auto it = snapshot->domainIOwb.begin();
+         it != snapshot->domainIOwb.end(); ++it) {
       table_data.emplace_back();
       TableRow& row = table_data.back();
       std::string name = !monitoring ? "in" : "domain_io_in";
       row.push_back(TableCell(name, format_ss));
       row.push_back(TableCell(it->first.c_str(), format_s));
-      row.push_back(TableCell(it->second.GetAvg60(), format_l));
-      row.push_back(TableCell(it->second.GetAvg300(), format_l));
-      row.push_back(TableCell(it->second.GetAvg3600(), format_l));
-      row.push_back(TableCell(it->second.GetAvg86400(), format_l));
+      row.push_back(TableCell(it->second.avg60, format_l));
+      row.push_back(TableCell(it->second.avg300, format_l));
+      row.push_back(TableCell(it->second.avg3600, format_l));
+      row.push_back(TableCell(it->second.avg86400, format_l));
     }
 
     table.AddRows(table_data);
@@ -894,36 +1119,36 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
     }
 
     // IO out bytes
-    for (auto it = IostatAvgAppIOrb.begin(); it != IostatAvgAppIOrb.end(); ++it) {
+    for (auto it = snapshot->appIOrb.begin(); it != snapshot->appIOrb.end();
+         ++it) {
       table_data.emplace_back();
       TableRow& row = table_data.back();
       std::string name = (!monitoring ? "out" : "app_io_out");
       row.push_back(TableCell(name, format_ss));
       row.push_back(TableCell(it->first.c_str(), format_s));
-      row.push_back(TableCell(it->second.GetAvg60(), format_l));
-      row.push_back(TableCell(it->second.GetAvg300(), format_l));
-      row.push_back(TableCell(it->second.GetAvg3600(), format_l));
-      row.push_back(TableCell(it->second.GetAvg86400(), format_l));
+      row.push_back(TableCell(it->second.avg60, format_l));
+      row.push_back(TableCell(it->second.avg300, format_l));
+      row.push_back(TableCell(it->second.avg3600, format_l));
+      row.push_back(TableCell(it->second.avg86400, format_l));
     }
 
     // IO in bytes
-    for (auto it = IostatAvgAppIOwb.begin(); it != IostatAvgAppIOwb.end(); ++it) {
+    for (auto it = snapshot->appIOwb.begin(); it != snapshot->appIOwb.end();
+         ++it) {
       table_data.emplace_back();
       TableRow& row = table_data.back();
       std::string name = (!monitoring ? "in" : "app_io_in");
       row.push_back(TableCell(name, format_ss));
       row.push_back(TableCell(it->first.c_str(), format_s));
-      row.push_back(TableCell(it->second.GetAvg60(), format_l));
-      row.push_back(TableCell(it->second.GetAvg300(), format_l));
-      row.push_back(TableCell(it->second.GetAvg3600(), format_l));
-      row.push_back(TableCell(it->second.GetAvg86400(), format_l));
+      row.push_back(TableCell(it->second.avg60, format_l));
+      row.push_back(TableCell(it->second.avg300, format_l));
+      row.push_back(TableCell(it->second.avg3600, format_l));
+      row.push_back(TableCell(it->second.avg86400, format_l));
     }
 
     table.AddRows(table_data);
     out += table.GenerateTable(HEADER).c_str();
   }
-
-  Mutex.UnLock();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1330,28 +1555,20 @@ Iostat::Store()
     return false;
   }
 
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator
-  tuit;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >::iterator
-  tgit;
   Mutex.Lock();
 
   // store user counters
-  for (tuit = IostatUid.begin(); tuit != IostatUid.end(); tuit++) {
-    google::sparse_hash_map<uid_t, unsigned long long>::iterator it;
-
-    for (it = tuit->second.begin(); it != tuit->second.end(); ++it) {
-      fprintf(fout, "tag=%s&uid=%u&val=%llu\n", tuit->first.c_str(), it->first,
+  for (int tag = 0; tag < kIostatNumTags; ++tag) {
+    for (auto it = IostatUid[tag].begin(); it != IostatUid[tag].end(); ++it) {
+      fprintf(fout, "tag=%s&uid=%u&val=%llu\n", gIostatTagNames[tag], it->first,
               it->second);
     }
   }
 
   // store group counter
-  for (tgit = IostatGid.begin(); tgit != IostatGid.end(); tgit++) {
-    google::sparse_hash_map<uid_t, unsigned long long>::iterator it;
-
-    for (it = tgit->second.begin(); it != tgit->second.end(); ++it) {
-      fprintf(fout, "tag=%s&gid=%u&val=%llu\n", tgit->first.c_str(), it->first,
+  for (int tag = 0; tag < kIostatNumTags; ++tag) {
+    for (auto it = IostatGid[tag].begin(); it != IostatGid[tag].end(); ++it) {
+      fprintf(fout, "tag=%s&gid=%u&val=%llu\n", gIostatTagNames[tag], it->first,
               it->second);
     }
   }
@@ -1386,23 +1603,39 @@ Iostat::Restore()
   while ((item = fscanf(fin, "%16383s\n", line)) == 1) {
     XrdOucEnv env(line);
 
-    if (env.Get("tag") && env.Get("uid") && env.Get("val")) {
-      std::string tag = env.Get("tag");
+    int tag = (env.Get("tag") ? GetTagIndex(env.Get("tag")) : -1);
+
+    if (tag < 0) {
+      continue;
+    }
+
+    if (env.Get("uid") && env.Get("val")) {
       uid_t uid = atoi(env.Get("uid"));
       unsigned long long val = strtoull(env.Get("val"), 0, 10);
       IostatUid[tag][uid] = val;
     }
 
-    if (env.Get("tag") && env.Get("gid") && env.Get("val")) {
-      std::string tag = env.Get("tag");
+    if (env.Get("gid") && env.Get("val")) {
       gid_t gid = atoi(env.Get("gid"));
       unsigned long long val = strtoull(env.Get("val"), 0, 10);
       IostatGid[tag][gid] = val;
     }
   }
 
+  // recompute the per tag totals
+  for (int tag = 0; tag < kIostatNumTags; ++tag) {
+    IostatTotal[tag] = 0;
+
+    for (auto it = IostatUid[tag].begin(); it != IostatUid[tag].end(); ++it) {
+      IostatTotal[tag] += it->second;
+    }
+  }
+
+  IostatCopy copy;
+  Copy(copy);
   Mutex.UnLock();
   fclose(fin);
+  Publish(copy);
   return true;
 }
 
@@ -1485,27 +1718,22 @@ Iostat::Circulate()
     XrdSysTimer sleeper;
     sleeper.Wait(512);
     Mutex.Lock();
-    google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, IostatAvg> >::iterator
-    tit;
     google::sparse_hash_map<std::string, IostatAvg >::iterator dit;
 
     // loop over tags
-    for (tit = IostatAvgUid.begin(); tit != IostatAvgUid.end(); ++tit) {
+    for (int tag = 0; tag < kIostatNumTags; ++tag) {
       // loop over vids
-      google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-
-      for (it = tit->second.begin(); it != tit->second.end(); ++it) {
+      for (auto it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end();
+           ++it) {
         it->second.StampZero();
       }
-    }
 
-    for (tit = IostatAvgGid.begin(); tit != IostatAvgGid.end(); ++tit) {
-      // loop over vids
-      google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-
-      for (it = tit->second.begin(); it != tit->second.end(); ++it) {
+      for (auto it = IostatAvgGid[tag].begin(); it != IostatAvgGid[tag].end();
+           ++it) {
         it->second.StampZero();
       }
+
+      IostatAvgTotal[tag].StampZero();
     }
 
     // loop over domain accounting
@@ -1528,7 +1756,10 @@ Iostat::Circulate()
       dit->second.StampZero();
     }
 
+    IostatCopy copy;
+    Copy(copy);
     Mutex.UnLock();
+    Publish(copy);
     size_t popularitybin = (((time(NULL))) % (IOSTAT_POPULARITY_DAY *
                             IOSTAT_POPULARITY_HISTORY_DAYS)) / IOSTAT_POPULARITY_DAY;
 
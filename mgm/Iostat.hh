@@ -31,8 +31,16 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include <google/sparse_hash_map>
 #include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <set>
+#include <thread>
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -47,6 +55,29 @@ EOSMGMNAMESPACE_BEGIN
 #define IOSTAT_POPULARITY_HISTORY_DAYS 7
 #define IOSTAT_POPULARITY_DAY 86400
 
+//------------------------------------------------------------------------------
+//! Io stat counters - interned so that the ingestion does not hash tag names.
+//! The order has to match Iostat::gIostatTagNames.
+//------------------------------------------------------------------------------
+enum IostatTag {
+  kIostatBytesRead = 0,
+  kIostatBytesWritten,
+  kIostatReadCalls,
+  kIostatReadvCalls,
+  kIostatWriteCalls,
+  kIostatFwdSeeks,
+  kIostatBwdSeeks,
+  kIostatXlFwdSeeks,
+  kIostatXlBwdSeeks,
+  kIostatBytesFwdSeek,
+  kIostatBytesBwdSeek,
+  kIostatBytesXlFwdSeek,
+  kIostatBytesXlBwdSeek,
+  kIostatDiskTimeRead,
+  kIostatDiskTimeWrite,
+  kIostatNumTags
+};
+
 class IostatAvg
 {
 public:
@@ -55,7 +86,14 @@ public:
   unsigned long avg300[60];
   unsigned long avg60[60];
 
-  IostatAvg()
+  // running sums of the bins above, so that reading a rate does not have to
+  // walk all bins
+  double sum86400;
+  double sum3600;
+  double sum300;
+  double sum60;
+
+  IostatAvg(): sum86400(0), sum3600(0), sum300(0), sum60(0)
   {
     memset(avg86400, 0, sizeof(avg86400));
     memset(avg3600, 0, sizeof(avg3600));
@@ -85,6 +123,7 @@ public:
       for (size_t bins = 0; bins < mbins; bins++) {
         unsigned int bin86400 = (((stoptime - (bins * 1440)) / 1440) % 60);
         avg86400[bin86400] += norm_val;
+        sum86400 += norm_val;
       }
     }
 
@@ -101,6 +140,7 @@ public:
       for (size_t bins = 0; bins < mbins; bins++) {
         unsigned int bin3600 = (((stoptime - (bins * 60)) / 60) % 60);
         avg3600[bin3600] += norm_val;
+        sum3600 += norm_val;
       }
     }
 
@@ -117,6 +157,7 @@ public:
       for (size_t bins = 0; bins < mbins; bins++) {
         unsigned int bin300 = (((stoptime - (bins * 5)) / 5) % 60);
         avg300[bin300] += norm_val;
+        sum300 += norm_val;
       }
     }
 
@@ -133,6 +174,7 @@ public:
       for (size_t bins = 0; bins < mbins; ++bins) {
         unsigned int bin60 = (((stoptime - (bins * 1)) / 1) % 60);
         avg60[bin60] += norm_val;
+        sum60 += norm_val;
       }
     }
   }
@@ -144,6 +186,10 @@ public:
     unsigned int bin3600 = (time(0) / 60);
     unsigned int bin300 = (time(0) / 5);
     unsigned int bin60 = (time(0) / 1);
+    sum86400 -= avg86400[(bin86400 + 1) % 60];
+    sum3600 -= avg3600[(bin3600 + 1) % 60];
+    sum300 -= avg300[(bin300 + 1) % 60];
+    sum60 -= avg60[(bin60 + 1) % 60];
     avg86400[(bin86400 + 1) % 60] = 0;
     avg3600[(bin3600 + 1) % 60] = 0;
     avg300[(bin300 + 1) % 60] = 0;
@@ -151,51 +197,27 @@ public:
   }
 
   double
-  GetAvg86400()
+  GetAvg86400() const
   {
-    double sum = 0;
-
-    for (int i = 0; i < 60; i++) {
-      sum += avg86400[i];
-    }
-
-    return sum;
+    return sum86400;
   }
 
   double
-  GetAvg3600()
+  GetAvg3600() const
   {
-    double sum = 0;
-
-    for (int i = 0; i < 60; i++) {
-      sum += avg3600[i];
-    }
-
-    return sum;
+    return sum3600;
   }
 
   double
-  GetAvg300()
+  GetAvg300() const
   {
-    double sum = 0;
-
-    for (int i = 0; i < 60; i++) {
-      sum += avg300[i];
-    }
-
-    return sum;
+    return sum300;
   }
 
   double
-  GetAvg60()
+  GetAvg60() const
   {
-    double sum = 0;
-
-    for (int i = 0; i < 60; i++) {
-      sum += avg60[i];
-    }
-
-    return sum;
+    return sum60;
   }
 };
 
@@ -206,15 +228,42 @@ class Iostat
   // -------------------------------------------------------------
 private:
 
+  // -----------------------------------------------------------
+  // Reports are parsed by a set of ingestion threads into fixed
+  // records, which are applied in batches to the maps below
+  // -----------------------------------------------------------
+
+  struct IostatRecord {
+    uid_t uid;
+    gid_t gid;
+    time_t ots;
+    time_t cts;
+    unsigned long long val[kIostatNumTags];
+    std::vector<std::string> domains; // domain/node accounting keys
+    std::string app; // application accounting key
+  };
+
+  struct IngestShard {
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<XrdMqMessage*> mQueue; // messages waiting to be parsed
+    std::thread mThread;
+  };
+
+  std::vector<std::unique_ptr<IngestShard>> mShards;
+  std::atomic<size_t> mNextShard;
+  std::atomic<bool> mShutdown;
+
   XrdSysMutex Mutex;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, unsigned long long> >
-  IostatUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, unsigned long long> >
-  IostatGid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<uid_t, IostatAvg> >
-  IostatAvgUid;
-  google::sparse_hash_map<std::string, google::sparse_hash_map<gid_t, IostatAvg> >
-  IostatAvgGid;
+  google::sparse_hash_map<uid_t, unsigned long long> IostatUid[kIostatNumTags];
+  google::sparse_hash_map<gid_t, unsigned long long> IostatGid[kIostatNumTags];
+  google::sparse_hash_map<uid_t, IostatAvg> IostatAvgUid[kIostatNumTags];
+  google::sparse_hash_map<gid_t, IostatAvg> IostatAvgGid[kIostatNumTags];
+
+  // per tag totals and time series, so that the summary does not have to
+  // walk all users
+  unsigned long long IostatTotal[kIostatNumTags];
+  IostatAvg IostatAvgTotal[kIostatNumTags];
 
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgDomainIOrb;
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgDomainIOwb;
@@ -222,6 +271,55 @@ private:
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgAppIOrb;
   google::sparse_hash_map<std::string, IostatAvg> IostatAvgAppIOwb;
 
+  // -----------------------------------------------------------
+  // the reporting works on a copy of the counters and averages
+  // which is published by the circulate thread, so that 'io stat'
+  // never blocks the ingestion on the Mutex above
+  // -----------------------------------------------------------
+
+  struct IostatRates {
+    double avg60;
+    double avg300;
+    double avg3600;
+    double avg86400;
+  };
+
+  struct IostatSnapshot {
+    std::map<uid_t, unsigned long long> uid[kIostatNumTags];
+    std::map<gid_t, unsigned long long> gid[kIostatNumTags];
+    std::map<uid_t, IostatRates> avgUid[kIostatNumTags];
+    std::map<gid_t, IostatRates> avgGid[kIostatNumTags];
+    unsigned long long total[kIostatNumTags];
+    IostatRates avgTotal[kIostatNumTags];
+    std::map<std::string, IostatRates> domainIOrb;
+    std::map<std::string, IostatRates> domainIOwb;
+    std::map<std::string, IostatRates> appIOrb;
+    std::map<std::string, IostatRates> appIOwb;
+  };
+
+  // flat copy taken under the Mutex, the sorted snapshot is built from it
+  // after the Mutex is released so that the ingestion is not held up
+  struct IostatCopy {
+    std::vector<std::pair<uid_t, unsigned long long>> uid[kIostatNumTags];
+    std::vector<std::pair<gid_t, unsigned long long>> gid[kIostatNumTags];
+    std::vector<std::pair<uid_t, IostatRates>> avgUid[kIostatNumTags];
+    std::vector<std::pair<gid_t, IostatRates>> avgGid[kIostatNumTags];
+    unsigned long long total[kIostatNumTags];
+    IostatRates avgTotal[kIostatNumTags];
+    std::vector<std::pair<std::string, IostatRates>> domainIOrb;
+    std::vector<std::pair<std::string, IostatRates>> domainIOwb;
+    std::vector<std::pair<std::string, IostatRates>> appIOrb;
+    std::vector<std::pair<std::string, IostatRates>> appIOwb;
+  };
+
+  std::mutex mSnapshotMutex; // protecting the pointer below
+  std::shared_ptr<const IostatSnapshot> mSnapshot;
+
+  static IostatRates GetRates(const IostatAvg& avg);
+  void Copy(IostatCopy& copy); // Mutex has to be locked
+  void Publish(const IostatCopy& copy); // Mutex must not be locked
+  std::shared_ptr<const IostatSnapshot> GetSnapshot();
+
   std::set<std::string> IoDomains;
   std::set<std::string> IoNodes;
 
@@ -287,6 +385,15 @@ private:
   XrdOucString
   mStoreFileName; // file name where a dump is loaded/saved in Restore/Store
 
+  std::mutex mReportFileMutex; // protecting the daily report log file below
+  XrdOucString mOpenReportFile; // name of the open daily report log file
+  FILE* mOpenReportFd; // handle of the open daily report log file
+
+  void Ingest(IngestShard* shard);
+  void ParseReport(XrdMqMessage* message, IostatRecord& record);
+  void WriteReport(const std::string& body, eos::common::Report* report);
+  void Apply(const std::vector<IostatRecord>& records);
+
 
 public:
   // configuration keys used in config key-val store
@@ -295,6 +402,9 @@ public:
   static const char* gIostatReportNamespace;
   static const char* gIostatPopularity;
   static const char* gIostatUdpTargetList;
+  static const char* gIostatTagNames[kIostatNumTags];
+
+  static int GetTagIndex(const char* tag);
 
   pthread_t thread;
   pthread_t cthread;
@@ -367,111 +477,36 @@ public:
     PopularityMutex.UnLock();
   }
 
-  // stats collection
-
-  void
-  Add(const char* tag, uid_t uid, gid_t gid, unsigned long val, time_t starttime,
-      time_t stoptime)
-  {
-    Mutex.Lock();
-    IostatUid[tag][uid] += val;
-    IostatGid[tag][gid] += val;
-    IostatAvgUid[tag][uid].Add(val, starttime, stoptime);
-    IostatAvgGid[tag][gid].Add(val, starttime, stoptime);
-    Mutex.UnLock();
-  }
+  // warning: you have to lock the mutex if directly used
 
   unsigned long long
-  GetTotal(const char* tag)
+  GetTotal(int tag)
   {
-    google::sparse_hash_map<uid_t, unsigned long long>::const_iterator it;
-    unsigned long long val = 0;
-
-    if (!IostatUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatUid[tag].begin(); it != IostatUid[tag].end(); ++it) {
-      val += it->second;
-    }
-
-    return val;
+    return IostatTotal[tag];
   }
 
-  // warning: you have to lock the mutex if directly used
-
   double
-  GetTotalAvg86400(const char* tag)
+  GetTotalAvg86400(int tag)
   {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg86400();
-    }
-
-    return val;
+    return IostatAvgTotal[tag].GetAvg86400();
   }
 
-  // warning: you have to lock the mutex if directly used
-
   double
-  GetTotalAvg3600(const char* tag)
+  GetTotalAvg3600(int tag)
   {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg3600();
-    }
-
-    return val;
+    return IostatAvgTotal[tag].GetAvg3600();
   }
 
-  // warning: you have to lock the mutex if directly used
-
   double
-  GetTotalAvg300(const char* tag)
+  GetTotalAvg300(int tag)
   {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg300();
-    }
-
-    return val;
+    return IostatAvgTotal[tag].GetAvg300();
   }
 
-  // warning: you have to lock the mutex if directly used
-
   double
-  GetTotalAvg60(const char* tag)
+  GetTotalAvg60(int tag)
   {
-    google::sparse_hash_map<uid_t, IostatAvg>::iterator it;
-    double val = 0;
-
-    if (!IostatAvgUid.count(tag)) {
-      return 0;
-    }
-
-    for (it = IostatAvgUid[tag].begin(); it != IostatAvgUid[tag].end(); ++it) {
-      val += it->second.GetAvg60();
-    }
-
-    return val;
+    return IostatAvgTotal[tag].GetAvg60();
   }
 
   void* Circulate();
@@ -0,0 +1,601 @@
+//------------------------------------------------------------------------------
+// File: JobQueue.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/JobQueue.hh"
+#include "common/Logging.hh"
+#ifdef HAVE_QCLIENT
+#include "namespace/ns_quarkdb/BackendClient.hh"
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+
+EOSMGMNAMESPACE_BEGIN
+
+//! Number of ids reserved at once from the QuarkDB counter
+static const int64_t sIdBlock = 100;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+JobQueue::JobQueue(const std::string& name):
+  mName(name), mAttached(false), mQcl(nullptr),
+  mQdbKey(std::string("eos-jobqueue:") + name),
+  mQdbIdKey(std::string("eos-jobqueue:") + name + ":meta"),
+  mMaster(true), mNextId(1), mIdBlockEnd(0)
+{
+  mDb.setName(std::string("jobqueue.") + name);
+  // Jobs are only written as a whole, no need to look up previous versions
+  mDb.useSeqId(false);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+JobQueue::~JobQueue()
+{
+  Close();
+}
+
+//------------------------------------------------------------------------------
+// Attach the db file and load the jobs stored in it
+//------------------------------------------------------------------------------
+bool
+JobQueue::Open(const std::string& db_file)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mAttached || mQcl || !mJobs.empty()) {
+    eos_static_err("msg=\"job queue already in use\" queue=%s", mName.c_str());
+    return false;
+  }
+
+  if (!mDb.attachDb(db_file, true, 0)) {
+    eos_static_err("msg=\"failed to attach %s db\" queue=%s path=%s",
+                   eos::common::DbMap::getDbType().c_str(), mName.c_str(),
+                   db_file.c_str());
+    return false;
+  }
+
+  // The jobs are indexed in memory, don't keep a second copy in the map
+  mDb.outOfCore(true);
+  mAttached = true;
+  const eos::common::DbMapTypes::Tkey* k;
+  const eos::common::DbMapTypes::Tval* v;
+  std::vector<std::string> invalid;
+
+  for (mDb.beginIter(); mDb.iterate(&k, &v);) {
+    Job job;
+
+    if (!Deserialize(*k, v->value, job) || mKeys.count(job.mKey)) {
+      invalid.push_back(*k);
+      continue;
+    }
+
+    AddPending(job);
+
+    if (job.mId >= mNextId) {
+      mNextId = job.mId + 1;
+    }
+  }
+
+  for (auto it = invalid.begin(); it != invalid.end(); ++it) {
+    eos_static_warning("msg=\"dropping invalid job entry\" queue=%s key=%s",
+                       mName.c_str(), it->c_str());
+    mDb.remove(*it);
+  }
+
+  eos_static_info("msg=\"loaded job queue\" queue=%s path=%s njobs=%lu",
+                  mName.c_str(), db_file.c_str(), mJobs.size());
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Attach the QuarkDB cluster and load the jobs stored in it
+//------------------------------------------------------------------------------
+bool
+JobQueue::OpenQdb(const std::string& qdb_cluster)
+{
+#ifdef HAVE_QCLIENT
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mAttached || mQcl || !mJobs.empty()) {
+    eos_static_err("msg=\"job queue already in use\" queue=%s", mName.c_str());
+    return false;
+  }
+
+  qclient::Members qdb_members;
+
+  if (!qdb_members.parse(qdb_cluster)) {
+    eos_static_err("msg=\"failed to parse qdbcluster members\" queue=%s "
+                   "qdbcluster=\"%s\"", mName.c_str(), qdb_cluster.c_str());
+    return false;
+  }
+
+  mQcl = eos::BackendClient::getInstance(qdb_members);
+
+  if (!LoadQdb()) {
+    mQcl = nullptr;
+    return false;
+  }
+
+  return true;
+#else
+  eos_static_err("msg=\"no QuarkDB support\" queue=%s", mName.c_str());
+  return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Detach the db file or the QuarkDB cluster
+//------------------------------------------------------------------------------
+void
+JobQueue::Close()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mAttached) {
+    mDb.detachDb();
+    mAttached = false;
+  }
+
+  mQcl = nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Track the master state of the MGM
+//------------------------------------------------------------------------------
+void
+JobQueue::SetMaster(bool is_master)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  // Keep the old state if the reload fails so that it is retried
+  if (is_master && !mMaster && mQcl && !LoadQdb()) {
+    return;
+  }
+
+  mMaster = is_master;
+}
+
+//------------------------------------------------------------------------------
+// Enqueue a job
+//------------------------------------------------------------------------------
+bool
+JobQueue::Enqueue(const std::string& group, const std::string& key,
+                  const std::string& data, int priority, time_t due)
+{
+  if ((group.find('|') != std::string::npos) ||
+      (key.find('|') != std::string::npos)) {
+    eos_static_err("msg=\"illegal job\" queue=%s group=\"%s\" key=\"%s\"",
+                   mName.c_str(), group.c_str(), key.c_str());
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mKeys.count(key)) {
+    return true;
+  }
+
+  Job job;
+  job.mId = NextId();
+
+  if (!job.mId) {
+    return false;
+  }
+
+  job.mGroup = group;
+  job.mKey = key;
+  job.mData = data;
+  job.mPriority = priority;
+  job.mDue = (due ? due : time(NULL));
+
+  if (!Store(job)) {
+    return false;
+  }
+
+  AddPending(job);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Dequeue the due jobs of a group
+//------------------------------------------------------------------------------
+size_t
+JobQueue::Dequeue(const std::string& group, size_t max_running,
+                  std::vector<Job>& jobs, time_t now)
+{
+  jobs.clear();
+
+  if (!now) {
+    now = time(NULL);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto git = mGroups.find(group);
+
+  if (git == mGroups.end()) {
+    return 0;
+  }
+
+  Group& grp = git->second;
+  auto it = grp.mPending.begin();
+
+  // Jobs of equal priority are ordered by due time, so the first job of a
+  // priority which is not due yet ends that priority
+  while ((it != grp.mPending.end()) && (grp.mRunning < max_running)) {
+    if (std::get<1>(*it) > now) {
+      it = grp.mPending.lower_bound(Order(std::get<0>(*it) + 1, 0, 0));
+      continue;
+    }
+
+    Entry& entry = mJobs[std::get<2>(*it)];
+    entry.mRunning = true;
+    ++grp.mRunning;
+    jobs.push_back(entry.mJob);
+    it = grp.mPending.erase(it);
+  }
+
+  return jobs.size();
+}
+
+//------------------------------------------------------------------------------
+// Remove a finished job
+//------------------------------------------------------------------------------
+bool
+JobQueue::Done(uint64_t id)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mJobs.find(id);
+
+  if (it == mJobs.end()) {
+    return false;
+  }
+
+  Group& grp = mGroups[it->second.mJob.mGroup];
+
+  if (it->second.mRunning) {
+    --grp.mRunning;
+  } else {
+    grp.mPending.erase(GetOrder(it->second.mJob));
+  }
+
+  if (grp.mPending.empty() && !grp.mRunning) {
+    mGroups.erase(it->second.mJob.mGroup);
+  }
+
+  mKeys.erase(it->second.mJob.mKey);
+  mJobs.erase(it);
+  Erase(id);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Put a running job back into the pending jobs
+//------------------------------------------------------------------------------
+bool
+JobQueue::Retry(uint64_t id, time_t due, const std::string& data)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mJobs.find(id);
+
+  if ((it == mJobs.end()) || !it->second.mRunning) {
+    return false;
+  }
+
+  Job& job = it->second.mJob;
+  job.mDue = due;
+  job.mData = data;
+  ++job.mRetry;
+  Store(job);
+  it->second.mRunning = false;
+  Group& grp = mGroups[job.mGroup];
+  --grp.mRunning;
+  grp.mPending.insert(GetOrder(job));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Check if a job with the given key is pending or running
+//------------------------------------------------------------------------------
+bool
+JobQueue::IsQueued(const std::string& key) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return (mKeys.count(key) != 0);
+}
+
+//------------------------------------------------------------------------------
+// Get the number of pending jobs
+//------------------------------------------------------------------------------
+size_t
+JobQueue::GetPending(const std::string& group) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  size_t n_pending = 0;
+
+  for (auto it = mGroups.begin(); it != mGroups.end(); ++it) {
+    if (group.empty() || (it->first == group)) {
+      n_pending += it->second.mPending.size();
+    }
+  }
+
+  return n_pending;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of running jobs
+//------------------------------------------------------------------------------
+size_t
+JobQueue::GetRunning(const std::string& group) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  size_t n_running = 0;
+
+  for (auto it = mGroups.begin(); it != mGroups.end(); ++it) {
+    if (group.empty() || (it->first == group)) {
+      n_running += it->second.mRunning;
+    }
+  }
+
+  return n_running;
+}
+
+//------------------------------------------------------------------------------
+// Serialize a job into its db key and value
+//------------------------------------------------------------------------------
+void
+JobQueue::Serialize(const Job& job, std::string& key, std::string& value)
+{
+  char skey[32];
+  snprintf(skey, sizeof(skey), "%016llx", (unsigned long long) job.mId);
+  key = skey;
+  value = std::to_string(job.mPriority);
+  value += '|';
+  value += std::to_string((long long) job.mDue);
+  value += '|';
+  value += std::to_string(job.mRetry);
+  value += '|';
+  value += job.mGroup;
+  value += '|';
+  value += job.mKey;
+  value += '|';
+  value += job.mData;
+}
+
+//------------------------------------------------------------------------------
+// Parse a job from its db key and value
+//------------------------------------------------------------------------------
+bool
+JobQueue::Deserialize(const std::string& key, const std::string& value,
+                      Job& job)
+{
+  char* end = 0;
+  job.mId = strtoull(key.c_str(), &end, 16);
+
+  if ((key.length() != 16) || *end || !job.mId) {
+    return false;
+  }
+
+  // The payload is the last field and may contain the separator
+  size_t pos[5];
+  size_t start = 0;
+
+  for (size_t i = 0; i < 5; ++i) {
+    pos[i] = value.find('|', start);
+
+    if (pos[i] == std::string::npos) {
+      return false;
+    }
+
+    start = pos[i] + 1;
+  }
+
+  job.mPriority = atoi(value.substr(0, pos[0]).c_str());
+  job.mDue = (time_t) strtoll(value.c_str() + pos[0] + 1, 0, 10);
+  job.mRetry = (unsigned int) strtoul(value.c_str() + pos[1] + 1, 0, 10);
+  job.mGroup = value.substr(pos[2] + 1, pos[3] - pos[2] - 1);
+  job.mKey = value.substr(pos[3] + 1, pos[4] - pos[3] - 1);
+  job.mData = value.substr(pos[4] + 1);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Reload the index from QuarkDB
+//------------------------------------------------------------------------------
+bool
+JobQueue::LoadQdb()
+{
+#ifdef HAVE_QCLIENT
+  mJobs.clear();
+  mKeys.clear();
+  mGroups.clear();
+  // Reserve a new block for the next job, the previous master may have used
+  // the rest of the current one
+  mNextId = 1;
+  mIdBlockEnd = 0;
+  qclient::QHash jobs_map(*mQcl, mQdbKey);
+  std::pair<std::string, std::unordered_map<std::string, std::string>> reply;
+  std::string cursor = "0";
+  constexpr int64_t count = 10000;
+  std::vector<std::string> invalid;
+
+  try {
+    do {
+      reply = jobs_map.hscan(cursor, count);
+      cursor = reply.first;
+
+      for (const auto& elem : reply.second) {
+        Job job;
+
+        if (!Deserialize(elem.first, elem.second, job) || mKeys.count(job.mKey)) {
+          invalid.push_back(elem.first);
+          continue;
+        }
+
+        AddPending(job);
+      }
+    } while (cursor != "0");
+
+    for (auto it = invalid.begin(); it != invalid.end(); ++it) {
+      eos_static_warning("msg=\"dropping invalid job entry\" queue=%s key=%s",
+                         mName.c_str(), it->c_str());
+      jobs_map.hdel(*it);
+    }
+  } catch (std::runtime_error& qdb_err) {
+    eos_static_err("msg=\"failed to load job queue\" queue=%s err=\"%s\"",
+                   mName.c_str(), qdb_err.what());
+    mJobs.clear();
+    mKeys.clear();
+    mGroups.clear();
+    return false;
+  }
+
+  eos_static_info("msg=\"loaded job queue\" queue=%s qdbkey=%s njobs=%lu",
+                  mName.c_str(), mQdbKey.c_str(), mJobs.size());
+  return true;
+#else
+  return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Get the id of the next enqueued job
+//------------------------------------------------------------------------------
+uint64_t
+JobQueue::NextId()
+{
+#ifdef HAVE_QCLIENT
+
+  if (mQcl && (mNextId > mIdBlockEnd)) {
+    try {
+      qclient::QHash id_map(*mQcl, mQdbIdKey);
+      mIdBlockEnd = id_map.hincrby("next-id", sIdBlock);
+    } catch (std::runtime_error& qdb_err) {
+      eos_static_err("msg=\"failed to reserve job ids\" queue=%s err=\"%s\"",
+                     mName.c_str(), qdb_err.what());
+      return 0;
+    }
+
+    mNextId = mIdBlockEnd - sIdBlock + 1;
+  }
+
+#endif
+  return mNextId++;
+}
+
+//------------------------------------------------------------------------------
+// Add a pending job to the index
+//------------------------------------------------------------------------------
+void
+JobQueue::AddPending(const Job& job)
+{
+  Entry& entry = mJobs[job.mId];
+  entry.mJob = job;
+  entry.mRunning = false;
+  mKeys[job.mKey] = job.mId;
+  mGroups[job.mGroup].mPending.insert(GetOrder(job));
+}
+
+//------------------------------------------------------------------------------
+// Write a job to the db
+//------------------------------------------------------------------------------
+bool
+JobQueue::Store(const Job& job)
+{
+  std::string key, value;
+#ifdef HAVE_QCLIENT
+
+  if (mQcl) {
+    Serialize(job, key, value);
+
+    try {
+      qclient::QHash jobs_map(*mQcl, mQdbKey);
+      jobs_map.hset(key, value);
+    } catch (std::runtime_error& qdb_err) {
+      eos_static_err("msg=\"failed to store job\" queue=%s id=%s key=\"%s\" "
+                     "err=\"%s\"", mName.c_str(), key.c_str(), job.mKey.c_str(),
+                     qdb_err.what());
+      return false;
+    }
+
+    return true;
+  }
+
+#endif
+
+  if (!mAttached) {
+    return true;
+  }
+
+  Serialize(job, key, value);
+
+  if ((long) mDb.set(key, value, "") < 0) {
+    eos_static_err("msg=\"failed to store job\" queue=%s id=%s key=\"%s\"",
+                   mName.c_str(), key.c_str(), job.mKey.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Remove a job from the db
+//------------------------------------------------------------------------------
+bool
+JobQueue::Erase(uint64_t id)
+{
+  char skey[32];
+  snprintf(skey, sizeof(skey), "%016llx", (unsigned long long) id);
+#ifdef HAVE_QCLIENT
+
+  if (mQcl) {
+    try {
+      qclient::QHash jobs_map(*mQcl, mQdbKey);
+      jobs_map.hdel(skey);
+    } catch (std::runtime_error& qdb_err) {
+      eos_static_err("msg=\"failed to remove job\" queue=%s id=%s err=\"%s\"",
+                     mName.c_str(), skey, qdb_err.what());
+      return false;
+    }
+
+    return true;
+  }
+
+#endif
+
+  if (!mAttached) {
+    return true;
+  }
+
+  if (mDb.remove(skey) < 0) {
+    eos_static_err("msg=\"failed to remove job\" queue=%s id=%s",
+                   mName.c_str(), skey);
+    return false;
+  }
+
+  return true;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,271 @@
+//------------------------------------------------------------------------------
+// File: JobQueue.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOSMGM_JOBQUEUE__HH__
+#define __EOSMGM_JOBQUEUE__HH__
+
+#include "mgm/Namespace.hh"
+#include "common/DbMap.hh"
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace qclient
+{
+class QClient;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class JobQueue
+//!
+//! @brief Persistent queue of background jobs (conversions, workflows) kept
+//! in a QuarkDB hash, or in a local DbMap if the MGM has no QuarkDB cluster,
+//! instead of entries in the namespace. Every job belongs to a group e.g. the
+//! space of a conversion - groups are dequeued and accounted independently.
+//! Jobs are handed out by descending priority, then by due time and enqueue
+//! order, and only once they are due. The number of jobs running per group is
+//! bounded by the caller of Dequeue.
+//!
+//! A job is written once when enqueued, overwritten when rescheduled and
+//! removed when done, keyed by its id which grows monotonically, so the
+//! store is only appended to. In QuarkDB the ids are reserved in blocks from
+//! a shared counter, so a new master never reuses the id of a stored job.
+//! The running state is not persisted, after a restart or a master change
+//! all stored jobs are pending again. A job key is unique among the pending
+//! and running jobs, enqueueing the same key twice is a no-op. Without an
+//! attached db the queue works in memory only.
+//------------------------------------------------------------------------------
+class JobQueue
+{
+public:
+  //! Queued job
+  struct Job {
+    Job(): mId(0), mPriority(0), mDue(0), mRetry(0) {}
+
+    uint64_t mId; ///< unique id given by the queue
+    std::string mGroup; ///< group the job is dequeued and accounted in
+    std::string mKey; ///< unique key of the job
+    std::string mData; ///< opaque payload
+    int mPriority; ///< higher priorities are dequeued first
+    time_t mDue; ///< time before which the job is not dequeued
+    unsigned int mRetry; ///< number of reschedules
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param name name of the queue used for logging
+  //----------------------------------------------------------------------------
+  JobQueue(const std::string& name);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~JobQueue();
+
+  //----------------------------------------------------------------------------
+  //! Attach the db file and load the jobs stored in it, must be called before
+  //! any job is enqueued
+  //!
+  //! @param db_file path of the db
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Open(const std::string& db_file);
+
+  //----------------------------------------------------------------------------
+  //! Attach the QuarkDB cluster and load the jobs stored in it, must be called
+  //! before any job is enqueued
+  //!
+  //! @param qdb_cluster cluster members "host1:port1 host2:port2 ..."
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool OpenQdb(const std::string& qdb_cluster);
+
+  //----------------------------------------------------------------------------
+  //! Detach the db file or the QuarkDB cluster, the jobs stay in memory
+  //----------------------------------------------------------------------------
+  void Close();
+
+  //----------------------------------------------------------------------------
+  //! Track the master state of the MGM. When it becomes the master again the
+  //! jobs are reloaded from QuarkDB to pick up the ones queued by the previous
+  //! master, a local db has nothing new to load.
+  //!
+  //! @param is_master true if the MGM is the master
+  //----------------------------------------------------------------------------
+  void SetMaster(bool is_master);
+
+  //----------------------------------------------------------------------------
+  //! Enqueue a job
+  //!
+  //! @param group group of the job, must not contain '|'
+  //! @param key unique key of the job, must not contain '|'
+  //! @param data opaque payload
+  //! @param priority higher priorities are dequeued first
+  //! @param due time before which the job is not dequeued, 0 for now
+  //!
+  //! @return true if the job is queued (also if already queued), otherwise
+  //!         false
+  //----------------------------------------------------------------------------
+  bool Enqueue(const std::string& group, const std::string& key,
+               const std::string& data, int priority = 0, time_t due = 0);
+
+  //----------------------------------------------------------------------------
+  //! Dequeue the due jobs of a group and mark them as running
+  //!
+  //! @param group group to dequeue from
+  //! @param max_running maximum number of running jobs of the group
+  //! @param jobs filled with the dequeued jobs
+  //! @param now current time, 0 to use the system time
+  //!
+  //! @return number of dequeued jobs
+  //----------------------------------------------------------------------------
+  size_t Dequeue(const std::string& group, size_t max_running,
+                 std::vector<Job>& jobs, time_t now = 0);
+
+  //----------------------------------------------------------------------------
+  //! Remove a finished job
+  //!
+  //! @return true if the job existed, otherwise false
+  //----------------------------------------------------------------------------
+  bool Done(uint64_t id);
+
+  //----------------------------------------------------------------------------
+  //! Put a running job back into the pending jobs
+  //!
+  //! @param id id of the job
+  //! @param due time before which the job is not dequeued again
+  //! @param data new payload of the job
+  //!
+  //! @return true if the job was running, otherwise false
+  //----------------------------------------------------------------------------
+  bool Retry(uint64_t id, time_t due, const std::string& data);
+
+  //----------------------------------------------------------------------------
+  //! Check if a job with the given key is pending or running
+  //----------------------------------------------------------------------------
+  bool IsQueued(const std::string& key) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the number of pending jobs of a group or of all groups
+  //----------------------------------------------------------------------------
+  size_t GetPending(const std::string& group = "") const;
+
+  //----------------------------------------------------------------------------
+  //! Get the number of running jobs of a group or of all groups
+  //----------------------------------------------------------------------------
+  size_t GetRunning(const std::string& group = "") const;
+
+private:
+  //! Scheduling order of the pending jobs: priority, due time and id
+  typedef std::tuple<int, time_t, uint64_t> Order;
+
+  //! Jobs of a group
+  struct Group {
+    Group(): mRunning(0) {}
+
+    std::set<Order> mPending; ///< pending jobs in scheduling order
+    size_t mRunning; ///< number of running jobs
+  };
+
+  //! Job with its state
+  struct Entry {
+    Job mJob; ///< job
+    bool mRunning; ///< true if dequeued and not yet done
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the scheduling order of a job
+  //----------------------------------------------------------------------------
+  static Order GetOrder(const Job& job)
+  {
+    return Order(-job.mPriority, job.mDue, job.mId);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Serialize a job into its db key and value
+  //----------------------------------------------------------------------------
+  static void Serialize(const Job& job, std::string& key, std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Parse a job from its db key and value
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Deserialize(const std::string& key, const std::string& value,
+                          Job& job);
+
+  //----------------------------------------------------------------------------
+  //! Reload the index from QuarkDB - mMutex must be locked
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool LoadQdb();
+
+  //----------------------------------------------------------------------------
+  //! Get the id of the next enqueued job - mMutex must be locked
+  //!
+  //! @return id or 0 if no id could be reserved
+  //----------------------------------------------------------------------------
+  uint64_t NextId();
+
+  //----------------------------------------------------------------------------
+  //! Add a pending job to the index - mMutex must be locked
+  //----------------------------------------------------------------------------
+  void AddPending(const Job& job);
+
+  //----------------------------------------------------------------------------
+  //! Write a job to the db if attached - mMutex must be locked
+  //----------------------------------------------------------------------------
+  bool Store(const Job& job);
+
+  //----------------------------------------------------------------------------
+  //! Remove a job from the db if attached - mMutex must be locked
+  //----------------------------------------------------------------------------
+  bool Erase(uint64_t id);
+
+  std::string mName; ///< name of the queue
+  mutable std::mutex mMutex; ///< mutex protecting all members
+  eos::common::DbMap mDb; ///< persistent copy of the jobs
+  bool mAttached; ///< true if the db is attached
+  qclient::QClient* mQcl; ///< QuarkDB client if attached - no ownership
+  std::string mQdbKey; ///< QuarkDB hash of the jobs
+  std::string mQdbIdKey; ///< QuarkDB hash of the id counter
+  bool mMaster; ///< last master state given to SetMaster
+  uint64_t mNextId; ///< id of the next enqueued job
+  uint64_t mIdBlockEnd; ///< last id reserved in QuarkDB
+  std::map<uint64_t, Entry> mJobs; ///< all jobs by id
+  std::map<std::string, uint64_t> mKeys; ///< job ids by key
+  std::map<std::string, Group> mGroups; ///< jobs by group
+};
+
+EOSMGMNAMESPACE_END
+
+#endif
@@ -29,6 +29,7 @@
 #include "mgm/Quota.hh"
 #include "mgm/LRU.hh"
 #include "mgm/Stat.hh"
+#include "mgm/Converter.hh"
 #include "mgm/Master.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/XrdMgmOfsDirectory.hh"
@@ -496,7 +497,6 @@ LRU::CacheExpire(const char* dir,
                     "deletion-bytes=%s", lwm, hwm,  cwm,
                     StringConversion::GetReadableSizeString(sizestring, bytes_to_free, "B"));
   // Build the LRU list
-  std::map<std::string, std::set<std::string> > cachedirs;
   XrdOucString stdErr;
   time_t ms = 0;
 
@@ -508,61 +508,63 @@ LRU::CacheExpire(const char* dir,
   // map with path/mtime pairs
   std::set<lru_entry_t> lru_map;
   unsigned long long lru_size = 0;
+  // Build the LRU list while the find is running, directory by directory.
+  // We just keep as many entries in the LRU list to have the required
+  // number of bytes to free available.
+  auto add_files = [&](const std::string & path, std::set<std::string>& files) {
+    eos_static_debug("path=%s", path.c_str());
+
+    for (auto fit = files.begin(); fit != files.end(); fit++) {
+      // build the full path name
+      std::string fpath = path;
+      fpath += *fit;
+      struct stat buf;
+      eos_static_debug("path=%s", fpath.c_str());
+
+      // get the current ctime & size information
+      if (!gOFS->_stat(fpath.c_str(), &buf, mError, mRootVid, "")) {
+        if (lru_map.size())
+          if ((lru_size > bytes_to_free) &&
+              lru_map.size() &&
+              ((--lru_map.end())->ctime < buf.st_ctime)) {
+            // this entry is newer than all the rest
+            continue;
+          }
 
-  if (!gOFS->_find(dir, mError, stdErr, mRootVid, cachedirs, "", "", false, ms)) {
-    // Loop through the result and build an LRU list
-    // We just keep as many entries in the LRU list to have the required
-    // number of bytes to free available.
-    for (auto dit = cachedirs.begin(); dit != cachedirs.end(); dit++) {
-      eos_static_debug("path=%s", dit->first.c_str());
-
-      for (auto fit = dit->second.begin(); fit != dit->second.end(); fit++) {
-        // build the full path name
-        std::string fpath = dit->first;
-        fpath += *fit;
-        struct stat buf;
-        eos_static_debug("path=%s", fpath.c_str());
-
-        // get the current ctime & size information
-        if (!gOFS->_stat(fpath.c_str(), &buf, mError, mRootVid, "")) {
-          if (lru_map.size())
-            if ((lru_size > bytes_to_free) &&
-                lru_map.size() &&
-                ((--lru_map.end())->ctime < buf.st_ctime)) {
-              // this entry is newer than all the rest
-              continue;
-            }
-
-          // add LRU entry in front
-          lru_entry_t lru;
-          lru.path = fpath;
-          lru.ctime = buf.st_ctime;
-          lru.size = buf.st_blocks * buf.st_blksize;
-          lru_map.insert(lru);
-          lru_size += lru.size;
-          eos_static_debug("msg=\"adding\" file=\"%s\" "
-                           "bytes-free=\"%llu\" lru-size=\"%llu\"",
-                           fpath.c_str(),
-                           bytes_to_free,
-                           lru_size);
-
-          // check if we can shrink the LRU map
-          if (lru_map.size() && (lru_size > bytes_to_free)) {
-            while (lru_map.size() &&
-                   ((lru_size - (--lru_map.end())->size) > bytes_to_free)) {
-              // remove the last element  of the map
-              auto it = lru_map.end();
-              it--;
-              // substract the size
-              lru_size -= it->size;
-              eos_static_info("msg=\"clean-up\" path=\"%s\"", it->path.c_str());
-              lru_map.erase(it);
-            }
+        // add LRU entry in front
+        lru_entry_t lru;
+        lru.path = fpath;
+        lru.ctime = buf.st_ctime;
+        lru.size = buf.st_blocks * buf.st_blksize;
+        lru_map.insert(lru);
+        lru_size += lru.size;
+        eos_static_debug("msg=\"adding\" file=\"%s\" "
+                         "bytes-free=\"%llu\" lru-size=\"%llu\"",
+                         fpath.c_str(),
+                         bytes_to_free,
+                         lru_size);
+
+        // check if we can shrink the LRU map
+        if (lru_map.size() && (lru_size > bytes_to_free)) {
+          while (lru_map.size() &&
+                 ((lru_size - (--lru_map.end())->size) > bytes_to_free)) {
+            // remove the last element  of the map
+            auto it = lru_map.end();
+            it--;
+            // substract the size
+            lru_size -= it->size;
+            eos_static_info("msg=\"clean-up\" path=\"%s\"", it->path.c_str());
+            lru_map.erase(it);
           }
         }
       }
     }
-  } else {
+
+    return true;
+  };
+
+  if (gOFS->_find(dir, mError, stdErr, mRootVid, add_files, "", "", false,
+                  ms)) {
     eos_static_err("msg=\"%s\"", stdErr.c_str());
   }
 
@@ -746,17 +748,16 @@ LRU::ConvertMatch(const char* dir,
 
     snprintf(conversiontagfile,
              sizeof(conversiontagfile) - 1,
-             "%s/%016llx:%s#%s%s",
-             gOFS->MgmProcConversionPath.c_str(),
+             "%016llx:%s#%s%s",
              it->first,
              space.c_str(),
              conversion.c_str(),
              plctplcy.c_str());
-    eos_static_notice("msg=\"creating conversion tag file\" tag-file=%s",
+    eos_static_notice("msg=\"queueing conversion job\" job=%s",
                       conversiontagfile);
 
-    if (gOFS->_touch(conversiontagfile, mError, mRootVid, 0)) {
-      eos_static_err("msg=\"unable to create conversion job\" job-file=\"%s\"",
+    if (!Converter::Schedule(conversiontagfile)) {
+      eos_static_err("msg=\"unable to create conversion job\" job=\"%s\"",
                      conversiontagfile);
     }
   }
@@ -44,7 +44,8 @@ Messaging::Messaging(const char* url, const char* defaultreceiverqueue,
   SharedObjectManager = som;
 
   // we add to a broker with the flushbacklog flag since we don't want to block message flow in case of a master/slave MGM where one got stuck or too slow
-  if (gMessageClient.AddBroker(url, advisorystatus, advisoryquery , true)) {
+  if (gMessageClient.AddBroker(url, advisorystatus, advisoryquery , true,
+                               XMQCLONGPOLLTIME)) {
     zombie = false;
   } else {
     zombie = true;
@@ -195,8 +196,11 @@ Messaging::Listen()
     } else {
       XrdSysThread::SetCancelOn();
       XrdSysThread::CancelPoint();
-      XrdSysTimer sleeper;
-      sleeper.Wait(1000);
+
+      if (!gMessageClient.LongPollWaited()) {
+        XrdSysTimer sleeper;
+        sleeper.Wait(1000);
+      }
     }
   }
 }
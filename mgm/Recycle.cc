@@ -333,56 +333,59 @@ Recycle::Recycler()
                   //.............................................................
                   // do a directory deletion - first find all subtree children
                   //.............................................................
-                  std::map<std::string, std::set<std::string> > found;
-                  std::map<std::string, std::set<std::string> >::const_reverse_iterator rfoundit;
-                  std::set<std::string>::const_iterator fileit;
+                  std::set<std::string> founddirs;
                   XrdOucString stdErr;
+                  //...........................................................
+                  // delete the files while the subtree is listed
+                  //...........................................................
+                  auto remove_files = [&](const std::string & dir,
+                  std::set<std::string>& files) {
+                    founddirs.insert(dir);
+
+                    for (auto fileit = files.begin(); fileit != files.end();
+                         fileit++) {
+                      std::string fspath = dir;
+                      std::string fname = *fileit;
+                      size_t lpos;
+
+                      if ((lpos = fname.find(" -> ")) != std::string::npos) {
+                        // rewrite link name
+                        fname.erase(lpos);
+                      }
 
-                  if (gOFS->_find(it->second.c_str(), lError, stdErr, rootvid, found)) {
-                    eos_static_err("msg=\"unable to do a find in subtree\" path=%s stderr=\"%s\"",
-                                   it->second.c_str(), stdErr.c_str());
-                  } else {
-                    //...........................................................
-                    // standard way to delete files recursively
-                    //...........................................................
-                    // delete files starting at the deepest level
-                    for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++) {
-                      for (fileit = rfoundit->second.begin(); fileit != rfoundit->second.end();
-                           fileit++) {
-                        std::string fspath = rfoundit->first;
-                        std::string fname = *fileit;
-                        size_t lpos;
-
-                        if ((lpos = fname.find(" -> ")) != std::string::npos) {
-                          // rewrite link name
-                          fname.erase(lpos);
-                        }
-
-                        fspath += fname;
+                      fspath += fname;
 
-                        if (gOFS->_rem(fspath.c_str(), lError, rootvid, (const char*) 0)) {
-                          eos_static_err("msg=\"unable to remove file\" path=%s", fspath.c_str());
-                        } else {
-                          eos_static_info("msg=\"permanently deleted file from recycle bin\" path=%s keep-time=%llu",
-                                          fspath.c_str(), lKeepTime);
-                        }
+                      if (gOFS->_rem(fspath.c_str(), lError, rootvid, (const char*) 0)) {
+                        eos_static_err("msg=\"unable to remove file\" path=%s", fspath.c_str());
+                      } else {
+                        eos_static_info("msg=\"permanently deleted file from recycle bin\" path=%s keep-time=%llu",
+                                        fspath.c_str(), lKeepTime);
                       }
                     }
 
+                    return true;
+                  };
+
+                  if (gOFS->_find(it->second.c_str(), lError, stdErr, rootvid,
+                                  remove_files)) {
+                    eos_static_err("msg=\"unable to do a find in subtree\" path=%s stderr=\"%s\"",
+                                   it->second.c_str(), stdErr.c_str());
+                  } else {
                     //...........................................................
                     // delete directories starting at the deepest level
                     //...........................................................
-                    for (rfoundit = found.rbegin(); rfoundit != found.rend(); rfoundit++) {
+                    for (auto rfoundit = founddirs.rbegin();
+                         rfoundit != founddirs.rend(); rfoundit++) {
                       //.........................................................
                       // don't even try to delete the root directory
                       //.........................................................
-                      std::string fspath = rfoundit->first.c_str();
+                      std::string fspath = rfoundit->c_str();
 
                       if (fspath == "/") {
                         continue;
                       }
 
-                      if (gOFS->_remdir(rfoundit->first.c_str(), lError, rootvid, (const char*) 0)) {
+                      if (gOFS->_remdir(rfoundit->c_str(), lError, rootvid, (const char*) 0)) {
                         eos_static_err("msg=\"unable to remove directory\" path=%s", fspath.c_str());
                       } else {
                         eos_static_info("msg=\"permanently deleted directory from recycle bin\" path=%s keep-time=%llu",
@@ -39,6 +39,7 @@
 #include "XrdSys/XrdSysTimer.hh"
 #include "Xrd/XrdScheduler.hh"
 #include "XrdCl/XrdClDefaultEnv.hh"
+#include <limits>
 
 #define EOS_WFE_BASH_PREFIX "/var/eos/wfe/bash/"
 
@@ -54,7 +55,7 @@ EOSMGMNAMESPACE_BEGIN
 using namespace eos::common;
 
 /*----------------------------------------------------------------------------*/
-WFE::WFE()
+WFE::WFE(): mQueue("workflow")
 /*----------------------------------------------------------------------------*/
 /**
  * @brief Constructor of the work flow engine
@@ -122,8 +123,9 @@ WFE::WFEr()
 /**
  * @brief WFE method doing the actual workflow
  *
- * This thread method loops in regular intervals over all workflow jobs in the
- * workflow directory /eos/<instance>/proc/workflow/
+ * This thread method loops in regular intervals over all due workflow jobs in
+ * the workflow job queue and cleans old entries in the workflow directory
+ * /eos/<instance>/proc/workflow/
  */
 /*----------------------------------------------------------------------------*/
 {
@@ -148,12 +150,14 @@ WFE::WFEr()
 
   XrdSysTimer sleeper;
   sleeper.Snooze(10);
+
   //----------------------------------------------------------------------------
   // Eternal thread doing WFE scans
   //----------------------------------------------------------------------------
   time_t snoozetime = 10;
   size_t lWFEntx = 0;
   time_t cleanuptime = 0;
+  bool was_master = false;
   eos_static_info("msg=\"async WFE thread started\"");
 
   while (1) {
@@ -166,8 +170,6 @@ WFE::WFEr()
     time_t lStartTime = time(NULL);
     time_t lStopTime;
     time_t lKeepTime = 7 * 86400;
-    std::map<std::string, std::set<std::string> > wfedirs;
-    XrdOucString stdErr;
     {
       eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
 
@@ -195,129 +197,81 @@ WFE::WFEr()
       }
     }
 
+    bool is_master = gOFS->MgmMaster.IsMaster();
+    // pick up the jobs queued by the previous master
+    mQueue.SetMaster(is_master);
+
+    // queue the jobs left in the workflow directory by a previous version or
+    // a previous master whenever this MGM becomes the master
+    if (is_master && !was_master) {
+      ImportJobs();
+    }
+
+    was_master = is_master;
+
     // only a master needs to run WFE
-    if (gOFS->MgmMaster.IsMaster() && IsEnabledWFE) {
+    if (is_master && IsEnabledWFE) {
       // -------------------------------------------------------------------------
-      // do a find
+      // schedule the due jobs of the queue, without ntx there is no limit
       // -------------------------------------------------------------------------
       eos_static_info("msg=\"start WFE scan\"");
-      // -------------------------------------------------------------------------
-      // find all directories defining an WFE policy
-      // -------------------------------------------------------------------------
       gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
       EXEC_TIMING_BEGIN("WFEFind");
-      // prepare four queries today, yestereday for queued and error jobs
-      std::string queries[4];
-
-      for (size_t i = 0; i < 4; ++i) {
-        queries[i] = gOFS->MgmProcWorkflowPath.c_str();
-        queries[i] += "/";
-      }
-
-      {
-        // today
-        time_t when = time(NULL);
-        std::string day = eos::common::Timing::UnixTimstamp_to_Day(when);
-        queries[0] += day;
-        queries[0] += "/q/";
-        queries[1] += day;
-        queries[1] += "/e/";
-        //yesterday
-        when -= (24 * 3600);
-        day = eos::common::Timing::UnixTimstamp_to_Day(when);
-        queries[2] += day;
-        queries[2] += "/q/";
-        queries[3] += day;
-        queries[3] += "/e/";
-      }
-
-      for (size_t i = 0; i < 4; ++i) {
-        eos_static_info("query-path=%s", queries[i].c_str());
-        gOFS->_find(queries[i].c_str(),
-                    mError,
-                    stdErr,
-                    mRootVid,
-                    wfedirs,
-                    0,
-                    0,
-                    false,
-                    0,
-                    false,
-                    0
-                   );
-      }
+      size_t max_running = (lWFEntx ? lWFEntx :
+                            std::numeric_limits<size_t>::max());
+      size_t nscheduled = 0;
+
+      while (1) {
+        std::vector<JobQueue::Job> jobs;
+
+        if (!mQueue.Dequeue("default", max_running, jobs)) {
+          // wait for running jobs to finish if there are more to schedule
+          if (mQueue.GetPending() && (mQueue.GetRunning() >= max_running)) {
+            mDoneSignal.Wait(10);
+            continue;
+          }
 
-      {
-        eos_static_info("msg=\"finished WFE find\" WFE-dirs=%llu %s",
-                        wfedirs.size(), stdErr.c_str()
-                       );
-        time_t now = time(NULL);
-
-        for (auto it = wfedirs.begin(); it != wfedirs.end(); it++) {
-          // -------------------------------------------------------------------
-          // get workflows
-          // -------------------------------------------------------------------
-          if (it->second.size()) {
-            for (auto wit = it->second.begin(); wit != it->second.end(); ++wit) {
-              eos_static_info("wfe-dir=\"%s\" wfe-job=\"%s\"", it->first.c_str(),
-                              wit->c_str());
-              std::string f = it->first;
-              f += *wit;
-              Job* job = new Job();
-
-              if (!job || job->Load(f)) {
-                eos_static_err("msg=\"cannot load workflow entry\" value=\"%s\"", f.c_str());
-
-                if (job) {
-                  delete job;
-                }
-              } else {
-                // don't schedule jobs for the future
-                if ((!job->mActions.size()) || (now < job->mActions[0].mTime)) {
-                  delete job;
-                  continue;
-                }
+          break;
+        }
 
-                // stop scheduling if there are too many jobs running
-                if ((lWFEntx - GetActiveJobs()) <= 0) {
-                  if (lWFEntx > 0) {
-                    mDoneSignal.Wait(10);
+        for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+          Job* job = new Job();
 
-                    if ((lWFEntx - GetActiveJobs()) <= 0) {
-                      delete job;
-                      break;
-                    }
-                  }
-                }
+          if (job->Deserialize(it->mData) || !job->mActions.size()) {
+            eos_static_err("msg=\"cannot load workflow job\" key=\"%s\"",
+                           it->mKey.c_str());
+            mQueue.Done(it->mId);
+            delete job;
+            continue;
+          }
 
-                if (!job->IsSync()) {
-                  // use the shared scheduler for asynchronous jobs
-                  XrdSysMutexHelper sLock(gSchedulerMutex);
-                  time_t storetime = 0;
-                  // move job into the scheduled queue
-                  job->Move("q", "s", storetime);
-                  job->mActions[0].mQueue = "s";
-                  job->mActions[0].mTime = storetime;
-                  XrdOucString tst;
-                  job->mActions[0].mWhen = eos::common::StringConversion::GetSizeString(tst,
-                                           (unsigned long long) storetime);
-                  gScheduler->Schedule((XrdJob*) job);
-                  IncActiveJobs();
-                  eos_static_info("msg=\"scheduled workflow\" job=\"%s\"",
-                                  job->mDescription.c_str());
-                } else {
-                  delete job;
-                }
-              }
-            }
+          job->mQueueId = it->mId;
+
+          if (job->mActions[0].mQueue == "q") {
+            // store the job in the scheduled queue, retried jobs stay in the
+            // error queue until they run
+            time_t storetime = 0;
+            job->Save("s", storetime, 0, job->mRetry);
+            job->mActions[0].mQueue = "s";
+            job->mActions[0].mTime = storetime;
+            XrdOucString tst;
+            job->mActions[0].mWhen = eos::common::StringConversion::GetSizeString(tst,
+                                     (unsigned long long) storetime);
           }
+
+          // use the shared scheduler for asynchronous jobs
+          XrdSysMutexHelper sLock(gSchedulerMutex);
+          gScheduler->Schedule((XrdJob*) job);
+          IncActiveJobs();
+          ++nscheduled;
+          eos_static_info("msg=\"scheduled workflow\" job=\"%s\"",
+                          job->mDescription.c_str());
         }
       }
 
       EXEC_TIMING_END("WFEFind");
-      eos_static_info("msg=\"finished WFE application\" WFE-dirs=%llu",
-                      wfedirs.size()
-                     );
+      eos_static_info("msg=\"finished WFE application\" scheduled=%llu queued=%llu",
+                      nscheduled, mQueue.GetPending());
     }
 
     lStopTime = time(NULL);
@@ -404,6 +358,61 @@ WFE::WFEr()
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+void
+WFE::ImportJobs()
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief queue the jobs of today and yesterday found in the queued and error
+ *        directories of the workflow directory, queued entries are removed
+ *        while error entries stay until the job runs again
+ */
+/*----------------------------------------------------------------------------*/
+{
+  std::map<std::string, std::set<std::string> > wfedirs;
+  XrdOucString stdErr;
+  time_t when = time(NULL);
+
+  for (size_t i = 0; i < 2; ++i) {
+    std::string day = eos::common::Timing::UnixTimstamp_to_Day(when);
+    std::string queries[2] = {"/q/", "/e/"};
+
+    for (size_t j = 0; j < 2; ++j) {
+      queries[j] = gOFS->MgmProcWorkflowPath.c_str() + std::string("/") + day +
+                   queries[j];
+      eos_static_info("query-path=%s", queries[j].c_str());
+      gOFS->_find(queries[j].c_str(), mError, stdErr, mRootVid, wfedirs,
+                  0, 0, false, 0, false, 0);
+    }
+
+    when -= (24 * 3600);
+  }
+
+  for (auto it = wfedirs.begin(); it != wfedirs.end(); it++) {
+    for (auto wit = it->second.begin(); wit != it->second.end(); ++wit) {
+      std::string f = it->first;
+      f += *wit;
+      Job job;
+
+      if (job.Load(f) || !job.mActions.size()) {
+        eos_static_err("msg=\"cannot load workflow entry\" value=\"%s\"",
+                       f.c_str());
+        continue;
+      }
+
+      if (Enqueue(job)) {
+        continue;
+      }
+
+      eos_static_info("msg=\"queued workflow entry\" value=\"%s\"", f.c_str());
+
+      if (job.mActions[0].mQueue == "q") {
+        job.Delete("q");
+      }
+    }
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 int
 /*----------------------------------------------------------------------------*/
@@ -1470,6 +1479,7 @@ WFE::Job::DoIt(bool issync)
                     Move("r", "e", storetime, ++mRetry);
                     XrdOucString log = "scheduled for retry";
                     Results("e", EAGAIN , log, storetime);
+                    gOFS->WFEd.Retry(*this, storetime);
                   } else {
                     storetime = (time_t) mActions[0].mTime;
                     // can not retry
@@ -1837,6 +1847,7 @@ WFE::Job::DoIt(bool issync)
   }
 
   if (!IsSync()) {
+    gOFS->WFEd.Done(*this);
     gOFS->WFEd.GetSignal()->Signal();
     gOFS->WFEd.DecActiveJobs();
   }
@@ -1844,6 +1855,176 @@ WFE::Job::DoIt(bool issync)
   return retc;
 }
 
+/*----------------------------------------------------------------------------*/
+static void
+AppendField(std::string& out, const std::string& field)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief append a length prefixed field to a serialized job
+ */
+/*----------------------------------------------------------------------------*/
+{
+  out += std::to_string(field.length());
+  out += ':';
+  out += field;
+}
+
+/*----------------------------------------------------------------------------*/
+static bool
+ReadField(const std::string& in, size_t& pos, std::string& field)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief read a length prefixed field of a serialized job
+ * @return true if success
+ */
+/*----------------------------------------------------------------------------*/
+{
+  size_t colon = in.find(':', pos);
+
+  if (colon == std::string::npos) {
+    return false;
+  }
+
+  size_t len = strtoul(in.c_str() + pos, 0, 10);
+
+  if ((colon == pos) || (colon + 1 + len > in.length())) {
+    return false;
+  }
+
+  field = in.substr(colon + 1, len);
+  pos = colon + 1 + len;
+  return true;
+}
+
+/*----------------------------------------------------------------------------*/
+std::string
+WFE::Job::Serialize(std::string queue, time_t when)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief serialize the first action of a job for the job queue
+ * @param queue queue the job is in when dequeued
+ * @param when time of the action
+ * @return serialized job
+ */
+/*----------------------------------------------------------------------------*/
+{
+  std::string out;
+  XrdOucString hexfid;
+  eos::common::FileId::Fid2Hex(mFid, hexfid);
+  AppendField(out, hexfid.c_str());
+  AppendField(out, std::to_string((unsigned long long) when));
+  AppendField(out, std::to_string(mRetry));
+  AppendField(out, queue);
+  AppendField(out, mActions[0].mEvent);
+  AppendField(out, mActions[0].mWorkflow);
+  AppendField(out, mActions[0].mAction);
+  AppendField(out, eos::common::Mapping::VidToString(mVid));
+  return out;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+WFE::Job::Deserialize(const std::string& data)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief load a workflow job from its job queue representation
+ * @return SFS_OK if success
+ */
+/*----------------------------------------------------------------------------*/
+{
+  std::string fields[8];
+  size_t pos = 0;
+
+  for (size_t i = 0; i < 8; ++i) {
+    if (!ReadField(data, pos, fields[i])) {
+      eos_static_err("msg=\"illegal workflow job\" data=\"%s\"", data.c_str());
+      return SFS_ERROR;
+    }
+  }
+
+  mFid = eos::common::FileId::Hex2Fid(fields[0].c_str());
+  mRetry = (int) strtoul(fields[2].c_str(), 0, 10);
+  AddAction(fields[6], fields[4], (time_t) strtoull(fields[1].c_str(), 0, 10),
+            fields[5], fields[3]);
+
+  if (!eos::common::Mapping::VidFromString(mVid, fields[7].c_str())) {
+    eos_static_crit("parsing of %s failed - setting nobody\n", fields[7].c_str());
+    eos::common::Mapping::Nobody(mVid);
+  }
+
+  return SFS_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+WFE::Enqueue(Job& job)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief queue an asynchronous workflow job, it is stored in the scheduled
+ *        queue of the workflow directory once it is due
+ * @return SFS_OK if success
+ */
+/*----------------------------------------------------------------------------*/
+{
+  if (job.mActions.size() != 1) {
+    return SFS_ERROR;
+  }
+
+  // a job is unique like its entry in the workflow directory
+  XrdOucString hexfid;
+  eos::common::FileId::Fid2Hex(job.mFid, hexfid);
+  std::string key = job.mActions[0].mWorkflow + "/" + job.mActions[0].mWhen +
+                    ":" + hexfid.c_str() + ":" + job.mActions[0].mEvent;
+
+  if (!mQueue.Enqueue("default", key,
+                      job.Serialize(job.mActions[0].mQueue, job.mActions[0].mTime),
+                      0, job.mActions[0].mTime)) {
+    eos_static_err("msg=\"failed to queue workflow job\" job=\"%s\"",
+                   job.mDescription.c_str());
+    return SFS_ERROR;
+  }
+
+  return SFS_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+int
+WFE::Retry(Job& job, time_t when)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief queue a running job again to run at the given time from the error
+ *        queue of the workflow directory
+ * @return SFS_OK if success
+ */
+/*----------------------------------------------------------------------------*/
+{
+  if (!job.mQueueId || !mQueue.Retry(job.mQueueId, when, job.Serialize("e",
+                                     when))) {
+    eos_static_err("msg=\"failed to queue workflow job for retry\" job=\"%s\"",
+                   job.mDescription.c_str());
+    return SFS_ERROR;
+  }
+
+  // the job stays queued
+  job.mQueueId = 0;
+  return SFS_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::Done(Job& job)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief remove a finished job from the job queue
+ */
+/*----------------------------------------------------------------------------*/
+{
+  if (job.mQueueId) {
+    mQueue.Done(job.mQueueId);
+    job.mQueueId = 0;
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 void
 WFE::PublishActiveJobs()
@@ -28,6 +28,7 @@
 #include "common/Mapping.hh"
 #include "common/Timing.hh"
 #include "common/FileId.hh"
+#include "mgm/JobQueue.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
 #include "Xrd/XrdJob.hh"
@@ -65,6 +66,10 @@ private:
   /// condition variabl to get signalled for a done job
   XrdSysCondVar mDoneSignal;
 
+  /// persistent queue of the asynchronous jobs waiting to run or to be retried,
+  /// shared by the MGMs through QuarkDB if configured
+  JobQueue mQueue;
+
 public:
 
   /* Default Constructor - use it to run the WFE thread by calling Start
@@ -105,6 +110,10 @@ public:
    */
   void* WFEr();
 
+  /* Queue the jobs left in the workflow directory by a previous version
+   */
+  void ImportJobs();
+
   /**
    * @brief Destructor
    *
@@ -149,6 +158,7 @@ public:
     {
       mFid = 0;
       mRetry = 0;
+      mQueueId = 0;
     }
 
     Job(eos::common::FileId::fileid_t fid,
@@ -156,6 +166,7 @@ public:
     {
       mFid = fid;
       mRetry = 0;
+      mQueueId = 0;
       eos::common::Mapping::Copy(vid, mVid);
     }
 
@@ -169,6 +180,7 @@ public:
       mFid = other.mFid;
       mDescription = other.mDescription;
       mRetry = other.mRetry;
+      mQueueId = other.mQueueId;
     }
     // ---------------------------------------------------------------------------
     // Job execution function
@@ -191,6 +203,13 @@ public:
 
     int Delete(std::string queue);
 
+    // -------------------------------------------------------------------------
+    // job queue related methods
+    // -------------------------------------------------------------------------
+    std::string Serialize(std::string queue, time_t when);
+
+    int Deserialize(const std::string& data);
+
     // -------------------------------------------------------------------------
 
     void AddAction(std::string action,
@@ -227,8 +246,37 @@ public:
     eos::common::Mapping::VirtualIdentity mVid;
     std::string mWorkflowPath;
     int mRetry;///! number of retries
+    uint64_t mQueueId; ///! id in the job queue, 0 if not queued
   };
 
+  /**
+   * @brief attach the db of the job queue
+   * @param db_file path of the local db
+   * @param qdb_cluster QuarkDB cluster members, if not empty the queue is
+   *        stored there instead of the local db
+   * @return true if successful
+   */
+  bool OpenQueue(const std::string& db_file, const std::string& qdb_cluster)
+  {
+    if (!qdb_cluster.empty()) {
+      return mQueue.OpenQdb(qdb_cluster);
+    }
+
+    return mQueue.Open(db_file);
+  }
+
+  /* Queue an asynchronous job to be run when due
+   */
+  int Enqueue(Job& job);
+
+  /* Queue a running job again to be retried at the given time
+   */
+  int Retry(Job& job, time_t when);
+
+  /* Remove a finished job from the queue
+   */
+  void Done(Job& job);
+
   XrdSysCondVar* GetSignal()
   {
     return &mDoneSignal;
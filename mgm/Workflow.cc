@@ -153,7 +153,7 @@ Workflow::Create(eos::common::Mapping::VirtualIdentity& vid)
     retc = job.Save("s", t);
   } else {
     job.AddAction(mAction, mEvent, t, mWorkflow, "q");
-    retc = job.Save("q", t);
+    retc = gOFS->WFEd.Enqueue(job);
   }
 
   if (retc) {
@@ -62,6 +62,7 @@
 #include "mgm/WFE.hh"
 #include "mgm/Fsck.hh"
 #include "mgm/Master.hh"
+#include "mgm/FindWalker.hh"
 #include "namespace/interface/IFsView.hh"
 #include "XrdVersion.hh"
 #include "XrdOss/XrdOss.hh"
@@ -248,6 +249,7 @@ XrdMgmOfs::Disc(const XrdSecEntity* client)
 #include "XrdMgmOfs/Chksum.cc"
 #include "XrdMgmOfs/Chmod.cc"
 #include "XrdMgmOfs/Chown.cc"
+#include "XrdMgmOfs/Commit.cc"
 #include "XrdMgmOfs/DeleteExternal.cc"
 #include "XrdMgmOfs/Exists.cc"
 #include "XrdMgmOfs/Find.cc"
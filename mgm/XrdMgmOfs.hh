@@ -104,11 +104,14 @@
 #include "common/LinuxStat.hh"
 #include "common/FileId.hh"
 #include "common/FileSystem.hh"
+#include "common/ThreadPool.hh"
 #include "mq/XrdMqMessaging.hh"
 #include "mgm/proc/ProcCommand.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include <google/sparse_hash_map>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 
 USE_EOSMGMNAMESPACE
@@ -315,6 +318,63 @@ public:
             XrdOucErrInfo& out_error,
             const XrdSecEntity* client = 0);
 
+  //----------------------------------------------------------------------------
+  //! Replica commit sent by an FST when closing a file
+  //----------------------------------------------------------------------------
+  struct CommitRequest {
+    CommitRequest():
+      mSize(0), mFid(0), mFsid(0), mDropFsid(0), mMtime(0), mMtimeNs(0),
+      mVerifyChecksum(false), mCommitChecksum(false), mVerifySize(false),
+      mCommitSize(false), mReplication(false), mReconstruction(false),
+      mModified(false), mFusex(false), mHasChecksum(false), mOcChunk(false),
+      mOcN(0), mOcMax(0), mOcDone(false), mErrno(0) {}
+
+    eos::common::LogId mLogId; ///< log id of the FST transaction
+    std::string mPath; ///< path of the file
+    unsigned long long mSize; ///< size of the replica
+    unsigned long long mFid; ///< file id
+    unsigned long mFsid; ///< file system of the replica
+    unsigned long mDropFsid; ///< file system to drop e.g. after a drain
+    unsigned long mMtime; ///< modification time
+    unsigned long mMtimeNs; ///< modification time nanoseconds
+    bool mVerifyChecksum, mCommitChecksum, mVerifySize, mCommitSize;
+    bool mReplication, mReconstruction, mModified, mFusex;
+    bool mHasChecksum; ///< true if a checksum was sent
+    std::string mChecksum; ///< checksum in hex representation
+    bool mOcChunk; ///< true for a chunk of an OwnCloud chunked upload
+    int mOcN, mOcMax; ///< OwnCloud chunk number and number of chunks
+    std::string mOcUuid; ///< OwnCloud upload id
+    bool mOcDone; ///< true if this is the last OwnCloud chunk
+    std::shared_ptr<eos::IFileMD> mFmd; ///< committed file
+    std::string mFmdName; ///< name of the file before the commit
+    int mErrno; ///< error code, 0 if successful so far
+    std::string mErrOp; ///< failed operation in the Emsg format
+    std::string mErrTarget; ///< target of the failed operation
+  };
+
+  //----------------------------------------------------------------------------
+  //! Parse a replica commit
+  //!
+  //! @param env commit opaque information sent by the FST
+  //! @param tident trace identity of the FST
+  //! @param vid virtual identity of the FST
+  //! @param req filled with the commit, mErrno is set if incomplete
+  //----------------------------------------------------------------------------
+  void CommitParse(XrdOucEnv& env, const char* tident,
+                   eos::common::Mapping::VirtualIdentity& vid,
+                   CommitRequest& req);
+
+  //----------------------------------------------------------------------------
+  //! Apply a batch of replica commits. The file system states are checked and
+  //! the namespace is updated under a single lock for the whole batch, only
+  //! the renames of atomic uploads are done per file.
+  //!
+  //! @param reqs commits to apply, failed ones have mErrno set on return
+  //! @param vid virtual identity of the FST
+  //----------------------------------------------------------------------------
+  void Commit(std::vector<CommitRequest>& reqs,
+              eos::common::Mapping::VirtualIdentity& vid);
+
   // ---------------------------------------------------------------------------
   //! get stats function (fake ok)
   // ---------------------------------------------------------------------------
@@ -427,6 +487,9 @@ public:
   //!
   //! @note The millisleep variable allows to slow down full scans to decrease
   //! the impact when doing large scans.
+  //!
+  //! @note This collects the whole result in memory, large scans should use
+  //! the callback version below.
   // ---------------------------------------------------------------------------
   int _find(const char* path, XrdOucErrInfo& out_error, XrdOucString& stdErr,
             eos::common::Mapping::VirtualIdentity& vid,
@@ -435,6 +498,33 @@ public:
             time_t millisleep = 0, bool nscounter = true, int maxdepth = 0,
             const char* filematch = 0, bool take_lock = true);
 
+  //----------------------------------------------------------------------------
+  //! Callback receiving the results of a find: a directory path (with a
+  //! trailing '/') and the matching file names in it. Every directory is
+  //! passed at most once, the files can be moved out of the set. Returning
+  //! false stops the find.
+  //----------------------------------------------------------------------------
+  typedef std::function<bool(const std::string& dir,
+                             std::set<std::string>& files)> FindCallback;
+
+  //----------------------------------------------------------------------------
+  //! Low-level namespace find command streaming the results
+  //!
+  //! Same as above, but the results are passed directory by directory to the
+  //! callback while the sub-tree is listed. Sub-trees are listed in parallel
+  //! on a thread pool (unless take_lock is false or millisleep is set) and
+  //! depth first, so only the directories waiting to be listed and a bounded
+  //! number of listed ones are kept in memory. The namespace lock is held per
+  //! directory and never while the callback runs. The callback calls are
+  //! serialized and come in path order, but from different threads.
+  //----------------------------------------------------------------------------
+  int _find(const char* path, XrdOucErrInfo& out_error, XrdOucString& stdErr,
+            eos::common::Mapping::VirtualIdentity& vid,
+            const FindCallback& callback,
+            const char* key = 0, const char* val = 0, bool no_files = false,
+            time_t millisleep = 0, bool nscounter = true, int maxdepth = 0,
+            const char* filematch = 0, bool take_lock = true);
+
   // ---------------------------------------------------------------------------
   // delete dir
   // ---------------------------------------------------------------------------
@@ -579,6 +669,15 @@ public:
             bool follow = true,
             std::string* uri = 0);
 
+  // ---------------------------------------------------------------------------
+  // fill a stat buffer and the ETag from file/container meta data - the caller
+  // has to hold the namespace lock
+  // ---------------------------------------------------------------------------
+  void FileMdToStat(eos::IFileMD* fmd, struct stat* buf, std::string* etag);
+
+  void ContainerMdToStat(eos::IContainerMD* cmd, struct stat* buf,
+                         std::string* etag);
+
 
   // ---------------------------------------------------------------------------
   // stat file to retrieve mode
@@ -1466,6 +1565,8 @@ public:
   std::unique_ptr<Egroup> EgroupRefresh;
   //!  Recycle object running the recycle bin deletion thread
   std::unique_ptr<Recycle> Recycler;
+  //! Pool helping to list sub-trees in parallel for _find, created by Configure
+  std::unique_ptr<eos::common::ThreadPool> mFindThreads;
   bool UTF8; ///< true if running in less restrictive character set mode
 
   std::string mArchiveEndpoint; ///< archive ZMQ connection endpoint
@@ -1500,6 +1601,27 @@ private:
   //----------------------------------------------------------------------------
   void InitStats();
 
+  //----------------------------------------------------------------------------
+  //! Check that the file system of a commit still accepts replicas - the
+  //! FsView::gFsView.ViewMutex must be read locked
+  //----------------------------------------------------------------------------
+  void CommitCheckFs(CommitRequest& req,
+                     eos::common::Mapping::VirtualIdentity& vid);
+
+  //----------------------------------------------------------------------------
+  //! Update the file meta data of a commit - the eosViewRWMutex must be write
+  //! locked
+  //----------------------------------------------------------------------------
+  void CommitUpdate(CommitRequest& req,
+                    eos::common::Mapping::VirtualIdentity& vid);
+
+  //----------------------------------------------------------------------------
+  //! Rename the file of a committed atomic upload to its final name, takes
+  //! the namespace locks itself
+  //----------------------------------------------------------------------------
+  void CommitFinalize(CommitRequest& req,
+                      eos::common::Mapping::VirtualIdentity& vid);
+
   //----------------------------------------------------------------------------
   //! Static method to start a thread that will queue, build and submit backup
   //! operations to the archiver daemon.
@@ -98,6 +98,7 @@ XrdMgmOfs::_access(const char *path,
   std::shared_ptr<eos::IContainerMD> dh;
   std::shared_ptr<eos::IFileMD> fh;
   bool permok = false;
+  bool egroup_pending = false;
   uint16_t flags = 0;
   uid_t fuid = 99;
   gid_t fgid = 99;
@@ -151,6 +152,7 @@ XrdMgmOfs::_access(const char *path,
     eos_info("acl=%d r=%d w=%d wo=%d x=%d egroup=%d mutable=%d",
              acl.HasAcl(), acl.CanRead(), acl.CanWrite(), acl.CanWriteOnce(),
              acl.CanBrowse(), acl.HasEgroup(), acl.IsMutable());
+    egroup_pending = acl.EgroupPending();
 
     if (vid.uid && !acl.IsMutable() && (mode & W_OK)) {
       eos_debug("msg=\"access\" errno=EPERM reason=\"immutable\"");
@@ -254,7 +256,12 @@ XrdMgmOfs::_access(const char *path,
   if (dh && (!permok)) {
     if (lock)
       gOFS->eosViewRWMutex.UnLockRead();
-    
+
+    if (egroup_pending) {
+      // let the client retry once the e-group membership is known
+      return gOFS->Stall(error, 1, "e-group membership lookup pending");
+    }
+
     errno = EACCES;
     return Emsg(epname, error, EACCES, "access", path);
   }
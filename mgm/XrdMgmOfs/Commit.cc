@@ -0,0 +1,667 @@
+// ----------------------------------------------------------------------
+// File: Commit.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2011 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+// -----------------------------------------------------------------------
+// This file is included source code in XrdMgmOfs.cc to make the code more
+// transparent without slowing down the compilation time.
+// -----------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Parse a replica commit
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::CommitParse(XrdOucEnv& env, const char* tident,
+                       eos::common::Mapping::VirtualIdentity& vid,
+                       CommitRequest& req)
+{
+  eos::common::LogId& ThreadLogId = req.mLogId;
+  ThreadLogId.SetSingleShotLogId(tident);
+  char* asize = env.Get("mgm.size");
+  char* spath = env.Get("mgm.path");
+  char* afid = env.Get("mgm.fid");
+  char* afsid = env.Get("mgm.add.fsid");
+  char* amtime = env.Get("mgm.mtime");
+  char* amtimensec = env.Get("mgm.mtime_ns");
+  char* alogid = env.Get("mgm.logid");
+
+  if (alogid) {
+    ThreadLogId.SetLogId(alogid, tident);
+  }
+
+  XrdOucString averifychecksum = env.Get("mgm.verify.checksum");
+  XrdOucString acommitchecksum = env.Get("mgm.commit.checksum");
+  XrdOucString averifysize = env.Get("mgm.verify.size");
+  XrdOucString acommitsize = env.Get("mgm.commit.size");
+  XrdOucString adropfsid = env.Get("mgm.drop.fsid");
+  XrdOucString areplication = env.Get("mgm.replication");
+  XrdOucString areconstruction = env.Get("mgm.reconstruction");
+  XrdOucString aismodified = env.Get("mgm.modified");
+  XrdOucString afusex = env.Get("mgm.fusex");
+  req.mVerifyChecksum = (averifychecksum == "1");
+  req.mCommitChecksum = (acommitchecksum == "1");
+  req.mVerifySize = (averifysize == "1");
+  req.mCommitSize = (acommitsize == "1");
+  req.mReplication = (areplication == "1");
+  req.mReconstruction = (areconstruction == "1");
+  req.mModified = (aismodified == "1");
+  req.mFusex = (afusex == "1");
+  int envlen;
+  XrdOucString oc_uuid = "";
+  req.mOcChunk = eos::common::OwnCloud::GetChunkInfo(env.Env(envlen), req.mOcN,
+                 req.mOcMax, oc_uuid);
+  req.mOcUuid = oc_uuid.c_str();
+  char* checksum = env.Get("mgm.checksum");
+
+  if (adropfsid.length()) {
+    req.mDropFsid = strtoul(adropfsid.c_str(), 0, 10);
+  }
+
+  if (req.mReconstruction) {
+    // remove the checksum we don't care about it
+    checksum = 0;
+    req.mVerifySize = false;
+    req.mVerifyChecksum = false;
+    req.mCommitSize = false;
+    req.mCommitChecksum = false;
+    req.mReplication = false;
+  }
+
+  if (checksum) {
+    req.mHasChecksum = true;
+    req.mChecksum = checksum;
+  }
+
+  if (spath) {
+    req.mPath = spath;
+  }
+
+  if (asize && afid && spath && afsid && amtime && amtimensec) {
+    req.mSize = strtoull(asize, 0, 10);
+    req.mFid = strtoull(afid, 0, 16);
+    req.mFsid = strtoul(afsid, 0, 10);
+    req.mMtime = strtoul(amtime, 0, 10);
+    req.mMtimeNs = strtoul(amtimensec, 0, 10);
+  } else {
+    eos_thread_err("commit message does not contain all meta information: %s",
+                   env.Env(envlen));
+    gOFS->MgmStats.Add("CommitFailedParameters", 0, 0, 1);
+    req.mErrno = EINVAL;
+
+    if (spath) {
+      req.mErrOp = "commit filesize change - size,fid,fsid,mtime not complete";
+      req.mErrTarget = spath;
+    } else {
+      req.mErrOp = "commit filesize change - size,fid,fsid,mtime,path not complete";
+      req.mErrTarget = "unknown";
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply a batch of replica commits
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::Commit(std::vector<CommitRequest>& reqs,
+                  eos::common::Mapping::VirtualIdentity& vid)
+{
+  {
+    // Check that the file systems are still allowed to accept replica's
+    eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
+
+    for (auto& req : reqs) {
+      if (!req.mErrno) {
+        CommitCheckFs(req, vid);
+      }
+    }
+  }
+
+  {
+    // Keep the lock order View=>Namespace=>Quota
+    eos::common::RWMutexWriteLock nslock(gOFS->eosViewRWMutex);
+
+    for (auto& req : reqs) {
+      if (!req.mErrno) {
+        CommitUpdate(req, vid);
+      }
+    }
+  }
+
+  for (auto& req : reqs) {
+    if (!req.mErrno) {
+      CommitFinalize(req, vid);
+      gOFS->MgmStats.Add("Commit", 0, 0, 1);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check that the file system of a commit still accepts replicas
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::CommitCheckFs(CommitRequest& req,
+                         eos::common::Mapping::VirtualIdentity& vid)
+{
+  eos::common::LogId& ThreadLogId = req.mLogId;
+  const char* checksum = (req.mHasChecksum ? req.mChecksum.c_str() : 0);
+  eos::mgm::FileSystem* fs = 0;
+
+  if (FsView::gFsView.mIdView.count(req.mFsid)) {
+    fs = FsView::gFsView.mIdView[req.mFsid];
+  }
+
+  if ((!fs) || (fs->GetConfigStatus() < eos::common::FileSystem::kDrain)) {
+    eos_thread_err("msg=\"commit suppressed\" configstatus=%s subcmd=commit "
+                   "path=%s size=%llu fid=%08llx fsid=%lu dropfsid=%lu checksum=%s"
+                   " mtime=%lu mtime.nsec=%lu oc-chunk=%d oc-n=%d oc-max=%d "
+                   "oc-uuid=%s", (fs ? eos::common::FileSystem::GetConfigStatusAsString(
+                                    fs->GetConfigStatus()) :
+                                  "deleted"), req.mPath.c_str(), req.mSize, req.mFid,
+                   req.mFsid, req.mDropFsid, checksum, req.mMtime, req.mMtimeNs,
+                   req.mOcChunk, req.mOcN, req.mOcMax, req.mOcUuid.c_str());
+    req.mErrno = EIO;
+    req.mErrOp = "commit file metadata - filesystem is in non-operational state [EIO]";
+    return;
+  }
+
+  if (checksum) {
+    eos_thread_info("subcmd=commit path=%s size=%llu fid=%08llx fsid=%lu "
+                    "dropfsid=%lu checksum=%s mtime=%lu mtime.nsec=%lu oc-chunk=%d "
+                    "oc-n=%d oc-max=%d oc-uuid=%s", req.mPath.c_str(), req.mSize,
+                    req.mFid, req.mFsid, req.mDropFsid, checksum, req.mMtime,
+                    req.mMtimeNs, req.mOcChunk, req.mOcN, req.mOcMax,
+                    req.mOcUuid.c_str());
+  } else {
+    eos_thread_info("subcmd=commit path=%s size=%llu fid=%08llx fsid=%lu "
+                    "dropfsid=%lu mtime=%lu mtime.nsec=%lu oc-chunk=%d oc-n=%d "
+                    "oc-max=%d oc-uuid=%s", req.mPath.c_str(), req.mSize, req.mFid,
+                    req.mFsid, req.mDropFsid, req.mMtime, req.mMtimeNs,
+                    req.mOcChunk, req.mOcN, req.mOcMax, req.mOcUuid.c_str());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Update the file meta data of a commit
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::CommitUpdate(CommitRequest& req,
+                        eos::common::Mapping::VirtualIdentity& vid)
+{
+  eos::common::LogId& ThreadLogId = req.mLogId;
+  unsigned long long size = req.mSize;
+  unsigned long long fid = req.mFid;
+  unsigned long fsid = req.mFsid;
+  char binchecksum[SHA_DIGEST_LENGTH];
+  memset(binchecksum, 0, sizeof(binchecksum));
+
+  if (req.mHasChecksum) {
+    for (unsigned int i = 0; (i + 1 < req.mChecksum.length()) &&
+         (i / 2 < sizeof(binchecksum)); i += 2) {
+      // hex2binary conversion
+      char hex[3];
+      hex[0] = req.mChecksum[i];
+      hex[1] = req.mChecksum[i + 1];
+      hex[2] = 0;
+      binchecksum[i / 2] = strtol(hex, 0, 16);
+    }
+  }
+
+  eos::Buffer checksumbuffer;
+  checksumbuffer.putData(binchecksum, SHA_DIGEST_LENGTH);
+  // get the file meta data if exists
+  std::shared_ptr<eos::IFileMD> fmd;
+  std::shared_ptr<eos::IContainerMD> cmd;
+  eos::IContainerMD::id_t cid = 0;
+  XrdOucString emsg = "";
+  errno = 0;
+
+  try {
+    fmd = gOFS->eosFileService->getFileMD(fid);
+  } catch (eos::MDException& e) {
+    errno = e.getErrno();
+    eos_thread_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n", e.getErrno(),
+                     e.getMessage().str().c_str());
+    emsg = "retc=";
+    emsg += e.getErrno();
+    emsg += " msg=";
+    emsg += e.getMessage().str().c_str();
+  }
+
+  if (!fmd) {
+    // uups, no such file anymore
+    if (errno == ENOENT) {
+      req.mErrno = ENOENT;
+      req.mErrOp = "commit filesize change - file is already removed [EIDRM]";
+    } else {
+      emsg.insert("commit filesize change [EIO] ", 0);
+      req.mErrno = errno;
+      req.mErrOp = emsg.c_str();
+      req.mErrTarget = req.mPath;
+    }
+
+    return;
+  }
+
+  unsigned long lid = fmd->getLayoutId();
+
+  // check if fsid and fid are ok
+  if (fmd->getId() != fid) {
+    eos_thread_notice("commit for fid=%lu but fid=%lu", fmd->getId(), fid);
+    gOFS->MgmStats.Add("CommitFailedFid", 0, 0, 1);
+    req.mErrno = EINVAL;
+    req.mErrOp = "commit filesize change - file id is wrong [EINVAL]";
+    req.mErrTarget = req.mPath;
+    return;
+  }
+
+  // check if this file is already unlinked from the visible namespace
+  if (!(cid = fmd->getContainerId())) {
+    eos_thread_warning("commit for fid=%lu but file is disconnected from any container",
+                       fmd->getId());
+    gOFS->MgmStats.Add("CommitFailedUnlinked", 0, 0, 1);
+    req.mErrno = EIDRM;
+    req.mErrOp = "commit filesize change - file is already removed [EIDRM]";
+    return;
+  }
+
+  // check if this commit comes from a transfer and if the size/checksum is ok
+  if (req.mReplication) {
+    // we remote this file NOW from the scheduling maps
+    {
+      XrdSysMutexHelper sLock(ScheduledToDrainFidMutex);
+
+      if (ScheduledToDrainFid.count(fid)) {
+        ScheduledToDrainFid.erase(fid);
+      }
+    }
+    {
+      XrdSysMutexHelper sLock(ScheduledToBalanceFidMutex);
+
+      if (ScheduledToBalanceFid.count(fid)) {
+        ScheduledToBalanceFid.erase(fid);
+      }
+    }
+
+    if (eos::common::LayoutId::GetLayoutType(lid) ==
+        eos::common::LayoutId::kReplica) {
+      // we check filesize and the checksum only for replica layouts
+      eos_thread_debug("fmd size=%lli, size=%lli", fmd->getSize(), size);
+
+      if (fmd->getSize() != size) {
+        eos_thread_err("replication for fid=%lu resulted in a different file "
+                       "size on fsid=%llu - rejecting replica", fmd->getId(), fsid);
+        gOFS->MgmStats.Add("ReplicaFailedSize", 0, 0, 1);
+
+        // -----------------------------------------------------------
+        // if we come via FUSE, we have to remove this replica
+        // -----------------------------------------------------------
+        if (fmd->hasLocation((unsigned short) fsid)) {
+          fmd->unlinkLocation((unsigned short) fsid);
+          fmd->removeLocation((unsigned short) fsid);
+
+          try {
+            gOFS->eosView->updateFileStore(fmd.get());
+            // this call is not needed, since it is just a new replica location
+            // gOFS->FuseXCast(eos::common::FileId::FidToInode(fmd->getId()));
+          } catch (eos::MDException& e) {
+            errno = e.getErrno();
+            std::string errmsg = e.getMessage().str();
+            eos_thread_crit("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                            e.getErrno(), e.getMessage().str().c_str());
+          }
+        }
+
+        req.mErrno = EBADE;
+        req.mErrOp = "commit replica - file size is wrong [EBADE]";
+        return;
+      }
+
+      bool cxError = false;
+      size_t cxlen = eos::common::LayoutId::GetChecksumLen(fmd->getLayoutId());
+
+      for (size_t i = 0; i < cxlen; i++) {
+        if (fmd->getChecksum().getDataPadded(i) != checksumbuffer.getDataPadded(i)) {
+          cxError = true;
+        }
+      }
+
+      if (cxError) {
+        eos_thread_err("replication for fid=%lu resulted in a different checksum "
+                       "on fsid=%llu - rejecting replica", fmd->getId(), fsid);
+        gOFS->MgmStats.Add("ReplicaFailedChecksum", 0, 0, 1);
+
+        // -----------------------------------------------------------
+        // if we come via FUSE, we have to remove this replica
+        // -----------------------------------------------------------
+        if (fmd->hasLocation((unsigned short) fsid)) {
+          fmd->unlinkLocation((unsigned short) fsid);
+          fmd->removeLocation((unsigned short) fsid);
+
+          try {
+            gOFS->eosView->updateFileStore(fmd.get());
+            // this call is not be needed, since it is just a new replica location
+            //gOFS->FuseXCast(eos::common::FileId::FidToInode(fmd->getId()));
+          } catch (eos::MDException& e) {
+            errno = e.getErrno();
+            std::string errmsg = e.getMessage().str();
+            eos_thread_crit("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                            e.getErrno(), e.getMessage().str().c_str());
+          }
+        }
+
+        req.mErrno = EBADR;
+        req.mErrOp = "commit replica - file checksum is wrong [EBADR]";
+        return;
+      }
+    }
+  }
+
+  if (req.mVerifySize) {
+    // check if we saw a file size change or checksum change
+    if (fmd->getSize() != size) {
+      eos_thread_err("commit for fid=%lu gave a file size change after "
+                     "verification on fsid=%llu", fmd->getId(), fsid);
+    }
+  }
+
+  if (req.mHasChecksum) {
+    if (req.mVerifyChecksum) {
+      bool cxError = false;
+      size_t cxlen = eos::common::LayoutId::GetChecksumLen(fmd->getLayoutId());
+
+      for (size_t i = 0; i < cxlen; i++) {
+        if (fmd->getChecksum().getDataPadded(i) != checksumbuffer.getDataPadded(i)) {
+          cxError = true;
+        }
+      }
+
+      if (cxError) {
+        eos_thread_err("commit for fid=%lu gave a different checksum after "
+                       "verification on fsid=%llu", fmd->getId(), fsid);
+      }
+    }
+  }
+
+  // For changing the modification time we have to figure out if we
+  // just attach a new replica or if we have a change of the contents
+  bool isUpdate = false;
+  {
+    std::shared_ptr<eos::IContainerMD> dir;
+
+    try {
+      dir = gOFS->eosDirectoryService->getContainerMD(cid);
+    } catch (eos::MDException& e) {
+      eos_thread_err("parent_id=%llu not found", cid);
+      gOFS->MgmStats.Add("CommitFailedUnlinked", 0, 0, 1);
+      req.mErrno = EIDRM;
+      req.mErrOp = "commit file, parent contrainer removed [EIDRM]";
+      return;
+    }
+
+    eos::IQuotaNode* ns_quota = eosView->getQuotaNode(dir.get());
+
+    // Free previous quota
+    if (ns_quota) {
+      ns_quota->removeFile(fmd.get());
+    }
+
+    fmd->addLocation(fsid);
+
+    // If fsid is in the deletion list, we try to remove it if there
+    // is something in the deletion list
+    if (fmd->getNumUnlinkedLocation()) {
+      fmd->removeLocation(fsid);
+    }
+
+    if (req.mDropFsid) {
+      eos_thread_debug("commit: dropping replica on fs %lu", req.mDropFsid);
+      fmd->unlinkLocation((unsigned short) req.mDropFsid);
+    }
+
+    if (req.mCommitSize) {
+      req.mFmdName = fmd->getName();
+
+      if ((fmd->getSize() != size) || req.mModified) {
+        eos_thread_debug("size difference forces mtime %lld %lld or "
+                         "ismodified=%d", fmd->getSize(), size, req.mModified);
+        isUpdate = true;
+      }
+
+      fmd->setSize(size);
+    }
+
+    if (ns_quota) {
+      ns_quota->addFile(fmd.get());
+    }
+  }
+
+  if (req.mOcChunk && req.mCommitSize) {
+    // store the index in flags;
+    fmd->setFlags(req.mOcN + 1);
+    eos_thread_info("subcmd=commit max-chunks=%d commited-chunks=%d", req.mOcMax,
+                    fmd->getFlags());
+
+    // The last chunk terminates all
+    if (req.mOcMax == (req.mOcN + 1)) {
+      // we are done with chunked upload, remove the flags counter
+      fmd->setFlags((S_IRWXU | S_IRWXG | S_IRWXO));
+      req.mOcDone = true;
+    }
+  }
+
+  if (req.mCommitChecksum) {
+    if (!isUpdate) {
+      for (int i = 0; i < SHA_DIGEST_LENGTH; i++) {
+        if (fmd->getChecksum().getDataPadded(i) != checksumbuffer.getDataPadded(i)) {
+          eos_thread_debug("checksum difference forces mtime");
+          isUpdate = true;
+        }
+      }
+    }
+
+    fmd->setChecksum(checksumbuffer);
+  }
+
+  eos::IFileMD::ctime_t mt;
+  mt.tv_sec = req.mMtime;
+  mt.tv_nsec = req.mMtimeNs;
+
+  if (isUpdate && req.mMtime) {
+    // Update the modification time only if the file contents changed and
+    // mtime != 0 (FUSE clients will commit mtime=0 to indicated that they
+    // call utimes anyway
+    fmd->setMTime(mt);
+  }
+
+  eos_thread_debug("commit: setting size to %llu", fmd->getSize());
+
+  try {
+    gOFS->eosView->updateFileStore(fmd.get());
+    cmd = gOFS->eosDirectoryService->getContainerMD(cid);
+
+    if (isUpdate) {
+      // update parent mtime
+      cmd->setMTimeNow();
+      gOFS->eosView->updateContainerStore(cmd.get());
+
+      // Broadcast to the fusex network only if the change has been
+      // triggered outside the fusex client network e.g. xrdcp etc.
+      if (!req.mFusex) {
+        gOFS->FuseXCast(cmd->getId());
+      }
+
+      cmd->notifyMTimeChange(gOFS->eosDirectoryService);
+    }
+  } catch (eos::MDException& e) {
+    errno = e.getErrno();
+    std::string errmsg = e.getMessage().str();
+    eos_thread_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                     e.getErrno(), e.getMessage().str().c_str());
+    gOFS->MgmStats.Add("CommitFailedNamespace", 0, 0, 1);
+    req.mErrno = errno;
+    req.mErrOp = "commit filesize change";
+    req.mErrTarget = errmsg;
+    return;
+  }
+
+  req.mFmd = fmd;
+}
+
+//------------------------------------------------------------------------------
+// Rename the file of a committed atomic upload to its final name
+//------------------------------------------------------------------------------
+void
+XrdMgmOfs::CommitFinalize(CommitRequest& req,
+                          eos::common::Mapping::VirtualIdentity& vid)
+{
+  eos::common::LogId& ThreadLogId = req.mLogId;
+  std::shared_ptr<eos::IFileMD> fmd = req.mFmd;
+  XrdOucErrInfo error;
+  // check if this is an atomic path
+  eos::common::Path atomic_path(fmd->getName().c_str());
+  bool isVersioning = false;
+  atomic_path.DecodeAtomicPath(isVersioning);
+  std::string dname;
+  eos::common::Mapping::VirtualIdentity rootvid;
+  eos::common::Mapping::Root(rootvid);
+  // Path of a previous version existing before an atomic/versioning upload
+  std::string delete_path = "";
+  eos_thread_info("commitsize=%d n1=%s n2=%s occhunk=%d ocdone=%d",
+                  req.mCommitSize, req.mFmdName.c_str(), atomic_path.GetName(),
+                  req.mOcChunk, req.mOcDone);
+
+  if ((req.mCommitSize) && (req.mFmdName != atomic_path.GetName()) &&
+      (!req.mOcChunk || req.mOcDone)) {
+    eos_thread_info("commit: de-atomize file %s => %s", req.mFmdName.c_str(),
+                    atomic_path.GetName());
+    std::shared_ptr<eos::IContainerMD> dir;
+    std::shared_ptr<eos::IContainerMD> versiondir;
+    XrdOucString versionedname = "";
+    unsigned long long vfid = 0;
+    {
+      eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+      std::shared_ptr<eos::IFileMD> versionfmd;
+
+      try {
+        dname = gOFS->eosView->getUri(fmd.get());
+        eos::common::Path dPath(dname.c_str());
+        dname = dPath.GetParentPath();
+
+        if (isVersioning) {
+          versionfmd = gOFS->eosView->getFile(dname + atomic_path.GetPath());
+          vfid = versionfmd->getId();
+        }
+      } catch (eos::MDException& e) {
+        errno = e.getErrno();
+        eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                  e.getErrno(), e.getMessage().str().c_str());
+      }
+    }
+
+    // check if we want versioning
+    if (isVersioning) {
+      eos_static_info("checked  %s%s vfid=%llu", dname.c_str(), atomic_path.GetPath(),
+                      vfid);
+
+      // We purged the versions before during open, so we just simulate a new
+      // one and do the final rename in a transaction
+      if (vfid) {
+        gOFS->Version(vfid, error, rootvid, 0xffff, &versionedname, true);
+      }
+    }
+
+    eos::common::Path version_path(versionedname.c_str());
+    {
+      eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex);
+
+      // We have to de-atomize the fmd name here e.g. make the temporary
+      // atomic name a persistent name
+      try {
+        dir = eosView->getContainer(dname);
+        fmd = gOFS->eosFileService->getFileMD(req.mFid);
+
+        if (isVersioning) {
+          std::shared_ptr<eos::IFileMD> versionfmd;
+
+          try {
+            versiondir = eosView->getContainer(version_path.GetParentPath());
+            // rename the existing path to the version path
+            versionfmd = gOFS->eosView->getFile(dname + atomic_path.GetPath());
+            dir->removeFile(atomic_path.GetName());
+            versionfmd->setName(version_path.GetName());
+            versionfmd->setContainerId(versiondir->getId());
+            versiondir->addFile(versionfmd.get());
+            versiondir->setMTimeNow();
+            eosView->updateFileStore(versionfmd.get());
+            gOFS->FuseXCast(eos::common::FileId::FidToInode(versiondir->getId()));
+            // Update the ownership and mode of the new file to the original
+            // one
+            fmd->setCUid(versionfmd->getCUid());
+            fmd->setCGid(versionfmd->getCGid());
+            fmd->setFlags(versionfmd->getFlags());
+            eosView->updateFileStore(fmd.get());
+          } catch (eos::MDException& e) {
+            errno = e.getErrno();
+            eos_thread_err("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                           e.getErrno(), e.getMessage().str().c_str());
+          }
+        }
+
+        std::shared_ptr<eos::IFileMD> pfmd;
+
+        // Rename the temporary upload path to the final path
+        if ((pfmd = dir->findFile(atomic_path.GetName()))) {
+          eos_thread_info("msg=\"found final path\" %s", atomic_path.GetName());
+          // If the target exists we swap the two and then delete the
+          // previous one
+          delete_path = fmd->getName();
+          delete_path += ".delete";
+          eos_thread_info("msg=\"delete path\" %s", delete_path.c_str());
+          eosView->renameFile(pfmd.get(), delete_path);
+        } else {
+          eos_thread_info("msg=\"didn't find path\" %s", atomic_path.GetName());
+        }
+
+        eosView->renameFile(fmd.get(), atomic_path.GetName());
+        eos_thread_info("msg=\"de-atomize file\" fid=%llu atomic-name=%s "
+                        "final-name=%s", fmd->getId(), fmd->getName().c_str(),
+                        atomic_path.GetName());
+      } catch (eos::MDException& e) {
+        delete_path = "";
+        errno = e.getErrno();
+        std::string errmsg = e.getMessage().str();
+        eos_thread_err("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                       e.getErrno(), e.getMessage().str().c_str());
+      }
+    }
+  }
+
+  // If there was a previous target file we have to delete the renamed
+  // atomic left-over
+  if (delete_path.length()) {
+    delete_path.insert(0, dname.c_str());
+
+    if (gOFS->_rem(delete_path.c_str(), error, rootvid, "")) {
+      eos_thread_err("msg=\"failed to remove atomic left-over\" path=%s",
+                     delete_path.c_str());
+    }
+  }
+}
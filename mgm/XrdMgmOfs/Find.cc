@@ -27,7 +27,12 @@
 // -----------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
-// Low-level namespace find command
+// Number of pool threads helping the calling thread to list a sub-tree
+//------------------------------------------------------------------------------
+static const unsigned int sFindHelpers = 3;
+
+//------------------------------------------------------------------------------
+// Low-level namespace find command collecting the results in a map
 //------------------------------------------------------------------------------
 int
 XrdMgmOfs::_find(const char* path, XrdOucErrInfo& out_error,
@@ -37,10 +42,34 @@ XrdMgmOfs::_find(const char* path, XrdOucErrInfo& out_error,
                  time_t millisleep, bool nscounter, int maxdepth,
                  const char* filematch, bool take_lock)
 {
-  std::vector< std::vector<std::string> > found_dirs;
-  std::shared_ptr<eos::IContainerMD> cmd;
+  FindCallback collect = [&found](const std::string & dir,
+  std::set<std::string>& files) {
+    std::set<std::string>& entry = found[dir];
+
+    if (entry.empty()) {
+      entry.swap(files);
+    } else {
+      entry.insert(files.begin(), files.end());
+    }
+
+    return true;
+  };
+  return _find(path, out_error, stdErr, vid, collect, key, val, no_files,
+               millisleep, nscounter, maxdepth, filematch, take_lock);
+}
+
+//------------------------------------------------------------------------------
+// Low-level namespace find command
+//------------------------------------------------------------------------------
+int
+XrdMgmOfs::_find(const char* path, XrdOucErrInfo& out_error,
+                 XrdOucString& stdErr, eos::common::Mapping::VirtualIdentity& vid,
+                 const FindCallback& callback,
+                 const char* key, const char* val, bool no_files,
+                 time_t millisleep, bool nscounter, int maxdepth,
+                 const char* filematch, bool take_lock)
+{
   std::string Path = path;
-  XrdSysTimer snooze;
   EXEC_TIMING_BEGIN("Find");
 
   if (nscounter) {
@@ -52,77 +81,74 @@ XrdMgmOfs::_find(const char* path, XrdOucErrInfo& out_error,
   }
 
   errno = 0;
-  found_dirs.resize(1);
-  found_dirs[0].resize(1);
-  found_dirs[0][0] = Path.c_str();
-  int deepness = 0;
   // Users cannot return more than 100k files and 50k dirs with one find,
   // unless there is an access rule allowing deeper queries
   static uint64_t dir_limit = 50000;
   static uint64_t file_limit = 100000;
   Access::GetFindLimits(vid, dir_limit, file_limit);
-  uint64_t filesfound = 0;
-  uint64_t dirsfound = 0;
+  std::atomic<uint64_t> filesfound(0);
+  std::atomic<uint64_t> dirsfound(0);
   bool limitresult = false;
-  bool limited = false;
 
   if ((vid.uid != 0) && (!eos::common::Mapping::HasUid(3, vid.uid_list)) &&
       (!eos::common::Mapping::HasGid(4, vid.gid_list)) && (!vid.sudoer)) {
     limitresult = true;
   }
 
-  do {
-    bool permok = false;
-    found_dirs.resize(deepness + 2);
+  std::mutex err_mutex; // protects stdErr and limit_reported
+  bool limit_reported = false;
 
-    // Loop over all directories in that deepness
-    for (unsigned int i = 0; i < found_dirs[deepness].size(); i++) {
-      Path = found_dirs[deepness][i].c_str();
-      eos_static_debug("Listing files in directory %s", Path.c_str());
+  // List one directory, the namespace lock is only held while looking at
+  // the directory and never while calling the callback
+  auto list = [&](const FindWalker::Dir & dir,
+                  std::vector<FindWalker::Dir>& subdirs,
+  std::set<std::string>& files, bool & exists) {
+    XrdOucErrInfo error;
+    std::string err;
+    bool limited = false;
 
+    if (millisleep) {
       // Slow down the find command without holding locks
-      if (millisleep) {
-        snooze.Wait(millisleep);
-      }
-
-      // Held only for the current loop
-      eos::common::RWMutexReadLock ns_rd_lock;
+      XrdSysTimer snooze;
+      snooze.Wait(millisleep);
+    }
 
-      if (take_lock) {
-        ns_rd_lock.Grab(gOFS->eosViewRWMutex);
-      }
+    eos_static_debug("Listing files in directory %s", dir.mPath.c_str());
+    std::shared_ptr<eos::IContainerMD> cmd;
+    bool permok = false;
+    // Held only for the current directory
+    eos::common::RWMutexReadLock ns_rd_lock;
 
-      try {
-        cmd = gOFS->eosView->getContainer(Path.c_str(), false);
-        permok = cmd->access(vid.uid, vid.gid, R_OK | X_OK);
-      } catch (eos::MDException& e) {
-        errno = e.getErrno();
-        cmd.reset();
-        eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
-                  e.getErrno(), e.getMessage().str().c_str());
-      }
+    if (take_lock) {
+      ns_rd_lock.Grab(gOFS->eosViewRWMutex);
+    }
 
-      if (cmd) {
-        if (!permok) {
-          // check-out for ACLs
-          permok = _access(Path.c_str(), R_OK | X_OK, out_error, vid, "",
-                           false) ? false : true;
-        }
+    try {
+      cmd = gOFS->eosView->getContainer(dir.mPath.c_str(), false);
+      permok = cmd->access(vid.uid, vid.gid, R_OK | X_OK);
+    } catch (eos::MDException& e) {
+      cmd.reset();
+      eos_static_debug("msg=\"exception\" ec=%d emsg=\"%s\"\n",
+                       e.getErrno(), e.getMessage().str().c_str());
+    }
 
-        if (!permok) {
-          stdErr += "error: no permissions to read directory ";
-          stdErr += Path.c_str();
-          stdErr += "\n";
-          continue;
-        }
+    if (cmd) {
+      exists = true;
 
-        // Add all children into the 2D vectors
-        // @todo (esindril): User the itertor interface from the ns
-        auto it_begin = cmd->subcontainersBegin();
-        auto it_end = cmd->subcontainersEnd();
+      if (!permok) {
+        // check-out for ACLs
+        permok = _access(dir.mPath.c_str(), R_OK | X_OK, error, vid, "",
+                         false) ? false : true;
+      }
 
-        for (auto dit = it_begin; dit != it_end; ++dit) {
-          std::string fpath = Path.c_str();
+      if (!permok) {
+        err += "error: no permissions to read directory ";
+        err += dir.mPath;
+        err += "\n";
+      } else {
+        for (auto dit = cmd->subcontainersBegin();
+             dit != cmd->subcontainersEnd(); ++dit) {
+          std::string fpath = dir.mPath;
           fpath += dit->first;
           fpath += "/";
 
@@ -133,61 +159,52 @@ XrdMgmOfs::_find(const char* path, XrdOucErrInfo& out_error,
             if (wkey.find("*") != STR_NPOS) {
               // this is a search for 'beginswith' match
               eos::IContainerMD::XAttrMap attrmap;
+              bool matched = false;
 
-              if (!gOFS->_attr_ls(fpath.c_str(), out_error, vid,
+              if (!gOFS->_attr_ls(fpath.c_str(), error, vid,
                                   (const char*) 0, attrmap, false)) {
                 for (auto it = attrmap.begin(); it != attrmap.end(); it++) {
                   XrdOucString akey = it->first.c_str();
 
                   if (akey.matches(wkey.c_str())) {
-                    // Trick to add element
-                    (void)found[fpath].size();
+                    matched = true;
                   }
                 }
               }
 
-              found_dirs[deepness + 1].push_back(fpath.c_str());
+              subdirs.push_back(FindWalker::Dir{fpath, dir.mDepth + 1, matched});
             } else {
               // This is a search for a full match or a key search
-              std::string sval = val;
               XrdOucString attr = "";
 
-              if (!gOFS->_attr_get(fpath.c_str(), out_error, vid,
+              if (!gOFS->_attr_get(fpath.c_str(), error, vid,
                                    (const char*) 0, key, attr, false)) {
-                found_dirs[deepness + 1].push_back(fpath.c_str());
-
-                if ((val == std::string("*")) || (attr == val)) {
-                  (void)found[fpath].size();
-                }
+                subdirs.push_back(FindWalker::Dir{fpath, dir.mDepth + 1,
+                                          (val == std::string("*")) || (attr == val)});
               }
             }
           } else {
             if (limitresult) {
               // Apply  user limits for non root/admin/sudoers
-              if (dirsfound >= dir_limit) {
-                stdErr += "warning: find results are limited for you to ndirs=";
-                stdErr += (int) dir_limit;
-                stdErr += " -  result is truncated!\n";
+              if (dirsfound++ >= dir_limit) {
+                err += "warning: find results are limited for you to ndirs=";
+                err += std::to_string(dir_limit);
+                err += " -  result is truncated!\n";
                 limited = true;
                 break;
               }
             }
 
-            found_dirs[deepness + 1].push_back(fpath.c_str());
-            (void)found[fpath].size();
-            dirsfound++;
+            subdirs.push_back(FindWalker::Dir{fpath, dir.mDepth + 1, true});
           }
         }
 
-        if (!no_files) {
+        if (!no_files && !limited) {
           std::string link;
-          std::string fname;
           std::shared_ptr<eos::IFileMD> fmd;
-          auto it_begin = cmd->filesBegin();
-          auto it_end = cmd->filesEnd();
 
-          for (auto fit = it_begin; fit != it_end; ++fit) {
-            fname = fit->first;
+          for (auto fit = cmd->filesBegin(); fit != cmd->filesEnd(); ++fit) {
+            const std::string& fname = fit->first;
             fmd = cmd->findFile(fname);
 
             // Skip symbolic links
@@ -197,77 +214,76 @@ XrdMgmOfs::_find(const char* path, XrdOucErrInfo& out_error,
               link.clear();
             }
 
-            if (limitresult) {
-              // Apply user limits for non root/admin/sudoers
-              if (filesfound >= file_limit) {
-                stdErr += "warning: find results are limited for you to nfiles=";
-                stdErr += (int) file_limit;
-                stdErr += " -  result is truncated!\n";
-                limited = true;
-                break;
-              }
-            }
-
             if (!filematch) {
-              if (link.length()) {
-                std::string ip = fname;
-                ip += " -> ";
-                ip += link;
-                found[Path].insert(ip);
+              if (limitresult && (filesfound++ >= file_limit)) {
+                // Apply user limits for non root/admin/sudoers
+                limited = true;
+              } else if (link.length()) {
+                files.insert(fname + " -> " + link);
               } else {
-                found[Path].insert(fname);
+                files.insert(fname);
               }
-
-              filesfound++;
             } else {
               XrdOucString name = fname.c_str();
 
               if (name.matches(filematch)) {
-                found[Path].insert(fname);
-                filesfound++;
+                if (limitresult && (filesfound++ >= file_limit)) {
+                  limited = true;
+                } else {
+                  files.insert(fname);
+                }
               }
             }
+
+            if (limited) {
+              err += "warning: find results are limited for you to nfiles=";
+              err += std::to_string(file_limit);
+              err += " -  result is truncated!\n";
+              break;
+            }
           }
         }
       }
+    }
+
+    ns_rd_lock.Release();
+
+    if (err.length()) {
+      std::lock_guard<std::mutex> lock(err_mutex);
+
+      // Only the first thread reaching a limit reports it
+      if (!limited || !limit_reported) {
+        stdErr += err.c_str();
+      }
 
       if (limited) {
-        break;
+        limit_reported = true;
       }
     }
 
-    deepness++;
+    return !limited;
+  };
 
-    if (limited) {
-      break;
-    }
-  } while (found_dirs[deepness].size() && ((!maxdepth) || (deepness < maxdepth)));
+  // Sub-trees are listed in parallel unless the caller holds the namespace
+  // lock or asked for a slow scan, the results are handed out in path order
+  FindWalker walker(list, callback, maxdepth);
+  uint64_t emitted = walker.Walk(Path, (take_lock && !millisleep) ?
+                                 mFindThreads.get() : nullptr, sFindHelpers);
 
-  if (!no_files) {
+  if (!no_files && !emitted) {
     // If the result is empty, maybe this was a find by file
-    if (!found.size()) {
-      XrdSfsFileExistence file_exists;
-
-      if (((_exists(Path.c_str(), file_exists, out_error, vid,
-                    0, take_lock)) == SFS_OK) &&
-          (file_exists == XrdSfsFileExistIsFile)) {
-        eos::common::Path cPath(Path.c_str());
-        found[cPath.GetParentPath()].insert(cPath.GetName());
-      }
+    XrdSfsFileExistence file_exists;
+
+    if (((_exists(Path.c_str(), file_exists, out_error, vid,
+                  0, take_lock)) == SFS_OK) &&
+        (file_exists == XrdSfsFileExistIsFile)) {
+      eos::common::Path cPath(Path.c_str());
+      std::set<std::string> files;
+      files.insert(cPath.GetName());
+      callback(cPath.GetParentPath(), files);
     }
   }
 
-  // Include also the directory which was specified in the query if it is
-  // accessible and a directory since it can evt. be missing if it is empty
-  XrdSfsFileExistence dir_exists;
-
-  if (((_exists(found_dirs[0][0].c_str(), dir_exists, out_error, vid,
-                0, take_lock)) == SFS_OK)
-      && (dir_exists == XrdSfsFileExistIsDirectory)) {
-    eos::common::Path cPath(found_dirs[0][0].c_str());
-    (void) found[found_dirs[0][0].c_str()].size();
-  }
-
   if (nscounter) {
     EXEC_TIMING_END("Find");
   }
@@ -264,6 +264,11 @@ XrdMgmOfs::FSctl(const int cmd,
 #include "fsctl/Commit.cc"
     }
 
+    // Commit a batch of replicas
+    if (execmd == "commits") {
+#include "fsctl/Commits.cc"
+    }
+
     // Drop a replica
     if (execmd == "drop") {
 #include "fsctl/Drop.cc"
@@ -184,6 +184,11 @@ XrdMgmOfs::_mkdir(const char* path,
 
       // Admin can always create a directory
       if (stdpermcheck && (!dir->access(vid.uid, vid.gid, X_OK | W_OK))) {
+        if (acl.EgroupPending()) {
+          // let the client retry once the e-group membership is known
+          return gOFS->Stall(error, 1, "e-group membership lookup pending");
+        }
+
         errno = EPERM;
         return Emsg(epname, error, EPERM, "create parent directory",
                     cPath.GetParentPath());
@@ -319,6 +324,11 @@ XrdMgmOfs::_mkdir(const char* path,
       }
 
       if (stdpermcheck && (!dir->access(vid.uid, vid.gid, X_OK | W_OK))) {
+        if (acl.EgroupPending()) {
+          // let the client retry once the e-group membership is known
+          return gOFS->Stall(error, 1, "e-group membership lookup pending");
+        }
+
         errno = EPERM;
         return Emsg(epname, error, EPERM, "create parent directory",
                     cPath.GetParentPath());
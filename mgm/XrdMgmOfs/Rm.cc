@@ -183,8 +183,14 @@ XrdMgmOfs::_rem(const char* path,
 
     if (container) {
       if (stdpermcheck && (!container->access(vid.uid, vid.gid, W_OK | X_OK))) {
-        errno = EPERM;
         gOFS->eosViewRWMutex.UnLockWrite();
+
+        if (acl.EgroupPending()) {
+          // let the client retry once the e-group membership is known
+          return gOFS->Stall(error, 1, "e-group membership lookup pending");
+        }
+
+        errno = EPERM;
         std::ostringstream oss;
         oss << path << " by tident=" << vid.tident;
         return Emsg(epname, error, errno, "remove file", oss.str().c_str());
@@ -0,0 +1,120 @@
+// ----------------------------------------------------------------------
+// File: Commits.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2011 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+// -----------------------------------------------------------------------
+// This file is included source code in XrdMgmOfs.cc to make the code more
+// transparent without slowing down the compilation time.
+// -----------------------------------------------------------------------
+
+{
+  REQUIRE_SSS_OR_LOCAL_AUTH;
+  ACCESSMODE_W;
+  MAYSTALL;
+  MAYREDIRECT;
+
+  EXEC_TIMING_BEGIN("CommitBatch");
+  // Batch of commits coalesced by an FST, every commit is the base64 encoded
+  // opaque information of a single commit
+  char* acommits = env.Get("mgm.commits");
+  unsigned long ncommits = (acommits ? strtoul(acommits, 0, 10) : 0);
+
+  if (!ncommits || (ncommits > 1024))
+  {
+    int envlen;
+    eos_thread_err("commit batch message is not valid: %s", env.Env(envlen));
+    gOFS->MgmStats.Add("CommitFailedParameters", 0, 0, 1);
+    return Emsg(epname, error, EINVAL, "commit batch - number of commits invalid",
+                spath);
+  }
+
+  std::vector<CommitRequest> reqs(ncommits);
+
+  for (unsigned long i = 0; i < ncommits; ++i)
+  {
+    std::string key = "mgm.commit." + std::to_string(i);
+    char* acommit = env.Get(key.c_str());
+    std::string commit_opaque;
+
+    if (!acommit ||
+        !eos::common::SymKey::Base64Decode(acommit, commit_opaque)) {
+      eos_thread_err("commit batch entry %lu missing or not decodable", i);
+      gOFS->MgmStats.Add("CommitFailedParameters", 0, 0, 1);
+      reqs[i].mErrno = EINVAL;
+      reqs[i].mErrOp = "commit batch - entry not decodable";
+      reqs[i].mErrTarget = key;
+      continue;
+    }
+
+    XrdOucEnv commit_env(commit_opaque.c_str());
+    CommitParse(commit_env, tident, vid, reqs[i]);
+  }
+
+  Commit(reqs, vid);
+  // Reply the error of every failed commit as the errno of its tag e.g.
+  // EIDRM for [EIDRM] or EIO if not tagged together with the base64 encoded
+  // error message, the FST maps them like the reply of a single commit
+  std::string reply = "";
+
+  for (unsigned long i = 0; i < ncommits; ++i)
+  {
+    if (!reqs[i].mErrno) {
+      continue;
+    }
+
+    XrdOucErrInfo commit_error;
+    Emsg(epname, commit_error, reqs[i].mErrno, reqs[i].mErrOp.c_str(),
+         reqs[i].mErrTarget.c_str());
+    int ec = EIO;
+    static const std::pair<const char*, int> tags[] = {
+      {"[EIDRM]", EIDRM}, {"[EBADE]", EBADE}, {"[EBADR]", EBADR},
+      {"[EINVAL]", EINVAL}, {"[EADV]", EADV}
+    };
+
+    for (const auto& tag : tags) {
+      if (reqs[i].mErrOp.find(tag.first) != std::string::npos) {
+        ec = tag.second;
+        break;
+      }
+    }
+
+    reply += "&mgm.commit." + std::to_string(i) + "=" + std::to_string(ec);
+    std::string msg;
+
+    if (eos::common::SymKey::Base64Encode(commit_error.getErrText(),
+                                          strlen(commit_error.getErrText()), msg) &&
+        msg.length()) {
+      reply += "&mgm.commit." + std::to_string(i) + ".msg=" + msg;
+    }
+  }
+
+  gOFS->MgmStats.Add("CommitBatch", 0, 0, 1);
+  reply.insert(0, "OK");
+  // The reply can exceed the error message buffer for large batches,
+  // ownership of the copy is taken by xrd_buff and error then takes ownership
+  // of the xrd_buff object.
+  XrdOucBuffer* xrd_buff = new XrdOucBuffer(strdup(reply.c_str()),
+      reply.length() + 1);
+  error.setErrInfo(xrd_buff->BuffSize(), xrd_buff);
+  EXEC_TIMING_END("CommitBatch");
+  return SFS_DATA;
+}
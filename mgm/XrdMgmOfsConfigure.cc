@@ -49,6 +49,7 @@
 #include "mgm/Iostat.hh"
 #include "mgm/LRU.hh"
 #include "mgm/WFE.hh"
+#include "mgm/Converter.hh"
 #include "mgm/Master.hh"
 #include "mgm/Messaging.hh"
 #ifdef HAVE_QCLIENT
@@ -1190,6 +1191,20 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
     Eroute.Say("Config notice: archive directory is not defined - archiving is disabled");
   }
 
+  // Attach the persistent queues of the conversion and workflow jobs, they are
+  // shared with the other MGMs through QuarkDB if a cluster is configured
+  std::string queuedb = MgmMetaLogDir.c_str();
+
+  if (!Converter::OpenQueue(queuedb + "/conversion.queue", mQdbCluster)) {
+    Eroute.Say("Config warning: cannot attach the conversion queue - queued "
+               "conversions are kept in memory only");
+  }
+
+  if (!WFEd.OpenQueue(queuedb + "/workflow.queue", mQdbCluster)) {
+    Eroute.Say("Config warning: cannot attach the workflow queue - queued "
+               "workflows are kept in memory only");
+  }
+
   if (!ns_lib_path.empty()) {
     eos::common::PluginManager& pm = eos::common::PluginManager::GetInstance();
     pm.LoadByPath(ns_lib_path);
@@ -1994,6 +2009,11 @@ XrdMgmOfs::Configure(XrdSysError& Eroute)
     eos_warning("msg=\"cannot start recycle thread\"");
   }
 
+  // create the pool helping to list sub-trees in parallel for find
+  mFindThreads.reset(new eos::common::ThreadPool(
+                       std::max(std::thread::hardware_concurrency() / 8, 2u),
+                       std::max(std::thread::hardware_concurrency() / 2, 4u)));
+
   // add all stat entries with 0
   InitStats();
   // set IO accounting file
@@ -2090,6 +2110,7 @@ XrdMgmOfs::InitStats()
   MgmStats.Add("Chmod", 0, 0, 0);
   MgmStats.Add("Chown", 0, 0, 0);
   MgmStats.Add("Commit", 0, 0, 0);
+  MgmStats.Add("CommitBatch", 0, 0, 0);
   MgmStats.Add("CommitFailedFid", 0, 0, 0);
   MgmStats.Add("CommitFailedNamespace", 0, 0, 0);
   MgmStats.Add("CommitFailedParameters", 0, 0, 0);
@@ -163,6 +163,7 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
   gOFS->MgmStats.Add("OpenDir", vid.uid, vid.gid, 1);
   // Open the directory
   bool permok = false;
+  bool egroup_pending = false;
   // ---------------------------------------------------------------------------
   eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
 
@@ -190,27 +191,24 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
           permok = true;
         }
       }
+
+      egroup_pending = acl.EgroupPending();
     }
 
     if (permok) {
       // Add all the files and subdirectories
       gOFS->MgmStats.Add("OpenDir-Entry", vid.uid, vid.gid,
                          dh->getNumContainers() + dh->getNumFiles());
-      // Collect all file names
-      auto fit_begin = dh->filesBegin();
-      auto fit_end = dh->filesEnd();
-
-      for (auto it = fit_begin; it != fit_end; ++it) {
-        dh_list.insert(it->first);
-      }
+      // Collect all file and subcontainer names - big directories are listed
+      // page by page without loading all their children into memory
+      std::vector<std::string> names;
+      std::string cursor = "0";
 
-      // Collect all subcontainers
-      auto cit_begin = dh->subcontainersBegin();
-      auto cit_end = dh->subcontainersEnd();
-
-      for (auto it = cit_begin; it != cit_end; ++it) {
-        dh_list.insert(it->first);
-      }
+      do {
+        names.clear();
+        cursor = dh->scanChildNames(cursor, names);
+        dh_list.insert(names.begin(), names.end());
+      } while (cursor != "0");
 
       dh_list.insert(".");
 
@@ -241,6 +239,11 @@ XrdMgmOfsDirectory::_open(const char* dir_path,
                 "open directory", cPath.GetPath());
 
   if (!permok) {
+    if (egroup_pending) {
+      // let the client retry once the e-group membership is known
+      return gOFS->Stall(error, 1, "e-group membership lookup pending");
+    }
+
     errno = EPERM;
     return Emsg(epname, error, errno,
                 "open directory", cPath.GetPath());
@@ -672,6 +672,11 @@ XrdMgmOfsFile::open(const char* inpath,
     if ((!isSharedFile || isRW) && stdpermcheck
         && (!dmd->access(vid.uid, vid.gid, (isRW) ? W_OK | X_OK : R_OK | X_OK))) {
       if (!((vid.uid == DAEMONUID) && (isPioReconstruct))) {
+        if (acl.EgroupPending()) {
+          // let the client retry once the e-group membership is known
+          return gOFS->Stall(error, 1, "e-group membership lookup pending");
+        }
+
         // we don't apply this permission check for reconstruction jobs issued via the daemon account
         errno = EPERM;
         gOFS->MgmStats.Add("OpenFailedPermission", vid.uid, vid.gid, 1);
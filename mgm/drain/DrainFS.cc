@@ -31,6 +31,11 @@
 
 EOSMGMNAMESPACE_BEGIN
 
+//! Number of file ids enumerated in one go
+static const size_t sDrainBatch = 1000;
+//! Length of the window used to adapt the concurrency in seconds
+static const time_t sDrainWindow = 10;
+
 //------------------------------------------------------------------------------
 // Destructor
 //------------------------------------------------------------------------------
@@ -184,28 +189,23 @@ DrainFS::Drain()
     }
 
     long long totalfiles = 0;
-    eos::IFsView::FileList filelist;
-    // the function should list all the files available on the given FS and create a
-    // DrainTransferJob object which should be responsible of the copy via thirdparty
-    // and the removal of the original copy
+    // The files are enumerated in batches while draining, only the counter
+    // is needed up front
     XrdSysThread::SetCancelOff();
     {
-      eos::common::RWMutexReadLock vlock(FsView::gFsView.ViewMutex);
       eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
       totalfiles = gOFS->eosFsView->getNumFilesOnFs(mFsId);
+    }
 
-      if (totalfiles == 0) {
-        CompleteDrain();
-        return 0;
-      }
-
-      // Loop through all files and create draining jobs
-      for (auto it_fid = gOFS->eosFsView->getFileList(mFsId);
-           (it_fid && it_fid->valid()); it_fid->next()) {
-        mJobsPending.push_back(std::shared_ptr<DrainTransferJob>
-                               (new DrainTransferJob(it_fid->getElement(), mFsId, mTargetFsId)));
-      }
+    if (totalfiles == 0) {
+      CompleteDrain();
+      return 0;
     }
+
+    mFilesLeft = totalfiles;
+    // Files which failed in the previous attempt are enumerated again
+    mEnumerated = false;
+    mFailed.clear();
     // set the shared object counter
     {
       eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
@@ -242,46 +242,31 @@ DrainFS::Drain()
     eos_notice("Filesystem fsid=%u is under draining..", mFsId);
     bool firstRun = true;
 
+    time_t window_start = time(NULL);
+
     //start the loop to drain the files
     do {
       XrdSysThread::CancelPoint();
       bool stalled = ((time(NULL) - last_filesleft_change) > 600);
-      auto job = mJobsPending.begin();
-      eos::common::FileSystem::fsid_t fsIdTarget;
       last_filesleft = filesleft;
-
-      while ((mJobsRunning.size() <= maxParallelJobs) && (job != mJobsPending.end())) {
-        if (!(*job)->GetTargetFS()) {
-          if ((fsIdTarget = SelectTargetFS(&(*job->get()))) != 0) {
-            (*job)->SetTargetFS(fsIdTarget);
-          } else {
-            std::string error = "Failed to find a suitable Target filesystem for draining";
-            (*job)->ReportError(error);
-            mJobsFailed.push_back(*job);
-            job = mJobsPending.erase(job);
-            continue;
-          }
-        }
-        XrdSysTimer sleep;
-        sleep.Wait(200);
-        (*job)->SetStatus(DrainTransferJob::Ready);
-        (*job)->Start();
-        mJobsRunning.push_back(*job);
-        job = mJobsPending.erase(job);
+      CollectJobs();
+      PrepareJobs();
+      StartJobs();
+      time_t now = time(NULL);
+
+      if (now - window_start >= sDrainWindow) {
+        AdaptConcurrency(now - window_start);
+        window_start = now;
       }
 
-      for (auto it_jobs = mJobsRunning.begin() ; it_jobs !=  mJobsRunning.end();) {
-        if ((*it_jobs)->GetStatus() == DrainTransferJob::OK) {
-          it_jobs = mJobsRunning.erase(it_jobs);
-        } else if ((*it_jobs)->GetStatus() == DrainTransferJob::Failed) {
-          mJobsFailed.push_back(*it_jobs);
-          it_jobs = mJobsRunning.erase(it_jobs);
-        } else {
-          it_jobs++;
-        }
+      {
+        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+        filesleft = gOFS->eosFsView->getNumFilesOnFs(mFsId);
       }
 
-      filesleft = mJobsPending.size() + mJobsFailed.size();
+      mFilesLeft = filesleft;
+      mNumRunning = mJobsRunning.size();
+      mNumQueued = mPending.size() + mJobsReady.size();
 
       if (!last_filesleft) {
         last_filesleft = filesleft;
@@ -402,6 +387,178 @@ DrainFS::Drain()
   return 0;
 }
 
+//------------------------------------------------------------------------------
+// Enumerate the next batch of files not yet queued, running or failed
+//------------------------------------------------------------------------------
+size_t
+DrainFS::RefillPending()
+{
+  size_t added = 0;
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+  for (auto it_fid = gOFS->eosFsView->getFileList(mFsId);
+       (it_fid && it_fid->valid() && (added < sDrainBatch)); it_fid->next()) {
+    eos::common::FileId::fileid_t fid = it_fid->getElement();
+
+    if (!mFailed.count(fid) && mSeen.insert(fid).second) {
+      mPending.push_back(fid);
+      ++added;
+    }
+  }
+
+  if (!added) {
+    mEnumerated = true;
+  }
+
+  return added;
+}
+
+//------------------------------------------------------------------------------
+// Create jobs for the pending files and select their targets in one batch
+//------------------------------------------------------------------------------
+void
+DrainFS::PrepareJobs()
+{
+  if ((mPending.size() < sDrainBatch / 2) && !mEnumerated) {
+    RefillPending();
+  }
+
+  // Only keep enough jobs around to fill the transfer slots twice
+  size_t max_ready = 2 * maxParallelJobs;
+  std::vector<std::shared_ptr<DrainTransferJob>> jobs;
+
+  while (!mPending.empty() && (mJobsReady.size() + jobs.size() < max_ready)) {
+    jobs.push_back(std::make_shared<DrainTransferJob>(mPending.front(), mFsId,
+                   mTargetFsId));
+    mPending.pop_front();
+  }
+
+  if (jobs.empty()) {
+    return;
+  }
+
+  SelectTargetFS(jobs);
+  mJobsReady.insert(mJobsReady.end(), jobs.begin(), jobs.end());
+}
+
+//------------------------------------------------------------------------------
+// Submit ready jobs to the thread pool within the node limits
+//------------------------------------------------------------------------------
+void
+DrainFS::StartJobs()
+{
+  size_t nready = mJobsReady.size();
+
+  for (size_t i = 0; (i < nready) && (mJobsRunning.size() < maxParallelJobs);
+       ++i) {
+    std::shared_ptr<DrainTransferJob> job = mJobsReady.front();
+    mJobsReady.pop_front();
+    NodeStats& node = mNodeStats[mJobNode[job.get()]];
+
+    if (node.mRunning >= std::min(node.mLimit, maxParallelJobs)) {
+      // Node is at its limit, keep the job for later
+      node.mSaturated = true;
+      mJobsReady.push_back(job);
+      continue;
+    }
+
+    node.mRunning++;
+    job->SetStatus(DrainTransferJob::Ready);
+    mJobsRunning.push_back(job);
+    mThreadPool.PushTask<void>([job]() {
+      job->DoIt();
+    });
+  }
+}
+
+//------------------------------------------------------------------------------
+// Collect finished jobs and update the node statistics
+//------------------------------------------------------------------------------
+void
+DrainFS::CollectJobs()
+{
+  for (auto it_jobs = mJobsRunning.begin(); it_jobs != mJobsRunning.end();) {
+    DrainTransferJob::Status status = (*it_jobs)->GetStatus();
+
+    if ((status != DrainTransferJob::OK) && (status != DrainTransferJob::Failed)) {
+      ++it_jobs;
+      continue;
+    }
+
+    auto it_node = mJobNode.find(it_jobs->get());
+
+    if (it_node != mJobNode.end()) {
+      NodeStats& node = mNodeStats[it_node->second];
+
+      if (node.mRunning) {
+        node.mRunning--;
+      }
+
+      if (status == DrainTransferJob::OK) {
+        node.mOk++;
+        node.mBytes += (*it_jobs)->GetBytes();
+      } else {
+        node.mFailed++;
+      }
+
+      mJobNode.erase(it_node);
+    }
+
+    mSeen.erase((*it_jobs)->GetFileId());
+
+    if (status == DrainTransferJob::OK) {
+      mWindowFiles++;
+    } else {
+      mFailed.insert((*it_jobs)->GetFileId());
+      mJobsFailed.push_back(*it_jobs);
+    }
+
+    it_jobs = mJobsRunning.erase(it_jobs);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Adapt the node limits and the published rate at the end of a window
+//------------------------------------------------------------------------------
+void
+DrainFS::AdaptConcurrency(double window)
+{
+  uint64_t bytes = 0;
+
+  for (auto& elem : mNodeStats) {
+    NodeStats& node = elem.second;
+    uint64_t done = node.mOk + node.mFailed;
+    double rate = node.mBytes / window;
+    bytes += node.mBytes;
+
+    if (done) {
+      if (node.mFailed * 4 >= done) {
+        // Too many errors - back off multiplicatively
+        node.mLimit = std::max(1u, node.mLimit / 2);
+      } else if (node.mSaturated && (rate >= 0.9 * node.mLastRate)) {
+        // Throughput still scales with the concurrency - probe one more slot
+        node.mLimit = std::min(node.mLimit + 1, maxParallelJobs);
+      } else if ((rate < 0.5 * node.mLastRate) && (node.mLimit > 1)) {
+        node.mLimit--;
+      }
+
+      node.mLastRate = rate;
+    }
+
+    eos_debug("node=%s limit=%u running=%u ok=%llu failed=%llu rate=%.02f",
+              elem.first.c_str(), node.mLimit, node.mRunning, node.mOk,
+              node.mFailed, rate);
+    node.mOk = node.mFailed = node.mBytes = 0;
+    node.mSaturated = false;
+  }
+
+  mRate = bytes / window;
+  double file_rate = mWindowFiles / window;
+  mFileRate = (mFileRate ? (0.7 * mFileRate + 0.3 * file_rate) : file_rate);
+  mWindowFiles = 0;
+  mEta = ((mFileRate > 0) ? (uint64_t)(mFilesLeft / mFileRate) : 0);
+}
+
 //----------------------------------------------------------------------------
 // Clean up when draining is completed
 //----------------------------------------------------------------------------
@@ -471,88 +628,93 @@ DrainFS::DrainStop()
 }
 
 //------------------------------------------------------------------------------
-// Select target file system using the GeoTreeEngine
+// Select target file systems using the GeoTreeEngine for a batch of jobs
 //------------------------------------------------------------------------------
-eos::common::FileSystem::fsid_t
-DrainFS::SelectTargetFS(DrainTransferJob* job)
-
+void
+DrainFS::SelectTargetFS(std::vector<std::shared_ptr<DrainTransferJob>>& jobs)
 {
-  eos::common::RWMutexReadLock(FsView::gFsView.ViewMutex);
-  eos::common::RWMutexReadLock nsLock(gOFS->eosViewRWMutex);
-  std::vector<FileSystem::fsid_t>* newReplicas = new
-  std::vector<FileSystem::fsid_t>();
-  std::vector<FileSystem::fsid_t> existingReplicas;
-  eos::common::FileSystem::fs_snapshot source_snapshot;
-  eos::common::FileSystem* source_fs = 0;
-  std::shared_ptr<eos::IFileMD> fmd =  gOFS->eosFileService->getFileMD(
-                                         job->GetFileId());
-  unsigned int nfilesystems = 1;
-  unsigned int ncollocatedfs = 0;
-  source_fs = FsView::gFsView.mIdView[job->GetSourceFS()];
-  source_fs->SnapShotFileSystem(source_snapshot);
-  FsGroup* group = FsView::gFsView.mGroupView[source_snapshot.mGroup];
-  //check other replicas for the file
-  std::vector<std::string> fsidsgeotags;
-  existingReplicas = static_cast<std::vector<FileSystem::fsid_t>>
-                     (fmd->getLocations());
-
-  if (!gGeoTreeEngine.getInfosFromFsIds(existingReplicas,
-                                        &fsidsgeotags,
-                                        0, 0)) {
-    eos_notice("could not retrieve info for all avoid fsids");
-    delete newReplicas;
-    return 0;
+  eos::common::RWMutexReadLock fs_lock(FsView::gFsView.ViewMutex);
+  eos::common::RWMutexReadLock ns_lock(gOFS->eosViewRWMutex);
+  std::vector<std::shared_ptr<DrainTransferJob>> selected;
+  FsGroup* group = 0;
+  auto it_src = FsView::gFsView.mIdView.find(mFsId);
+
+  if ((it_src != FsView::gFsView.mIdView.end()) && it_src->second) {
+    eos::common::FileSystem::fs_snapshot source_snapshot;
+    it_src->second->SnapShotFileSystem(source_snapshot);
+    auto it_group = FsView::gFsView.mGroupView.find(source_snapshot.mGroup);
+
+    if (it_group != FsView::gFsView.mGroupView.end()) {
+      group = it_group->second;
+    }
   }
 
-  auto repl = existingReplicas.begin();
+  for (auto& job : jobs) {
+    eos::common::FileSystem::fsid_t target = job->GetTargetFS();
 
-  while (repl != existingReplicas.end()) {
-    eos_static_debug("existing replicas: %d", *repl);
-    repl++;
-  }
+    if (!target && group) {
+      std::shared_ptr<eos::IFileMD> fmd;
 
-  auto geo = fsidsgeotags.begin();
+      try {
+        fmd = gOFS->eosFileService->getFileMD(job->GetFileId());
+      } catch (eos::MDException& e) {
+        // File was deleted in the meantime, nothing to drain
+        mSeen.erase(job->GetFileId());
+        continue;
+      }
 
-  while (geo != fsidsgeotags.end()) {
-    eos_static_debug("geotags: %s", (*geo).c_str());
-    geo++;
-  }
+      unsigned int ncollocatedfs = 0;
+      std::vector<FileSystem::fsid_t> newReplicas;
+      std::vector<FileSystem::fsid_t> existingReplicas =
+        static_cast<std::vector<FileSystem::fsid_t>>(fmd->getLocations());
+      //check other replicas for the file
+      std::vector<std::string> fsidsgeotags;
+
+      if (!gGeoTreeEngine.getInfosFromFsIds(existingReplicas, &fsidsgeotags,
+                                            0, 0)) {
+        eos_notice("could not retrieve info for all avoid fsids");
+      } else if (gGeoTreeEngine.placeNewReplicasOneGroup(
+                   group, 1,
+                   &newReplicas,
+                   (ino64_t) fmd->getId(),
+                   NULL, //entrypoints
+                   NULL, //firewall
+                   GeoTreeEngine::draining,
+                   &existingReplicas,
+                   &fsidsgeotags,
+                   fmd->getSize(),
+                   "",//start from geotag
+                   "",//client geo tag
+                   ncollocatedfs,
+                   NULL, //excludeFS
+                   &fsidsgeotags, //excludeGeoTags
+                   NULL) && !newReplicas.empty()) {
+        //return only one FS now
+        target = newReplicas.front();
+        eos_static_debug("GeoTree Draining Placement fxid=%08llx -> fsid=%u",
+                         job->GetFileId(), target);
+      } else {
+        eos_notice("could not place the replica");
+      }
+    }
 
-  bool res = gGeoTreeEngine.placeNewReplicasOneGroup(
-               group, nfilesystems,
-               newReplicas,
-               (ino64_t) fmd->getId(),
-               NULL, //entrypoints
-               NULL, //firewall
-               GeoTreeEngine::draining,
-               &existingReplicas,
-               &fsidsgeotags,
-               fmd->getSize(),
-               "",//start from geotag
-               "",//client geo tag
-               ncollocatedfs,
-               NULL, //excludeFS
-               &fsidsgeotags, //excludeGeoTags
-               NULL);
-
-  if (res) {
-    std::ostringstream oss;
-
-    for (auto it = newReplicas->begin(); it != newReplicas->end(); ++it) {
-      oss << " " << (unsigned long)(*it);
+    if (!target) {
+      job->ReportError("Failed to find a suitable Target filesystem for draining");
+      mSeen.erase(job->GetFileId());
+      mFailed.insert(job->GetFileId());
+      mJobsFailed.push_back(job);
+      continue;
     }
 
-    eos_static_debug("GeoTree Draining Placement returned %d with fs id's -> %s",
-                     (int)res, oss.str().c_str());
-    //return only one FS now
-    eos::common::FileSystem::fsid_t targetFS = *newReplicas->begin();
-    delete newReplicas;
-    return targetFS;
-  } else {
-    eos_notice("could not place the replica");
-    delete newReplicas;
-    return 0;
+    job->SetTargetFS(target);
+    auto it_trg = FsView::gFsView.mIdView.find(target);
+    mJobNode[job.get()] = (((it_trg != FsView::gFsView.mIdView.end()) &&
+                            it_trg->second) ?
+                           it_trg->second->GetString("hostport") : "unknown");
+    selected.push_back(job);
   }
+
+  jobs.swap(selected);
 }
 
 EOSMGMNAMESPACE_END
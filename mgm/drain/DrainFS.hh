@@ -26,6 +26,11 @@
 #include "mgm/Namespace.hh"
 #include "mgm/FileSystem.hh"
 #include "common/Logging.hh"
+#include "common/ThreadPool.hh"
+#include <atomic>
+#include <deque>
+#include <map>
+#include <unordered_set>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -34,6 +39,12 @@ class DrainTransferJob;
 
 //------------------------------------------------------------------------------
 //! @brief Class implementing the draining of a filesystem
+//!
+//! The files of the file system are enumerated lazily in batches, the targets
+//! of a batch are selected under a single namespace lock and the transfers
+//! run in a thread pool shared by all draining file systems. The number of
+//! transfers in flight towards each target node is adapted to the throughput
+//! and error rate observed for that node, bounded by drainer.fs.ntx.
 //------------------------------------------------------------------------------
 class DrainFS: public eos::common::LogId
 {
@@ -48,11 +59,14 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor
   //!
+  //! @param thread_pool pool of the drainer running the transfers
   //! @param fs_id filesystem id
   //----------------------------------------------------------------------------
-  DrainFS(eos::common::FileSystem::fsid_t fs_id, 
-            eos::common::FileSystem::fsid_t target_fs_id = 0):
-    mThread(0), mFsId(fs_id), mTargetFsId(target_fs_id), mDrainStatus(eos::common::FileSystem::kNoDrain)
+  DrainFS(eos::common::ThreadPool& thread_pool,
+          eos::common::FileSystem::fsid_t fs_id,
+          eos::common::FileSystem::fsid_t target_fs_id = 0):
+    mThread(0), mFsId(fs_id), mTargetFsId(target_fs_id), mDrainStatus(eos::common::FileSystem::kNoDrain),
+    mThreadPool(thread_pool)
   {}
 
   //----------------------------------------------------------------------------
@@ -87,7 +101,87 @@ public:
   {
     return mFsId;
   }
+
+  //---------------------------------------------------------------------------
+  //! Get number of files left to drain
+  //---------------------------------------------------------------------------
+  inline uint64_t GetFilesLeft() const
+  {
+    return mFilesLeft;
+  }
+
+  //---------------------------------------------------------------------------
+  //! Get number of transfers in flight
+  //---------------------------------------------------------------------------
+  inline uint64_t GetRunning() const
+  {
+    return mNumRunning;
+  }
+
+  //---------------------------------------------------------------------------
+  //! Get number of files enumerated and waiting for a transfer slot
+  //---------------------------------------------------------------------------
+  inline uint64_t GetQueueDepth() const
+  {
+    return mNumQueued;
+  }
+
+  //---------------------------------------------------------------------------
+  //! Get drain rate in bytes per second
+  //---------------------------------------------------------------------------
+  inline uint64_t GetRate() const
+  {
+    return mRate;
+  }
+
+  //---------------------------------------------------------------------------
+  //! Get estimated time to completion in seconds, 0 if unknown
+  //---------------------------------------------------------------------------
+  inline uint64_t GetEta() const
+  {
+    return mEta;
+  }
+
 private:
+  //! Transfer statistics and adaptive concurrency of one target node
+  struct NodeStats {
+    unsigned int mRunning = 0; ///< Transfers in flight towards the node
+    unsigned int mLimit = 2; ///< Current limit of transfers in flight
+    bool mSaturated = false; ///< Limit was reached during the window
+    uint64_t mOk = 0; ///< Successful transfers in the window
+    uint64_t mFailed = 0; ///< Failed transfers in the window
+    uint64_t mBytes = 0; ///< Bytes transferred in the window
+    double mLastRate = 0; ///< Throughput of the previous window
+  };
+
+  //----------------------------------------------------------------------------
+  //! Enumerate the next batch of files not yet queued, running or failed
+  //!
+  //! @return number of files added to the pending queue
+  //----------------------------------------------------------------------------
+  size_t RefillPending();
+
+  //----------------------------------------------------------------------------
+  //! Create jobs for the pending files and select their targets in one batch
+  //----------------------------------------------------------------------------
+  void PrepareJobs();
+
+  //----------------------------------------------------------------------------
+  //! Submit ready jobs to the thread pool within the node limits
+  //----------------------------------------------------------------------------
+  void StartJobs();
+
+  //----------------------------------------------------------------------------
+  //! Collect finished jobs and update the node statistics
+  //----------------------------------------------------------------------------
+  void CollectJobs();
+
+  //----------------------------------------------------------------------------
+  //! Adapt the node limits and the published rate at the end of a window
+  //!
+  //! @param window length of the window in seconds
+  //----------------------------------------------------------------------------
+  void AdaptConcurrency(double window);
 
   //----------------------------------------------------------------------------
   // Thread loop implementing the drain job
@@ -95,13 +189,12 @@ private:
   void* Drain();
 
   //----------------------------------------------------------------------------
-  //! Select target file system using the GeoTreeEngine
-  //!
-  //! @param job drain job object
+  //! Select target file systems using the GeoTreeEngine for a batch of jobs,
+  //! jobs without a suitable target are moved to the failed list
   //!
-  ///! @return if successful then target file system, othewise 0
+  //! @param jobs drain jobs without a target
   //----------------------------------------------------------------------------
-  eos::common::FileSystem::fsid_t SelectTargetFS(DrainTransferJob* job);
+  void SelectTargetFS(std::vector<std::shared_ptr<DrainTransferJob>>& jobs);
 
   //----------------------------------------------------------------------------
   //! Set initial drain counters and status
@@ -123,17 +216,36 @@ private:
   eos::common::FileSystem::fsid_t mTargetFsId;  ///< Id of the target fs for draining
   // @todo (amanzi): try using std::thread just like in drain job
   eos::common::FileSystem::eDrainStatus mDrainStatus;
+  eos::common::ThreadPool& mThreadPool; ///< Pool running the transfers
   std::string mSpace; ///< Space where fs resides
   std::string mGroup; ///< Group where fs resided
-  //! Collection of drain jobs to run
-  std::vector<shared_ptr<DrainTransferJob>> mJobsPending;
+  //! File ids enumerated but without a job yet
+  std::deque<eos::common::FileId::fileid_t> mPending;
+  //! File ids which are pending, ready or running
+  std::unordered_set<eos::common::FileId::fileid_t> mSeen;
+  //! File ids which failed in the current drain attempt
+  std::unordered_set<eos::common::FileId::fileid_t> mFailed;
+  //! Jobs with a target waiting for a transfer slot
+  std::deque<shared_ptr<DrainTransferJob>> mJobsReady;
   //! Collection of failed drain jobs
   std::vector<shared_ptr<DrainTransferJob>> mJobsFailed;
   //! Collection of running drain jobs
   std::vector<shared_ptr<DrainTransferJob>> mJobsRunning;
+  //! Target node of the running jobs
+  std::map<DrainTransferJob*, std::string> mJobNode;
+  //! Statistics per target node
+  std::map<std::string, NodeStats> mNodeStats;
+  bool mEnumerated = false; ///< A refill found no new file
   bool mDrainStop = false; ///< Flag to cancel an ongoing draining
   int mMaxRetries = 1; ///< Max number of retries
   unsigned int maxParallelJobs = 10; ///< Max number of parallel drain jobs
+  uint64_t mWindowFiles = 0; ///< Files drained in the current window
+  double mFileRate = 0; ///< Smoothed files per second
+  std::atomic<uint64_t> mFilesLeft {0}; ///< Files left on the file system
+  std::atomic<uint64_t> mNumRunning {0}; ///< Transfers in flight
+  std::atomic<uint64_t> mNumQueued {0}; ///< Pending and ready files
+  std::atomic<uint64_t> mRate {0}; ///< Bytes per second of the last window
+  std::atomic<uint64_t> mEta {0}; ///< Estimated seconds to completion
 };
 
 EOSMGMNAMESPACE_END
@@ -98,6 +98,7 @@ DrainTransferJob::DoIt()
       owner_uid = fmd->getCUid();
       owner_gid = fmd->getCGid();
       size = fmd->getSize();
+      mBytes = size;
       source_path = gOFS->eosView->getUri(fmd.get());
       eos::common::Path cPath(source_path.c_str());
       cmd = gOFS->eosView->getContainer(cPath.GetParentPath());
@@ -142,6 +143,7 @@ DrainTransferJob::DoIt()
   if ((LayoutId::GetLayoutType(lid) == LayoutId::kRaidDP) ||
        (LayoutId::GetLayoutType(lid) == LayoutId::kRaid6)) {
     // @todo (amanzi): to be implemented - run TPC with reconstruction
+    ReportError("Draining of RAIN layouts is not supported");
   } else {
     // Prepare the TPC copy job
     XrdCl::PropertyList properties;
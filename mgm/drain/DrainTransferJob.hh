@@ -26,6 +26,7 @@
 #include "common/FileId.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
+#include <atomic>
 #include <thread>
 
 EOSMGMNAMESPACE_BEGIN
@@ -51,7 +52,7 @@ public:
                    eos::common::FileSystem::fsid_t fsIdS,
                    eos::common::FileSystem::fsid_t fsIdT = 0):
     mFileId(fileId), mFsIdSource(fsIdS), mFsIdTarget(fsIdT), mThread(),
-    mStatus(OK) {}
+    mStatus(OK), mBytes(0) {}
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -63,6 +64,11 @@ public:
   //----------------------------------------------------------------------------
   void Start();
 
+  //----------------------------------------------------------------------------
+  //! Do the transfer in the calling thread e.g. a thread pool worker
+  //----------------------------------------------------------------------------
+  void DoIt();
+
   //----------------------------------------------------------------------------
   //! Log error message and save it
   //!
@@ -105,18 +111,23 @@ public:
     return mErrorString;
   }
 
-private:
   //----------------------------------------------------------------------------
-  //! Method executed by the drainer thread where all the work is done
+  //! Get the size of the transferred file
   //----------------------------------------------------------------------------
-  void DoIt();
+  inline uint64_t GetBytes() const
+  {
+    return mBytes;
+  }
+
+private:
 
   eos::common::FileId::fileid_t mFileId; ///< File id to transfer
   ///! Source and destination file system
   eos::common::FileSystem::fsid_t mFsIdSource, mFsIdTarget;
   std::thread mThread; ///< Thread doing the draining
   std::string mErrorString; ///< Error message
-  Status mStatus; ///< Status of the drain job
+  std::atomic<Status> mStatus; ///< Status of the drain job
+  std::atomic<uint64_t> mBytes; ///< Size of the file
 };
 
 EOSMGMNAMESPACE_END
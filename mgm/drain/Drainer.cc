@@ -32,7 +32,8 @@ EOSMGMNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-Drainer::Drainer()
+Drainer::Drainer():
+  mThreadPool(std::max(std::thread::hardware_concurrency(), 16u), 256)
 {
   XrdSysThread::Run(&mThread, Drainer::StaticDrainer,
                     static_cast<void*>(this), XRDSYSTHREAD_HOLD,
@@ -137,7 +138,8 @@ Drainer::StartFSDrain(unsigned int sourceFsId, unsigned int targetFsId, XrdOucSt
   }
 
   //start the drain
-  shared_ptr<DrainFS> fs = shared_ptr<DrainFS>(new DrainFS(sourceFsId, targetFsId));
+  shared_ptr<DrainFS> fs = shared_ptr<DrainFS>(new DrainFS(mThreadPool, sourceFsId,
+                                  targetFsId));
 
   if (it_drainfs != mDrainFS.end()) {
     it_drainfs->second.insert(fs);
@@ -288,6 +290,11 @@ Drainer::GetDrainStatus(unsigned int fsId, XrdOucString& out, XrdOucString& err)
     table_header.push_back(std::make_tuple("node", 30, "s"));
     table_header.push_back(std::make_tuple("fs id", 10, "s"));
     table_header.push_back(std::make_tuple("drain status", 30, "s"));
+    table_header.push_back(std::make_tuple("files left", 10, "+l"));
+    table_header.push_back(std::make_tuple("running", 8, "+l"));
+    table_header.push_back(std::make_tuple("queued", 8, "+l"));
+    table_header.push_back(std::make_tuple("rate", 10, "s"));
+    table_header.push_back(std::make_tuple("eta", 10, "s"));
     table.SetHeader(table_header);
     out =  table.GenerateTable(HEADER, selections).c_str();
   } else {
@@ -326,6 +333,11 @@ Drainer::GetDrainStatus(unsigned int fsId, XrdOucString& out, XrdOucString& err)
     table_header.push_back(std::make_tuple("node", 30, "s"));
     table_header.push_back(std::make_tuple("fs id", 10, "s"));
     table_header.push_back(std::make_tuple("drain status", 30, "s"));
+    table_header.push_back(std::make_tuple("files left", 10, "+l"));
+    table_header.push_back(std::make_tuple("running", 8, "+l"));
+    table_header.push_back(std::make_tuple("queued", 8, "+l"));
+    table_header.push_back(std::make_tuple("rate", 10, "s"));
+    table_header.push_back(std::make_tuple("eta", 10, "s"));
     PrintTable(table, drain_snapshot.mHostPort, (*it).get());
     table.SetHeader(table_header);
     out += table.GenerateTable(HEADER, selections).c_str();
@@ -367,6 +379,18 @@ Drainer::PrintTable(TableFormatterBase& table, std::string node,
   table_data.back().push_back(TableCell(fs->GetFsId(), "s"));
   table_data.back().push_back(TableCell(FileSystem::GetDrainStatusAsString(
                                           fs->GetDrainStatus()), "s"));
+  table_data.back().push_back(TableCell((unsigned long long)
+                                        fs->GetFilesLeft(), "+l"));
+  table_data.back().push_back(TableCell((unsigned long long)
+                                        fs->GetRunning(), "+l"));
+  table_data.back().push_back(TableCell((unsigned long long)
+                                        fs->GetQueueDepth(), "+l"));
+  XrdOucString rate;
+  eos::common::StringConversion::GetReadableSizeString(rate, fs->GetRate(),
+      "B/s");
+  table_data.back().push_back(TableCell(rate.c_str(), "s"));
+  std::string eta = (fs->GetEta() ? std::to_string(fs->GetEta()) + "s" : "-");
+  table_data.back().push_back(TableCell(eta, "s"));
   table.AddRows(table_data);
 }
 
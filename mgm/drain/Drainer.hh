@@ -25,6 +25,7 @@
 #include "mgm/Namespace.hh"
 #include "common/Logging.hh"
 #include "common/FileSystem.hh"
+#include "common/ThreadPool.hh"
 #include "mgm/TableFormatter/TableFormatterBase.hh"
 
 EOSMGMNAMESPACE_BEGIN
@@ -112,6 +113,8 @@ private:
   pthread_t mThread;
   //contains per space the max allowed fs draining per node
   std::map<std::string, int> maxFSperNodeConfMap;
+  //! Pool running the transfers of all draining file systems
+  eos::common::ThreadPool mThreadPool;
   DrainMap  mDrainFS;
   XrdSysMutex mDrainMutex, drainConfMutex;
 };
@@ -31,8 +31,18 @@
 #include "common/Logging.hh"
 #include "common/Timing.hh"
 #include "common/Path.hh"
+#include "mgm/Acl.hh"
 #include "common/http/OwnCloud.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
 #include "XrdOuc/XrdOucErrInfo.hh"
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -40,6 +50,311 @@ EOSMGMNAMESPACE_BEGIN
 char dav_rfc3986[256] = {0};
 char dav_html5[256] = {0};
 
+/*----------------------------------------------------------------------------*/
+//! Number of children whose stat information is filled under one lock
+static const size_t sPropFindBatchSize = 512;
+//! Max number of cached depth 1 responses
+static const size_t sPropFindCacheMaxEntries = 4096;
+//! Max size of a cached depth 1 response
+static const size_t sPropFindCacheMaxBody = 16 * 1024 * 1024;
+
+/*----------------------------------------------------------------------------*/
+//! Cached depth 1 PROPFIND response of a collection
+struct PropFindCacheEntry {
+  std::string etag; //!< ETag of the collection when the body was built
+  time_t ts; //!< Time when the body was built
+  std::shared_ptr<const std::string> body; //!< Response body
+  std::list<std::string>::iterator lru; //!< Position in sPropFindCacheLru
+};
+
+static std::mutex sPropFindCacheMutex;
+//! Cached responses by request key
+static std::unordered_map<std::string, PropFindCacheEntry> sPropFindCache;
+//! Keys of the cached responses, most recently used first
+static std::list<std::string> sPropFindCacheLru;
+//! Size of the cached bodies
+static size_t sPropFindCacheBytes = 0;
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Drop a cached response, sPropFindCacheMutex has to be held
+ */
+/*----------------------------------------------------------------------------*/
+static void
+PropFindCacheErase(std::unordered_map<std::string, PropFindCacheEntry>::iterator
+                   it)
+{
+  sPropFindCacheBytes -= it->second.body->size();
+  sPropFindCacheLru.erase(it->second.lru);
+  sPropFindCache.erase(it);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Get a cached response if it was built for the current ETag of the
+ * collection and is not older than ttl seconds
+ *
+ * @return response body or nullptr if not cached
+ */
+/*----------------------------------------------------------------------------*/
+static std::shared_ptr<const std::string>
+PropFindCacheGet(const std::string& key, const std::string& etag, time_t ttl)
+{
+  std::lock_guard<std::mutex> lock(sPropFindCacheMutex);
+  auto it = sPropFindCache.find(key);
+
+  if (it == sPropFindCache.end()) {
+    return nullptr;
+  }
+
+  if ((it->second.etag != etag) || (it->second.ts + ttl <= time(NULL))) {
+    PropFindCacheErase(it);
+    return nullptr;
+  }
+
+  sPropFindCacheLru.splice(sPropFindCacheLru.begin(), sPropFindCacheLru,
+                           it->second.lru);
+  return it->second.body;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Cache a response, evicting the least recently used ones to stay within
+ * max_bytes and sPropFindCacheMaxEntries
+ */
+/*----------------------------------------------------------------------------*/
+static void
+PropFindCachePut(const std::string& key, const std::string& etag,
+                 const std::string& body, size_t max_bytes)
+{
+  if ((body.size() > sPropFindCacheMaxBody) || (body.size() > max_bytes)) {
+    return;
+  }
+
+  auto cached = std::make_shared<const std::string>(body);
+  std::lock_guard<std::mutex> lock(sPropFindCacheMutex);
+  auto it = sPropFindCache.find(key);
+
+  if (it != sPropFindCache.end()) {
+    PropFindCacheErase(it);
+  }
+
+  while (!sPropFindCacheLru.empty() &&
+         ((sPropFindCacheBytes + body.size() > max_bytes) ||
+          (sPropFindCache.size() >= sPropFindCacheMaxEntries))) {
+    PropFindCacheErase(sPropFindCache.find(sPropFindCacheLru.back()));
+  }
+
+  sPropFindCacheLru.push_front(key);
+  sPropFindCache[key] = PropFindCacheEntry {etag, time(NULL), cached,
+                                            sPropFindCacheLru.begin()
+                                           };
+  sPropFindCacheBytes += body.size();
+}
+
+/*----------------------------------------------------------------------------*/
+//! Child of a collection as enumerated for a PROPFIND
+struct PropFindChild {
+  std::string name;
+  eos::IContainerMD::id_t id;
+  bool isdir;
+  bool valid; //!< Stat information was filled
+  bool link; //!< Symbolic link, needs a path based stat
+  struct stat statInfo;
+  std::string etag;
+};
+
+/*----------------------------------------------------------------------------*/
+static long long
+PropFindEnvValue(const char* name, long long def)
+{
+  const char* val = getenv(name);
+  return (val ? strtoll(val, 0, 10) : def);
+}
+
+/*----------------------------------------------------------------------------*/
+static bool
+PropFindHiddenEntry(const std::string& name)
+{
+  XrdOucString entryname = name.c_str();
+  return (entryname.beginswith(EOS_COMMON_PATH_VERSION_FILE_PREFIX) ||
+          entryname.beginswith(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) ||
+          entryname.beginswith(EOS_WEBDAV_HIDE_IN_PROPFIND_PREFIX));
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Open a collection through the directory interface, which applies the path
+ * mapping, the access rules, stalls and redirects and the browse permission,
+ * and get its id and ETag without enumerating it.
+ *
+ * @param dir_path filled with the namespace path of the collection
+ *
+ * @return 0 if successful, otherwise errno
+ */
+/*----------------------------------------------------------------------------*/
+static int
+PropFindOpenCollection(const std::string& path,
+                       eos::common::Mapping::VirtualIdentity& vid,
+                       std::string& dir_path, eos::IContainerMD::id_t& id,
+                       std::string& etag, bool& cacheable)
+{
+  XrdMgmOfsDirectory directory;
+  int rc = directory.open(path.c_str(), vid, (const char*) 0);
+
+  if (rc != SFS_OK) {
+    // Stalls and redirects can not be followed by a WebDAV client
+    return ((rc == SFS_ERROR) && directory.error.getErrInfo()) ?
+           directory.error.getErrInfo() : EAGAIN;
+  }
+
+  dir_path = directory.FName();
+  directory.close();
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+  std::shared_ptr<eos::IContainerMD> dh;
+
+  try {
+    dh = gOFS->eosView->getContainer(dir_path);
+  } catch (eos::MDException& e) {
+    return e.getErrno();
+  }
+
+  struct stat buf;
+  id = dh->getId();
+  gOFS->ContainerMdToStat(dh.get(), &buf, &etag);
+  cacheable = (gOFS->eosSyncTimeAccounting &&
+               dh->hasAttribute("sys.mtime.propagation"));
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Enumerate the children of an opened collection by id under a single
+ * namespace lock
+ *
+ * @return 0 if successful, otherwise errno
+ */
+/*----------------------------------------------------------------------------*/
+static int
+PropFindListCollection(const std::string& dir_path,
+                       std::vector<PropFindChild>& children)
+{
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+  std::shared_ptr<eos::IContainerMD> dh;
+
+  try {
+    dh = gOFS->eosView->getContainer(dir_path);
+  } catch (eos::MDException& e) {
+    return e.getErrno();
+  }
+
+  children.reserve(dh->getNumContainers() + dh->getNumFiles());
+
+  for (auto it = dh->filesBegin(); it != dh->filesEnd(); ++it) {
+    if (!PropFindHiddenEntry(it->first)) {
+      children.push_back(PropFindChild {it->first, it->second, false, false,
+                                        false, {}, ""});
+    }
+  }
+
+  for (auto it = dh->subcontainersBegin(); it != dh->subcontainersEnd(); ++it) {
+    if (!PropFindHiddenEntry(it->first)) {
+      children.push_back(PropFindChild {it->first, it->second, true, false,
+                                        false, {}, ""});
+    }
+  }
+
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Count the entries below a collection using the number of children kept by
+ * every container, without building anything. The count stops as soon as
+ * it exceeds max_entries.
+ *
+ * @param id  id of the collection
+ *
+ * @return number of entries counted, max_entries + 1 if exceeded
+ */
+/*----------------------------------------------------------------------------*/
+static size_t
+PropFindCountTree(eos::IContainerMD::id_t id, size_t max_entries)
+{
+  size_t nentries = 0;
+  std::deque<eos::IContainerMD::id_t> to_count;
+  to_count.push_back(id);
+
+  while (!to_count.empty()) {
+    // Don't keep the namespace locked for the whole tree
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+    for (size_t n = 0; (n < sPropFindBatchSize) && !to_count.empty(); ++n) {
+      eos::IContainerMD::id_t cid = to_count.front();
+      to_count.pop_front();
+
+      try {
+        std::shared_ptr<eos::IContainerMD> cmd =
+          gOFS->eosDirectoryService->getContainerMD(cid);
+        nentries += cmd->getNumFiles() + cmd->getNumContainers();
+
+        if (nentries > max_entries) {
+          return max_entries + 1;
+        }
+
+        for (auto it = cmd->subcontainersBegin();
+             it != cmd->subcontainersEnd(); ++it) {
+          to_count.push_back(it->second);
+        }
+      } catch (eos::MDException& e) {
+        // Container removed in the meanwhile
+      }
+    }
+  }
+
+  return nentries;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Fill the stat information of a batch of children under one namespace lock
+ */
+/*----------------------------------------------------------------------------*/
+static void
+PropFindFillStats(std::vector<PropFindChild>& children, size_t begin,
+                  size_t end)
+{
+  eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex);
+
+  for (size_t i = begin; i < end; ++i) {
+    PropFindChild& child = children[i];
+
+    try {
+      if (child.isdir) {
+        std::shared_ptr<eos::IContainerMD> cmd =
+          gOFS->eosDirectoryService->getContainerMD(child.id);
+        gOFS->ContainerMdToStat(cmd.get(), &child.statInfo, &child.etag);
+      } else {
+        std::shared_ptr<eos::IFileMD> fmd =
+          gOFS->eosFileService->getFileMD(child.id);
+
+        if (fmd->isLink()) {
+          child.link = true;
+          continue;
+        }
+
+        gOFS->FileMdToStat(fmd.get(), &child.statInfo, &child.etag);
+      }
+
+      child.valid = true;
+    } catch (eos::MDException& e) {
+      // Entry removed in the meanwhile
+      eos_static_debug("msg=\"failed to stat child\" id=%llu ec=%d",
+                       (unsigned long long) child.id, e.getErrno());
+    }
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 void
 dav_uri_encode(unsigned char* s, char* enc, char* tb)
@@ -124,19 +439,6 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     }
   }
 
-  // Build the response
-  // xml declaration
-  xml_node<>* decl = mXMLResponseDocument.allocate_node(node_declaration);
-  decl->append_attribute(AllocateAttribute("version", "1.0"));
-  decl->append_attribute(AllocateAttribute("encoding", "utf-8"));
-  mXMLResponseDocument.append_node(decl);
-  // <multistatus/> node
-  xml_node<>* multistatusNode = AllocateNode("d:multistatus");
-  multistatusNode->append_attribute(AllocateAttribute("xmlns:d", "DAV:"));
-  multistatusNode->append_attribute(
-    AllocateAttribute(eos::common::OwnCloud::OwnCloudNs(),
-                      eos::common::OwnCloud::OwnCloudNsUrl()));
-  mXMLResponseDocument.append_node(multistatusNode);
   // Is the requested resource a file or directory?
   XrdOucErrInfo error;
   struct stat statInfo;
@@ -157,86 +459,274 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
   //  }
   eos_static_debug("depth=%s, isdir=%d", depth.c_str(),
                    S_ISDIR(statInfo.st_mode));
-  xml_node<>* responseNode = 0;
 
-  if (depth == "0" || !S_ISDIR(statInfo.st_mode)) {
-    // Simply stat the file or direcAtory
-    responseNode = BuildResponseNode(request->GetUrl(), request->GetUrl(true));
+  bool infinite = false;
+  bool noroot = false;
+  int level = ParseDepth(depth, infinite, noroot);
 
-    if (responseNode) {
-      multistatusNode->append_node(responseNode);
-    } else {
-      return this;
+  if (level < 0) {
+    SetResponseCode(ResponseCodes::BAD_REQUEST);
+    return this;
+  }
+
+  if (S_ISDIR(statInfo.st_mode) && level) {
+    return BuildCollectionResponse(request, noroot, infinite);
+  }
+
+  // Build the response
+  // xml declaration
+  xml_node<>* decl = mXMLResponseDocument.allocate_node(node_declaration);
+  decl->append_attribute(AllocateAttribute("version", "1.0"));
+  decl->append_attribute(AllocateAttribute("encoding", "utf-8"));
+  mXMLResponseDocument.append_node(decl);
+  // <multistatus/> node
+  xml_node<>* multistatusNode = AllocateNode("d:multistatus");
+  multistatusNode->append_attribute(AllocateAttribute("xmlns:d", "DAV:"));
+  multistatusNode->append_attribute(
+    AllocateAttribute(eos::common::OwnCloud::OwnCloudNs(),
+                      eos::common::OwnCloud::OwnCloudNsUrl()));
+  mXMLResponseDocument.append_node(multistatusNode);
+  // Simply stat the file or directory
+  xml_node<>* responseNode = BuildResponseNode(request->GetUrl(),
+                             request->GetUrl(true));
+
+  if (responseNode) {
+    multistatusNode->append_node(responseNode);
+  } else {
+    return this;
+  }
+
+  std::string responseString;
+  rapidxml::print(std::back_inserter(responseString), mXMLResponseDocument,
+                  rapidxml::print_no_indenting);
+  mXMLResponseDocument.clear();
+  SetResponseCode(HttpResponse::MULTI_STATUS);
+  AddHeader("Content-Length", std::to_string((long long) responseString.size()));
+  AddHeader("Content-Type", "application/xml; charset=utf-8");
+  SetBody(responseString);
+  return this;
+}
+
+/*----------------------------------------------------------------------------*/
+eos::common::HttpResponse*
+PropFindResponse::BuildCollectionResponse(eos::common::HttpRequest* request,
+    bool noroot, bool infinite)
+{
+  using namespace rapidxml;
+  const size_t max_entries = PropFindEnvValue(
+                               "EOS_MGM_DAV_PROPFIND_MAX_ENTRIES", 100000);
+  const time_t cache_ttl = PropFindEnvValue("EOS_MGM_DAV_PROPFIND_CACHE_TTL",
+                           30);
+  const size_t cache_size = PropFindEnvValue("EOS_MGM_DAV_PROPFIND_CACHE_SIZE",
+                            256 * 1024 * 1024);
+  std::string body;
+  std::string cache_key;
+  std::string cache_etag;
+  bool first = true;
+  // Collections still to be listed as pairs of (path, href)
+  std::deque<std::pair<std::string, std::string>> to_list;
+  to_list.push_back(std::make_pair(request->GetUrl(), request->GetUrl(true)));
+
+  body = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+         "<d:multistatus xmlns:d=\"DAV:\" ";
+  body += eos::common::OwnCloud::OwnCloudNs();
+  body += "=\"";
+  body += eos::common::OwnCloud::OwnCloudNsUrl();
+  body += "\">";
+
+  while (!to_list.empty()) {
+    std::string url = to_list.front().first;
+    std::string hrefurl = to_list.front().second;
+    to_list.pop_front();
+    std::vector<PropFindChild> children;
+    std::string dir_path;
+    std::string etag;
+    eos::IContainerMD::id_t id = 0;
+    bool cacheable = false;
+    int rc = PropFindOpenCollection(url, *mVirtualIdentity, dir_path, id, etag,
+                                    cacheable);
+
+    if (rc) {
+      if (first) {
+        eos_static_warning("msg=\"error opening directory - might be "
+                           "stalled/banned\" path=%s errno=%d", url.c_str(), rc);
+        SetResponseCode(rc == ENOENT ? ResponseCodes::NOT_FOUND :
+                        ResponseCodes::FORBIDDEN);
+        return this;
+      }
+
+      // Sub-collections we can't browse are reported but not descended into
+      continue;
     }
-  } else if (depth == "1") {
-    // Stat the resource and all child resources
-    XrdMgmOfsDirectory directory;
-    int listrc = directory.open(request->GetUrl().c_str(), *mVirtualIdentity,
-                                 (const char*) 0);
-    responseNode = BuildResponseNode(request->GetUrl().c_str(),
-                                     request->GetUrl(true).c_str());
-
-    if (responseNode) {
-      multistatusNode->append_node(responseNode);
+
+    if (first) {
+      first = false;
+
+      // RFC 4918 - refuse infinite depth before walking the tree if disabled
+      // or if the tree is too big, the limit is checked on the child counts
+      if (infinite && (!max_entries ||
+                       (PropFindCountTree(id, max_entries) > max_entries))) {
+        eos_static_warning("msg=\"propfind with infinite depth refused\" "
+                           "path=%s max=%llu", url.c_str(),
+                           (unsigned long long) max_entries);
+        body = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+               "<d:error xmlns:d=\"DAV:\"><d:propfind-finite-depth/>"
+               "</d:error>";
+        SetResponseCode(ResponseCodes::FORBIDDEN);
+        AddHeader("Content-Length", std::to_string((long long) body.size()));
+        AddHeader("Content-Type", "application/xml; charset=utf-8");
+        SetBody(body);
+        return this;
+      }
+
+      // The access checks were done by the open, a hit skips the enumeration
+      // and the stats of the children
+      if (!infinite && cacheable && cache_ttl && cache_size &&
+          IsCacheable(mRequestPropertyTypes)) {
+        cache_key = url + "\n" + hrefurl + "\n" +
+                    IdentityKey(*mVirtualIdentity) + "\n" +
+                    std::to_string(mRequestPropertyTypes) + (noroot ? "n" : "");
+        cache_etag = etag;
+        std::shared_ptr<const std::string> cached =
+          PropFindCacheGet(cache_key, etag, cache_ttl);
+
+        if (cached) {
+          eos_static_debug("msg=\"propfind cache hit\" path=%s etag=%s",
+                           url.c_str(), etag.c_str());
+          SetResponseCode(HttpResponse::MULTI_STATUS);
+          AddHeader("Content-Length", std::to_string((long long) cached->size()));
+          AddHeader("Content-Type", "application/xml; charset=utf-8");
+          SetBody(*cached);
+          return this;
+        }
+      }
+
+      if (!noroot) {
+        xml_node<>* responseNode = BuildResponseNode(url, hrefurl);
+
+        if (!responseNode) {
+          return this;
+        }
+
+        rapidxml::print(std::back_inserter(body), *responseNode,
+                        rapidxml::print_no_indenting);
+        mXMLResponseDocument.clear();
+      }
     }
 
-    if (!listrc) {
-      const char* val;
+    if (PropFindListCollection(dir_path, children)) {
+      // Removed in the meanwhile, reported without its children
+      continue;
+    }
 
-      while ((val = directory.nextEntry())) {
-        XrdOucString entryname = val;
+    for (size_t begin = 0; begin < children.size();
+         begin += sPropFindBatchSize) {
+      size_t end = std::min(children.size(), begin + sPropFindBatchSize);
+      PropFindFillStats(children, begin, end);
+
+      for (size_t i = begin; i < end; ++i) {
+        PropFindChild& child = children[i];
+        eos::common::Path path((url + "/" + child.name).c_str());
+        eos::common::Path refpath((hrefurl + "/" + child.name).c_str());
+        xml_node<>* responseNode = 0;
+
+        if (child.link) {
+          // Symbolic links are followed by the path based stat
+          responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath());
+        } else if (child.valid) {
+          responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath(),
+                                           child.statInfo, child.etag);
+        }
 
-        // don't display . .., atomic(+version) uploads and version directories
-        if (entryname.beginswith(EOS_COMMON_PATH_VERSION_FILE_PREFIX) ||
-            entryname.beginswith(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) ||
-            entryname.beginswith(EOS_WEBDAV_HIDE_IN_PROPFIND_PREFIX) ||
-            (entryname == ".") ||
-            (entryname == "..")) {
-          // skip over . .. and hidden files
+        if (!responseNode) {
+          // We might have a failed stat if there are symlinks present or if
+          // the entry was deleted in the meanwhile
+          SetResponseCode(HttpResponse::OK);
           continue;
         }
 
-        // one response node for each file...
-        eos::common::Path path((request->GetUrl() + std::string("/") + std::string(
-                                  val)).c_str());
-        eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
-                                   std::string(val)).c_str());
-        responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath());
-
-        if (responseNode) {
-          multistatusNode->append_node(responseNode);
-        } else {
-          // We might have a failed stat in the BuildResponseNode if there are
-          // symlinks present
-          SetResponseCode(HttpResponse::OK);
+        rapidxml::print(std::back_inserter(body), *responseNode,
+                        rapidxml::print_no_indenting);
+
+        if (infinite && child.isdir) {
+          to_list.push_back(std::make_pair(std::string(path.GetPath()),
+                                           std::string(refpath.GetPath())));
         }
       }
-    } else {
-      eos_static_warning("msg=\"error opening directory - might be stalled/banned\"");
-      SetResponseCode(ResponseCodes::FORBIDDEN);
-      return this;
+
+      // Release the nodes of this batch, they are already serialized
+      mXMLResponseDocument.clear();
     }
-  } else if (depth == "1,noroot") {
-    // Stat all child resources but not the requested resource
-    SetResponseCode(HttpResponse::NOT_IMPLEMENTED);
-    return this;
-  } else if (depth == "infinity" || depth == "") {
-    // Recursively stat the resource and all child resources
-    SetResponseCode(HttpResponse::NOT_IMPLEMENTED);
-    return this;
   }
 
-  std::string responseString;
-  rapidxml::print(std::back_inserter(responseString), mXMLResponseDocument,
-                  rapidxml::print_no_indenting);
-  mXMLResponseDocument.clear();
+  body += "</d:multistatus>";
+
+  if (cache_key.length()) {
+    PropFindCachePut(cache_key, cache_etag, body, cache_size);
+  }
+
   SetResponseCode(HttpResponse::MULTI_STATUS);
-  AddHeader("Content-Length", std::to_string((long long) responseString.size()));
+
+  AddHeader("Content-Length", std::to_string((long long) body.size()));
   AddHeader("Content-Type", "application/xml; charset=utf-8");
-  SetBody(responseString);
+  SetBody(body);
   return this;
 }
 
+/*----------------------------------------------------------------------------*/
+int
+PropFindResponse::ParseDepth(const std::string& depth, bool& infinite,
+                             bool& noroot)
+{
+  infinite = ((depth == "infinity") || depth.empty());
+  noroot = (depth == "1,noroot");
+
+  if (depth == "0") {
+    return 0;
+  }
+
+  if ((depth == "1") || noroot || infinite) {
+    return 1;
+  }
+
+  return -1;
+}
+
+/*----------------------------------------------------------------------------*/
+bool
+PropFindResponse::IsCacheable(int propertyTypes)
+{
+  return !(propertyTypes & (PropertyTypes::QUOTA_AVAIL |
+                            PropertyTypes::QUOTA_USED |
+                            PropertyTypes::GET_OCPERM));
+}
+
+/*----------------------------------------------------------------------------*/
+std::string
+PropFindResponse::IdentityKey(const eos::common::Mapping::VirtualIdentity& vid)
+{
+  std::string key = std::to_string(vid.uid) + ":" + std::to_string(vid.gid);
+  std::vector<uid_t> uids(vid.uid_list.begin(), vid.uid_list.end());
+  std::vector<gid_t> gids(vid.gid_list.begin(), vid.gid_list.end());
+  std::sort(uids.begin(), uids.end());
+  std::sort(gids.begin(), gids.end());
+  key += ":u";
+
+  for (const auto& uid : uids) {
+    key += "," + std::to_string(uid);
+  }
+
+  key += ":g";
+
+  for (const auto& gid : gids) {
+    key += "," + std::to_string(gid);
+  }
+
+  key += std::string(":") + (vid.sudoer ? "s" : "-") + ":" +
+         vid.prot.c_str() + ":" + vid.host;
+  return key;
+}
+
 /*----------------------------------------------------------------------------*/
 void
 PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
@@ -309,13 +799,9 @@ rapidxml::xml_node<>*
 PropFindResponse::BuildResponseNode(const std::string& url,
                                     const std::string& hrefurl)
 {
-  using namespace rapidxml;
-  XrdMgmOfsDirectory directory;
   XrdOucErrInfo error;
   struct stat statInfo;
   std::string etag;
-  std::string id;
-  bool allpropresponse = false;
   XrdOucString urlp = url.c_str();
   XrdOucString hrefp = hrefurl.c_str();
 
@@ -336,6 +822,29 @@ PropFindResponse::BuildResponseNode(const std::string& url,
     return NULL;
   }
 
+  return BuildResponseNode(urlp.c_str(), hrefp.c_str(), statInfo, etag);
+}
+
+/*----------------------------------------------------------------------------*/
+rapidxml::xml_node<>*
+PropFindResponse::BuildResponseNode(const std::string& url,
+                                    const std::string& hrefurl,
+                                    struct stat& statInfo,
+                                    const std::string& etag)
+{
+  using namespace rapidxml;
+  XrdOucErrInfo error;
+  std::string id;
+  bool allpropresponse = false;
+  XrdOucString urlp = url.c_str();
+  XrdOucString hrefp = hrefurl.c_str();
+
+  while (urlp.replace("//", "/")) {
+  }
+
+  while (hrefp.replace("//", "/")) {
+  }
+
   eos_static_debug("url=%s etag=%s", urlp.c_str(), etag.c_str());
   // encode the url's
   urlp = EncodeURI(urlp.c_str()).c_str();
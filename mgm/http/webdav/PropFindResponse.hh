@@ -151,6 +151,80 @@ public:
   rapidxml::xml_node<>*
   BuildResponseNode (const std::string &url, const std::string &hrefurl);
 
+  /**
+   * Build a response XML <response/> node from already known stat
+   * information without going back to the namespace.
+   *
+   * @param url       the URL of the resource to build a response node for
+   * @param hrefurl   the URL to be reported in the <href/> node
+   * @param statInfo  the stat information of the resource
+   * @param etag      the ETag of the resource
+   *
+   * @return the newly build response node
+   */
+  rapidxml::xml_node<>*
+  BuildResponseNode (const std::string &url, const std::string &hrefurl,
+                     struct stat &statInfo, const std::string &etag);
+
+  /**
+   * Build the response for a PROPFIND with depth 1 or infinity on a
+   * collection. Every collection is opened through XrdMgmOfsDirectory for the
+   * access checks, then its children are enumerated by id under a single
+   * namespace lock, their stat information is filled in batches and every <response/>
+   * node is serialized as soon as it is built, so that the XML DOM never
+   * holds more than one batch. An infinite depth request is refused before
+   * the walk if the tree holds more than EOS_MGM_DAV_PROPFIND_MAX_ENTRIES
+   * entries. Depth 1 responses of collections with
+   * mtime propagation are cached and served again, without enumerating the
+   * collection, while their ETag does not change. The cache keeps the most
+   * recently used responses within EOS_MGM_DAV_PROPFIND_CACHE_SIZE bytes.
+   *
+   * @param request   the client request object
+   * @param noroot    if true don't report the collection itself
+   * @param infinite  if true descend into all sub-collections
+   *
+   * @return the response object
+   */
+  HttpResponse*
+  BuildCollectionResponse (eos::common::HttpRequest *request, bool noroot,
+                           bool infinite);
+
+  /**
+   * Parse the Depth header of a PROPFIND request. A missing header means
+   * infinity (RFC 4918).
+   *
+   * @param depth     value of the Depth header
+   * @param infinite  set to true if all sub-collections are requested
+   * @param noroot    set to true if the collection itself is not reported
+   *
+   * @return 0 or 1 for a finite depth, infinity is 1 with infinite set,
+   *         -1 if the header is invalid
+   */
+  static int
+  ParseDepth (const std::string &depth, bool &infinite, bool &noroot);
+
+  /**
+   * Check if a depth 1 response with the given properties may be cached.
+   * Quota and permission properties depend on more than the collection ETag.
+   *
+   * @param propertyTypes  the requested property types
+   *
+   * @return true if the response can be cached
+   */
+  static bool
+  IsCacheable (int propertyTypes);
+
+  /**
+   * Build the part of the cache key describing everything the access
+   * decisions of a listing depend on for the given identity.
+   *
+   * @param vid  the virtual identity of the client
+   *
+   * @return the identity key
+   */
+  static std::string
+  IdentityKey (const eos::common::Mapping::VirtualIdentity &vid);
+
   /**
    * Convert the given property type string into its integer constant
    * representation.
@@ -27,12 +27,10 @@
 
 EOSMGMNAMESPACE_BEGIN
 
-std::atomic_uint_least64_t IProcCommand::uuid{0};
-
 //------------------------------------------------------------------------------
 // Open a proc command e.g. call the appropriate user or admin commmand and
-// store the output in a resultstream or in case of find in a temporary output
-// file.
+// store the output in a resultstream or in case of streaming commands return
+// as soon as the command started writing its output.
 //------------------------------------------------------------------------------
 int
 IProcCommand::open(const char* path, const char* info,
@@ -47,9 +45,20 @@ IProcCommand::open(const char* path, const char* info,
     mExecRequest = true;
   }
 
-  std::future_status status = mFuture.wait_for(std::chrono::seconds(delay));
+  std::future_status status = std::future_status::timeout;
+
+  // Streaming commands can be read from before they are done
+  for (int i = 0; i < delay * 10; ++i) {
+    status = mFuture.wait_for(std::chrono::milliseconds(100));
+
+    if ((status == std::future_status::ready) || mStdOutStream.IsOpen()) {
+      break;
+    }
+  }
 
-  if (status != std::future_status::ready) {
+  if (mStdOutStream.IsOpen()) {
+    readStdOutStream = true;
+  } else if (status != std::future_status::ready) {
     // Stall the client
     std::string msg = "command not ready, stall the client 5 seconds";
     eos_notice("%s", msg.c_str());
@@ -58,31 +67,22 @@ IProcCommand::open(const char* path, const char* info,
     // @todo (esindril): Investigate how SFS_STARTED would behave in such a case
   } else {
     eos::console::ReplyProto reply = mFuture.get();
-
-    // Output is written in file
-    if (!ofstdoutStreamFilename.empty() && !ofstderrStreamFilename.empty()) {
-      ifstdoutStream.open(ofstdoutStreamFilename, std::ifstream::in);
-      ifstderrStream.open(ofstderrStreamFilename, std::ifstream::in);
-      iretcStream.str(std::string("&mgm.proc.retc=") + std::to_string(reply.retc()));
-      readStdOutStream = true;
+    std::ostringstream oss;
+
+    if (mReqProto.format() == eos::console::RequestProto::JSON) {
+      ConvertToJsonFormat(reply, oss);
+    } else if (mReqProto.format() == eos::console::RequestProto::FUSE) {
+      // @todo (esindril) This format should be dropped and the client should
+      // just parse the stdout reponse. For example the FST dumpmd should do
+      // this.
+      oss << reply.std_out();
     } else {
-      std::ostringstream oss;
-
-      if (mReqProto.format() == eos::console::RequestProto::JSON) {
-        ConvertToJsonFormat(reply, oss);
-      } else if (mReqProto.format() == eos::console::RequestProto::FUSE) {
-        // @todo (esindril) This format should be dropped and the client should
-        // just parse the stdout reponse. For example the FST dumpmd should do
-        // this.
-        oss << reply.std_out();
-      } else {
-        oss << "mgm.proc.stdout=" << reply.std_out()
-            << "&mgm.proc.stderr=" << reply.std_err()
-            << "&mgm.proc.retc=" << reply.retc();
-      }
-
-      mTmpResp = oss.str();
+      oss << "mgm.proc.stdout=" << reply.std_out()
+          << "&mgm.proc.stderr=" << reply.std_err()
+          << "&mgm.proc.retc=" << reply.retc();
     }
+
+    mTmpResp = oss.str();
   }
 
   return SFS_OK;
@@ -96,34 +96,31 @@ IProcCommand::read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen)
 {
   size_t cpy_len = 0;
 
-  if (readStdOutStream && ifstdoutStream.is_open() && ifstderrStream.is_open()) {
-    ifstdoutStream.read(buff, blen);
-    cpy_len = (size_t)ifstdoutStream.gcount();
+  if (readStdOutStream) {
+    cpy_len = mStdOutStream.Read(buff, blen);
 
-    if (cpy_len < (size_t)blen) {
-      readStdOutStream = false;
-      readStdErrStream = true;
-      ifstderrStream.read(buff + cpy_len, blen - cpy_len);
-      cpy_len += (size_t)ifstderrStream.gcount();
-    }
-  } else if (readStdErrStream && ifstderrStream.is_open()) {
-    ifstderrStream.read(buff, blen);
-    cpy_len = (size_t)ifstderrStream.gcount();
-
-    if (cpy_len < (size_t)blen) {
-      readStdErrStream = false;
-      readRetcStream = true;
-      iretcStream.read(buff + cpy_len, blen - cpy_len);
-      cpy_len += (size_t)iretcStream.gcount();
+    if (cpy_len) {
+      return cpy_len;
     }
-  } else if (readRetcStream) {
-    iretcStream.read(buff, blen);
-    cpy_len = (size_t)iretcStream.gcount();
 
-    if (cpy_len < (size_t)blen) {
-      readRetcStream = false;
-    }
-  } else if ((size_t)offset < mTmpResp.length()) {
+    // The stdout is complete, the stderr and retc follow once the command
+    // returned
+    readStdOutStream = false;
+    mTmpRespOffset = mStdOutStream.GetSize();
+    eos::console::ReplyProto reply = mFuture.get();
+    std::ostringstream oss;
+    oss << "&mgm.proc.stderr=" << ofstderrStream.str()
+        << "&mgm.proc.retc=" << reply.retc();
+    mTmpResp = oss.str();
+  }
+
+  if (offset < mTmpRespOffset) {
+    return 0;
+  }
+
+  offset -= mTmpRespOffset;
+
+  if ((size_t)offset < mTmpResp.length()) {
     cpy_len = std::min((size_t)(mTmpResp.size() - offset), (size_t)blen);
     memcpy(buff, mTmpResp.data() + offset, cpy_len);
   }
@@ -141,7 +138,10 @@ IProcCommand::LaunchJob()
     mFuture = ProcInterface::sProcThreads.PushTask<eos::console::ReplyProto>
     ([&]() -> eos::console::ReplyProto {
       std::lock_guard<std::mutex> lock(mMutexAsync);
-      return ProcessRequest();
+      eos::console::ReplyProto reply = ProcessRequest();
+      // Release a reader waiting for streamed output
+      mStdOutStream.Close();
+      return reply;
     });
   } else {
     std::promise<eos::console::ReplyProto> promise;
@@ -162,6 +162,7 @@ IProcCommand::KillJob()
   }
 
   mForceKill.store(true);
+  mStdOutStream.Cancel();
 
   if (mMutexAsync.try_lock()) {
     mMutexAsync.unlock();
@@ -172,61 +173,29 @@ IProcCommand::KillJob()
 }
 
 //------------------------------------------------------------------------------
-// Open temporary output files for file based results
+// Stream the stdout of the command to the client
 //------------------------------------------------------------------------------
 bool
-IProcCommand::OpenTemporaryOutputFiles()
+IProcCommand::OpenStreamingOutput()
 {
-  ostringstream tmpdir;
-  tmpdir << "/tmp/eos.mgm/";
-  tmpdir << uuid++;
-  ofstdoutStreamFilename = tmpdir.str();
-  ofstdoutStreamFilename += ".stdout";
-  ofstderrStreamFilename = tmpdir.str();
-  ofstderrStreamFilename += ".stderr";
-  eos::common::Path cPath(ofstdoutStreamFilename.c_str());
-
-  if (!cPath.MakeParentPath(S_IRWXU)) {
-    eos_err("Unable to create temporary outputfile directory %s",
-            tmpdir.str().c_str());
-    return false;
-  }
-
-  // own the directory by daemon
-  if (::chown(cPath.GetParentPath(), 2, 2)) {
-    eos_err("Unable to own temporary outputfile directory %s",
-            cPath.GetParentPath());
-  }
-
-  ofstdoutStream.open(ofstdoutStreamFilename, std::ofstream::out);
-  ofstderrStream.open(ofstderrStreamFilename, std::ofstream::out);
-
-  if ((!ofstdoutStream) || (!ofstderrStream)) {
-    if (ofstdoutStream.is_open()) {
-      ofstdoutStream.close();
-    }
-
-    if (ofstderrStream.is_open()) {
-      ofstderrStream.close();
-    }
-
+  if (!mDoAsync) {
     return false;
   }
 
+  mStdOutStream.Open();
   ofstdoutStream << "mgm.proc.stdout=";
-  ofstderrStream << "&mgm.proc.stderr=";
-  return true;
+  return (bool) ofstdoutStream;
 }
 
 //------------------------------------------------------------------------------
-// Open temporary output files for file based results
+// Mark the end of the streamed stdout
 //------------------------------------------------------------------------------
 bool
-IProcCommand::CloseTemporaryOutputFiles()
+IProcCommand::CloseStreamingOutput()
 {
-  ofstdoutStream.close();
-  ofstderrStream.close();
-  return !(ofstdoutStream.is_open() || ofstderrStream.is_open());
+  ofstdoutStream.flush();
+  mStdOutStream.Close();
+  return !mStdOutStream.IsCancelled();
 }
 
 //------------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 
 #pragma once
 #include "mgm/Namespace.hh"
+#include "mgm/proc/ProcStream.hh"
 #include "common/Mapping.hh"
 #include "common/Logging.hh"
 #include "common/ConsoleReply.pb.h"
@@ -47,7 +48,8 @@ public:
   //----------------------------------------------------------------------------
   IProcCommand():
     mExecRequest(false), mReqProto(), mDoAsync(false), mForceKill(false),
-    stdOut(), stdErr(), stdJson(), retc(0), mTmpResp() {}
+    stdOut(), stdErr(), stdJson(), retc(0), mTmpResp(), mTmpRespOffset(0),
+    ofstdoutStream(&mStdOutStream) {}
 
   //----------------------------------------------------------------------------
   //! Costructor
@@ -58,7 +60,7 @@ public:
                eos::common::Mapping::VirtualIdentity& vid, bool async):
     mExecRequest(false), mReqProto(std::move(req)), mDoAsync(async),
     mForceKill(false), mVid(vid), stdOut(), stdErr(), stdJson(), retc(0),
-    mTmpResp() {}
+    mTmpResp(), mTmpRespOffset(0), ofstdoutStream(&mStdOutStream) {}
 
   //----------------------------------------------------------------------------
   //! Destructor
@@ -66,24 +68,12 @@ public:
   virtual ~IProcCommand()
   {
     mForceKill.store(true);
-
-    if (ofstdoutStream.is_open()) {
-      ofstdoutStream.close();
-    }
-
-    unlink(ofstdoutStreamFilename.c_str());
-
-    if (ofstderrStream.is_open()) {
-      ofstderrStream.close();
-    }
-
-    unlink(ofstderrStreamFilename.c_str());
   }
 
   //----------------------------------------------------------------------------
   //! Open a proc command e.g. call the appropriate user or admin commmand and
-  //! store the output in a resultstream of in case of find in temporary output
-  //! files.
+  //! store the output in a resultstream or in case of streaming commands
+  //! return as soon as the command started writing its output.
   //!
   //! @param inpath path indicating user or admin command
   //! @param info CGI describing the proc command
@@ -97,7 +87,8 @@ public:
                    XrdOucErrInfo* error);
 
   //----------------------------------------------------------------------------
-  //! Read a part of the result stream created during open
+  //! Read a part of the result stream created during open, for streaming
+  //! commands this blocks until the command produced more output
   //!
   //! @param boff offset where to start
   //! @param buff buffer to store stream
@@ -108,7 +99,8 @@ public:
   virtual size_t read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen);
 
   //----------------------------------------------------------------------------
-  //! Get the size of the result stream
+  //! Get the size of the result stream, for streaming commands the size of
+  //! the output produced so far
   //!
   //! @param buf stat structure to fill
   //!
@@ -119,17 +111,9 @@ public:
     off_t size = 0;
 
     if (readStdOutStream) {
-      ifstdoutStream.seekg(0, ifstdoutStream.end);
-      size += ifstdoutStream.tellg();
-      ifstdoutStream.seekg(0, ifstdoutStream.beg);
-      ifstderrStream.seekg(0, ifstderrStream.end);
-      size += ifstderrStream.tellg();
-      ifstderrStream.seekg(0, ifstderrStream.beg);
-      iretcStream.seekg(0, iretcStream.end);
-      size += iretcStream.tellg();
-      iretcStream.seekg(0, iretcStream.beg);
+      size = mStdOutStream.GetSize();
     } else {
-      size = mTmpResp.length();
+      size = mTmpRespOffset + mTmpResp.length();
     }
 
     memset(buf, 0, sizeof(struct stat));
@@ -139,19 +123,21 @@ public:
 
   //----------------------------------------------------------------------------
   //! Close the proc stream and store the clients comment for the command in the
-  //! comment log file
+  //! comment log file. A streaming command still running is told to stop and
+  //! waited for.
   //!
   //! @return 0 if comment has been successfully stored otherwise != 0
   //----------------------------------------------------------------------------
   virtual int close()
   {
     //@todo (esindril): to implement for proto commands
-    if (ifstdoutStream.is_open()) {
-      ifstdoutStream.close();
-    }
+    if (mStdOutStream.IsOpen()) {
+      mForceKill.store(true);
+      mStdOutStream.Cancel();
 
-    if (ifstderrStream.is_open()) {
-      ifstderrStream.close();
+      if (mFuture.valid()) {
+        mFuture.wait();
+      }
     }
 
     return SFS_OK;
@@ -177,8 +163,21 @@ public:
   virtual bool KillJob() final;
 
 protected:
-  virtual bool OpenTemporaryOutputFiles();
-  virtual bool CloseTemporaryOutputFiles();
+  //----------------------------------------------------------------------------
+  //! Stream the stdout of the command to the client while it is written to
+  //! ofstdoutStream instead of returning it in the reply, the stderr written
+  //! to ofstderrStream is sent at the end. Only for asynchronous commands.
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool OpenStreamingOutput();
+
+  //----------------------------------------------------------------------------
+  //! Mark the end of the streamed stdout
+  //!
+  //! @return true if successful, false if the client stopped reading
+  //----------------------------------------------------------------------------
+  bool CloseStreamingOutput();
 
   //----------------------------------------------------------------------------
   //! Format console reply as json output
@@ -201,17 +200,12 @@ protected:
   XrdOucString stdJson; ///< JSON output returned by proc command
   int retc; ///< return code from the proc command
   std::string mTmpResp; ///< String used for streaming the response
-  std::ofstream ofstdoutStream;
-  std::ofstream ofstderrStream;
-  std::string ofstdoutStreamFilename;
-  std::string ofstderrStreamFilename;
-  std::ifstream ifstdoutStream;
-  std::ifstream ifstderrStream;
-  std::istringstream iretcStream;
-  bool readStdOutStream {false};
-  bool readStdErrStream {false};
-  bool readRetcStream {false};
-  static std::atomic_uint_least64_t uuid;
+  //! Client offset at which mTmpResp starts i.e. length of the streamed stdout
+  XrdSfsFileOffset mTmpRespOffset;
+  ProcStream mStdOutStream; ///< Bounded stdout of streaming commands
+  std::ostream ofstdoutStream; ///< Writes to mStdOutStream
+  std::ostringstream ofstderrStream; ///< stderr of streaming commands
+  bool readStdOutStream {false}; ///< True while reading mStdOutStream
 };
 
 EOSMGMNAMESPACE_END
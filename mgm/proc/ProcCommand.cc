@@ -40,7 +40,8 @@ ProcCommand::ProcCommand():
   mOutDepth(0), fstdout(0), fstderr(0), fresultStream(0), fstdoutfilename(""),
   fstderrfilename(""), fresultStreamfilename(""), mError(0), mComment(""),
   mLen(0), mAdminCmd(false), mUserCmd(false), mFuseFormat(false),
-  mJsonFormat(false), mHttpFormat(false), mClosed(false), mJsonCallback("")
+  mJsonFormat(false), mHttpFormat(false), mClosed(false), mStreaming(false),
+  mLastStreamed(0), mJsonCallback("")
 {
   mExecTime = time(NULL);
 }
@@ -59,6 +60,13 @@ ProcCommand::ProcCommand(eos::common::Mapping::VirtualIdentity& vid):
 //------------------------------------------------------------------------------
 ProcCommand::~ProcCommand()
 {
+  // A streaming command still running uses the members below
+  if (mStreaming && mFuture.valid()) {
+    mForceKill.store(true);
+    mStdOutStream.Cancel();
+    mFuture.wait();
+  }
+
   if (fstdout) {
     fclose(fstdout);
     fstdout = 0;
@@ -230,6 +238,24 @@ ProcCommand::open(const char* inpath, const char* info,
     mJsonFormat = true;
   }
 
+  // Commands with a potentially large output stream it to the client while
+  // they run, see ProcessRequest
+  if (mDoAsync && !mJsonFormat && !mHttpFormat &&
+      ((mUserCmd && ((mCmd == "ls") || (mCmd == "fileinfo"))) ||
+       (mAdminCmd && (mCmd == "fs") && (mSubCmd == "dumpmd")))) {
+    // The identity and the opaque info of the caller are gone once open
+    // returns
+    mVid = vid_in;
+    pVid = &mVid;
+    mInfo = (info ? info : "");
+    ininfo = mInfo.c_str();
+
+    mStreaming = true;
+    mStdOutStream.Open();
+    LaunchJob();
+    return SFS_OK;
+  }
+
   // Admin command section
   if (mAdminCmd) {
     if (mCmd == "archive") {
@@ -380,6 +406,11 @@ ProcCommand::open(const char* inpath, const char* info,
 size_t
 ProcCommand::read(XrdSfsFileOffset boff, char* buff, XrdSfsXferSize blen)
 {
+  if (mStreaming) {
+    // The client reads the streamed output sequentially
+    return mStdOutStream.Read(buff, blen);
+  }
+
   if (fresultStream) {
     // file based results go here ...
     if ((fseek(fresultStream, boff, 0)) == 0) {
@@ -417,7 +448,7 @@ int
 ProcCommand::stat(struct stat* buf)
 {
   memset(buf, 0, sizeof(struct stat));
-  buf->st_size = mLen;
+  buf->st_size = (mStreaming ? mStdOutStream.GetSize() : mLen);
   return SFS_OK;
 }
 
@@ -429,6 +460,13 @@ int
 ProcCommand::close()
 {
   if (!mClosed) {
+    if (mStreaming && mFuture.valid()) {
+      // Stop the command if the client did not read all of the output
+      mForceKill.store(true);
+      mStdOutStream.Cancel();
+      mFuture.wait();
+    }
+
     // Only instance users or sudoers can add to the log book
     if ((pVid->uid <= 2) || (pVid->sudoer)) {
       if (mComment.length() && gOFS->commentLog) {
@@ -445,6 +483,75 @@ ProcCommand::close()
   return retc;
 }
 
+//------------------------------------------------------------------------------
+// Run a command streaming its output to the client
+//------------------------------------------------------------------------------
+eos::console::ReplyProto
+ProcCommand::ProcessRequest()
+{
+  eos::console::ReplyProto reply;
+
+  // Old style commands which don't stream their output run in open
+  if (!mStreaming) {
+    return reply;
+  }
+
+  if (!mFuseFormat) {
+    ofstdoutStream << "mgm.proc.stdout=";
+  }
+
+  if (mCmd == "ls") {
+    Ls();
+  } else if (mCmd == "fileinfo") {
+    Fileinfo();
+  } else {
+    Fs();
+  }
+
+  FlushStdOut();
+
+  if (!mFuseFormat) {
+    // Same result as MakeResult, stdErr is kept for the comment log
+    XrdOucString err = stdErr;
+    ofstdoutStream << "&mgm.proc.stderr=" << XrdMqMessage::Seal(err)
+                   << "&mgm.proc.retc=" << retc << "\n";
+  } else if (mLastStreamed && (mLastStreamed != '\n')) {
+    ofstdoutStream << "\n";
+  }
+
+  if (retc) {
+    eos_static_err("%s (errno=%u)", stdErr.c_str(), retc);
+  }
+
+  ofstdoutStream.flush();
+  reply.set_retc(retc);
+  return reply;
+}
+
+//------------------------------------------------------------------------------
+// Send the output collected so far to the client of a streaming command
+//------------------------------------------------------------------------------
+bool
+ProcCommand::FlushStdOut()
+{
+  if (!mStreaming) {
+    return true;
+  }
+
+  if (stdOut.length()) {
+    mLastStreamed = stdOut[stdOut.length() - 1];
+
+    if (!mFuseFormat) {
+      XrdMqMessage::Seal(stdOut);
+    }
+
+    ofstdoutStream << stdOut.c_str() << std::flush;
+    stdOut = "";
+  }
+
+  return (!mForceKill && ofstdoutStream);
+}
+
 //------------------------------------------------------------------------------
 // Build the inmemory result of the stdout,stderr & retc of the proc command.
 // Depending on the output format the key-value CGI returned changes => see
@@ -86,7 +86,7 @@ public:
   //----------------------------------------------------------------------------
   //! Open a proc command e.g. call the appropriate user or admin commmand and
   //! store the output in a resultstream of in case of find in temporary output
-  //! files.
+  //! files. Commands streaming their output run after open returns.
   //!
   //! @param inpath path indicating user or admin command
   //! @param info CGI describing the proc command
@@ -130,12 +130,20 @@ public:
 
   //----------------------------------------------------------------------------
   //! Method implementing the specific behvior of the command executed by the
-  //! asynchronous thread - used only for protobuf commands
+  //! asynchronous thread - used by old style commands only when they stream
+  //! their output, see AllowStreaming
   //----------------------------------------------------------------------------
-  virtual eos::console::ReplyProto ProcessRequest() override
+  virtual eos::console::ReplyProto ProcessRequest() override;
+
+  //----------------------------------------------------------------------------
+  //! Let the commands with a potentially large output (ls, fileinfo and
+  //! fs dumpmd) stream it to the client while they run instead of buffering
+  //! it. Only for commands opened on behalf of a client, internal callers
+  //! collect the output with AddOutput.
+  //----------------------------------------------------------------------------
+  inline void AllowStreaming()
   {
-    // Default behvior for old (raw) style commands
-    return eos::console::ReplyProto();
+    mDoAsync = true;
   }
 
   //----------------------------------------------------------------------------
@@ -153,7 +161,7 @@ public:
   //!
   //! @return true if successful otherwise false
   //----------------------------------------------------------------------------
-  bool OpenTemporaryOutputFiles() override;
+  bool OpenTemporaryOutputFiles();
 
   //----------------------------------------------------------------------------
   //! Get the return code of a proc command
@@ -271,6 +279,15 @@ public:
   //----------------------------------------------------------------------------
   bool KeyValToHttpTable(XrdOucString& stdOut);
 
+  //----------------------------------------------------------------------------
+  //! Send the output collected in stdOut so far to the client if the command
+  //! streams its output, otherwise do nothing. Must not be called while
+  //! holding the namespace lock since it blocks until the client reads.
+  //!
+  //! @return false if the client stopped reading, otherwise true
+  //----------------------------------------------------------------------------
+  bool FlushStdOut();
+
 protected:
   eos::common::Mapping::VirtualIdentity* pVid; ///< Pointer to virtual identity
 
@@ -308,6 +325,9 @@ private:
   bool mJsonFormat; ///< indicates JSON format
   bool mHttpFormat; ///< indicates HTTP format
   bool mClosed; ///< indicates the proc command has been closed already
+  bool mStreaming; ///< indicates the output is streamed to the client
+  char mLastStreamed; ///< last character streamed to the client
+  std::string mInfo; ///< copy of the opaque info of a streaming command
   XrdOucString mJsonCallback; ///< sets the JSONP callback name in a response
 
   //----------------------------------------------------------------------------
@@ -64,7 +64,9 @@ ProcInterface::GetProcCommand(const char* tident,
     if (env.Get("mgm.cmd.proto")) {
       pcmd = HandleProtobufRequest(path, opaque, vid);
     } else {
-      pcmd.reset(new ProcCommand());
+      ProcCommand* cmd = new ProcCommand();
+      cmd->AllowStreaming();
+      pcmd.reset(cmd);
     }
   }
 
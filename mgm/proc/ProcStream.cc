@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------------
+//! @file ProcStream.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#include "mgm/proc/ProcStream.hh"
+#include <algorithm>
+#include <cstring>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ProcStream::ProcStream(size_t chunk_size, size_t max_queued):
+  mChunkSize(chunk_size ? chunk_size : 1), mMaxQueued(max_queued),
+  mChunk(mChunkSize), mQueued(0), mOffset(0), mSize(0), mOpen(false),
+  mClosed(false), mCancelled(false), mReaderWaiting(false)
+{
+  setp(mChunk.data(), mChunk.data() + mChunkSize);
+}
+
+//------------------------------------------------------------------------------
+// Mark the stream as used
+//------------------------------------------------------------------------------
+void
+ProcStream::Open()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mOpen = true;
+}
+
+//------------------------------------------------------------------------------
+// Check if the stream is used
+//------------------------------------------------------------------------------
+bool
+ProcStream::IsOpen()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mOpen;
+}
+
+//------------------------------------------------------------------------------
+// Queue the pending output and mark the end of the stream
+//------------------------------------------------------------------------------
+void
+ProcStream::Close()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (!mClosed) {
+    (void) Push(lock);
+    mClosed = true;
+    mCond.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop the output and let all further writes fail
+//------------------------------------------------------------------------------
+void
+ProcStream::Cancel()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mCancelled = true;
+  mQueue.clear();
+  mQueued = 0;
+  mOffset = 0;
+  mCond.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Check if the stream was cancelled
+//------------------------------------------------------------------------------
+bool
+ProcStream::IsCancelled()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mCancelled;
+}
+
+//------------------------------------------------------------------------------
+// Read output
+//------------------------------------------------------------------------------
+size_t
+ProcStream::Read(char* buff, size_t len)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mReaderWaiting = true;
+  mCond.wait(lock, [&]() {
+    return (mQueue.size() || mClosed || mCancelled);
+  });
+  mReaderWaiting = false;
+  size_t nread = 0;
+
+  while ((nread < len) && mQueue.size()) {
+    const std::string& chunk = mQueue.front();
+    size_t ncopy = std::min(len - nread, chunk.size() - mOffset);
+    memcpy(buff + nread, chunk.data() + mOffset, ncopy);
+    nread += ncopy;
+    mOffset += ncopy;
+
+    if (mOffset == chunk.size()) {
+      mQueued -= chunk.size();
+      mOffset = 0;
+      mQueue.pop_front();
+    }
+  }
+
+  if (nread) {
+    mCond.notify_all();
+  }
+
+  return nread;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of bytes queued so far
+//------------------------------------------------------------------------------
+unsigned long long
+ProcStream::GetSize()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mSize;
+}
+
+//------------------------------------------------------------------------------
+// Queue the full chunk and start a new one
+//------------------------------------------------------------------------------
+ProcStream::int_type
+ProcStream::overflow(int_type ch)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (!Push(lock)) {
+    return traits_type::eof();
+  }
+
+  lock.unlock();
+
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(ch);
+}
+
+//------------------------------------------------------------------------------
+// Queue the current chunk if a reader is waiting for output
+//------------------------------------------------------------------------------
+int
+ProcStream::sync()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (mReaderWaiting) {
+    return (Push(lock) ? 0 : -1);
+  }
+
+  return (mCancelled ? -1 : 0);
+}
+
+//------------------------------------------------------------------------------
+// Move the current chunk into the queue
+//------------------------------------------------------------------------------
+bool
+ProcStream::Push(std::unique_lock<std::mutex>& lock)
+{
+  size_t len = pptr() - pbase();
+
+  if (len && !mCancelled) {
+    mCond.wait(lock, [&]() {
+      return (mCancelled || (mQueued < mMaxQueued));
+    });
+
+    if (!mCancelled) {
+      mQueue.emplace_back(pbase(), len);
+      mQueued += len;
+      mSize += len;
+      mCond.notify_all();
+    }
+  }
+
+  setp(mChunk.data(), mChunk.data() + mChunkSize);
+  return !mCancelled;
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+//! @file ProcStream.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ProcStream
+//!
+//! @brief Bounded stream of output chunks between a proc command writing its
+//! result and the client reading it. The command writes through an
+//! std::ostream using this buffer, full chunks are queued and handed out by
+//! Read. Once the queued bytes reach the limit the writer blocks until the
+//! client reads, so the memory used does not depend on the output size.
+//! Partial chunks are only queued on flush if a reader is waiting.
+//------------------------------------------------------------------------------
+class ProcStream: public std::streambuf
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param chunk_size size of the chunks handed to the reader
+  //! @param max_queued maximum number of queued bytes before blocking the
+  //!        writer
+  //----------------------------------------------------------------------------
+  ProcStream(size_t chunk_size = 64 * 1024, size_t max_queued = 4 * 1024 * 1024);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~ProcStream() = default;
+
+  //----------------------------------------------------------------------------
+  //! Mark the stream as used, the reader can start reading
+  //----------------------------------------------------------------------------
+  void Open();
+
+  //----------------------------------------------------------------------------
+  //! Check if the stream is used
+  //----------------------------------------------------------------------------
+  bool IsOpen();
+
+  //----------------------------------------------------------------------------
+  //! Queue the pending output and mark the end of the stream, called by the
+  //! writer
+  //----------------------------------------------------------------------------
+  void Close();
+
+  //----------------------------------------------------------------------------
+  //! Drop the output and let all further writes fail e.g. the client is gone
+  //----------------------------------------------------------------------------
+  void Cancel();
+
+  //----------------------------------------------------------------------------
+  //! Check if the stream was cancelled
+  //----------------------------------------------------------------------------
+  bool IsCancelled();
+
+  //----------------------------------------------------------------------------
+  //! Read output, blocks until some output is queued or the stream is closed
+  //!
+  //! @param buff buffer to fill
+  //! @param len size of the buffer
+  //!
+  //! @return number of bytes read, 0 at the end of the stream
+  //----------------------------------------------------------------------------
+  size_t Read(char* buff, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of bytes queued so far
+  //----------------------------------------------------------------------------
+  unsigned long long GetSize();
+
+protected:
+  //----------------------------------------------------------------------------
+  //! Queue the full chunk and start a new one
+  //----------------------------------------------------------------------------
+  int_type overflow(int_type ch) override;
+
+  //----------------------------------------------------------------------------
+  //! Queue the current chunk if a reader is waiting for output
+  //----------------------------------------------------------------------------
+  int sync() override;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Move the current chunk into the queue, blocks while the queue is full -
+  //! mMutex must be locked
+  //!
+  //! @return false if the stream was cancelled, otherwise true
+  //----------------------------------------------------------------------------
+  bool Push(std::unique_lock<std::mutex>& lock);
+
+  size_t mChunkSize; ///< size of the chunks
+  size_t mMaxQueued; ///< maximum number of queued bytes
+  std::vector<char> mChunk; ///< chunk being written, the put area
+  std::mutex mMutex; ///< protects the members below
+  std::condition_variable mCond; ///< signals changes of the queue
+  std::deque<std::string> mQueue; ///< chunks ready to be read
+  size_t mQueued; ///< number of bytes in the queue
+  size_t mOffset; ///< offset already read in the first queued chunk
+  unsigned long long mSize; ///< number of bytes queued so far
+  bool mOpen; ///< true if the stream is used
+  bool mClosed; ///< true if no more output is coming
+  bool mCancelled; ///< true if the output is not wanted any more
+  bool mReaderWaiting; ///< true while a reader waits for output
+};
+
+EOSMGMNAMESPACE_END
@@ -111,7 +111,9 @@ ProcCommand::Fs()
         XrdOucString dt = pOpaque->Get("mgm.dumpmd.storetime");
         size_t entries = 0;
         retc = proc_fs_dumpmd(fsidst, option, dp, df, ds, stdOut, stdErr,
-                              *pVid, entries);
+                              *pVid, entries, [this]() {
+          return FlushStdOut();
+        });
 
         if (!retc) {
           gOFS->MgmStats.Add("DumpMd", pVid->uid, pVid->gid, entries);
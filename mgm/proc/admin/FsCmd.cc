@@ -317,8 +317,18 @@ FsCmd::DumpMd(const eos::console::FsProto::DumpMdProto& dumpmdProto)
       }
     }
     std::string sfsid = std::to_string(dumpmdProto.fsid());
-    XrdOucString option = dumpmdProto.display() ==
-                          eos::console::FsProto::DumpMdProto::MONITOR ? "m" : "";
+    XrdOucString option = "";
+
+    if ((dumpmdProto.display() ==
+         eos::console::FsProto::DumpMdProto::COMPACT) ||
+        ((dumpmdProto.display() == eos::console::FsProto::DumpMdProto::MONITOR)
+         && dumpmdProto.compact())) {
+      option = "c";
+    } else if (dumpmdProto.display() ==
+               eos::console::FsProto::DumpMdProto::MONITOR) {
+      option = "m";
+    }
+
     XrdOucString dp = dumpmdProto.showpath() ? "1" : "0";
     XrdOucString df = dumpmdProto.showfid() ? "1" : "0";
     XrdOucString ds = dumpmdProto.showsize() ? "1" : "0";
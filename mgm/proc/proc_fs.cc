@@ -115,6 +115,60 @@ MvOpType get_operation_type(const std::string& in1, const std::string& in2,
   return MvOpType::UNKNOWN;
 }
 
+//------------------------------------------------------------------------------
+// Append the compact positional record of a file to the output
+//------------------------------------------------------------------------------
+static void
+AppendCompactRecord(const std::shared_ptr<eos::IFileMD>& fmd,
+                    XrdOucString& out)
+{
+  char line[256];
+  eos::IFileMD::ctime_t ctime;
+  eos::IFileMD::ctime_t mtime;
+  fmd->getCTime(ctime);
+  fmd->getMTime(mtime);
+  snprintf(line, sizeof(line), "%llu %llu %llu %llu %llu %llu %llu %u %u %u ",
+           (unsigned long long) fmd->getId(),
+           (unsigned long long) fmd->getContainerId(),
+           (unsigned long long) ctime.tv_sec, (unsigned long long) ctime.tv_nsec,
+           (unsigned long long) mtime.tv_sec, (unsigned long long) mtime.tv_nsec,
+           (unsigned long long) fmd->getSize(), (unsigned int) fmd->getLayoutId(),
+           (unsigned int) fmd->getCUid(), (unsigned int) fmd->getCGid());
+  out += line;
+  eos::Buffer xs = fmd->getChecksum();
+
+  if (xs.getSize()) {
+    for (size_t i = 0; i < xs.getSize(); ++i) {
+      snprintf(line, sizeof(line), "%02x",
+               *((unsigned char*)(xs.getDataPtr() + i)));
+      out += line;
+    }
+  } else {
+    out += "none";
+  }
+
+  out += " ";
+  bool has_loc = false;
+
+  for (const auto& loc : fmd->getLocations()) {
+    snprintf(line, sizeof(line), "%u,", loc);
+    out += line;
+    has_loc = true;
+  }
+
+  for (const auto& loc : fmd->getUnlinkedLocations()) {
+    snprintf(line, sizeof(line), "!%u,", loc);
+    out += line;
+    has_loc = true;
+  }
+
+  if (!has_loc) {
+    out += "-";
+  }
+
+  out += "\n";
+}
+
 //------------------------------------------------------------------------------
 // Dump metadata information
 //------------------------------------------------------------------------------
@@ -122,16 +176,22 @@ int
 proc_fs_dumpmd(std::string& fsidst, XrdOucString& option, XrdOucString& dp,
                XrdOucString& df, XrdOucString& ds, XrdOucString& stdOut,
                XrdOucString& stdErr,
-               eos::common::Mapping::VirtualIdentity& vid_in, size_t& entries)
+               eos::common::Mapping::VirtualIdentity& vid_in, size_t& entries,
+               const std::function<bool()>& flush)
 {
   entries = 0;
   int retc = 0;
+  bool stopped = false;
   bool dumppath = false;
   bool dumpfid = false;
   bool dumpsize = false;
   bool monitor = false;
+  bool compact = false;
 
-  if (option != "m") {
+  if (option == "c") {
+    monitor = true;
+    compact = true;
+  } else if (option != "m") {
     if (dp == "1") {
       dumppath = true;
     }
@@ -156,6 +216,10 @@ proc_fs_dumpmd(std::string& fsidst, XrdOucString& option, XrdOucString& dp,
     eos::common::RWMutexReadLock ns_rd_lock;
     ns_rd_lock.Grab(gOFS->eosViewRWMutex);
 
+    if (compact) {
+      stdOut += "#eos.dumpmd.compact v1\n";
+    }
+
     for (auto it_fid = gOFS->eosFsView->getFileList(fsid);
          (it_fid && it_fid->valid()); it_fid->next()) {
       try {
@@ -164,7 +228,9 @@ proc_fs_dumpmd(std::string& fsidst, XrdOucString& option, XrdOucString& dp,
         if (fmd) {
           entries++;
 
-          if ((!dumppath) && (!dumpfid) && (!dumpsize)) {
+          if (compact) {
+            AppendCompactRecord(fmd, stdOut);
+          } else if ((!dumppath) && (!dumpfid) && (!dumpsize)) {
             std::string env;
             fmd->getEnv(env, true);
             XrdOucString senv = env.c_str();
@@ -231,12 +297,19 @@ proc_fs_dumpmd(std::string& fsidst, XrdOucString& option, XrdOucString& dp,
       // Release the lock from time to time to let writers progress
       if (entries % 1024 == 0) {
         ns_rd_lock.Release();
+
+        // Hand out the output so far without holding the lock
+        if (flush && !flush()) {
+          stopped = true;
+          break;
+        }
+
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         ns_rd_lock.Grab(gOFS->eosViewRWMutex);
       }
     }
 
-    if (monitor) {
+    if (monitor && !stopped) {
       // Also add files which have yet to be unlinked
       for (auto it_fid = gOFS->eosFsView->getUnlinkedFileList(fsid);
            (it_fid && it_fid->valid()); it_fid->next()) {
@@ -245,16 +318,26 @@ proc_fs_dumpmd(std::string& fsidst, XrdOucString& option, XrdOucString& dp,
 
           if (fmd) {
             entries++;
-            std::string env;
-            fmd->getEnv(env, true);
-            XrdOucString senv = env.c_str();
-            senv.replace("checksum=&", "checksum=none&");
-            stdOut += senv.c_str();
-            stdOut += "&container=-\n";
+
+            if (compact) {
+              AppendCompactRecord(fmd, stdOut);
+            } else {
+              std::string env;
+              fmd->getEnv(env, true);
+              XrdOucString senv = env.c_str();
+              senv.replace("checksum=&", "checksum=none&");
+              stdOut += senv.c_str();
+              stdOut += "&container=-\n";
+            }
 
             // Release the lock from time to time to let writers progress
             if (entries % 1024 == 0) {
               ns_rd_lock.Release();
+
+              if (flush && !flush()) {
+                break;
+              }
+
               std::this_thread::sleep_for(std::chrono::milliseconds(100));
               ns_rd_lock.Grab(gOFS->eosViewRWMutex);
             }
@@ -30,6 +30,7 @@
 #include "mgm/FileSystem.hh"
 #include "mgm/FsView.hh"
 #include "XrdSec/XrdSecEntity.hh"
+#include <functional>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -52,11 +53,21 @@ enum class MvOpType {
 
 //------------------------------------------------------------------------------
 //! Dump metadata held on filesystem
+//!
+//! @note option "m" produces the monitoring env format, option "c" the
+//! compact positional format used by the FST bulk resync i.e. one line per
+//! file: "fid cid ctime ctime_ns mtime mtime_ns size lid uid gid xs locations"
+//! preceded by a header line "#eos.dumpmd.compact v1".
+//!
+//! @param flush if given, called without the namespace lock every 1024
+//!        entries e.g. to send the output collected in stdOut so far, the dump
+//!        stops if it returns false
 //------------------------------------------------------------------------------
 int proc_fs_dumpmd(std::string& fsidst, XrdOucString& option, XrdOucString& dp,
                    XrdOucString& df, XrdOucString& ds, XrdOucString& stdOut,
                    XrdOucString& stdErr, eos::common::Mapping::VirtualIdentity& vid_in,
-                   size_t& entries);
+                   size_t& entries,
+                   const std::function<bool()>& flush = nullptr);
 
 //------------------------------------------------------------------------------
 //! Dump metada held on filesystem
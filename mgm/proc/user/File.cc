@@ -29,6 +29,7 @@
 #include "mgm/Macros.hh"
 #include "mgm/Policy.hh"
 #include "mgm/Stat.hh"
+#include "mgm/Converter.hh"
 #include "common/Path.hh"
 #include "common/LayoutId.hh"
 #include "common/SecEntity.hh"
@@ -1117,8 +1118,7 @@ ProcCommand::File()
                   // we hand over as an conversion layout ID
                   snprintf(conversiontagfile,
                            sizeof(conversiontagfile) - 1,
-                           "%s/%016llx:%s#%s",
-                           gOFS->MgmProcConversionPath.c_str(),
+                           "%016llx:%s#%s",
                            fileid,
                            space.c_str(),
                            layout.c_str());
@@ -1158,8 +1158,7 @@ ProcCommand::File()
                                                    eos::common::LayoutId::GetRedundancyStripeNumber(layoutid));
                     snprintf(conversiontagfile,
                              sizeof(conversiontagfile) - 1,
-                             "%s/%016llx:%s#%08lx%s",
-                             gOFS->MgmProcConversionPath.c_str(),
+                             "%016llx:%s#%08lx%s",
                              fileid,
                              space.c_str(),
                              (unsigned long) layoutid,
@@ -1169,8 +1168,7 @@ ProcCommand::File()
                     // assume this is the name of an attribute
                     snprintf(conversiontagfile,
                              sizeof(conversiontagfile) - 1,
-                             "%s/%016llx:%s#%s%s",
-                             gOFS->MgmProcConversionPath.c_str(),
+                             "%016llx:%s#%s%s",
                              fileid,
                              space.c_str(),
                              layout.c_str(),
@@ -1179,14 +1177,11 @@ ProcCommand::File()
                   }
                 }
 
-                eos::common::Mapping::VirtualIdentity rootvid;
-                eos::common::Mapping::Root(rootvid);
-
-                if (gOFS->_touch(conversiontagfile, *mError, rootvid, 0)) {
+                if (!Converter::Schedule(conversiontagfile)) {
                   stdErr += "error: unable to create conversion job '";
                   stdErr += conversiontagfile;
                   stdErr += "'";
-                  retc = errno;
+                  retc = EIO;
                 } else {
                   stdOut += "success: created conversion job '";
                   stdOut += conversiontagfile;
@@ -42,9 +42,9 @@ eos::mgm::FindCmd::ProcessRequest()
 {
   eos::console::ReplyProto reply;
 
-  if (!OpenTemporaryOutputFiles()) {
+  if (!OpenStreamingOutput()) {
     std::ostringstream error;
-    error << "error: cannot write find result files on MGM" << std::endl;
+    error << "error: cannot stream find result on MGM" << std::endl;
     reply.set_retc(EIO);
     reply.set_std_err(error.str());
     return reply;
@@ -131,31 +131,8 @@ eos::mgm::FindCmd::ProcessRequest()
   schedulinggroupbalance.set_empty_key("");
   sizedistribution.set_empty_key(-1);
   sizedistributionn.set_empty_key(-1);
-  eos::common::Path cPath(spath.c_str());
-  bool deepquery = cPath.GetSubPathSize() < 5 && (!findRequest.directories() ||
-                   findRequest.files());
-  static eos::common::RWMutex deepQueryMutex;
-  static std::unique_ptr<std::map<std::string, std::set<std::string>>>
-  globalfound;
-  eos::common::RWMutexWriteLock deepQueryMutexGuard;
-  std::unique_ptr<std::map<std::string, std::set<std::string>>> localfound;
-  std::map<std::string, std::set<std::string>>* found = nullptr;
   XrdOucErrInfo errInfo;
 
-  if (deepquery) {
-    // we use a single once allocated map for deep searches to store the results to avoid memory explosion
-    deepQueryMutexGuard.Grab(deepQueryMutex);
-
-    if (!globalfound) {
-      globalfound.reset(new std::map<std::string, std::set<std::string>>());
-    }
-
-    found = globalfound.get();
-  } else {
-    localfound.reset(new std::map<std::string, std::set<std::string>>());
-    found = localfound.get();
-  }
-
   // check what <path> actually is ...
   XrdSfsFileExistence file_exists;
 
@@ -164,10 +141,6 @@ eos::mgm::FindCmd::ProcessRequest()
     error << "error: failed to run exists on '" << spath << "'";
     ofstderrStream << error.str();
 
-    if (deepquery) {
-      deepQueryMutexGuard.Release();
-    }
-
     reply.set_retc(errno);
     reply.set_std_err(error.str());
     return reply;
@@ -182,468 +155,448 @@ eos::mgm::FindCmd::ProcessRequest()
       error << "error: no such file or directory";
       ofstderrStream << error.str();
 
-      if (deepquery) {
-        deepQueryMutexGuard.Release();
-      }
-
       reply.set_retc(ENOENT);
       reply.set_std_err(error.str());
       return reply;
     }
   }
 
-  errInfo.clear();
-
-  if (gOFS->_find(spath.c_str(), errInfo, stdErr, mVid, (*found),
-                  attributekey.length() ? attributekey.c_str() : nullptr,
-                  attributevalue.length() ? attributevalue.c_str() : nullptr,
-                  nofiles, 0, true, finddepth,
-                  filematch.length() ? filematch.c_str() : nullptr)) {
-    std::ostringstream error;
-    error << stdErr;
-    error << "error: unable to run find in directory";
-    ofstderrStream << error.str();
-
-    if (deepquery) {
-      deepQueryMutexGuard.Release();
-    }
-
-    reply.set_retc(errno);
-    reply.set_std_err(error.str());
-    return reply;
-  } else {
-    if (stdErr.length()) {
-      ofstderrStream << stdErr;
-      reply.set_retc(E2BIG);
-    }
-  }
-
   unsigned int cnt = 0;
   unsigned long long filecounter = 0;
   unsigned long long dircounter = 0;
+  bool listfiles = (findRequest.files() || !dirs);
+  // Only the directories are kept for the directory listing below, files are
+  // handled while the find is running
+  std::set<std::string> founddirs;
+  auto process = [&](const std::string & founddir,
+  std::set<std::string>& foundfiles) {
+    if (dirs) {
+      founddirs.insert(founddir);
+    }
 
-  if (findRequest.files() || !dirs) {
-    for (auto& foundit : *found) {
-      if (!findRequest.files() && !nodirs) {
-        if (!printcounter) {
-          if (printxurl) {
-            ofstdoutStream << url;
-          }
+    if (!listfiles) {
+      return true;
+    }
 
-          ofstdoutStream << foundit.first << std::endl;
+    if (!findRequest.files() && !nodirs) {
+      if (!printcounter) {
+        if (printxurl) {
+          ofstdoutStream << url;
         }
 
-        dircounter++;
+        ofstdoutStream << founddir << std::endl;
       }
 
-      for (auto& fileit : foundit.second) {
-        cnt++;
-        std::string fspath = foundit.first;
-        fspath += fileit;
-
-        if (!calcbalance) {
-          //-------------------------------------------
-          eos::common::RWMutexReadLock eosViewMutexGuard;
-          eosViewMutexGuard.Grab(gOFS->eosViewRWMutex);
-          std::shared_ptr<eos::IFileMD> fmd;
+      dircounter++;
+    }
 
-          try {
-            bool selected = true;
-            fmd = gOFS->eosView->getFile(fspath);
-            eosViewMutexGuard.Release();
-            //-------------------------------------------
+    for (auto& fileit : foundfiles) {
+      cnt++;
+      std::string fspath = founddir;
+      fspath += fileit;
 
-            if (selectonehour) {
-              eos::IFileMD::ctime_t mtime;
-              fmd->getMTime(mtime);
+      if (!calcbalance) {
+        //-------------------------------------------
+        eos::common::RWMutexReadLock eosViewMutexGuard;
+        eosViewMutexGuard.Grab(gOFS->eosViewRWMutex);
+        std::shared_ptr<eos::IFileMD> fmd;
 
-              if (mtime.tv_sec > (time(nullptr) - 3600)) {
-                selected = false;
-              }
-            }
+        try {
+          bool selected = true;
+          fmd = gOFS->eosView->getFile(fspath);
+          eosViewMutexGuard.Release();
+          //-------------------------------------------
 
-            if (selectoldertime > 0) {
-              eos::IFileMD::ctime_t mtime;
-              fmd->getMTime(mtime);
+          if (selectonehour) {
+            eos::IFileMD::ctime_t mtime;
+            fmd->getMTime(mtime);
 
-              if (mtime.tv_sec > selectoldertime) {
-                selected = false;
-              }
+            if (mtime.tv_sec > (time(nullptr) - 3600)) {
+              selected = false;
             }
+          }
 
-            if (selectyoungertime > 0) {
-              eos::IFileMD::ctime_t mtime;
-              fmd->getMTime(mtime);
-
-              if (mtime.tv_sec < selectyoungertime) {
-                selected = false;
-              }
-            }
+          if (selectoldertime > 0) {
+            eos::IFileMD::ctime_t mtime;
+            fmd->getMTime(mtime);
 
-            if (searchuid && fmd->getCUid() != uid) {
+            if (mtime.tv_sec > selectoldertime) {
               selected = false;
             }
+          }
 
-            if (searchnotuid && fmd->getCUid() == notuid) {
-              selected = false;
-            }
+          if (selectyoungertime > 0) {
+            eos::IFileMD::ctime_t mtime;
+            fmd->getMTime(mtime);
 
-            if (searchgid && fmd->getCGid() != gid) {
+            if (mtime.tv_sec < selectyoungertime) {
               selected = false;
             }
+          }
 
-            if (searchnotgid && fmd->getCGid() == notgid) {
-              selected = false;
-            }
+          if (searchuid && fmd->getCUid() != uid) {
+            selected = false;
+          }
 
-            // Check attribute key-value filter
-            if (!attributekey.empty() && !attributevalue.empty()) {
-              XrdOucString attr;
-              errInfo.clear();
-              gOFS->_attr_get(fspath.c_str(), errInfo, mVid, nullptr,
-                              attributekey.c_str(), attr);
+          if (searchnotuid && fmd->getCUid() == notuid) {
+            selected = false;
+          }
 
-              if (attributevalue != std::string(attr.c_str())) {
-                selected = false;
-              }
-            }
+          if (searchgid && fmd->getCGid() != gid) {
+            selected = false;
+          }
 
-            if (findzero && fmd->getSize() != 0) {
+          if (searchnotgid && fmd->getCGid() == notgid) {
+            selected = false;
+          }
+
+          // Check attribute key-value filter
+          if (!attributekey.empty() && !attributevalue.empty()) {
+            XrdOucString attr;
+            errInfo.clear();
+            gOFS->_attr_get(fspath.c_str(), errInfo, mVid, nullptr,
+                            attributekey.c_str(), attr);
+
+            if (attributevalue != std::string(attr.c_str())) {
               selected = false;
             }
+          }
 
-            if (findgroupmix) {
-              // find files which have replicas on mixed scheduling groups
-              std::string sGroupRef = "";
-              std::string sGroup = "";
-              bool mixed = false;
-
-              for (auto lociter : fmd->getLocations()) {
-                // ignore filesystem id 0
-                if (!lociter) {
-                  eos_err("fsid 0 found fid=%lld", fmd->getId());
-                  continue;
-                }
+          if (findzero && fmd->getSize() != 0) {
+            selected = false;
+          }
 
-                eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-                eos::common::FileSystem* filesystem = nullptr;
+          if (findgroupmix) {
+            // find files which have replicas on mixed scheduling groups
+            std::string sGroupRef = "";
+            std::string sGroup = "";
+            bool mixed = false;
 
-                if (FsView::gFsView.mIdView.count(lociter)) {
-                  filesystem = FsView::gFsView.mIdView[lociter];
-                }
+            for (auto lociter : fmd->getLocations()) {
+              // ignore filesystem id 0
+              if (!lociter) {
+                eos_err("fsid 0 found fid=%lld", fmd->getId());
+                continue;
+              }
 
-                if (filesystem != nullptr) {
-                  sGroup = filesystem->GetString("schedgroup");
-                } else {
-                  sGroup = "none";
-                }
+              eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+              eos::common::FileSystem* filesystem = nullptr;
 
-                if (!sGroupRef.empty()) {
-                  if (sGroup != sGroupRef) {
-                    mixed = true;
-                    break;
-                  }
-                } else {
-                  sGroupRef = sGroup;
-                }
+              if (FsView::gFsView.mIdView.count(lociter)) {
+                filesystem = FsView::gFsView.mIdView[lociter];
               }
 
-              if (!mixed) {
-                selected = false;
+              if (filesystem != nullptr) {
+                sGroup = filesystem->GetString("schedgroup");
+              } else {
+                sGroup = "none";
+              }
+
+              if (!sGroupRef.empty()) {
+                if (sGroup != sGroupRef) {
+                  mixed = true;
+                  break;
+                }
+              } else {
+                sGroupRef = sGroup;
               }
             }
 
-            if (selectrepdiff &&
-                fmd->getNumLocation() == eos::common::LayoutId::GetStripeNumber(
-                  fmd->getLayoutId() + 1)) {
+            if (!mixed) {
               selected = false;
             }
+          }
 
-            // How to print, count, etc. when file is selected...
-            if (selected) {
-              bool printSimple = !(printsize || printfid || printuid || printgid ||
-                                   printchecksum || printfileinfo || printfs || printctime ||
-                                   printmtime || printrep || printunlink || printhosts ||
-                                   printpartition || selectrepdiff || purge_atomic || layoutstripes);
-
-              if (printSimple) {
-                if (!printcounter) {
-                  if (printxurl) {
-                    ofstdoutStream << url;
-                  }
+          if (selectrepdiff &&
+              fmd->getNumLocation() == eos::common::LayoutId::GetStripeNumber(
+                fmd->getLayoutId() + 1)) {
+            selected = false;
+          }
 
-                  ofstdoutStream << fspath << std::endl;
+          // How to print, count, etc. when file is selected...
+          if (selected) {
+            bool printSimple = !(printsize || printfid || printuid || printgid ||
+                                 printchecksum || printfileinfo || printfs || printctime ||
+                                 printmtime || printrep || printunlink || printhosts ||
+                                 printpartition || selectrepdiff || purge_atomic || layoutstripes);
+
+            if (printSimple) {
+              if (!printcounter) {
+                if (printxurl) {
+                  ofstdoutStream << url;
                 }
-              } else {
-                if (!purge_atomic && !layoutstripes) {
-                  if (!printfileinfo) {
-                    if (!printcounter) {
-                      ofstdoutStream << "path=";
 
-                      if (printxurl) {
-                        ofstdoutStream << url;
-                      }
+                ofstdoutStream << fspath << std::endl;
+              }
+            } else {
+              if (!purge_atomic && !layoutstripes) {
+                if (!printfileinfo) {
+                  if (!printcounter) {
+                    ofstdoutStream << "path=";
 
-                      ofstdoutStream << fspath;
+                    if (printxurl) {
+                      ofstdoutStream << url;
+                    }
 
-                      if (printsize) {
-                        ofstdoutStream << " size=" << fmd->getSize();
-                      }
+                    ofstdoutStream << fspath;
 
-                      if (printfid) {
-                        ofstdoutStream << " fid=" << fmd->getId();
-                      }
+                    if (printsize) {
+                      ofstdoutStream << " size=" << fmd->getSize();
+                    }
 
-                      if (printuid) {
-                        ofstdoutStream << " uid=" << fmd->getCUid();
-                      }
+                    if (printfid) {
+                      ofstdoutStream << " fid=" << fmd->getId();
+                    }
 
-                      if (printgid) {
-                        ofstdoutStream << " gid=" << fmd->getCGid();
-                      }
+                    if (printuid) {
+                      ofstdoutStream << " uid=" << fmd->getCUid();
+                    }
 
-                      if (printfs) {
-                        ofstdoutStream << " fsid=";
-                        eos::IFileMD::LocationVector loc_vect = fmd->getLocations();
-                        eos::IFileMD::LocationVector::const_iterator lociter;
+                    if (printgid) {
+                      ofstdoutStream << " gid=" << fmd->getCGid();
+                    }
 
-                        for (lociter = loc_vect.begin(); lociter != loc_vect.end(); ++lociter) {
-                          if (lociter != loc_vect.begin()) {
-                            ofstdoutStream << ',';
-                          }
+                    if (printfs) {
+                      ofstdoutStream << " fsid=";
+                      eos::IFileMD::LocationVector loc_vect = fmd->getLocations();
+                      eos::IFileMD::LocationVector::const_iterator lociter;
 
-                          ofstdoutStream << *lociter;
+                      for (lociter = loc_vect.begin(); lociter != loc_vect.end(); ++lociter) {
+                        if (lociter != loc_vect.begin()) {
+                          ofstdoutStream << ',';
                         }
+
+                        ofstdoutStream << *lociter;
                       }
+                    }
 
-                      if (printpartition) {
-                        ofstdoutStream << " partition=";
-                        std::set<std::string> fsPartition;
+                    if (printpartition) {
+                      ofstdoutStream << " partition=";
+                      std::set<std::string> fsPartition;
 
-                        for (auto lociter : fmd->getLocations()) {
-                          // get host name for fs id
-                          eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-                          eos::common::FileSystem* filesystem = nullptr;
+                      for (auto lociter : fmd->getLocations()) {
+                        // get host name for fs id
+                        eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+                        eos::common::FileSystem* filesystem = nullptr;
 
-                          if (FsView::gFsView.mIdView.count(lociter)) {
-                            filesystem = FsView::gFsView.mIdView[lociter];
-                          }
+                        if (FsView::gFsView.mIdView.count(lociter)) {
+                          filesystem = FsView::gFsView.mIdView[lociter];
+                        }
 
-                          if (filesystem != nullptr) {
-                            eos::common::FileSystem::fs_snapshot_t fs;
+                        if (filesystem != nullptr) {
+                          eos::common::FileSystem::fs_snapshot_t fs;
 
-                            if (filesystem->SnapShotFileSystem(fs, true)) {
-                              std::string partition = fs.mHost;
-                              partition += ":";
-                              partition += fs.mPath;
+                          if (filesystem->SnapShotFileSystem(fs, true)) {
+                            std::string partition = fs.mHost;
+                            partition += ":";
+                            partition += fs.mPath;
 
-                              if ((!selectonline) ||
-                                  (filesystem->GetActiveStatus(true) == eos::common::FileSystem::kOnline)) {
-                                fsPartition.insert(partition);
-                              }
+                            if ((!selectonline) ||
+                                (filesystem->GetActiveStatus(true) == eos::common::FileSystem::kOnline)) {
+                              fsPartition.insert(partition);
                             }
                           }
                         }
+                      }
 
-                        for (auto partitionit = fsPartition.begin(); partitionit != fsPartition.end();
-                             partitionit++) {
-                          if (partitionit != fsPartition.begin()) {
-                            ofstdoutStream << ',';
-                          }
-
-                          ofstdoutStream << partitionit->c_str();
+                      for (auto partitionit = fsPartition.begin(); partitionit != fsPartition.end();
+                           partitionit++) {
+                        if (partitionit != fsPartition.begin()) {
+                          ofstdoutStream << ',';
                         }
+
+                        ofstdoutStream << partitionit->c_str();
                       }
+                    }
 
-                      if (printhosts) {
-                        ofstdoutStream << " hosts=";
-                        std::set<std::string> fsHosts;
+                    if (printhosts) {
+                      ofstdoutStream << " hosts=";
+                      std::set<std::string> fsHosts;
 
-                        for (auto lociter : fmd->getLocations()) {
-                          // get host name for fs id
-                          eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-                          eos::common::FileSystem* filesystem = nullptr;
+                      for (auto lociter : fmd->getLocations()) {
+                        // get host name for fs id
+                        eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+                        eos::common::FileSystem* filesystem = nullptr;
 
-                          if (FsView::gFsView.mIdView.count(lociter)) {
-                            filesystem = FsView::gFsView.mIdView[lociter];
-                          }
+                        if (FsView::gFsView.mIdView.count(lociter)) {
+                          filesystem = FsView::gFsView.mIdView[lociter];
+                        }
 
-                          if (filesystem != nullptr) {
-                            eos::common::FileSystem::fs_snapshot_t fs;
+                        if (filesystem != nullptr) {
+                          eos::common::FileSystem::fs_snapshot_t fs;
 
-                            if (filesystem->SnapShotFileSystem(fs, true)) {
-                              fsHosts.insert(fs.mHost);
-                            }
+                          if (filesystem->SnapShotFileSystem(fs, true)) {
+                            fsHosts.insert(fs.mHost);
                           }
                         }
+                      }
 
-                        for (auto hostit = fsHosts.begin(); hostit != fsHosts.end(); hostit++) {
-                          if (hostit != fsHosts.begin()) {
-                            ofstdoutStream << ',';
-                          }
-
-                          ofstdoutStream << hostit->c_str();
+                      for (auto hostit = fsHosts.begin(); hostit != fsHosts.end(); hostit++) {
+                        if (hostit != fsHosts.begin()) {
+                          ofstdoutStream << ',';
                         }
+
+                        ofstdoutStream << hostit->c_str();
                       }
+                    }
 
-                      if (printchecksum) {
-                        ofstdoutStream << " checksum=";
+                    if (printchecksum) {
+                      ofstdoutStream << " checksum=";
 
-                        for (unsigned int i = 0;
-                             i < eos::common::LayoutId::GetChecksumLen(fmd->getLayoutId()); i++) {
-                          ofstdoutStream << std::right << setfill('0') << std::setw(2)
-                                         << (unsigned char)(fmd->getChecksum().getDataPadded(i));
-                        }
+                      for (unsigned int i = 0;
+                           i < eos::common::LayoutId::GetChecksumLen(fmd->getLayoutId()); i++) {
+                        ofstdoutStream << std::right << setfill('0') << std::setw(2)
+                                       << (unsigned char)(fmd->getChecksum().getDataPadded(i));
                       }
+                    }
 
-                      if (printctime) {
-                        eos::IFileMD::ctime_t ctime;
-                        fmd->getCTime(ctime);
-                        ofstdoutStream << " ctime=" << (unsigned long long) ctime.tv_sec;
-                        ofstdoutStream << '.' << (unsigned long long) ctime.tv_nsec;
-                      }
+                    if (printctime) {
+                      eos::IFileMD::ctime_t ctime;
+                      fmd->getCTime(ctime);
+                      ofstdoutStream << " ctime=" << (unsigned long long) ctime.tv_sec;
+                      ofstdoutStream << '.' << (unsigned long long) ctime.tv_nsec;
+                    }
 
-                      if (printmtime) {
-                        eos::IFileMD::ctime_t mtime;
-                        fmd->getMTime(mtime);
-                        ofstdoutStream << " mtime=" << (unsigned long long) mtime.tv_sec;
-                        ofstdoutStream << '.' << (unsigned long long) mtime.tv_nsec;
-                      }
+                    if (printmtime) {
+                      eos::IFileMD::ctime_t mtime;
+                      fmd->getMTime(mtime);
+                      ofstdoutStream << " mtime=" << (unsigned long long) mtime.tv_sec;
+                      ofstdoutStream << '.' << (unsigned long long) mtime.tv_nsec;
+                    }
 
-                      if (printrep) {
-                        ofstdoutStream << " nrep=" << fmd->getNumLocation();
-                      }
+                    if (printrep) {
+                      ofstdoutStream << " nrep=" << fmd->getNumLocation();
+                    }
 
-                      if (printunlink) {
-                        ofstdoutStream << " nunlink=" << fmd->getNumUnlinkedLocation();
-                      }
+                    if (printunlink) {
+                      ofstdoutStream << " nunlink=" << fmd->getNumUnlinkedLocation();
                     }
-                  } else {
-                    // print fileinfo -m
-                    this->PrintFileInfoMinusM(fspath, errInfo);
                   }
+                } else {
+                  // print fileinfo -m
+                  this->PrintFileInfoMinusM(fspath, errInfo);
+                }
 
-                  if (!printcounter) {
-                    ofstdoutStream << std::endl;
-                  }
+                if (!printcounter) {
+                  ofstdoutStream << std::endl;
                 }
+              }
 
-                // Do the purge if needed
-                if (purge_atomic &&
-                    fspath.find(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) != std::string::npos) {
-                  ofstdoutStream << "# found atomic " << fspath << std::endl;
-                  struct stat buf;
+              // Do the purge if needed
+              if (purge_atomic &&
+                  fspath.find(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) != std::string::npos) {
+                ofstdoutStream << "# found atomic " << fspath << std::endl;
+                struct stat buf;
 
-                  if ((!gOFS->_stat(fspath.c_str(), &buf, errInfo, mVid, (const char*) nullptr,
-                                    nullptr)) &&
-                      ((mVid.uid == 0) || (mVid.uid == buf.st_uid))) {
-                    time_t now = time(nullptr);
+                if ((!gOFS->_stat(fspath.c_str(), &buf, errInfo, mVid, (const char*) nullptr,
+                                  nullptr)) &&
+                    ((mVid.uid == 0) || (mVid.uid == buf.st_uid))) {
+                  time_t now = time(nullptr);
 
-                    if ((now - buf.st_ctime) > 86400) {
-                      if (!gOFS->_rem(fspath.c_str(), errInfo, mVid, (const char*) nullptr)) {
-                        ofstdoutStream << "# purging atomic " << fspath;
-                      }
-                    } else {
-                      ofstdoutStream << "# skipping atomic " << fspath << " [< 1d old ]" << std::endl;
+                  if ((now - buf.st_ctime) > 86400) {
+                    if (!gOFS->_rem(fspath.c_str(), errInfo, mVid, (const char*) nullptr)) {
+                      ofstdoutStream << "# purging atomic " << fspath;
                     }
+                  } else {
+                    ofstdoutStream << "# skipping atomic " << fspath << " [< 1d old ]" << std::endl;
                   }
                 }
+              }
 
-                // Add layout stripes if needed
-                if (layoutstripes) {
-                  ProcCommand fileCmd;
-                  std::string info = "mgm.cmd=file&mgm.subcmd=layout&mgm.path=";
-                  info += fspath;
-                  info += "&mgm.file.layout.stripes=";
-                  info += std::to_string(stripes);
-
-                  if (fileCmd.open("/proc/user", info.c_str(), mVid, &errInfo) == 0) {
-                    std::ostringstream outputStream;
-                    XrdSfsFileOffset offset = 0;
-                    constexpr uint32_t size = 512;
-                    auto bytesRead = 0ul;
-                    char buffer[size];
-
-                    do {
-                      bytesRead = fileCmd.read(offset, buffer, size);
-
-                      for (auto i = 0u; i < bytesRead; i++) {
-                        outputStream << buffer[i];
-                      }
+              // Add layout stripes if needed
+              if (layoutstripes) {
+                ProcCommand fileCmd;
+                std::string info = "mgm.cmd=file&mgm.subcmd=layout&mgm.path=";
+                info += fspath;
+                info += "&mgm.file.layout.stripes=";
+                info += std::to_string(stripes);
+
+                if (fileCmd.open("/proc/user", info.c_str(), mVid, &errInfo) == 0) {
+                  std::ostringstream outputStream;
+                  XrdSfsFileOffset offset = 0;
+                  constexpr uint32_t size = 512;
+                  auto bytesRead = 0ul;
+                  char buffer[size];
+
+                  do {
+                    bytesRead = fileCmd.read(offset, buffer, size);
+
+                    for (auto i = 0u; i < bytesRead; i++) {
+                      outputStream << buffer[i];
+                    }
 
-                      offset += bytesRead;
-                    } while (bytesRead == size);
+                    offset += bytesRead;
+                  } while (bytesRead == size);
 
-                    fileCmd.close();
-                    XrdOucEnv env(outputStream.str().c_str());
+                  fileCmd.close();
+                  XrdOucEnv env(outputStream.str().c_str());
 
-                    if (std::stoi(env.Get("mgm.proc.retc")) == 0) {
-                      if (!silent) {
-                        ofstdoutStream << env.Get("mgm.proc.stdout") << std::endl;
-                      }
-                    } else {
-                      ofstderrStream << env.Get("mgm.proc.stderr") << std::endl;
+                  if (std::stoi(env.Get("mgm.proc.retc")) == 0) {
+                    if (!silent) {
+                      ofstdoutStream << env.Get("mgm.proc.stdout") << std::endl;
                     }
+                  } else {
+                    ofstderrStream << env.Get("mgm.proc.stderr") << std::endl;
                   }
                 }
               }
-
-              filecounter++;
             }
-          } catch (eos::MDException& e) {
-            eos_debug("caught exception %d %s\n", e.getErrno(),
-                      e.getMessage().str().c_str());
-            eosViewMutexGuard.Release();
-            //-------------------------------------------
-          }
-        } else {
-          // get location
-          //-------------------------------------------
-          eos::common::RWMutexReadLock eosViewMutexGuard;
-          eosViewMutexGuard.Grab(gOFS->eosViewRWMutex);
-          std::shared_ptr<eos::IFileMD> fmd;
 
-          try {
-            fmd = gOFS->eosView->getFile(fspath);
-          } catch (eos::MDException& e) {
-            eos_debug("caught exception %d %s\n", e.getErrno(),
-                      e.getMessage().str().c_str());
+            filecounter++;
           }
-
+        } catch (eos::MDException& e) {
+          eos_debug("caught exception %d %s\n", e.getErrno(),
+                    e.getMessage().str().c_str());
           eosViewMutexGuard.Release();
+          //-------------------------------------------
+        }
+      } else {
+        // get location
+        //-------------------------------------------
+        eos::common::RWMutexReadLock eosViewMutexGuard;
+        eosViewMutexGuard.Grab(gOFS->eosViewRWMutex);
+        std::shared_ptr<eos::IFileMD> fmd;
+
+        try {
+          fmd = gOFS->eosView->getFile(fspath);
+        } catch (eos::MDException& e) {
+          eos_debug("caught exception %d %s\n", e.getErrno(),
+                    e.getMessage().str().c_str());
+        }
 
-          if (fmd) {
-            for (unsigned int i = 0; i < fmd->getNumLocation(); i++) {
-              auto loc = fmd->getLocation(i);
-              size_t size = fmd->getSize();
+        eosViewMutexGuard.Release();
 
-              if (!loc) {
-                eos_err("fsid 0 found %s %llu", fmd->getName().c_str(), fmd->getId());
-                continue;
-              }
+        if (fmd) {
+          for (unsigned int i = 0; i < fmd->getNumLocation(); i++) {
+            auto loc = fmd->getLocation(i);
+            size_t size = fmd->getSize();
 
-              filesystembalance[loc] += size;
+            if (!loc) {
+              eos_err("fsid 0 found %s %llu", fmd->getName().c_str(), fmd->getId());
+              continue;
+            }
 
-              if ((i == 0) && (size)) {
-                auto bin = (int) log10((double) size);
-                sizedistribution[ bin ] += size;
-                sizedistributionn[ bin ]++;
-              }
+            filesystembalance[loc] += size;
 
-              eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
-              eos::common::FileSystem* filesystem = nullptr;
+            if ((i == 0) && (size)) {
+              auto bin = (int) log10((double) size);
+              sizedistribution[ bin ] += size;
+              sizedistributionn[ bin ]++;
+            }
 
-              if (FsView::gFsView.mIdView.count(loc)) {
-                filesystem = FsView::gFsView.mIdView[loc];
-              }
+            eos::common::RWMutexReadLock lock(FsView::gFsView.ViewMutex);
+            eos::common::FileSystem* filesystem = nullptr;
 
-              if (filesystem != nullptr) {
-                eos::common::FileSystem::fs_snapshot_t fs;
+            if (FsView::gFsView.mIdView.count(loc)) {
+              filesystem = FsView::gFsView.mIdView[loc];
+            }
 
-                if (filesystem->SnapShotFileSystem(fs, true)) {
-                  spacebalance[fs.mSpace] += size;
-                  schedulinggroupbalance[fs.mGroup] += size;
-                }
+            if (filesystem != nullptr) {
+              eos::common::FileSystem::fs_snapshot_t fs;
+
+              if (filesystem->SnapShotFileSystem(fs, true)) {
+                spacebalance[fs.mSpace] += size;
+                schedulinggroupbalance[fs.mGroup] += size;
               }
             }
           }
@@ -651,13 +604,40 @@ eos::mgm::FindCmd::ProcessRequest()
       }
     }
 
+    // Stop the find if the client is gone
+    return (!mForceKill && ofstdoutStream);
+  };
+
+  errInfo.clear();
+
+  if (gOFS->_find(spath.c_str(), errInfo, stdErr, mVid, process,
+                  attributekey.length() ? attributekey.c_str() : nullptr,
+                  attributevalue.length() ? attributevalue.c_str() : nullptr,
+                  nofiles, 0, true, finddepth,
+                  filematch.length() ? filematch.c_str() : nullptr)) {
+    std::ostringstream error;
+    error << stdErr;
+    error << "error: unable to run find in directory";
+    ofstderrStream << error.str();
+
+    reply.set_retc(errno);
+    reply.set_std_err(error.str());
+    return reply;
+  } else {
+    if (stdErr.length()) {
+      ofstderrStream << stdErr;
+      reply.set_retc(E2BIG);
+    }
+  }
+
+  if (listfiles) {
     gOFS->MgmStats.Add("FindEntries", mVid.uid, mVid.gid, cnt);
   }
 
   eos_debug("Listing directories");
 
   if (dirs) {
-    for (auto& foundit : *found) {
+    for (auto& founddir : founddirs) {
       // Filtering the directories
       bool selected = true;
       eos::common::RWMutexReadLock eosViewMutexGuard;
@@ -665,7 +645,7 @@ eos::mgm::FindCmd::ProcessRequest()
       std::shared_ptr<eos::IContainerMD> mCmd;
 
       try {
-        mCmd = gOFS->eosView->getContainer(foundit.first);
+        mCmd = gOFS->eosView->getContainer(founddir);
         eosViewMutexGuard.Release();
       } catch (eos::MDException& e) {
         eos_debug("caught exception %d %s\n", e.getErrno(),
@@ -692,7 +672,7 @@ eos::mgm::FindCmd::ProcessRequest()
       if (searchpermission || searchnotpermission) {
         struct stat buf;
 
-        if (gOFS->_stat(foundit.first.c_str(), &buf, errInfo, mVid, nullptr,
+        if (gOFS->_stat(founddir.c_str(), &buf, errInfo, mVid, nullptr,
                         nullptr) == 0) {
           std::ostringstream flagOstr;
           flagOstr << std::oct << buf.st_mode;
@@ -715,7 +695,7 @@ eos::mgm::FindCmd::ProcessRequest()
         // get the attributes and call the verify function
         eos::IContainerMD::XAttrMap map;
 
-        if (!gOFS->_attr_ls(foundit.first.c_str(), errInfo,
+        if (!gOFS->_attr_ls(founddir.c_str(), errInfo,
                             mVid, nullptr, map)) {
           if ((map.count("sys.acl") || map.count("user.acl"))) {
             if (map.count("sys.acl")) {
@@ -737,14 +717,14 @@ eos::mgm::FindCmd::ProcessRequest()
 
       // eventually call the version purge function if we own this version dir or we are root
       if (selected && purge &&
-          (foundit.first.find(EOS_COMMON_PATH_VERSION_PREFIX) != std::string::npos)) {
+          (founddir.find(EOS_COMMON_PATH_VERSION_PREFIX) != std::string::npos)) {
         struct stat buf;
 
-        if ((!gOFS->_stat(foundit.first.c_str(), &buf, errInfo, mVid, nullptr,
+        if ((!gOFS->_stat(founddir.c_str(), &buf, errInfo, mVid, nullptr,
                           nullptr)) &&
             ((mVid.uid == 0) || (mVid.uid == buf.st_uid))) {
-          ofstdoutStream << "# purging " << foundit.first;
-          gOFS->PurgeVersion(foundit.first.c_str(), errInfo, max_version);
+          ofstdoutStream << "# purging " << founddir;
+          gOFS->PurgeVersion(founddir.c_str(), errInfo, max_version);
         }
       }
 
@@ -755,24 +735,32 @@ eos::mgm::FindCmd::ProcessRequest()
           std::shared_ptr<eos::IContainerMD> mCmd;
           unsigned long long childfiles = 0;
           unsigned long long childdirs = 0;
+          bool found = false;
 
           try {
-            mCmd = gOFS->eosView->getContainer(foundit.first);
+            mCmd = gOFS->eosView->getContainer(founddir);
             childfiles = mCmd->getNumFiles();
             childdirs = mCmd->getNumContainers();
-            ofstdoutStream << foundit.first << " ndir=" << childdirs << " nfiles=" <<
-                           childfiles << std::endl;
+            found = true;
           } catch (eos::MDException& e) {
             eos_debug("caught exception %d %s\n", e.getErrno(),
                       e.getMessage().str().c_str());
           }
+
+          // Don't write to the client while holding the namespace lock
+          nLock.Release();
+
+          if (found) {
+            ofstdoutStream << founddir << " ndir=" << childdirs << " nfiles=" <<
+                           childfiles << std::endl;
+          }
         } else {
           if (!printfileinfo) {
             // print directories
             XrdOucString attr = "";
 
             if (!printkey.empty()) {
-              gOFS->_attr_get(foundit.first.c_str(), errInfo, mVid, nullptr,
+              gOFS->_attr_get(founddir.c_str(), errInfo, mVid, nullptr,
                               printkey.c_str(), attr);
 
               if (!printkey.empty()) {
@@ -791,30 +779,39 @@ eos::mgm::FindCmd::ProcessRequest()
               ofstdoutStream << url;
             }
 
-            ofstdoutStream << foundit.first;
+            ofstdoutStream << founddir;
 
             if (printuid || printgid) {
               eos::common::RWMutexReadLock nLock(gOFS->eosViewRWMutex);
               std::shared_ptr<eos::IContainerMD> mCmd;
+              bool found = false;
+              uid_t cuid = 0;
+              gid_t cgid = 0;
 
               try {
-                mCmd = gOFS->eosView->getContainer(foundit.first.c_str());
-
-                if (printuid) {
-                  ofstdoutStream << " uid=" << mCmd->getCUid();
-                }
-
-                if (printgid) {
-                  ofstdoutStream << " gid=" << mCmd->getCGid();
-                }
+                mCmd = gOFS->eosView->getContainer(founddir.c_str());
+                cuid = mCmd->getCUid();
+                cgid = mCmd->getCGid();
+                found = true;
               } catch (eos::MDException& e) {
                 eos_debug("caught exception %d %s\n", e.getErrno(),
                           e.getMessage().str().c_str());
               }
+
+              // Don't write to the client while holding the namespace lock
+              nLock.Release();
+
+              if (found && printuid) {
+                ofstdoutStream << " uid=" << cuid;
+              }
+
+              if (found && printgid) {
+                ofstdoutStream << " gid=" << cgid;
+              }
             }
           } else {
             // print fileinfo -m
-            this->PrintFileInfoMinusM(foundit.first, errInfo);
+            this->PrintFileInfoMinusM(founddir, errInfo);
           }
 
           ofstdoutStream << std::endl;
@@ -827,11 +824,6 @@ eos::mgm::FindCmd::ProcessRequest()
     }
   }
 
-  if (deepquery) {
-    globalfound->clear();
-    deepQueryMutexGuard.Release();
-  }
-
   if (printcounter) {
     ofstdoutStream << "nfiles=" << filecounter << " ndirectories=" << dircounter <<
                    std::endl;
@@ -902,9 +894,9 @@ eos::mgm::FindCmd::ProcessRequest()
     }
   }
 
-  if (!CloseTemporaryOutputFiles()) {
+  if (!CloseStreamingOutput()) {
     std::ostringstream error;
-    error << "error: cannot save find result files on MGM" << std::endl;
+    error << "error: find result stream was cancelled" << std::endl;
     reply.set_retc(EIO);
     reply.set_std_err(error.str());
     return reply;
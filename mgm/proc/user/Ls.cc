@@ -323,6 +323,12 @@ ProcCommand::Ls()
             // this was a single file to be listed
             break;
           }
+
+          // Hand out the listing while reading the directory if the client
+          // gets it streamed
+          if (!FlushStdOut()) {
+            break;
+          }
         }
 
         if (!ls_file.length()) {
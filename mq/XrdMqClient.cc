@@ -33,6 +33,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <chrono>
 
 /******************************************************************************/
 /*                        X r d M q C l i e n t                               */
@@ -63,6 +64,7 @@ XrdMqClient::XrdMqClient(const char* clientid, const char* brokerurl,
   kMessageBuffer = "";
   kRecvBuffer = nullptr;
   kRecvBufferAlloc = 0;
+  kLongPollWaited = false;
   // Install sigbus signal handler
   struct sigaction act;
   memset(&act, 0, sizeof(act));
@@ -411,6 +413,8 @@ XrdMqClient::RecvMessage()
     }
 
     XrdCl::StatInfo* stinfo = 0;
+    auto start = std::chrono::steady_clock::now();
+    kLongPollWaited = false;
 
     while (!file->Stat(true, stinfo).IsOK()) {
       ReNewBrokerXrdClientReceiver(0);
@@ -421,6 +425,10 @@ XrdMqClient::RecvMessage()
     }
 
     if (!stinfo->GetSize()) {
+      // A broker doing long-poll answers empty only once the poll expired
+      kLongPollWaited = ((std::chrono::steady_clock::now() - start) >=
+                         std::chrono::seconds(1));
+      delete stinfo;
       return 0;
     }
 
@@ -535,7 +543,8 @@ bool
 XrdMqClient::AddBroker(const char* brokerurl,
                        bool advisorystatus,
                        bool advisoryquery,
-                       bool advisoryflushbacklog)
+                       bool advisoryflushbacklog,
+                       int longpoll)
 {
   if (!brokerurl) {
     return false;
@@ -560,6 +569,14 @@ XrdMqClient::AddBroker(const char* brokerurl,
   newBrokerUrl += XMQCADVISORYFLUSHBACKLOG;
   newBrokerUrl += "=";
   newBrokerUrl += advisoryflushbacklog;
+
+  if (longpoll > 0) {
+    newBrokerUrl += "&";
+    newBrokerUrl += XMQCLONGPOLL;
+    newBrokerUrl += "=";
+    newBrokerUrl += longpoll;
+  }
+
   printf("==> new Broker %s\n", newBrokerUrl.c_str());
 
   for (int i = 0; i < kBrokerN; i++) {
@@ -139,6 +139,15 @@ class XrdMqClient
 
   XrdMqMessage* RecvMessage();
 
+  //----------------------------------------------------------------------------
+  //! Check if the last RecvMessage without result already waited on the
+  //! broker for messages, in which case the caller can poll again right away
+  //----------------------------------------------------------------------------
+  inline bool LongPollWaited() const
+  {
+    return kLongPollWaited;
+  }
+
   XrdOucString* GetBrokerUrl(int i, XrdOucString& rhostport);
 
   XrdOucString GetBrokerId(int i);
@@ -153,8 +162,15 @@ class XrdMqClient
 
   void CheckBrokerXrdClientReceiver(int i);
 
+  //----------------------------------------------------------------------------
+  //! Add a broker
+  //!
+  //! @param longpoll seconds the broker waits for messages when the receiver
+  //!        queue is empty, 0 to answer right away
+  //----------------------------------------------------------------------------
   bool AddBroker(const char* brokerurl, bool advisorystatus = false,
-                 bool advisoryquery = false, bool advisoryflushbacklog = false);
+                 bool advisoryquery = false, bool advisoryflushbacklog = false,
+                 int longpoll = 0);
 
   void Disconnect();
 
@@ -223,6 +239,7 @@ class XrdMqClient
   int kRecvBufferAlloc;
   size_t kInternalBufferPosition;
   bool kInitOK;
+  bool kLongPollWaited; ///< Last empty receive waited on the broker
 };
 
 
@@ -39,6 +39,9 @@
 #define XMQCADVISORYSTATUS       "xmqclient.advisory.status"
 #define XMQCADVISORYQUERY        "xmqclient.advisory.query"
 #define XMQCADVISORYFLUSHBACKLOG "xmqclient.advisory.flushbacklog"
+#define XMQCLONGPOLL             "xmqclient.longpoll"
+// seconds the listeners ask the broker to wait for messages in a stat
+#define XMQCLONGPOLLTIME 5
 #define XMQCIPHER EVP_des_cbc
 
 //------------------------------------------------------------------------------
@@ -57,7 +57,7 @@ XrdMqMessaging::Listen()
 
     if (newmessage) {
       delete newmessage;
-    } else {
+    } else if (!gMessageClient.LongPollWaited()) {
       XrdSysTimer sleeper;
       sleeper.Wait(1000);
     }
@@ -74,7 +74,8 @@ XrdMqMessaging::XrdMqMessaging(const char* url,
                                XrdMqSharedObjectManager* som):
   tid(0)
 {
-  if (gMessageClient.AddBroker(url, advisorystatus, advisoryquery)) {
+  if (gMessageClient.AddBroker(url, advisorystatus, advisoryquery, false,
+                               XMQCLONGPOLLTIME)) {
     zombie = false;
   } else {
     zombie = true;
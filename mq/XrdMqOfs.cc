@@ -91,14 +91,41 @@ STRINGSTORE(const char* __charptr__)
   }
 }
 
-XrdMqOfsOutMutex::XrdMqOfsOutMutex()
+XrdMqOfsOutMutex::XrdMqOfsOutMutex(const std::string& queue)
 {
-  gMqFS->QueueOutMutex.Lock();
+  mShard = &gMqFS->GetQueueShard(queue);
+  mShard->Mutex.LockWrite();
 }
 
 XrdMqOfsOutMutex::~XrdMqOfsOutMutex()
 {
-  gMqFS->QueueOutMutex.UnLock();
+  mShard->Mutex.UnLockWrite();
+}
+
+XrdMqOfsOutReadLock::XrdMqOfsOutReadLock(const char* queue)
+{
+  if (queue) {
+    mShard = &gMqFS->GetQueueShard(queue);
+    mShard->Mutex.LockRead();
+  } else {
+    // always the same order, several shards are only ever read locked
+    mShard = 0;
+
+    for (int i = 0; i < MQOFSQUEUESHARDS; ++i) {
+      gMqFS->QueueOut[i].Mutex.LockRead();
+    }
+  }
+}
+
+XrdMqOfsOutReadLock::~XrdMqOfsOutReadLock()
+{
+  if (mShard) {
+    mShard->Mutex.UnLockRead();
+  } else {
+    for (int i = MQOFSQUEUESHARDS - 1; i >= 0; --i) {
+      gMqFS->QueueOut[i].Mutex.UnLockRead();
+    }
+  }
 }
 
 /******************************************************************************/
@@ -121,11 +148,13 @@ XrdMqOfs::XrdMqOfs(XrdSysError* ep):
   MaxMessageBacklog  = MQOFSMAXMESSAGEBACKLOG;
   MaxQueueBacklog    = MQOFSMAXQUEUEBACKLOG;
   RejectQueueBacklog = MQOFSREJECTQUEUEBACKLOG;
+  MaxLongPollers     = MQOFSMAXLONGPOLLERS;
+  LongPollers = 0;
   (void) signal(SIGINT, xrdmqofs_shutdown);
   HostName = 0;
   HostPref = 0;
-  fprintf(stderr, "Addr::QueueOutMutex        0x%llx\n",
-          (unsigned long long) &gMqFS->QueueOutMutex);
+  fprintf(stderr, "Addr::QueueOut             0x%llx\n",
+          (unsigned long long) gMqFS->QueueOut);
   fprintf(stderr, "Addr::MessageMutex         0x%llx\n",
           (unsigned long long) &gMqFS->MessagesMutex);
 }
@@ -140,6 +169,21 @@ XrdMqOfs::Init(XrdSysError& ep)
   return true;
 }
 
+/******************************************************************************/
+/*                           N u m Q u e u e s                                */
+/******************************************************************************/
+size_t
+XrdMqOfs::NumQueues()
+{
+  size_t nqueues = 0;
+
+  for (int i = 0; i < MQOFSQUEUESHARDS; ++i) {
+    nqueues += QueueOut[i].Queues.Size();
+  }
+
+  return nqueues;
+}
+
 
 /******************************************************************************/
 /*                         G e t F i l e S y s t e m                          */
@@ -274,9 +318,9 @@ XrdMqOfs::stat(const char*                queuename,
   ZTRACE(stat, "stat by buf: " << queuename);
   std::string squeue = queuename;
   {
-    XrdMqOfsOutMutex qm;
+    XrdMqOfsOutReadLock qm(queuename);
 
-    if ((!gMqFS->QueueOut.count(squeue)) || (!(Out = gMqFS->QueueOut[squeue]))) {
+    if (!(Out = gMqFS->GetQueueShard(squeue).Queues.Find(squeue))) {
       return gMqFS->Emsg(epname, error, EINVAL, "check queue - no such queue");
     }
 
@@ -297,7 +341,6 @@ XrdMqOfs::stat(const char*                queuename,
     XrdSmartOucEnv* env = new XrdSmartOucEnv(amg.GetMessageBuffer());
     XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), env, tident,
                             XrdMqMessageHeader::kQueryMessage, queuename);
-    XrdMqOfsOutMutex qm;
 
     if (!gMqFS->Deliver(matches)) {
       delete env;
@@ -360,9 +403,10 @@ XrdMqOfsFile::open(const char*                queuename,
   tident = error.getErrUser();
   MAYREDIRECT;
   ZTRACE(open, "Connecting Queue: " << queuename);
-  XrdMqOfsOutMutex qm;
   QueueName = queuename;
   std::string squeue = queuename;
+  XrdMqOfsOutMutex qm(squeue);
+  XrdMqQueueShard& shard = gMqFS->GetQueueShard(squeue);
 
   //  printf("%s %s %s\n",QueueName.c_str(),gMqFS->QueuePrefix.c_str(),opaque);
   // check if this queue is accepted by the broker
@@ -372,7 +416,7 @@ XrdMqOfsFile::open(const char*                queuename,
                        "connect queue - the broker does not serve the requested queue");
   }
 
-  if (gMqFS->QueueOut.count(squeue)) {
+  if (shard.Queues.Find(squeue)) {
     fprintf(stderr, "EBUSY: Queue %s is busy\n", QueueName.c_str());
     // this is already open by 'someone'
     return gMqFS->Emsg(epname, error, EBUSY, "connect queue - already connected",
@@ -385,6 +429,7 @@ XrdMqOfsFile::open(const char*                queuename,
   bool advisorystatus = false;
   bool advisoryquery = false;
   bool advisoryflushbacklog = false;
+  int longpoll = 0;
   const char* val;
 
   if ((val = queueenv.Get(XMQCADVISORYSTATUS))) {
@@ -399,11 +444,24 @@ XrdMqOfsFile::open(const char*                queuename,
     advisoryflushbacklog = atoi(val);
   }
 
+  if ((val = queueenv.Get(XMQCLONGPOLL))) {
+    longpoll = atoi(val);
+
+    if (longpoll < 0) {
+      longpoll = 0;
+    }
+
+    if (longpoll > MQOFSMAXLONGPOLL) {
+      longpoll = MQOFSMAXLONGPOLL;
+    }
+  }
+
   Out->AdvisoryStatus = advisorystatus;
   Out->AdvisoryQuery  = advisoryquery;
   Out->AdvisoryFlushBackLog = advisoryflushbacklog;
   Out->BrokenByFlush = false;
-  gMqFS->QueueOut.insert(std::pair<std::string, XrdMqMessageOut*>(squeue, Out));
+  Out->LongPoll = longpoll;
+  shard.Queues.Add(squeue, Out, advisorystatus, advisoryquery);
   ZTRACE(open, "Connected Queue: " << queuename);
   IsOpen = true;
   return SFS_OK;
@@ -421,15 +479,16 @@ XrdMqOfsFile::close()
   ZTRACE(close, "Disconnecting Queue: " << QueueName.c_str());
   std::string squeue = QueueName.c_str();
   {
-    XrdMqOfsOutMutex qm;
+    XrdMqOfsOutMutex qm(squeue);
+    XrdMqQueueShard& shard = gMqFS->GetQueueShard(squeue);
 
-    if ((gMqFS->QueueOut.count(squeue)) && (Out = gMqFS->QueueOut[squeue])) {
+    if ((Out = shard.Queues.Find(squeue))) {
       // hmm this could create a dead lock
       //      Out->DeletionSem.Wait();
       Out->Lock();
       // we have to take away all pending messages
       Out->RetrieveMessages();
-      gMqFS->QueueOut.erase(squeue);
+      shard.Queues.Remove(squeue);
       delete Out;
     }
 
@@ -450,7 +509,6 @@ XrdMqOfsFile::close()
     XrdSmartOucEnv* env = new XrdSmartOucEnv(amg.GetMessageBuffer());
     XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), env, tident,
                             XrdMqMessageHeader::kStatusMessage, QueueName.c_str());
-    XrdMqOfsOutMutex qm;
 
     if (!gMqFS->Deliver(matches)) {
       delete env;
@@ -470,17 +528,20 @@ XrdMqOfsFile::read(XrdSfsFileOffset  fileOffset,
   ZTRACE(read, "read");
 
   if (Out) {
-    unsigned int mlen = Out->MessageBuffer.length();
+    // large buffers are read in chunks, don't shift the rest for each chunk
+    unsigned int mlen = Out->MessageBuffer.length() - Out->MessageBufferPos;
     ZTRACE(read, "reading size:" << buffer_size);
 
     if ((unsigned long) buffer_size < mlen) {
-      memcpy(buffer, Out->MessageBuffer.c_str(), buffer_size);
-      Out->MessageBuffer.erase(0, buffer_size);
+      memcpy(buffer, Out->MessageBuffer.c_str() + Out->MessageBufferPos,
+             buffer_size);
+      Out->MessageBufferPos += buffer_size;
       return buffer_size;
     } else {
-      memcpy(buffer, Out->MessageBuffer.c_str(), mlen);
+      memcpy(buffer, Out->MessageBuffer.c_str() + Out->MessageBufferPos, mlen);
       Out->MessageBuffer.clear();
       Out->MessageBuffer.reserve(0);
+      Out->MessageBufferPos = 0;
       return mlen;
     }
   }
@@ -528,14 +589,39 @@ XrdMqOfsFile::stat(struct stat* buf)
       XrdSmartOucEnv* env = new XrdSmartOucEnv(amg.GetMessageBuffer());
       XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), env, tident,
                               XrdMqMessageHeader::kQueryMessage, QueueName.c_str());
-      XrdMqOfsOutMutex qm;
 
       if (!gMqFS->Deliver(matches)) {
         delete env;
       }
     }
-    //    Out->MessageSem.Wait(1);
     Out->Lock();
+
+    if (Out->LongPoll && Out->MessageQueue.empty() &&
+        (Out->MessageBuffer.length() == Out->MessageBufferPos)) {
+      // long-poll: wait until a message is delivered or the poll expires.
+      // Only a bounded number of receivers may hold a thread like this, the
+      // others get the empty answer right away and poll again later.
+      if (gMqFS->LongPollers.fetch_add(1) < gMqFS->MaxLongPollers) {
+        time_t deadline = time(0) + Out->LongPoll;
+        time_t now;
+
+        // Requests of this file are serialized, so close can not delete the
+        // queue meanwhile. DeletionSem is released to not block a stat by
+        // name for the whole poll.
+        while (Out->MessageQueue.empty() && ((now = time(0)) < deadline)) {
+          Out->LongPollWaiting = true;
+          Out->UnLock();
+          Out->DeletionSem.Post();
+          Out->MessageSem.Wait(deadline - now);
+          Out->DeletionSem.Wait();
+          Out->Lock();
+          Out->LongPollWaiting = false;
+        }
+      }
+
+      gMqFS->LongPollers--;
+    }
+
     ZTRACE(stat, "Grabbing message");
     memset(buf, 0, sizeof(struct stat));
     buf->st_blksize = 1024;
@@ -661,6 +747,12 @@ int XrdMqOfs::Configure(XrdSysError& Eroute)
           }
         }
 
+        if (!strcmp("maxlongpollers", var)) {
+          if ((val = Config.GetWord())) {
+            MaxLongPollers = atoi(val);
+          }
+        }
+
         if (!strcmp("trace", var)) {
           if ((val = Config.GetWord())) {
             XrdOucString tracelevel = val;
@@ -709,6 +801,9 @@ int XrdMqOfs::Configure(XrdSysError& Eroute)
   BrokerId += QueuePrefix;
   Eroute.Say("=====> mq.queue: ", QueuePrefix.c_str());
   Eroute.Say("=====> mq.brokerid: ", BrokerId.c_str());
+  XrdOucString smaxlongpollers = "";
+  smaxlongpollers += MaxLongPollers;
+  Eroute.Say("=====> mq.maxlongpollers: ", smaxlongpollers.c_str());
   return rc;
 }
 
@@ -773,9 +868,10 @@ XrdMqOfs::Statistics()
       rc = write(fd, line, strlen(line));
       sprintf(line, "mq.queued                 %d\n", (int)Messages.size());
       rc = write(fd, line, strlen(line));
-      sprintf(line, "mq.nqueues                %d\n", (int)QueueOut.size());
+      sprintf(line, "mq.nqueues                %d\n", (int)NumQueues());
       rc = write(fd, line, strlen(line));
-      sprintf(line, "mq.backloghits            %lld\n", QueueBacklogHits);
+      sprintf(line, "mq.backloghits            %lld\n",
+              QueueBacklogHits.load());
       rc = write(fd, line, strlen(line));
       sprintf(line, "mq.in_rate                %f\n",
               (1000.0 * (ReceivedMessages - LastReceivedMessages) / (tdiff)));
@@ -819,7 +915,7 @@ XrdMqOfs::Statistics()
            DiscardedMonitoringMessages);
     ZTRACE(getstats, "No        Messages            : " << NoMessages);
     ZTRACE(getstats, "Queue     Messages            : " << Messages.size());
-    ZTRACE(getstats, "#Queues                       : " << QueueOut.size());
+    ZTRACE(getstats, "#Queues                       : " << NumQueues());
     ZTRACE(getstats, "Deferred  Messages (backlog)  : " << BacklogDeferred);
     ZTRACE(getstats, "Backlog   Messages Hits       : " << QueueBacklogHits);
     char rates[4096];
@@ -40,6 +40,8 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <atomic>
+#include <functional>
 
 #include <utime.h>
 #include <pwd.h>
@@ -52,6 +54,8 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSys/XrdSysSemWait.hh"
 #include "XrdOfs/XrdOfs.hh"
+#include "mq/XrdMqRWMutex.hh"
+#include "mq/XrdMqSubscriptionIndex.hh"
 
 class XrdSecEntity;
 
@@ -59,6 +63,12 @@ class XrdSecEntity;
 #define MQOFSMAXMESSAGEBACKLOG 100000
 #define MQOFSMAXQUEUEBACKLOG 50000
 #define MQOFSREJECTQUEUEBACKLOG 100000
+// number of independently locked parts of the output queue index
+#define MQOFSQUEUESHARDS 16
+// maximum time in seconds a receiver stat waits for new messages
+#define MQOFSMAXLONGPOLL 10
+// default maximum number of receivers waiting in stat at the same time
+#define MQOFSMAXLONGPOLLERS 256
 
 #define MAYREDIRECT {                                       \
     int port=0;                                               \
@@ -138,19 +148,24 @@ public:
   bool AdvisoryFlushBackLog;
   bool BrokenByFlush;
   int  nQueued;
+  int  LongPoll;         // -> seconds a stat waits for messages, 0 = no wait
+  bool LongPollWaiting;  // -> a stat waits on MessageSem
   XrdOucString QueueName;
   XrdSysSemWait DeletionSem;
   XrdSysSemWait MessageSem;
   std::deque<XrdSmartOucEnv*> MessageQueue;
 
-  XrdMqMessageOut(const char* queuename)
+  XrdMqMessageOut(const char* queuename) : MessageSem(0)
   {
     MessageBuffer = "";
+    MessageBufferPos = 0;
     AdvisoryStatus = false;
     AdvisoryQuery = false;
     AdvisoryFlushBackLog = false;
     BrokenByFlush = false;
     nQueued = 0;
+    LongPoll = 0;
+    LongPollWaiting = false;
     QueueName = queuename;
     MessageQueue.clear();
   }
@@ -161,6 +176,7 @@ public:
   }
 
   std::string MessageBuffer;
+  size_t MessageBufferPos; // -> part of MessageBuffer already read
   size_t RetrieveMessages();
 };
 
@@ -260,11 +276,36 @@ private:
 };
 
 
+// part of the output queue index with its own lock, a queue belongs to the
+// shard selected by the hash of its name
+class XrdMqQueueShard
+{
+public:
+  XrdMqSubscriptionIndex<XrdMqMessageOut>
+  Queues;  // -> index of the queues of this shard
+  XrdMqRWMutex
+  Mutex;   // -> write locked to change, read locked to deliver
+};
+
+// write lock of the index shard of a queue, taken to add or remove the queue
 class XrdMqOfsOutMutex
 {
 public:
-  XrdMqOfsOutMutex();
+  XrdMqOfsOutMutex(const std::string& queue);
   ~XrdMqOfsOutMutex();
+private:
+  XrdMqQueueShard* mShard;
+};
+
+// read lock of the index shard of a queue or, without a queue name, of all
+// shards in ascending order, taken to deliver messages
+class XrdMqOfsOutReadLock
+{
+public:
+  XrdMqOfsOutReadLock(const char* queue = 0);
+  ~XrdMqOfsOutReadLock();
+private:
+  XrdMqQueueShard* mShard; // -> locked shard, 0 if all shards are locked
 };
 
 class XrdMqOfs : public XrdSfsFileSystem
@@ -321,10 +362,15 @@ public:
   QueueAdvisory;      // -> "<queueprefix>/*" for advisory message matches
   XrdOucString     BrokerId;           // -> manger id + queue name as path
 
-  std::map<std::string, XrdMqMessageOut*>
-  QueueOut;  // -> hash of all output's connected
-  XrdSysMutex
-  QueueOutMutex;  // -> mutex protecting the output hash
+  XrdMqQueueShard
+  QueueOut[MQOFSQUEUESHARDS];  // -> index of all output's connected
+
+  XrdMqQueueShard& GetQueueShard(const std::string& queue)
+  {
+    return QueueOut[std::hash<std::string>()(queue) % MQOFSQUEUESHARDS];
+  }
+
+  size_t           NumQueues();        // -> number of connected queues
 
   bool             Deliver(XrdMqOfsMatches&
                            Match); // -> delivers a message into matching output queues
@@ -403,11 +449,13 @@ public:
   long long    UndeliverableMessages;
   long long    DiscardedMonitoringMessages;
   long long    NoMessages;
-  long long    BacklogDeferred;
-  long long    QueueBacklogHits;
+  std::atomic<long long> BacklogDeferred;
+  std::atomic<long long> QueueBacklogHits;
   long long    MaxMessageBacklog;
   long long    MaxQueueBacklog;
   long long    RejectQueueBacklog;
+  int          MaxLongPollers;
+  std::atomic<int> LongPollers;        // -> receivers waiting in stat
   void         Statistics();
   XrdOucString StatisticsFile;
   char*         ConfigFN;
@@ -27,6 +27,7 @@
 #include "mq/XrdMqMessage.hh"
 #include "mq/XrdMqOfsTrace.hh"
 #include "XrdOuc/XrdOucEnv.hh"
+#include <algorithm>
 
 #define XRDMQOFS_FSCTLPATHLEN 1024
 
@@ -44,75 +45,44 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
   std::string sendername = Matches.sendername.c_str();
   // here we store all the queues where we need to deliver this message
   std::vector<XrdMqMessageOut*> MatchedOutputQueues;
+  std::vector<XrdMqMessageOut*> ShardQueues;
+  bool advisory =
+    (((Matches.messagetype) == XrdMqMessageHeader::kStatusMessage) ||
+     ((Matches.messagetype) == XrdMqMessageHeader::kQueryMessage));
+  bool wildcard = (Matches.queuename.find("*") != STR_NPOS);
+  // A named queue needs only its own index shard, the others need all
+  XrdMqOfsOutReadLock qm((advisory || wildcard) ? 0 :
+                         Matches.queuename.c_str());
   Matches.message->procmutex.Lock();
 
-  // If we have a status message we have to do a complete loop
-  if (((Matches.messagetype) == XrdMqMessageHeader::kStatusMessage) ||
-      ((Matches.messagetype) == XrdMqMessageHeader::kQueryMessage)) {
-    std::map<std::string, XrdMqMessageOut*>::const_iterator QueueOutIt;
-
-    for (QueueOutIt = QueueOut.begin(); QueueOutIt != QueueOut.end();
-         QueueOutIt++) {
-      XrdMqMessageOut* Out = QueueOutIt->second;
-
-      // if this would be a loop back message we continue
-      if (sendername == QueueOutIt->first) {
-        // avoid feedback to the same queue
-        continue;
-      }
-
-      // if this queue does not take advisory status messages we continue
-      if ((Matches.messagetype == XrdMqMessageHeader::kStatusMessage) &&
-          (!Out->AdvisoryStatus)) {
-        continue;
-      }
-
-      // if this queue does not take advisory query messages we continue
-      if ((Matches.messagetype == XrdMqMessageHeader::kQueryMessage)  &&
-          (!Out->AdvisoryQuery)) {
-        continue;
-      } else {
-        ZTRACE(fsctl, "Adding Advisory Message to Queuename: " <<
-               Out->QueueName.c_str());
-        MatchedOutputQueues.push_back(Out);
-      }
+  // Status and query messages go to all queues taking advisory messages
+  if (advisory) {
+    for (int i = 0; i < MQOFSQUEUESHARDS; ++i) {
+      QueueOut[i].Queues.MatchAdvisory(Matches.messagetype ==
+                                       XrdMqMessageHeader::kQueryMessage,
+                                       sendername, ShardQueues);
+      MatchedOutputQueues.insert(MatchedOutputQueues.end(), ShardQueues.begin(),
+                                 ShardQueues.end());
     }
-  } else {
-    // If we have a wildcard match we have to do a complete loop
-    if ((Matches.queuename.find("*") != STR_NPOS)) {
-      std::map<std::string, XrdMqMessageOut*>::const_iterator QueueOutIt;
-
-      for (QueueOutIt = QueueOut.begin(); QueueOutIt != QueueOut.end();
-           QueueOutIt++) {
-        XrdMqMessageOut* Out = QueueOutIt->second;
-
-        // fprintf(stderr,"%s <=> %s\n", sendername.c_str(), QueueOutIt->first.c_str());
-        // If this would be a loop back message we continue
-        if (sendername == QueueOutIt->first) {
-          // avoid feedback to the same queue
-          continue;
-        }
 
-        XrdOucString Key = QueueOutIt->first.c_str();
-        XrdOucString nowildcard = Matches.queuename;
-        nowildcard.replace("*", "");
-        int nmatch = Key.matches(Matches.queuename.c_str(), '*');
-
-        if (nmatch == nowildcard.length()) {
-          // this is a match
-          ZTRACE(fsctl, "Adding Wildcard matched Message to Queuename: "
-                 << Out->QueueName.c_str());
-          MatchedOutputQueues.push_back(Out);
-        }
+    ZTRACE(fsctl, "Adding Advisory Message to " << MatchedOutputQueues.size()
+           << " queues");
+  } else {
+    if (wildcard) {
+      // Wildcard match through the subscription index of each shard
+      for (int i = 0; i < MQOFSQUEUESHARDS; ++i) {
+        QueueOut[i].Queues.MatchWildcard(Matches.queuename.c_str(), sendername,
+                                         ShardQueues);
+        MatchedOutputQueues.insert(MatchedOutputQueues.end(),
+                                   ShardQueues.begin(), ShardQueues.end());
       }
+
+      ZTRACE(fsctl, "Adding Wildcard matched Message to "
+             << MatchedOutputQueues.size() << " queues");
     } else {
       // We have just to find one named queue
       std::string queuename = Matches.queuename.c_str();
-      XrdMqMessageOut* Out = 0;
-
-      if (QueueOut.count(queuename)) {
-        Out = QueueOut[queuename];
-      }
+      XrdMqMessageOut* Out = GetQueueShard(queuename).Queues.Find(queuename);
 
       if (Out) {
         ZTRACE(fsctl, "Adding full matched Message to Queuename: " <<
@@ -127,7 +97,11 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
     Matches.backlog = false;
     Matches.backlogrejected = false;
 
-    // Lock all matched queues at once
+    // Lock all matched queues at once - deliveries run concurrently, so they
+    // lock the queues in the order of their address
+    std::sort(MatchedOutputQueues.begin(), MatchedOutputQueues.end(),
+              std::less<XrdMqMessageOut*>());
+
     for (unsigned int i = 0; i < MatchedOutputQueues.size(); ++i) {
       XrdMqMessageOut* Out = MatchedOutputQueues[i];
       Out->Lock();
@@ -202,6 +176,12 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
           Out->MessageQueue.push_back((Matches.message));
           Matches.message->AddRefs(1);
           Out->nQueued++;
+
+          if (Out->LongPollWaiting) {
+            // wake up the long-polling receiver
+            Out->LongPollWaiting = false;
+            Out->MessageSem.Post();
+          }
         }
       }
     }
@@ -227,6 +207,11 @@ XrdMqMessageOut::RetrieveMessages()
 {
   XrdSmartOucEnv* message;
 
+  if (MessageBufferPos) {
+    MessageBuffer.erase(0, MessageBufferPos);
+    MessageBufferPos = 0;
+  }
+
   while (MessageQueue.size()) {
     message = MessageQueue.front();
     MessageQueue.pop_front();
@@ -345,10 +330,7 @@ XrdMqOfs::FSctl(const int               cmd,
   env = new XrdSmartOucEnv(envstring.c_str());
   XrdMqOfsMatches matches(mh.kReceiverQueue.c_str(), env, tident, mh.kType,
                           mh.kSenderId.c_str());
-  {
-    XrdMqOfsOutMutex qm;
-    Deliver(matches);
-  }
+  Deliver(matches);
 
   if (matches.backlogrejected) {
     XrdOucString backlogmessage =
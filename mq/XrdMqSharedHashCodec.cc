@@ -0,0 +1,441 @@
+// ----------------------------------------------------------------------
+// File: XrdMqSharedHashCodec.cc
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mq/XrdMqSharedHashCodec.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unordered_map>
+
+//! Format version of the buffer
+static const unsigned char sCodecVersion = 1;
+
+//! Value types
+enum {
+  kValueString = 0, ///< <varint length> <bytes>
+  kValueUInt = 1, ///< <varint> of a decimal integer
+  kValueNegInt = 2, ///< <varint> of the absolute value of a negative integer
+  kValueDoubleG = 3, ///< 8 bytes IEEE double printed with %g
+  kValueDoubleF = 4 ///< 8 bytes IEEE double printed with %f
+};
+
+static const char sBase64Chars[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+//------------------------------------------------------------------------------
+// Append varint to buffer
+//------------------------------------------------------------------------------
+static inline void
+PutVarint(std::string& buffer, uint64_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back((char)((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+
+  buffer.push_back((char) value);
+}
+
+//------------------------------------------------------------------------------
+// Read varint from buffer
+//------------------------------------------------------------------------------
+static inline bool
+GetVarint(const unsigned char*& ptr, const unsigned char* end, uint64_t& value)
+{
+  value = 0;
+
+  for (int shift = 0; (ptr < end) && (shift < 64); shift += 7) {
+    uint64_t byte = *ptr++;
+    value |= (byte & 0x7f) << shift;
+
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Check if the string is a canonical decimal number without sign
+//------------------------------------------------------------------------------
+static inline bool
+IsCanonicalUInt(const char* str, size_t len)
+{
+  // 19 digits always fit into 64 bits
+  if ((len == 0) || (len > 19) || ((str[0] == '0') && (len > 1))) {
+    return false;
+  }
+
+  for (size_t i = 0; i < len; ++i) {
+    if ((str[i] < '0') || (str[i] > '9')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Format a double in the given type
+//------------------------------------------------------------------------------
+static inline int
+FormatDouble(char* buf, size_t len, int type, double value)
+{
+  return snprintf(buf, len, (type == kValueDoubleG) ? "%g" : "%f", value);
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+XrdMqSharedHashCodec::XrdMqSharedHashCodec():
+  mCount(0)
+{
+  mBuffer.reserve(4096);
+  mBuffer.push_back((char) sCodecVersion);
+}
+
+//------------------------------------------------------------------------------
+// Get the table of well known keys
+//------------------------------------------------------------------------------
+const std::vector<std::string>&
+XrdMqSharedHashCodec::GetKeyTable()
+{
+  // The position of a key is its id on the wire, new keys have to be
+  // appended at the end to stay compatible with running peers
+  static const std::vector<std::string> sKeyTable {
+    "id", "uuid", "host", "hostport", "port", "path", "queue", "queuepath",
+    "schedgroup", "configstatus", "drainstatus", "errc", "headroom",
+    "scaninterval", "graceperiod", "drainperiod", "bootcheck",
+    "bootsenttime", "status", "stat.active", "stat.boot",
+    "stat.bootdonetime", "stat.bootsenttime", "stat.errc", "stat.errmsg",
+    "stat.geotag", "stat.health", "stat.health.drives_failed",
+    "stat.health.drives_total", "stat.health.indicator",
+    "stat.health.redundancy_factor", "stat.heartbeattime", "stat.host",
+    "stat.hostport", "stat.publishtimestamp", "stat.disk.bw",
+    "stat.disk.iops", "stat.disk.load", "stat.disk.readratemb",
+    "stat.disk.writeratemb", "stat.net.ethratemib", "stat.net.inratemib",
+    "stat.net.outratemib", "stat.nominal.filled", "stat.ropen",
+    "stat.ropen.hotfiles", "stat.wopen", "stat.wopen.hotfiles",
+    "stat.statfs.bavail", "stat.statfs.bfree", "stat.statfs.blocks",
+    "stat.statfs.bsize", "stat.statfs.bused", "stat.statfs.capacity",
+    "stat.statfs.ffree", "stat.statfs.files", "stat.statfs.filled",
+    "stat.statfs.freebytes", "stat.statfs.fused", "stat.statfs.namelen",
+    "stat.statfs.type", "stat.statfs.usedbytes", "stat.usedfiles",
+    "stat.balance.ntx", "stat.balance.rate", "stat.balance.threshold",
+    "stat.balancer.running", "stat.drain.ntx", "stat.drain.rate",
+    "stat.drainer", "stat.drainer.running", "stat.drainprogress",
+    "stat.dataproxy.gopen", "stat.sys.eos.start", "stat.sys.eos.version",
+    "stat.sys.kernel", "stat.sys.keytab", "stat.sys.rss",
+    "stat.sys.sockets", "stat.sys.threads", "stat.sys.uptime",
+    "stat.sys.vsize", "stat.timeleft", "stat.drainbytesleft",
+    "stat.drainfiles", "stat.drainretry", "stat.drain.failed",
+    "stat.drain.successful", "stat.drain.progress", "stat.balancing",
+    "stat.balancing.running", "stat.converter.active", "stat.wfe.active"
+  };
+  return sKeyTable;
+}
+
+//------------------------------------------------------------------------------
+// Add a key/value update of a subject to the buffer
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHashCodec::Add(uint32_t subject_index, const std::string& key,
+                          const std::string& value)
+{
+  static const std::unordered_map<std::string, uint64_t> sKeyIds = [] {
+    std::unordered_map<std::string, uint64_t> ids;
+    const std::vector<std::string>& table = GetKeyTable();
+
+    for (size_t i = 0; i < table.size(); ++i) {
+      ids[table[i]] = i + 1;
+    }
+
+    return ids;
+  }();
+  PutVarint(mBuffer, subject_index);
+  auto it = sKeyIds.find(key);
+
+  if (it != sKeyIds.end()) {
+    PutVarint(mBuffer, it->second);
+  } else {
+    PutVarint(mBuffer, 0);
+    PutVarint(mBuffer, key.length());
+    mBuffer.append(key);
+  }
+
+  const char* str = value.c_str();
+  size_t len = value.length();
+
+  if (IsCanonicalUInt(str, len)) {
+    mBuffer.push_back((char) kValueUInt);
+    PutVarint(mBuffer, strtoull(str, 0, 10));
+  } else if ((len > 1) && (str[0] == '-') && (str[1] != '0') &&
+             IsCanonicalUInt(str + 1, len - 1)) {
+    mBuffer.push_back((char) kValueNegInt);
+    PutVarint(mBuffer, strtoull(str + 1, 0, 10));
+  } else {
+    int type = kValueString;
+    double dvalue = 0;
+
+    // Only numbers with a fraction or exponent are candidates for doubles
+    if ((len < 32) && (isdigit(str[0]) || (str[0] == '-')) &&
+        strpbrk(str, ".e")) {
+      char* endptr = 0;
+      dvalue = strtod(str, &endptr);
+
+      if (endptr == str + len) {
+        char buf[64];
+
+        if ((FormatDouble(buf, sizeof(buf), kValueDoubleG, dvalue) == (int) len) &&
+            !memcmp(buf, str, len)) {
+          type = kValueDoubleG;
+        } else if ((FormatDouble(buf, sizeof(buf), kValueDoubleF,
+                                 dvalue) == (int) len) &&
+                   !memcmp(buf, str, len)) {
+          type = kValueDoubleF;
+        }
+      }
+    }
+
+    mBuffer.push_back((char) type);
+
+    if (type == kValueString) {
+      PutVarint(mBuffer, len);
+      mBuffer.append(value);
+    } else {
+      uint64_t bits;
+      memcpy(&bits, &dvalue, sizeof(bits));
+
+      for (int i = 0; i < 8; ++i) {
+        mBuffer.push_back((char)((bits >> (8 * i)) & 0xff));
+      }
+    }
+  }
+
+  mCount++;
+}
+
+//------------------------------------------------------------------------------
+// Get the base64 encoded buffer
+//------------------------------------------------------------------------------
+std::string
+XrdMqSharedHashCodec::Encode() const
+{
+  const unsigned char* in = (const unsigned char*) mBuffer.data();
+  size_t len = mBuffer.length();
+  std::string out;
+  out.reserve(((len + 2) / 3) * 4);
+  size_t i = 0;
+
+  for (; i + 2 < len; i += 3) {
+    uint32_t triple = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+    out.push_back(sBase64Chars[(triple >> 18) & 0x3f]);
+    out.push_back(sBase64Chars[(triple >> 12) & 0x3f]);
+    out.push_back(sBase64Chars[(triple >> 6) & 0x3f]);
+    out.push_back(sBase64Chars[triple & 0x3f]);
+  }
+
+  if (i < len) {
+    uint32_t triple = in[i] << 16;
+
+    if (i + 1 < len) {
+      triple |= in[i + 1] << 8;
+    }
+
+    out.push_back(sBase64Chars[(triple >> 18) & 0x3f]);
+    out.push_back(sBase64Chars[(triple >> 12) & 0x3f]);
+    out.push_back((i + 1 < len) ? sBase64Chars[(triple >> 6) & 0x3f] : '=');
+    out.push_back('=');
+  }
+
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Decode a base64 encoded buffer
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::Decode(const char* encoded, size_t length,
+                             std::vector<Entry>& entries, size_t& nentries)
+{
+  static const std::vector<signed char> sBase64Map = [] {
+    std::vector<signed char> map(256, -1);
+
+    for (int i = 0; i < 64; ++i) {
+      map[(unsigned char) sBase64Chars[i]] = i;
+    }
+
+    return map;
+  }();
+  const std::vector<std::string>& table = GetKeyTable();
+  nentries = 0;
+
+  if (length % 4) {
+    return false;
+  }
+
+  // Base64 decoding
+  thread_local std::string buffer;
+  buffer.clear();
+  buffer.reserve((length / 4) * 3);
+
+  for (size_t i = 0; i < length; i += 4) {
+    int c[4];
+
+    for (int j = 0; j < 4; ++j) {
+      if (encoded[i + j] == '=') {
+        // Padding is only allowed at the end
+        if ((i + 4 != length) || (j < 2)) {
+          return false;
+        }
+
+        c[j] = -2;
+      } else {
+        c[j] = sBase64Map[(unsigned char) encoded[i + j]];
+
+        if ((c[j] < 0) || ((j == 3) && (c[2] == -2))) {
+          return false;
+        }
+      }
+    }
+
+    buffer.push_back((char)((c[0] << 2) | (c[1] >> 4)));
+
+    if (c[2] != -2) {
+      buffer.push_back((char)(((c[1] & 0xf) << 4) | (c[2] >> 2)));
+
+      if (c[3] != -2) {
+        buffer.push_back((char)(((c[2] & 0x3) << 6) | c[3]));
+      }
+    }
+  }
+
+  const unsigned char* ptr = (const unsigned char*) buffer.data();
+  const unsigned char* end = ptr + buffer.length();
+
+  if ((ptr == end) || (*ptr++ != sCodecVersion)) {
+    return false;
+  }
+
+  uint64_t value;
+
+  while (ptr < end) {
+    if (nentries == entries.size()) {
+      entries.resize(entries.size() ? 2 * entries.size() : 64);
+    }
+
+    Entry& entry = entries[nentries];
+
+    // Subject index
+    if (!GetVarint(ptr, end, value) || (value > UINT32_MAX)) {
+      return false;
+    }
+
+    entry.mSubjectIndex = (uint32_t) value;
+
+    // Key
+    if (!GetVarint(ptr, end, value)) {
+      return false;
+    }
+
+    if (value) {
+      if (value > table.size()) {
+        return false;
+      }
+
+      entry.mKey = table[value - 1];
+    } else {
+      if (!GetVarint(ptr, end, value) || (value > (uint64_t)(end - ptr))) {
+        return false;
+      }
+
+      entry.mKey.assign((const char*) ptr, value);
+      ptr += value;
+    }
+
+    // Value
+    if (ptr == end) {
+      return false;
+    }
+
+    int type = *ptr++;
+
+    switch (type) {
+    case kValueString:
+      if (!GetVarint(ptr, end, value) || (value > (uint64_t)(end - ptr))) {
+        return false;
+      }
+
+      entry.mValue.assign((const char*) ptr, value);
+      ptr += value;
+      break;
+
+    case kValueUInt:
+    case kValueNegInt: {
+      if (!GetVarint(ptr, end, value)) {
+        return false;
+      }
+
+      char buf[32];
+      int len = snprintf(buf, sizeof(buf), (type == kValueUInt) ? "%llu" : "-%llu",
+                         (unsigned long long) value);
+      entry.mValue.assign(buf, len);
+      break;
+    }
+
+    case kValueDoubleG:
+    case kValueDoubleF: {
+      if (end - ptr < 8) {
+        return false;
+      }
+
+      uint64_t bits = 0;
+
+      for (int i = 0; i < 8; ++i) {
+        bits |= ((uint64_t) ptr[i]) << (8 * i);
+      }
+
+      ptr += 8;
+      double dvalue;
+      memcpy(&dvalue, &bits, sizeof(dvalue));
+      char buf[512];
+      int len = FormatDouble(buf, sizeof(buf), type, dvalue);
+
+      if ((len < 0) || (len >= (int) sizeof(buf))) {
+        return false;
+      }
+
+      entry.mValue.assign(buf, len);
+      break;
+    }
+
+    default:
+      return false;
+    }
+
+    nentries++;
+  }
+
+  return true;
+}
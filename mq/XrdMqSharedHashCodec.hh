@@ -0,0 +1,107 @@
+// ----------------------------------------------------------------------
+// File: XrdMqSharedHashCodec.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __XRDMQ_SHAREDHASHCODEC_HH__
+#define __XRDMQ_SHAREDHASHCODEC_HH__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Class XrdMqSharedHashCodec
+//!
+//! @brief Compact encoding of shared hash updates. Well known keys are sent
+//! as ids of a static key table, integers as varints and doubles as IEEE
+//! values if they convert back to the identical string. The records of all
+//! subjects of a (mux) transaction are batched in one buffer which is base64
+//! encoded, so that it can travel as a value of the env message body.
+//!
+//! Record layout:
+//!   <varint subject-index> <key> <value>
+//!   key   := <varint id + 1> | 0 <varint length> <bytes>
+//!   value := <type byte> <payload>
+//------------------------------------------------------------------------------
+class XrdMqSharedHashCodec
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Decoded update of one key
+  //----------------------------------------------------------------------------
+  struct Entry {
+    uint32_t mSubjectIndex; ///< Index of the subject in the subject list
+    std::string mKey; ///< Key
+    std::string mValue; ///< Value
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  XrdMqSharedHashCodec();
+
+  //----------------------------------------------------------------------------
+  //! Add a key/value update of a subject to the buffer
+  //!
+  //! @param subject_index index of the subject in the message subject list
+  //! @param key key
+  //! @param value value
+  //----------------------------------------------------------------------------
+  void Add(uint32_t subject_index, const std::string& key,
+           const std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Get number of added updates
+  //----------------------------------------------------------------------------
+  size_t Size() const
+  {
+    return mCount;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the base64 encoded buffer
+  //----------------------------------------------------------------------------
+  std::string Encode() const;
+
+  //----------------------------------------------------------------------------
+  //! Decode a base64 encoded buffer
+  //!
+  //! @param encoded encoded buffer
+  //! @param length length of the encoded buffer
+  //! @param entries decoded entries, existing elements are reused
+  //! @param nentries number of valid elements in entries
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Decode(const char* encoded, size_t length,
+                     std::vector<Entry>& entries, size_t& nentries);
+
+  //----------------------------------------------------------------------------
+  //! Get the table of well known keys - entries can only be appended!
+  //----------------------------------------------------------------------------
+  static const std::vector<std::string>& GetKeyTable();
+
+private:
+  std::string mBuffer; ///< Binary buffer
+  size_t mCount; ///< Number of records in the buffer
+};
+
+#endif
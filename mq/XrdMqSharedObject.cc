@@ -24,6 +24,7 @@
 #include "mq/XrdMqSharedObject.hh"
 #include "mq/XrdMqMessaging.hh"
 #include "mq/XrdMqStringConversion.hh"
+#include "mq/XrdMqSharedHashCodec.hh"
 #include "common/Logging.hh"
 #include "XrdSys/XrdSysTimer.hh"
 #include "XrdOuc/XrdOucEnv.hh"
@@ -33,11 +34,15 @@
 
 bool XrdMqSharedObjectManager::sDebug = 0;
 bool XrdMqSharedObjectManager::sBroadcast = true;
+bool XrdMqSharedObjectManager::sBinaryUpdates =
+  (getenv("EOS_MQ_BINARY_UPDATES") &&
+   !strcmp(getenv("EOS_MQ_BINARY_UPDATES"), "1"));
 
 // Static counters
 std::atomic<unsigned long long> XrdMqSharedHash::sSetCounter {0};
 std::atomic<unsigned long long> XrdMqSharedHash::sSetNLCounter = {0};
 std::atomic<unsigned long long> XrdMqSharedHash::sGetCounter = {0};
+std::atomic<unsigned long long> XrdMqSharedHash::sChangeCounter {0};
 
 __thread XrdMqSharedObjectChangeNotifier::Subscriber*
 XrdMqSharedObjectChangeNotifier::tlSubscriber = NULL;
@@ -180,7 +185,8 @@ XrdMqSharedHash::XrdMqSharedHash(const char* subject, const char* bcast_queue,
                                  XrdMqSharedObjectManager* som):
   mType("hash"), mSOM(som), mSubject((subject ? subject : "")),
   mIsTransaction(false), mBroadcastQueue((bcast_queue ? bcast_queue : "")),
-  mTransactMutex(new XrdSysMutex()), mStoreMutex(new XrdMqRWMutex())
+  mTransactMutex(new XrdSysMutex()), mStoreMutex(new XrdMqRWMutex()),
+  mChangeId(++sChangeCounter)
 {}
 
 //------------------------------------------------------------------------------
@@ -212,11 +218,50 @@ XrdMqSharedHash::operator=(XrdMqSharedHash&& other)
     std::swap(mTransactions, other.mTransactions);
     std::swap(mTransactMutex, other.mTransactMutex);
     std::swap(mStoreMutex, other.mStoreMutex);
+    std::swap(mWatchers, other.mWatchers);
+    Changed();
   }
 
   return *this;
 }
 
+//------------------------------------------------------------------------------
+// Record a modification of the contents
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::Changed()
+{
+  mChangeId = ++sChangeCounter;
+
+  for (const auto& watcher : mWatchers) {
+    ++*watcher;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Attach a watcher incremented together with the change id
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::AddWatcher(const Watcher& watcher)
+{
+  XrdMqRWMutexWriteLock wr_lock(*mStoreMutex);
+
+  for (auto it = mWatchers.begin(); it != mWatchers.end();) {
+    if (*it == watcher) {
+      return;
+    }
+
+    // Nobody reads this counter any more
+    if (it->use_count() == 1) {
+      it = mWatchers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  mWatchers.push_back(watcher);
+}
+
 //------------------------------------------------------------------------------
 // Get size of the hash
 //------------------------------------------------------------------------------
@@ -377,8 +422,13 @@ XrdMqSharedHash::CloseTransaction()
 
   if (XrdMqSharedObjectManager::sBroadcast && mTransactions.size()) {
     XrdOucString txmessage = "";
-    MakeUpdateEnvHeader(txmessage);
-    AddTransactionsToEnvString(txmessage, false);
+
+    if (XrdMqSharedObjectManager::sBinaryUpdates) {
+      MakeBinaryUpdateEnvString(txmessage);
+    } else {
+      MakeUpdateEnvHeader(txmessage);
+      AddTransactionsToEnvString(txmessage, false);
+    }
 
     if (txmessage.length() > (2 * 1000 * 1000)) {
       // Set the message size limit to 2M, if the message is bigger then just
@@ -575,6 +625,40 @@ XrdMqSharedHash::AddTransactionsToEnvString(XrdOucString& out, bool clear_after)
   }
 }
 
+//-------------------------------------------------------------------------------
+// Encode transactions as binary update message - this must be called with the
+// mTransactMutex locked.
+//-------------------------------------------------------------------------------
+void
+XrdMqSharedHash::MakeBinaryUpdateEnvString(XrdOucString& out)
+{
+  XrdMqSharedHashCodec codec;
+  {
+    XrdMqRWMutexReadLock rd_lock(*mStoreMutex);
+
+    for (auto it = mTransactions.begin(); it != mTransactions.end(); it++) {
+      auto it_store = mStore.find(*it);
+
+      if (it_store != mStore.end()) {
+        codec.Add(0, it_store->first, it_store->second.GetValue());
+      }
+    }
+  }
+  out = XRDMQSHAREDHASH_BUPDATE;
+  out += "&";
+  out += XRDMQSHAREDHASH_SUBJECT;
+  out += "=";
+  out += mSubject.c_str();
+  out += "&";
+  out += XRDMQSHAREDHASH_TYPE;
+  out += "=";
+  out += mType.c_str();
+  out += "&";
+  out += XRDMQSHAREDHASH_BINARY;
+  out += "=";
+  out += codec.Encode().c_str();
+}
+
 //-------------------------------------------------------------------------------
 // Encode deletions as env string - this must be called with the mTransactMutex
 // locked.
@@ -651,6 +735,7 @@ XrdMqSharedHash::Delete(const std::string& key, bool broadcast)
 
   if (mStore.count(key)) {
     mStore.erase(key);
+    Changed();
     deleted = true;
 
     if (XrdMqSharedObjectManager::sBroadcast && broadcast) {
@@ -711,6 +796,7 @@ XrdMqSharedHash::Clear(bool broadcast)
   }
 
   mStore.clear();
+  Changed();
 }
 
 //-------------------------------------------------------------------------------
@@ -728,6 +814,7 @@ XrdMqSharedHash::SetImpl(const char* key, const char* value, bool broadcast)
     mStore[skey] = XrdMqSharedHashEntry(key, value);
   }
 
+  Changed();
   mStoreMutex->UnLockWrite();
 
   if (XrdMqSharedObjectManager::sBroadcast && broadcast) {
@@ -2390,7 +2477,7 @@ XrdMqSharedObjectChangeNotifier::Stop()
 // Constructor
 //------------------------------------------------------------------------------
 XrdMqSharedObjectManager::XrdMqSharedObjectManager():
-  mDumperTid(0), mDumperFile("")
+  mDumperTid(0), mHashGeneration(0), mDumperFile("")
 {
   mEnableQueue = false;
   AutoReplyQueue = "";
@@ -2460,6 +2547,7 @@ XrdMqSharedObjectManager::CreateSharedHash(const char* subject,
   } else {
     XrdMqSharedHash* newhash = new XrdMqSharedHash(subject, broadcastqueue, som);
     mHashSubjects.insert(std::pair<std::string, XrdMqSharedHash*> (ss, newhash));
+    ++mHashGeneration;
     HashMutex.UnLockWrite();
 
     if (mEnableQueue) {
@@ -2545,6 +2633,7 @@ XrdMqSharedObjectManager::DeleteSharedHash(const char* subject, bool broadcast)
 
     delete(mHashSubjects[ss]);
     mHashSubjects.erase(ss);
+    ++mHashGeneration;
     HashMutex.UnLockWrite();
 
     if (mEnableQueue) {
@@ -2956,6 +3045,55 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
       XrdMqRWMutexReadLock lock(HashMutex);
       // from here on we have a read lock on 'sh'
 
+      if (ftag == XRDMQSHAREDHASH_BUPDATE) {
+        thread_local std::vector<XrdMqSharedHashCodec::Entry> entries;
+        size_t nentries = 0;
+        const char* bin = env.Get(XRDMQSHAREDHASH_BINARY);
+
+        if (!bin || !XrdMqSharedHashCodec::Decode(bin, strlen(bin), entries,
+            nentries)) {
+          error = "bupdate: parsing error in binary tag";
+          return false;
+        }
+
+        // Resolve every subject only once
+        std::vector<XrdMqSharedHash*> hashes(subjectlist.size(), nullptr);
+
+        for (size_t i = 0; i < nentries; ++i) {
+          const XrdMqSharedHashCodec::Entry& entry = entries[i];
+
+          if (entry.mSubjectIndex >= subjectlist.size()) {
+            error = "bupdate: subject index out of range";
+            return false;
+          }
+
+          sh = hashes[entry.mSubjectIndex];
+
+          if (!sh) {
+            sh = GetObject(subjectlist[entry.mSubjectIndex].c_str(), type.c_str());
+
+            if (!sh) {
+              error = "bupdate: subject does not exist (FATAL!)";
+              return false;
+            }
+
+            hashes[entry.mSubjectIndex] = sh;
+          }
+
+          if (sDebug) {
+            fprintf(stderr,
+                    "XrdMqSharedObjectManager::ParseEnvMessage=>Setting [%s] %s=> %s\n",
+                    subjectlist[entry.mSubjectIndex].c_str(), entry.mKey.c_str(),
+                    entry.mValue.c_str());
+          }
+
+          // Set entry without broadcast
+          sh->Set(entry.mKey.c_str(), entry.mValue.c_str(), false);
+        }
+
+        return true;
+      }
+
       if ((ftag == XRDMQSHAREDHASH_UPDATE) || (ftag == XRDMQSHAREDHASH_BCREPLY)) {
         std::string val = (env.Get(XRDMQSHAREDHASH_PAIRS) ? env.Get(
                              XRDMQSHAREDHASH_PAIRS) : "");
@@ -3168,8 +3306,13 @@ XrdMqSharedObjectManager::CloseMuxTransaction()
 
   if (MuxTransactions.size()) {
     XrdOucString txmessage = "";
-    MakeMuxUpdateEnvHeader(txmessage);
-    AddMuxTransactionEnvString(txmessage);
+
+    if (sBinaryUpdates) {
+      MakeMuxBinaryUpdateEnvString(txmessage);
+    } else {
+      MakeMuxUpdateEnvHeader(txmessage);
+      AddMuxTransactionEnvString(txmessage);
+    }
     XrdMqMessage message("XrdMqSharedHashMessage");
     message.SetBody(txmessage.c_str());
     message.MarkAsMonitor();
@@ -3259,6 +3402,41 @@ XrdMqSharedObjectManager::AddMuxTransactionEnvString(XrdOucString& out)
   }
 }
 
+//------------------------------------------------------------------------------
+// Encode the mux transaction as binary update message
+//------------------------------------------------------------------------------
+void
+XrdMqSharedObjectManager::MakeMuxBinaryUpdateEnvString(XrdOucString& out)
+{
+  XrdMqSharedHashCodec codec;
+  uint32_t index = 0;
+  MakeMuxUpdateEnvHeader(out);
+  // The header is the same as for the text update except for the command
+  out.replace(XRDMQSHAREDHASH_UPDATE, XRDMQSHAREDHASH_BUPDATE);
+
+  for (auto it_subj = MuxTransactions.begin(); it_subj != MuxTransactions.end();
+       ++it_subj, ++index) {
+    XrdMqSharedHash* hash = GetObject(it_subj->first.c_str(),
+                                      MuxTransactionType.c_str());
+
+    if (hash) {
+      XrdMqRWMutexReadLock lock(*(hash->mStoreMutex));
+
+      for (auto it = it_subj->second.begin(); it != it_subj->second.end(); ++it) {
+        auto it_store = hash->mStore.find(*it);
+
+        if (it_store != hash->mStore.end()) {
+          codec.Add(index, it_store->first, it_store->second.GetValue());
+        }
+      }
+    }
+  }
+
+  out += "&";
+  out += XRDMQSHAREDHASH_BINARY;
+  out += "=";
+  out += codec.Encode().c_str();
+}
 
 //-------------------------------------------------------------------------------
 //
@@ -34,6 +34,7 @@
 #include <vector>
 #include <set>
 #include <deque>
+#include <memory>
 #include <regex.h>
 #include "mgm/TableFormatter/TableCell.hh"
 #include <atomic>
@@ -45,11 +46,13 @@
 #define XRDMQSHAREDHASH_BCREPLY   "mqsh.cmd=bcreply"
 #define XRDMQSHAREDHASH_DELETE    "mqsh.cmd=delete"
 #define XRDMQSHAREDHASH_REMOVE    "mqsh.cmd=remove"
+#define XRDMQSHAREDHASH_BUPDATE   "mqsh.cmd=bupdate"
 #define XRDMQSHAREDHASH_SUBJECT   "mqsh.subject"
 #define XRDMQSHAREDHASH_PAIRS     "mqsh.pairs"
 #define XRDMQSHAREDHASH_KEYS      "mqsh.keys"
 #define XRDMQSHAREDHASH_REPLY     "mqsh.reply"
 #define XRDMQSHAREDHASH_TYPE      "mqsh.type"
+#define XRDMQSHAREDHASH_BINARY    "mqsh.bin"
 
 //! Forward declaration
 class XrdMqSharedObjectManager;
@@ -181,6 +184,11 @@ public:
   static std::atomic<unsigned long long> sSetCounter; ///< Counter for set operations
   static std::atomic<unsigned long long> sSetNLCounter; ///< Counter for set no-lock operations
   static std::atomic<unsigned long long> sGetCounter; ///< Counter for get operations
+  //! Source of change ids, shared by all hashes so that a hash recreated with
+  //! the same subject never repeats the change id of its predecessor
+  static std::atomic<unsigned long long> sChangeCounter;
+  //! Counter incremented by every modification of the hashes it is attached to
+  using Watcher = std::shared_ptr<std::atomic<unsigned long long>>;
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -224,6 +232,26 @@ public:
   //----------------------------------------------------------------------------
   unsigned int GetSize();
 
+  //----------------------------------------------------------------------------
+  //! Get change id of the hash. The id is updated by every modification of
+  //! the contents, so values derived from the hash can be cached as long as
+  //! the change id is the same.
+  //----------------------------------------------------------------------------
+  inline unsigned long long GetChangeId() const
+  {
+    return mChangeId.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Attach a watcher which is incremented together with the change id, so
+  //! that a set of hashes can be watched with a single counter. Attaching the
+  //! same watcher again has no effect and watchers not referenced anywhere
+  //! else any more are dropped.
+  //!
+  //! @param watcher counter to attach
+  //----------------------------------------------------------------------------
+  void AddWatcher(const Watcher& watcher);
+
   //----------------------------------------------------------------------------
   //! Get age in milliseconds for a certain key
   //!
@@ -449,6 +477,13 @@ private:
   mTransactMutex; ///< Mutex protecting the set of transactions
   std::unique_ptr<XrdMqRWMutex>
   mStoreMutex; ///< RW Mutex protecting the mStore object
+  std::atomic<unsigned long long> mChangeId; ///< Id of the last modification
+  std::vector<Watcher> mWatchers; ///< Counters bumped with mChangeId
+
+  //----------------------------------------------------------------------------
+  //! Record a modification of the contents - mStoreMutex must be write locked
+  //----------------------------------------------------------------------------
+  void Changed();
 
   //----------------------------------------------------------------------------
   //! Construct broadcast env header
@@ -486,6 +521,14 @@ private:
   //----------------------------------------------------------------------------
   void AddTransactionsToEnvString(XrdOucString& out, bool clearafter = true);
 
+  //----------------------------------------------------------------------------
+  //! Encode transactions as binary update message - this must be called with
+  //! the mTransactMutex locked.
+  //!
+  //! @param out output string containing header and binary encoded pairs
+  //----------------------------------------------------------------------------
+  void MakeBinaryUpdateEnvString(XrdOucString& out);
+
   //----------------------------------------------------------------------------
   //! Encode deletions as env string
   //!
@@ -607,6 +650,8 @@ private:
   pthread_t mDumperTid; ///< Dumper thread tid
   ///! Map of subjects to shared hash objects
   std::map<std::string, XrdMqSharedHash*> mHashSubjects;
+  //! Generation of mHashSubjects, updated by every creation and deletion
+  std::atomic<unsigned long long> mHashGeneration;
   ///! Map of subjects to shared queue objects
   std::map<std::string, XrdMqSharedQueue> mQueueSubjects;
   std::string mDumperFile; ///< File where dumps are written
@@ -619,6 +664,9 @@ private:
 public:
   static bool sDebug; ///< Set debug mode
   static bool sBroadcast; ///< Set broadcasting mode
+  //! Send updates in the binary encoding (EOS_MQ_BINARY_UPDATES=1), all
+  //! receivers have to understand it. Both encodings are always accepted.
+  static bool sBinaryUpdates;
 
   //----------------------------------------------------------------------------
   //! Constructor
@@ -660,6 +708,16 @@ public:
   };
 
   XrdMqRWMutex HashMutex;
+
+  //----------------------------------------------------------------------------
+  //! Get generation of the hash subjects, it changes every time a hash is
+  //! created or deleted. A hash pointer obtained with the HashMutex read lock
+  //! stays valid while the generation doesn't change.
+  //----------------------------------------------------------------------------
+  inline unsigned long long GetHashGeneration() const
+  {
+    return mHashGeneration.load();
+  }
   XrdMqRWMutex ListMutex;
 
   //----------------------------------------------------------------------------
@@ -839,6 +897,13 @@ public:
   //----------------------------------------------------------------------------
   void AddMuxTransactionEnvString(XrdOucString& out);
 
+  //----------------------------------------------------------------------------
+  //! Encode the mux transaction as binary update message
+  //!
+  //! @param out output string containing header and binary encoded pairs
+  //----------------------------------------------------------------------------
+  void MakeMuxBinaryUpdateEnvString(XrdOucString& out);
+
 protected:
   XrdSysMutex MuxTransactionsMutex; ///< protects the mux transaction map
   std::string MuxTransactionType; ///<
@@ -0,0 +1,265 @@
+// ----------------------------------------------------------------------
+// File: XrdMqSubscriptionIndex.hh
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __XRDMQ_SUBSCRIPTIONINDEX_HH__
+#define __XRDMQ_SUBSCRIPTIONINDEX_HH__
+
+#include "XrdOuc/XrdOucString.hh"
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Class XrdMqSubscriptionIndex
+//!
+//! @brief Index of the output queues connected to the broker, used to find
+//! the receivers of a message without looking at every queue. Exact names
+//! are a map lookup. For wildcard names the literal part before the first
+//! '*' selects a range of the queues ordered by name and the literal part
+//! after the last '*' a range of the queues ordered by reversed name; only
+//! the smaller range is checked with the usual XrdOucString::matches rule.
+//! The queues found for a wildcard name are cached until the next queue is
+//! added or removed, so that repeated broadcasts cost only the fan-out.
+//! Queues taking advisory status or query messages are kept in own lists.
+//!
+//! Returned queue lists are ordered by address, which is the order in which
+//! the broker locks several queues at once. The caller has to serialize
+//! Add/Remove against all other calls, lookups may run concurrently.
+//------------------------------------------------------------------------------
+template <typename T>
+class XrdMqSubscriptionIndex
+{
+public:
+  //! Maximum number of cached wildcard names
+  static constexpr size_t kMaxCachedPatterns = 1024;
+
+  //----------------------------------------------------------------------------
+  //! Add a queue
+  //!
+  //! @param name queue name
+  //! @param out queue object
+  //! @param advisory_status queue takes advisory status messages
+  //! @param advisory_query queue takes advisory query messages
+  //----------------------------------------------------------------------------
+  void Add(const std::string& name, T* out, bool advisory_status,
+           bool advisory_query)
+  {
+    mQueues[name] = out;
+    mReversed[std::string(name.rbegin(), name.rend())] = out;
+
+    if (advisory_status) {
+      mAdvisoryStatus[name] = out;
+    }
+
+    if (advisory_query) {
+      mAdvisoryQuery[name] = out;
+    }
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCache.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove a queue
+  //----------------------------------------------------------------------------
+  void Remove(const std::string& name)
+  {
+    mQueues.erase(name);
+    mReversed.erase(std::string(name.rbegin(), name.rend()));
+    mAdvisoryStatus.erase(name);
+    mAdvisoryQuery.erase(name);
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    mCache.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find a queue by exact name
+  //!
+  //! @return queue object or nullptr
+  //----------------------------------------------------------------------------
+  T* Find(const std::string& name) const
+  {
+    auto it = mQueues.find(name);
+    return ((it != mQueues.end()) ? it->second : nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Number of queues
+  //----------------------------------------------------------------------------
+  size_t Size() const
+  {
+    return mQueues.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find the queues taking advisory status or query messages
+  //!
+  //! @param query if true the query, otherwise the status subscribers
+  //! @param sender name of the sending queue, which is skipped
+  //! @param matched filled with the queues
+  //----------------------------------------------------------------------------
+  void MatchAdvisory(bool query, const std::string& sender,
+                     std::vector<T*>& matched) const
+  {
+    const std::map<std::string, T*>& queues = (query ? mAdvisoryQuery :
+        mAdvisoryStatus);
+    matched.clear();
+
+    for (const auto& queue : queues) {
+      if (queue.first != sender) {
+        matched.push_back(queue.second);
+      }
+    }
+
+    std::sort(matched.begin(), matched.end(), std::less<T*>());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find the queues matching a name which contains wildcards
+  //!
+  //! @param pattern queue name with '*' wildcards
+  //! @param sender name of the sending queue, which is skipped
+  //! @param matched filled with the queues
+  //----------------------------------------------------------------------------
+  void MatchWildcard(const std::string& pattern, const std::string& sender,
+                     std::vector<T*>& matched)
+  {
+    T* skip = Find(sender);
+    matched.clear();
+    {
+      std::lock_guard<std::mutex> lock(mCacheMutex);
+      auto it = mCache.find(pattern);
+
+      if (it != mCache.end()) {
+        Filter(it->second, skip, matched);
+        return;
+      }
+    }
+    std::vector<T*> all;
+    Scan(pattern, all);
+    Filter(all, skip, matched);
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    if (mCache.size() >= kMaxCachedPatterns) {
+      mCache.clear();
+    }
+
+    mCache[pattern].swap(all);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if a queue name matches a name with wildcards, like the broker
+  //! always did: all literal characters of the pattern have to match
+  //----------------------------------------------------------------------------
+  static bool Matches(const std::string& name, const std::string& pattern)
+  {
+    XrdOucString key = name.c_str();
+    XrdOucString nowildcard = pattern.c_str();
+    nowildcard.replace("*", "");
+    return (key.matches(pattern.c_str(), '*') == nowildcard.length());
+  }
+
+private:
+  typedef typename std::map<std::string, T*>::const_iterator const_iterator;
+
+  //----------------------------------------------------------------------------
+  //! Copy a queue list without the sender queue
+  //----------------------------------------------------------------------------
+  static void Filter(const std::vector<T*>& all, T* skip,
+                     std::vector<T*>& matched)
+  {
+    matched.reserve(all.size());
+
+    for (auto out : all) {
+      if (out != skip) {
+        matched.push_back(out);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if an iterator is still in the range of keys starting with key
+  //----------------------------------------------------------------------------
+  static bool InRange(const std::map<std::string, T*>& queues,
+                      const const_iterator& it, const std::string& key)
+  {
+    return ((it != queues.end()) &&
+            (it->first.compare(0, key.length(), key) == 0));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find all queues matching a wildcard name
+  //----------------------------------------------------------------------------
+  void Scan(const std::string& pattern, std::vector<T*>& all) const
+  {
+    std::string prefix = pattern.substr(0, pattern.find('*'));
+    std::string suffix = pattern.substr(pattern.rfind('*') + 1);
+    std::string rsuffix(suffix.rbegin(), suffix.rend());
+    const_iterator pbegin = mQueues.lower_bound(prefix);
+    const_iterator sbegin = mReversed.lower_bound(rsuffix);
+    const_iterator pit = pbegin;
+    const_iterator sit = sbegin;
+
+    // Walk both candidate ranges until the shorter one ends
+    while (InRange(mQueues, pit, prefix) && InRange(mReversed, sit, rsuffix)) {
+      ++pit;
+      ++sit;
+    }
+
+    bool by_prefix = !InRange(mQueues, pit, prefix);
+    const std::map<std::string, T*>& queues = (by_prefix ? mQueues : mReversed);
+    const std::string& key = (by_prefix ? prefix : rsuffix);
+
+    for (const_iterator it = (by_prefix ? pbegin : sbegin);
+         InRange(queues, it, key); ++it) {
+      if (by_prefix) {
+        if (Matches(it->first, pattern)) {
+          all.push_back(it->second);
+        }
+      } else {
+        if (Matches(std::string(it->first.rbegin(), it->first.rend()),
+                    pattern)) {
+          all.push_back(it->second);
+        }
+      }
+    }
+
+    std::sort(all.begin(), all.end(), std::less<T*>());
+  }
+
+  std::map<std::string, T*> mQueues; ///< Queues by name
+  std::map<std::string, T*> mReversed; ///< Queues by reversed name
+  std::map<std::string, T*> mAdvisoryStatus; ///< Advisory status subscribers
+  std::map<std::string, T*> mAdvisoryQuery; ///< Advisory query subscribers
+  std::mutex mCacheMutex; ///< Mutex protecting the cache
+  //! Queues matching a wildcard name, including a possible sender
+  std::unordered_map<std::string, std::vector<T*>> mCache;
+};
+
+template <typename T>
+constexpr size_t XrdMqSubscriptionIndex<T>::kMaxCachedPatterns;
+
+#endif
@@ -34,6 +34,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include <sys/time.h>
 #include <google/dense_hash_map>
 
@@ -317,8 +318,9 @@ public:
   //! Get iterator to the begining of the subcontainers map
   //----------------------------------------------------------------------------
   inline eos::IContainerMD::ContainerMap::const_iterator
-  subcontainersBegin() const
+  subcontainersBegin()
   {
+    loadChildren();
     return mSubcontainers.begin();
   }
 
@@ -326,8 +328,9 @@ public:
   //! Get iterator to the end of the subcontainers map
   //----------------------------------------------------------------------------
   inline eos::IContainerMD::ContainerMap::const_iterator
-  subcontainersEnd() const
+  subcontainersEnd()
   {
+    loadChildren();
     return mSubcontainers.end();
   }
 
@@ -335,8 +338,9 @@ public:
   //! Get iterator to the begining of the files map
   //----------------------------------------------------------------------------
   inline eos::IContainerMD::FileMap::const_iterator
-  filesBegin() const
+  filesBegin()
   {
+    loadChildren();
     return mFiles.begin();
   }
 
@@ -344,8 +348,9 @@ public:
   //! Get iterator to the end of the files map
   //----------------------------------------------------------------------------
   inline eos::IContainerMD::FileMap::const_iterator
-  filesEnd() const
+  filesEnd()
   {
+    loadChildren();
     return mFiles.end();
   }
 
@@ -367,6 +372,34 @@ public:
     return 0;
   }
 
+  //----------------------------------------------------------------------------
+  //! Cursor based listing of the names of the files and subcontainers.
+  //! Containers whose children are loaded only partially serve the names
+  //! page by page from the backend, without filling the in-memory maps. All
+  //! the others return all the names in one go.
+  //!
+  //! @param cursor "0" to start a listing, otherwise the value returned by
+  //!        the previous call
+  //! @param names vector where the names are appended
+  //!
+  //! @return cursor for the next call or "0" if the listing is complete
+  //----------------------------------------------------------------------------
+  virtual std::string scanChildNames(const std::string& cursor,
+                                     std::vector<std::string>& names)
+  {
+    names.reserve(names.size() + getNumFiles() + getNumContainers());
+
+    for (auto it = filesBegin(); it != filesEnd(); ++it) {
+      names.push_back(it->first);
+    }
+
+    for (auto it = subcontainersBegin(); it != subcontainersEnd(); ++it) {
+      names.push_back(it->first);
+    }
+
+    return "0";
+  }
+
   //----------------------------------------------------------------------------
   //! Get env representation of the container object
   //!
@@ -392,6 +425,12 @@ public:
   }
 
 protected:
+  //----------------------------------------------------------------------------
+  //! Make sure the maps below hold all the children before they are iterated,
+  //! for implementations which load them on demand
+  //----------------------------------------------------------------------------
+  virtual void loadChildren() {}
+
   ContainerMap mSubcontainers; //! Directory name to id map
   FileMap mFiles; ///< File name to id map
 
@@ -28,7 +28,9 @@
 #include "namespace/MDException.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include <google/dense_hash_set>
+#include <functional>
 #include <set>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -196,6 +198,67 @@ public:
   //----------------------------------------------------------------------------
   virtual bool hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Pick distinct files of a file system uniformly at random. The first call
+  //! for a file system builds its sampling index, afterwards each pick is
+  //! O(1) independently of the number of files on the file system.
+  //!
+  //! @param location file system id
+  //! @param n number of files requested
+  //! @param fids vector filled with at most n file ids in random order
+  //----------------------------------------------------------------------------
+  virtual void getRandomFiles(IFileMD::location_t location, size_t n,
+                              std::vector<IFileMD::id_t>& fids) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Pick files of a file system at random, stratified by size. A uniform
+  //! sample of oversample * n files is split into power of two size classes
+  //! and the result takes the files round-robin from the classes, so that
+  //! the few large files are not hidden behind the many small ones.
+  //!
+  //! @param location file system id
+  //! @param n number of files requested
+  //! @param size_of function returning the size of a file id
+  //! @param fids vector filled with at most n file ids
+  //! @param oversample size of the uniform sample relative to n
+  //----------------------------------------------------------------------------
+  virtual void getRandomFilesBySize(IFileMD::location_t location, size_t n,
+                                    const std::function<uint64_t(IFileMD::id_t)>& size_of,
+                                    std::vector<IFileMD::id_t>& fids,
+                                    size_t oversample = 8)
+  {
+    std::vector<IFileMD::id_t> candidates;
+    getRandomFiles(location, n * oversample, candidates);
+    fids.clear();
+
+    if (candidates.size() <= n) {
+      fids.swap(candidates);
+      return;
+    }
+
+    std::vector<std::vector<IFileMD::id_t>> classes(65);
+
+    for (auto fid : candidates) {
+      uint64_t size = size_of(fid);
+      size_t cls = 0;
+
+      while (size) {
+        size >>= 1;
+        ++cls;
+      }
+
+      classes[cls].push_back(fid);
+    }
+
+    for (size_t round = 0; fids.size() < n; ++round) {
+      for (const auto& cls : classes) {
+        if ((round < cls.size()) && (fids.size() < n)) {
+          fids.push_back(cls[round]);
+        }
+      }
+    }
+  }
+
   //----------------------------------------------------------------------------
   //! Finalize
   //----------------------------------------------------------------------------
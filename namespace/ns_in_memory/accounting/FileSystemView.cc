@@ -85,6 +85,7 @@ void FileSystemView::fileMDChanged(IFileMDChangeListener::Event* e)
     resize(pFiles, e->location + 1);
     resize(pUnlinkedFiles, e->location + 1);
     pFiles[e->location].insert(e->file->getId());
+    mSampler.insert(e->location, e->file->getId());
     pNoReplicas.erase(e->file->getId());
     break;
 
@@ -100,6 +101,8 @@ void FileSystemView::fileMDChanged(IFileMDChangeListener::Event* e)
     resize(pUnlinkedFiles, e->location + 1);
     pFiles[e->oldLocation].erase(e->file->getId());
     pFiles[e->location].insert(e->file->getId());
+    mSampler.erase(e->oldLocation, e->file->getId());
+    mSampler.insert(e->location, e->file->getId());
     break;
 
   //------------------------------------------------------------------------
@@ -127,6 +130,7 @@ void FileSystemView::fileMDChanged(IFileMDChangeListener::Event* e)
     }
 
     pFiles[e->location].erase(e->file->getId());
+    mSampler.erase(e->location, e->file->getId());
     pUnlinkedFiles[e->location].insert(e->file->getId());
     break;
 
@@ -147,6 +151,7 @@ void FileSystemView::fileMDRead(IFileMD* obj)
     resize(pFiles, *it + 1);
     resize(pUnlinkedFiles, *it + 1);
     pFiles[*it].insert(obj->getId());
+    mSampler.insert(*it, obj->getId());
   }
 
   IFileMD::LocationVector unlink_vect = obj->getUnlinkedLocations();
@@ -218,6 +223,7 @@ void FileSystemView::finalize()
   pFiles.clear();
   pUnlinkedFiles.clear();
   pNoReplicas.clear();
+  mSampler.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -261,6 +267,21 @@ FileSystemView::getNumUnlinkedFilesOnFs(IFileMD::location_t fs_id)
   return pUnlinkedFiles[fs_id].size();
 }
 
+//------------------------------------------------------------------------------
+// Pick distinct files of a file system uniformly at random
+//------------------------------------------------------------------------------
+void
+FileSystemView::getRandomFiles(IFileMD::location_t location, size_t n,
+                               std::vector<IFileMD::id_t>& fids)
+{
+  if (pFiles.size() <= location) {
+    fids.clear();
+    return;
+  }
+
+  mSampler.getRandomFiles(location, pFiles[location], n, fids);
+}
+
 //------------------------------------------------------------------------------
 // Check if file system has file id
 //------------------------------------------------------------------------------
@@ -27,6 +27,7 @@
 #include "namespace/MDException.hh"
 #include "namespace/Namespace.hh"
 #include "namespace/interface/IFsView.hh"
+#include "namespace/utils/FileListSampler.hh"
 #include <utility>
 
 EOSNSNAMESPACE_BEGIN
@@ -165,6 +166,16 @@ public:
   //----------------------------------------------------------------------------
   bool hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id) override;
 
+  //----------------------------------------------------------------------------
+  //! Pick distinct files of a file system uniformly at random
+  //!
+  //! @param location file system id
+  //! @param n number of files requested
+  //! @param fids vector filled with at most n file ids in random order
+  //----------------------------------------------------------------------------
+  void getRandomFiles(IFileMD::location_t location, size_t n,
+                      std::vector<IFileMD::id_t>& fids) override;
+
   //----------------------------------------------------------------------------
   //! Configure
   //!
@@ -196,6 +207,7 @@ private:
   std::vector<IFsView::FileList> pFiles;
   std::vector<IFsView::FileList> pUnlinkedFiles;
   IFsView::FileList              pNoReplicas;
+  FsViewSampler                  mSampler; ///< Random sampling indexes
 };
 
 EOSNSNAMESPACE_END
@@ -27,20 +27,82 @@
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include <sys/stat.h>
 #include <algorithm>
+#include <future>
 
 EOSNSNAMESPACE_BEGIN
 
+//------------------------------------------------------------------------------
+// Check that a reply has the HSCAN layout: cursor, [field, value, ...]
+//------------------------------------------------------------------------------
+static bool
+isScanReply(const qclient::redisReplyPtr& reply)
+{
+  return (reply && (reply->type == REDIS_REPLY_ARRAY) &&
+          (reply->elements == 2) &&
+          (reply->element[0]->type == REDIS_REPLY_STRING) &&
+          (reply->element[1]->type == REDIS_REPLY_ARRAY) &&
+          ((reply->element[1]->elements % 2) == 0));
+}
+
+//------------------------------------------------------------------------------
+// Check if an HSCAN reply is the last page
+//------------------------------------------------------------------------------
+static bool
+isLastPage(const qclient::redisReplyPtr& reply)
+{
+  return (std::string(reply->element[0]->str, reply->element[0]->len) == "0");
+}
+
+//------------------------------------------------------------------------------
+// Get the value of an integer reply
+//------------------------------------------------------------------------------
+static uint64_t
+getInteger(const qclient::redisReplyPtr& reply)
+{
+  if (!reply || (reply->type != REDIS_REPLY_INTEGER)) {
+    throw std::runtime_error("unexpected integer reply");
+  }
+
+  return reply->integer;
+}
+
+//------------------------------------------------------------------------------
+// Track a child added to a partially loaded container
+//------------------------------------------------------------------------------
+static void
+rememberChild(std::unordered_set<std::string>& added,
+              std::unordered_set<std::string>& removed, const std::string& name)
+{
+  added.insert(name);
+  removed.erase(name);
+}
+
+//------------------------------------------------------------------------------
+// Track a child removed from a partially loaded container
+//------------------------------------------------------------------------------
+template <typename MapT>
+static void
+forgetChild(MapT& map, std::unordered_set<std::string>& added,
+            std::unordered_set<std::string>& removed, const std::string& name)
+{
+  map.erase(name);
+  added.erase(name);
+  removed.insert(name);
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 ContainerMD::ContainerMD(id_t id, IFileMDSvc* file_svc,
                          IContainerMDSvc* cont_svc)
-  : IContainerMD(), pContSvc(cont_svc), pFileSvc(file_svc),
+  : IContainerMD(), mCont(mArena.get()), pContSvc(cont_svc),
+    pFileSvc(file_svc),
     pFilesKey(stringify(id) + constants::sMapFilesSuffix),
-    pDirsKey(stringify(id) + constants::sMapDirsSuffix), mClock(1)
+    pDirsKey(stringify(id) + constants::sMapDirsSuffix), mClock(1),
+    mPartial(false), mLoaded(true), mNumFiles(0), mNumDirs(0)
 {
-  mCont.set_id(id);
-  mCont.set_mode(040755);
+  mCont->set_id(id);
+  mCont->set_mode(040755);
   ContainerMDSvc* impl_cont_svc = dynamic_cast<ContainerMDSvc*>(cont_svc);
 
   if (!impl_cont_svc) {
@@ -67,7 +129,9 @@ ContainerMD::clone() const
 //------------------------------------------------------------------------------
 // Copy constructor
 //------------------------------------------------------------------------------
-ContainerMD::ContainerMD(const ContainerMD& other)
+ContainerMD::ContainerMD(const ContainerMD& other):
+  IContainerMD(), mCont(mArena.get()), mPartial(false), mLoaded(true),
+  mNumFiles(0), mNumDirs(0)
 {
   *this = other;
 }
@@ -77,7 +141,13 @@ ContainerMD::ContainerMD(const ContainerMD& other)
 //------------------------------------------------------------------------------
 ContainerMD& ContainerMD::operator= (const ContainerMD& other)
 {
-  mCont    = other.mCont;
+  if (this == &other) {
+    return *this;
+  }
+
+  // Start from an arena sized after the copied object
+  mCont    = mArena.reset(other.mCont->ByteSizeLong());
+  mCont->CopyFrom(*other.mCont);
   pContSvc = other.pContSvc;
   pFileSvc = other.pFileSvc;
   pQcl     = other.pQcl;
@@ -96,16 +166,26 @@ ContainerMD& ContainerMD::operator= (const ContainerMD& other)
 std::shared_ptr<IContainerMD>
 ContainerMD::findContainer(const std::string& name)
 {
-  auto iter = mSubcontainers.find(name);
+  id_t id = 0;
 
-  if (iter == mSubcontainers.end()) {
-    return nullptr;
+  if (mPartial) {
+    if (!findPartial(pDirsMap, mSubcontainers, mRemovedDirs, name, id)) {
+      return nullptr;
+    }
+  } else {
+    auto iter = mSubcontainers.find(name);
+
+    if (iter == mSubcontainers.end()) {
+      return nullptr;
+    }
+
+    id = iter->second;
   }
 
   std::shared_ptr<IContainerMD> cont;
 
   try {
-    cont = pContSvc->getContainerMD(iter->second);
+    cont = pContSvc->getContainerMD(id);
   } catch (const MDException& ex) {
     cont = nullptr;
   }
@@ -113,7 +193,14 @@ ContainerMD::findContainer(const std::string& name)
   // Curate the list of subcontainers in case entry is not found
   if (cont == nullptr) {
     pFlusher->hdel(pDirsKey, name);
-    mSubcontainers.erase(iter);
+
+    if (mPartial) {
+      std::lock_guard<std::mutex> lock(mChildrenMutex);
+      forgetChild(mSubcontainers, mAddedDirs, mRemovedDirs, name);
+      --mNumDirs;
+    } else {
+      mSubcontainers.erase(name);
+    }
   }
 
   return cont;
@@ -125,16 +212,31 @@ ContainerMD::findContainer(const std::string& name)
 void
 ContainerMD::removeContainer(const std::string& name)
 {
-  auto it = mSubcontainers.find(name);
+  if (mPartial) {
+    id_t id = 0;
 
-  if (it == mSubcontainers.end()) {
-    MDException e(ENOENT);
-    e.getMessage()  << __FUNCTION__ << " Container " << name << " not found";
-    throw e;
+    if (!findPartial(pDirsMap, mSubcontainers, mRemovedDirs, name, id)) {
+      MDException e(ENOENT);
+      e.getMessage()  << __FUNCTION__ << " Container " << name << " not found";
+      throw e;
+    }
+
+    std::lock_guard<std::mutex> lock(mChildrenMutex);
+    forgetChild(mSubcontainers, mAddedDirs, mRemovedDirs, name);
+    --mNumDirs;
+  } else {
+    auto it = mSubcontainers.find(name);
+
+    if (it == mSubcontainers.end()) {
+      MDException e(ENOENT);
+      e.getMessage()  << __FUNCTION__ << " Container " << name << " not found";
+      throw e;
+    }
+
+    mSubcontainers.erase(it);
+    mSubcontainers.resize(0);
   }
 
-  mSubcontainers.erase(it);
-  mSubcontainers.resize(0);
   // Delete container also from KV backend
   pFlusher->hdel(pDirsKey, name);
 }
@@ -145,15 +247,33 @@ ContainerMD::removeContainer(const std::string& name)
 void
 ContainerMD::addContainer(IContainerMD* container)
 {
-  container->setParentId(mCont.id());
-  auto ret = mSubcontainers.insert(std::make_pair(container->getName(),
-                                   container->getId()));
+  container->setParentId(mCont->id());
+  bool inserted = true;
+
+  if (mPartial) {
+    id_t id = 0;
+
+    if (findPartial(pDirsMap, mSubcontainers, mRemovedDirs,
+                    container->getName(), id)) {
+      inserted = false;
+    } else {
+      std::lock_guard<std::mutex> lock(mChildrenMutex);
+      mSubcontainers.insert(std::make_pair(container->getName(),
+                                           container->getId()));
+      rememberChild(mAddedDirs, mRemovedDirs, container->getName());
+      ++mNumDirs;
+    }
+  } else {
+    auto ret = mSubcontainers.insert(std::make_pair(container->getName(),
+                                     container->getId()));
+    inserted = ret.second;
+  }
 
   // @todo (esindril): Here we (should ?!) follow the behaviour of the namespace
   // in memory and don't do any extra checks but this can lead to multiple
   // accounting of this file in the quota view since the listeners are notified
   // every time we call this ....
-  if (!ret.second) {
+  if (!inserted) {
     eos::MDException e(EINVAL);
     e.getMessage()  << __FUNCTION__ << " Container with name \""
                     << container->getName() << "\" already exists";
@@ -170,16 +290,26 @@ ContainerMD::addContainer(IContainerMD* container)
 std::shared_ptr<IFileMD>
 ContainerMD::findFile(const std::string& name)
 {
-  auto iter = mFiles.find(name);
+  id_t id = 0;
+
+  if (mPartial) {
+    if (!findPartial(pFilesMap, mFiles, mRemovedFiles, name, id)) {
+      return nullptr;
+    }
+  } else {
+    auto iter = mFiles.find(name);
 
-  if (iter == mFiles.end()) {
-    return nullptr;
+    if (iter == mFiles.end()) {
+      return nullptr;
+    }
+
+    id = iter->second;
   }
 
   std::shared_ptr<IFileMD> file;
 
   try {
-    file = pFileSvc->getFileMD(iter->second);
+    file = pFileSvc->getFileMD(id);
   } catch (MDException& e) {
     file = nullptr;
   }
@@ -187,7 +317,14 @@ ContainerMD::findFile(const std::string& name)
   // Curate the list of files in case file entry is not found
   if (file == nullptr) {
     pFlusher->hdel(pFilesKey, name);
-    mFiles.erase(iter);
+
+    if (mPartial) {
+      std::lock_guard<std::mutex> lock(mChildrenMutex);
+      forgetChild(mFiles, mAddedFiles, mRemovedFiles, name);
+      --mNumFiles;
+    } else {
+      mFiles.erase(name);
+    }
   }
 
   return file;
@@ -199,8 +336,17 @@ ContainerMD::findFile(const std::string& name)
 void
 ContainerMD::addFile(IFileMD* file)
 {
-  file->setContainerId(mCont.id());
-  (void)mFiles.insert(std::make_pair(file->getName(), file->getId()));
+  file->setContainerId(mCont->id());
+
+  if (mPartial) {
+    std::lock_guard<std::mutex> lock(mChildrenMutex);
+    (void)mFiles.insert(std::make_pair(file->getName(), file->getId()));
+    rememberChild(mAddedFiles, mRemovedFiles, file->getName());
+    ++mNumFiles;
+  } else {
+    (void)mFiles.insert(std::make_pair(file->getName(), file->getId()));
+  }
+
   // @todo (esindril): Here we follow the behaviour of the namespace in memory
   // and don't do any extra checks but this can lead to multiple accounting
   // of this file in the quota view since the listeners are notified every
@@ -225,27 +371,42 @@ ContainerMD::addFile(IFileMD* file)
 void
 ContainerMD::removeFile(const std::string& name)
 {
-  auto iter = mFiles.find(name);
+  IFileMD::id_t id = 0;
 
-  if (iter != mFiles.end()) {
-    IFileMD::id_t id = iter->second;
+  if (mPartial) {
+    if (!findPartial(pFilesMap, mFiles, mRemovedFiles, name, id)) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mChildrenMutex);
+    forgetChild(mFiles, mAddedFiles, mRemovedFiles, name);
+    --mNumFiles;
+  } else {
+    auto iter = mFiles.find(name);
+
+    if (iter == mFiles.end()) {
+      return;
+    }
+
+    id = iter->second;
     mFiles.erase(iter);
     mFiles.resize(0);
-    // Do async call to KV backend
-    pFlusher->hdel(pFilesKey, name);
+  }
 
-    try {
-      std::shared_ptr<IFileMD> file = pFileSvc->getFileMD(id);
-      // NOTE: This is an ugly hack. The file object has no reference to the
-      // container id, therefore we hijack the "location" member of the Event
-      // class to pass in the container id.
-      IFileMDChangeListener::Event
-      e(file.get(), IFileMDChangeListener::SizeChange, mCont.id(),
-        0, -file->getSize());
-      pFileSvc->notifyListeners(&e);
-    } catch (MDException& e) {
-      // File already removed
-    }
+  // Do async call to KV backend
+  pFlusher->hdel(pFilesKey, name);
+
+  try {
+    std::shared_ptr<IFileMD> file = pFileSvc->getFileMD(id);
+    // NOTE: This is an ugly hack. The file object has no reference to the
+    // container id, therefore we hijack the "location" member of the Event
+    // class to pass in the container id.
+    IFileMDChangeListener::Event
+    e(file.get(), IFileMDChangeListener::SizeChange, mCont->id(),
+      0, -file->getSize());
+    pFileSvc->notifyListeners(&e);
+  } catch (MDException& e) {
+    // File already removed
   }
 }
 
@@ -255,7 +416,12 @@ ContainerMD::removeFile(const std::string& name)
 size_t
 ContainerMD::getNumFiles()
 {
-  return mFiles.size();
+  if (mLoaded) {
+    return mFiles.size();
+  }
+
+  std::lock_guard<std::mutex> lock(mChildrenMutex);
+  return (mLoaded ? mFiles.size() : mNumFiles);
 }
 
 //----------------------------------------------------------------------------
@@ -264,7 +430,12 @@ ContainerMD::getNumFiles()
 size_t
 ContainerMD::getNumContainers()
 {
-  return mSubcontainers.size();
+  if (mLoaded) {
+    return mSubcontainers.size();
+  }
+
+  std::lock_guard<std::mutex> lock(mChildrenMutex);
+  return (mLoaded ? mSubcontainers.size() : mNumDirs);
 }
 
 //------------------------------------------------------------------------
@@ -274,6 +445,8 @@ ContainerMD::getNumContainers()
 void
 ContainerMD::cleanUp()
 {
+  loadChildren();
+
   for (const auto& elem : mFiles) {
     auto file = pFileSvc->getFileMD(elem.second);
     pFileSvc->removeFile(file.get());
@@ -291,6 +464,18 @@ ContainerMD::cleanUp()
   }
 
   mSubcontainers.clear();
+
+  if (mPartial) {
+    // All the children are gone, no need to track the changes anymore
+    std::lock_guard<std::mutex> lock(mChildrenMutex);
+    mAddedFiles.clear();
+    mAddedDirs.clear();
+    mRemovedFiles.clear();
+    mRemovedDirs.clear();
+    mNumFiles = mNumDirs = 0;
+    mPartial = false;
+  }
+
   // Delete files and subcontainers map from the KV backend
   pFlusher->del(pFilesKey);
   pFlusher->del(pDirsKey);
@@ -409,17 +594,17 @@ ContainerMD::access(uid_t uid, gid_t gid, int flags)
   }
 
   // Check the perms
-  if (uid == mCont.uid()) {
-    char user = convertModetUser(mCont.mode());
+  if (uid == mCont->uid()) {
+    char user = convertModetUser(mCont->mode());
     return checkPerms(user, convFlags);
   }
 
-  if (gid == mCont.gid()) {
-    char group = convertModetGroup(mCont.mode());
+  if (gid == mCont->gid()) {
+    char group = convertModetGroup(mCont->mode());
     return checkPerms(group, convFlags);
   }
 
-  char other = convertModetOther(mCont.mode());
+  char other = convertModetOther(mCont->mode());
   return checkPerms(other, convFlags);
 }
 
@@ -430,15 +615,15 @@ void
 ContainerMD::setName(const std::string& name)
 {
   // // Check that there is no clash with other subcontainers having the same name
-  // if (mCont.parent_id() != 0u) {
-  //   auto parent = pContSvc->getContainerMD(mCont.parent_id());
+  // if (mCont->parent_id() != 0u) {
+  //   auto parent = pContSvc->getContainerMD(mCont->parent_id());
   //   if (parent->findContainer(name)) {
   //     eos::MDException e(EINVAL);
   //     e.getMessage() << "Container with name \"" << name << "\" already exists";
   //     throw e;
   //   }
   // }
-  mCont.set_name(name);
+  mCont->set_name(name);
 }
 
 //------------------------------------------------------------------------------
@@ -447,7 +632,7 @@ ContainerMD::setName(const std::string& name)
 void
 ContainerMD::setCTime(ctime_t ctime)
 {
-  mCont.set_ctime(&ctime, sizeof(ctime));
+  mCont->set_ctime(&ctime, sizeof(ctime));
 }
 
 //------------------------------------------------------------------------------
@@ -465,7 +650,7 @@ ContainerMD::setCTimeNow()
 #else
   clock_gettime(CLOCK_REALTIME, &tnow);
 #endif
-  mCont.set_ctime(&tnow, sizeof(tnow));
+  mCont->set_ctime(&tnow, sizeof(tnow));
 }
 
 //------------------------------------------------------------------------------
@@ -474,7 +659,7 @@ ContainerMD::setCTimeNow()
 void
 ContainerMD::getCTime(ctime_t& ctime) const
 {
-  (void) memcpy(&ctime, mCont.ctime().data(), sizeof(ctime));
+  (void) memcpy(&ctime, mCont->ctime().data(), sizeof(ctime));
 }
 
 //------------------------------------------------------------------------------
@@ -483,7 +668,7 @@ ContainerMD::getCTime(ctime_t& ctime) const
 void
 ContainerMD::setMTime(mtime_t mtime)
 {
-  mCont.set_mtime(&mtime, sizeof(mtime));
+  mCont->set_mtime(&mtime, sizeof(mtime));
 }
 
 //------------------------------------------------------------------------------
@@ -501,7 +686,7 @@ ContainerMD::setMTimeNow()
 #else
   clock_gettime(CLOCK_REALTIME, &tnow);
 #endif
-  mCont.set_mtime(&tnow, sizeof(tnow));
+  mCont->set_mtime(&tnow, sizeof(tnow));
 }
 
 //------------------------------------------------------------------------------
@@ -510,7 +695,7 @@ ContainerMD::setMTimeNow()
 void
 ContainerMD::getMTime(mtime_t& mtime) const
 {
-  (void) memcpy(&mtime, mCont.mtime().data(), sizeof(mtime));
+  (void) memcpy(&mtime, mCont->mtime().data(), sizeof(mtime));
 }
 
 //------------------------------------------------------------------------------
@@ -526,7 +711,7 @@ ContainerMD::setTMTime(tmtime_t tmtime)
       (tmtime.tv_sec > tmt.tv_sec) ||
       ((tmtime.tv_sec == tmt.tv_sec) &&
        (tmtime.tv_nsec > tmt.tv_nsec))) {
-    mCont.set_stime(&tmtime, sizeof(tmtime));
+    mCont->set_stime(&tmtime, sizeof(tmtime));
     return true;
   }
 
@@ -557,7 +742,7 @@ ContainerMD::setTMTimeNow()
 void
 ContainerMD::getTMTime(tmtime_t& tmtime)
 {
-  (void) memcpy(&tmtime, mCont.stime().data(), sizeof(tmtime));
+  (void) memcpy(&tmtime, mCont->stime().data(), sizeof(tmtime));
 }
 
 //------------------------------------------------------------------------------
@@ -576,7 +761,7 @@ ContainerMD::notifyMTimeChange(IContainerMDSvc* containerMDSvc)
 uint64_t
 ContainerMD::updateTreeSize(int64_t delta)
 {
-  uint64_t sz = mCont.tree_size();
+  uint64_t sz = mCont->tree_size();
 
   // Avoid usigned underflow
   if ((delta < 0) && (std::llabs(delta) > sz)) {
@@ -585,7 +770,7 @@ ContainerMD::updateTreeSize(int64_t delta)
     sz += delta;
   }
 
-  mCont.set_tree_size(sz);
+  mCont->set_tree_size(sz);
   return sz;
 }
 
@@ -595,9 +780,9 @@ ContainerMD::updateTreeSize(int64_t delta)
 std::string
 ContainerMD::getAttribute(const std::string& name) const
 {
-  auto it = mCont.xattrs().find(name);
+  auto it = mCont->xattrs().find(name);
 
-  if (it == mCont.xattrs().end()) {
+  if (it == mCont->xattrs().end()) {
     MDException e(ENOENT);
     e.getMessage()  << __FUNCTION__  << " Attribute: " << name << " not found";
     throw e;
@@ -612,10 +797,10 @@ ContainerMD::getAttribute(const std::string& name) const
 void
 ContainerMD::removeAttribute(const std::string& name)
 {
-  auto it = mCont.xattrs().find(name);
+  auto it = mCont->xattrs().find(name);
 
-  if (it != mCont.xattrs().end()) {
-    mCont.mutable_xattrs()->erase(it->first);
+  if (it != mCont->xattrs().end()) {
+    mCont->mutable_xattrs()->erase(it->first);
   }
 }
 
@@ -627,7 +812,9 @@ ContainerMD::serialize(Buffer& buffer)
 {
   // Align the buffer to 4 bytes to efficiently compute the checksum
   ++mClock;
-  size_t obj_size = mCont.ByteSizeLong();
+  size_t obj_size = mCont->ByteSizeLong();
+  // Give back the space left behind by updates of the object
+  mCont = mArena.compact(obj_size);
   uint32_t align_size = (obj_size + 3) >> 2 << 2;
   size_t sz = sizeof(align_size);
   size_t msg_size = align_size + 2 * sz;
@@ -637,12 +824,14 @@ ContainerMD::serialize(Buffer& buffer)
   const char* ptr = buffer.getDataPtr() + 2 * sz;
   google::protobuf::io::ArrayOutputStream aos((void*)ptr, align_size);
 
-  if (!mCont.SerializeToZeroCopyStream(&aos)) {
+  if (!mCont->SerializeToZeroCopyStream(&aos)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while serializing buffer";
     throw ex;
   }
 
+  // The buffer may be reused so clear the alignment padding
+  (void) memset((void*)(ptr + obj_size), 0, align_size - obj_size);
   // Compute the CRC32C checkusm
   uint32_t cksum = DataHelper::computeCRC32C((void*)ptr, align_size);
   cksum = DataHelper::finalizeCRC32C(cksum);
@@ -658,15 +847,23 @@ ContainerMD::serialize(Buffer& buffer)
 //------------------------------------------------------------------------------
 void
 ContainerMD::deserialize(Buffer& buffer)
+{
+  deserialize(buffer.getDataPtr(), buffer.getSize());
+}
+
+//------------------------------------------------------------------------------
+// Deserialize directly from a memory region
+//------------------------------------------------------------------------------
+void
+ContainerMD::deserialize(const char* data, size_t msg_size)
 {
   uint32_t cksum_expected = 0;
   uint32_t obj_size = 0;
   size_t sz = sizeof(cksum_expected);
-  const char* ptr = buffer.getDataPtr();
+  const char* ptr = data;
   (void) memcpy(&cksum_expected, ptr, sz);
   ptr += sz;
   (void) memcpy(&obj_size, ptr, sz);
-  size_t msg_size = buffer.getSize();
   uint32_t align_size = msg_size - 2 * sz;
   ptr += sz; // now pointing to the serialized object
   uint32_t cksum_computed = DataHelper::computeCRC32C((void*)ptr, align_size);
@@ -679,56 +876,318 @@ ContainerMD::deserialize(Buffer& buffer)
   }
 
   google::protobuf::io::ArrayInputStream ais(ptr, obj_size);
+  // Parse into a fresh arena sized after the object
+  mCont = mArena.reset(obj_size);
 
-  if (!mCont.ParseFromZeroCopyStream(&ais)) {
+  if (!mCont->ParseFromZeroCopyStream(&ais)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while deserializing buffer";
     throw ex;
   }
 
   // Rebuild the file and subcontainer keys
-  pFilesKey = stringify(mCont.id()) + constants::sMapFilesSuffix;
+  pFilesKey = stringify(mCont->id()) + constants::sMapFilesSuffix;
   pFilesMap.setKey(pFilesKey);
-  pDirsKey = stringify(mCont.id()) + constants::sMapDirsSuffix;
+  pDirsKey = stringify(mCont->id()) + constants::sMapDirsSuffix;
   pDirsMap.setKey(pDirsKey);
 
-  // Grab the files and subcontainers
-  constexpr int64_t count = 2000000;
-
+  // Grab the files and subcontainers concurrently, page by page
   if (pQcl) {
     try {
-      std::string cursor = "0";
-      std::pair<std::string, std::unordered_map<std::string, std::string>> reply;
-
-      do {
-        reply = pFilesMap.hscan(cursor, count);
-        cursor = reply.first;
+      const int64_t count = getScanPageSize();
+      auto files_req = requestPage(pFilesKey, "0", count);
+      auto dirs_req = requestPage(pDirsKey, "0", count);
+      qclient::redisReplyPtr files = files_req.get();
+      qclient::redisReplyPtr dirs = dirs_req.get();
+
+      if (!isScanReply(files) || !isScanReply(dirs)) {
+        throw std::runtime_error("unexpected HSCAN reply");
+      }
 
-        for (const auto& elem : reply.second) {
-          mFiles.insert(std::make_pair(elem.first, std::stoull(elem.second)));
+      if (!isLastPage(files) || !isLastPage(dirs)) {
+        // More than one page - big containers are loaded on demand
+        auto nfiles_req = pQcl->exec("HLEN", pFilesKey);
+        auto ndirs_req = pQcl->exec("HLEN", pDirsKey);
+        uint64_t nfiles = getInteger(nfiles_req.get());
+        uint64_t ndirs = getInteger(ndirs_req.get());
+
+        if (nfiles + ndirs >= getPartialLoadSize()) {
+          mNumFiles = nfiles;
+          mNumDirs = ndirs;
+          mPartial = true;
+          mLoaded = false;
+          return;
         }
-      } while (cursor != "0");
-
-      // Get the subcontainers
-      cursor = "0";
-
-      do {
-        reply = pDirsMap.hscan(cursor, count);
-        cursor = reply.first;
+      }
 
-        for (const auto& elem : reply.second) {
-          mSubcontainers.insert(std::make_pair(elem.first, std::stoull(elem.second)));
-        }
-      } while (cursor != "0");
+      scanPages(pFilesKey, std::move(files),
+      [this](const std::string & name, const std::string & id) {
+        mFiles.insert(std::make_pair(name, std::stoull(id)));
+      });
+      scanPages(pDirsKey, std::move(dirs),
+      [this](const std::string & name, const std::string & id) {
+        mSubcontainers.insert(std::make_pair(name, std::stoull(id)));
+      });
     } catch (std::runtime_error& qdb_err) {
       MDException e(ENOENT);
-      e.getMessage()  << __FUNCTION__  << " Container #" << mCont.id()
+      e.getMessage()  << __FUNCTION__  << " Container #" << mCont->id()
                       << " failed to get subentries";
       throw e;
     }
   }
 }
 
+// Definition of class static members
+constexpr int64_t ContainerMD::sDefaultScanPageSize;
+constexpr uint64_t ContainerMD::sDefaultPartialLoadSize;
+std::atomic<uint64_t> ContainerMD::sPartialLoadSize([]() {
+  const char* ptr = getenv("EOS_NS_QDB_PARTIAL_LOAD");
+  uint64_t sz = (ptr ? strtoull(ptr, nullptr, 10) : 0);
+  return ((sz > 0) ? sz : sDefaultPartialLoadSize);
+}());
+
+//------------------------------------------------------------------------------
+// Get the number of entries requested per HSCAN page
+//------------------------------------------------------------------------------
+int64_t
+ContainerMD::getScanPageSize()
+{
+  static int64_t page_size = []() {
+    const char* ptr = getenv("EOS_NS_QDB_HSCAN_PAGE");
+    int64_t sz = (ptr ? strtoll(ptr, nullptr, 10) : 0);
+    return ((sz > 0) ? sz : sDefaultScanPageSize);
+  }();
+  return page_size;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of children from which a container is loaded partially
+//------------------------------------------------------------------------------
+uint64_t
+ContainerMD::getPartialLoadSize()
+{
+  return sPartialLoadSize;
+}
+
+//------------------------------------------------------------------------------
+// Set the number of children from which a container is loaded partially
+//------------------------------------------------------------------------------
+void
+ContainerMD::setPartialLoadSize(uint64_t size)
+{
+  sPartialLoadSize = size;
+}
+
+//------------------------------------------------------------------------------
+// Request one HSCAN page of a QuarkDB hash
+//------------------------------------------------------------------------------
+std::future<qclient::redisReplyPtr>
+ContainerMD::requestPage(const std::string& key, const std::string& cursor,
+                         int64_t count)
+{
+  return pQcl->exec("HSCAN", key, cursor, "COUNT", std::to_string(count));
+}
+
+//------------------------------------------------------------------------------
+// Go through all the pages of a QuarkDB hash, the next page is requested
+// before the current one is processed
+//------------------------------------------------------------------------------
+template <typename Func>
+void
+ContainerMD::scanPages(const std::string& key, qclient::redisReplyPtr reply,
+                       Func&& func)
+{
+  const int64_t count = getScanPageSize();
+  std::future<qclient::redisReplyPtr> request;
+
+  while (true) {
+    if (!isScanReply(reply)) {
+      throw std::runtime_error("unexpected HSCAN reply for " + key);
+    }
+
+    std::string cursor(reply->element[0]->str, reply->element[0]->len);
+
+    if (cursor != "0") {
+      request = requestPage(key, cursor, count);
+    }
+
+    redisReply* page = reply->element[1];
+
+    for (size_t i = 0; i < page->elements; i += 2) {
+      func(std::string(page->element[i]->str, page->element[i]->len),
+           std::string(page->element[i + 1]->str, page->element[i + 1]->len));
+    }
+
+    if (cursor == "0") {
+      break;
+    }
+
+    reply = request.get();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the id of a child of a partially loaded container
+//------------------------------------------------------------------------------
+template <typename MapT>
+bool
+ContainerMD::findPartial(qclient::QHash& hash, const MapT& map,
+                         const std::unordered_set<std::string>& removed,
+                         const std::string& name, id_t& id)
+{
+  {
+    std::lock_guard<std::mutex> lock(mChildrenMutex);
+    auto iter = map.find(name);
+
+    if (iter != map.end()) {
+      id = iter->second;
+      return true;
+    }
+
+    // The backend might still have removed children, and once all are
+    // loaded the map is complete
+    if (mLoaded || removed.count(name)) {
+      return false;
+    }
+  }
+
+  std::string value;
+
+  try {
+    value = hash.hget(name);
+  } catch (std::runtime_error& qdb_err) {
+    MDException e(ENOENT);
+    e.getMessage()  << __FUNCTION__  << " Container #" << mCont->id()
+                    << " failed to get subentry " << name;
+    throw e;
+  }
+
+  if (value.empty()) {
+    return false;
+  }
+
+  id = std::stoull(value);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Fill the in-memory maps of a partially loaded container
+//------------------------------------------------------------------------------
+void
+ContainerMD::loadChildren()
+{
+  if (mLoaded) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mChildrenMutex);
+
+  if (mLoaded) {
+    return;
+  }
+
+  // The maps hold the children added since the load, which are kept, and
+  // the backend might still have the ones removed since
+  try {
+    const int64_t count = getScanPageSize();
+    auto files = requestPage(pFilesKey, "0", count);
+    auto dirs = requestPage(pDirsKey, "0", count);
+    scanPages(pFilesKey, files.get(),
+    [this](const std::string & name, const std::string & id) {
+      if (!mRemovedFiles.count(name)) {
+        mFiles.insert(std::make_pair(name, std::stoull(id)));
+      }
+    });
+    scanPages(pDirsKey, dirs.get(),
+    [this](const std::string & name, const std::string & id) {
+      if (!mRemovedDirs.count(name)) {
+        mSubcontainers.insert(std::make_pair(name, std::stoull(id)));
+      }
+    });
+  } catch (std::runtime_error& qdb_err) {
+    MDException e(ENOENT);
+    e.getMessage()  << __FUNCTION__  << " Container #" << mCont->id()
+                    << " failed to get subentries";
+    throw e;
+  }
+
+  mLoaded = true;
+}
+
+//------------------------------------------------------------------------------
+// Cursor based listing of the names of the files and subcontainers
+//------------------------------------------------------------------------------
+std::string
+ContainerMD::scanChildNames(const std::string& cursor,
+                            std::vector<std::string>& names)
+{
+  if (!mPartial) {
+    return IContainerMD::scanChildNames(cursor, names);
+  }
+
+  // The cursor is "f:<hscan cursor>" while listing the files, then
+  // "d:<hscan cursor>" for the subcontainers and finally "a" for the children
+  // added since the load, which might not be in the backend yet
+  const std::string next = ((cursor == "0") ? "f:0" : cursor);
+
+  if (next == "a") {
+    std::lock_guard<std::mutex> lock(mChildrenMutex);
+    names.insert(names.end(), mAddedFiles.begin(), mAddedFiles.end());
+    names.insert(names.end(), mAddedDirs.begin(), mAddedDirs.end());
+    return "0";
+  }
+
+  const bool files = (next.compare(0, 2, "f:") == 0);
+
+  if (!files && (next.compare(0, 2, "d:") != 0)) {
+    MDException e(EINVAL);
+    e.getMessage()  << __FUNCTION__  << " Container #" << mCont->id()
+                    << " invalid listing cursor " << cursor;
+    throw e;
+  }
+
+  const std::string& key = (files ? pFilesKey : pDirsKey);
+  qclient::redisReplyPtr reply;
+
+  try {
+    reply = requestPage(key, next.substr(2), getScanPageSize()).get();
+  } catch (std::runtime_error& qdb_err) {
+    reply = nullptr;
+  }
+
+  if (!isScanReply(reply)) {
+    MDException e(ENOENT);
+    e.getMessage()  << __FUNCTION__  << " Container #" << mCont->id()
+                    << " failed to scan subentries";
+    throw e;
+  }
+
+  std::string hscan_cursor(reply->element[0]->str, reply->element[0]->len);
+  redisReply* page = reply->element[1];
+  std::lock_guard<std::mutex> lock(mChildrenMutex);
+  const std::unordered_set<std::string>& added =
+    (files ? mAddedFiles : mAddedDirs);
+  const std::unordered_set<std::string>& removed =
+    (files ? mRemovedFiles : mRemovedDirs);
+  names.reserve(names.size() + page->elements / 2);
+
+  for (size_t i = 0; i < page->elements; i += 2) {
+    std::string name(page->element[i]->str, page->element[i]->len);
+
+    // Removed children might still be in the backend and the added ones are
+    // listed at the end
+    if (!removed.count(name) && !added.count(name)) {
+      names.push_back(std::move(name));
+    }
+  }
+
+  if (hscan_cursor != "0") {
+    return (files ? "f:" : "d:") + hscan_cursor;
+  }
+
+  return (files ? "d:0" : "a");
+}
+
 //------------------------------------------------------------------------------
 // Get map copy of the extended attributes
 //------------------------------------------------------------------------------
@@ -737,7 +1196,7 @@ ContainerMD::getAttributes() const
 {
   XAttrMap xattrs;
 
-  for (const auto& elem : mCont.xattrs()) {
+  for (const auto& elem : mCont->xattrs()) {
     xattrs.insert(elem);
   }
 
@@ -752,7 +1211,7 @@ ContainerMD::getEnv(std::string& env, bool escapeAnd)
 {
   env = "";
   std::ostringstream oss;
-  std::string saveName = mCont.name();
+  std::string saveName = mCont->name();
 
   if (escapeAnd) {
     if (!saveName.empty()) {
@@ -775,17 +1234,17 @@ ContainerMD::getEnv(std::string& env, bool escapeAnd)
   (void) getMTime(mtime);
   (void) getTMTime(stime);
   oss << "name=" << saveName
-      << "&id=" << mCont.id()
-      << "&uid=" << mCont.uid() << "&gid=" << mCont.gid()
-      << "&parentid=" << mCont.parent_id()
-      << "&mode=" << std::oct << mCont.mode() << std::dec
-      << "&flags=" << std::oct << mCont.flags() << std::dec
-      << "&treesize=" << mCont.tree_size()
+      << "&id=" << mCont->id()
+      << "&uid=" << mCont->uid() << "&gid=" << mCont->gid()
+      << "&parentid=" << mCont->parent_id()
+      << "&mode=" << std::oct << mCont->mode() << std::dec
+      << "&flags=" << std::oct << mCont->flags() << std::dec
+      << "&treesize=" << mCont->tree_size()
       << "&ctime=" << ctime.tv_sec << "&ctime_ns=" << ctime.tv_nsec
       << "&mtime=" << mtime.tv_sec << "&mtime_ns=" << mtime.tv_nsec
       << "&stime=" << stime.tv_sec << "&stime_ns=" << stime.tv_nsec;
 
-  for (const auto& elem : mCont.xattrs()) {
+  for (const auto& elem : mCont->xattrs()) {
     oss << "&" << elem.first << "=" << elem.second;
   }
 
@@ -29,7 +29,15 @@
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/ContainerMd.pb.h"
+#include "namespace/ns_quarkdb/ProtoArena.hh"
 #include <sys/time.h>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -50,8 +58,9 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor used for testing and dump command
   //----------------------------------------------------------------------------
-  ContainerMD(): pContSvc(nullptr), pFileSvc(nullptr), pFlusher(nullptr),
-    pQcl(nullptr), mClock(1) {}
+  ContainerMD(): mCont(mArena.get()), pContSvc(nullptr), pFileSvc(nullptr),
+    pFlusher(nullptr), pQcl(nullptr), mClock(1), mPartial(false),
+    mLoaded(true), mNumFiles(0), mNumDirs(0) {}
 
   //----------------------------------------------------------------------------
   //! Desstructor
@@ -119,7 +128,7 @@ public:
   inline id_t
   getId() const override
   {
-    return mCont.id();
+    return mCont->id();
   }
 
   //----------------------------------------------------------------------------
@@ -128,7 +137,7 @@ public:
   inline id_t
   getParentId() const override
   {
-    return mCont.parent_id();
+    return mCont->parent_id();
   }
 
   //----------------------------------------------------------------------------
@@ -137,7 +146,7 @@ public:
   void
   setParentId(id_t parentId) override
   {
-    mCont.set_parent_id(parentId);
+    mCont->set_parent_id(parentId);
   }
 
   //----------------------------------------------------------------------------
@@ -146,7 +155,7 @@ public:
   inline uint16_t
   getFlags() const override
   {
-    return mCont.flags();
+    return mCont->flags();
   }
 
   //----------------------------------------------------------------------------
@@ -154,7 +163,7 @@ public:
   //----------------------------------------------------------------------------
   virtual void setFlags(uint16_t flags) override
   {
-    mCont.set_flags(0x00ff & flags);
+    mCont->set_flags(0x00ff & flags);
   }
 
   //----------------------------------------------------------------------------
@@ -213,7 +222,7 @@ public:
   inline uint64_t
   getTreeSize() const override
   {
-    return mCont.tree_size();
+    return mCont->tree_size();
   }
 
   //----------------------------------------------------------------------------
@@ -222,7 +231,7 @@ public:
   inline void
   setTreeSize(uint64_t treesize) override
   {
-    mCont.set_tree_size(treesize);
+    mCont->set_tree_size(treesize);
   }
 
   //----------------------------------------------------------------------------
@@ -236,7 +245,7 @@ public:
   inline const std::string&
   getName() const override
   {
-    return mCont.name();
+    return mCont->name();
   }
 
   //----------------------------------------------------------------------------
@@ -250,7 +259,7 @@ public:
   inline uid_t
   getCUid() const override
   {
-    return mCont.uid();
+    return mCont->uid();
   }
 
   //----------------------------------------------------------------------------
@@ -259,7 +268,7 @@ public:
   inline void
   setCUid(uid_t uid) override
   {
-    mCont.set_uid(uid);
+    mCont->set_uid(uid);
   }
 
   //----------------------------------------------------------------------------
@@ -268,7 +277,7 @@ public:
   inline gid_t
   getCGid() const override
   {
-    return mCont.gid();
+    return mCont->gid();
   }
 
   //----------------------------------------------------------------------------
@@ -277,7 +286,7 @@ public:
   inline void
   setCGid(gid_t gid) override
   {
-    mCont.set_gid(gid);
+    mCont->set_gid(gid);
   }
 
   //----------------------------------------------------------------------------
@@ -286,7 +295,7 @@ public:
   inline mode_t
   getMode() const override
   {
-    return mCont.mode();
+    return mCont->mode();
   }
 
   //----------------------------------------------------------------------------
@@ -295,7 +304,7 @@ public:
   inline void
   setMode(mode_t mode) override
   {
-    mCont.set_mode(mode);
+    mCont->set_mode(mode);
   }
 
   //----------------------------------------------------------------------------
@@ -304,7 +313,7 @@ public:
   void
   setAttribute(const std::string& name, const std::string& value) override
   {
-    (*mCont.mutable_xattrs())[name] = value;
+    (*mCont->mutable_xattrs())[name] = value;
   }
 
   //----------------------------------------------------------------------------
@@ -318,7 +327,7 @@ public:
   bool
   hasAttribute(const std::string& name) const override
   {
-    return (mCont.xattrs().find(name) != mCont.xattrs().end());
+    return (mCont->xattrs().find(name) != mCont->xattrs().end());
   }
 
   //----------------------------------------------------------------------------
@@ -327,7 +336,7 @@ public:
   size_t
   numAttributes() const override
   {
-    return mCont.xattrs().size();
+    return mCont->xattrs().size();
   }
 
   //----------------------------------------------------------------------------
@@ -365,6 +374,15 @@ public:
   //----------------------------------------------------------------------------
   void deserialize(Buffer& buffer) override;
 
+  //----------------------------------------------------------------------------
+  //! Deserialize the object directly from a memory region e.g. the value
+  //! returned by the backend, without copying it into a buffer first
+  //!
+  //! @param data pointer to the serialized object
+  //! @param size size of the serialized object
+  //----------------------------------------------------------------------------
+  void deserialize(const char* data, size_t size);
+
   //----------------------------------------------------------------------------
   //! Get value tracking changes to the metadata object
   //----------------------------------------------------------------------------
@@ -381,8 +399,90 @@ public:
   //----------------------------------------------------------------------------
   void getEnv(std::string& env, bool escapeAnd = false) override;
 
+  //----------------------------------------------------------------------------
+  //! Cursor based listing of the names of the files and subcontainers, see
+  //! IContainerMD. Partially loaded containers go through the backend hashes
+  //! one HSCAN page per call, corrected by the changes not flushed yet.
+  //----------------------------------------------------------------------------
+  std::string scanChildNames(const std::string& cursor,
+                             std::vector<std::string>& names) override;
+
+  //----------------------------------------------------------------------------
+  //! Check if the children were only partially loaded from the backend
+  //----------------------------------------------------------------------------
+  bool isPartial() const
+  {
+    return mPartial;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the number of entries requested per HSCAN page, configurable through
+  //! the EOS_NS_QDB_HSCAN_PAGE environment variable
+  //----------------------------------------------------------------------------
+  static int64_t getScanPageSize();
+
+  //----------------------------------------------------------------------------
+  //! Get the number of children from which a container is loaded partially,
+  //! configurable through the EOS_NS_QDB_PARTIAL_LOAD environment variable
+  //----------------------------------------------------------------------------
+  static uint64_t getPartialLoadSize();
+
+  //----------------------------------------------------------------------------
+  //! Set the number of children from which a container is loaded partially
+  //----------------------------------------------------------------------------
+  static void setPartialLoadSize(uint64_t size);
+
+protected:
+  //----------------------------------------------------------------------------
+  //! Fill the in-memory maps of a partially loaded container before they
+  //! are iterated
+  //----------------------------------------------------------------------------
+  void loadChildren() override;
+
 private:
-  eos::ns::ContainerMdProto mCont; ///< Protobuf container representation
+  //! Default number of entries requested per HSCAN page
+  static constexpr int64_t sDefaultScanPageSize = 10000;
+  //! Default number of children from which a container is loaded partially
+  static constexpr uint64_t sDefaultPartialLoadSize = 100000;
+  //! Number of children from which a container is loaded partially
+  static std::atomic<uint64_t> sPartialLoadSize;
+
+  //----------------------------------------------------------------------------
+  //! Request one HSCAN page of a QuarkDB hash, the reply is delivered by the
+  //! QClient event loop
+  //----------------------------------------------------------------------------
+  std::future<qclient::redisReplyPtr>
+  requestPage(const std::string& key, const std::string& cursor,
+              int64_t count);
+
+  //----------------------------------------------------------------------------
+  //! Go through all the pages of a QuarkDB hash starting from the given
+  //! reply. The next page is requested before the current one is handed to
+  //! func(field, value).
+  //----------------------------------------------------------------------------
+  template <typename Func>
+  void scanPages(const std::string& key, qclient::redisReplyPtr reply,
+                 Func&& func);
+
+  //----------------------------------------------------------------------------
+  //! Get the id of a child of a partially loaded container, taking into
+  //! account the changes which might not be flushed to the backend yet
+  //!
+  //! @param hash backend hash of the files or subcontainers
+  //! @param map in-memory map of the files or subcontainers
+  //! @param removed names removed since the container was loaded
+  //! @param name name of the child
+  //! @param id set to the id of the child if found
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  template <typename MapT>
+  bool findPartial(qclient::QHash& hash, const MapT& map,
+                   const std::unordered_set<std::string>& removed,
+                   const std::string& name, id_t& id);
+
+  ProtoArena<eos::ns::ContainerMdProto> mArena; ///< Proto arena
+  eos::ns::ContainerMdProto* mCont; ///< Protobuf container representation
   IContainerMDSvc* pContSvc;  ///< Container metadata service
   IFileMDSvc* pFileSvc;       ///< File metadata service
   MetadataFlusher* pFlusher; ///< Metadata flusher object
@@ -392,6 +492,23 @@ private:
   qclient::QHash pFilesMap;   ///< Map holding info about files
   qclient::QHash pDirsMap;    ///< Map holding info about subcontainers
   uint64_t mClock; ///< Value tracking changes
+
+  //----------------------------------------------------------------------------
+  // Containers with many children are loaded partially: the children are
+  // looked up in the backend on demand, and the in-memory maps only hold the
+  // ones added since the load until the maps are iterated. The changes since
+  // the load are tracked by name, since the flusher might not have written
+  // them to the backend yet.
+  //----------------------------------------------------------------------------
+  bool mPartial; ///< Children loaded partially, the members below are used
+  std::atomic<bool> mLoaded; ///< In-memory maps hold all the children
+  std::mutex mChildrenMutex; ///< Protects the maps and the members below
+  std::unordered_set<std::string> mAddedFiles; ///< Files added since the load
+  std::unordered_set<std::string> mRemovedFiles; ///< Files removed since
+  std::unordered_set<std::string> mAddedDirs; ///< Subcontainers added since
+  std::unordered_set<std::string> mRemovedDirs; ///< Subcontainers removed since
+  uint64_t mNumFiles; ///< Number of files
+  uint64_t mNumDirs; ///< Number of subcontainers
 };
 
 EOSNSNAMESPACE_END
@@ -30,9 +30,9 @@ EOSNSNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 FileMD::FileMD(id_t id, IFileMDSvc* fileMDSvc):
-  pFileMDSvc(fileMDSvc), mClock(1)
+  pFileMDSvc(fileMDSvc), mFile(mArena.get()), mClock(1)
 {
-  mFile.set_id(id);
+  mFile->set_id(id);
 }
 
 //------------------------------------------------------------------------------
@@ -47,7 +47,8 @@ FileMD::clone() const
 //------------------------------------------------------------------------------
 // Copy constructor
 //------------------------------------------------------------------------------
-FileMD::FileMD(const FileMD& other)
+FileMD::FileMD(const FileMD& other):
+  mFile(mArena.get())
 {
   *this = other;
 }
@@ -58,7 +59,13 @@ FileMD::FileMD(const FileMD& other)
 FileMD&
 FileMD::operator = (const FileMD& other)
 {
-  mFile = other.mFile;
+  if (this == &other) {
+    return *this;
+  }
+
+  // Start from an arena sized after the copied object
+  mFile = mArena.reset(other.mFile->ByteSizeLong());
+  mFile->CopyFrom(*other.mFile);
   mClock = other.mClock;
   pFileMDSvc   = 0;
   return *this;
@@ -74,7 +81,7 @@ FileMD::addLocation(location_t location)
     return;
   }
 
-  mFile.add_locations(location);
+  mFile->add_locations(location);
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::LocationAdded,
                                  location);
   pFileMDSvc->notifyListeners(&e);
@@ -86,10 +93,10 @@ FileMD::addLocation(location_t location)
 void
 FileMD::replaceLocation(unsigned int index, location_t newlocation)
 {
-  location_t oldLocation = mFile.locations(index);
+  location_t oldLocation = mFile->locations(index);
 
   if (oldLocation != newlocation) {
-    mFile.set_locations(index, newlocation);
+    mFile->set_locations(index, newlocation);
     IFileMDChangeListener::Event e(this, IFileMDChangeListener::LocationReplaced,
                                    newlocation, oldLocation);
     pFileMDSvc->notifyListeners(&e);
@@ -102,10 +109,10 @@ FileMD::replaceLocation(unsigned int index, location_t newlocation)
 void
 FileMD::removeLocation(location_t location)
 {
-  for (auto it = mFile.mutable_unlink_locations()->cbegin();
-       it != mFile.mutable_unlink_locations()->cend(); ++it) {
+  for (auto it = mFile->mutable_unlink_locations()->cbegin();
+       it != mFile->mutable_unlink_locations()->cend(); ++it) {
     if (*it == location) {
-      it = mFile.mutable_unlink_locations()->erase(it);
+      it = mFile->mutable_unlink_locations()->erase(it);
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationRemoved, location);
       pFileMDSvc->notifyListeners(&e);
@@ -123,12 +130,12 @@ FileMD::removeAllLocations()
   // @note: This needs to be done like this since the FileSystemView checks at
   // each steps if there are any locations or unlinked locations and then adds
   // the file to the set of files without replicas.
-  auto it = mFile.mutable_unlink_locations()->cbegin();
+  auto it = mFile->mutable_unlink_locations()->cbegin();
 
-  while (it != mFile.mutable_unlink_locations()->cend()) {
+  while (it != mFile->mutable_unlink_locations()->cend()) {
     IFileMDChangeListener::Event
     e(this, IFileMDChangeListener::LocationRemoved, *it);
-    it = mFile.mutable_unlink_locations()->erase(it);
+    it = mFile->mutable_unlink_locations()->erase(it);
     pFileMDSvc->notifyListeners(&e);
   }
 }
@@ -139,11 +146,11 @@ FileMD::removeAllLocations()
 void
 FileMD::unlinkLocation(location_t location)
 {
-  for (auto it = mFile.mutable_locations()->cbegin();
-       it != mFile.mutable_locations()->cend(); ++it) {
+  for (auto it = mFile->mutable_locations()->cbegin();
+       it != mFile->mutable_locations()->cend(); ++it) {
     if (*it == location) {
-      mFile.add_unlink_locations(*it);
-      it = mFile.mutable_locations()->erase(it);
+      mFile->add_unlink_locations(*it);
+      it = mFile->mutable_locations()->erase(it);
       IFileMDChangeListener::Event
       e(this, IFileMDChangeListener::LocationUnlinked, location);
       pFileMDSvc->notifyListeners(&e);
@@ -158,15 +165,15 @@ FileMD::unlinkLocation(location_t location)
 void
 FileMD::unlinkAllLocations()
 {
-  for (auto it = mFile.locations().cbegin();
-       it != mFile.locations().cend(); ++it) {
-    mFile.add_unlink_locations(*it);
+  for (auto it = mFile->locations().cbegin();
+       it != mFile->locations().cend(); ++it) {
+    mFile->add_unlink_locations(*it);
     IFileMDChangeListener::Event
     e(this, IFileMDChangeListener::LocationUnlinked, *it);
     pFileMDSvc->notifyListeners(&e);
   }
 
-  mFile.clear_locations();
+  mFile->clear_locations();
 }
 
 //------------------------------------------------------------------------
@@ -177,7 +184,7 @@ FileMD::getEnv(std::string& env, bool escapeAnd)
 {
   env = "";
   std::ostringstream oss;
-  std::string saveName = mFile.name();
+  std::string saveName = mFile->name();
 
   if (escapeAnd) {
     if (!saveName.empty()) {
@@ -197,37 +204,37 @@ FileMD::getEnv(std::string& env, bool escapeAnd)
   ctime_t mtime;
   (void) getCTime(ctime);
   (void) getMTime(mtime);
-  oss << "name=" << saveName << "&id=" << mFile.id()
+  oss << "name=" << saveName << "&id=" << mFile->id()
       << "&ctime=" << ctime.tv_sec << "&ctime_ns=" << ctime.tv_nsec
       << "&mtime=" << mtime.tv_sec << "&mtime_ns=" << mtime.tv_nsec
-      << "&size=" << mFile.size() << "&cid=" << mFile.cont_id()
-      << "&uid=" << mFile.uid() << "&gid=" << mFile.gid()
-      << "&lid=" << mFile.layout_id() << "&flags=" << mFile.flags()
-      << "&link=" << mFile.link_name();
+      << "&size=" << mFile->size() << "&cid=" << mFile->cont_id()
+      << "&uid=" << mFile->uid() << "&gid=" << mFile->gid()
+      << "&lid=" << mFile->layout_id() << "&flags=" << mFile->flags()
+      << "&link=" << mFile->link_name();
   env += oss.str();
   env += "&location=";
   char locs[16];
 
-  for (const auto& elem : mFile.locations()) {
+  for (const auto& elem : mFile->locations()) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
-  for (const auto& elem : mFile.unlink_locations()) {
+  for (const auto& elem : mFile->unlink_locations()) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "!%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
   env += "&checksum=";
-  uint8_t size = mFile.checksum().size();
+  uint8_t size = mFile->checksum().size();
 
   for (uint8_t i = 0; i < size; i++) {
     char hx[3];
     hx[0] = 0;
     snprintf(static_cast<char*>(hx), sizeof(hx), "%02x",
-             *(unsigned char*)(mFile.checksum().data() + i));
+             *(unsigned char*)(mFile->checksum().data() + i));
     env += static_cast<char*>(hx);
   }
 }
@@ -247,7 +254,9 @@ FileMD::serialize(eos::Buffer& buffer)
   // Increase clock to mark that metadata file has suffered updates
   ++mClock;
   // Align the buffer to 4 bytes to efficiently compute the checksum
-  size_t obj_size = mFile.ByteSizeLong();
+  size_t obj_size = mFile->ByteSizeLong();
+  // Give back the space left behind by updates of the object
+  mFile = mArena.compact(obj_size);
   uint32_t align_size = (obj_size + 3) >> 2 << 2;
   size_t sz = sizeof(align_size);
   size_t msg_size = align_size + 2 * sz;
@@ -257,12 +266,14 @@ FileMD::serialize(eos::Buffer& buffer)
   const char* ptr = buffer.getDataPtr() + 2 * sz;
   google::protobuf::io::ArrayOutputStream aos((void*)ptr, align_size);
 
-  if (!mFile.SerializeToZeroCopyStream(&aos)) {
+  if (!mFile->SerializeToZeroCopyStream(&aos)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while serializing buffer";
     throw ex;
   }
 
+  // The buffer may be reused so clear the alignment padding
+  (void) memset((void*)(ptr + obj_size), 0, align_size - obj_size);
   // Compute the CRC32C checkusm
   uint32_t cksum = DataHelper::computeCRC32C((void*)ptr, align_size);
   cksum = DataHelper::finalizeCRC32C(cksum);
@@ -278,15 +289,23 @@ FileMD::serialize(eos::Buffer& buffer)
 //------------------------------------------------------------------------------
 void
 FileMD::deserialize(const eos::Buffer& buffer)
+{
+  deserialize(buffer.getDataPtr(), buffer.getSize());
+}
+
+//------------------------------------------------------------------------------
+// Deserialize directly from a memory region
+//------------------------------------------------------------------------------
+void
+FileMD::deserialize(const char* data, size_t msg_size)
 {
   uint32_t cksum_expected = 0;
   uint32_t obj_size = 0;
   size_t sz = sizeof(cksum_expected);
-  const char* ptr = buffer.getDataPtr();
+  const char* ptr = data;
   (void) memcpy(&cksum_expected, ptr, sz);
   ptr += sz;
   (void) memcpy(&obj_size, ptr, sz);
-  size_t msg_size = buffer.getSize();
   uint32_t align_size = msg_size - 2 * sz;
   ptr += sz; // now pointing to the serialized object
   uint32_t cksum_computed = DataHelper::computeCRC32C((void*)ptr, align_size);
@@ -299,8 +318,10 @@ FileMD::deserialize(const eos::Buffer& buffer)
   }
 
   google::protobuf::io::ArrayInputStream ais(ptr, obj_size);
+  // Parse into a fresh arena sized after the object
+  mFile = mArena.reset(obj_size);
 
-  if (!mFile.ParseFromZeroCopyStream(&ais)) {
+  if (!mFile->ParseFromZeroCopyStream(&ais)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while deserializing buffer";
     throw ex;
@@ -313,8 +334,8 @@ FileMD::deserialize(const eos::Buffer& buffer)
 void
 FileMD::setSize(uint64_t size)
 {
-  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.size();
-  mFile.set_size(size & 0x0000ffffffffffff);
+  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile->size();
+  mFile->set_size(size & 0x0000ffffffffffff);
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::SizeChange, 0, 0,
                                  sizeChange);
   pFileMDSvc->notifyListeners(&e);
@@ -326,7 +347,7 @@ FileMD::setSize(uint64_t size)
 void
 FileMD::getCTime(ctime_t& ctime) const
 {
-  (void) memcpy(&ctime, mFile.ctime().data(), sizeof(ctime_t));
+  (void) memcpy(&ctime, mFile->ctime().data(), sizeof(ctime_t));
 }
 
 //------------------------------------------------------------------------------
@@ -335,7 +356,7 @@ FileMD::getCTime(ctime_t& ctime) const
 void
 FileMD::setCTime(ctime_t ctime)
 {
-  mFile.set_ctime(&ctime, sizeof(ctime));
+  mFile->set_ctime(&ctime, sizeof(ctime));
 }
 
 //----------------------------------------------------------------------------
@@ -353,7 +374,7 @@ FileMD::setCTimeNow()
 #else
   clock_gettime(CLOCK_REALTIME, &tnow);
 #endif
-  mFile.set_ctime(&tnow, sizeof(tnow));
+  mFile->set_ctime(&tnow, sizeof(tnow));
 }
 
 //------------------------------------------------------------------------------
@@ -362,7 +383,7 @@ FileMD::setCTimeNow()
 void
 FileMD::getMTime(ctime_t& mtime) const
 {
-  (void) memcpy(&mtime, mFile.mtime().data(), sizeof(time_t));
+  (void) memcpy(&mtime, mFile->mtime().data(), sizeof(time_t));
 }
 
 //------------------------------------------------------------------------------
@@ -371,7 +392,7 @@ FileMD::getMTime(ctime_t& mtime) const
 void
 FileMD::setMTime(ctime_t mtime)
 {
-  mFile.set_mtime(&mtime, sizeof(mtime));
+  mFile->set_mtime(&mtime, sizeof(mtime));
 }
 
 //------------------------------------------------------------------------------
@@ -389,7 +410,7 @@ FileMD::setMTimeNow()
 #else
   clock_gettime(CLOCK_REALTIME, &tnow);
 #endif
-  mFile.set_mtime(&tnow, sizeof(tnow));
+  mFile->set_mtime(&tnow, sizeof(tnow));
 }
 
 //------------------------------------------------------------------------------
@@ -400,7 +421,7 @@ FileMD::getAttributes() const
 {
   std::map<std::string, std::string> xattrs;
 
-  for (const auto& elem : mFile.xattrs()) {
+  for (const auto& elem : mFile->xattrs()) {
     xattrs.insert(elem);
   }
 
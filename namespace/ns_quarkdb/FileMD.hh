@@ -28,6 +28,7 @@
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
 #include "namespace/ns_quarkdb/FileMd.pb.h"
+#include "namespace/ns_quarkdb/ProtoArena.hh"
 #include <stdint.h>
 #include <sys/time.h>
 
@@ -106,7 +107,7 @@ public:
   inline id_t
   getId() const override
   {
-    return mFile.id();
+    return mFile->id();
   }
 
   //----------------------------------------------------------------------------
@@ -115,7 +116,7 @@ public:
   inline uint64_t
   getSize() const override
   {
-    return mFile.size();
+    return mFile->size();
   }
 
   //----------------------------------------------------------------------------
@@ -129,7 +130,7 @@ public:
   inline IContainerMD::id_t
   getContainerId() const override
   {
-    return mFile.cont_id();
+    return mFile->cont_id();
   }
 
   //----------------------------------------------------------------------------
@@ -138,7 +139,7 @@ public:
   void
   setContainerId(IContainerMD::id_t containerId) override
   {
-    mFile.set_cont_id(containerId);
+    mFile->set_cont_id(containerId);
   }
 
   //----------------------------------------------------------------------------
@@ -147,8 +148,8 @@ public:
   inline const Buffer
   getChecksum() const override
   {
-    Buffer buff(mFile.checksum().size());
-    buff.putData((void*)mFile.checksum().data(), mFile.checksum().size());
+    Buffer buff(mFile->checksum().size());
+    buff.putData((void*)mFile->checksum().data(), mFile->checksum().size());
     return buff;
   }
 
@@ -162,8 +163,8 @@ public:
   bool
   checksumMatch(const void* checksum) const override
   {
-    return !memcmp(checksum, (void*)mFile.checksum().data(),
-                   mFile.checksum().size());
+    return !memcmp(checksum, (void*)mFile->checksum().data(),
+                   mFile->checksum().size());
   }
 
   //----------------------------------------------------------------------------
@@ -172,7 +173,7 @@ public:
   void
   setChecksum(const Buffer& checksum) override
   {
-    mFile.set_checksum(checksum.getDataPtr(), checksum.getSize());
+    mFile->set_checksum(checksum.getDataPtr(), checksum.getSize());
   }
 
   //----------------------------------------------------------------------------
@@ -181,7 +182,7 @@ public:
   void
   clearChecksum(uint8_t size = 20) override
   {
-    mFile.clear_checksum();
+    mFile->clear_checksum();
   }
 
   //----------------------------------------------------------------------------
@@ -193,7 +194,7 @@ public:
   void
   setChecksum(const void* checksum, uint8_t size) override
   {
-    mFile.set_checksum(checksum, size);
+    mFile->set_checksum(checksum, size);
   }
 
   //----------------------------------------------------------------------------
@@ -202,7 +203,7 @@ public:
   inline const std::string
   getName() const override
   {
-    return mFile.name();
+    return mFile->name();
   }
 
   //----------------------------------------------------------------------------
@@ -210,7 +211,7 @@ public:
   //----------------------------------------------------------------------------
   inline void setName(const std::string& name) override
   {
-    mFile.set_name(name);
+    mFile->set_name(name);
   }
 
   //----------------------------------------------------------------------------
@@ -223,7 +224,8 @@ public:
   //----------------------------------------------------------------------------
   inline LocationVector getLocations() const override
   {
-    LocationVector locations(mFile.locations().begin(), mFile.locations().end());
+    LocationVector locations(mFile->locations().begin(),
+                             mFile->locations().end());
     return locations;
   }
 
@@ -233,8 +235,8 @@ public:
   location_t
   getLocation(unsigned int index) override
   {
-    if (index < (unsigned int)mFile.locations_size()) {
-      return mFile.locations(index);
+    if (index < (unsigned int)mFile->locations_size()) {
+      return mFile->locations(index);
     }
 
     return 0;
@@ -261,7 +263,7 @@ public:
   void
   clearLocations() override
   {
-    mFile.clear_locations();
+    mFile->clear_locations();
   }
 
   //----------------------------------------------------------------------------
@@ -270,8 +272,8 @@ public:
   bool
   hasLocation(location_t location) override
   {
-    for (int i = 0; i < mFile.locations_size(); i++) {
-      if (mFile.locations(i) == location) {
+    for (int i = 0; i < mFile->locations_size(); i++) {
+      if (mFile->locations(i) == location) {
         return true;
       }
     }
@@ -285,7 +287,7 @@ public:
   inline size_t
   getNumLocation() const override
   {
-    return mFile.locations_size();
+    return mFile->locations_size();
   }
 
   //----------------------------------------------------------------------------
@@ -293,8 +295,8 @@ public:
   //----------------------------------------------------------------------------
   inline LocationVector getUnlinkedLocations() const override
   {
-    LocationVector unlinked_locations(mFile.unlink_locations().begin(),
-                                      mFile.unlink_locations().end());
+    LocationVector unlinked_locations(mFile->unlink_locations().begin(),
+                                      mFile->unlink_locations().end());
     return unlinked_locations;
   }
 
@@ -314,7 +316,7 @@ public:
   inline void
   clearUnlinkedLocations() override
   {
-    mFile.clear_unlink_locations();
+    mFile->clear_unlink_locations();
   }
 
   //----------------------------------------------------------------------------
@@ -323,8 +325,8 @@ public:
   bool
   hasUnlinkedLocation(location_t location) override
   {
-    for (int i = 0; i < mFile.unlink_locations_size(); ++i) {
-      if (mFile.unlink_locations()[i] == location) {
+    for (int i = 0; i < mFile->unlink_locations_size(); ++i) {
+      if (mFile->unlink_locations()[i] == location) {
         return true;
       }
     }
@@ -338,7 +340,7 @@ public:
   inline size_t
   getNumUnlinkedLocation() const override
   {
-    return mFile.unlink_locations_size();
+    return mFile->unlink_locations_size();
   }
 
   //----------------------------------------------------------------------------
@@ -347,7 +349,7 @@ public:
   inline uid_t
   getCUid() const override
   {
-    return mFile.uid();
+    return mFile->uid();
   }
 
   //----------------------------------------------------------------------------
@@ -356,7 +358,7 @@ public:
   inline void
   setCUid(uid_t uid) override
   {
-    mFile.set_uid(uid);
+    mFile->set_uid(uid);
   }
 
   //----------------------------------------------------------------------------
@@ -365,7 +367,7 @@ public:
   inline gid_t
   getCGid() const override
   {
-    return mFile.gid();
+    return mFile->gid();
   }
 
   //----------------------------------------------------------------------------
@@ -374,7 +376,7 @@ public:
   inline void
   setCGid(gid_t gid) override
   {
-    mFile.set_gid(gid);
+    mFile->set_gid(gid);
   }
 
   //----------------------------------------------------------------------------
@@ -383,7 +385,7 @@ public:
   inline layoutId_t
   getLayoutId() const override
   {
-    return mFile.layout_id();
+    return mFile->layout_id();
   }
 
   //----------------------------------------------------------------------------
@@ -392,7 +394,7 @@ public:
   inline void
   setLayoutId(layoutId_t layoutId) override
   {
-    mFile.set_layout_id(layoutId);
+    mFile->set_layout_id(layoutId);
   }
 
   //----------------------------------------------------------------------------
@@ -401,7 +403,7 @@ public:
   inline uint16_t
   getFlags() const override
   {
-    return mFile.flags();
+    return mFile->flags();
   }
 
   //----------------------------------------------------------------------------
@@ -410,7 +412,7 @@ public:
   inline bool
   getFlag(uint8_t n) override
   {
-    return (bool)(mFile.flags() & (0x0001 << n));
+    return (bool)(mFile->flags() & (0x0001 << n));
   }
 
   //----------------------------------------------------------------------------
@@ -419,7 +421,7 @@ public:
   inline void
   setFlags(uint16_t flags) override
   {
-    mFile.set_flags(flags);
+    mFile->set_flags(flags);
   }
 
   //----------------------------------------------------------------------------
@@ -429,9 +431,9 @@ public:
   setFlag(uint8_t n, bool flag) override
   {
     if (flag) {
-      mFile.set_flags(mFile.flags() | (1 << n));
+      mFile->set_flags(mFile->flags() | (1 << n));
     } else {
-      mFile.set_flags(mFile.flags() & (~(1 << n)));
+      mFile->set_flags(mFile->flags() & (~(1 << n)));
     }
   }
 
@@ -464,7 +466,7 @@ public:
   inline std::string
   getLink() const override
   {
-    return mFile.link_name();
+    return mFile->link_name();
   }
 
   //----------------------------------------------------------------------------
@@ -473,7 +475,7 @@ public:
   inline void
   setLink(std::string link_name) override
   {
-    mFile.set_link_name(link_name);
+    mFile->set_link_name(link_name);
   }
 
   //----------------------------------------------------------------------------
@@ -482,7 +484,7 @@ public:
   bool
   isLink() const override
   {
-    return !mFile.link_name().empty();
+    return !mFile->link_name().empty();
   }
 
   //----------------------------------------------------------------------------
@@ -491,7 +493,7 @@ public:
   void
   setAttribute(const std::string& name, const std::string& value) override
   {
-    (*mFile.mutable_xattrs())[name] = value;
+    (*mFile->mutable_xattrs())[name] = value;
   }
 
   //----------------------------------------------------------------------------
@@ -500,10 +502,10 @@ public:
   void
   removeAttribute(const std::string& name) override
   {
-    auto it = mFile.xattrs().find(name);
+    auto it = mFile->xattrs().find(name);
 
-    if (it != mFile.xattrs().end()) {
-      mFile.mutable_xattrs()->erase(it->first);
+    if (it != mFile->xattrs().end()) {
+      mFile->mutable_xattrs()->erase(it->first);
     }
   }
 
@@ -512,7 +514,7 @@ public:
   //----------------------------------------------------------------------------
   void clearAttributes() override
   {
-    mFile.clear_xattrs();
+    mFile->clear_xattrs();
   }
 
   //----------------------------------------------------------------------------
@@ -521,7 +523,7 @@ public:
   bool
   hasAttribute(const std::string& name) const override
   {
-    return (mFile.xattrs().find(name) != mFile.xattrs().end());
+    return (mFile->xattrs().find(name) != mFile->xattrs().end());
   }
 
   //----------------------------------------------------------------------------
@@ -530,7 +532,7 @@ public:
   inline size_t
   numAttributes() const override
   {
-    return mFile.xattrs().size();
+    return mFile->xattrs().size();
   }
 
   //----------------------------------------------------------------------------
@@ -539,9 +541,9 @@ public:
   std::string
   getAttribute(const std::string& name) const override
   {
-    auto it = mFile.xattrs().find(name);
+    auto it = mFile->xattrs().find(name);
 
-    if (it == mFile.xattrs().end()) {
+    if (it == mFile->xattrs().end()) {
       MDException e(ENOENT);
       e.getMessage() << "Attribute: " << name << " not found";
       throw e;
@@ -567,6 +569,15 @@ public:
   //----------------------------------------------------------------------------
   void deserialize(const Buffer& buffer) override;
 
+  //----------------------------------------------------------------------------
+  //! Deserialize the object directly from a memory region e.g. the value
+  //! returned by the backend, without copying it into a buffer first
+  //!
+  //! @param data pointer to the serialized object
+  //! @param size size of the serialized object
+  //----------------------------------------------------------------------------
+  void deserialize(const char* data, size_t size);
+
   //----------------------------------------------------------------------------
   //! Get value tracking changes to the metadata object
   //----------------------------------------------------------------------------
@@ -579,7 +590,8 @@ protected:
   IFileMDSvc* pFileMDSvc;
 
 private:
-  eos::ns::FileMdProto mFile; ///< Protobuf file representation
+  ProtoArena<eos::ns::FileMdProto> mArena; ///< Proto arena
+  eos::ns::FileMdProto* mFile; ///< Protobuf file representation
   uint64_t mClock; ///< Value tracking metadata changes
 };
 
@@ -60,8 +60,39 @@ struct hasGetId {
   static constexpr bool value = test<EntryT>(int());
 };
 
+//------------------------------------------------------------------------------
+//! Helper struct to test if EntryT implements the getNumFiles and
+//! getNumContainers methods i.e. it's a container whose cost in the cache
+//! depends on the number of children.
+//------------------------------------------------------------------------------
+template <class EntryT>
+struct hasNumChildren {
+  template <typename C>
+  static constexpr decltype(std::declval<C>().getNumFiles() +
+                            std::declval<C>().getNumContainers(), bool())
+  test(int)
+  {
+    return true;
+  }
+
+  template <typename C>
+  static constexpr bool
+  test(...)
+  {
+    return false;
+  }
+
+  // int is used to give precedence!
+  static constexpr bool value = test<EntryT>(int());
+};
+
 //------------------------------------------------------------------------------
 //! LRU cache for namespace entries
+//!
+//! Each entry has a weight: 1 for files and 1 plus one per sChildrenPerWeight
+//! children for containers. The maximum size applies to the sum of weights so
+//! that a few containers with millions of children can't pin an unbounded
+//! amount of memory in the cache.
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
 class LRU
@@ -70,7 +101,7 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor
   //!
-  //! @param maxSize maximum number of entries in the cache
+  //! @param maxSize maximum sum of the weights of the entries in the cache
   //----------------------------------------------------------------------------
   LRU(std::uint64_t maxSize);
 
@@ -123,10 +154,22 @@ public:
     return mMap.size();
   }
 
+  //----------------------------------------------------------------------------
+  //! Get sum of the weights of all entries
+  //!
+  //! @return cache weight
+  //----------------------------------------------------------------------------
+  inline std::uint64_t
+  weight() const
+  {
+    eos::common::RWMutexWriteLock lock_w(mMutex);
+    return mWeight;
+  }
+
   //----------------------------------------------------------------------------
   //! Set max size
   //!
-  //! @param max_size new maximum number of entries
+  //! @param max_size new maximum sum of weights
   //----------------------------------------------------------------------------
   inline void
   set_max_size(const std::uint64_t max_size)
@@ -138,6 +181,30 @@ public:
 private:
   //! Percentage at which the cache purging stops
   static constexpr double sPurgeStopRatio = 0.9;
+  //! Number of container children accounted as one extra entry
+  static constexpr std::uint64_t sChildrenPerWeight = 1000;
+
+  //----------------------------------------------------------------------------
+  //! Get weight of a container entry
+  //----------------------------------------------------------------------------
+  template <typename C = EntryT>
+  static typename std::enable_if<hasNumChildren<C>::value, std::uint64_t>::type
+  getWeight(const std::shared_ptr<C>& obj)
+  {
+    return 1 + (obj->getNumFiles() + obj->getNumContainers()) /
+           sChildrenPerWeight;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get weight of any other entry
+  //----------------------------------------------------------------------------
+  template <typename C = EntryT>
+  static typename std::enable_if < !hasNumChildren<C>::value,
+         std::uint64_t >::type
+         getWeight(const std::shared_ptr<C>& obj)
+  {
+    return 1;
+  }
 
   //! Forbid copying or moving LRU objects
   LRU(const LRU& other) = delete;
@@ -147,7 +214,12 @@ private:
 
   using ListT = std::list<std::shared_ptr<EntryT>>;
   typename std::list<std::shared_ptr<EntryT>>::iterator ListIterT;
-  using MapT = std::map<IdT, decltype(ListIterT)>;
+  //! Position of an object in the list and its weight when last accessed
+  struct MapEntry {
+    decltype(ListIterT) mIter;
+    std::uint64_t mWeight;
+  };
+  using MapT = std::map<IdT, MapEntry>;
   MapT mMap;   ///< Internal map pointing to obj in list
   ListT mList; ///< Internal list of objects where new/used objects are at the
   ///< end of the list
@@ -155,18 +227,22 @@ private:
   //! Mutext to protect access to the map and list which is set to blocking
   // mutable eos::common::RWMutex mMutex;
   mutable eos::common::RWMutex mMutex;
-  std::uint64_t mMaxSize; ///< Maximum number of entries
+  std::uint64_t mMaxSize; ///< Maximum sum of weights
+  std::uint64_t mWeight; ///< Sum of weights of all entries
 };
 
-// Definition of class static member
+// Definition of class static members
 template <typename IdT, typename EntryT>
 constexpr double LRU<IdT, EntryT>::sPurgeStopRatio;
+template <typename IdT, typename EntryT>
+constexpr std::uint64_t LRU<IdT, EntryT>::sChildrenPerWeight;
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 template <typename IdT, typename EntryT>
-LRU<IdT, EntryT>::LRU(std::uint64_t max_size) : mMutex(), mMaxSize(max_size)
+LRU<IdT, EntryT>::LRU(std::uint64_t max_size) : mMutex(), mMaxSize(max_size),
+  mWeight(0)
 {
   mMutex.SetBlocking(true);
 }
@@ -180,6 +256,7 @@ LRU<IdT, EntryT>::~LRU()
   eos::common::RWMutexWriteLock lock_w(mMutex);
   mMap.clear();
   mList.clear();
+  mWeight = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -196,10 +273,15 @@ LRU<IdT, EntryT>::get(IdT id)
     return nullptr;
   }
 
-  // Move object to the end of the list i.e. recently accessed
-  auto iter_new = mList.insert(mList.end(), *iter_map->second);
-  mList.erase(iter_map->second);
-  mMap[id] = iter_new;
+  // Move object to the end of the list i.e. recently accessed and refresh
+  // its weight as the number of children might have changed
+  MapEntry& entry = iter_map->second;
+  auto iter_new = mList.insert(mList.end(), *entry.mIter);
+  mList.erase(entry.mIter);
+  entry.mIter = iter_new;
+  std::uint64_t weight = getWeight(*iter_new);
+  mWeight = mWeight - entry.mWeight + weight;
+  entry.mWeight = weight;
   return *iter_new;
 }
 
@@ -214,28 +296,34 @@ typename std::enable_if<hasGetId<EntryT>::value, std::shared_ptr<EntryT>>::type
   auto iter_map = mMap.find(id);
 
   if (iter_map != mMap.end()) {
-    return *(iter_map->second);
+    return *(iter_map->second.mIter);
   }
 
-  // Check if map full and purge some entries if necessary 10% of max size
-  if (mMap.size() >= mMaxSize) {
+  // Check if map full and purge some entries if necessary 10% of max size,
+  // on top of the space needed by the new entry if it weighs more than one
+  std::uint64_t weight = getWeight(obj);
+
+  if (mWeight + weight > mMaxSize) {
     auto iter = mList.begin();
 
     while ((iter != mList.end()) &&
-           (mMap.size() > sPurgeStopRatio * mMaxSize)) {
+           (mWeight + weight > sPurgeStopRatio * mMaxSize + 1)) {
       // If object is referenced also by someone else then skip it
       if (iter->use_count() > 1) {
         ++iter;
         continue;
       }
 
-      mMap.erase((*iter)->getId());
+      auto iter_del = mMap.find((*iter)->getId());
+      mWeight -= iter_del->second.mWeight;
+      mMap.erase(iter_del);
       iter = mList.erase(iter);
     }
   }
 
   auto iter = mList.insert(mList.end(), obj);
-  mMap.emplace(id, iter);
+  mMap.emplace(id, MapEntry {iter, weight});
+  mWeight += weight;
   return *iter;
 }
 
@@ -253,7 +341,8 @@ LRU<IdT, EntryT>::remove(IdT id)
     return false;
   }
 
-  (void)mList.erase(iter_map->second);
+  mWeight -= iter_map->second.mWeight;
+  (void)mList.erase(iter_map->second.mIter);
   mMap.erase(iter_map);
   return true;
 }
@@ -0,0 +1,165 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2016 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Protobuf message allocated in an arena sized after the message
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_QUARKDB_PROTO_ARENA_HH__
+#define __EOS_NS_QUARKDB_PROTO_ARENA_HH__
+
+#include "namespace/Namespace.hh"
+#include <google/protobuf/arena.h>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Protobuf message living in an arena whose first block is sized after the
+//! serialized message. Parsing a metadata object then needs a single
+//! allocation for the message, its strings, repeated fields and map nodes.
+//!
+//! The arena does not release memory freed by updates of the message, so the
+//! owner calls reset when it parses a new message and compact before storing
+//! it. Both give back everything above what the message needs.
+//------------------------------------------------------------------------------
+template <typename MsgT>
+class ProtoArena
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  ProtoArena():
+    mBlockSize(0), mMsg(nullptr)
+  {
+    (void) reset(0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ProtoArena()
+  {
+    getArena()->~Arena();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Forbid copying or moving, the message belongs to this arena
+  //----------------------------------------------------------------------------
+  ProtoArena(const ProtoArena& other) = delete;
+  ProtoArena& operator=(const ProtoArena& other) = delete;
+  ProtoArena(ProtoArena&& other) = delete;
+  ProtoArena& operator=(ProtoArena&& other) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Get the message
+  //----------------------------------------------------------------------------
+  inline MsgT* get()
+  {
+    return mMsg;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop the message and all memory of the arena, then create an empty
+  //! message in a first block fitting the given serialized size. The current
+  //! first block is kept if its size is right.
+  //!
+  //! @param size serialized size of the message to be parsed
+  //!
+  //! @return new message, the previous one is no longer valid
+  //----------------------------------------------------------------------------
+  MsgT* reset(size_t size)
+  {
+    size_t block_size = getBlockSize(size);
+
+    if (mMsg) {
+      if ((block_size <= mBlockSize) && (mBlockSize <= 2 * block_size)) {
+        // Frees all blocks but the first one
+        (void) getArena()->Reset();
+        mMsg = google::protobuf::Arena::CreateMessage<MsgT>(getArena());
+        return mMsg;
+      }
+
+      getArena()->~Arena();
+    }
+
+    google::protobuf::ArenaOptions opts;
+    mBlock.reset(new char[block_size]);
+    mBlockSize = block_size;
+    opts.initial_block = mBlock.get();
+    opts.initial_block_size = mBlockSize;
+    new(&mArena) google::protobuf::Arena(opts);
+    mMsg = google::protobuf::Arena::CreateMessage<MsgT>(getArena());
+    return mMsg;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move the message to a fresh arena if the current one holds more than
+  //! twice the space the message needs, which happens after updates
+  //!
+  //! @param size serialized size of the message
+  //!
+  //! @return message, the previous one is no longer valid if it was moved
+  //----------------------------------------------------------------------------
+  MsgT* compact(size_t size)
+  {
+    if (getArena()->SpaceAllocated() <= 2 * getBlockSize(size)) {
+      return mMsg;
+    }
+
+    MsgT msg(*mMsg);
+    (void) reset(size);
+    mMsg->CopyFrom(msg);
+    return mMsg;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get size of the first block for a message of the given serialized size.
+  //! The parsed message takes about three times the space of its encoding,
+  //! mostly for the string and map node headers, plus the bookkeeping of the
+  //! arena.
+  //----------------------------------------------------------------------------
+  static size_t getBlockSize(size_t size)
+  {
+    return ((sizeof(MsgT) + 3 * size + 256) + 7) & ~((size_t) 7);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the arena constructed in place
+  //----------------------------------------------------------------------------
+  inline google::protobuf::Arena* getArena()
+  {
+    return reinterpret_cast<google::protobuf::Arena*>(&mArena);
+  }
+
+  std::unique_ptr<char[]> mBlock; ///< First block of the arena
+  size_t mBlockSize; ///< Size of the first block
+  //! Arena holding the message, recreated in place when the block changes
+  typename std::aligned_storage<sizeof(google::protobuf::Arena),
+           alignof(google::protobuf::Arena)>::type mArena;
+  MsgT* mMsg; ///< Message allocated in the arena
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_QUARKDB_PROTO_ARENA_HH__
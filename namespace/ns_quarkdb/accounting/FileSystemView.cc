@@ -123,6 +123,7 @@ FileSystemView::fileMDChanged(IFileMDChangeListener::Event* e)
       it->second.insert(file->getId());
     }
 
+    mSampler.insert(e->location, file->getId());
     pNoReplicas.erase(file->getId());
     // Commit to the backend
     key = keyFilesystemFiles(e->location);
@@ -152,6 +153,8 @@ FileSystemView::fileMDChanged(IFileMDChangeListener::Event* e)
       it->second.insert(file->getId());
     }
 
+    mSampler.erase(e->oldLocation, file->getId());
+    mSampler.insert(e->location, file->getId());
     key = keyFilesystemFiles(e->oldLocation);
     val = std::to_string(file->getId());
     pFlusher->srem(key, val);
@@ -188,6 +191,7 @@ FileSystemView::fileMDChanged(IFileMDChangeListener::Event* e)
       it->second.erase(file->getId());
     }
 
+    mSampler.erase(e->location, file->getId());
     it = pUnlinkedFiles.find(e->location);
 
     if (it == pUnlinkedFiles.end()) {
@@ -385,6 +389,24 @@ FileSystemView::hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Pick distinct files of a file system uniformly at random
+//------------------------------------------------------------------------------
+void
+FileSystemView::getRandomFiles(IFileMD::location_t location, size_t n,
+                               std::vector<IFileMD::id_t>& fids)
+{
+  auto it = pFiles.find(location);
+
+  if (it == pFiles.end()) {
+    fids.clear();
+    return;
+  }
+
+  CacheFiles(location);
+  mSampler.getRandomFiles(location, it->second, n, fids);
+}
+
 //------------------------------------------------------------------------------
 // Clear unlinked files for filesystem
 //------------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include "namespace/interface/IFsView.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/utils/FileListSampler.hh"
 #include <utility>
 
 EOSNSNAMESPACE_BEGIN
@@ -345,6 +346,16 @@ public:
   //----------------------------------------------------------------------------
   bool hasFileId(IFileMD::id_t fid, IFileMD::location_t fs_id) override;
 
+  //----------------------------------------------------------------------------
+  //! Pick distinct files of a file system uniformly at random
+  //!
+  //! @param location file system id
+  //! @param n number of files requested
+  //! @param fids vector filled with at most n file ids in random order
+  //----------------------------------------------------------------------------
+  void getRandomFiles(IFileMD::location_t location, size_t n,
+                      std::vector<IFileMD::id_t>& fids) override;
+
   //----------------------------------------------------------------------------
   //! Configure
   //!
@@ -438,6 +449,7 @@ private:
   MetadataFlusher* pFlusher; ///< Metadata flusher object
   qclient::QClient* pQcl;    ///< QClient object
   qclient::QSet pNoReplicasSet; ///< Set of file ids without replicas
+  FsViewSampler mSampler; ///< Random sampling indexes of the file lists
 };
 
 //------------------------------------------------------------------------------
@@ -202,10 +202,10 @@ ContainerMDSvc::getContainerMD(IContainerMD::id_t id, uint64_t* clock)
     throw e;
   }
 
-  cont.reset(new ContainerMD(0, pFileSvc, static_cast<IContainerMDSvc*>(this)));
-  eos::Buffer ebuff;
-  ebuff.putData(blob.c_str(), blob.length());
-  cont->deserialize(ebuff);
+  std::shared_ptr<ContainerMD> impl_cont =
+    std::make_shared<ContainerMD>(0, pFileSvc, static_cast<IContainerMDSvc*>(this));
+  impl_cont->deserialize(blob.data(), blob.length());
+  cont = impl_cont;
 
   if (clock) {
     *clock = cont->getClock();
@@ -233,9 +233,12 @@ ContainerMDSvc::createContainer()
 void
 ContainerMDSvc::updateStore(IContainerMD* obj)
 {
-  eos::Buffer ebuff;
+  // Serialization buffers are reused by each thread, the flusher keeps its
+  // own copy of the value
+  static thread_local eos::Buffer ebuff;
+  static thread_local std::string buffer;
   obj->serialize(ebuff);
-  std::string buffer(ebuff.getDataPtr(), ebuff.getSize());
+  buffer.assign(ebuff.getDataPtr(), ebuff.getSize());
   std::string sid = stringify(obj->getId());
   pFlusher->hset(getBucketKey(obj->getId()), sid, buffer);
 }
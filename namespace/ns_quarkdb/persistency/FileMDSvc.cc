@@ -200,10 +200,9 @@ FileMDSvc::getFileMD(IFileMD::id_t id, uint64_t* clock)
     throw e;
   }
 
-  file = std::make_shared<FileMD>(0, this);
-  eos::Buffer ebuff;
-  ebuff.putData(blob.c_str(), blob.length());
-  file->deserialize(ebuff);
+  std::shared_ptr<FileMD> impl_file = std::make_shared<FileMD>(0, this);
+  impl_file->deserialize(blob.data(), blob.length());
+  file = impl_file;
 
   if (clock) {
     *clock = file->getClock();
@@ -233,13 +232,16 @@ FileMDSvc::createFile()
 void
 FileMDSvc::updateStore(IFileMD* obj)
 {
-  eos::Buffer ebuff;
+  // Serialization buffers are reused by each thread, the flusher keeps its
+  // own copy of the value
+  static thread_local eos::Buffer ebuff;
+  static thread_local std::string buffer;
   obj->serialize(ebuff);
-  std::string buffer(ebuff.getDataPtr(), ebuff.getSize());
+  buffer.assign(ebuff.getDataPtr(), ebuff.getSize());
   std::string sid = stringify(obj->getId());
   pFlusher->hset(getBucketKey(obj->getId()), sid, buffer);
   // Remove id from dirty set
-  pFlusher->srem(constants::sSetCheckFiles, stringify(obj->getId()));
+  pFlusher->srem(constants::sSetCheckFiles, sid);
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,185 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2016 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Count heap allocations of metadata serialization and loading
+//------------------------------------------------------------------------------
+
+#include "namespace/ns_quarkdb/FileMD.hh"
+#include "namespace/ns_quarkdb/ProtoArena.hh"
+#include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+
+namespace
+{
+thread_local bool gCountAllocs = false; ///< Enable counting for this thread
+thread_local uint64_t gNumAllocs = 0; ///< Allocations done by this thread
+}
+
+//------------------------------------------------------------------------------
+// Replace the global allocation functions to count the calls
+//------------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+  if (gCountAllocs) {
+    ++gNumAllocs;
+  }
+
+  void* ptr = malloc(size ? size : 1);
+
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+  free(ptr);
+}
+
+//------------------------------------------------------------------------------
+//! Run a function n times and return the number of allocations per call
+//------------------------------------------------------------------------------
+template <typename FuncT>
+static double countAllocs(size_t n, FuncT func)
+{
+  gNumAllocs = 0;
+  gCountAllocs = true;
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < n; ++i) {
+    func();
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  gCountAllocs = false;
+  std::cout << "  " << (double) gNumAllocs / n << " allocs/op "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>
+            (elapsed).count() / n << " ns/op" << std::endl;
+  return (double) gNumAllocs / n;
+}
+
+//------------------------------------------------------------------------------
+// Compare the previous store/load path, which copied the value through an
+// eos::Buffer and kept the protobuf object on the heap, with the current one
+//------------------------------------------------------------------------------
+TEST(FileMD, AllocationBenchmark)
+{
+  const size_t n = 100000;
+  eos::FileMDSvc svc;
+  eos::FileMD src(1234, &svc);
+  src.setName("some_rather_long_file_name.root");
+  src.setCTimeNow();
+  src.setMTimeNow();
+  src.setChecksum("abcd1234", 8);
+  src.setCUid(1000);
+  src.setCGid(1000);
+  src.addLocation(1);
+  src.addLocation(2);
+  src.setAttribute("sys.eos.btime", "1517844111.583712");
+  // Previous path
+  std::string blob;
+  std::cout << "legacy store:" << std::endl;
+  double legacy = countAllocs(n, [&]() {
+    eos::Buffer ebuff;
+    src.serialize(ebuff);
+    blob = std::string(ebuff.getDataPtr(), ebuff.getSize());
+  });
+  std::cout << "legacy load:" << std::endl;
+  legacy += countAllocs(n, [&]() {
+    eos::Buffer ebuff;
+    ebuff.putData(blob.c_str(), blob.length());
+    std::shared_ptr<eos::ns::FileMdProto> proto =
+      std::make_shared<eos::ns::FileMdProto>();
+    uint32_t obj_size = 0;
+    (void) memcpy(&obj_size, ebuff.getDataPtr() + sizeof(obj_size),
+                  sizeof(obj_size));
+    ASSERT_TRUE(proto->ParseFromArray(ebuff.getDataPtr() + 2 * sizeof(obj_size),
+                                      obj_size));
+  });
+  // Current path with the buffers reused by the thread
+  eos::Buffer ebuff;
+  std::string value;
+  src.serialize(ebuff);
+  value.assign(ebuff.getDataPtr(), ebuff.getSize());
+  std::cout << "store:" << std::endl;
+  double current = countAllocs(n, [&]() {
+    src.serialize(ebuff);
+    value.assign(ebuff.getDataPtr(), ebuff.getSize());
+  });
+  std::cout << "load:" << std::endl;
+  current += countAllocs(n, [&]() {
+    std::shared_ptr<eos::FileMD> file = std::make_shared<eos::FileMD>(0, &svc);
+    file->deserialize(value.data(), value.size());
+  });
+  std::cout << "legacy=" << legacy << " current=" << current
+            << " allocs per store and load" << std::endl;
+  ASSERT_LE(2 * current, legacy);
+  // Check the object survives the round trip
+  eos::FileMD dst(0, &svc);
+  dst.deserialize(value.data(), value.size());
+  ASSERT_EQ(src.getId(), dst.getId());
+  ASSERT_EQ(src.getName(), dst.getName());
+  ASSERT_EQ(src.getNumLocation(), dst.getNumLocation());
+  ASSERT_EQ(src.getAttribute("sys.eos.btime"),
+            dst.getAttribute("sys.eos.btime"));
+  eos::FileMD copy(dst);
+  ASSERT_EQ(src.getName(), copy.getName());
+}
+
+//------------------------------------------------------------------------------
+// Check the arena gives back the space left behind by updates
+//------------------------------------------------------------------------------
+TEST(ProtoArena, Compact)
+{
+  eos::ProtoArena<eos::ns::FileMdProto> arena;
+  eos::ns::FileMdProto* msg = arena.get();
+  msg->set_name("some_rather_long_file_name.root");
+  // Nothing to give back, the message stays in place
+  ASSERT_EQ(msg, arena.compact(msg->ByteSizeLong()));
+
+  for (int i = 0; i < 1000; ++i) {
+    (*msg->mutable_xattrs())[std::to_string(i)] = "value";
+    msg->add_locations(i);
+  }
+
+  msg->mutable_xattrs()->clear();
+  msg->clear_locations();
+  msg->add_locations(1);
+  (*msg->mutable_xattrs())["sys.eos.btime"] = "1517844111.583712";
+  eos::ns::FileMdProto* compacted = arena.compact(msg->ByteSizeLong());
+  ASSERT_NE(msg, compacted);
+  ASSERT_EQ("some_rather_long_file_name.root", compacted->name());
+  ASSERT_EQ(1, compacted->locations_size());
+  ASSERT_EQ(1, compacted->xattrs().count("sys.eos.btime"));
+  // The compacted arena is sized after the message
+  ASSERT_EQ(compacted, arena.compact(compacted->ByteSizeLong()));
+}
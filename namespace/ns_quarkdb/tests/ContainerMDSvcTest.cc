@@ -22,12 +22,15 @@
 //------------------------------------------------------------------------------
 
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
+#include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/tests/TestUtils.hh"
 #include <cppunit/extensions/HelperMacros.h>
 #include <gtest/gtest.h>
+#include <chrono>
 #include <memory>
+#include <set>
 
 TEST(ContainerMDSvc, BasicSanity)
 {
@@ -148,3 +151,188 @@ TEST(ContainerMDSvc, BasicSanity)
     FAIL();
   }
 }
+
+//------------------------------------------------------------------------------
+// Cold vs warm listing of a large container
+//------------------------------------------------------------------------------
+TEST(ContainerMDSvc, ListingBenchmark)
+{
+  std::map<std::string, std::string> config = {
+    {"qdb_cluster", "localhost:7778"},
+    {"qdb_flusher_md", "tests_md"},
+    {"qdb_flusher_quota", "tests_quota"}
+  };
+  eos::ns::testing::FlushAllOnDestruction guard(qclient::Members::fromString(config["qdb_cluster"]));
+  eos::MetadataFlusher* flusher =
+    eos::MetadataFlusherFactory::getInstance(config["qdb_flusher_md"],
+        qclient::Members::fromString(config["qdb_cluster"]));
+  std::unique_ptr<eos::IContainerMDSvc> containerSvc{new eos::ContainerMDSvc()};
+  std::unique_ptr<eos::IFileMDSvc> fileSvc{new eos::FileMDSvc()};
+  containerSvc->setFileMDService(fileSvc.get());
+  fileSvc->setContMDService(containerSvc.get());
+  containerSvc->configure(config);
+  fileSvc->configure(config);
+  containerSvc->initialize();
+  fileSvc->initialize();
+  const size_t nfiles = 50000;
+  std::shared_ptr<eos::IContainerMD> cont = containerSvc->createContainer();
+  eos::IContainerMD::id_t id = cont->getId();
+  cont->setName("bench");
+  cont->setParentId(id);
+
+  for (size_t i = 0; i < nfiles; ++i) {
+    std::shared_ptr<eos::IFileMD> file = fileSvc->createFile();
+    file->setName("file" + std::to_string(i));
+    cont->addFile(file.get());
+  }
+
+  containerSvc->updateStore(cont.get());
+  flusher->synchronize();
+  cont.reset();
+  // A new service has an empty cache i.e. the first listing is cold
+  std::unique_ptr<eos::IContainerMDSvc> coldSvc{new eos::ContainerMDSvc()};
+  coldSvc->setFileMDService(fileSvc.get());
+  coldSvc->configure(config);
+  coldSvc->initialize();
+  auto list = [&]() {
+    std::shared_ptr<eos::IContainerMD> cmd = coldSvc->getContainerMD(id);
+    size_t count = 0;
+
+    for (auto it = cmd->filesBegin(); it != cmd->filesEnd(); ++it) {
+      ++count;
+    }
+
+    return count;
+  };
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(nfiles, list());
+  auto cold = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  ASSERT_EQ(nfiles, list());
+  auto warm = std::chrono::steady_clock::now() - start;
+  // Page through the same container loaded partially, without the map
+  const uint64_t partial_size = eos::ContainerMD::getPartialLoadSize();
+  eos::ContainerMD::setPartialLoadSize(1);
+  std::unique_ptr<eos::IContainerMDSvc> partialSvc{new eos::ContainerMDSvc()};
+  partialSvc->setFileMDService(fileSvc.get());
+  partialSvc->configure(config);
+  partialSvc->initialize();
+  start = std::chrono::steady_clock::now();
+  std::shared_ptr<eos::IContainerMD> cmd = partialSvc->getContainerMD(id);
+  std::vector<std::string> names;
+  std::string cursor = "0";
+
+  do {
+    cursor = cmd->scanChildNames(cursor, names);
+  } while (cursor != "0");
+
+  auto paged = std::chrono::steady_clock::now() - start;
+  ASSERT_EQ(nfiles, names.size());
+  eos::ContainerMD::setPartialLoadSize(partial_size);
+  partialSvc->finalize();
+  using std::chrono::microseconds;
+  std::cout << "files=" << nfiles
+            << " page=" << eos::ContainerMD::getScanPageSize()
+            << " cold=" << std::chrono::duration_cast<microseconds>(cold).count()
+            << "us warm=" << std::chrono::duration_cast<microseconds>(warm).count()
+            << "us paged=" << std::chrono::duration_cast<microseconds>(paged).count()
+            << "us" << std::endl;
+  coldSvc->finalize();
+  fileSvc->finalize();
+  containerSvc->finalize();
+}
+
+//------------------------------------------------------------------------------
+// Lookups, updates and listing of a partially loaded container
+//------------------------------------------------------------------------------
+TEST(ContainerMDSvc, PartialLoading)
+{
+  std::map<std::string, std::string> config = {
+    {"qdb_cluster", "localhost:7778"},
+    {"qdb_flusher_md", "tests_md"},
+    {"qdb_flusher_quota", "tests_quota"}
+  };
+  eos::ns::testing::FlushAllOnDestruction guard(qclient::Members::fromString(config["qdb_cluster"]));
+  eos::MetadataFlusher* flusher =
+    eos::MetadataFlusherFactory::getInstance(config["qdb_flusher_md"],
+        qclient::Members::fromString(config["qdb_cluster"]));
+  std::unique_ptr<eos::IContainerMDSvc> containerSvc{new eos::ContainerMDSvc()};
+  std::unique_ptr<eos::IFileMDSvc> fileSvc{new eos::FileMDSvc()};
+  containerSvc->setFileMDService(fileSvc.get());
+  fileSvc->setContMDService(containerSvc.get());
+  containerSvc->configure(config);
+  fileSvc->configure(config);
+  containerSvc->initialize();
+  fileSvc->initialize();
+  // More than one HSCAN page, otherwise the container is loaded completely
+  const size_t nfiles = eos::ContainerMD::getScanPageSize() + 10;
+  std::shared_ptr<eos::IContainerMD> cont = containerSvc->createContainer();
+  eos::IContainerMD::id_t id = cont->getId();
+  cont->setName("partial");
+  cont->setParentId(id);
+
+  for (size_t i = 0; i < nfiles; ++i) {
+    std::shared_ptr<eos::IFileMD> file = fileSvc->createFile();
+    file->setName("file" + std::to_string(i));
+    cont->addFile(file.get());
+  }
+
+  std::shared_ptr<eos::IContainerMD> sub = containerSvc->createContainer();
+  sub->setName("subdir");
+  cont->addContainer(sub.get());
+  containerSvc->updateStore(sub.get());
+  containerSvc->updateStore(cont.get());
+  flusher->synchronize();
+  cont.reset();
+  const uint64_t partial_size = eos::ContainerMD::getPartialLoadSize();
+  eos::ContainerMD::setPartialLoadSize(1);
+  std::unique_ptr<eos::IContainerMDSvc> partialSvc{new eos::ContainerMDSvc()};
+  partialSvc->setFileMDService(fileSvc.get());
+  partialSvc->configure(config);
+  partialSvc->initialize();
+  std::shared_ptr<eos::ContainerMD> cmd =
+    std::dynamic_pointer_cast<eos::ContainerMD>(partialSvc->getContainerMD(id));
+  ASSERT_TRUE(cmd != nullptr);
+  ASSERT_TRUE(cmd->isPartial());
+  ASSERT_EQ(nfiles, cmd->getNumFiles());
+  ASSERT_EQ(1u, cmd->getNumContainers());
+  // Lookups go to the backend
+  ASSERT_TRUE(cmd->findFile("file7") != nullptr);
+  ASSERT_TRUE(cmd->findFile("missing") == nullptr);
+  ASSERT_TRUE(cmd->findContainer("subdir") != nullptr);
+  // Changes are visible before they are flushed
+  cmd->removeFile("file7");
+  std::shared_ptr<eos::IFileMD> extra = fileSvc->createFile();
+  extra->setName("extra");
+  cmd->addFile(extra.get());
+  ASSERT_TRUE(cmd->findFile("file7") == nullptr);
+  ASSERT_TRUE(cmd->findFile("extra") != nullptr);
+  ASSERT_EQ(nfiles, cmd->getNumFiles());
+  std::vector<std::string> names;
+  std::string cursor = "0";
+
+  do {
+    cursor = cmd->scanChildNames(cursor, names);
+  } while (cursor != "0");
+
+  std::set<std::string> listed(names.begin(), names.end());
+  ASSERT_EQ(nfiles + 1, names.size());
+  ASSERT_EQ(names.size(), listed.size());
+  ASSERT_EQ(0u, listed.count("file7"));
+  ASSERT_EQ(1u, listed.count("extra"));
+  ASSERT_EQ(1u, listed.count("subdir"));
+  // Iterating fills the in-memory map
+  size_t count = 0;
+
+  for (auto it = cmd->filesBegin(); it != cmd->filesEnd(); ++it) {
+    ASSERT_NE("file7", it->first);
+    ++count;
+  }
+
+  ASSERT_EQ(nfiles, count);
+  ASSERT_EQ(nfiles, cmd->getNumFiles());
+  eos::ContainerMD::setPartialLoadSize(partial_size);
+  partialSvc->finalize();
+  fileSvc->finalize();
+  containerSvc->finalize();
+}
@@ -29,6 +29,7 @@
 #include <gtest/gtest.h>
 #include <cstdlib>
 #include <cstdint>
+#include <algorithm>
 #include <ctime>
 #include <sstream>
 #include <unistd.h>
@@ -185,6 +186,34 @@ TEST(FileSystemView, BasicSanity)
     ASSERT_EQ(numReplicas, 19200);
     numUnlinked = countUnlinked(fsView.get());
     ASSERT_EQ(numUnlinked, 800);
+
+    // Random samples only contain distinct files still linked on the fs
+    for (auto it = fsView->getFileSystemIterator(); it->valid(); it->next()) {
+      std::vector<eos::IFileMD::id_t> sample;
+      std::set<eos::IFileMD::id_t> unique;
+      uint64_t num_files = fsView->getNumFilesOnFs(it->getElement());
+      fsView->getRandomFiles(it->getElement(), 20, sample);
+      ASSERT_EQ(std::min<uint64_t>(20, num_files), sample.size());
+
+      for (auto fid : sample) {
+        ASSERT_TRUE(fsView->hasFileId(fid, it->getElement()));
+        ASSERT_TRUE(unique.insert(fid).second);
+      }
+
+      // Size stratified sample with a single file in the largest size class
+      eos::IFileMD::id_t big_fid = sample.empty() ? 0 : sample.front();
+      fsView->getRandomFilesBySize(it->getElement(), 2,
+      [big_fid](eos::IFileMD::id_t fid) -> uint64_t {
+        return (fid == big_fid) ? (1ull << 40) : 1024;
+      }, sample, 1000);
+      ASSERT_EQ(std::min<uint64_t>(2, num_files), sample.size());
+
+      if (num_files >= 2) {
+        ASSERT_TRUE(std::find(sample.begin(), sample.end(), big_fid) !=
+                    sample.end());
+      }
+    }
+
     std::list<eos::IFileMD::id_t> file_ids;
 
     for (int i = 500; i < 900; ++i) {
@@ -282,6 +311,52 @@ TEST(FileSystemView, BasicSanity)
   }
 }
 
+//------------------------------------------------------------------------------
+// Test random sampling index kept in sync with the file list
+//------------------------------------------------------------------------------
+TEST(FileSystemView, RandomSampling)
+{
+  eos::IFsView::FileList list;
+  list.set_deleted_key(0);
+  list.set_empty_key(0xffffffffffffffffll);
+
+  for (eos::IFileMD::id_t fid = 1; fid <= 1000; ++fid) {
+    list.insert(fid);
+  }
+
+  eos::FsViewSampler sampler;
+  std::vector<eos::IFileMD::id_t> sample;
+  sampler.insert(1, 5000); // no index yet, ignored
+  sampler.getRandomFiles(1, list, 10, sample);
+  ASSERT_EQ(10, sample.size());
+
+  // Remove even file ids through the hooks used by the views
+  for (eos::IFileMD::id_t fid = 2; fid <= 1000; fid += 2) {
+    list.erase(fid);
+    sampler.erase(1, fid);
+  }
+
+  list.insert(5000);
+  sampler.insert(1, 5000);
+  std::map<eos::IFileMD::id_t, int> hits;
+
+  for (int i = 0; i < 1000; ++i) {
+    sampler.getRandomFiles(1, list, 5, sample);
+    ASSERT_EQ(5, sample.size());
+
+    for (auto fid : sample) {
+      ASSERT_TRUE(list.find(fid) != list.end());
+      hits[fid]++;
+    }
+  }
+
+  // 5000 picks over 501 files, every file should be hit
+  ASSERT_EQ(501, hits.size());
+  // Asking for more than available returns the full list
+  sampler.getRandomFiles(1, list, 10000, sample);
+  ASSERT_EQ(list.size(), sample.size());
+}
+
 //------------------------------------------------------------------------------
 // Test file iterator on top of QHash object
 //------------------------------------------------------------------------------
@@ -125,6 +125,50 @@ TEST(LRU, BasicSanity)
   ASSERT_TRUE(!cache.get(100));
 }
 
+TEST(LRU, WeightedContainers)
+{
+  struct Container {
+    Container(std::uint64_t id, size_t files) : id_(id), files_(files) {}
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    size_t
+    getNumFiles()
+    {
+      return files_;
+    }
+
+    size_t
+    getNumContainers()
+    {
+      return 0;
+    }
+
+    std::uint64_t id_;
+    size_t files_;
+  };
+  eos::LRU<std::uint64_t, Container> cache{100};
+
+  for (std::uint64_t id = 0; id < 50; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Container>(id, 10)));
+  }
+
+  ASSERT_EQ((std::uint64_t)50, cache.weight());
+  // A container with 60k children weighs as much as 61 empty ones and pushes
+  // out the least recently used entries
+  ASSERT_TRUE(cache.put(100, std::make_shared<Container>(100, 60000)));
+  ASSERT_EQ((std::uint64_t)31, cache.size());
+  ASSERT_EQ((std::uint64_t)91, cache.weight());
+  ASSERT_TRUE(!cache.get(0));
+  ASSERT_TRUE(cache.get(49));
+  ASSERT_TRUE(cache.remove(100));
+  ASSERT_EQ((std::uint64_t)30, cache.weight());
+}
+
 TEST(PathProcessor, AbsPathTest)
 {
   std::string path = "/a/b/c/d/";
@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+// File: FileListSampler.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/utils/FileListSampler.hh"
+#include <algorithm>
+#include <set>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FileListSampler::FileListSampler(const IFsView::FileList& list)
+{
+  mPos.set_deleted_key(0);
+  mPos.set_empty_key(0xffffffffffffffffll);
+  mPos.resize(list.size());
+  mIds.reserve(list.size());
+
+  for (auto it = list.begin(); it != list.end(); ++it) {
+    insert(*it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add file id to the index
+//------------------------------------------------------------------------------
+void
+FileListSampler::insert(IFileMD::id_t fid)
+{
+  if (mPos.insert(std::make_pair(fid, mIds.size())).second) {
+    mIds.push_back(fid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove file id from the index
+//------------------------------------------------------------------------------
+void
+FileListSampler::erase(IFileMD::id_t fid)
+{
+  auto it = mPos.find(fid);
+
+  if (it == mPos.end()) {
+    return;
+  }
+
+  uint64_t pos = it->second;
+  mPos.erase(it);
+
+  // Move the last element into the freed slot
+  if (pos != mIds.size() - 1) {
+    mIds[pos] = mIds.back();
+    mPos[mIds[pos]] = pos;
+  }
+
+  mIds.pop_back();
+}
+
+//------------------------------------------------------------------------------
+// Pick distinct file ids uniformly at random
+//------------------------------------------------------------------------------
+void
+FileListSampler::sample(size_t n, std::mt19937_64& rng,
+                        std::vector<IFileMD::id_t>& fids) const
+{
+  size_t sz = mIds.size();
+
+  if (n >= sz) {
+    size_t first = fids.size();
+    fids.insert(fids.end(), mIds.begin(), mIds.end());
+    std::shuffle(fids.begin() + first, fids.end(), rng);
+    return;
+  }
+
+  // Floyd's algorithm - n distinct positions with n random draws
+  std::set<uint64_t> picked;
+
+  for (uint64_t j = sz - n; j < sz; ++j) {
+    std::uniform_int_distribution<uint64_t> dist(0, j);
+    uint64_t pos = dist(rng);
+
+    if (!picked.insert(pos).second) {
+      pos = j;
+      picked.insert(pos);
+    }
+
+    fids.push_back(mIds[pos]);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+FsViewSampler::FsViewSampler():
+  mActive(false), mRng(std::random_device()())
+{}
+
+//------------------------------------------------------------------------------
+// Drop all indexes
+//------------------------------------------------------------------------------
+void
+FsViewSampler::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mSamplers.clear();
+}
+
+//------------------------------------------------------------------------------
+// Pick distinct file ids of a file system uniformly at random
+//------------------------------------------------------------------------------
+void
+FsViewSampler::getRandomFiles(IFileMD::location_t location,
+                              const IFsView::FileList& list, size_t n,
+                              std::vector<IFileMD::id_t>& fids)
+{
+  fids.clear();
+
+  if (!n || list.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mSamplers.find(location);
+
+  if (it == mSamplers.end()) {
+    it = mSamplers.emplace(location, FileListSampler(list)).first;
+    mActive = true;
+  }
+
+  it->second.sample(n, mRng, fids);
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------
+// File: FileListSampler.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#ifndef __EOS_NS_FILELISTSAMPLER_HH__
+#define __EOS_NS_FILELISTSAMPLER_HH__
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IFsView.hh"
+#include <google/dense_hash_map>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FileListSampler
+//!
+//! @brief Random access index of the file ids of one file system. The ids
+//! are kept in a dense vector together with their position so that a uniform
+//! pick, an insertion and a removal (swap with the last element) are O(1).
+//------------------------------------------------------------------------------
+class FileListSampler
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param list file list used to populate the index
+  //----------------------------------------------------------------------------
+  FileListSampler(const IFsView::FileList& list);
+
+  //----------------------------------------------------------------------------
+  //! Add file id to the index
+  //----------------------------------------------------------------------------
+  void insert(IFileMD::id_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Remove file id from the index
+  //----------------------------------------------------------------------------
+  void erase(IFileMD::id_t fid);
+
+  //----------------------------------------------------------------------------
+  //! Get number of indexed file ids
+  //----------------------------------------------------------------------------
+  size_t size() const
+  {
+    return mIds.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Pick distinct file ids uniformly at random
+  //!
+  //! @param n number of file ids requested
+  //! @param rng random generator
+  //! @param fids vector where the picked file ids are appended
+  //----------------------------------------------------------------------------
+  void sample(size_t n, std::mt19937_64& rng,
+              std::vector<IFileMD::id_t>& fids) const;
+
+private:
+  std::vector<IFileMD::id_t> mIds; ///< Dense vector of file ids
+  ///! Position of each file id in mIds
+  google::dense_hash_map<IFileMD::id_t, uint64_t,
+         Murmur3::MurmurHasher<uint64_t>, Murmur3::eqstr> mPos;
+};
+
+//------------------------------------------------------------------------------
+//! Class FsViewSampler
+//!
+//! @brief Sampling indexes of the file systems kept by a file system view.
+//! An index is only built the first time a file system is sampled and then
+//! kept in sync with the view, so that file systems which are never balanced
+//! don't pay the extra memory.
+//!
+//! The views call insert/erase while holding the namespace write lock, while
+//! getRandomFiles is called with the read lock by several balancer threads.
+//! All accesses to the indexes are serialized by the internal mutex, which
+//! insert/erase skip as long as no index was ever built.
+//------------------------------------------------------------------------------
+class FsViewSampler
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  FsViewSampler();
+
+  //----------------------------------------------------------------------------
+  //! Add file id to the index of the file system if it exists
+  //----------------------------------------------------------------------------
+  inline void insert(IFileMD::location_t location, IFileMD::id_t fid)
+  {
+    if (!mActive) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mSamplers.find(location);
+
+    if (it != mSamplers.end()) {
+      it->second.insert(fid);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove file id from the index of the file system if it exists
+  //----------------------------------------------------------------------------
+  inline void erase(IFileMD::location_t location, IFileMD::id_t fid)
+  {
+    if (!mActive) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mSamplers.find(location);
+
+    if (it != mSamplers.end()) {
+      it->second.erase(fid);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all indexes
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Pick distinct file ids of a file system uniformly at random
+  //!
+  //! @param location file system id
+  //! @param list file list of the file system used to build the index
+  //! @param n number of file ids requested
+  //! @param fids vector filled with the picked file ids
+  //----------------------------------------------------------------------------
+  void getRandomFiles(IFileMD::location_t location,
+                      const IFsView::FileList& list, size_t n,
+                      std::vector<IFileMD::id_t>& fids);
+
+private:
+  std::atomic<bool> mActive; ///< True once an index was built
+  std::mutex mMutex; ///< Mutex protecting the indexes
+  std::mt19937_64 mRng; ///< Random generator
+  std::map<IFileMD::location_t, FileListSampler> mSamplers;
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_FILELISTSAMPLER_HH__
@@ -0,0 +1,290 @@
+//------------------------------------------------------------------------------
+// File: EosHttpBenchmark.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Local HTTP load generator used to compare the thread models of the EOS
+//! HTTP servers. Every client thread keeps one connection alive and sends
+//! GET requests with the given pipelining depth for the given duration.
+//!
+//! Usage: eos-http-bench <host> <port> <path> [connections] [seconds] [depth]
+//------------------------------------------------------------------------------
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Results of one client connection
+//------------------------------------------------------------------------------
+struct ClientResult {
+  unsigned long long requests = 0;
+  unsigned long long bytes = 0;
+  unsigned long long errors = 0;
+  std::vector<double> latencies; //!< Latencies in ms
+};
+
+std::atomic<bool> gRun(true);
+
+//------------------------------------------------------------------------------
+// Connect to host:port
+//------------------------------------------------------------------------------
+static int
+Connect(const std::string& host, const std::string& port)
+{
+  struct addrinfo hints;
+  struct addrinfo* res = 0;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res)) {
+    return -1;
+  }
+
+  int fd = -1;
+
+  for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+    if (fd < 0) {
+      continue;
+    }
+
+    if (!connect(fd, ai->ai_addr, ai->ai_addrlen)) {
+      break;
+    }
+
+    close(fd);
+    fd = -1;
+  }
+
+  freeaddrinfo(res);
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+// Read one response from the connection, buffer keeps pipelined leftovers
+//
+// @return size of the response body or -1 if failed
+//------------------------------------------------------------------------------
+static long long
+ReadResponse(int fd, std::string& buffer, std::vector<char>& chunk)
+{
+  size_t hdr_end;
+
+  while ((hdr_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+    ssize_t nread = recv(fd, chunk.data(), chunk.size(), 0);
+
+    if (nread <= 0) {
+      return -1;
+    }
+
+    buffer.append(chunk.data(), nread);
+  }
+
+  std::string header = buffer.substr(0, hdr_end);
+  std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+
+  if (header.compare(0, 12, "http/1.1 200") &&
+      header.compare(0, 12, "http/1.1 206")) {
+    return -1;
+  }
+
+  size_t pos = header.find("content-length:");
+
+  if (pos == std::string::npos) {
+    return -1;
+  }
+
+  unsigned long long length = strtoull(header.c_str() + pos + 15, 0, 10);
+  buffer.erase(0, hdr_end + 4);
+
+  // Consume the body without keeping it in memory
+  unsigned long long left = length;
+
+  if (buffer.size() >= left) {
+    buffer.erase(0, left);
+    return length;
+  }
+
+  left -= buffer.size();
+  buffer.clear();
+
+  while (left) {
+    ssize_t nread = recv(fd, chunk.data(), chunk.size(), 0);
+
+    if (nread <= 0) {
+      return -1;
+    }
+
+    if ((unsigned long long) nread > left) {
+      buffer.append(chunk.data() + left, nread - left);
+      left = 0;
+    } else {
+      left -= nread;
+    }
+  }
+
+  return length;
+}
+
+//------------------------------------------------------------------------------
+// Client loop for one keep-alive connection
+//------------------------------------------------------------------------------
+static void
+RunClient(const std::string& host, const std::string& port,
+          const std::string& path, int depth, ClientResult* result)
+{
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host +
+                        "\r\nConnection: keep-alive\r\n\r\n";
+  std::vector<char> chunk(1024 * 1024);
+  std::string buffer;
+  int fd = -1;
+
+  while (gRun) {
+    if (fd < 0) {
+      if ((fd = Connect(host, port)) < 0) {
+        result->errors++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        continue;
+      }
+
+      buffer.clear();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string batch;
+
+    for (int i = 0; i < depth; ++i) {
+      batch += request;
+    }
+
+    if (send(fd, batch.c_str(), batch.length(), MSG_NOSIGNAL) !=
+        (ssize_t) batch.length()) {
+      result->errors++;
+      close(fd);
+      fd = -1;
+      continue;
+    }
+
+    for (int i = 0; i < depth; ++i) {
+      long long nbytes = ReadResponse(fd, buffer, chunk);
+
+      if (nbytes < 0) {
+        result->errors++;
+        close(fd);
+        fd = -1;
+        break;
+      }
+
+      auto stop = std::chrono::steady_clock::now();
+      result->requests++;
+      result->bytes += nbytes;
+      result->latencies.push_back(
+        std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+  }
+
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Main
+//------------------------------------------------------------------------------
+int
+main(int argc, char* argv[])
+{
+  if (argc < 4) {
+    fprintf(stderr, "usage: %s <host> <port> <path> [connections=64] "
+            "[seconds=10] [pipeline-depth=1]\n", argv[0]);
+    return EINVAL;
+  }
+
+  std::string host = argv[1];
+  std::string port = argv[2];
+  std::string path = argv[3];
+  int nconnections = (argc > 4) ? atoi(argv[4]) : 64;
+  int seconds = (argc > 5) ? atoi(argv[5]) : 10;
+  int depth = (argc > 6) ? atoi(argv[6]) : 1;
+
+  if ((nconnections < 1) || (seconds < 1) || (depth < 1)) {
+    fprintf(stderr, "error: connections, seconds and depth must be positive\n");
+    return EINVAL;
+  }
+
+  std::vector<ClientResult> results(nconnections);
+  std::vector<std::thread> clients;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < nconnections; ++i) {
+    clients.emplace_back(RunClient, host, port, path, depth, &results[i]);
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  gRun = false;
+
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  double elapsed = std::chrono::duration<double>
+                   (std::chrono::steady_clock::now() - start).count();
+  ClientResult total;
+
+  for (auto& result : results) {
+    total.requests += result.requests;
+    total.bytes += result.bytes;
+    total.errors += result.errors;
+    total.latencies.insert(total.latencies.end(), result.latencies.begin(),
+                           result.latencies.end());
+  }
+
+  std::sort(total.latencies.begin(), total.latencies.end());
+  auto percentile = [&](double p) {
+    if (total.latencies.empty()) {
+      return 0.0;
+    }
+
+    return total.latencies[(size_t)(p * (total.latencies.size() - 1))];
+  };
+  fprintf(stdout, "connections=%d depth=%d duration=%.02fs\n", nconnections,
+          depth, elapsed);
+  fprintf(stdout, "requests=%llu errors=%llu rate=%.02f Hz\n", total.requests,
+          total.errors, total.requests / elapsed);
+  fprintf(stdout, "bytes=%llu bandwidth=%.02f MB/s\n", total.bytes,
+          total.bytes / elapsed / 1000000.0);
+  fprintf(stdout, "latency p50=%.03fms p90=%.03fms p99=%.03fms max=%.03fms\n",
+          percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0));
+  return (total.errors ? EIO : 0);
+}
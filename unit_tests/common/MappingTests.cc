@@ -24,6 +24,10 @@
 #include "gtest/gtest.h"
 #include "Namespace.hh"
 #include "common/Mapping.hh"
+#include "XrdSec/XrdSecEntity.hh"
+#include <chrono>
+#include <iostream>
+#include <thread>
 
 EOSCOMMONTESTING_BEGIN
 
@@ -78,4 +82,123 @@ TEST(Mapping, VidAssignOperator)
   ASSERT_TRUE(vid.sudoer == copy_vid.sudoer);
 }
 
+//------------------------------------------------------------------------------
+// Helpers for the IdMap tests
+//------------------------------------------------------------------------------
+namespace
+{
+void InitMapping()
+{
+  static bool done = []() {
+    eos::common::Mapping::Init();
+    return true;
+  }();
+  (void) done;
+}
+
+void SetSssRule(uid_t uid, gid_t gid)
+{
+  using namespace eos::common;
+  RWMutexWriteLock lock(Mapping::gMapMutex);
+  Mapping::RulesChanged();
+  Mapping::gVirtualUidMap["sss:\"<pwd>\":uid"] = uid;
+  Mapping::gVirtualGidMap["sss:\"<pwd>\":gid"] = gid;
+}
+
+void ClearSssRule()
+{
+  using namespace eos::common;
+  RWMutexWriteLock lock(Mapping::gMapMutex);
+  Mapping::RulesChanged();
+  Mapping::gVirtualUidMap.erase("sss:\"<pwd>\":uid");
+  Mapping::gVirtualGidMap.erase("sss:\"<pwd>\":gid");
+}
+}
+
+TEST(Mapping, IdMapCacheFollowsRules)
+{
+  using namespace eos::common;
+  InitMapping();
+  SetSssRule(1234, 5678);
+  XrdSecEntity client("sss");
+  client.name = (char*) "someuser";
+  client.host = (char*) "client.cern.ch";
+  Mapping::VirtualIdentity vid;
+  Mapping::IdMap(&client, "", "someuser.1:2@client.cern.ch", vid, false);
+  ASSERT_EQ(1234u, vid.uid);
+  ASSERT_EQ(5678u, vid.gid);
+  ASSERT_TRUE(vid.tident == "someuser.1:2@client.cern.ch");
+  // a second connection of the same client is served from the cache
+  Mapping::VirtualIdentity vid2;
+  Mapping::IdMap(&client, "eos.app=test", "someuser.3:4@client.cern.ch", vid2,
+                 false);
+  ASSERT_EQ(1234u, vid2.uid);
+  ASSERT_EQ(5678u, vid2.gid);
+  ASSERT_TRUE(vid2.tident == "someuser.3:4@client.cern.ch");
+  ASSERT_EQ("test", vid2.app);
+  ASSERT_EQ("client.cern.ch", vid2.host);
+  // a rule change invalidates the cached identities
+  SetSssRule(2345, 6789);
+  Mapping::VirtualIdentity vid3;
+  Mapping::IdMap(&client, "", "someuser.1:2@client.cern.ch", vid3, false);
+  ASSERT_EQ(2345u, vid3.uid);
+  ASSERT_EQ(6789u, vid3.gid);
+  ASSERT_EQ("", vid3.app);
+  ClearSssRule();
+  Mapping::VirtualIdentity vid4;
+  Mapping::IdMap(&client, "", "someuser.1:2@client.cern.ch", vid4, false);
+  ASSERT_EQ(99u, vid4.uid);
+  ASSERT_EQ(99u, vid4.gid);
+}
+
+//------------------------------------------------------------------------------
+// Measure the IdMap rate for a growing number of threads
+//------------------------------------------------------------------------------
+TEST(Mapping, IdMapBenchmark)
+{
+  using namespace eos::common;
+  InitMapping();
+  SetSssRule(1234, 5678);
+  const size_t ncalls = 100000;
+  const size_t nclients = 64;
+
+  for (size_t nthreads = 1; nthreads <= 8; nthreads *= 2) {
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nfailed(0);
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t t = 0; t < nthreads; ++t) {
+      workers.emplace_back([&, t]() {
+        std::string sname = "user" + std::to_string(t);
+        XrdSecEntity client("sss");
+        client.name = (char*) sname.c_str();
+        client.host = (char*) "client.cern.ch";
+
+        for (size_t i = 0; i < ncalls; ++i) {
+          std::string tident = sname + "." + std::to_string(i % nclients) +
+                               ":1@client.cern.ch";
+          Mapping::VirtualIdentity vid;
+          Mapping::IdMap(&client, "", tident.c_str(), vid, false);
+
+          if (vid.uid != 1234) {
+            ++nfailed;
+          }
+        }
+      });
+    }
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                 - start).count();
+    std::cout << "[ IdMap    ] threads=" << nthreads << " calls/s="
+              << (nthreads * ncalls / sec) << std::endl;
+    ASSERT_EQ(0u, nfailed);
+  }
+
+  ClearSssRule();
+}
+
 EOSCOMMONTESTING_END
@@ -0,0 +1,174 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/FmdDbMap.hh"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+
+using eos::fst::FmdDbMapHandler;
+
+TEST(FmdDbMapTest, CompactMgmToFmd)
+{
+  eos::fst::Fmd fmd;
+  eos::fst::FmdHelper::Reset(fmd);
+  ASSERT_TRUE(FmdDbMapHandler::CompactMgmToFmd(
+                "1234 56 1500000000 11 1500000001 22 4096 1048850 99 100 "
+                "a1b2c3d4 3,7,!12,", fmd));
+  ASSERT_EQ(1234u, fmd.fid());
+  ASSERT_EQ(56u, fmd.cid());
+  ASSERT_EQ(1500000000u, fmd.ctime());
+  ASSERT_EQ(11u, fmd.ctime_ns());
+  ASSERT_EQ(1500000001u, fmd.mtime());
+  ASSERT_EQ(22u, fmd.mtime_ns());
+  ASSERT_EQ(4096u, fmd.mgmsize());
+  ASSERT_EQ(1048850u, fmd.lid());
+  ASSERT_EQ(99u, fmd.uid());
+  ASSERT_EQ(100u, fmd.gid());
+  ASSERT_STREQ("a1b2c3d4", fmd.mgmchecksum().c_str());
+  ASSERT_STREQ("3,7,!12,", fmd.locations().c_str());
+  // Empty location list
+  ASSERT_TRUE(FmdDbMapHandler::CompactMgmToFmd(
+                "1 2 3 4 5 6 7 8 9 10 none -", fmd));
+  ASSERT_STREQ("none", fmd.mgmchecksum().c_str());
+  ASSERT_STREQ("", fmd.locations().c_str());
+  // Malformed records
+  ASSERT_FALSE(FmdDbMapHandler::CompactMgmToFmd("1 2 3", fmd));
+  ASSERT_FALSE(FmdDbMapHandler::CompactMgmToFmd(
+                 "id=1&cid=2&ctime=3", fmd));
+  ASSERT_FALSE(FmdDbMapHandler::CompactMgmToFmd(
+                 "1 2 3 4 5 6 7 8 9 10 abcd", fmd));
+}
+
+//------------------------------------------------------------------------------
+// The monitor records sent by MGMs without the compact format, including the
+// ones of unlinked files, give the same Fmd as the compact records
+//------------------------------------------------------------------------------
+TEST(FmdDbMapTest, EnvMgmToFmdUnlinked)
+{
+  eos::fst::Fmd compact_fmd, env_fmd;
+  eos::fst::FmdHelper::Reset(compact_fmd);
+  eos::fst::FmdHelper::Reset(env_fmd);
+  ASSERT_TRUE(FmdDbMapHandler::CompactMgmToFmd(
+                "1234 0 1500000000 11 1500000001 22 4096 1048850 99 100 "
+                "a1b2c3d4 !12,", compact_fmd));
+  XrdOucEnv env("name=f&id=1234&ctime=1500000000&ctime_ns=11&"
+                "mtime=1500000001&mtime_ns=22&size=4096&cid=0&uid=99&gid=100&"
+                "lid=1048850&location=!12,&checksum=a1b2c3d4&container=-");
+  ASSERT_TRUE(FmdDbMapHandler::EnvMgmToFmd(env, env_fmd));
+  ASSERT_EQ(compact_fmd.SerializeAsString(), env_fmd.SerializeAsString());
+  ASSERT_STREQ("!12,", env_fmd.locations().c_str());
+}
+
+//------------------------------------------------------------------------------
+// Drive the Fmd commit path at 10k closes/s with every durability mode and
+// check that all the records are visible right after the commit returns.
+//------------------------------------------------------------------------------
+TEST(FmdDbMapTest, GroupCommitBenchmark)
+{
+  using namespace std::chrono;
+  const eos::common::FileSystem::fsid_t fsid = 4242;
+  const size_t nthreads = 8;
+  const size_t per_thread = 1250;
+  const size_t target_rate = 10000;
+  char tmp_dir[] = "/tmp/eos.fmd.XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmp_dir) != nullptr);
+  eos::fst::FmdDbMapHandler& handler = eos::fst::gFmdDbMapHandler;
+  ASSERT_TRUE(handler.SetDBFile(tmp_dir, fsid));
+  std::vector<std::pair<FmdDbMapHandler::CommitMode, std::string>> modes {
+    {FmdDbMapHandler::CommitMode::kSync, "sync"},
+    {FmdDbMapHandler::CommitMode::kGroup, "group"},
+    {FmdDbMapHandler::CommitMode::kAsync, "async"}
+  };
+  uint64_t base_fid = 1;
+
+  for (const auto& mode : modes) {
+    handler.SetCommitMode(mode.first, 2, 256);
+    std::atomic<uint64_t> total_lat_us {0};
+    std::atomic<uint64_t> max_lat_us {0};
+    std::atomic<size_t> failed {0};
+    std::vector<std::thread> workers;
+    auto start = steady_clock::now();
+
+    for (size_t t = 0; t < nthreads; ++t) {
+      workers.emplace_back([&, t]() {
+        // Each thread issues its share of the target rate
+        auto period = microseconds(1000000 * nthreads / target_rate);
+        auto next = steady_clock::now();
+
+        for (size_t i = 0; i < per_thread; ++i) {
+          uint64_t fid = base_fid + t * per_thread + i;
+          std::unique_ptr<eos::fst::FmdHelper> fmd(
+            new eos::fst::FmdHelper(fid, fsid));
+          fmd->mProtoFmd.set_size(i);
+          auto t0 = steady_clock::now();
+
+          if (!handler.Commit(fmd.get())) {
+            ++failed;
+          }
+
+          uint64_t lat = duration_cast<microseconds>(steady_clock::now() -
+                         t0).count();
+          total_lat_us += lat;
+          uint64_t prev = max_lat_us.load();
+
+          while ((lat > prev) && !max_lat_us.compare_exchange_weak(prev, lat)) {}
+
+          next += period;
+          std::this_thread::sleep_until(next);
+        }
+      });
+    }
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    double duration = duration_cast<milliseconds>(steady_clock::now() -
+                      start).count() / 1000.0;
+    size_t ncommits = nthreads * per_thread;
+    std::cout << "[ BENCH    ] mode=" << mode.second
+              << " commits=" << ncommits
+              << " rate=" << (duration ? ncommits / duration : 0) << "Hz"
+              << " avg_latency=" << (total_lat_us / ncommits) << "us"
+              << " max_latency=" << max_lat_us << "us" << std::endl;
+    ASSERT_EQ(0u, failed);
+
+    // Read-your-writes: every record is visible even if not yet flushed
+    for (uint64_t fid = base_fid; fid < base_fid + ncommits; ++fid) {
+      std::unique_ptr<eos::fst::FmdHelper> fmd(
+        handler.LocalGetFmd(fid, fsid, 0, 0, 0, false, true));
+      ASSERT_TRUE(fmd != nullptr);
+      ASSERT_EQ(fid, fmd->mProtoFmd.fid());
+    }
+
+    ASSERT_TRUE(handler.FlushPending(fsid));
+    ASSERT_EQ((long long)(base_fid + ncommits - 1), handler.GetNumFiles(fsid));
+    base_fid += ncommits;
+  }
+
+  handler.SetCommitMode(FmdDbMapHandler::CommitMode::kGroup, 2, 256);
+  ASSERT_TRUE(handler.ShutdownDB(fsid));
+  std::string rm_cmd = "rm -rf ";
+  rm_cmd += tmp_dir;
+  (void) system(rm_cmd.c_str());
+}
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+// File: IoStatisticsTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/IoStatistics.hh"
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+using eos::fst::StreamingStats;
+
+TEST(IoStatisticsTest, Empty)
+{
+  StreamingStats stats;
+  ASSERT_EQ(0ull, stats.Count());
+  ASSERT_EQ(0ull, stats.Sum());
+  ASSERT_EQ(0ull, stats.Min());
+  ASSERT_EQ(0ull, stats.Max());
+  ASSERT_EQ(0.0, stats.Sigma());
+  ASSERT_EQ(0.0, stats.Percentile(0.5));
+}
+
+TEST(IoStatisticsTest, MatchesNaiveComputation)
+{
+  StreamingStats stats;
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<uint64_t> dist(1, 4 * 1024 * 1024);
+  std::vector<uint64_t> values;
+
+  for (int i = 0; i < 10000; ++i) {
+    values.push_back(dist(rng));
+    stats.Add(values.back());
+  }
+
+  uint64_t sum = 0, min = UINT64_MAX, max = 0;
+
+  for (auto v : values) {
+    sum += v;
+    min = std::min(min, v);
+    max = std::max(max, v);
+  }
+
+  double avg = (double) sum / values.size();
+  double var = 0;
+
+  for (auto v : values) {
+    var += (v - avg) * (v - avg);
+  }
+
+  double sigma = sqrt(var / values.size());
+  ASSERT_EQ(values.size(), stats.Count());
+  ASSERT_EQ(sum, stats.Sum());
+  ASSERT_EQ(min, stats.Min());
+  ASSERT_EQ(max, stats.Max());
+  ASSERT_NEAR(sigma, stats.Sigma(), sigma * 1e-6);
+}
+
+TEST(IoStatisticsTest, Percentiles)
+{
+  StreamingStats stats;
+
+  // 90 small reads of 4k and 10 large ones of 1M
+  for (int i = 0; i < 90; ++i) {
+    stats.Add(4096);
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    stats.Add(1024 * 1024);
+  }
+
+  ASSERT_EQ(StreamingStats::Bucket(4096),
+            StreamingStats::Bucket(stats.Percentile(0.5)));
+  ASSERT_EQ(1024.0 * 1024, stats.Percentile(0.99));
+  ASSERT_EQ(1024.0 * 1024, stats.Percentile(1.0));
+  // Percentiles are only accurate up to the power of two bucket
+  StreamingStats uniform;
+
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    uniform.Add(i);
+  }
+
+  double p50 = uniform.Percentile(0.5);
+  ASSERT_GE(p50, 256.0);
+  ASSERT_LE(p50, 1024.0);
+  ASSERT_EQ(StreamingStats::Bucket(500), StreamingStats::Bucket(p50));
+}
+
+TEST(IoStatisticsTest, ConcurrentAdd)
+{
+  StreamingStats stats;
+  std::vector<std::thread> threads;
+  const uint64_t per_thread = 100000;
+
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&stats, t, per_thread]() {
+      for (uint64_t i = 1; i <= per_thread; ++i) {
+        stats.Add(i + t);
+      }
+    });
+  }
+
+  for (auto& th : threads) {
+    th.join();
+  }
+
+  ASSERT_EQ(4 * per_thread, stats.Count());
+  ASSERT_EQ(4 * (per_thread * (per_thread + 1) / 2) + per_thread * 6,
+            stats.Sum());
+  ASSERT_EQ(1ull, stats.Min());
+  ASSERT_EQ(per_thread + 3, stats.Max());
+}
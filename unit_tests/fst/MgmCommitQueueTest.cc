@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+// File: MgmCommitQueueTest.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/MgmCommitQueue.hh"
+#include <cerrno>
+#include <string>
+#include <vector>
+
+using eos::fst::MgmCommitQueue;
+
+//------------------------------------------------------------------------------
+// Per commit errors in the reply of a commit batch
+//------------------------------------------------------------------------------
+TEST(MgmCommitQueue, ParseReply)
+{
+  std::vector<int> errnos(4, -1);
+  std::vector<std::string> msgs;
+  ASSERT_TRUE(MgmCommitQueue::ParseReply("OK", errnos, msgs));
+  ASSERT_EQ(std::vector<int>(4, 0), errnos);
+  ASSERT_EQ(std::vector<std::string>(4, ""), msgs);
+  // the reply may carry the string terminator
+  ASSERT_TRUE(MgmCommitQueue::ParseReply(std::string("OK\0", 3), errnos, msgs));
+  std::string reply = "OK&mgm.commit.1=";
+  reply += std::to_string(EIDRM);
+  reply += "&mgm.commit.3=";
+  reply += std::to_string(EIO);
+  // base64 of "commit replica - file not found"
+  reply += "&mgm.commit.3.msg=Y29tbWl0IHJlcGxpY2EgLSBmaWxlIG5vdCBmb3VuZA==";
+  ASSERT_TRUE(MgmCommitQueue::ParseReply(reply, errnos, msgs));
+  ASSERT_EQ(0, errnos[0]);
+  ASSERT_EQ(EIDRM, errnos[1]);
+  ASSERT_EQ(0, errnos[2]);
+  ASSERT_EQ(EIO, errnos[3]);
+  ASSERT_EQ("", msgs[1]);
+  ASSERT_EQ("commit replica - file not found", msgs[3]);
+  // invalid replies
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("error: unknown", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.4=5", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.1=", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.=5", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.1=5x", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.1x=5", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OKmgm.commit.1=5", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&other=5", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.1.msg=", errnos, msgs));
+  ASSERT_FALSE(MgmCommitQueue::ParseReply("OK&mgm.commit.1.other=YQ==", errnos,
+                                          msgs));
+}
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+// File: AclTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/Acl.hh"
+#include <chrono>
+#include <iostream>
+
+using namespace eos::mgm;
+
+//------------------------------------------------------------------------------
+// Build a virtual identity with one group
+//------------------------------------------------------------------------------
+static eos::common::Mapping::VirtualIdentity MakeVid(uid_t uid, gid_t gid)
+{
+  eos::common::Mapping::VirtualIdentity vid;
+  vid.uid = uid;
+  vid.gid = gid;
+  vid.uid_list = {uid};
+  vid.gid_list = {gid};
+  return vid;
+}
+
+TEST(Acl, CompiledRules)
+{
+  auto compiled = Acl::Compile("u:1000:rwxq,g:2000:!d,z:i,bogus:rw,u:1001",
+                               "u:1000:c", true);
+  // the rule without permissions and the unknown type are dropped
+  ASSERT_EQ(4u, compiled->mRules.size());
+  ASSERT_EQ(Acl::CompiledAcl::kUser, compiled->mRules[0].mKind);
+  ASSERT_TRUE(compiled->mRules[0].mNumeric);
+  ASSERT_EQ(1000u, compiled->mRules[0].mId);
+  ASSERT_EQ(Acl::CompiledAcl::kRead | Acl::CompiledAcl::kWrite |
+            Acl::CompiledAcl::kBrowse | Acl::CompiledAcl::kQuota,
+            compiled->mRules[0].mFlags);
+  ASSERT_EQ(Acl::CompiledAcl::kZ, compiled->mRules[2].mKind);
+  // 'c' is only valid in the sys.acl
+  ASSERT_EQ(0u, compiled->mRules[3].mFlags);
+  // the same definition is served from the cache
+  ASSERT_EQ(compiled.get(),
+            Acl::Compile("u:1000:rwxq,g:2000:!d,z:i,bogus:rw,u:1001",
+                         "u:1000:c", true).get());
+}
+
+TEST(Acl, Evaluation)
+{
+  auto vid = MakeVid(1000, 2000);
+  Acl acl("u:1000:rwx,g:2000:!d,z:i", "", vid);
+  ASSERT_TRUE(acl.HasAcl());
+  ASSERT_TRUE(acl.CanRead());
+  ASSERT_TRUE(acl.CanWrite());
+  ASSERT_TRUE(acl.CanBrowse());
+  ASSERT_TRUE(acl.CanNotDelete());
+  ASSERT_FALSE(acl.IsMutable());
+  // 'wo' takes precedence over 'w' and '+d' over '!d'
+  Acl acl2("g:2000:wo,u:1000:w+d,g:2000:!d", "", vid);
+  ASSERT_FALSE(acl2.CanWriteOnce());
+  ASSERT_TRUE(acl2.CanWrite());
+  ASSERT_TRUE(acl2.CanDelete());
+  ASSERT_FALSE(acl2.CanNotDelete());
+  // user acl only counts if enabled
+  Acl acl3("u:5:r", "u:1000:r", vid, false);
+  ASSERT_FALSE(acl3.CanRead());
+  Acl acl4("u:5:r", "u:1000:r", vid, true);
+  ASSERT_TRUE(acl4.CanRead());
+  // system groups are never checked
+  auto root_grp = MakeVid(1000, 0);
+  Acl acl5("u:1000:rwx", "", root_grp);
+  ASSERT_FALSE(acl5.HasAcl());
+}
+
+//------------------------------------------------------------------------------
+// Measure the evaluation rate of a 100-entry ACL matched by the last rule
+//------------------------------------------------------------------------------
+TEST(Acl, Benchmark100Entries)
+{
+  std::string sysacl;
+
+  for (int i = 0; i < 100; ++i) {
+    sysacl += "u:" + std::to_string(5000 + i) + ":rwx,";
+  }
+
+  sysacl += "g:2000:rx";
+  auto vid = MakeVid(1000, 2000);
+  const size_t nloops = 100000;
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < nloops; ++i) {
+    Acl acl(sysacl, "", vid);
+    ASSERT_TRUE(acl.CanRead());
+    ASSERT_FALSE(acl.CanWrite());
+  }
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+               start).count();
+  std::cout << "[ Acl      ] 100-entry evaluations/s=" << (nloops / sec)
+            << std::endl;
+}
@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+// File: EgroupTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/Egroup.hh"
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace eos::mgm;
+
+//------------------------------------------------------------------------------
+// Write a local e-group directory and return its path
+//------------------------------------------------------------------------------
+static std::string WriteDirectory(const std::string& content)
+{
+  char path[] = "/tmp/eos-egroup-test.XXXXXX";
+  int fd = mkstemp(path);
+  close(fd);
+  std::ofstream file(path);
+  file << content;
+  return path;
+}
+
+TEST(Egroup, SynchronousWithoutThread)
+{
+  std::string path = WriteDirectory("# test\nexperiment alice bob\n");
+  Egroup::Reset();
+  Egroup::SetDirectory(path);
+  std::string alice = "alice";
+  std::string carol = "carol";
+  std::string egroup = "experiment";
+  ASSERT_TRUE(Egroup::Member(alice, egroup));
+  ASSERT_FALSE(Egroup::Member(carol, egroup));
+  Egroup::Stats before = Egroup::GetStats();
+  ASSERT_TRUE(Egroup::Member(alice, egroup));
+  ASSERT_EQ(before.hits + 1, Egroup::GetStats().hits);
+  // without refresh thread a query does not report pending entries
+  std::string bob = "bob";
+  ASSERT_EQ(Egroup::kMember, Egroup::Query(bob, egroup));
+  Egroup::SetDirectory("");
+  unlink(path.c_str());
+}
+
+TEST(Egroup, AsynchronousRefresh)
+{
+  std::string path = WriteDirectory("experiment alice bob\nother carol\n");
+  Egroup::Reset();
+  Egroup::SetDirectory(path);
+  Egroup refresh;
+  ASSERT_TRUE(refresh.Start());
+  std::string bob = "bob";
+  std::string carol = "carol";
+  std::string egroup = "experiment";
+  std::string other = "other";
+  Egroup::Stats before = Egroup::GetStats();
+  // a query never waits, the miss is resolved by the refresh thread
+  Egroup::Status status = Egroup::Query(bob, egroup);
+  ASSERT_EQ(Egroup::kPending, status);
+
+  for (int i = 0; (i < 500) && (status == Egroup::kPending); ++i) {
+    usleep(10000);
+    status = Egroup::Query(bob, egroup);
+  }
+
+  ASSERT_EQ(Egroup::kMember, status);
+  // misses of Member are resolved synchronously
+  ASSERT_FALSE(Egroup::Member(carol, egroup));
+  ASSERT_TRUE(Egroup::Member(carol, other));
+  Egroup::Stats after = Egroup::GetStats();
+  ASSERT_LE(before.misses + 3, after.misses);
+  ASSERT_LE(before.pending + 1, after.pending);
+  ASSERT_LE(before.refreshes + 1, after.refreshes);
+  ASSERT_NE(std::string::npos,
+            Egroup::DumpMembers().find("egroup=experiment user=bob member=true"));
+  refresh.Stop();
+  Egroup::SetDirectory("");
+  unlink(path.c_str());
+}
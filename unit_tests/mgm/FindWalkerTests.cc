@@ -0,0 +1,279 @@
+//------------------------------------------------------------------------------
+// File: FindWalkerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/FindWalker.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+
+using eos::mgm::FindWalker;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// In-memory tree: directory path -> names of its sub-directories, every
+// directory holds the files f1 and f2
+//------------------------------------------------------------------------------
+std::map<std::string, std::vector<std::string>> MakeTree()
+{
+  std::map<std::string, std::vector<std::string>> tree;
+  // Names whose path order differs from the name order with the '/'
+  const std::vector<std::string> names {"d", "c", "b-x", "b", "b.x", "a"};
+
+  for (const auto& l1 : names) {
+    tree["/t/"].push_back(l1);
+
+    for (const auto& l2 : names) {
+      tree["/t/" + l1 + "/"].push_back(l2);
+
+      for (const auto& l3 : names) {
+        tree["/t/" + l1 + "/" + l2 + "/"].push_back(l3);
+        tree["/t/" + l1 + "/" + l2 + "/" + l3 + "/"];
+      }
+    }
+  }
+
+  return tree;
+}
+
+//------------------------------------------------------------------------------
+// List a directory of the tree, slowing down some of them to shuffle the
+// order in which the helpers finish
+//------------------------------------------------------------------------------
+bool List(const std::map<std::string, std::vector<std::string>>& tree,
+          const FindWalker::Dir& dir, std::vector<FindWalker::Dir>& subdirs,
+          std::set<std::string>& files, bool& exists)
+{
+  auto it = tree.find(dir.mPath);
+
+  if (it == tree.end()) {
+    exists = false;
+    return true;
+  }
+
+  exists = true;
+
+  if (dir.mPath.length() % 3 == 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+
+  for (const auto& name : it->second) {
+    subdirs.push_back(FindWalker::Dir{dir.mPath + name + "/", dir.mDepth + 1,
+                                      true});
+  }
+
+  files.insert("f1");
+  files.insert("f2");
+  return true;
+}
+}
+
+TEST(FindWalker, PathOrder)
+{
+  auto tree = MakeTree();
+  std::vector<std::string> expected;
+
+  for (const auto& elem : tree) {
+    expected.push_back(elem.first);
+  }
+
+  eos::common::ThreadPool pool(4, 4);
+
+  for (unsigned int helpers : {0u, 3u}) {
+    std::vector<std::string> emitted;
+    std::atomic<int> in_emit(0);
+    FindWalker walker([&](const FindWalker::Dir & dir,
+                          std::vector<FindWalker::Dir>& subdirs,
+    std::set<std::string>& files, bool & exists) {
+      return List(tree, dir, subdirs, files, exists);
+    }, [&](const std::string & dir, std::set<std::string>& files) {
+      // Calls are never concurrent
+      EXPECT_EQ(1, ++in_emit);
+      emitted.push_back(dir);
+      EXPECT_EQ(2u, files.size());
+      --in_emit;
+      return true;
+    }, 0);
+    ASSERT_EQ(expected.size(), walker.Walk("/t/", &pool, helpers));
+    ASSERT_EQ(expected, emitted);
+  }
+}
+
+TEST(FindWalker, MissingStart)
+{
+  auto tree = MakeTree();
+  FindWalker walker([&](const FindWalker::Dir & dir,
+                        std::vector<FindWalker::Dir>& subdirs,
+  std::set<std::string>& files, bool & exists) {
+    return List(tree, dir, subdirs, files, exists);
+  }, [&](const std::string & dir, std::set<std::string>& files) {
+    return true;
+  }, 0);
+  ASSERT_EQ(0u, walker.Walk("/missing/", nullptr, 0));
+}
+
+TEST(FindWalker, MaxDepth)
+{
+  auto tree = MakeTree();
+  eos::common::ThreadPool pool(4, 4);
+  std::vector<std::string> expected;
+
+  for (const auto& elem : tree) {
+    // Directories at depth 2 are part of the result but not listed
+    if (std::count(elem.first.begin(), elem.first.end(), '/') <= 4) {
+      expected.push_back(elem.first);
+    }
+  }
+
+  std::atomic<int> listed(0);
+  std::vector<std::string> emitted;
+  std::vector<size_t> nfiles;
+  FindWalker walker([&](const FindWalker::Dir & dir,
+                        std::vector<FindWalker::Dir>& subdirs,
+  std::set<std::string>& files, bool & exists) {
+    EXPECT_LT(dir.mDepth, 2);
+    ++listed;
+    return List(tree, dir, subdirs, files, exists);
+  }, [&](const std::string & dir, std::set<std::string>& files) {
+    emitted.push_back(dir);
+    nfiles.push_back(files.size());
+    return true;
+  }, 2);
+  ASSERT_EQ(expected.size(), walker.Walk("/t/", &pool, 3));
+  ASSERT_EQ(expected, emitted);
+  ASSERT_EQ(7, listed);
+
+  for (size_t i = 0; i < emitted.size(); ++i) {
+    ASSERT_EQ((std::count(emitted[i].begin(), emitted[i].end(), '/') < 4) ?
+              2u : 0u, nfiles[i]);
+  }
+}
+
+TEST(FindWalker, Limit)
+{
+  auto tree = MakeTree();
+  const std::string limited = "/t/b/";
+  std::vector<std::string> expected;
+
+  // Without helpers the directories are listed in path order: the ones up to
+  // the limited one, then the sub-directories it found before the limit
+  for (const auto& elem : tree) {
+    if (elem.first <= limited) {
+      expected.push_back(elem.first);
+    }
+  }
+
+  expected.push_back(limited + "d/");
+  expected.push_back(limited + "c/");
+  std::sort(expected.begin(), expected.end());
+  eos::common::ThreadPool pool(4, 4);
+
+  for (unsigned int helpers : {0u, 3u}) {
+    std::atomic<bool> stopped(false);
+    std::atomic<int> listed_after(0);
+    std::vector<std::string> emitted;
+    FindWalker walker([&](const FindWalker::Dir & dir,
+                          std::vector<FindWalker::Dir>& subdirs,
+    std::set<std::string>& files, bool & exists) {
+      if (stopped) {
+        ++listed_after;
+      }
+
+      if (dir.mPath == limited) {
+        exists = true;
+        subdirs.push_back(FindWalker::Dir{limited + "d/", 2, true});
+        subdirs.push_back(FindWalker::Dir{limited + "c/", 2, true});
+        stopped = true;
+        return false;
+      }
+
+      return List(tree, dir, subdirs, files, exists);
+    }, [&](const std::string & dir, std::set<std::string>& files) {
+      emitted.push_back(dir);
+      return true;
+    }, 0);
+    walker.Walk("/t/", helpers ? &pool : nullptr, helpers);
+    ASSERT_TRUE(std::is_sorted(emitted.begin(), emitted.end()));
+
+    if (!helpers) {
+      ASSERT_EQ(expected, emitted);
+      ASSERT_EQ(0, listed_after);
+    } else {
+      // Only the sub-directories found before the limit are in the result
+      std::vector<std::string> below;
+
+      for (const auto& path : emitted) {
+        if (path.compare(0, limited.length(), limited) == 0) {
+          below.push_back(path);
+        }
+      }
+
+      ASSERT_EQ((std::vector<std::string> {
+        limited, limited + "c/", limited + "d/"
+      }), below);
+    }
+  }
+}
+
+TEST(FindWalker, Abort)
+{
+  auto tree = MakeTree();
+  std::vector<std::string> expected;
+
+  for (const auto& elem : tree) {
+    if (expected.size() < 10) {
+      expected.push_back(elem.first);
+    }
+  }
+
+  eos::common::ThreadPool pool(4, 4);
+
+  for (unsigned int helpers : {0u, 3u}) {
+    std::atomic<bool> aborted(false);
+    std::atomic<int> listed_after(0);
+    std::vector<std::string> emitted;
+    FindWalker walker([&](const FindWalker::Dir & dir,
+                          std::vector<FindWalker::Dir>& subdirs,
+    std::set<std::string>& files, bool & exists) {
+      if (aborted) {
+        ++listed_after;
+      }
+
+      return List(tree, dir, subdirs, files, exists);
+    }, [&](const std::string & dir, std::set<std::string>& files) {
+      EXPECT_FALSE(aborted);
+      emitted.push_back(dir);
+      aborted = (emitted.size() == expected.size());
+      return !aborted;
+    }, 0);
+    ASSERT_EQ(expected.size(), walker.Walk("/t/", helpers ? &pool : nullptr,
+                                           helpers));
+    ASSERT_EQ(expected, emitted);
+
+    if (!helpers) {
+      ASSERT_EQ(0, listed_after);
+    }
+  }
+}
@@ -0,0 +1,461 @@
+//------------------------------------------------------------------------------
+// File: FsStateTableTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/FsStateTable.hh"
+#include "mgm/FsViewAggregate.hh"
+#include "mq/XrdMqSharedObject.hh"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using eos::common::FileSystem;
+
+//------------------------------------------------------------------------------
+// Create file systems with some values in their shared hash
+//------------------------------------------------------------------------------
+static void
+CreateFileSystems(XrdMqSharedObjectManager& mgr, size_t n_fs,
+                  std::vector<std::unique_ptr<FileSystem>>& fss)
+{
+  for (size_t i = 0; i < n_fs; ++i) {
+    std::string queue = "/eos/fst" + std::to_string(i / 24) +
+                        ".cern.ch:1095/fst";
+    std::string path = queue + "/data" + std::to_string(i % 24);
+    fss.emplace_back(new FileSystem(path.c_str(), queue.c_str(), &mgr));
+    FileSystem* fs = fss.back().get();
+    fs->OpenTransaction();
+    fs->SetLongLong("id", i + 1);
+    fs->SetString("schedgroup", ("default." + std::to_string(i % 24)).c_str());
+    fs->SetStatus((i % 7) ? FileSystem::kBooted : FileSystem::kDown);
+    fs->SetString("stat.active", (i % 5) ? "online" : "offline");
+    fs->SetConfigStatus((i % 3) ? FileSystem::kRW : FileSystem::kOff);
+    fs->SetLongLong("stat.statfs.capacity", 4000000000000ll + i);
+    fs->SetLongLong("stat.statfs.freebytes", 1000000000000ll + i);
+    fs->SetString("headroom", "10G");
+    fs->SetDouble("stat.disk.load", 0.01 * (i % 100));
+    fs->SetDouble("stat.statfs.filled", 25.0 + 0.001 * i);
+    fs->CloseTransaction();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Table values match the file system getters and follow hash changes
+//------------------------------------------------------------------------------
+TEST(FsStateTable, MatchesGetters)
+{
+  const size_t n_fs = 240;
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::vector<std::unique_ptr<FileSystem>> fss;
+  CreateFileSystems(mgr, n_fs, fss);
+  eos::mgm::FsStateTable table;
+  // Single threaded, the rows are read without their mutexes
+  table.Reserve(n_fs);
+  std::vector<std::string> keys {"stat.statfs.capacity", "headroom",
+                                 "stat.disk.load", "schedgroup", "<n>", "nokey"};
+
+  for (size_t i = 0; i < n_fs; ++i) {
+    ASSERT_TRUE(table.Refresh(i + 1, fss[i].get()));
+  }
+
+  for (size_t i = 0; i < n_fs; ++i) {
+    FileSystem* fs = fss[i].get();
+
+    for (const auto& key : keys) {
+      size_t col = table.GetColumn(key);
+      // A new column forces a re-read of the row
+      table.Refresh(i + 1, fs);
+      ASSERT_EQ(fs->GetString(key.c_str()), table.GetString(i + 1, col));
+      ASSERT_EQ(fs->GetLongLong(key.c_str()), table.GetLongLong(i + 1, col));
+      ASSERT_EQ(fs->GetDouble(key.c_str()), table.GetDouble(i + 1, col));
+    }
+
+    bool considered = ((fs->GetConfigStatus() >= FileSystem::kRO) &&
+                       (fs->GetStatus() == FileSystem::kBooted) &&
+                       (fs->GetActiveStatus() == FileSystem::kOnline));
+    ASSERT_EQ(considered, table.IsConsidered(i + 1));
+  }
+
+  // Only the modified file system is re-read
+  for (size_t i = 0; i < n_fs; ++i) {
+    ASSERT_FALSE(table.Refresh(i + 1, fss[i].get()));
+  }
+
+  FileSystem::fs_snapshot_t snapshot;
+  ASSERT_TRUE(fss[7]->SnapShotFileSystem(snapshot));
+  ASSERT_EQ(4000000000007ll, snapshot.mDiskCapacity);
+  fss[7]->SetLongLong("stat.statfs.capacity", 42);
+  size_t col = table.GetColumn("stat.statfs.capacity");
+
+  for (size_t i = 0; i < n_fs; ++i) {
+    ASSERT_EQ(i == 7, table.Refresh(i + 1, fss[i].get()));
+  }
+
+  ASSERT_EQ(42, table.GetLongLong(8, col));
+  ASSERT_TRUE(fss[7]->SnapShotFileSystem(snapshot));
+  ASSERT_EQ(42, snapshot.mDiskCapacity);
+  // A missing file system clears its row
+  ASSERT_TRUE(table.Refresh(8, nullptr));
+  ASSERT_EQ(0, table.GetLongLong(8, col));
+  ASSERT_FALSE(table.IsAvailable(8));
+}
+
+//------------------------------------------------------------------------------
+// Compare aggregating through the getters and through the table
+//------------------------------------------------------------------------------
+TEST(FsStateTable, AggregationBenchmark)
+{
+  const size_t n_fs = 10000;
+  const size_t n_loop = 5;
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::vector<std::unique_ptr<FileSystem>> fss;
+  CreateFileSystems(mgr, n_fs, fss);
+  std::vector<std::string> keys {"stat.statfs.capacity", "stat.statfs.freebytes",
+                                 "stat.disk.load", "stat.statfs.filled"};
+  double direct_sum = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t loop = 0; loop < n_loop; ++loop) {
+    direct_sum = 0;
+
+    for (const auto& key : keys) {
+      for (size_t i = 0; i < n_fs; ++i) {
+        if ((fss[i]->GetConfigStatus() >= FileSystem::kRO) &&
+            (fss[i]->GetStatus() == FileSystem::kBooted) &&
+            (fss[i]->GetActiveStatus() == FileSystem::kOnline)) {
+          direct_sum += fss[i]->GetDouble(key.c_str());
+        }
+      }
+    }
+  }
+
+  double direct = std::chrono::duration<double>
+                  (std::chrono::steady_clock::now() - start).count();
+  eos::mgm::FsStateTable table;
+  double table_sum = 0;
+  start = std::chrono::steady_clock::now();
+  table.Reserve(n_fs);
+
+  for (size_t loop = 0; loop < n_loop; ++loop) {
+    table_sum = 0;
+
+    for (const auto& key : keys) {
+      size_t col = table.GetColumn(key);
+      eos::common::RWMutexReadLock lock(table.GetMutex());
+
+      for (size_t i = 0; i < n_fs; ++i) {
+        table.Refresh(i + 1, fss[i].get());
+
+        if (table.IsConsidered(i + 1)) {
+          table_sum += table.GetDouble(i + 1, col);
+        }
+      }
+    }
+  }
+
+  double cached = std::chrono::duration<double>
+                  (std::chrono::steady_clock::now() - start).count();
+  ASSERT_EQ(direct_sum, table_sum);
+  std::cout << "[ BENCH    ] filesystems=" << n_fs << " keys=" << keys.size()
+            << " getters=" << 1000 * direct / n_loop << "ms table="
+            << 1000 * cached / n_loop << "ms" << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Compute the double aggregates of a column like the scans of BaseView, with
+// the deviations taken from ref if given
+//------------------------------------------------------------------------------
+static std::vector<double>
+ScanDoubles(const eos::mgm::FsStateTable& table,
+            const std::vector<FileSystem::fsid_t>& fsids, size_t col,
+            const double* ref = nullptr)
+{
+  double sum = 0;
+  double counted_sum = 0;
+  int cnt = 0;
+
+  for (auto fsid : fsids) {
+    sum += table.GetDouble(fsid, col);
+
+    if (table.IsConsidered(fsid)) {
+      cnt++;
+      counted_sum += table.GetDouble(fsid, col);
+    }
+  }
+
+  double counted_avg = (cnt) ? (double)(1.0 * counted_sum / cnt) : 0;
+  double avg = (ref ? *ref : counted_avg);
+  double sumsquare = 0;
+  double maxabsdev = 0;
+  double maxdev = -DBL_MAX;
+  double mindev = DBL_MAX;
+
+  for (auto fsid : fsids) {
+    if (table.IsConsidered(fsid)) {
+      sumsquare += pow((avg - table.GetDouble(fsid, col)), 2);
+      maxabsdev = std::max(maxabsdev, fabs(avg - table.GetDouble(fsid, col)));
+      double dev = -(avg - table.GetDouble(fsid, col));
+
+      if (dev > maxdev) {
+        maxdev = dev;
+      }
+
+      if (dev < mindev) {
+        mindev = dev;
+      }
+    }
+  }
+
+  return {sum, counted_avg, (cnt) ? sqrt(sumsquare / cnt) : 0, maxabsdev,
+          maxdev, mindev};
+}
+
+//------------------------------------------------------------------------------
+// Get the double aggregates of a column in the order of ScanDoubles
+//------------------------------------------------------------------------------
+static std::vector<double>
+AggregateDoubles(const eos::mgm::FsViewAggregate& aggregate, size_t col,
+                 const double* ref = nullptr)
+{
+  if (ref) {
+    return {aggregate.SumDouble(col), aggregate.AverageDouble(col),
+            aggregate.SigmaDouble(col, *ref), aggregate.MaxAbsDeviation(col, *ref),
+            aggregate.MaxDeviation(col, *ref), aggregate.MinDeviation(col, *ref)};
+  }
+
+  return {aggregate.SumDouble(col), aggregate.AverageDouble(col),
+          aggregate.SigmaDouble(col), aggregate.MaxAbsDeviation(col),
+          aggregate.MaxDeviation(col), aggregate.MinDeviation(col)};
+}
+
+//------------------------------------------------------------------------------
+// Check that the running aggregates agree with a scan up to rounding
+//------------------------------------------------------------------------------
+static void
+ExpectNear(const std::vector<double>& scan, const std::vector<double>& result)
+{
+  ASSERT_EQ(scan.size(), result.size());
+
+  for (size_t i = 0; i < scan.size(); ++i) {
+    EXPECT_NEAR(scan[i], result[i], 1e-9 * std::max(1.0, fabs(scan[i])))
+        << "result " << i;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Aggregates follow value and membership changes and give the results of a
+// full scan
+//------------------------------------------------------------------------------
+TEST(FsViewAggregate, MatchesScan)
+{
+  const size_t n_fs = 480;
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::vector<std::unique_ptr<FileSystem>> fss;
+  CreateFileSystems(mgr, n_fs, fss);
+  eos::mgm::FsStateTable table;
+  eos::mgm::FsViewAggregate aggregate;
+  table.Reserve(n_fs);
+  size_t lcol = table.GetColumn("stat.statfs.capacity");
+  size_t dcol = table.GetColumn("stat.statfs.filled");
+  std::vector<FileSystem::fsid_t> fsids;
+  unsigned long long stamp = 0;
+
+  for (size_t loop = 0; loop < 20; ++loop) {
+    // Change some values and move file systems in and out of the view
+    for (size_t i = loop; i < n_fs; i += 7) {
+      fss[i]->SetDouble("stat.statfs.filled", 0.37 * loop + 0.011 * i);
+      fss[i]->SetLongLong("stat.statfs.capacity", 3000000000000ll + loop * i);
+      fss[i]->SetStatus((loop + i) % 5 ? FileSystem::kBooted : FileSystem::kDown);
+    }
+
+    fsids.clear();
+
+    for (size_t i = 0; i < n_fs; ++i) {
+      if ((i + loop) % 11) {
+        fsids.push_back(i + 1);
+        table.Refresh(i + 1, fss[i].get());
+      }
+    }
+
+    aggregate.Update(table, fsids, false, ++stamp, lcol);
+    aggregate.Update(table, fsids, false, stamp, dcol);
+    long long lsum = 0;
+    int cnt = 0;
+
+    for (auto fsid : fsids) {
+      lsum += table.GetLongLong(fsid, lcol);
+
+      if (table.IsConsidered(fsid)) {
+        cnt++;
+      }
+    }
+
+    ASSERT_EQ(lsum, aggregate.SumLongLong(lcol));
+    ASSERT_EQ(cnt, aggregate.GetCountedCount());
+    ExpectNear(ScanDoubles(table, fsids, dcol),
+               AggregateDoubles(aggregate, dcol));
+    ASSERT_FALSE(aggregate.IsStale(stamp, dcol));
+  }
+
+  // The member order doesn't matter
+  std::reverse(fsids.begin(), fsids.end());
+  aggregate.Update(table, fsids, false, ++stamp, dcol);
+  ExpectNear(ScanDoubles(table, fsids, dcol), AggregateDoubles(aggregate, dcol));
+  // Deviations from the average of a larger view
+  double ref = 12.5;
+  ExpectNear(ScanDoubles(table, fsids, dcol, &ref),
+             AggregateDoubles(aggregate, dcol, &ref));
+  // A NaN propagates like in the scan and is gone with the value
+  fss[0]->SetString("stat.statfs.filled", "nan");
+  table.Refresh(1, fss[0].get());
+  aggregate.Update(table, fsids, false, ++stamp, dcol);
+  ASSERT_TRUE(std::isnan(aggregate.SumDouble(dcol)));
+  fss[0]->SetDouble("stat.statfs.filled", 1.0);
+  table.Refresh(1, fss[0].get());
+  aggregate.Update(table, fsids, false, ++stamp, dcol);
+  ExpectNear(ScanDoubles(table, fsids, dcol), AggregateDoubles(aggregate, dcol));
+}
+
+//------------------------------------------------------------------------------
+// The running sums stay accurate over many changes of values far apart in
+// magnitude
+//------------------------------------------------------------------------------
+TEST(FsViewAggregate, RunningSumsAccuracy)
+{
+  const size_t n_fs = 64;
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::vector<std::unique_ptr<FileSystem>> fss;
+  CreateFileSystems(mgr, n_fs, fss);
+  eos::mgm::FsStateTable table;
+  eos::mgm::FsViewAggregate aggregate;
+  table.Reserve(n_fs);
+  size_t dcol = table.GetColumn("stat.statfs.filled");
+  std::vector<FileSystem::fsid_t> fsids;
+  unsigned long long stamp = 0;
+
+  for (size_t i = 0; i < n_fs; ++i) {
+    fsids.push_back(i + 1);
+  }
+
+  for (size_t loop = 0; loop < 2000; ++loop) {
+    size_t i = (loop * 13) % n_fs;
+    double value = ((loop % 3) ? 1e12 + 0.001 * loop : 1e-3 * loop);
+    fss[i]->SetDouble("stat.statfs.filled", (loop % 2) ? value : -value);
+    table.Refresh(i + 1, fss[i].get());
+    aggregate.Update(table, fsids, true, ++stamp, dcol);
+  }
+
+  // Bring all values back to a small range, only rounding errors remain
+  for (size_t i = 0; i < n_fs; ++i) {
+    fss[i]->SetDouble("stat.statfs.filled", 25.0 + 0.001 * i);
+    table.Refresh(i + 1, fss[i].get());
+    aggregate.Update(table, fsids, true, ++stamp, dcol);
+  }
+
+  std::vector<double> scan {25.0 * n_fs + 0.001 * n_fs * (n_fs - 1) / 2,
+                            25.0 + 0.0005 * (n_fs - 1)};
+  EXPECT_NEAR(scan[0], aggregate.SumDouble(dcol), 1e-9);
+  EXPECT_NEAR(scan[1], aggregate.AverageDouble(dcol), 1e-12);
+  EXPECT_NEAR(0.001 * sqrt((n_fs * n_fs - 1) / 12.0),
+              aggregate.SigmaDouble(dcol), 1e-9);
+  EXPECT_NEAR(0.0005 * (n_fs - 1), aggregate.MaxDeviation(dcol), 1e-9);
+}
+
+//------------------------------------------------------------------------------
+// Rows are refreshed and columns registered from several threads, like views
+// sharing file systems do
+//------------------------------------------------------------------------------
+TEST(FsStateTable, ConcurrentRefresh)
+{
+  const size_t n_fs = 480;
+  const size_t n_threads = 8;
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::vector<std::unique_ptr<FileSystem>> fss;
+  CreateFileSystems(mgr, n_fs, fss);
+  eos::mgm::FsStateTable table;
+  std::vector<std::string> keys {"stat.statfs.capacity", "stat.statfs.freebytes",
+                                 "stat.disk.load", "stat.statfs.filled"};
+  std::vector<std::thread> threads;
+
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t loop = 0; loop < 20; ++loop) {
+        const std::string& key = keys[(t + loop) % keys.size()];
+        size_t col = table.GetColumn(key);
+        // Overlapping ranges of rows, growing the table on the way
+        size_t end = std::min(n_fs, (t + 1) * n_fs / n_threads + loop * 8);
+        table.Reserve(end);
+        eos::common::RWMutexReadLock lock(table.GetMutex());
+
+        for (size_t i = t * n_fs / (2 * n_threads); i < end; ++i) {
+          table.Refresh(i + 1, fss[i].get());
+          std::lock_guard<std::mutex> row_lock(table.GetRowMutex(i + 1));
+          (void) table.GetDouble(i + 1, col);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  table.Reserve(n_fs);
+
+  for (size_t i = 0; i < n_fs; ++i) {
+    table.Refresh(i + 1, fss[i].get());
+
+    for (const auto& key : keys) {
+      size_t col = table.GetColumn(key);
+      table.Refresh(i + 1, fss[i].get());
+      ASSERT_EQ(fss[i]->GetDouble(key.c_str()), table.GetDouble(i + 1, col));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// A watcher counts the changes of all the hashes it is attached to
+//------------------------------------------------------------------------------
+TEST(FsViewAggregate, HashWatcher)
+{
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::vector<std::unique_ptr<FileSystem>> fss;
+  CreateFileSystems(mgr, 2, fss);
+  auto watcher = std::make_shared<std::atomic<unsigned long long>>(0);
+  ASSERT_TRUE(fss[0]->AddChangeWatcher(watcher));
+  ASSERT_TRUE(fss[0]->AddChangeWatcher(watcher));
+  ASSERT_TRUE(fss[1]->AddChangeWatcher(watcher));
+  fss[0]->SetDouble("stat.disk.load", 0.5);
+  ASSERT_EQ(1ull, watcher->load());
+  fss[1]->SetDouble("stat.disk.load", 0.5);
+  ASSERT_EQ(2ull, watcher->load());
+}
@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+// File: IostatTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2018 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/Iostat.hh"
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+// The report is built from the published copy of the counters
+//------------------------------------------------------------------------------
+TEST(Iostat, PrintOutRestored)
+{
+  char dump[] = "/tmp/eos.iostat.XXXXXX";
+  int fd = mkstemp(dump);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  {
+    std::ofstream out(dump);
+    out << "tag=bytes_read&uid=99&val=100\n"
+        << "tag=bytes_read&uid=100&val=200\n"
+        << "tag=bytes_read&gid=99&val=300\n"
+        << "tag=unknown&uid=99&val=1\n";
+  }
+  eos::mgm::Iostat iostat;
+  XrdOucString out;
+  // Nothing published yet
+  iostat.PrintOut(out, true, false, true, true);
+  ASSERT_EQ(std::string::npos, std::string(out.c_str()).find("bytes_read"));
+  ASSERT_TRUE(iostat.SetStoreFileName(dump));
+  out = "";
+  iostat.PrintOut(out, true, false, true, true, true);
+  std::string report = out.c_str();
+  ASSERT_NE(std::string::npos,
+            report.find("measurement=bytes_read total=300 "));
+  ASSERT_NE(std::string::npos,
+            report.find("measurement=bytes_read rank=1 uid=100 counter=200 "));
+  ASSERT_NE(std::string::npos,
+            report.find("measurement=bytes_read rank=2 uid=99 counter=100 "));
+  ASSERT_EQ(std::string::npos, report.find("unknown"));
+  unlink(dump);
+}
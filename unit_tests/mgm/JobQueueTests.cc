@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+// File: JobQueueTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/JobQueue.hh"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using eos::mgm::JobQueue;
+
+//------------------------------------------------------------------------------
+// Ordering by priority and due time with bounded concurrency
+//------------------------------------------------------------------------------
+TEST(JobQueue, Scheduling)
+{
+  JobQueue queue("test");
+  std::vector<JobQueue::Job> jobs;
+  ASSERT_TRUE(queue.Enqueue("default", "a", "1", 0, 100));
+  ASSERT_TRUE(queue.Enqueue("default", "b", "2", 0, 50));
+  ASSERT_TRUE(queue.Enqueue("default", "c", "3", 1, 200));
+  ASSERT_TRUE(queue.Enqueue("default", "d", "4", 5, 90));
+  ASSERT_TRUE(queue.Enqueue("other", "e", "5", 0, 10));
+  // the same key is only queued once
+  ASSERT_TRUE(queue.Enqueue("default", "a", "6", 9, 10));
+  ASSERT_FALSE(queue.Enqueue("default", "a|b", "7"));
+  ASSERT_EQ(4u, queue.GetPending("default"));
+  ASSERT_EQ(5u, queue.GetPending());
+  // "c" is not due yet, the lower priority jobs are
+  ASSERT_EQ(2u, queue.Dequeue("default", 2, jobs, 150));
+  ASSERT_EQ("d", jobs[0].mKey);
+  ASSERT_EQ("b", jobs[1].mKey);
+  uint64_t id = jobs[0].mId;
+  ASSERT_EQ(2u, queue.GetRunning("default"));
+  ASSERT_EQ(0u, queue.Dequeue("default", 2, jobs, 150));
+  ASSERT_TRUE(queue.Done(id));
+  ASSERT_EQ(1u, queue.Dequeue("default", 2, jobs, 150));
+  ASSERT_EQ("a", jobs[0].mKey);
+  ASSERT_EQ("1", jobs[0].mData);
+  ASSERT_EQ(0u, queue.Dequeue("default", 10, jobs, 150));
+  ASSERT_EQ(1u, queue.Dequeue("default", 10, jobs, 200));
+  ASSERT_EQ("c", jobs[0].mKey);
+  ASSERT_TRUE(queue.IsQueued("c"));
+  ASSERT_EQ(1u, queue.GetPending());
+  // a retried job is pending again with its new payload
+  ASSERT_TRUE(queue.Retry(jobs[0].mId, 300, "retry"));
+  ASSERT_FALSE(queue.Retry(jobs[0].mId, 300, "retry"));
+  ASSERT_EQ(0u, queue.Dequeue("default", 10, jobs, 299));
+  ASSERT_EQ(1u, queue.Dequeue("default", 10, jobs, 300));
+  ASSERT_EQ("retry", jobs[0].mData);
+  ASSERT_EQ(1u, jobs[0].mRetry);
+  ASSERT_TRUE(queue.Done(jobs[0].mId));
+  ASSERT_FALSE(queue.Done(jobs[0].mId));
+  ASSERT_FALSE(queue.IsQueued("c"));
+}
+
+//------------------------------------------------------------------------------
+// Jobs survive a restart, running ones are pending again
+//------------------------------------------------------------------------------
+TEST(JobQueue, Persistency)
+{
+  char tmpl[] = "/tmp/eos-jobqueue-XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpl) != nullptr);
+  std::string db = std::string(tmpl) + "/queue.db";
+  {
+    JobQueue queue("test");
+    std::vector<JobQueue::Job> jobs;
+    ASSERT_TRUE(queue.Open(db));
+    ASSERT_TRUE(queue.Enqueue("default", "a", "payload|with|separators", 0, 10));
+    ASSERT_TRUE(queue.Enqueue("default", "b", "", 3, 20));
+    ASSERT_TRUE(queue.Enqueue("default", "c", "done", 0, 30));
+    ASSERT_EQ(3u, queue.Dequeue("default", 10, jobs, 100));
+    ASSERT_TRUE(queue.Retry(jobs[1].mId, 50, "retried|again"));
+    ASSERT_TRUE(queue.Done(jobs[2].mId));
+  }
+  JobQueue queue("test");
+  std::vector<JobQueue::Job> jobs;
+  ASSERT_TRUE(queue.Open(db));
+  ASSERT_FALSE(queue.Open(db));
+  ASSERT_EQ(2u, queue.GetPending("default"));
+  ASSERT_EQ(0u, queue.GetRunning());
+  ASSERT_FALSE(queue.IsQueued("c"));
+  ASSERT_EQ(2u, queue.Dequeue("default", 10, jobs, 100));
+  ASSERT_EQ("b", jobs[0].mKey);
+  ASSERT_EQ(3, jobs[0].mPriority);
+  ASSERT_EQ(20, jobs[0].mDue);
+  ASSERT_EQ("a", jobs[1].mKey);
+  ASSERT_EQ("retried|again", jobs[1].mData);
+  ASSERT_EQ(50, jobs[1].mDue);
+  ASSERT_EQ(1u, jobs[1].mRetry);
+  // new jobs are ordered after the stored ones
+  uint64_t last_id = std::max(jobs[0].mId, jobs[1].mId);
+  ASSERT_TRUE(queue.Enqueue("default", "d", "new"));
+  ASSERT_EQ(1u, queue.Dequeue("default", 10, jobs));
+  ASSERT_GT(jobs[0].mId, last_id);
+  queue.Close();
+  std::string rm = std::string("rm -rf ") + tmpl;
+  ASSERT_EQ(0, system(rm.c_str()));
+}
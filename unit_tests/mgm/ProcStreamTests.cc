@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// File: ProcStreamTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/proc/ProcStream.hh"
+#include <ostream>
+#include <string>
+#include <thread>
+
+using eos::mgm::ProcStream;
+
+//------------------------------------------------------------------------------
+// Output written by one thread is read in order by another one while the
+// queued output stays bounded
+//------------------------------------------------------------------------------
+TEST(ProcStream, ReadWhileWriting)
+{
+  ProcStream stream(16, 64);
+  std::ostream out(&stream);
+  std::string expected;
+
+  for (int i = 0; i < 1000; ++i) {
+    expected += "line " + std::to_string(i) + "\n";
+  }
+
+  std::thread writer([&]() {
+    stream.Open();
+    out << expected;
+    out.flush();
+    stream.Close();
+  });
+  std::string result;
+  char buff[10];
+  size_t nread = 0;
+
+  while ((nread = stream.Read(buff, sizeof(buff)))) {
+    ASSERT_LE(nread, sizeof(buff));
+    result.append(buff, nread);
+  }
+
+  writer.join();
+  ASSERT_TRUE(stream.IsOpen());
+  ASSERT_FALSE(stream.IsCancelled());
+  ASSERT_EQ(expected, result);
+  ASSERT_EQ(expected.length(), stream.GetSize());
+  // Reads after the end of the stream return nothing
+  ASSERT_EQ(0u, stream.Read(buff, sizeof(buff)));
+}
+
+//------------------------------------------------------------------------------
+// Cancelling the stream releases a blocked writer and fails further writes
+//------------------------------------------------------------------------------
+TEST(ProcStream, Cancel)
+{
+  ProcStream stream(16, 32);
+  std::ostream out(&stream);
+  std::thread writer([&]() {
+    stream.Open();
+
+    for (int i = 0; (i < 1000000) && out; ++i) {
+      out << "some output" << std::endl;
+    }
+
+    stream.Close();
+  });
+  char buff[8];
+  ASSERT_EQ(sizeof(buff), stream.Read(buff, sizeof(buff)));
+  stream.Cancel();
+  writer.join();
+  ASSERT_FALSE((bool) out);
+  ASSERT_TRUE(stream.IsCancelled());
+  ASSERT_EQ(0u, stream.Read(buff, sizeof(buff)));
+}
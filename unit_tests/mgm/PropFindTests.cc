@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+// File: PropFindTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/http/webdav/PropFindResponse.hh"
+
+using eos::mgm::PropFindResponse;
+
+TEST(PropFind, ParseDepth)
+{
+  bool infinite = true;
+  bool noroot = true;
+  ASSERT_EQ(0, PropFindResponse::ParseDepth("0", infinite, noroot));
+  ASSERT_FALSE(infinite);
+  ASSERT_FALSE(noroot);
+  ASSERT_EQ(1, PropFindResponse::ParseDepth("1", infinite, noroot));
+  ASSERT_FALSE(infinite);
+  ASSERT_FALSE(noroot);
+  ASSERT_EQ(1, PropFindResponse::ParseDepth("1,noroot", infinite, noroot));
+  ASSERT_FALSE(infinite);
+  ASSERT_TRUE(noroot);
+  ASSERT_EQ(1, PropFindResponse::ParseDepth("infinity", infinite, noroot));
+  ASSERT_TRUE(infinite);
+  ASSERT_FALSE(noroot);
+  // A missing Depth header means infinity
+  ASSERT_EQ(1, PropFindResponse::ParseDepth("", infinite, noroot));
+  ASSERT_TRUE(infinite);
+  ASSERT_EQ(-1, PropFindResponse::ParseDepth("2", infinite, noroot));
+  ASSERT_EQ(-1, PropFindResponse::ParseDepth("infinity,noroot", infinite,
+            noroot));
+}
+
+TEST(PropFind, CacheableProperties)
+{
+  ASSERT_TRUE(PropFindResponse::IsCacheable(
+                PropFindResponse::GET_ETAG | PropFindResponse::DISPLAY_NAME |
+                PropFindResponse::GET_OCID));
+  ASSERT_FALSE(PropFindResponse::IsCacheable(PropFindResponse::GET_ETAG |
+               PropFindResponse::QUOTA_USED));
+  ASSERT_FALSE(PropFindResponse::IsCacheable(PropFindResponse::QUOTA_AVAIL));
+  // Permissions are evaluated per entry for the client
+  ASSERT_FALSE(PropFindResponse::IsCacheable(PropFindResponse::GET_ETAG |
+               PropFindResponse::GET_OCPERM));
+}
+
+TEST(PropFind, IdentityKey)
+{
+  eos::common::Mapping::VirtualIdentity vid;
+  vid.uid = 1000;
+  vid.gid = 2000;
+  vid.uid_list = {1000};
+  vid.gid_list = {2000, 2001};
+  vid.prot = "https";
+  vid.host = "client.cern.ch";
+  const std::string key = PropFindResponse::IdentityKey(vid);
+  // Same identity with the groups in another order
+  eos::common::Mapping::VirtualIdentity other = vid;
+  other.gid_list = {2001, 2000};
+  ASSERT_EQ(key, PropFindResponse::IdentityKey(other));
+  // Secondary groups give access through ACLs
+  other = vid;
+  other.gid_list = {2000};
+  ASSERT_NE(key, PropFindResponse::IdentityKey(other));
+  other = vid;
+  other.uid_list = {1000, 1001};
+  ASSERT_NE(key, PropFindResponse::IdentityKey(other));
+  other = vid;
+  other.sudoer = true;
+  ASSERT_NE(key, PropFindResponse::IdentityKey(other));
+  // Access rules depend on the host and the protocol
+  other = vid;
+  other.host = "other.cern.ch";
+  ASSERT_NE(key, PropFindResponse::IdentityKey(other));
+  other = vid;
+  other.prot = "sss";
+  ASSERT_NE(key, PropFindResponse::IdentityKey(other));
+}
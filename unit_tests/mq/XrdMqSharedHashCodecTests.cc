@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSharedHashCodecTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mq/XrdMqSharedHashCodec.hh"
+#include "mq/XrdMqSharedObject.hh"
+#include "mq/XrdMqMessage.hh"
+#include <chrono>
+#include <iostream>
+
+//------------------------------------------------------------------------------
+// Encode/decode round trip of all value types
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, RoundTrip)
+{
+  std::vector<std::pair<std::string, std::string>> pairs {
+    {"stat.statfs.freebytes", "0"},
+    {"stat.statfs.capacity", "18446744073709551615"},
+    {"stat.statfs.bsize", "1234567890123456789"},
+    {"stat.errc", "-17"},
+    {"stat.errmsg", "-0"},
+    {"stat.geotag", "007"},
+    {"stat.disk.load", "0.5"},
+    {"stat.statfs.filled", "3.141593"},
+    {"stat.net.ethratemib", "1e+10"},
+    {"stat.boot", "booted"},
+    {"my.custom.key", "with|pipe~and%percent"},
+    {"another.custom.key", ""},
+    {"stat.nominal.filled", "12.5000001"}
+  };
+  XrdMqSharedHashCodec codec;
+
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    codec.Add(i % 3, pairs[i].first, pairs[i].second);
+  }
+
+  ASSERT_EQ(pairs.size(), codec.Size());
+  std::string encoded = codec.Encode();
+  std::vector<XrdMqSharedHashCodec::Entry> entries;
+  size_t nentries = 0;
+  ASSERT_TRUE(XrdMqSharedHashCodec::Decode(encoded.c_str(), encoded.length(),
+              entries, nentries));
+  ASSERT_EQ(pairs.size(), nentries);
+
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    ASSERT_EQ(i % 3, entries[i].mSubjectIndex);
+    ASSERT_EQ(pairs[i].first, entries[i].mKey);
+    ASSERT_EQ(pairs[i].second, entries[i].mValue);
+  }
+
+  // Truncated or corrupted buffers are rejected
+  for (size_t len = 0; len < encoded.length(); len += 4) {
+    (void) XrdMqSharedHashCodec::Decode(encoded.c_str(), len, entries, nentries);
+  }
+
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode(encoded.c_str(),
+               encoded.length() - 1, entries, nentries));
+  encoded[2] = '*';
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode(encoded.c_str(), encoded.length(),
+               entries, nentries));
+}
+
+//------------------------------------------------------------------------------
+// Compare decoding rate of the text and the binary heartbeat messages
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, DecodeBenchmark)
+{
+  const size_t n_fs = 24;
+  const size_t n_msg = 500;
+  const std::vector<std::string>& keys = XrdMqSharedHashCodec::GetKeyTable();
+  XrdMqSharedObjectManager mgr;
+  mgr.EnableBroadCast(false);
+  std::string subjects;
+  std::string pairs;
+  XrdMqSharedHashCodec codec;
+
+  // Heartbeat of one node publishing all stat keys of its file systems
+  for (size_t fs = 0; fs < n_fs; ++fs) {
+    std::string subject = "/eos/fst" + std::to_string(fs) +
+                          ".cern.ch:1095/fst/data" + std::to_string(fs);
+    ASSERT_TRUE(mgr.CreateSharedHash(subject.c_str(), "/eos/*/mgm"));
+    subjects += (fs ? "%" : "") + subject;
+
+    for (size_t k = 0; k < keys.size(); ++k) {
+      std::string value = ((k % 3) ? std::to_string(1000000 * fs + k) :
+                           std::to_string(0.25 * (fs + k)));
+      pairs += "|#" + std::to_string(fs) + "#" + keys[k] + "~" + value + "%" +
+               std::to_string(k);
+      codec.Add(fs, keys[k], value);
+    }
+  }
+
+  std::string text = std::string(XRDMQSHAREDHASH_UPDATE) + "&" +
+                     XRDMQSHAREDHASH_SUBJECT + "=" + subjects + "&" +
+                     XRDMQSHAREDHASH_TYPE + "=hash&" + XRDMQSHAREDHASH_PAIRS +
+                     "=" + pairs;
+  std::string binary = std::string(XRDMQSHAREDHASH_BUPDATE) + "&" +
+                       XRDMQSHAREDHASH_SUBJECT + "=" + subjects + "&" +
+                       XRDMQSHAREDHASH_TYPE + "=hash&" + XRDMQSHAREDHASH_BINARY +
+                       "=" + codec.Encode();
+  XrdOucString error;
+
+  for (auto body : {
+         text, binary
+       }) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < n_msg; ++i) {
+      XrdMqMessage message("XrdMqSharedHashMessage");
+      message.SetBody(body.c_str());
+      ASSERT_TRUE(mgr.ParseEnvMessage(&message, error)) << error.c_str();
+    }
+
+    double elapsed = std::chrono::duration<double>
+                     (std::chrono::steady_clock::now() - start).count();
+    std::cout << "[ BENCH    ] format=" << ((body == text) ? "text  " : "binary")
+              << " size=" << body.length() << " msg/s=" << n_msg / elapsed
+              << " keys/s=" << n_msg* n_fs* keys.size() / elapsed << std::endl;
+  }
+
+  // Both encodings lead to the same content
+  XrdMqRWMutexReadLock lock(mgr.HashMutex);
+  XrdMqSharedHash* hash = mgr.GetObject("/eos/fst3.cern.ch:1095/fst/data3",
+                                        "hash");
+  ASSERT_TRUE(hash != nullptr);
+  ASSERT_EQ(std::to_string(3000001), hash->Get(keys[1]));
+  ASSERT_EQ(std::to_string(0.25 * 3), hash->Get(keys[0]));
+  mgr.EnableBroadCast(true);
+}
@@ -0,0 +1,174 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSubscriptionIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2017 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mq/XrdMqSubscriptionIndex.hh"
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Output queue stand-in
+//------------------------------------------------------------------------------
+struct Queue {
+  std::string mName;
+};
+
+typedef XrdMqSubscriptionIndex<Queue> Index;
+
+//------------------------------------------------------------------------------
+// Create queues named like the ones of a large instance
+//------------------------------------------------------------------------------
+void
+CreateQueues(size_t n_fst, std::vector<std::unique_ptr<Queue>>& queues,
+             Index& index)
+{
+  std::vector<std::string> names {"/eos/mgm1.cern.ch:1094/mgm",
+                                  "/eos/mgm2.cern.ch:1094/mgm",
+                                  "/eos/mgm1.cern.ch:1094/errorreport",
+                                  "/eos/mgm1.cern.ch:1094/vst"};
+
+  for (size_t i = 0; i < n_fst; ++i) {
+    names.push_back("/eos/fst" + std::to_string(i) + ".cern.ch:1095/fst");
+  }
+
+  for (const auto& name : names) {
+    bool mgm = (name.substr(name.rfind('/')) == "/mgm");
+    queues.emplace_back(new Queue{name});
+    index.Add(name, queues.back().get(), mgm, mgm);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Match by looking at every queue like the broker did before the index
+//------------------------------------------------------------------------------
+void
+ScanMatch(const std::vector<std::unique_ptr<Queue>>& queues,
+          const std::string& pattern, const std::string& sender,
+          std::vector<Queue*>& matched)
+{
+  matched.clear();
+
+  for (const auto& queue : queues) {
+    if (queue && (queue->mName != sender) &&
+        Index::Matches(queue->mName, pattern)) {
+      matched.push_back(queue.get());
+    }
+  }
+
+  std::sort(matched.begin(), matched.end(), std::less<Queue*>());
+}
+}
+
+//------------------------------------------------------------------------------
+// Index lookups find the same queues as a scan of all queues
+//------------------------------------------------------------------------------
+TEST(XrdMqSubscriptionIndex, MatchesScan)
+{
+  std::vector<std::unique_ptr<Queue>> queues;
+  Index index;
+  CreateQueues(500, queues, index);
+  std::vector<std::string> patterns {
+    "/eos/*/fst", "/eos/*/mgm", "/eos/*", "*", "*/mgm", "/eos/fst1*",
+    "/eos/fst1*/fst", "/eos/*cern.ch:1094*", "/eos/mgm1.cern.ch:1094/*",
+    "/eos/*/nothing", "/other/*", "/eos/fst42*fst", "*fst*", "**"};
+  std::vector<std::string> senders {"", "/eos/mgm1.cern.ch:1094/mgm",
+                                    "/eos/fst10.cern.ch:1095/fst"};
+  std::vector<Queue*> expected;
+  std::vector<Queue*> matched;
+
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (const auto& pattern : patterns) {
+      for (const auto& sender : senders) {
+        // Twice, the second lookup is served from the cache
+        for (size_t i = 0; i < 2; ++i) {
+          ScanMatch(queues, pattern, sender, expected);
+          index.MatchWildcard(pattern, sender, matched);
+          ASSERT_EQ(expected, matched) << "pattern=" << pattern;
+        }
+      }
+    }
+
+    // Removing queues invalidates the cached results
+    for (size_t i = 3; !pass && (i < queues.size()); i += 3) {
+      index.Remove(queues[i]->mName);
+      queues[i].reset();
+    }
+  }
+
+  ASSERT_EQ(nullptr, index.Find("/eos/fst2.cern.ch:1095/fst"));
+  ASSERT_EQ(queues[5].get(), index.Find("/eos/fst1.cern.ch:1095/fst"));
+  // Advisory subscribers
+  index.MatchAdvisory(true, "/eos/mgm2.cern.ch:1094/mgm", matched);
+  ASSERT_EQ(1u, matched.size());
+  ASSERT_EQ(queues[0].get(), matched[0]);
+  index.MatchAdvisory(false, "", matched);
+  ASSERT_EQ(2u, matched.size());
+}
+
+//------------------------------------------------------------------------------
+// Compare matching messages by scanning all queues and through the index
+//------------------------------------------------------------------------------
+TEST(XrdMqSubscriptionIndex, ThroughputBenchmark)
+{
+  for (size_t n_fst : {1000, 10000}) {
+    std::vector<std::unique_ptr<Queue>> queues;
+    Index index;
+    CreateQueues(n_fst, queues, index);
+    // Replies to the MGM, heartbeats to all FSTs and direct messages
+    std::vector<std::string> patterns {"/eos/*/mgm", "/eos/*/fst",
+                                       "/eos/fst7.cern.ch:1095/fst"};
+    const size_t n_msg = 100;
+
+    for (const auto& pattern : patterns) {
+      std::vector<Queue*> expected;
+      std::vector<Queue*> matched;
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t i = 0; i < n_msg; ++i) {
+        ScanMatch(queues, pattern, "/eos/mgm1.cern.ch:1094/mgm", expected);
+      }
+
+      double scan = std::chrono::duration<double>
+                    (std::chrono::steady_clock::now() - start).count();
+      start = std::chrono::steady_clock::now();
+
+      for (size_t i = 0; i < n_msg; ++i) {
+        if (pattern.find('*') != std::string::npos) {
+          index.MatchWildcard(pattern, "/eos/mgm1.cern.ch:1094/mgm", matched);
+        } else {
+          matched.assign(1, index.Find(pattern));
+        }
+      }
+
+      double indexed = std::chrono::duration<double>
+                       (std::chrono::steady_clock::now() - start).count();
+      ASSERT_EQ(expected, matched);
+      std::cout << "[ BENCH    ] queues=" << queues.size() << " pattern="
+                << pattern << " receivers=" << matched.size()
+                << " scan=" << n_msg / scan << " msg/s index="
+                << n_msg / indexed << " msg/s" << std::endl;
+    }
+  }
+}